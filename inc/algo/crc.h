@@ -32,6 +32,21 @@ extern "C" {
 #include <tbx_types.h>
 #include <toolbox_defs.h>
 
+/*
+ * User defines
+ */
+#ifndef CRC_SLICING
+#define CRC_SLICING              (8)   /*!< Bytes per table step. 1: plain table, 4: slicing-by-4, 8: slicing-by-8 */
+#endif
+
+#ifndef CRC_TABLE_SLOTS
+#define CRC_TABLE_SLOTS          (2)   /*!< Number of (polynomial, bit order) tables that can be linked for each CRC width */
+#endif
+
+#ifndef CRC_TABLE_THRESHOLD
+#define CRC_TABLE_THRESHOLD      (32)  /*!< Buffers smaller than this are calculated bitwise, without tables */
+#endif
+
 /*
  * Polynomials for CRC8
  */
@@ -82,6 +97,26 @@ extern "C" {
 
 #define CRC16_ANSI            (CRC16_IBM)
 
+/*
+ * Polynomials for CRC32
+ */
+#define CRC32_IEEE            (0x04C11DB7)   /*!< Ethernet, zip, PNG, SATA, MPEG-2, many others */
+#define CRC32_IEEE_rev        (0xEDB88320)   /*!< Ethernet, zip, PNG, SATA, MPEG-2, many others, for reverse bit order */
+#define CRC32_Castagnoli      (0x1EDC6F41)   /*!< iSCSI, SCTP, ext4, Btrfs. SSE4.2/ARMv8 hardware support */
+#define CRC32_Castagnoli_rev  (0x82F63B78)   /*!< iSCSI, SCTP, ext4, Btrfs. SSE4.2/ARMv8 hardware support, for reverse bit order */
+#define CRC32_Koopman         (0x741B8CD7)   /*!< Excellent at Ethernet frame length */
+#define CRC32_Koopman_rev     (0xEB31D82E)   /*!< Excellent at Ethernet frame length, for reverse bit order */
+#define CRC32_Q               (0x814141AB)   /*!< aviation; AIXM */
+#define CRC32_Q_rev           (0xD5828281)   /*!< aviation; AIXM, for reverse bit order */
+
+/*
+ * Polynomials for CRC64
+ */
+#define CRC64_ECMA            (0x42F0E1EBA9EA3693ULL)  /*!< ECMA-182, xz */
+#define CRC64_ECMA_rev        (0xC96C5795D7870F42ULL)  /*!< ECMA-182, xz, for reverse bit order */
+#define CRC64_ISO             (0x000000000000001BULL)  /*!< ISO 3309, HDLC */
+#define CRC64_ISO_rev         (0xD800000000000000ULL)  /*!< ISO 3309, HDLC, for reverse bit order */
+
 /*!
  * Enumerator for Bit Order of the CRC operation
  */
@@ -90,6 +125,25 @@ typedef enum {
    CRC_LSB        //!< LittleEndian:   Least significant bit to Most significant bit
 }CRC_BitOrder_en;
 
+/*!
+ * Table storage of the table driven engine, CRC_SLICING tables of 256 points.
+ * The user provides it and links it with CRCxx_link_table().
+ */
+typedef uint8_t   crc8_table_t[CRC_SLICING][256];
+typedef uint16_t  crc16_table_t[CRC_SLICING][256];
+typedef uint32_t  crc32_table_t[CRC_SLICING][256];
+typedef uint64_t  crc64_table_t[CRC_SLICING][256];
+
+/*
+ * Link functions. Call them at initialisation, before the buffer
+ * functions run from more than one thread.
+ */
+drv_status_en CRC8_link_table (crc8_table_t *tb, uint8_t poly, CRC_BitOrder_en bo);
+drv_status_en CRC16_link_table (crc16_table_t *tb, uint16_t poly, CRC_BitOrder_en bo);
+drv_status_en CRC32_link_table (crc32_table_t *tb, uint32_t poly, CRC_BitOrder_en bo);
+drv_status_en CRC64_link_table (crc64_table_t *tb, uint64_t poly, CRC_BitOrder_en bo);
+void CRC_unlink_tables (void);
+
 
 uint8_t CRC8_byte (uint8_t poly, CRC_BitOrder_en bo, uint8_t crc, byte_t b);
 uint8_t CRC8_buffer (uint8_t poly, CRC_BitOrder_en bo, uint8_t crc, const byte_t *data, bytecount_t size);
@@ -97,6 +151,13 @@ uint8_t CRC8_buffer (uint8_t poly, CRC_BitOrder_en bo, uint8_t crc, const byte_t
 uint16_t CRC16_byte (uint16_t poly, CRC_BitOrder_en bo, uint16_t crc, byte_t b);
 uint16_t CRC16_buffer (uint16_t poly, CRC_BitOrder_en bo, uint16_t crc, const byte_t *data, bytecount_t size);
 
+uint32_t CRC32_byte (uint32_t poly, CRC_BitOrder_en bo, uint32_t crc, byte_t b);
+uint32_t CRC32_buffer (uint32_t poly, CRC_BitOrder_en bo, uint32_t crc, const byte_t *data, bytecount_t size);
+
+uint64_t CRC64_byte (uint64_t poly, CRC_BitOrder_en bo, uint64_t crc, byte_t b);
+uint64_t CRC64_buffer (uint64_t poly, CRC_BitOrder_en bo, uint64_t crc, const byte_t *data, bytecount_t size);
+
+
 
 
 
@@ -36,6 +36,7 @@ extern "C" {
 #include <std/stime.h>
 #include <tbx_types.h>
 #include <math/math.h>
+#include <math/quick_trig.h>
 #include <math.h>
 
 /*!
@@ -97,6 +98,9 @@ drv_status_en psa_set_location (psa_t *psa, double lon, double lat);
  */
 psa_output_t psa_calculate (psa_t *psa);
 
+double psa_jd (time_t utc);
+void psa_calculate_n (const psa_t *psa, const double *jd, double *zenith, double *azimuth, uint32_t n);
+
 #ifdef __cplucpluc
 }
 #endif
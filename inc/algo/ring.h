@@ -0,0 +1,145 @@
+/*
+ * \file ring.h
+ * \brief
+ *    Lock-free ring buffers for inter-thread communication.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos <houtouridis.ch@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef  __ring_h__
+#define  __ring_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <stdatomic.h>
+#include <string.h>
+
+/*
+ * User defines
+ */
+#ifndef RING_ALIGN
+#if __SIZEOF_POINTER__ >= 8
+#define RING_ALIGN      (64)     //!< Cache line size, producer and consumer indexes live on different lines
+#else
+#define RING_ALIGN      (4)      //!< Single core MCUs have no false sharing
+#endif
+#endif
+
+/*!
+ * The MPMC ring cell header size. Each cell holds a sequence number
+ * followed by the item, padded to 8 bytes.
+ */
+#define RING_MPMC_HDR                     (8)
+#define RING_MPMC_STRIDE(_isz)            (RING_MPMC_HDR + (((_isz) + 7) & ~7))
+/*!
+ * The buffer size in bytes, needed from a MPMC ring of _items with size _isz
+ */
+#define RING_MPMC_BUFFER_SIZE(_items, _isz)  ((_items) * RING_MPMC_STRIDE(_isz))
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Single producer - single consumer ring.
+ * The indexes run freely and the slot is (index & mask), so head == tail
+ * means empty and tail - head == items means full. No slot is wasted.
+ * Each side writes only its own index (release) and reads the other side's
+ * index (acquire). A private copy of the other side's index is kept, so the
+ * shared line is read only when the ring looks full/empty.
+ */
+typedef struct {
+   byte_t      *buf;          //!< pointer to ring's buffer [items * item_size]
+   uint32_t    items;         //!< ring's item capacity (power of 2)
+   uint32_t    mask;          //!< items - 1
+   uint32_t    item_size;     //!< each item size
+   _Alignas(RING_ALIGN)
+   _Atomic uint32_t  tail;    //!< producer index
+   uint32_t    head_c;        //!< producer's copy of head
+   _Alignas(RING_ALIGN)
+   _Atomic uint32_t  head;    //!< consumer index
+   uint32_t    tail_c;        //!< consumer's copy of tail
+}ring_spsc_t;
+
+/*!
+ * Multiple producer - multiple consumer bounded ring (D. Vyukov).
+ * Each cell carries a sequence number. A cell with seq == pos is free for
+ * the producer that claims pos, and a cell with seq == pos+1 is full for
+ * the consumer that claims pos. The claim is a CAS on tail/head, the data
+ * copy happens outside of it and the publish is a release store of seq.
+ */
+typedef struct {
+   byte_t      *buf;          //!< pointer to ring's cells [RING_MPMC_BUFFER_SIZE(items, item_size)]
+   uint32_t    items;         //!< ring's item capacity (power of 2)
+   uint32_t    mask;          //!< items - 1
+   uint32_t    item_size;     //!< each item size
+   uint32_t    stride;        //!< each cell size
+   _Alignas(RING_ALIGN)
+   _Atomic uint32_t  tail;    //!< producers index
+   _Alignas(RING_ALIGN)
+   _Atomic uint32_t  head;    //!< consumers index
+}ring_mpmc_t;
+
+/*
+ *  ============= PUBLIC Ring API =============
+ */
+
+/*
+ * SPSC ring
+ */
+int  ring_spsc_init (ring_spsc_t *r, void *buf, uint32_t items, uint32_t item_size);
+void ring_spsc_flush (ring_spsc_t *r);
+uint32_t ring_spsc_waiting (ring_spsc_t *r);
+int  ring_spsc_is_empty (ring_spsc_t *r);
+int  ring_spsc_is_full (ring_spsc_t *r);
+
+int  ring_spsc_put (ring_spsc_t *r, const void *b);
+int  ring_spsc_get (ring_spsc_t *r, void *b);
+uint32_t ring_spsc_put_n (ring_spsc_t *r, const void *b, uint32_t n);
+uint32_t ring_spsc_get_n (ring_spsc_t *r, void *b, uint32_t n);
+
+void* ring_spsc_reserve (ring_spsc_t *r, uint32_t *n);
+void  ring_spsc_commit (ring_spsc_t *r, uint32_t n);
+void* ring_spsc_peek (ring_spsc_t *r, uint32_t *n);
+void  ring_spsc_release (ring_spsc_t *r, uint32_t n);
+
+/*
+ * MPMC ring
+ */
+int  ring_mpmc_init (ring_mpmc_t *r, void *buf, uint32_t items, uint32_t item_size);
+uint32_t ring_mpmc_waiting (ring_mpmc_t *r);
+
+int  ring_mpmc_put (ring_mpmc_t *r, const void *b);
+int  ring_mpmc_get (ring_mpmc_t *r, void *b);
+uint32_t ring_mpmc_put_n (ring_mpmc_t *r, const void *b, uint32_t n);
+uint32_t ring_mpmc_get_n (ring_mpmc_t *r, void *b, uint32_t n);
+
+void* ring_mpmc_reserve (ring_mpmc_t *r);
+void  ring_mpmc_commit (ring_mpmc_t *r, void *item);
+void* ring_mpmc_peek (ring_mpmc_t *r);
+void  ring_mpmc_release (ring_mpmc_t *r, void *item);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //#ifndef  __ring_h__
@@ -179,6 +179,8 @@ drv_status_en spa_set_atmos (spa_t *spa, double pr, double temp, double at_ref);
  * ============ User Functions ===========
  */
 spa_output_t spa_calculate (spa_t *spa, spa_func_en fun);
+void spa_calculate_batch (const spa_time_t *times, uint32_t nt, const spa_t *sites, uint32_t ns,
+                          spa_func_en fun, spa_output_t *out);
 
 
 #ifdef __cplusplus
@@ -34,6 +34,7 @@ extern "C" {
 #endif
 
 #include <std/stime.h>
+#include <math/quick_trig.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -86,6 +87,9 @@ void spa_grena_set_temperature (spa_grena_t *spa, double T);
 void spa_grena_init (spa_grena_t *spa);
 sun_pos_t spa_grena_calculation (spa_grena_t *spa);
 
+double spa_grena_njd (time_t utc);
+void spa_grena_calculation_n (const spa_grena_t *spa, const double *njd, double *azimuth, double *elev, uint32_t n);
+
 #ifdef __cplusplus
 }
 #endif
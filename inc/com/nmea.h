@@ -45,8 +45,7 @@ extern "C" {
 /*
  * ============ parser's data types =============
  */
-#define NMEA_IS_DELIMITER(_c)    (_c == ',' || _c == '*' || _c == '\r')
-#define NMEA_TOKEN_SIZE          (12)
+#define NMEA_MAX_FRAC_DIGITS     (9)      //!< Fractional digits of a field, the rest are ignored
 
 
 /*
@@ -129,7 +128,8 @@ typedef enum {
    NMEA_GSV,   /*!< GPS Satellites in view */
    NMEA_RMC,   /*!< Recommended minimum specific GPS/Transit data */
    NMEA_VTG,   /*!< Track made good and ground speed */
-   NMEA_ZDA    /*!< Date & Time */
+   NMEA_ZDA,   /*!< Date & Time */
+   NMEA_MSGID_NUM
 }nmea_msgid_en;
 
 /*!
@@ -250,6 +250,45 @@ typedef struct {
    int         zone_m;        //!< Local minutes time zone (minute offset)
 }nmea_zda_t;
 
+/*!
+ * Latest value cache. Each checksum valid sentence updates its message
+ * and sets its bit (1 << id) in \a updated. nmea_read_xxx() clears it.
+ */
+typedef struct {
+   nmea_gga_t     gga;
+   nmea_gll_t     gll;
+   nmea_gsa_t     gsa;
+   nmea_gsv_t     gsv;
+   nmea_rmc_t     rmc;
+   nmea_vtg_t     vtg;
+   nmea_zda_t     zda;
+   uint32_t       updated;    //!< Bit mask of the unread messages
+}nmea_cache_t;
+
+/*!
+ * Stream parser's state. The sentence is not buffered. The checksum is
+ * calculated and each field is converted while the characters arrive.
+ */
+typedef struct {
+   uint8_t        st;         //!< Parser state
+   uint8_t        cs;         //!< Calculated checksum
+   uint8_t        rcs;        //!< Received checksum
+   uint8_t        alen;       //!< Address length
+   char           addr[8];    //!< Address field, ex: "GPGGA"
+   nmea_msgid_en  id;         //!< Sentence id
+   const parse_obj_en *format;//!< Sentence grammar, or NULL for the not implemented ones
+   int            tk;         //!< Current field in grammar
+   // Current field
+   uint32_t       ip;         //!< Integer part
+   uint32_t       fp;         //!< Fractional part
+   uint8_t        fd;         //!< Fractional digits
+   uint8_t        flen;       //!< Field length
+   uint8_t        dot;        //!< Field has decimal point
+   uint8_t        neg;        //!< Field has minus sign
+   char           ch0;        //!< Field's first character
+   nmea_common_t  obj;        //!< Sentence data
+}nmea_parser_t;
+
 /*!
  * \name interface types
  */
@@ -266,15 +305,26 @@ typedef struct {
 }nmea_io_t;
 //!@}
 
+typedef struct nmea nmea_t;
+
+/*!
+ * Sentence callback. It is called for every checksum valid sentence
+ * of its type, with a pointer to the message in cache (ex: nmea_gga_t*).
+ */
+typedef void (*nmea_cb_ft) (nmea_t *nmea, nmea_msgid_en id, const void *msg);
+
 /*!
  * NMEA public data type
  */
-typedef struct {
-   byte_t         *buf;       //!< Pointer to sentence buffer
-   int            buf_size;   //!< Buffer size
+struct nmea {
    nmea_io_t      io;         //!< Module's input output
+   nmea_cb_ft     cb[NMEA_MSGID_NUM];  //!< Sentence callbacks
+   nmea_cache_t   cache;      //!< Latest messages
+   nmea_parser_t  ps;         //!< Stream parser
+   uint32_t       sentences;  //!< Valid sentences
+   uint32_t       errors;     //!< Checksum errors and broken sentences
    drv_status_en  status;     //!< Driver's status
-}nmea_t;
+};
 
 
 
@@ -287,16 +337,17 @@ void mnea_unused (void);
  * \name Link and Glue functions
  */
 //!@{
-void nmea_link_buffer (nmea_t *nmea, byte_t *b);
+void nmea_link_buffer (nmea_t *nmea, byte_t *b);         /*!< for compatibility */
 void nmea_link_in (nmea_t *nmea, nmea_in_ft in);
 void nmea_link_out (nmea_t *nmea, nmea_out_ft out);
+void nmea_link_callback (nmea_t *nmea, nmea_msgid_en id, nmea_cb_ft cb);
 //!@}
 
 /*
  * \name Set functions
  */
 //!@{
-void nmea_set_buffer_size (nmea_t *nmea, int s);
+void nmea_set_buffer_size (nmea_t *nmea, int s);         /*!< for compatibility */
 //!@}
 
 /*
@@ -306,6 +357,8 @@ void nmea_set_buffer_size (nmea_t *nmea, int s);
 void nmea_deinit (nmea_t *nmea);
 drv_status_en nmea_init (nmea_t *nmea);
 
+int nmea_feed (nmea_t *nmea, const byte_t *buf, int len);
+
 drv_status_en nmea_read_gga (nmea_t *nmea, nmea_gga_t *gga);
 drv_status_en nmea_read_gll (nmea_t *nmea, nmea_gll_t *gll);
 drv_status_en nmea_read_gsa (nmea_t *nmea, nmea_gsa_t *gsa);
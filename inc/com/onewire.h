@@ -0,0 +1,143 @@
+/*!
+ * \file onewire.h
+ * \brief
+ *    A target and bus driver independent 1-Wire ROM search. The search state
+ *    lives in a user object, so any number of buses can be searched at the
+ *    same time. It supports the conditional (alarm) search, the family code
+ *    filtering and the enumeration of a whole bus to a user table at standard
+ *    or overdrive speed.
+ * \note
+ *    The bus driver has to provide a byte write, a search triplet and an ioctl
+ *    function with CTRL_RESET and CTRL_SET_SPEED. The onewire_uart and
+ *    onewire_bb drivers provide all of them.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2016 Choutouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __onewire_h__
+#define __onewire_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_ioctl.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <algo/crc.h>
+#include <sys/pt.h>
+#include <string.h>
+
+/* ================   General Defines   ====================*/
+
+#define  OW_ROM_SIZE             (8)      /*!< ROM id size in bytes */
+#define  OW_ROM_BITS             (64)     /*!< ROM id size in bits */
+
+/*
+ * ROM commands
+ */
+#define  OW_CMD_READ_ROM         (0x33)
+#define  OW_CMD_MATCH_ROM        (0x55)
+#define  OW_CMD_SKIP_ROM         (0xCC)
+#define  OW_CMD_SEARCH_ROM       (0xF0)
+#define  OW_CMD_SEARCH_ALARM     (0xEC)   /*!< Conditional search, only the devices with alarm */
+#define  OW_CMD_RESUME           (0xA5)
+#define  OW_CMD_OD_SKIP_ROM      (0x3C)
+#define  OW_CMD_OD_MATCH_ROM     (0x69)
+
+/*!
+ * 1-Wire speed, the same values with OW_UART_T_xx and OW_BB_T_xx
+ */
+#define  OW_T_STANDARD           (0)
+#define  OW_T_OVERDRIVE          (1)
+
+#define  OW_FAMILY_ANY           (0x00)   /*!< No family code filtering */
+
+/*!
+ * Search triplet return bits
+ */
+#define  OW_TRIPLET_ID           (0x01)   /*!< The ROM bit read */
+#define  OW_TRIPLET_CMP          (0x02)   /*!< The complement of ROM bit read */
+#define  OW_TRIPLET_DIR          (0x04)   /*!< The direction we have written */
+
+typedef byte_t ow_rom_t[OW_ROM_SIZE];     /*!< 1-Wire ROM id, family code first */
+
+typedef void   (*ow_tx_ft) (void *, byte_t);                               /*!< 1-wire byte write function pointer */
+typedef uint8_t (*ow_triplet_ft) (void *, uint8_t);                        /*!< 1-wire search triplet function pointer */
+typedef drv_status_en (*ow_ioctl_ft) (void *, ioctl_cmd_t, ioctl_buf_t);   /*!< 1-wire ioctl function pointer */
+
+/*!
+ * The 1-Wire bus driver links
+ */
+typedef struct {
+   void*          ow;         /*!< void 1-wire type structure, ex: ow_uart_t, ow_bb_t */
+   ow_tx_ft       tx;         /*!< 1-wire byte write function */
+   ow_triplet_ft  triplet;    /*!< 1-wire search triplet function */
+   ow_ioctl_ft    ioctl;      /*!< 1-wire ioctl function, for CTRL_RESET and CTRL_SET_SPEED */
+}ow_bus_t;
+
+/*!
+ * ROM search state. A zeroed object starts a ROM search for all families
+ */
+typedef struct {
+   ow_rom_t       rom;        /*!< The last ROM id found, the path of the next pass */
+   uint8_t        last;       /*!< The last discrepancy we took the 0 path, 1 based, 0 for none */
+   byte_t         cmd;        /*!< Search command, 0 for OW_CMD_SEARCH_ROM */
+   byte_t         family;     /*!< Family code filter, OW_FAMILY_ANY for none */
+}ow_search_t;
+
+/*!
+ * Non blocking enumeration state, \see ow_enumerate_async().
+ * Zero it before the first call.
+ */
+typedef struct {
+   pt_t           pt;         /*!< Protothread of the operation */
+   ow_search_t    s;          /*!< The search state */
+   drv_status_en  st;         /*!< The last search result */
+   int            n;          /*!< The number of the devices found, or -1 on bus error */
+}ow_enum_t;
+
+
+/*
+ *  ============= PUBLIC 1-Wire API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+void ow_link_ow (ow_bus_t *bus, void *ow);
+void ow_link_tx (ow_bus_t *bus, ow_tx_ft fun);
+void ow_link_triplet (ow_bus_t *bus, ow_triplet_ft fun);
+void ow_link_ioctl (ow_bus_t *bus, ow_ioctl_ft fun);
+
+/*
+ * User Functions
+ */
+void ow_search_init (ow_search_t *s, byte_t cmd, byte_t family);
+drv_status_en ow_search (ow_bus_t *bus, ow_search_t *s, byte_t *romid);
+int ow_enumerate (ow_bus_t *bus, byte_t cmd, byte_t family, uint32_t speed, ow_rom_t *table, int size);
+drv_status_en ow_enumerate_async (ow_bus_t *bus, ow_enum_t *op, byte_t cmd, byte_t family, uint32_t speed, ow_rom_t *table, int size);
+
+int ow_rom_cmp (const byte_t *r1, const byte_t *r2);
+int ow_rom_find (const ow_rom_t *table, int n, const byte_t *romid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef __onewire_h__ */
@@ -31,6 +31,7 @@ extern "C" {
 #include <tbx_ioctl.h>
 #include <tbx_types.h>
 #include <sys/jiffies.h>
+#include <com/onewire.h>
 #include <string.h>
 
 
@@ -73,6 +74,7 @@ typedef struct {
 typedef struct {
    ow_io_t        io;         /*!< Callback pointers and direction state */
    ow_timings_t   timings;    /*!< Timings */
+   ow_search_t    search;     /*!< The search state of ow_bb_search() */
    drv_status_en  status;     /*!< Toolbox driver status */
 }ow_bb_t;
 
@@ -208,6 +210,7 @@ drv_status_en
 uint8_t  ow_bb_rx (ow_bb_t *ow);
 void     ow_bb_tx (ow_bb_t *ow, byte_t byte);
 uint8_t  ow_bb_rw (ow_bb_t *ow, byte_t byte);
+uint8_t  ow_bb_triplet (ow_bb_t *ow, uint8_t dir);
 drv_status_en
          ow_bb_search (ow_bb_t *ow, uint8_t *romid);
 
@@ -40,11 +40,25 @@ extern "C" {
 #include <tbx_ioctl.h>
 #include <tbx_types.h>
 #include <toolbox_defs.h>
+#include <com/onewire.h>
 #include <string.h>
 
+/*
+ * ================   User Defines   ====================
+ */
+
+/*!
+ * The bytes of a bulk transfer. Each byte is 8 UART frames, so the
+ * bulk transfers need a stack buffer of 8*OW_UART_BULK_SIZE bytes.
+ */
+#ifndef OW_UART_BULK_SIZE
+#define OW_UART_BULK_SIZE        (8)
+#endif
+
 /* ================   General Defines   ====================*/
 
 typedef uint16_t (*ow_uart_rw_ft) (uint8_t);           /*!< UART read-write function pointer */
+typedef drv_status_en (*ow_uart_rwbuf_ft) (byte_t*, int); /*!< UART buffer read-write function pointer */
 typedef drv_status_en (*ow_uart_br_ft) (uint32_t);    /*!< UART baudrate modify function pointer */
 
 /*!
@@ -71,6 +85,8 @@ typedef struct {
  */
 typedef struct {
    ow_uart_rw_ft  rw;      /*!< Pointer UART read-write function */
+   ow_uart_rwbuf_ft
+                  rwbuf;   /*!< Pointer UART buffer read-write function, optional */
    ow_uart_br_ft  br;      /*!< Pointer to UART baudrate function */
 }ow_uart_io_t;
 
@@ -81,6 +97,7 @@ typedef struct {
    ow_uart_io_t      io;         /*!< Callback pointers and direction state */
    uint32_t          timing;     /*!< The selected timing mode */
    ow_uart_br_t      baudrate;   /*!< The current baudrate configuration */
+   ow_search_t       search;     /*!< The search state of ow_uart_search() */
    drv_status_en     status;     /*!< Toolbox driver status */
 }ow_uart_t;
 
@@ -162,14 +179,14 @@ typedef struct {
    do {                       \
       _br_.reset = 9600;      \
       _br_.oper = 115200;     \
-      _br_.current = 9600;    \
+      _br_.current = 0;       \
    } while (0)
 
 #define  _ow_baudrate_overdrive(_br_)  \
    do {                          \
       _br_.reset = 115200;       \
       _br_.oper = 921600;        \
-      _br_.current = 115200;     \
+      _br_.current = 0;          \
    } while (0)
 
 /*
@@ -180,6 +197,7 @@ typedef struct {
  * Link and Glue functions
  */
 void ow_uart_link_rw (ow_uart_t *ow, ow_uart_rw_ft tx);    /*!< link driver's read-write function */
+void ow_uart_link_rwbuf (ow_uart_t *ow, ow_uart_rwbuf_ft rwbuf);  /*!< link driver's buffer read-write function */
 void ow_uart_link_br (ow_uart_t *ow, ow_uart_br_ft br);    /*!< link driver's baudrate function*/
 
 /*
@@ -198,6 +216,11 @@ drv_status_en
 uint8_t  ow_uart_rx (ow_uart_t *ow);
 void     ow_uart_tx (ow_uart_t *ow, byte_t byte);
 uint8_t  ow_uart_rw (ow_uart_t *ow, byte_t byte);
+drv_status_en
+         ow_uart_read (ow_uart_t *ow, byte_t *buf, int n);
+drv_status_en
+         ow_uart_write (ow_uart_t *ow, const byte_t *buf, int n);
+uint8_t  ow_uart_triplet (ow_uart_t *ow, uint8_t dir);
 drv_status_en
          ow_uart_search (ow_uart_t *ow, uint8_t *romid);
 
@@ -32,6 +32,7 @@ extern "C" {
 
 #include <crypt/cryptint.h>
 #include <string.h>
+#include <stddef.h>
 #include <inttypes.h>
 
 typedef struct
@@ -44,6 +45,19 @@ aes_t;
 
 typedef enum {AES_128=128, AES_192=192, AES_256=256} aes_size;
 
+/*!
+ * GCM context. It holds the hash subkey H of a keyed aes_t and its
+ * multiples for the 4-bit table GHASH.
+ */
+typedef struct
+{
+    aes_t    *aes;      /* the block cipher, key already set */
+    uint64_t HL[16];    /* H multiples, low 64 bits */
+    uint64_t HH[16];    /* H multiples, high 64 bits */
+    uint8_t  H[16];     /* hash subkey E(K, 0^128) */
+}
+aes_gcm_t;
+
 void  aes_key_deinit (aes_t *ctx);
 void aes128_key_init (aes_t *ctx, uint8_t *key);
 void aes192_key_init (aes_t *ctx, uint8_t *key);
@@ -52,6 +66,24 @@ void aes256_key_init (aes_t *ctx, uint8_t *key);
 void aes_encrypt (aes_t *ctx, uint8_t in[16], uint8_t out[16]);
 void aes_decrypt (aes_t *ctx, uint8_t in[16], uint8_t out[16]);
 
+/*
+ * Block cipher modes
+ */
+int  aes_cbc_encrypt (aes_t *ctx, uint8_t iv[16], const uint8_t *in, uint8_t *out, size_t len);
+int  aes_cbc_decrypt (aes_t *ctx, uint8_t iv[16], const uint8_t *in, uint8_t *out, size_t len);
+void aes_ctr (aes_t *ctx, uint8_t ctr[16], const uint8_t *in, uint8_t *out, size_t len);
+int  aes_ni_enable (int en);
+
+void aes_gcm_init (aes_gcm_t *gcm, aes_t *ctx);
+void aes_gcm_encrypt (aes_gcm_t *gcm, const uint8_t *iv, size_t iv_len,
+                      const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, uint8_t *out, size_t len,
+                      uint8_t *tag, size_t tag_len);
+int  aes_gcm_decrypt (aes_gcm_t *gcm, const uint8_t *iv, size_t iv_len,
+                      const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, uint8_t *out, size_t len,
+                      const uint8_t *tag, size_t tag_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,9 +36,28 @@ extern "C" {
 
 #include <crypt/cryptint.h>
 #include <string.h>
+#include <stddef.h>
 #include <inttypes.h>
 
+/*
+ * ================   User Defines   ====================
+ */
+
+/*!
+ * Use the bitsliced engine for the multi block modes (ECB, CTR and CBC
+ * decryption). It runs 64 blocks at once in 64-bit words, or 256 blocks
+ * with AVX2, so it is on by default only for 64-bit targets.
+ */
+#ifndef DES_BITSLICE
+ #if UINTPTR_MAX > 0xFFFFFFFF
+  #define DES_BITSLICE    (1)
+ #else
+  #define DES_BITSLICE    (0)
+ #endif
+#endif
+
 #define DES_KEY_SIZE    8
+#define DES_BLOCK_SIZE  8
 
 /*!
  * \brief
@@ -82,6 +101,19 @@ void des3_set3key_dec (des3_t *ctx, const uint8_t key[24]);
 void  des_crypt_ecb (des_t *ctx, const uint8_t input[8], uint8_t output[8]);
 void des3_crypt_ecb (des3_t *ctx, const uint8_t input[8], uint8_t output[8]);
 
+/*
+ * Block cipher modes
+ */
+int   des_ecb (des_t *ctx, const uint8_t *in, uint8_t *out, size_t len);
+int   des_cbc_encrypt (des_t *ctx, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len);
+int   des_cbc_decrypt (des_t *ctx, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len);
+void  des_ctr (des_t *ctx, uint8_t ctr[8], const uint8_t *in, uint8_t *out, size_t len);
+
+int  des3_ecb (des3_t *ctx, const uint8_t *in, uint8_t *out, size_t len);
+int  des3_cbc_encrypt (des3_t *ctx, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len);
+int  des3_cbc_decrypt (des3_t *ctx, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len);
+void des3_ctr (des3_t *ctx, uint8_t ctr[8], const uint8_t *in, uint8_t *out, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
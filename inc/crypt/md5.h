@@ -50,6 +50,13 @@ typedef struct
 md5_t;
 
 
+/*
+ * Streaming API
+ */
+void md5_init (md5_t *ctx);
+void md5_update (md5_t *ctx, const uint8_t *input, size_t ilen);
+void md5_finish (md5_t *ctx, uint8_t output[16]);
+
 void md5 (const uint8_t *input, size_t ilen, uint8_t output[16]);
 
 #ifdef __cplusplus
@@ -51,6 +51,13 @@ typedef struct
 sha1_t;
 
 
+/*
+ * Streaming API
+ */
+void sha1_init (sha1_t *ctx);
+void sha1_update (sha1_t *ctx, const uint8_t *input, size_t ilen);
+void sha1_finish (sha1_t *ctx, uint8_t output[20]);
+
 /*!
  * \brief
  *    Output = SHA1 (input buffer)
@@ -38,6 +38,17 @@ extern "C" {
 #include <stddef.h>
 #include <inttypes.h>
 
+/*
+ * User defines
+ */
+#ifndef SHA2_MB_LANES
+#define SHA2_MB_LANES   (8)   //!< Messages hashed in parallel from sha256_mb(). 4 or 8
+#endif
+
+#if SHA2_MB_LANES != 4 && SHA2_MB_LANES != 8
+#error "SHA2_MB_LANES must be 4 or 8"
+#endif
+
 typedef enum {SHA2_224=0, SHA2_256} sha2_size;
 
 /*!
@@ -54,8 +65,17 @@ typedef struct
 sha2_t;
 
 
+/*
+ * Streaming API
+ */
+void sha2_init (sha2_t *ctx, sha2_size sz);
+void sha2_update (sha2_t *ctx, const uint8_t *input, size_t ilen);
+void sha2_finish (sha2_t *ctx, uint8_t *output);
+
 void sha224 (uint8_t *input, size_t ilen, uint8_t output[28]);
 void sha256 (uint8_t *input, size_t ilen, uint8_t output[32]);
+void sha256_mb (const uint8_t *input[], const size_t ilen[], uint8_t *output[], uint32_t n);
+int  sha2_ni_enable (int en);
 
 #ifdef __cplusplus
 }
@@ -60,6 +60,13 @@ typedef struct
 sha3_t;
 
 
+/*
+ * Streaming API
+ */
+void sha3_init (sha3_t *ctx, sha3_size sz);
+void sha3_update (sha3_t *ctx, const uint8_t *input, size_t ilen);
+void sha3_finish (sha3_t *ctx, uint8_t *output);
+
 void sha384 (uint8_t *input, size_t ilen, uint8_t output[48]);
 void sha512 (uint8_t *input, size_t ilen, uint8_t output[64]);
 
@@ -29,7 +29,10 @@ extern "C" {
 #endif
 
 #include <tbx_types.h>
+#include <tbx_ioctl.h>
 #include <com/i2c_bb.h>
+#include <sys/pt.h>
+#include <string.h>
 /*
  * =================== User Defines =====================
  */
@@ -40,6 +43,7 @@ extern "C" {
 
 #define EE_PAGE_SZ_DEF        (64)           // 64 bytes
 #define EE_SECTOR_SIZE_DEF    (512)          // 512 bytes
+#define EE_NO_PAGE            (0xFFFFFFFF)   // Empty cache line
 
 /* ================    General Types    ====================*/
 typedef enum {
@@ -68,10 +72,48 @@ typedef volatile struct
    uint32_t       timeout;
 }ee_conf_t;
 
+/*!
+ * Write-back cache line. It holds one EEPROM page. The dirty bytes
+ * are the span [lo, hi) and are written back with one page write.
+ */
+typedef struct
+{
+   address_t      page;       /*!< Page address of the line, EE_NO_PAGE for empty line */
+   uint16_t       lo, hi;     /*!< Dirty span [lo, hi) inside the page */
+   uint8_t        valid;      /*!< The whole page is loaded from the EEPROM */
+   uint32_t       stamp;      /*!< Last use, for LRU replacement */
+   byte_t         *data;      /*!< Line data, page_size bytes */
+}ee_line_t;
+
+/*!
+ * The optional write-back cache
+ */
+typedef struct
+{
+   ee_line_t      *line;      /*!< Cache lines */
+   byte_t         *mem;       /*!< Data of the lines, lines * page_size bytes */
+   uint32_t       lines;      /*!< The number of lines, 0 for no cache */
+   uint32_t       clock;      /*!< LRU clock */
+}ee_cache_t;
+
+/*!
+ * Non blocking operation state, \see ee_read_async(), ee_write_async().
+ * Zero it before the first call.
+ */
+typedef struct
+{
+   pt_t           pt;         /*!< Protothread of the operation */
+   bytecount_t    done;       /*!< Bytes done */
+   int            ret;        /*!< Bytes of the last page write */
+   uint32_t       to;         /*!< ACK polling tries left */
+   drv_status_en  st;         /*!< ACK polling result */
+}ee_op_t;
+
 typedef volatile struct
 {
    ee_io_t        io;
    ee_conf_t      conf;
+   ee_cache_t     cache;
    drv_status_en  status;
 }ee_t;
 
@@ -88,6 +130,7 @@ void ee_link_i2c (ee_t *ee, void* i2c);
 void ee_link_i2c_rx (ee_t *ee, drv_i2c_rx_ft fun);
 void ee_link_i2c_tx (ee_t *ee, drv_i2c_tx_ft fun);
 void ee_link_i2c_ioctl (ee_t *ee, drv_i2c_ioctl_ft fun);
+void ee_link_cache (ee_t *ee, ee_line_t *line, byte_t *mem, uint32_t lines);
 
 /*
  * Set functions
@@ -113,6 +156,10 @@ drv_status_en ee_write (ee_t *ee, address_t add, byte_t *buf, bytecount_t n);
 
 drv_status_en  ee_read_sector (ee_t *ee, int sector, byte_t *buf, int count);
 drv_status_en ee_write_sector (ee_t *ee, int sector, byte_t *buf, int count);
+drv_status_en        ee_sync (ee_t *ee);
+
+drv_status_en  ee_read_async (ee_t *ee, ee_op_t *op, address_t add, byte_t *buf, bytecount_t n);
+drv_status_en ee_write_async (ee_t *ee, ee_op_t *op, address_t add, byte_t *buf, bytecount_t n);
 
 drv_status_en       ee_ioctl (ee_t *ee, ioctl_cmd_t cmd, ioctl_buf_t buf);
 
@@ -0,0 +1,195 @@
+/*!
+ * \file flog.h
+ * \brief
+ *    A target independent log structured key/record store for NOR flash.
+ *    The records are appended to a page buffer and programmed a page at a
+ *    time. The obsolete records are reclaimed sector by sector, choosing the
+ *    sectors by their garbage and their erase count (wear leveling). A RAM
+ *    index [key] -> flash address is rebuilt at mount.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __flog_h__
+#define __flog_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_ioctl.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <algo/crc.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * ================   User Defines   ====================
+ */
+
+/*!
+ * The smallest flash area that is programmed once. The S25FS keeps an
+ * ECC for each 16 bytes, so a flush pads the log to this boundary.
+ */
+#ifndef FLOG_PROG_UNIT
+#define FLOG_PROG_UNIT           (16)
+#endif
+
+/*!
+ * Free sectors kept for the reclamation. The writes wait for a
+ * reclamation when only these are left.
+ */
+#ifndef FLOG_RESERVE_SECTORS
+#define FLOG_RESERVE_SECTORS     (1)
+#endif
+
+/*!
+ * flog_service() reclaims a sector while the free sectors are less
+ * than this.
+ */
+#ifndef FLOG_SERVICE_SECTORS
+#define FLOG_SERVICE_SECTORS     (3)
+#endif
+
+/*!
+ * The erase count difference that moves the data of the least worn
+ * sector (cold data), so the sector returns to the free ones.
+ */
+#ifndef FLOG_WEAR_DELTA
+#define FLOG_WEAR_DELTA          (16)
+#endif
+
+/*
+ * ================   General Defines   ====================
+ */
+#define FLOG_PAGE_SZ_DEF         (256)          /*!< Program page size */
+#define FLOG_SECTOR_SZ_DEF       (0x10000)      /*!< Erase sector size, 64k */
+
+#define FLOG_MAGIC               (0x474F4C46)   /*!< "FLOG" */
+#define FLOG_HEADER_SIZE         (2*FLOG_PROG_UNIT)   /*!< Sector header, {magic, erase count, ~erase count} and {seq, ~seq} units */
+#define FLOG_REC_HEADER_SIZE     (8)            /*!< Record header {key, len, crc, 0xFFFF} */
+#define FLOG_ALIGN               (4)            /*!< Record alignment */
+#define FLOG_SEQ_FREE            (0xFFFFFFFF)   /*!< Sequence of an erased sector */
+#define FLOG_NO_SECTOR           (0xFFFFFFFF)
+
+typedef uint16_t  flog_key_t;     /*!< Record key, [0 .. keys) */
+typedef uint32_t  flog_addr_t;    /*!< Flash address, 0 for no record */
+
+typedef drv_status_en (*flog_io_ft) (void*, uint32_t, byte_t*, int);        /*!< Flash I/O function pointer */
+typedef drv_status_en (*flog_ioctl_ft) (void*, ioctl_cmd_t, ioctl_buf_t);  /*!< Flash io control function pointer */
+
+/*!
+ * The drivers link data struct.
+ */
+typedef struct {
+   void *         flash;      /*!< void flash type structure, ex: s25fs_t, snor_t */
+   flog_io_ft     fl_read;    /*!< Link to FLASH read function */
+   flog_io_ft     fl_write;   /*!< Link to FLASH write function */
+   flog_ioctl_ft  fl_ioctl;   /*!< Link to FLASH io control function, for CTRL_ERASE_PAGE */
+}flog_io_t;
+
+/*!
+ * The flog configuration and settings struct
+ */
+typedef struct {
+   uint32_t       base;       /*!< The flash address of the store, sector aligned */
+   uint32_t       sectors;    /*!< The number of erase sectors of the store */
+   uint32_t       sector_sz;  /*!< The flash erase sector size */
+   uint32_t       page_sz;    /*!< The flash program page size */
+}flog_conf_t;
+
+/*!
+ * RAM information of each sector
+ */
+typedef struct {
+   uint32_t       erase_cnt;  /*!< Erase count */
+   uint32_t       seq;        /*!< Log sequence, FLOG_SEQ_FREE for free sectors */
+   uint32_t       used;       /*!< Used bytes, the end of the records */
+   uint32_t       live;       /*!< Bytes of the current records */
+}flog_sector_t;
+
+/*!
+ * Statistics
+ */
+typedef struct {
+   uint32_t       user_bytes; /*!< Record data written by the user */
+   uint32_t       copy_bytes; /*!< Record bytes copied by the reclamation */
+   uint32_t       reclaims;   /*!< Reclaimed sectors */
+   uint32_t       erases;     /*!< Erased sectors */
+}flog_stat_t;
+
+/*!
+ * The flog data type.
+ */
+typedef struct {
+   flog_io_t      io;         /*!< driver links */
+   flog_conf_t    conf;       /*!< Configuration and settings */
+   flog_addr_t    *index;     /*!< RAM index [key] -> flash address of the key's last record */
+   uint32_t       keys;       /*!< The number of entries in index buffer */
+   flog_sector_t  *sec;       /*!< Sector table, conf.sectors entries */
+   byte_t         *page;      /*!< Page buffer, conf.page_sz bytes */
+   uint32_t       active;     /*!< The sector we append to */
+   uint32_t       wpos;       /*!< The write offset in active sector */
+   uint32_t       ppos;       /*!< The programmed offset in active sector */
+   uint32_t       seq;        /*!< The next sector sequence */
+   uint32_t       free;       /*!< The number of free sectors */
+   flog_stat_t    stat;       /*!< Statistics */
+   drv_status_en  status;     /*!< flog status */
+}flog_t;
+
+/*
+ * ========== Public flog API ================
+ */
+
+/*
+ * Link and Glue functions
+ */
+void flog_link_flash (flog_t *flog, void* flash);
+void flog_link_flash_read (flog_t *flog, flog_io_ft f);
+void flog_link_flash_write (flog_t *flog, flog_io_ft f);
+void flog_link_flash_ioctl (flog_t *flog, flog_ioctl_ft f);
+void flog_link_index (flog_t *flog, flog_addr_t *index, uint32_t keys);
+void flog_link_sectors (flog_t *flog, flog_sector_t *sec, uint32_t sectors);
+void flog_link_page (flog_t *flog, byte_t *page);
+
+/*
+ * Set functions
+ */
+void flog_set_base (flog_t *flog, uint32_t address);
+void flog_set_sector_size (flog_t *flog, uint32_t size);
+void flog_set_page_size (flog_t *flog, uint32_t size);
+
+/*
+ * User Functions
+ */
+void flog_deinit (flog_t *flog);
+drv_status_en flog_init (flog_t *flog);
+
+int flog_read (flog_t *flog, flog_key_t key, void *buf, int size);
+drv_status_en flog_write (flog_t *flog, flog_key_t key, const void *buf, int size);
+drv_status_en flog_delete (flog_t *flog, flog_key_t key);
+drv_status_en flog_sync (flog_t *flog);
+int flog_service (flog_t *flog);
+drv_status_en flog_ioctl (flog_t *flog, ioctl_cmd_t cmd, ioctl_buf_t buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   //#ifndef __flog_h__
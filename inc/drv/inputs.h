@@ -0,0 +1,150 @@
+/*!
+ * \file inputs.h
+ * \brief
+ *    A target independent multi bank input scanner with timestamped events
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __inputs_h__
+#define __inputs_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_ioctl.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <algo/ring.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * =================== General Defines =====================
+ */
+#define IN_BANK_BITS          (32)        /*!< Inputs per bank */
+#define IN_DEF_HOLDTIME       (2000)      /*!< Ticks for a long press */
+#define IN_DEF_REPTIME        (200)       /*!< Ticks between repeats */
+
+/*!
+ * The input id of an event. The bank index on the upper bits and
+ * the bit of the bank on the lower 5 bits.
+ */
+#define IN_ID(_bank, _bit)    ((uint16_t)(((_bank) << 5) | ((_bit) & 0x1F)))
+#define IN_ID_BANK(_id)       ((_id) >> 5)
+#define IN_ID_BIT(_id)        ((_id) & 0x1F)
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Input event types
+ */
+typedef enum {
+   IN_EV_PRESS = 0,     /*!< The input became active */
+   IN_EV_LONG,          /*!< The input is active for holdtime */
+   IN_EV_REPEAT,        /*!< The input is still active, every reptime after the long event */
+   IN_EV_RELEASE,       /*!< The input released before holdtime */
+   IN_EV_LONG_RELEASE   /*!< The input released after a long event */
+}in_event_en;
+
+/*!
+ * Input event, as it comes out of the event queue
+ */
+typedef struct {
+   uint32_t    time;          /*!< The scan time of the event, in user's ticks */
+   uint16_t    id;            /*!< The input id, see IN_ID() */
+   uint8_t     type;          /*!< The event type, see in_event_en */
+   uint8_t     _res;
+}in_event_t;
+
+/*!
+ * Bank read function. Returns the raw state of up to 32 inputs
+ * with a single transaction.
+ */
+typedef drv_status_en (*in_read_ft) (void *, uint32_t *);
+
+/*!
+ * An input bank. Up to 32 inputs, read at once and debounced in
+ * parallel with a 2 bit vertical counter per input. An input has to
+ * be stable for 4 scans before its debounced state follows.
+ */
+typedef struct {
+   void*          dev;        /*!< void bank device, ex: tca953x_t, a GPIO port */
+   in_read_ft     read;       /*!< Bank read function */
+   uint32_t       mask;       /*!< Used inputs */
+   uint32_t       inv;        /*!< Active low inputs */
+   uint32_t       rep;        /*!< Inputs with repeat events */
+   uint32_t       state;      /*!< Debounced state, 1 for active */
+   uint32_t       cnt0;       /*!< Vertical counter, bit 0 */
+   uint32_t       cnt1;       /*!< Vertical counter, bit 1 */
+   uint32_t       tmr;        /*!< Inputs waiting for a long/repeat deadline */
+   uint32_t       lng;        /*!< Inputs that had a long event */
+   uint32_t       dl[IN_BANK_BITS];   /*!< The next long/repeat deadline of each input */
+}in_bank_t;
+
+/*!
+ * Input scanner data struct
+ */
+typedef struct {
+   in_bank_t*     bank;       /*!< Banks of the scanner */
+   int            banks;      /*!< Number of banks */
+   ring_spsc_t    q;          /*!< Event queue, scan is the producer */
+   uint32_t       holdtime;   /*!< Ticks for a long press */
+   uint32_t       reptime;    /*!< Ticks between repeats */
+   uint32_t       lost;       /*!< Events lost on a full queue */
+   drv_status_en  status;
+}in_t;
+
+/*
+ *  ============= PUBLIC Inputs API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+void in_link_bank (in_bank_t *b, void *dev, in_read_ft fun);
+
+/*
+ * Set functions
+ */
+void in_set_bank_mask (in_bank_t *b, uint32_t mask, uint32_t inv);
+void in_set_bank_repeat (in_bank_t *b, uint32_t rep);
+void in_set_holdtime (in_t *in, uint32_t holdtime);
+void in_set_reptime (in_t *in, uint32_t reptime);
+
+/*
+ * User Functions
+ */
+void in_deinit (in_t *in);
+drv_status_en in_init (in_t *in, in_bank_t *bank, int banks, in_event_t *buf, uint32_t items);
+
+drv_status_en in_scan (in_t *in, uint32_t now);
+void in_scan_bank (in_t *in, int b, uint32_t raw, uint32_t now);
+
+int in_get (in_t *in, in_event_t *ev);
+uint32_t in_state (in_t *in, int b);
+void in_flush (in_t *in);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   //#ifndef __inputs_h__
@@ -46,6 +46,7 @@ extern "C" {
  * User Functions
  */
 temp_t sen_jtype (float volt, float contact);
+const sen_lut_t* sen_jtype_lut (void);
 
 
 #ifdef __cplusplus
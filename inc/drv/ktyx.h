@@ -47,8 +47,11 @@ extern "C" {
  * User Functions
  */
 temp_t sen_kty8x_121 (res_t r);
+const sen_lut_t* sen_kty8x_121_lut (void);
 temp_t sen_kty8x_122 (res_t r);
+const sen_lut_t* sen_kty8x_122_lut (void);
 temp_t sen_kty11_6 (res_t r);
+const sen_lut_t* sen_kty11_6_lut (void);
 
 #ifdef __cplusplus
 }
@@ -47,6 +47,7 @@ extern "C" {
  * User Functions
  */
 temp_t sen_ntc10k_3435k (res_t r);
+const sen_lut_t* sen_ntc10k_3435k_lut (void);
 
 
 #ifdef __cplusplus
@@ -46,6 +46,7 @@ extern "C" {
  * User Functions
  */
 temp_t sen_ntc3997k (res_t r);
+const sen_lut_t* sen_ntc3997k_lut (void);
 
 
 #ifdef __cplusplus
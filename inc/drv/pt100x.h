@@ -47,7 +47,9 @@ extern "C" {
  * User Functions
  */
 temp_t sen_pt100 (res_t r);
+const sen_lut_t* sen_pt100_lut (void);
 temp_t sen_pt1000 (res_t r);
+const sen_lut_t* sen_pt1000_lut (void);
 
 #ifdef __cplusplus
 }
@@ -33,6 +33,7 @@ extern "C" {
 #include <stddef.h>
 #include <com/spi_bb.h>
 #include <sys/jiffies.h>
+#include <sys/pt.h>
 #include <crypt/cryptint.h>
 
 /*
@@ -154,6 +155,18 @@ typedef volatile struct {
    uint32_t sector_sz;        /*!< The virtual sector size, used in file systems */
 }s25fs_conf_t;
 
+/*!
+ * Non blocking operation state, \see s25fs_read_async(), s25fs_write_async(),
+ * s25fs_erase_async(). Zero it before the first call.
+ */
+typedef struct {
+   pt_t           pt;         /*!< Protothread of the operation */
+   int            done;       /*!< Bytes done */
+   int            ret;        /*!< Bytes of the last page program */
+   jf_deadline_t  dl;         /*!< Ready polling deadline */
+   drv_status_en  st;         /*!< Ready polling result */
+}s25fs_op_t;
+
 /*!
  * The s25fs driver data type. Each one refers to
  * each flash chip in the PCB.
@@ -196,6 +209,11 @@ drv_status_en         s25fs_read (s25fs_t *drv, s25fs_idx_t idx, s25fs_data_t *b
 drv_status_en        s25fs_write (s25fs_t *drv, s25fs_idx_t idx, s25fs_data_t *buf, int count);
 drv_status_en  s25fs_read_sector (s25fs_t *drv, int sector, s25fs_data_t *buf, int count);
 drv_status_en s25fs_write_sector (s25fs_t *drv, int sector, s25fs_data_t *buf, int count);
+
+drv_status_en  s25fs_erase_async (s25fs_t *drv, s25fs_op_t *op, s25fs_idx_t idx);
+drv_status_en   s25fs_read_async (s25fs_t *drv, s25fs_op_t *op, s25fs_idx_t idx, s25fs_data_t *buf, int count);
+drv_status_en  s25fs_write_async (s25fs_t *drv, s25fs_op_t *op, s25fs_idx_t idx, s25fs_data_t *buf, int count);
+
 drv_status_en        s25fs_ioctl (s25fs_t *drv, ioctl_cmd_t ctrl, ioctl_buf_t buf);
 
 #ifdef __cplusplus
@@ -36,6 +36,7 @@ extern "C" {
 
 #include <tbx_ioctl.h>
 #include <tbx_types.h>
+#include <sys/pt.h>
 #include <string.h>
 #include <stdint.h>
 
@@ -100,6 +101,11 @@ typedef drv_status_en (*spi_ioctl_t) (void *, ioctl_cmd_t, ioctl_buf_t);
 //typedef uint8_t (*spi_read_t) (void *, int);
 //typedef void    (*spi_write_t) (void *, uint8_t, int);
 typedef uint8_t (*spi_rw_t) (void *spi, uint8_t data);
+/*!
+ * Bulk SPI transfer of n bytes. A NULL tx sends 0xFF bytes and
+ * a NULL rx discards the received bytes.
+ */
+typedef void    (*spi_rw_block_t) (void *spi, const uint8_t *tx, uint8_t *rx, size_t n);
 
 typedef volatile struct
 {
@@ -110,6 +116,9 @@ typedef volatile struct
    void*          spi;           /*!< void SPI type structure */
    spi_ioctl_t    spi_ioctl;     /*!< SPI ioctl function */
    spi_rw_t       spi_rw;        /*!< SPI read/write function */
+   spi_rw_block_t spi_rw_block;  /*!< Optional SPI bulk read/write function (DMA/FIFO) */
+   sd_dat_t*      ra_buf;        /*!< Optional read-ahead cache buffer [ra_size * 512] */
+   uint32_t       ra_size;       /*!< Read-ahead cache size in sectors */
 }sd_io_t;
 
 typedef volatile struct
@@ -119,6 +128,8 @@ typedef volatile struct
    uint8_t        pow;     /*!< power on flag */
    drv_status_en  status;  /*!< Disk status */
    uint32_t       t1, t2;  /*!< General decrement timers on time-base \sa SD_timebase() */
+   sd_idx_t       ra_sector;  /*!< First sector in read-ahead cache */
+   uint32_t       ra_count;   /*!< Valid sectors in read-ahead cache, 0 for empty */
 }sd_data_t;
 
 typedef volatile struct
@@ -127,6 +138,18 @@ typedef volatile struct
    sd_data_t      drive[SD_NUMBER_OF_DRIVES];      /*!< Physical drive table */
 }sd_spi_t;
 
+/*!
+ * Non blocking operation state, \see sd_read_async(), sd_write_async().
+ * Zero it before the first call.
+ */
+typedef struct
+{
+   pt_t           pt;         /*!< Protothread of the operation */
+   size_t         done;       /*!< Sectors done */
+   sd_idx_t       addr;       /*!< Card address of the first sector */
+   sd_dat_t       r;          /*!< The last polled byte */
+}sd_op_t;
+
 
 /*!
  * FAT FS Compatible types and defines.
@@ -157,6 +180,8 @@ void sd_link_cs (int drv, drv_pinout_ft fun);
 void sd_link_pw (int drv, drv_pinout_ft fun);
 void sd_link_spi_ioctl (int drv, spi_ioctl_t fun);
 void sd_link_spi_rw (int drv, spi_rw_t fun);
+void sd_link_spi_rw_block (int drv, spi_rw_block_t fun);
+void sd_link_cache (int drv, void* buf, uint32_t sectors);
 void sd_link_spi (int drv, void* spi);
 
 /*
@@ -175,6 +200,8 @@ drv_status_en sd_setstatus (int drv, drv_status_en st);   /*!< for compatibility
 
 drv_status_en  sd_read (int drv, sd_idx_t sector, sd_dat_t *buf, size_t count);
 drv_status_en sd_write (int drv, sd_idx_t sector, const sd_dat_t *buf, size_t count);
+drv_status_en  sd_read_async (int drv, sd_op_t *op, sd_idx_t sector, sd_dat_t *buf, size_t count);
+drv_status_en sd_write_async (int drv, sd_op_t *op, sd_idx_t sector, const sd_dat_t *buf, size_t count);
 drv_status_en sd_ioctl (int drv, ioctl_cmd_t ctrl, ioctl_buf_t buf);
 
 #ifdef __cplusplus
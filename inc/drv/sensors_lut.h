@@ -30,9 +30,19 @@
 #define __sensors_lut_h__
 
 #include <math.h>
+#include <float.h>
 #include <limits.h>
 #include <stdint.h>
 
+/* ================      User Defines      ======================*/
+
+/*!
+ * Maximum number of points of a compiled LUT. It has to be a power of 2,
+ * the compiled tables are padded up to it for the branchless search.
+ */
+#ifndef SEN_LUT_SIZE
+#define  SEN_LUT_SIZE  (64)
+#endif
 
 /* ================        General         ======================*/
 #define  TEMP_ERROR    (-274.0)        // Bellow Absolute zero
@@ -45,12 +55,44 @@ typedef float  lux_t;
 typedef float  press_t;
 typedef float  lut_t;
 
+/*!
+ * Conversion method of a compiled LUT
+ */
+typedef enum {
+   SEN_FIT_NONE = 0,    //!< Linear interpolation of the table
+   SEN_FIT_CUBIC,       //!< Least squares cubic polynomial
+   SEN_FIT_SH           //!< Steinhart-Hart equation, for NTC thermistors
+}sen_fit_en;
+
+/*!
+ * Compiled LUT. It is built once from a FROM/TO table pair and converts
+ * without scanning the table. The FROM points are stored ascending, so
+ * the negative coefficient tables are stored negated.
+ */
+typedef struct {
+   float       f[SEN_LUT_SIZE];  /*!< Ascending FROM points, padded with FLT_MAX */
+   float       t[SEN_LUT_SIZE];  /*!< TO points */
+   float       k[SEN_LUT_SIZE];  /*!< Slope dt/df of each segment */
+   int         n;                /*!< Number of points, 0 for not compiled */
+   int         size;             /*!< The padded size, power of 2 */
+   float       gain;             /*!< v -> f[] units, scale and sign */
+   float       inv;              /*!< 1/step for uniform FROM points, 0 otherwise */
+   sen_fit_en  fit;              /*!< Conversion method */
+   float       c[4];             /*!< Fit coefficients */
+   float       xc, xs;           /*!< Cubic fit input normalisation x = (v*scale - xc)*xs */
+}sen_lut_t;
+
 /*
  * ================== Exported API to Lib ==================
  */
 float sen_nclut (float v, const lut_t *F, const float *T);
 float sen_pclut (float v, const lut_t *F, const float *T);
 
+int   sen_lut_init (sen_lut_t *lut, const lut_t *F, const float *T, float scale);
+float  sen_lut_fit (sen_lut_t *lut, sen_fit_en fit);
+float  sen_convert (const sen_lut_t *lut, float v);
+void sen_convert_n (const sen_lut_t *lut, const float *v, float *t, int n);
+
 /*!
  * \note
  *    Dont need to use these functions directly. The sen_pt100(), sen_pt1000(),
@@ -75,6 +75,12 @@ typedef  uint32_t    see_idx_t;     /*!< SEE byte addressing */
 
 
 
+/*!
+ * The number of entries needed for the RAM index of a see with
+ * page size _ps and word size _ws. One entry per virtual word.
+ */
+#define SEE_INDEX_ENTRIES(_ps, _ws)    ((_ps) / ((_ws) + sizeof (see_idx_t)))
+
 typedef enum {
    EE_SUCCESS = 0,
    EE_NODATA,
@@ -134,6 +140,9 @@ typedef volatile struct {
    see_iface_t    iface;      /*!< Interface */
    see_idx_t      last_cur;   /*!< Holds the last write flash address of current page */
    see_idx_t      last_pr;    /*!< Holds the last write flash address of previous page */
+   see_idx_t      *index;     /*!< Optional RAM index [word] -> flash address of the word's last record, 0 for no data */
+   uint32_t       index_size; /*!< The number of entries in index buffer */
+   uint8_t        index_en;   /*!< The index is linked, big enough and up to date */
    drv_status_en  status;     /*!< see driver status, NOT the device status */
 }see_t;
 
@@ -148,6 +157,7 @@ void see_link_flash (see_t *see, void* flash);
 void see_link_flash_read (see_t *see, fl_io_ft f);
 void see_link_flash_write (see_t *see, fl_io_ft f);
 void see_link_flash_ioctl (see_t *see, fl_ioctl_ft f);
+void see_link_index (see_t *see, see_idx_t *index, uint32_t entries);
 
 /*
  * Set functions
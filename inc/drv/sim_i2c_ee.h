@@ -0,0 +1,146 @@
+/*!
+ * \file sim_i2c_ee.h
+ * \brief
+ *    A RAM backed 24xx I2C EEPROM simulator. It has the i2c_tx/i2c_rx/
+ *    i2c_ioctl interface of the I2C drivers, so it can be linked to the
+ *    ee_i2c driver. It models the control byte, the address bytes, the
+ *    page write roll over, the write cycle that does not acknowledge the
+ *    control byte and the sequential read, and it counts the bus
+ *    transactions and the bus time so EEPROM users can be measured.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __sim_i2c_ee_h__
+#define __sim_i2c_ee_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_ioctl.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * =================== General Defines =====================
+ */
+#define SIE_HWADDR_DEF           (0xA0)      /*!< Control code of the 24xx family */
+#define SIE_PAGE_SZ_DEF          (64)        /*!< Page size */
+
+/*!
+ * Default timings of a 24xx at 400KHz, in nsec
+ */
+#define SIE_T_BYTE_DEF           (22500)     /*!< Byte with ack, 9 clocks */
+#define SIE_T_COND_DEF           (2500)      /*!< Start or stop condition */
+#define SIE_T_WR_DEF             (5000000)   /*!< Write cycle */
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * The bus state of the simulator
+ */
+typedef enum {
+   SIE_ST_IDLE = 0,     /*!< Wait for start */
+   SIE_ST_CONTROL,      /*!< Wait for the control byte */
+   SIE_ST_ADDRESS,      /*!< Receive the address bytes */
+   SIE_ST_WRITE,        /*!< Receive data to write */
+   SIE_ST_READ          /*!< Transmit data */
+}sie_state_en;
+
+/*!
+ * The simulator timing model, in nsec
+ */
+typedef struct {
+   uint32_t       byte;       /*!< Byte with ack, 9 clocks */
+   uint32_t       cond;       /*!< Start or stop condition */
+   uint32_t       wr;         /*!< Write cycle */
+}sie_timing_t;
+
+/*!
+ * The simulator statistics
+ */
+typedef struct {
+   uint64_t       time;       /*!< Total bus time in nsec */
+   uint64_t       read_bytes; /*!< Data bytes read */
+   uint64_t       write_bytes;/*!< Data bytes written */
+   uint32_t       transactions; /*!< Start conditions */
+   uint32_t       polls;      /*!< Not acknowledged control bytes during a write cycle */
+   uint32_t       page_writes;/*!< Write cycles */
+}sie_stat_t;
+
+/*!
+ * The simulator data type.
+ */
+typedef struct {
+   byte_t         *mem;       /*!< The RAM image of the EEPROM */
+   uint32_t       size;       /*!< The EEPROM size */
+   uint32_t       page_sz;    /*!< Page size */
+   byte_t         hw_addr;    /*!< Control byte without the R/W bit */
+   uint8_t        addr_sz;    /*!< Address bytes, 1 up to 256 bytes size else 2 */
+   sie_state_en   state;      /*!< Bus state */
+   uint8_t        acnt;       /*!< Received address bytes */
+   uint32_t       ptr;        /*!< Address counter */
+   uint32_t       wcnt;       /*!< Bytes of the current page write */
+   uint64_t       busy;       /*!< End time of the write cycle */
+   uint64_t       *clock;     /*!< Shared simulation clock in nsec, NULL to run on the bus time */
+   sie_timing_t   t;          /*!< Timing model */
+   sie_stat_t     stat;       /*!< Statistics */
+   drv_status_en  status;     /*!< Simulator status */
+}sie_t;
+
+
+/*
+ *  ============= PUBLIC SIM I2C EE API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+void sie_link_mem (sie_t *sie, byte_t *mem, uint32_t size);
+void sie_link_clock (sie_t *sie, uint64_t *clock);
+
+/*
+ * Set functions
+ */
+void sie_set_hwaddress (sie_t *sie, byte_t add);
+void sie_set_page_size (sie_t *sie, uint32_t size);
+void sie_set_timing (sie_t *sie, uint32_t byte, uint32_t cond, uint32_t wr);
+
+/*
+ * User Functions
+ */
+void sie_deinit (sie_t *sie);
+drv_status_en sie_init (sie_t *sie);
+
+/*
+ * I2C interface, to link to the EEPROM driver
+ */
+byte_t sie_i2c_rx (sie_t *sie, uint8_t ack, int seq);
+int    sie_i2c_tx (sie_t *sie, byte_t byte, int seq);
+drv_status_en sie_i2c_ioctl (sie_t *sie, ioctl_cmd_t cmd, ioctl_buf_t buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   //#ifndef __sim_i2c_ee_h__
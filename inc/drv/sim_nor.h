@@ -0,0 +1,173 @@
+/*!
+ * \file sim_nor.h
+ * \brief
+ *    A RAM backed NOR flash simulator. It has the page program and
+ *    sector erase semantics of a NOR flash and a timing model of the
+ *    SPI transfers, the page programs and the erases, so flash users
+ *    can be measured on the host or on the target. The SPI interface
+ *    links to the S25FS driver, with the busy status of the programs
+ *    and the erases.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __sim_nor_h__
+#define __sim_nor_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_ioctl.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * =================== General Defines =====================
+ */
+#define SNOR_PAGE_SZ_DEF         (256)       /*!< Program page size */
+#define SNOR_SECTOR_SZ_DEF       (0x10000)   /*!< Erase sector size, 64k */
+
+/*!
+ * Default timings of a S25FS at 50MHz SPI, in nsec
+ */
+#define SNOR_T_CMD_DEF           (1000)      /*!< Command, address and CS overhead */
+#define SNOR_T_BYTE_DEF          (160)       /*!< Transfer of one byte */
+#define SNOR_T_PP_DEF            (340000)    /*!< Page program */
+#define SNOR_T_SE_DEF            (520000000) /*!< Sector erase */
+
+/*!
+ * The S25FS commands of the SPI interface
+ */
+#define SNOR_CMD_WRDI            (0x04)
+#define SNOR_CMD_RDSR            (0x05)
+#define SNOR_CMD_WREN            (0x06)
+#define SNOR_CMD_PP_4B           (0x12)
+#define SNOR_CMD_READ_4B         (0x13)
+#define SNOR_CMD_SE_4B           (0xDC)
+
+#define SNOR_SR_WIP              (0x01)      /*!< Write in progress */
+#define SNOR_SR_WEL              (0x02)      /*!< Write enable latch */
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * The SPI interface state of the simulator
+ */
+typedef enum {
+   SNOR_ST_IDLE = 0,    /*!< Not selected or ignored command */
+   SNOR_ST_CMD,         /*!< Wait for the command */
+   SNOR_ST_ADDR,        /*!< Receive the address */
+   SNOR_ST_RDSR,        /*!< Transmit the status register */
+   SNOR_ST_READ,        /*!< Transmit data */
+   SNOR_ST_PROG,        /*!< Receive data to program */
+   SNOR_ST_ERASE        /*!< Erase on deselect */
+}snor_state_en;
+
+/*!
+ * The simulator timing model, in nsec
+ */
+typedef struct {
+   uint32_t       cmd;        /*!< Command, address and CS overhead */
+   uint32_t       byte;       /*!< Transfer of one byte */
+   uint32_t       pp;         /*!< Page program */
+   uint32_t       se;         /*!< Sector erase */
+}snor_timing_t;
+
+/*!
+ * The simulator statistics
+ */
+typedef struct {
+   uint64_t       time;       /*!< Total busy time in nsec */
+   uint64_t       read_bytes; /*!< Read bytes */
+   uint64_t       prog_bytes; /*!< Programmed bytes */
+   uint32_t       reads;      /*!< Read commands */
+   uint32_t       programs;   /*!< Page program commands */
+   uint32_t       erases;     /*!< Sector erase commands */
+   uint32_t       violations; /*!< Programs that try to turn 0 bits to 1 */
+   uint32_t       polls;      /*!< Status reads during a program or an erase */
+}snor_stat_t;
+
+/*!
+ * The simulator data type.
+ */
+typedef struct {
+   byte_t         *mem;       /*!< The RAM image of the flash */
+   uint32_t       size;       /*!< The flash size */
+   uint32_t       page_sz;    /*!< Program page size */
+   uint32_t       sector_sz;  /*!< Erase sector size */
+   uint32_t       *erase_cnt; /*!< Optional erase counters, one per sector */
+   snor_state_en  state;      /*!< SPI interface state */
+   byte_t         cmd;        /*!< SPI command */
+   uint8_t        acnt;       /*!< Received address bytes */
+   uint8_t        wel;        /*!< Write enable latch */
+   uint32_t       ptr;        /*!< Address counter */
+   uint32_t       wcnt;       /*!< Bytes of the current page program */
+   uint64_t       busy;       /*!< End time of the program or erase */
+   uint64_t       *clock;     /*!< Shared simulation clock in nsec, NULL to run on the busy time */
+   snor_timing_t  t;          /*!< Timing model */
+   snor_stat_t    stat;       /*!< Statistics */
+   drv_status_en  status;     /*!< Simulator status */
+}snor_t;
+
+
+/*
+ *  ============= PUBLIC SIM NOR API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+void snor_link_mem (snor_t *snor, byte_t *mem, uint32_t size);
+void snor_link_erase_cnt (snor_t *snor, uint32_t *cnt);
+void snor_link_clock (snor_t *snor, uint64_t *clock);
+
+/*
+ * Set functions
+ */
+void snor_set_page_sz (snor_t *snor, uint32_t size);
+void snor_set_sector_sz (snor_t *snor, uint32_t size);
+void snor_set_timing (snor_t *snor, uint32_t cmd, uint32_t byte, uint32_t pp, uint32_t se);
+
+/*
+ * User Functions
+ */
+void snor_deinit (snor_t *snor);
+drv_status_en snor_init (snor_t *snor);
+
+drv_status_en snor_erase (snor_t *snor, uint32_t idx);
+drv_status_en  snor_read (snor_t *snor, uint32_t idx, byte_t *buf, int count);
+drv_status_en snor_write (snor_t *snor, uint32_t idx, byte_t *buf, int count);
+drv_status_en snor_ioctl (snor_t *snor, ioctl_cmd_t ctrl, ioctl_buf_t buf);
+
+/*
+ * SPI interface, to link to the S25FS driver
+ */
+void snor_spi_cs (snor_t *snor, uint8_t en);
+drv_status_en snor_spi_read (snor_t *snor, byte_t *buf, int n);
+drv_status_en snor_spi_write (snor_t *snor, byte_t *buf, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   //#ifndef __sim_nor_h__
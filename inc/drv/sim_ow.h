@@ -0,0 +1,137 @@
+/*!
+ * \file sim_ow.h
+ * \brief
+ *    A multi-device 1-Wire bus simulator. It has the rw/rwbuf/br interface
+ *    of the UART 1-Wire driver and it decodes the UART frames to resets and
+ *    time slots at standard and overdrive speed. The devices answer to the
+ *    ROM commands, the search, the conditional search and the overdrive skip
+ *    and match. The bus time and the transfers are counted, so 1-Wire users
+ *    can be measured on the host or on the target.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2016 Choutouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __sim_ow_h__
+#define __sim_ow_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_ioctl.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <com/onewire.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * =================== General Defines =====================
+ */
+
+/*!
+ * Default overhead of a UART driver call, in nsec
+ */
+#define SOW_T_CALL_DEF           (20000)
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * The bus state of the simulator
+ */
+typedef enum {
+   SOW_ST_IDLE = 0,     /*!< Wait for reset */
+   SOW_ST_ROMCMD,       /*!< Receive the ROM command */
+   SOW_ST_SEARCH,       /*!< Search triplets */
+   SOW_ST_MATCH,        /*!< Receive the ROM id to match */
+   SOW_ST_READROM,      /*!< Transmit the ROM id */
+   SOW_ST_FUNC          /*!< Function commands, the devices do not answer */
+}sow_state_en;
+
+/*!
+ * A simulated device
+ */
+typedef struct {
+   ow_rom_t       rom;        /*!< ROM id */
+   uint8_t        alarm;      /*!< Alarm condition, for the conditional search */
+   uint8_t        od;         /*!< Overdrive support */
+   uint8_t        speed;      /*!< Current speed, OW_T_STANDARD or OW_T_OVERDRIVE */
+   uint8_t        active;     /*!< Selected from the last ROM command */
+}sow_dev_t;
+
+/*!
+ * The simulator statistics
+ */
+typedef struct {
+   uint64_t       time;       /*!< Total bus time in nsec */
+   uint32_t       resets;     /*!< Reset pulses */
+   uint32_t       slots;      /*!< Time slots */
+   uint32_t       transfers;  /*!< UART driver calls */
+}sow_stat_t;
+
+/*!
+ * The simulator data type.
+ */
+typedef struct {
+   sow_dev_t      *dev;       /*!< The devices on the bus */
+   int            n;          /*!< The number of devices */
+   sow_state_en   state;      /*!< Bus state */
+   uint8_t        cmd;        /*!< The ROM command */
+   uint32_t       cnt;        /*!< Time slots of the current state */
+   uint32_t       baudrate;   /*!< The UART baudrate */
+   uint32_t       t_call;     /*!< UART driver call overhead in nsec */
+   sow_stat_t     stat;       /*!< Statistics */
+   drv_status_en  status;     /*!< Simulator status */
+}sow_t;
+
+
+/*
+ *  ============= PUBLIC SIM 1-Wire API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+void sow_link_devices (sow_t *sow, sow_dev_t *dev, int n);
+
+/*
+ * Set functions
+ */
+void sow_set_timing (sow_t *sow, uint32_t call);
+
+/*
+ * User Functions
+ */
+void sow_deinit (sow_t *sow);
+drv_status_en sow_init (sow_t *sow);
+void sow_make_rom (byte_t *rom, byte_t family, uint64_t serial);
+
+/*
+ * UART interface, to link to the onewire_uart driver
+ */
+uint16_t sow_uart_rw (sow_t *sow, uint8_t frame);
+drv_status_en sow_uart_rwbuf (sow_t *sow, byte_t *frame, int n);
+drv_status_en sow_uart_br (sow_t *sow, uint32_t br);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   //#ifndef __sim_ow_h__
@@ -0,0 +1,180 @@
+/*!
+ * \file sim_sd.h
+ * \brief
+ *    A RAM backed SDHC card simulator in SPI mode. It has the spi_rw,
+ *    spi_rw_block and spi_ioctl interface that the sd_spi driver links
+ *    to. It models the command frames, the R1/R3/R7 responses, the data
+ *    tokens of the single and multiple block reads and writes, the read
+ *    access time and the write busy time, and it counts the SPI calls and
+ *    the bus time so the byte and the bulk paths can be measured.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __sim_sd_h__
+#define __sim_sd_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_ioctl.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * =================== General Defines =====================
+ */
+#define SIMSD_BLOCK_SZ           (512)       /*!< Block size, fixed for SDHC */
+#define SIMSD_INIT_POLLS         (3)         /*!< ACMD41 calls before the card leaves idle */
+
+/*!
+ * Default timings of a class 4 SDHC card, in nsec
+ */
+#define SIMSD_CLOCK_DEF          (400000)    /*!< SPI clock before CTRL_SET_CLOCK, in Hz */
+#define SIMSD_T_GAP_DEF          (500)       /*!< Gap of each SPI call, the CPU time between transfers */
+#define SIMSD_T_ACCESS_DEF       (100000)    /*!< Read access time, command to data token */
+#define SIMSD_T_WR_DEF           (800000)    /*!< Busy time of a single block write */
+#define SIMSD_T_MWR_DEF          (200000)    /*!< Busy time of each block of a multiple block write */
+
+/*!
+ * R1 response bits
+ */
+#define SIMSD_R1_IDLE            (0x01)
+#define SIMSD_R1_ILLEGAL         (0x04)
+#define SIMSD_R1_ADDRESS         (0x20)
+#define SIMSD_R1_PARAM           (0x40)
+
+/*!
+ * Data tokens and data response
+ */
+#define SIMSD_TOKEN_START        (0xFE)      /*!< Single block read/write and multiple block read */
+#define SIMSD_TOKEN_MSTART       (0xFC)      /*!< Multiple block write */
+#define SIMSD_TOKEN_STOP         (0xFD)      /*!< Stop of a multiple block write */
+#define SIMSD_DATA_ACCEPTED      (0x05)
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * The data phase of the simulator
+ */
+typedef enum {
+   SIMSD_PH_NONE = 0,     /*!< Commands only */
+   SIMSD_PH_READ,         /*!< Transmit the data blocks of a read or a register */
+   SIMSD_PH_WTOKEN,       /*!< Wait for a write data token */
+   SIMSD_PH_WDATA         /*!< Receive a write data block and its CRC */
+}simsd_phase_en;
+
+/*!
+ * The simulator timing model, in nsec
+ */
+typedef struct {
+   uint32_t       byte;       /*!< Transfer of one byte, from the SPI clock */
+   uint32_t       gap;        /*!< Gap of each SPI call */
+   uint32_t       access;     /*!< Read access time */
+   uint32_t       wr;         /*!< Single block write busy time */
+   uint32_t       mwr;        /*!< Multiple block write busy time, per block */
+}simsd_timing_t;
+
+/*!
+ * The simulator statistics
+ */
+typedef struct {
+   uint64_t       time;       /*!< Total bus time in nsec */
+   uint64_t       bytes;      /*!< SPI bytes */
+   uint32_t       calls;      /*!< SPI calls, byte and bulk */
+   uint32_t       cmds;       /*!< Command frames */
+   uint32_t       read_blocks;   /*!< Data blocks read */
+   uint32_t       write_blocks;  /*!< Data blocks written */
+   uint32_t       pre_erases; /*!< ACMD23 commands */
+   uint32_t       polls;      /*!< Bytes clocked while the card is busy or in access time */
+   uint32_t       errors;     /*!< Commands answered with an error */
+}simsd_stat_t;
+
+/*!
+ * The simulator data type.
+ */
+typedef struct {
+   byte_t         *mem;       /*!< The RAM image of the card */
+   uint32_t       sectors;    /*!< The card size in blocks */
+   uint8_t        sel;        /*!< Chip select */
+   uint8_t        idle;       /*!< Card in idle state */
+   uint8_t        app;        /*!< The next command is an ACMD */
+   uint8_t        inits;      /*!< ACMD41 calls */
+   byte_t         cmd[6];     /*!< Command frame */
+   uint8_t        cpos;       /*!< Received command bytes */
+   byte_t         resp[8];    /*!< Response bytes to transmit */
+   uint8_t        rlen;       /*!< Response length */
+   uint8_t        rpos;       /*!< Transmitted response bytes */
+   simsd_phase_en phase;      /*!< Data phase */
+   uint8_t        multi;      /*!< Multiple block read/write */
+   uint32_t       sector;     /*!< Current block */
+   const byte_t   *src;       /*!< Data of the read block */
+   uint32_t       dlen;       /*!< Data length of the read block */
+   int32_t        dpos;       /*!< Data position, -1 before the token */
+   uint64_t       ready;      /*!< Time of the next read data token */
+   uint64_t       busy;       /*!< End time of the write busy */
+   byte_t         blk[SIMSD_BLOCK_SZ+2];   /*!< Write block buffer, with CRC */
+   byte_t         reg[64];    /*!< CSD, CID or SD status to transmit */
+   uint64_t       *clock;     /*!< Shared simulation clock in nsec, NULL to run on the bus time */
+   simsd_timing_t t;          /*!< Timing model */
+   simsd_stat_t   stat;       /*!< Statistics */
+   drv_status_en  status;     /*!< Simulator status */
+}simsd_t;
+
+
+/*
+ *  ============= PUBLIC SIM SD API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+void simsd_link_mem (simsd_t *sd, byte_t *mem, uint32_t size);
+void simsd_link_clock (simsd_t *sd, uint64_t *clock);
+
+/*
+ * Set functions
+ */
+void simsd_set_clock (simsd_t *sd, uint32_t clk);
+void simsd_set_timing (simsd_t *sd, uint32_t gap, uint32_t access, uint32_t wr, uint32_t mwr);
+
+/*
+ * User Functions
+ */
+void simsd_deinit (simsd_t *sd);
+drv_status_en simsd_init (simsd_t *sd);
+
+/*
+ * SPI interface, to link to the sd_spi driver
+ */
+void   simsd_spi_cs (simsd_t *sd, uint8_t en);
+byte_t simsd_spi_rw (simsd_t *sd, byte_t out);
+void   simsd_spi_rw_block (simsd_t *sd, const byte_t *tx, byte_t *rx, size_t n);
+drv_status_en simsd_spi_ioctl (simsd_t *sd, ioctl_cmd_t cmd, ioctl_buf_t buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   //#ifndef __sim_sd_h__
@@ -0,0 +1,85 @@
+/*!
+ * \file sim_tim.h
+ * \brief
+ *    A simulated hardware timer for the jiffy module. A wrapping 16bit
+ *    up counter with auto reload, that runs from the host clock or a
+ *    fixed number of ticks on each read, so jiffies, delays and timer
+ *    wheels can be run and measured on the host.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __sim_tim_h__
+#define __sim_tim_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+#include <sys/jiffies.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Simulated timer data. The jiffy links have no driver pointer, so
+ * there is one simulated timer, as there is one jiffy timer.
+ */
+typedef struct {
+   uint32_t       freq;       /*!< Counter frequency, 0 for stopped */
+   uint32_t       top;        /*!< Auto reload value, the counter wraps after top */
+   uint32_t       step;       /*!< Ticks on each read, 0 to follow the host clock */
+   uint64_t       ticks;      /*!< Total ticks from start */
+   uint64_t       t0;         /*!< Host clock at start, in nsec */
+   uint64_t       reads;      /*!< Number of reads */
+   uint64_t       *clock;     /*!< Shared simulation clock in nsec, NULL for none */
+}sim_tim_t;
+
+/*
+ *  ============= PUBLIC Simulated timer API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+void sim_tim_link_clock (uint64_t *clock);
+
+/*
+ * Set functions
+ */
+void sim_tim_set_step (uint32_t step);
+
+/*
+ * User Functions
+ */
+int sim_tim_setfreq (uint32_t freq, uint32_t top);
+jiffy_t sim_tim_read (void);
+void sim_tim_advance (uint64_t ticks);
+uint64_t sim_tim_ticks (void);
+uint64_t sim_tim_reads (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   //#ifndef __sim_tim_h__
@@ -139,6 +139,8 @@ drv_status_en tca953x_init (tca953x_t *tca);
 drv_status_en tca953x_direction (tca953x_t *tca, tca953x_port_en port, tca953x_pin_en pin, uint8_t dir);
 drv_status_en tca953x_port_read (tca953x_t *tca, tca953x_port_en port, uint8_t *in);
 drv_status_en tca953x_port_write (tca953x_t *tca, tca953x_port_en port, uint8_t out);
+drv_status_en tca953x_inputs_read (tca953x_t *tca, uint16_t *in);
+drv_status_en tca953x_in_read (void *tca, uint32_t *in);
 drv_status_en tca953x_pin_read (tca953x_t *tca, tca953x_port_en port, tca953x_pin_en pin, uint8_t *in);
 drv_status_en tca953x_pin_write (tca953x_t *tca, tca953x_port_en port, tca953x_pin_en pin, uint8_t out);
 
@@ -30,6 +30,37 @@ extern "C" {
 #endif
 
 #include <dsp/dsp.h>
+#include <dsp/fft.h>
+#include <dsp/vectors.h>
+#include <string.h>
+
+/*
+ * User defines
+ */
+#ifndef CONV_FFT_THRESHOLD
+#define CONV_FFT_THRESHOLD    (64)  //!< conv_xx() use the FFT when both sizes reach this
+#endif
+
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Streaming overlap-save convolver. Each block of L new samples is
+ * placed after the last M-1 input samples, transformed, multiplied with
+ * the fixed kernel spectrum and transformed back. The first M-1 output
+ * points are discarded (circular aliasing) and the other L are valid.
+ */
+typedef struct {
+   complex_d_t *H;      //!< Kernel spectrum [N]
+   complex_d_t *t;      //!< Work buffer [N]
+   double      *s;      //!< Input segment, M-1 old samples and L new [N]
+   double      *o;      //!< Output of the last block [L]
+   uint32_t    N;       //!< FFT size
+   uint32_t    M;       //!< Kernel size
+   uint32_t    L;       //!< Block size, N-M+1
+   uint32_t    cnt;     //!< Samples in the current block
+}conv_ols_t;
 
 /*
  * ================== Public API ====================
@@ -84,6 +115,50 @@ void conv_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_
 #endif   // #ifndef conv
 #endif   // #if __STDC_VERSION__ >= 201112L
 
+
+int conv_fft_f (float *y, float *h, int32_t sh, float *x, int32_t sx) __O3__ ;
+int conv_fft_d (double *y, double *h, int32_t sh, double *x, int32_t sx) __O3__ ;
+int conv_fft_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t sx) __O3__ ;
+int conv_fft_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t sx) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+
+#ifndef conv_fft
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> int conv_fft (T *y, T *h, uint32_t sh, T *x, uint32_t sx);
+ *
+ * \brief
+ *    Calculates the convolution of h and x using the FFT.
+ *
+ *   y[n] = iFFT (FFT(h) .* FFT(x))
+ *
+ * \param   y  Pointer to output vector of size sh+sx-1
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+#define conv_fft(y, h, sh, x, sx) _Generic((y),     \
+                                        float*: conv_fft_f,   \
+                                       double*: conv_fft_d,   \
+                                  complex_f_t*: conv_fft_cf,  \
+                                  complex_d_t*: conv_fft_cd,  \
+                                       default: conv_fft_d)(y, h, sh, x, sx)
+#endif   // #ifndef conv_fft
+#endif   // #if __STDC_VERSION__ >= 201112L
+
+void conv_ols_deinit (conv_ols_t *c);
+uint32_t conv_ols_init (conv_ols_t *c, double *h, uint32_t sh, uint32_t block);
+void conv_ols_reset (conv_ols_t *c);
+void conv_ols (conv_ols_t *c, double *x, double *y, uint32_t n) __O3__ ;
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,13 +31,121 @@ extern "C" {
 
 #include <dsp/dsp.h>
 #include <math/math.h>
+/*
+ * User Defines
+ */
+#ifndef FFT_PLAN_CACHE_SIZE
+#define FFT_PLAN_CACHE_SIZE      (4)   //!< Number of plans kept by the fft_xx() entry points
+#endif
+
+#if FFT_PLAN_CACHE_SIZE < 2
+#error "FFT_PLAN_CACHE_SIZE must be at least 2, the real transforms use two plans"
+#endif
+
+/*!
+ * Keep one plan cache per thread. The default is on for hosted C11 builds.
+ * Freestanding targets without TLS support get a single shared cache.
+ */
+#ifndef FFT_PLAN_CACHE_TLS
+#if __STDC_VERSION__ >= 201112L && __STDC_HOSTED__
+#define FFT_PLAN_CACHE_TLS       (1)
+#else
+#define FFT_PLAN_CACHE_TLS       (0)
+#endif
+#endif
+
 /*
  * General Defines
  */
 
+/*
+ * =================== Data types =====================
+ */
+
+/*!
+ * Plan numeric types. Integer input transforms produce single
+ * precision output, so they share the float tables.
+ */
+typedef enum {
+   FFT_PLAN_D = 0,      //!< Double precision tables
+   FFT_PLAN_F,          //!< Single precision tables
+   FFT_PLAN_I = FFT_PLAN_F
+}fft_ptype_en;
+
+/*!
+ * FFT plan. Holds the precomputed bit reversal permutation
+ * and the twiddle factors W_n^k = e^(-j2pik/n), k=[0..n/2) for
+ * a transform of size n.
+ */
+typedef struct {
+   uint32_t       n;       //!< Transform size (power of 2)
+   fft_ptype_en   type;    //!< Table type
+   uint32_t       *rev;    //!< Bit reversal permutation table [n]
+   void           *w;      //!< Twiddle table [n/2] of complex_d_t or complex_f_t
+}fft_plan_t;
+
 /*
  * ========= Public API ============
  */
+// FFT plans
+uint32_t fft_plan_create (fft_plan_t *p, uint32_t n, fft_ptype_en type);
+void fft_plan_destroy (fft_plan_t *p);
+fft_plan_t* fft_plan_get (uint32_t n, fft_ptype_en type);
+void fft_plan_flush (void);
+
+void fft_plan_execute_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X) __O3__ ;
+void fft_plan_execute_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X) __O3__ ;
+void fft_plan_execute_ci (fft_plan_t *p, complex_i_t *x, complex_f_t *X) __O3__ ;
+void ifft_plan_execute_c (fft_plan_t *p, complex_d_t *X, complex_d_t *x) __O3__ ;
+void ifft_plan_execute_cf (fft_plan_t *p, complex_f_t *X, complex_f_t *x) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+#ifndef fft_plan_execute
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void fft_plan_execute (fft_plan_t *p, T *x, T *X);
+ *
+ * \brief
+ *    Calculate the forward FFT of size p->n using the precomputed
+ *    tables of plan p. Both in-place and not in-place calls are valid.
+ *
+ * \param   p     Pointer to a plan created with a matching type
+ * \param   x     Pointer to size p->n time domain array
+ * \param   X     Pointer to size p->n frequency domain array
+ * \return        None
+ */
+#define fft_plan_execute(p, x, X)   _Generic((x),  \
+       complex_d_t*: fft_plan_execute_c,           \
+       complex_f_t*: fft_plan_execute_cf,          \
+       complex_i_t*: fft_plan_execute_ci,          \
+            default: fft_plan_execute_c)(p, x, X)
+#endif   // #ifndef fft_plan_execute
+
+#ifndef ifft_plan_execute
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> void ifft_plan_execute (fft_plan_t *p, T *X, T *x);
+ *
+ * \brief
+ *    Calculate the inverse FFT of size p->n using the precomputed
+ *    tables of plan p. Both in-place and not in-place calls are valid.
+ *
+ * \param   p     Pointer to a plan created with a matching type
+ * \param   X     Pointer to size p->n frequency domain array
+ * \param   x     Pointer to size p->n time domain array
+ * \return        None
+ */
+#define ifft_plan_execute(p, X, x)  _Generic((x),  \
+       complex_d_t*: ifft_plan_execute_c,          \
+       complex_f_t*: ifft_plan_execute_cf,         \
+            default: ifft_plan_execute_c)(p, X, x)
+#endif   // #ifndef ifft_plan_execute
+#endif   // #if __STDC_VERSION__ >= 201112L
+
 // Forward FFT
 #if __STDC_VERSION__ >= 201112L
 
@@ -39,6 +39,12 @@ extern "C" {
  * User defines
  */
 #define  FIR_WSINC_MIN_TAPS       (5)
+#ifndef FIR_WSINC_DF_TAPS
+#define  FIR_WSINC_DF_TAPS        (64)  //!< Kernels up to this size run in direct form, longer ones in frequency domain
+#endif
+#ifndef FIR_WSINC_PART_SIZE
+#define  FIR_WSINC_PART_SIZE      (64)  //!< Partition size (power of 2) of the frequency domain engine. It is also its latency
+#endif
 
 /*
  * General defines
@@ -89,6 +95,27 @@ typedef struct {
    uint32_t       N;    //!< The number of kernel points in frequncy complex domain
    window_pt      W;    //!< Pointer to window function
    wsinc_taps_pt  tp;   //!< Pointer to number of taps calculation function
+
+   /*
+    * Streaming engine data.
+    * Short kernels use a mirrored delay line, so the last T samples are always
+    * contiguous for the dot product. Long kernels use uniformly partitioned
+    * overlap-save convolution. The kernel is split in P partitions of B taps and
+    * each block of B input samples is transformed once and kept in a frequency
+    * domain delay line of P spectra.
+    */
+   double         *h;   //!< Time domain kernel [T]
+   complex_d_t    *dl;  //!< Delay line, direct form [2T]
+   double         *s;   //!< Input segment of the frequency domain engine, old and new block [2B]
+   complex_d_t    *H;   //!< Kernel partition spectra [P][2B]
+   complex_d_t    *X;   //!< Input block spectra, the frequency domain delay line [P][2B]
+   complex_d_t    *A;   //!< Spectrum accumulator [2B]
+   double         *o;   //!< Output of the last block [B]
+   uint32_t       di;   //!< Delay line index
+   uint32_t       B;    //!< Partition size, 0 for direct form
+   uint32_t       P;    //!< Number of partitions
+   uint32_t       xi;   //!< Newest spectrum in X
+   uint32_t       cnt;  //!< Samples in the current block
 }fir_wsinc_t;
 
 
@@ -111,6 +138,7 @@ void fir_wsic_set_cascade (fir_wsinc_t *f, uint32_t c);
  */
 void fir_wsinc_deinit (fir_wsinc_t* f);
 uint32_t fir_wsinc_init (fir_wsinc_t* f);
+void fir_wsinc_reset (fir_wsinc_t* f);
 
 double fir_wsinc_d (fir_wsinc_t* f, double in) __O3__ ;
 float fir_wsinc_f (fir_wsinc_t* f, float in) __O3__ ;
@@ -120,6 +148,7 @@ complex_f_t fir_wsinc_cf (fir_wsinc_t* f, complex_f_t in) __O3__ ;
 complex_f_t fir_wsinc_ci (fir_wsinc_t* f, complex_i_t in) __O3__ ;
 
 void fir_wsinc (fir_wsinc_t *f, double *in, double *out, uint32_t n);
+void fir_wsinc_block (fir_wsinc_t *f, const double *in, double *out, uint32_t n) __O3__ ;
 
 #if __STDC_VERSION__ >= 201112L
 #ifndef fir_mova
@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 #include <dsp/dsp.h>
+#include <dsp/conv.h>
 
 /*
  * ================== Public API ====================
@@ -81,6 +82,44 @@ void xcorr_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32
 #endif   // #ifndef xcorr
 #endif   // #if __STDC_VERSION__ >= 201112L
 
+
+int xcorr_fft_f (float *y, float *t, int32_t st, float *x, int32_t sx) __O3__ ;
+int xcorr_fft_d (double *y, double *t, int32_t st, double *x, int32_t sx) __O3__ ;
+int xcorr_fft_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) __O3__ ;
+int xcorr_fft_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) __O3__ ;
+
+#if __STDC_VERSION__ >= 201112L
+
+#ifndef xcorr_fft
+/*!
+ * A pseudo type-polymorphism mechanism using _Generic macro
+ * to simulate:
+ *
+ * template<typename T> int xcorr_fft (T *y, T *t, int st, T *x, int sx);
+ *
+ * \brief
+ *    Calculates the cross-correlation of t and x using the FFT.
+ *    The result is the same as xcorr().
+ *
+ * \param   y  Pointer to output vector of size st+sx-1
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+#define xcorr_fft(y, t, st, x, sx) _Generic((y),     \
+                                        float*: xcorr_fft_f,   \
+                                       double*: xcorr_fft_d,   \
+                                  complex_f_t*: xcorr_fft_cf,  \
+                                  complex_d_t*: xcorr_fft_cd,  \
+                                       default: xcorr_fft_d)(y, t, st, x, sx)
+#endif   // #ifndef xcorr_fft
+#endif   // #if __STDC_VERSION__ >= 201112L
+
 #ifdef __cplusplus
 }
 #endif
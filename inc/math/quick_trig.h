@@ -30,6 +30,8 @@ extern "C" {
 #endif
 
 #include <math/math.h>
+#include <math.h>
+#include <float.h>
 
 #define  Q15_MAX        (0x8000)
 
@@ -39,6 +41,160 @@ extern "C" {
 int32_t isin_S4 (int32_t x) __O3__;
 int32_t icos_S4 (int32_t x) __O3__;
 
+/*
+ * ============= Double precision polynomial approximations =============
+ *
+ * They are branch free and always inline, so loops over arrays that use them
+ * can be vectorized by the compiler. The arguments are reduced to a small
+ * interval and a Taylor polynomial is used. The error is below 1e-13
+ * for |x| < 1e6.
+ * Quadrant selections are made with exact 0/1 and +/-1 factors instead of
+ * conditionals, because the compiler does not speculate floating point code
+ * out of a branch.
+ */
+
+#define  _QT_ROUND_MAGIC   (6755399441055744.0)          //!< 1.5 * 2^52, x + M - M rounds to integer
+#define  _QT_PIO2_HI       (1.57079632673412561417e+00)  //!< First 33 bits of pi/2
+#define  _QT_PIO2_LO       (6.07710050650619224932e-11)  //!< pi/2 - _QT_PIO2_HI
+#define  _QT_RSQRT_MAGIC   (0x5FE6EB50C7B537A9ULL)       //!< Initial 1/sqrt(x) guess from the exponent bits
+
+/*!
+ * \brief
+ *    sin(r) and cos(r) polynomials for |r| <= pi/4
+ */
+__STATIC_INLINE __FORCE_INLINE__ double _qt_sin_poly (double r) {
+   double z = r*r;
+   return r + r*z*(-1.0/6 + z*(1.0/120 + z*(-1.0/5040 + z*(1.0/362880
+            + z*(-1.0/39916800 + z*(1.0/6227020800))))));
+}
+__STATIC_INLINE __FORCE_INLINE__ double _qt_cos_poly (double r) {
+   double z = r*r;
+   return 1.0 + z*(-1.0/2 + z*(1.0/24 + z*(-1.0/720 + z*(1.0/40320
+            + z*(-1.0/3628800 + z*(1.0/479001600 + z*(-1.0/87178291200)))))));
+}
+
+/*!
+ * \brief
+ *    Reduce x to r in [-pi/4, pi/4] and the quadrant q, x = q*pi/2 + r
+ */
+__STATIC_INLINE __FORCE_INLINE__ double _qt_reduce (double x, int32_t *q) {
+   double k = (x * M_2_PI + _QT_ROUND_MAGIC) - _QT_ROUND_MAGIC;
+   *q = (int32_t)k;
+   return (x - k*_QT_PIO2_HI) - k*_QT_PIO2_LO;
+}
+
+/*!
+ * \brief
+ *    Square root with Newton iterations on 1/sqrt(x). The libm sqrt() sets
+ *    errno and the compiler can not vectorize it.
+ * \param   x  Value >= 0
+ * \return     sqrt(x)
+ */
+__STATIC_INLINE __FORCE_INLINE__ double _qt_sqrt (double x) {
+   union { double d; uint64_t u; } v = { .d = x + DBL_MIN };
+   double h = 0.5 * v.d, y;
+
+   v.u = _QT_RSQRT_MAGIC - (v.u >> 1);
+   y  = v.d;
+   y *= 1.5 - h*y*y;
+   y *= 1.5 - h*y*y;
+   y *= 1.5 - h*y*y;
+   y *= 1.5 - h*y*y;
+   return x * y;
+}
+
+/*!
+ * \brief
+ *    Polynomial sine
+ * \param   x  Angle [rad]
+ * \return     sin(x)
+ */
+__STATIC_INLINE __FORCE_INLINE__ double qsin (double x) {
+   int32_t q;
+   double r = _qt_reduce (x, &q);
+   double m = (double)(q & 1);
+   double y = _qt_sin_poly (r)*(1.0 - m) + _qt_cos_poly (r)*m;
+   return y * (double)(1 - (q & 2));
+}
+
+/*!
+ * \brief
+ *    Polynomial cosine
+ * \param   x  Angle [rad]
+ * \return     cos(x)
+ */
+__STATIC_INLINE __FORCE_INLINE__ double qcos (double x) {
+   int32_t q;
+   double r = _qt_reduce (x, &q);
+   double m = (double)(q & 1);
+   double y = _qt_cos_poly (r)*(1.0 - m) + _qt_sin_poly (r)*m;
+   return y * (double)(1 - ((q+1) & 2));
+}
+
+/*!
+ * \brief
+ *    Polynomial tangent
+ * \param   x  Angle [rad]
+ * \return     tan(x)
+ */
+__STATIC_INLINE __FORCE_INLINE__ double qtan (double x) {
+   int32_t q;
+   double r = _qt_reduce (x, &q);
+   double s = _qt_sin_poly (r), c = _qt_cos_poly (r);
+   double n = (q & 1) ? -c : s;
+   double d = (q & 1) ? s : c;
+   return n / d;
+}
+
+/*!
+ * \brief
+ *    Polynomial arc tangent of y/x in [-pi, pi]
+ *    The ratio is reduced to [0, 1] by symmetry and then twice with the half
+ *    angle formula atan(a) = 2*atan(a / (1 + sqrt(1 + a^2))) to [0, tan(pi/16)].
+ * \param   y  The y coordinate
+ * \param   x  The x coordinate
+ * \return     atan2(y, x) [rad]
+ */
+__STATIC_INLINE __FORCE_INLINE__ double qatan2 (double y, double x) {
+   double ax = fabs (x), ay = fabs (y);
+   double sw = (double)(ay > ax);
+   double ng = (double)(x < 0);
+   double mx = (ax > ay) ? ax : ay;
+   double mn = (ax > ay) ? ay : ax;
+   double t  = mn / (mx + (double)(mx == 0));
+   double z, r;
+
+   t /= 1.0 + _qt_sqrt (1.0 + t*t);
+   t /= 1.0 + _qt_sqrt (1.0 + t*t);
+   z  = t*t;
+   r  = 4.0*(t + t*z*(-1.0/3 + z*(1.0/5 + z*(-1.0/7 + z*(1.0/9 + z*(-1.0/11
+        + z*(1.0/13 + z*(-1.0/15 + z*(1.0/17 + z*(-1.0/19 + z*(1.0/21)))))))))));
+
+   r  = sw*M_PI_2 + (1.0 - 2.0*sw)*r;
+   r  = ng*M_PI + (1.0 - 2.0*ng)*r;
+   return copysign (r, y);
+}
+
+/*!
+ * \brief
+ *    Polynomial arc sine
+ * \param   x  Value in [-1, 1]
+ * \return     asin(x) [rad]
+ */
+__STATIC_INLINE __FORCE_INLINE__ double qasin (double x) {
+   return qatan2 (x, _qt_sqrt ((1.0 - x)*(1.0 + x)));
+}
+
+/*!
+ * \brief
+ *    Polynomial arc cosine
+ * \param   x  Value in [-1, 1]
+ * \return     acos(x) [rad]
+ */
+__STATIC_INLINE __FORCE_INLINE__ double qacos (double x) {
+   return qatan2 (_qt_sqrt ((1.0 - x)*(1.0 + x)), x);
+}
+
 
 #ifdef __cplusplus
 }
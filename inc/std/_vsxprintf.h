@@ -40,6 +40,7 @@ extern "C" {
 #endif
 
 #include <std/_base_io.h>
+#include <std/dtoa.h>
 #include <toolbox_defs.h>
 
 /*!
@@ -53,13 +54,58 @@ typedef int (*_putc_out_t) (char *, const char );
 
 int _putc_usr (char *dst, const char c);  /*!< back end for user's device stdout */
 int _putc_dst (char *dst, const char c);  /*!< back end for sprintf family */
-int _putc_fil (char *dst, const char c);  /*!< back end for file printf family */
+#if defined (PRINTF_FILES)
+int _putc_fil (char *dst, const char c);  /*!< back end for file printf family, dst is the FILE pointer */
+#endif
+
+/*!
+ * Stack buffer size for the callback output sinks.
+ */
+#ifndef _IO_SINK_BUFFER_SIZE
+#define _IO_SINK_BUFFER_SIZE     (64)
+#endif
+
+/*!
+ * Output sink write callback. It gets runs of \a n characters.
+ *
+ * \param   ctx   The sink's context (file, device etc...)
+ * \param   src   Pointer to the characters
+ * \param   n     The number of characters
+ * \return        The number of written characters
+ */
+typedef int (*_io_write_t) (void *ctx, const char *src, int n);
+
+int _write_usr (void *ctx, const char *src, int n);   /*!< sink back end for user's device stdout */
+#if defined (PRINTF_FILES)
+int _write_fil (void *ctx, const char *src, int n);   /*!< sink back end for file printf family, ctx is the FILE pointer */
+#endif
+
+/*!
+ * Buffered output sink. The conversion functions fill the buffer in runs
+ * and the write callback is called when it is full or flushed.
+ * A sink without callback is a bounded string output. There the buffer is the
+ * destination string and the characters that do not fit are only counted.
+ */
+typedef struct {
+   _io_write_t write;   /*!< Flush callback, NULL for string output */
+   void        *ctx;    /*!< Callback context */
+   char        *buf;    /*!< Pointer to buffer */
+   int         size;    /*!< Buffer size */
+   int         cnt;     /*!< Characters in buffer */
+   int         total;   /*!< All the produced characters */
+}_io_sink_t;
 
 /*
  * ============================ Public Functions ============================
  */
 void _io_unused (void);
 
+void _io_sink_init (_io_sink_t *s, _io_write_t write, void *ctx, char *buf, int size);
+int  _io_sink_flush (_io_sink_t *s);
+
+int vsxprintf_sink (_io_sink_t *s, const char *frm, __VALIST ap);
+int vxprintf (_io_write_t write, void *ctx, const char *frm, __VALIST ap);
+int vsnxprintf (char *dst, size_t size, const char *frm, __VALIST ap);
 int vsxprintf(_putc_out_t _putc_out, char *dst, char *pfrm, __VALIST ap);
 
 /*!
@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 #include <std/_base_io.h>
+#include <std/dtoa.h>
 
 /*!
  * Callback read mode type.
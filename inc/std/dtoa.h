@@ -0,0 +1,65 @@
+/*!
+ * \file dtoa.h
+ * \brief
+ *    Shortest round trip double to string and correctly rounded
+ *    string to double conversions.
+ *
+ * this file is part of toolbox (std part)
+ *
+ * Copyright (C) 2014 Houtouridis Christos <houtouridis.ch@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __dtoa_h__
+#define __dtoa_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <toolbox_defs.h>
+#include <stdint.h>
+#include <math.h>
+
+/*
+ * ================ General Defines ================
+ */
+#define DTOA_MAX_DIGITS       (17)     /*!< Maximum significant digits of a double */
+#define DTOA_BUFFER_SIZE      (25)     /*!< Buffer size for dtoa(), ex: "-2.2250738585072014e-308" */
+
+/*!
+ * The exact significant digits of dtoa_round(). The next ones are zeros.
+ */
+#ifndef DTOA_EXACT_DIGITS
+#define DTOA_EXACT_DIGITS     (40)
+#endif
+
+/*
+ * ================ Exported API ================
+ */
+
+int dtoa_digits (double v, char *digits, int *dexp);
+int dtoa_round (double v, char *digits, int nd, int *dexp, int keep);
+int dtoa_fixed (double v, char *digits, int *dexp, int frac);
+int dtoa (double v, char *buf);
+
+double strtod_fast (const char *str, char **end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif   //#ifndef __dtoa_h__
@@ -144,6 +144,11 @@ int vprintf (const char *frm, __VALIST ap);
 int  printf (const char *frm, ...);
 int    puts (const char *dst);
 
+#if defined (PRINTF_FILES)
+int vfprintf (FILE *fp, const char *frm, __VALIST ap);
+int  fprintf (FILE *fp, const char *frm, ...);
+#endif
+
 /*!
  * Tailor this in order to connect printf functionality
  * to your hardware (stdout).
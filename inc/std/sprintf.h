@@ -142,6 +142,8 @@ extern "C" {
  */
 int vsprintf(char *dst, const char *frm, __VALIST ap);
 int sprintf(char *dst, const char *frm, ...);
+int vsnprintf(char *dst, size_t size, const char *frm, __VALIST ap);
+int snprintf(char *dst, size_t size, const char *frm, ...);
 
 /*!
  * Tailor this in order to connect printf functionality
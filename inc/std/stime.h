@@ -57,8 +57,12 @@ extern "C" {
 /* =================== Exported Functions ===================== */
 
 int isleap(int year);
-time_t smktime (struct tm *_timeptr);
+time_t smktime (const struct tm *_timeptr);
 struct tm *sgmtime (const time_t *_timer);
+struct tm *sgmtime_r (const time_t *_timer, struct tm *_tm);
+
+void sgmtime_n (const time_t *_timer, struct tm *_tm, uint32_t n);
+void smktime_n (const struct tm *_tm, time_t *_timer, uint32_t n);
 
 #ifdef __cplusplus
 }
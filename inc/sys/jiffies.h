@@ -36,6 +36,8 @@
 typedef uint16_t     jiffy_t;       //!< Jiffy type 2 byte unsigned integer
 typedef int32_t      jtime_t;        //!< Jiffy time type for delay functionalities usec/msec
 typedef int          (*jf_setfreq_pt) (uint32_t, uint32_t);   //!< Pointer to setfreq function \sa setfreq
+typedef jiffy_t      (*jf_read_pt) (void);                    //!< Pointer to timer read function
+typedef uint64_t     jf_deadline_t;                           //!< Deadline in extended jiffies \sa jf_now()
 
 /*!
  * Jiffy inner structure,
@@ -55,11 +57,14 @@ typedef volatile struct {
     *   refers to timer's auto reload value.
     */
    jiffy_t        *value;        /*!< Pointer to timers current value */
+   jf_read_pt     read;          /*!< Pointer to timer read function, used instead of value if linked */
    uint32_t       freq;          /*!< timer's  frequency */
    jiffy_t        jiffies;       /*!< jiffies max value (timer's max value) */
    jiffy_t        jp1ms;         /*!< Jiffies per 1 msec to use in delay function */
    jiffy_t        jp1us;         /*!< Jiffies per 1 usec to use in delay function */
    jiffy_t        jp100ns;       /*!< Jiffies per 100 nsec to use in delay function */
+   uint64_t       ext;           /*!< Extended 64bit jiffy count at the last read */
+   jiffy_t        last;          /*!< Timer value at the last extended read */
    drv_status_en  status;
 }jf_t;
 
@@ -73,6 +78,7 @@ typedef volatile struct {
  */
 void jf_link_setfreq (jf_setfreq_pt pfun);
 void jf_link_value (jiffy_t* v);
+void jf_link_read (jf_read_pt pfun);
 
 /*
  * Set functions
@@ -98,6 +104,14 @@ int jf_check_msec (jtime_t msec);
 int jf_check_usec (jtime_t usec);
 int jf_check_100nsec (jtime_t _100nsec);
 
+uint64_t jf_now (void);
+uint64_t jf_to_usec (uint64_t jf);
+uint64_t jf_from_usec (uint64_t usec);
+jf_deadline_t jf_deadline_ms (jtime_t msec);
+jf_deadline_t jf_deadline_us (jtime_t usec);
+jf_deadline_t jf_deadline_100ns (jtime_t _100nsec);
+int jf_expired (jf_deadline_t dl);
+
 /*!
  * \note
  * The Jiffy lib has no jiffy_t target pointer in the API. This means
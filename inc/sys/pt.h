@@ -0,0 +1,138 @@
+/*
+ * \file pt.h
+ * \brief
+ *    Stackless coroutines (protothreads) for the drivers' non blocking API
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __pt_h__
+#define __pt_h__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include <stdint.h>
+#include <tbx_types.h>
+
+/*!
+ * \note
+ *    A protothread is a function that returns PT_PENDING (DRV_BUSY)
+ *    where it would block, and continues from the same line when it is
+ *    called again. It keeps only the line number, in a pt_t, so:
+ *    - The local variables are lost on each wait. Keep the state in the
+ *      operation struct of the caller.
+ *    - No switch statements between PT_BEGIN() and PT_END().
+ *    The other return values (DRV_READY, DRV_ERROR) end the protothread
+ *    and the next call starts over.
+ *
+ *    ex:
+ *       drv_status_en op (dev_t *d, op_t *op) {
+ *          PT_BEGIN (&op->pt);
+ *          _start (d);
+ *          PT_WAIT_UNTIL (&op->pt, _ready (d));
+ *          PT_END (&op->pt);
+ *       }
+ *       while (op (d, &o) == PT_PENDING)
+ *          do_something_else ();
+ */
+
+/*!
+ * Protothread local continuation
+ */
+typedef struct {
+   uint16_t    lc;         /*!< The line to continue from, 0 to start */
+}pt_t;
+
+#define PT_PENDING               (DRV_BUSY)
+
+/*!
+ * The resume labels follow code, mark them as intended fall through
+ * for -Wimplicit-fallthrough.
+ */
+#if defined(__has_attribute)
+#if __has_attribute(fallthrough)
+#define PT_FALLTHROUGH           __attribute__ ((fallthrough))
+#endif
+#endif
+#ifndef PT_FALLTHROUGH
+#define PT_FALLTHROUGH           do { } while (0)
+#endif
+
+#define PT_INIT(_pt)             do { (_pt)->lc = 0; } while (0)
+#define PT_BEGIN(_pt)            switch ((_pt)->lc) { case 0:
+#define PT_END(_pt)              } (_pt)->lc = 0; return DRV_READY
+
+/*!
+ * End the protothread with a status
+ */
+#define PT_EXIT(_pt, _st)        do { (_pt)->lc = 0; return (_st); } while (0)
+
+/*!
+ * Give the CPU to the others once
+ */
+#define PT_YIELD(_pt)                                 \
+   do {                                               \
+      (_pt)->lc = __LINE__; return PT_PENDING;        \
+      PT_FALLTHROUGH;                                 \
+      case __LINE__: ;                                \
+   } while (0)
+
+/*!
+ * Wait until/while a condition, the condition is evaluated on each call
+ */
+#define PT_WAIT_UNTIL(_pt, _cond)                     \
+   do {                                               \
+      (_pt)->lc = __LINE__;                           \
+      PT_FALLTHROUGH;                                 \
+      case __LINE__:                                  \
+      if (!(_cond)) return PT_PENDING;                \
+   } while (0)
+
+#define PT_WAIT_WHILE(_pt, _cond)   PT_WAIT_UNTIL (_pt, !(_cond))
+
+/*!
+ * Run a child protothread to its end and get its status.
+ * The child's pt_t has to be zero on the first call.
+ */
+#define PT_CALL(_pt, _st, _call)                      \
+   do {                                               \
+      (_pt)->lc = __LINE__;                           \
+      PT_FALLTHROUGH;                                 \
+      case __LINE__:                                  \
+      if (((_st) = (_call)) == PT_PENDING)            \
+         return PT_PENDING;                           \
+   } while (0)
+
+/*!
+ * Non blocking semaphore and mutex, \see sem_check() and mut_trylock()
+ */
+#define PT_SEM_WAIT(_pt, _s)     PT_WAIT_UNTIL (_pt, sem_check (_s))
+#define PT_MUT_LOCK(_pt, _m)     PT_WAIT_UNTIL (_pt, mut_trylock (_m))
+
+/*!
+ * Non blocking delay on a jiffy deadline, \see jf_deadline_us()
+ */
+#define PT_WAIT_DEADLINE(_pt, _dl)  PT_WAIT_UNTIL (_pt, jf_expired (_dl))
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif   //#ifndef __pt_h__
@@ -0,0 +1,69 @@
+/*
+ * \file sched.h
+ * \brief
+ *    A cooperative round robin scheduler for protothread tasks
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __sched_h__
+#define __sched_h__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include <stdint.h>
+#include <tbx_types.h>
+#include <sys/pt.h>
+
+typedef drv_status_en (*sched_task_ft) (void *);   //!< Task function, a protothread
+
+/*!
+ * Task object, owned by the user. The task function is called on each
+ * round while it returns PT_PENDING. Any other status ends the task.
+ */
+typedef struct sched_task {
+   struct sched_task *next;
+   sched_task_ft     fun;        /*!< The task function */
+   void*             arg;        /*!< The task argument */
+   drv_status_en     status;     /*!< The last task status, PT_PENDING while it runs */
+}sched_task_t;
+
+/*!
+ * Scheduler data struct
+ */
+typedef struct {
+   sched_task_t      *head;      /*!< The running tasks */
+   uint32_t          tasks;      /*!< The number of running tasks */
+   uint64_t          runs;       /*!< Task calls */
+}sched_t;
+
+/*
+ *  ============= PUBLIC Scheduler API =============
+ */
+void sched_init (sched_t *s);
+void sched_add (sched_t *s, sched_task_t *t, sched_task_ft fun, void *arg);
+uint32_t sched_run_once (sched_t *s);
+void sched_run (sched_t *s);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif   //#ifndef __sched_h__
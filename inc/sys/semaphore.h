@@ -30,12 +30,22 @@
 
 #include <toolbox_defs.h>
 #include <stdlib.h>
+#include <stdatomic.h>
+
+/*
+ * User defines
+ */
+#ifndef SEM_SPIN
+#define SEM_SPIN        (100)    //!< Spins before a waiter sleeps on the futex, Linux hosts only
+#endif
 
 /*!
- * Semaphore data type
+ * Semaphore data type.
+ * For a mutex val is 0 unlocked, 1 locked and 2 locked with waiters.
  */
 typedef struct {
-   int val;          /*!< Semaphore value. */
+   _Atomic int val;        /*!< Semaphore value. */
+   _Atomic int waiters;    /*!< Waiters sleeping on the futex */
 }sem_t;
 
 /*
@@ -0,0 +1,106 @@
+/*
+ * \file twheel.h
+ * \brief
+ *    A hierarchical timer wheel for one-shot and periodic callbacks
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __twheel_h__
+#define __twheel_h__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <tbx_types.h>
+#include <toolbox_defs.h>
+
+/*
+ * User defines
+ */
+#ifndef TW_LEVELS
+#define TW_LEVELS       (4)      //!< Wheel levels, the wheel spans 64^TW_LEVELS ticks
+#endif
+
+/*
+ * General defines
+ */
+#define TW_SLOT_BITS    (6)
+#define TW_SLOTS        (1 << TW_SLOT_BITS)     //!< Slots per level, one bit of a 64bit mask each
+#define TW_SLOT_MASK    (TW_SLOTS - 1)
+
+typedef void (*tw_cb_ft) (void *);     //!< Timer callback
+
+/*!
+ * List node, the timers are linked in the slots of the wheel
+ */
+typedef struct tw_node {
+   struct tw_node    *next;
+   struct tw_node    *prev;
+}tw_node_t;
+
+/*!
+ * Timer object. It is owned by the user and linked in the wheel, so
+ * there is no allocation. Zero it before the first tw_add().
+ */
+typedef struct {
+   tw_node_t      node;       /*!< Slot list node, must be first */
+   uint64_t       expires;    /*!< Absolute expire tick */
+   uint32_t       period;     /*!< Period in ticks, 0 for one-shot */
+   uint16_t       slot;       /*!< The slot index of the wheel, level*TW_SLOTS + slot */
+   uint8_t        active;     /*!< Linked in the wheel */
+   tw_cb_ft       cb;         /*!< The callback */
+   void*          arg;        /*!< The callback argument */
+}tw_timer_t;
+
+/*!
+ * Timer wheel.
+ * Level 0 holds the timers of the next 64 ticks one slot per tick. Each
+ * next level has 64 times coarser slots and its timers cascade to the
+ * lower levels when the lower level wraps. Each level keeps a mask
+ * of its non empty slots, so empty ticks are skipped 64 at a time.
+ */
+typedef struct {
+   uint64_t       tick;       /*!< The next tick to process */
+   uint64_t       occ[TW_LEVELS];                /*!< Non empty slots of each level */
+   tw_node_t      slot[TW_LEVELS * TW_SLOTS];    /*!< Slot list heads */
+   uint32_t       timers;     /*!< Number of active timers */
+}tw_t;
+
+/*
+ *  ============= PUBLIC Timer wheel API =============
+ */
+void tw_init (tw_t *w, uint64_t now);
+uint64_t tw_now (tw_t *w);
+
+void tw_add (tw_t *w, tw_timer_t *t, uint32_t delay, uint32_t period, tw_cb_ft cb, void *arg);
+void tw_add_at (tw_t *w, tw_timer_t *t, uint64_t expires, uint32_t period, tw_cb_ft cb, void *arg);
+int  tw_del (tw_t *w, tw_timer_t *t);
+int  tw_pending (tw_timer_t *t);
+
+uint32_t tw_advance (tw_t *w, uint64_t now);
+uint64_t tw_next (tw_t *w);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif   //#ifndef __twheel_h__
@@ -51,6 +51,7 @@ extern "C" {
  */
 #include <algo/crc.h>
 #include <algo/queue.h>
+#include <algo/ring.h>
 #include <algo/spa.h>
 #include <algo/spa_grena.h>
 #include <algo/psa.h>
@@ -59,6 +60,7 @@ extern "C" {
  */
 #include <com/i2c_bb.h>
 #include <com/spi_bb.h>
+#include <com/onewire.h>
 #include <com/onewire_bb.h>
 #include <com/onewire_uart.h>
 #include <com/nmea.h>
@@ -79,7 +81,9 @@ extern "C" {
  */
 #include <drv/alcd.h>
 #include <drv/buttons.h>
+#include <drv/inputs.h>
 #include <drv/ee_i2c.h>
+#include <drv/sim_i2c_ee.h>
 
 #include <drv/pt100x.h>
 #include <drv/ktyx.h>
@@ -94,9 +98,14 @@ extern "C" {
 
 #include <drv/sim_ee.h>
 #include <drv/sd_spi.h>
+#include <drv/sim_sd.h>
 #include <drv/ss_display.h>
 #include <drv/s25fs_spi.h>
+#include <drv/sim_nor.h>
+#include <drv/flog.h>
 #include <drv/ds2431.h>
+#include <drv/sim_ow.h>
+#include <drv/sim_tim.h>
 
 #include <drv/tca953x.h>
 #include <drv/mcp4728.h>
@@ -136,7 +145,10 @@ extern "C" {
 //#include <sys/ffconf.h>
 //#include <sys/integer.h>
 #include <sys/jiffies.h>
+#include <sys/twheel.h>
 #include <sys/semaphore.h>
+#include <sys/pt.h>
+#include <sys/sched.h>
 
 /*!
  * \defgroup UserInterface
@@ -68,6 +68,29 @@ extern "C" {
 #define __Os__
 #endif
 
+/*!
+ * Inline even in functions with other optimisation or target attributes.
+ * Small math kernels need this to get vectorized inside the __SIMD__ loops.
+ */
+#ifdef __GNUC__
+#define __FORCE_INLINE__   __attribute__ ((always_inline))
+#else
+#define __FORCE_INLINE__
+#endif
+
+/*!
+ * SIMD kernels.
+ * On GNU/Linux x86 hosts the function is cloned for AVX2 and for the baseline
+ * (SSE2) instruction set and the loader selects the clone from the CPU features.
+ * On other targets the vector code follows the compiler flags (ex: -mfpu=neon).
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__linux__) && \
+   (defined(__x86_64__) || defined(__i386__)) && !defined(TBX_NO_SIMD_CLONES)
+#define __SIMD__  __attribute__ ((target_clones("avx2","default")))
+#else
+#define __SIMD__
+#endif
+
 
 
 
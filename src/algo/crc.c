@@ -22,6 +22,261 @@
  *
  */
 #include <algo/crc.h>
+#include <string.h>
+
+/*
+ * ============ Table driven engine ============
+ */
+
+/*!
+ * Linked table entry. Each entry points to CRC_SLICING tables of 256 points
+ * in user's storage. Table k advances the CRC of each byte value by k extra
+ * zero bytes.
+ */
+typedef struct {
+   uint64_t          poly;    //!< The polynomial of the table
+   CRC_BitOrder_en   bo;      //!< The bit order of the table
+   const void        *t;      //!< Pointer to the tables, NULL if empty
+}_crc_link_t;
+
+static _crc_link_t _crc8_links[CRC_TABLE_SLOTS];
+static _crc_link_t _crc16_links[CRC_TABLE_SLOTS];
+static _crc_link_t _crc32_links[CRC_TABLE_SLOTS];
+static _crc_link_t _crc64_links[CRC_TABLE_SLOTS];
+
+/*!
+ * \brief
+ *    The main body of the table linking. It generates the tables of
+ *    (poly, bo) with the bitwise _byte function in the user's storage and
+ *    puts them in the slot of (poly, bo), or in an empty one.
+ *
+ * \param   _t       The CRC type
+ * \param   _W       The CRC width in bits
+ * \param   _byte    The bitwise byte function
+ * \param   _links   The linked tables of the width
+ */
+#define _crc_link_body(_t, _W, _byte, _links) {                            \
+   uint32_t i, k, e;                                                       \
+                                                                           \
+   if (tb == NULL)                                                         \
+      return DRV_ERROR;                                                    \
+   for (e=0 ; e<CRC_TABLE_SLOTS ; ++e)                                     \
+      if (_links[e].t && _links[e].poly == poly && _links[e].bo == bo)    \
+         break;                                                            \
+   if (e == CRC_TABLE_SLOTS)                                               \
+      for (e=0 ; e<CRC_TABLE_SLOTS && _links[e].t ; ++e)                  \
+         ;                                                                 \
+   if (e == CRC_TABLE_SLOTS)                                               \
+      return DRV_ERROR;                                                    \
+                                                                           \
+   for (i=0 ; i<256 ; ++i)                                                 \
+      (*tb)[0][i] = _byte (poly, bo, (bo == CRC_LSB) ? (_t)i : (_t)((_t)i << ((_W)-8)), 0); \
+   for (k=1 ; k<CRC_SLICING ; ++k)                                         \
+      for (i=0 ; i<256 ; ++i)                                              \
+         (*tb)[k][i] = _byte (poly, bo, (*tb)[k-1][i], 0);                 \
+   _links[e].poly = poly;                                                  \
+   _links[e].bo = bo;                                                      \
+   _links[e].t = (const void*)tb;                                          \
+   return DRV_READY;                                                       \
+}
+
+/*!
+ * \brief
+ *    The main body of table lookup. It only reads the linked tables, so
+ *    the buffer functions can run from many threads at once.
+ *
+ * \param   _t       The CRC type
+ * \param   _links   The linked tables of the width
+ */
+#define _crc_find_body(_t, _links) {                                       \
+   uint32_t e;                                                             \
+   for (e=0 ; e<CRC_TABLE_SLOTS ; ++e)                                     \
+      if (_links[e].t && _links[e].poly == poly && _links[e].bo == bo)    \
+         return (const _t (*)[256])_links[e].t;                           \
+   return NULL;                                                            \
+}
+
+/*!
+ * Shift the CRC by 8*_n bits. Shifts equal or greater than the
+ * width result to 0.
+ */
+#define _crc_shr(_t, _c, _n)   ((_t)(((uint64_t)(_c) >> (4*(_n))) >> (4*(_n))))
+#define _crc_shl(_t, _c, _n)   ((_t)(((uint64_t)(_c) << (4*(_n))) << (4*(_n))))
+
+/*!
+ * \brief
+ *    The main body of the slicing-by-N CRC calculation. Each step takes
+ *    N = CRC_SLICING bytes. The CRC bytes are folded into the first data
+ *    bytes and the new CRC is the XOR of one lookup per byte, plus the
+ *    part of the old CRC that is not shifted out. The tail is calculated
+ *    one byte at a time.
+ *
+ * \param   _t    The CRC type
+ * \param   _W    The CRC width in bits
+ */
+#define _crc_slice_body(_t, _W) {                                          \
+   bytecount_t i;                                                          \
+   uint32_t k;                                                             \
+   byte_t d;                                                               \
+   _t acc;                                                                 \
+                                                                           \
+   i = 0;                                                                  \
+   if (bo == CRC_LSB) {                                                    \
+      for ( ; i+CRC_SLICING <= size ; i+=CRC_SLICING) {                    \
+         acc = _crc_shr (_t, crc, CRC_SLICING);                            \
+         for (k=0 ; k<CRC_SLICING ; ++k) {                                 \
+            d = data[i+k];                                                 \
+            if (8*k < (_W))                                                \
+               d ^= (byte_t)(crc >> (8*k));                                \
+            acc ^= tb[CRC_SLICING-1-k][d];                                 \
+         }                                                                 \
+         crc = acc;                                                        \
+      }                                                                    \
+      for ( ; i<size ; ++i)                                                \
+         crc = _crc_shr (_t, crc, 1) ^ tb[0][(byte_t)crc ^ data[i]];       \
+   }                                                                       \
+   else {                                                                  \
+      for ( ; i+CRC_SLICING <= size ; i+=CRC_SLICING) {                    \
+         acc = _crc_shl (_t, crc, CRC_SLICING);                            \
+         for (k=0 ; k<CRC_SLICING ; ++k) {                                 \
+            d = data[i+k];                                                 \
+            if (8*k < (_W))                                                \
+               d ^= (byte_t)(crc >> ((_W)-8-8*k));                         \
+            acc ^= tb[CRC_SLICING-1-k][d];                                 \
+         }                                                                 \
+         crc = acc;                                                        \
+      }                                                                    \
+      for ( ; i<size ; ++i)                                                \
+         crc = _crc_shl (_t, crc, 1) ^ tb[0][(byte_t)(crc >> ((_W)-8)) ^ data[i]]; \
+   }                                                                       \
+   return crc;                                                             \
+}
+
+static const uint8_t (*_crc8_table (uint8_t poly, CRC_BitOrder_en bo))[256] {
+   _crc_find_body (uint8_t, _crc8_links);
+}
+static const uint16_t (*_crc16_table (uint16_t poly, CRC_BitOrder_en bo))[256] {
+   _crc_find_body (uint16_t, _crc16_links);
+}
+static const uint32_t (*_crc32_table (uint32_t poly, CRC_BitOrder_en bo))[256] {
+   _crc_find_body (uint32_t, _crc32_links);
+}
+static const uint64_t (*_crc64_table (uint64_t poly, CRC_BitOrder_en bo))[256] {
+   _crc_find_body (uint64_t, _crc64_links);
+}
+
+static uint8_t _crc8_slice (const uint8_t (*tb)[256], CRC_BitOrder_en bo, uint8_t crc, const byte_t *data, bytecount_t size) __O3__ ;
+static uint16_t _crc16_slice (const uint16_t (*tb)[256], CRC_BitOrder_en bo, uint16_t crc, const byte_t *data, bytecount_t size) __O3__ ;
+static uint32_t _crc32_slice (const uint32_t (*tb)[256], CRC_BitOrder_en bo, uint32_t crc, const byte_t *data, bytecount_t size) __O3__ ;
+static uint64_t _crc64_slice (const uint64_t (*tb)[256], CRC_BitOrder_en bo, uint64_t crc, const byte_t *data, bytecount_t size) __O3__ ;
+
+static uint8_t _crc8_slice (const uint8_t (*tb)[256], CRC_BitOrder_en bo, uint8_t crc, const byte_t *data, bytecount_t size) {
+   _crc_slice_body (uint8_t, 8);
+}
+static uint16_t _crc16_slice (const uint16_t (*tb)[256], CRC_BitOrder_en bo, uint16_t crc, const byte_t *data, bytecount_t size) {
+   _crc_slice_body (uint16_t, 16);
+}
+static uint32_t _crc32_slice (const uint32_t (*tb)[256], CRC_BitOrder_en bo, uint32_t crc, const byte_t *data, bytecount_t size) {
+   _crc_slice_body (uint32_t, 32);
+}
+static uint64_t _crc64_slice (const uint64_t (*tb)[256], CRC_BitOrder_en bo, uint64_t crc, const byte_t *data, bytecount_t size) {
+   _crc_slice_body (uint64_t, 64);
+}
+
+/*
+ * ============ Hardware CRC32C ============
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define _CRC32C_HW
+/*!
+ * \brief
+ *    CRC32 Castagnoli (reverse bit order) using the SSE4.2 crc32 instruction
+ */
+__attribute__ ((target ("sse4.2")))
+static uint32_t _crc32c_hw (uint32_t crc, const byte_t *data, bytecount_t size) {
+   uint64_t c = crc, w;
+   bytecount_t i;
+
+   for (i=0 ; i+8 <= size ; i+=8) {
+      memcpy ((void*)&w, (const void*)&data[i], 8);
+      c = __builtin_ia32_crc32di (c, w);
+   }
+   for ( ; i<size ; ++i)
+      c = __builtin_ia32_crc32qi ((uint32_t)c, data[i]);
+   return (uint32_t)c;
+}
+static int _crc32c_hw_avail (void) {
+   return __builtin_cpu_supports ("sse4.2");
+}
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define _CRC32C_HW
+/*!
+ * \brief
+ *    CRC32 Castagnoli (reverse bit order) using the ARMv8 crc32c instructions
+ */
+static uint32_t _crc32c_hw (uint32_t crc, const byte_t *data, bytecount_t size) {
+   uint32_t w;
+   bytecount_t i;
+
+   for (i=0 ; i+4 <= size ; i+=4) {
+      memcpy ((void*)&w, (const void*)&data[i], 4);
+      crc = __crc32cw (crc, w);
+   }
+   for ( ; i<size ; ++i)
+      crc = __crc32cb (crc, data[i]);
+   return crc;
+}
+#define _crc32c_hw_avail()    (1)
+#endif
+
+/*
+ * ============ Public API ============
+ */
+
+/*!
+ * \brief
+ *    Generate the tables of a polynomial in the user's storage and use
+ *    them for the buffer calculations of (poly, bo). Without linked tables
+ *    the buffer functions calculate bitwise.
+ * \note
+ *    The buffer functions only read the linked tables. Link the tables at
+ *    initialisation, before the buffer functions run from more than one
+ *    thread.
+ *
+ * \param   tb    Pointer to the table storage, static or for the lifetime of the link
+ * \param   poly  The polynomial
+ * \param   bo    The CRC bit order
+ * \return  The status of the operation
+ *    \arg     DRV_READY   The tables are linked
+ *    \arg     DRV_ERROR   No free slot, see CRC_TABLE_SLOTS
+ */
+drv_status_en CRC8_link_table (crc8_table_t *tb, uint8_t poly, CRC_BitOrder_en bo) {
+   _crc_link_body (uint8_t, 8, CRC8_byte, _crc8_links);
+}
+drv_status_en CRC16_link_table (crc16_table_t *tb, uint16_t poly, CRC_BitOrder_en bo) {
+   _crc_link_body (uint16_t, 16, CRC16_byte, _crc16_links);
+}
+drv_status_en CRC32_link_table (crc32_table_t *tb, uint32_t poly, CRC_BitOrder_en bo) {
+   _crc_link_body (uint32_t, 32, CRC32_byte, _crc32_links);
+}
+drv_status_en CRC64_link_table (crc64_table_t *tb, uint64_t poly, CRC_BitOrder_en bo) {
+   _crc_link_body (uint64_t, 64, CRC64_byte, _crc64_links);
+}
+
+/*!
+ * \brief
+ *    Unlink all the tables. The buffer functions calculate bitwise
+ *    until new tables are linked.
+ * \return  None
+ */
+void CRC_unlink_tables (void)
+{
+   memset ((void*)_crc8_links, 0, sizeof (_crc8_links));
+   memset ((void*)_crc16_links, 0, sizeof (_crc16_links));
+   memset ((void*)_crc32_links, 0, sizeof (_crc32_links));
+   memset ((void*)_crc64_links, 0, sizeof (_crc64_links));
+}
 
 /*!
  * \brief
@@ -114,11 +369,14 @@ uint8_t CRC8_byte (uint8_t poly, CRC_BitOrder_en bo, uint8_t crc, byte_t b)
  */
 uint8_t CRC8_buffer (uint8_t poly, CRC_BitOrder_en bo, uint8_t crc, const byte_t *data, bytecount_t size)
 {
-   uint16_t i;
+   const uint8_t (*tb)[256];
+   bytecount_t i;
 
    // Data check
    if(data == 0)  return crc;
 
+   if (size >= CRC_TABLE_THRESHOLD && (tb = _crc8_table (poly, bo)) != NULL)
+      return _crc8_slice (tb, bo, crc, data, size);
    for (i=0 ; i<size ; ++i)
       crc = CRC8_byte (poly, bo, crc, data [i]);
    return crc;
@@ -225,14 +483,161 @@ uint16_t CRC16_byte (uint16_t poly, CRC_BitOrder_en bo, uint16_t crc, byte_t b)
  */
 uint16_t CRC16_buffer (uint16_t poly, CRC_BitOrder_en bo, uint16_t crc, const byte_t *data, bytecount_t size)
 {
-   uint16_t i;
+   const uint16_t (*tb)[256];
+   bytecount_t i;
 
    // Data check
    if(data == 0)  return crc;
 
+   if (size >= CRC_TABLE_THRESHOLD && (tb = _crc16_table (poly, bo)) != NULL)
+      return _crc16_slice (tb, bo, crc, data, size);
    for (i=0 ; i<size ; ++i)
       crc = CRC16_byte (poly, bo, crc, data [i]);
    return crc;
 }
 
+/*!
+ * \brief
+ *    Append CRC32 to an existing CRC value
+ * \param   poly  The 32bit wide polynomial to use
+ *    \arg  CRC32_IEEE            (0x04C11DB7)  Ethernet, zip, PNG, SATA, MPEG-2
+ *    \arg  CRC32_IEEE_rev        (0xEDB88320)  Ethernet, zip, PNG, SATA, MPEG-2, for reverse bit order
+ *    \arg  CRC32_Castagnoli      (0x1EDC6F41)  iSCSI, SCTP, ext4, Btrfs
+ *    \arg  CRC32_Castagnoli_rev  (0x82F63B78)  iSCSI, SCTP, ext4, Btrfs, for reverse bit order
+ *    \arg  CRC32_Koopman         (0x741B8CD7)  Excellent at Ethernet frame length
+ *    \arg  CRC32_Koopman_rev     (0xEB31D82E)  Excellent at Ethernet frame length, for reverse bit order
+ *    \arg  CRC32_Q               (0x814141AB)  aviation; AIXM
+ *    \arg  CRC32_Q_rev           (0xD5828281)  aviation; AIXM, for reverse bit order
+ *    \arg  Any other 32bit wide polynomial
+ * \param   bo    The CRC bit order of the operation
+ *    \arg  CRC_MSB     The "usual" bit order of the operation
+ *    \arg  CRC_LSB     The invert LSB->MSB order of the operation
+ * \param   crc   The current CRC value in witch to append the calculated the new CRC
+ * \param   b     The byte to check
+ * \return  The new CRC value
+ */
+uint32_t CRC32_byte (uint32_t poly, CRC_BitOrder_en bo, uint32_t crc, byte_t b)
+{
+   uint8_t i;
+
+   switch (bo) {
+      default:
+      case CRC_MSB:
+         crc ^= (uint32_t)b << 24;
+         for (i=0; i<8; ++i)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ poly : crc << 1;
+         break;
+      case CRC_LSB:
+         crc ^= b;
+         for (i=0; i<8; ++i)
+            crc = (crc & 0x00000001) ? (crc >> 1) ^ poly : crc >> 1;
+         break;
+   }
+   return crc;
+}
+
+/*!
+ * \brief
+ *    Calculate the CRC32 code of a buffer
+ *
+ *    The calculation does not apply any initial or final XOR value. For ex:
+ *    the IEEE 802.3 (zip) CRC is:
+ *       ~CRC32_buffer (CRC32_IEEE_rev, CRC_LSB, 0xFFFFFFFF, data, size)
+ *    The Castagnoli reverse bit order CRC uses the SSE4.2 or ARMv8 crc32c
+ *    instructions when available.
+ *
+ * \param   poly  The polynomial to use, see CRC32_byte()
+ * \param   bo    The CRC bit order of the operation
+ *    \arg  CRC_MSB     The "usual" bit order of the operation
+ *    \arg  CRC_LSB     The invert LSB->MSB order of the operation
+ * \param   crc      The current CRC value in witch to append the calculated the new CRC
+ * \param   data     Pointer to data buffer
+ * \param   size     The size of the data buffer
+ * \return  The CRC32 value
+ */
+uint32_t CRC32_buffer (uint32_t poly, CRC_BitOrder_en bo, uint32_t crc, const byte_t *data, bytecount_t size)
+{
+   const uint32_t (*tb)[256];
+   bytecount_t i;
+
+   // Data check
+   if(data == 0)  return crc;
+
+#if defined(_CRC32C_HW)
+   if (poly == CRC32_Castagnoli_rev && bo == CRC_LSB && _crc32c_hw_avail ())
+      return _crc32c_hw (crc, data, size);
+#endif
+   if (size >= CRC_TABLE_THRESHOLD && (tb = _crc32_table (poly, bo)) != NULL)
+      return _crc32_slice (tb, bo, crc, data, size);
+   for (i=0 ; i<size ; ++i)
+      crc = CRC32_byte (poly, bo, crc, data [i]);
+   return crc;
+}
+
+/*!
+ * \brief
+ *    Append CRC64 to an existing CRC value
+ * \param   poly  The 64bit wide polynomial to use
+ *    \arg  CRC64_ECMA            (0x42F0E1EBA9EA3693)  ECMA-182, xz
+ *    \arg  CRC64_ECMA_rev        (0xC96C5795D7870F42)  ECMA-182, xz, for reverse bit order
+ *    \arg  CRC64_ISO             (0x000000000000001B)  ISO 3309, HDLC
+ *    \arg  CRC64_ISO_rev         (0xD800000000000000)  ISO 3309, HDLC, for reverse bit order
+ *    \arg  Any other 64bit wide polynomial
+ * \param   bo    The CRC bit order of the operation
+ *    \arg  CRC_MSB     The "usual" bit order of the operation
+ *    \arg  CRC_LSB     The invert LSB->MSB order of the operation
+ * \param   crc   The current CRC value in witch to append the calculated the new CRC
+ * \param   b     The byte to check
+ * \return  The new CRC value
+ */
+uint64_t CRC64_byte (uint64_t poly, CRC_BitOrder_en bo, uint64_t crc, byte_t b)
+{
+   uint8_t i;
+
+   switch (bo) {
+      default:
+      case CRC_MSB:
+         crc ^= (uint64_t)b << 56;
+         for (i=0; i<8; ++i)
+            crc = (crc & 0x8000000000000000ULL) ? (crc << 1) ^ poly : crc << 1;
+         break;
+      case CRC_LSB:
+         crc ^= b;
+         for (i=0; i<8; ++i)
+            crc = (crc & 0x0000000000000001ULL) ? (crc >> 1) ^ poly : crc >> 1;
+         break;
+   }
+   return crc;
+}
+
+/*!
+ * \brief
+ *    Calculate the CRC64 code of a buffer
+ *
+ *    The calculation does not apply any initial or final XOR value. For ex:
+ *    the CRC-64/XZ is:
+ *       ~CRC64_buffer (CRC64_ECMA_rev, CRC_LSB, ~0ULL, data, size)
+ *
+ * \param   poly  The polynomial to use, see CRC64_byte()
+ * \param   bo    The CRC bit order of the operation
+ *    \arg  CRC_MSB     The "usual" bit order of the operation
+ *    \arg  CRC_LSB     The invert LSB->MSB order of the operation
+ * \param   crc      The current CRC value in witch to append the calculated the new CRC
+ * \param   data     Pointer to data buffer
+ * \param   size     The size of the data buffer
+ * \return  The CRC64 value
+ */
+uint64_t CRC64_buffer (uint64_t poly, CRC_BitOrder_en bo, uint64_t crc, const byte_t *data, bytecount_t size)
+{
+   const uint64_t (*tb)[256];
+   bytecount_t i;
 
+   // Data check
+   if(data == 0)  return crc;
+
+   if (size >= CRC_TABLE_THRESHOLD && (tb = _crc64_table (poly, bo)) != NULL)
+      return _crc64_slice (tb, bo, crc, data, size);
+   for (i=0 ; i<size ; ++i)
+      crc = CRC64_byte (poly, bo, crc, data [i]);
+   return crc;
+}
@@ -243,4 +243,76 @@ psa_output_t psa_calculate (psa_t *psa)
    return out;
 }
 
+/*!
+ * \brief
+ *    PSA Julian day of a UNIX time, for \see psa_calculate_n().
+ *    The day is linear to time, so a series can also be filled as
+ *    jd[i] = jd[0] + i*step/86400.0
+ *
+ * \param   utc   the time to use in UNIX time format
+ * \return        Julian day from noon 1 January 2000 Universal Time
+ */
+double psa_jd (time_t utc) {
+   return (double)utc / 86400.0 - 10957.5;
+}
+
+/*!
+ * \brief
+ *    Calculate Sun position for many time stamps on one location.
+ *    The algorithm is the same as \see psa_calculate(), but the data are
+ *    structure of arrays and the trigonometric functions are the inline
+ *    polynomials of quick_trig, so the loop is vectorized.
+ * \note
+ *    The decimal hour enters only the hour angle, so 15*dec_hour is replaced by
+ *    360*(jd + 0.5). They differ by whole turns.
+ *
+ * \param   psa      Pointer to psa_t structure with the location. Its time is not used
+ * \param   jd       Pointer to the Julian days from noon 1 January 2000 UT \see psa_jd()
+ * \param   zenith   Pointer to zenith results [rad]
+ * \param   azimuth  Pointer to azimuth results [rad]
+ * \param   n        The number of time stamps
+ * \return  None
+ */
+__O3__ __SIMD__ void psa_calculate_n (const psa_t *psa, const double *jd, double *zenith, double *azimuth, uint32_t n)
+{
+   double lat_rad = _deg2rad (psa->loc.latitude);
+   double cos_lat = cos (lat_rad);
+   double sin_lat = sin (lat_rad);
+   double lon = psa->loc.longitude;
+   uint32_t i;
+
+   for (i=0 ; i<n ; ++i) {
+      double w, mean_lon, mean_anomaly, elon, eobl, sin_elon, ra, dec;
+      double local_mean_st, hour_angle, cos_ha, zen, az;
+
+      // Ecliptic coordinates
+      w            = 2.1429 - 0.0010394594*jd[i];
+      mean_lon     = 4.8950630 + 0.017202791698*jd[i];
+      mean_anomaly = 6.2400600 + 0.0172019699*jd[i];
+      elon = mean_lon - 0.0001134
+           + 0.03341607*qsin (mean_anomaly)
+           + 0.00034894*qsin (2*mean_anomaly)
+           - 0.0000203*qsin (w);
+      eobl = 0.4090928 - 6.2140e-9*jd[i] + 0.0000396*qcos (w);
+
+      // Celestial coordinates
+      sin_elon = qsin (elon);
+      ra  = qatan2 (qcos (eobl) * sin_elon, qcos (elon));
+      dec = qasin (qsin (eobl) * sin_elon);
+
+      // Local coordinates
+      local_mean_st = _deg2rad ((6.6974243242 + 0.0657098283*jd[i])*15 + (jd[i] + 0.5)*360 + lon);
+      hour_angle = local_mean_st - ra;
+      cos_ha = qcos (hour_angle);
+
+      zen = qacos (cos_lat*cos_ha*qcos (dec) + qsin (dec)*sin_lat);
+      az  = qatan2 (-qsin (hour_angle), qtan (dec)*cos_lat - sin_lat*cos_ha);
+      az += (az < 0.0) ? M_2PI : 0.0;
+
+      // Parallax Correction
+      zenith[i]  = zen + (PSA_EARTH_MEAN_RADIUS/PSA_ASTRONOMICAL_UNIT)*qsin (zen);
+      azimuth[i] = az;
+   }
+}
+
 
@@ -147,7 +147,7 @@ __Os__ int queue_get (queue_t *q, void *b)
   *   This function returns the head address.
   */
 inline void* queue_head (queue_t *q){
-   return (void*)&q->buf[q->head];
+   return (void*)&q->buf[q->head*q->item_size];
 }
 
 /*!
@@ -155,5 +155,5 @@ inline void* queue_head (queue_t *q){
   *   This function returns the tail address.
   */
 inline void* queue_tail (queue_t *q){
-   return (void*)&q->buf[q->tail];
+   return (void*)&q->buf[q->tail*q->item_size];
 }
@@ -0,0 +1,541 @@
+/*
+ * \file ring.c
+ * \brief
+ *    Lock-free ring buffers for inter-thread communication.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos <houtouridis.ch@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <algo/ring.h>
+
+#define _relaxed     memory_order_relaxed
+#define _acquire     memory_order_acquire
+#define _release     memory_order_release
+
+/*
+ *  ============= Static API =============
+ */
+
+/*!
+ * \brief
+ *    Copy n items between a linear buffer and the ring, starting
+ *    from ring index idx. The copy wraps around at the end of the ring.
+ */
+static inline void _copy_in (byte_t *ring, uint32_t items, uint32_t idx, const byte_t *b, uint32_t n, uint32_t isz) {
+   uint32_t c = items - idx;
+
+   if (c > n)  c = n;
+   memcpy ((void*)&ring[idx*isz], (const void*)b, c*isz);
+   if (n > c)
+      memcpy ((void*)ring, (const void*)&b[c*isz], (n-c)*isz);
+}
+
+static inline void _copy_out (byte_t *b, const byte_t *ring, uint32_t items, uint32_t idx, uint32_t n, uint32_t isz) {
+   uint32_t c = items - idx;
+
+   if (c > n)  c = n;
+   memcpy ((void*)b, (const void*)&ring[idx*isz], c*isz);
+   if (n > c)
+      memcpy ((void*)&b[c*isz], (const void*)ring, (n-c)*isz);
+}
+
+/*!
+ * \brief
+ *    Return the free items of a SPSC ring, as seen from the producer.
+ *    The shared head is read only if the cached copy does not give at
+ *    least n free items.
+ */
+static inline uint32_t _spsc_free (ring_spsc_t *r, uint32_t t, uint32_t n) {
+   uint32_t f = r->items - (t - r->head_c);
+
+   if (f < n) {
+      r->head_c = atomic_load_explicit (&r->head, _acquire);
+      f = r->items - (t - r->head_c);
+   }
+   return f;
+}
+
+/*!
+ * \brief
+ *    Return the waiting items of a SPSC ring, as seen from the consumer.
+ *    The shared tail is read only if the cached copy does not give at
+ *    least n waiting items.
+ */
+static inline uint32_t _spsc_avail (ring_spsc_t *r, uint32_t h, uint32_t n) {
+   uint32_t a = r->tail_c - h;
+
+   if (a < n) {
+      r->tail_c = atomic_load_explicit (&r->tail, _acquire);
+      a = r->tail_c - h;
+   }
+   return a;
+}
+
+/*!
+ * MPMC cell access
+ */
+#define _cell(_r, _pos)       (&(_r)->buf[((_pos) & (_r)->mask) * (_r)->stride])
+#define _cell_seq(_c)         ((_Atomic uint32_t*)(void*)(_c))
+#define _cell_data(_c)        ((void*)&(_c)[RING_MPMC_HDR])
+
+/*!
+ * \brief
+ *    Claim up to n consecutive cells of a MPMC ring. A cell is ready when
+ *    its sequence is pos+k+_d, where _d is 0 for producers (free cell) and
+ *    1 for consumers (full cell). The cells are claimed by moving the index
+ *    with a CAS. Cells can not change state without the index moving, so a
+ *    successful CAS owns all the checked cells.
+ *
+ * \param   _r    Pointer to ring
+ * \param   _idx  The index to claim (tail or head)
+ * \param   _d    The sequence offset of a ready cell
+ * \param   _n    Maximum number of cells to claim
+ * \param   _pos  Set to the first claimed position
+ * \return  The number of claimed cells, 0 if the ring is full/empty
+ */
+static uint32_t _mpmc_claim (ring_mpmc_t *r, _Atomic uint32_t *idx, uint32_t d, uint32_t n, uint32_t *pos)
+{
+   uint32_t p, k, seq;
+   int32_t diff = 0;
+
+   p = atomic_load_explicit (idx, _relaxed);
+   for ( ; ; ) {
+      for (k=0 ; k<n ; ++k) {
+         seq = atomic_load_explicit (_cell_seq (_cell (r, p+k)), _acquire);
+         if ((diff = (int32_t)(seq - (p + k + d))) != 0)
+            break;
+      }
+      if (k == 0) {
+         if (diff < 0)
+            return 0;   // Full/empty
+         p = atomic_load_explicit (idx, _relaxed);
+         continue;      // Another thread took the cell
+      }
+      if (atomic_compare_exchange_weak_explicit (idx, &p, p+k, _relaxed, _relaxed)) {
+         *pos = p;
+         return k;
+      }
+   }
+}
+
+/*
+ *  ============= Public SPSC API =============
+ */
+
+/*!
+ * \brief
+ *    Initialize a SPSC ring
+ * \param   r           Pointer to ring
+ * \param   buf         Pointer to ring's buffer. Must be at least items*item_size bytes
+ * \param   items       The ring's capacity. Must be a power of 2
+ * \param   item_size   The size of each item in bytes
+ * \return  The status of the operation
+ *    \arg  0     Fail, invalid arguments
+ *    \arg  1     Success
+ */
+int ring_spsc_init (ring_spsc_t *r, void *buf, uint32_t items, uint32_t item_size)
+{
+   if (buf == NULL || items == 0 || (items & (items-1)) || item_size == 0)
+      return 0;
+   r->buf = (byte_t*)buf;
+   r->items = items;
+   r->mask = items - 1;
+   r->item_size = item_size;
+   ring_spsc_flush (r);
+   return 1;
+}
+
+/*!
+ * \brief
+ *    Empty the ring. Not thread safe, both sides must be idle.
+ * \param   r     Pointer to ring
+ */
+void ring_spsc_flush (ring_spsc_t *r)
+{
+   atomic_store_explicit (&r->tail, 0, _relaxed);
+   atomic_store_explicit (&r->head, 0, _relaxed);
+   r->head_c = r->tail_c = 0;
+}
+
+/*!
+ * \brief
+ *    Return the number of items on ring. The result is a snapshot
+ *    and can be used from any side.
+ * \param   r     Pointer to ring
+ */
+uint32_t ring_spsc_waiting (ring_spsc_t *r) {
+   uint32_t h = atomic_load_explicit (&r->head, _acquire);
+   return atomic_load_explicit (&r->tail, _acquire) - h;
+}
+
+/*!
+ * \brief
+ *    Check if ring is empty
+ * \param   r     Pointer to ring
+ * \return
+ *    \arg  0     Not empty
+ *    \arg  1     Empty
+ */
+int ring_spsc_is_empty (ring_spsc_t *r) {
+   return (ring_spsc_waiting (r) == 0) ? 1 : 0;
+}
+
+/*!
+ * \brief
+ *    Check if ring is full
+ * \param   r     Pointer to ring
+ * \return
+ *    \arg  0     Not full
+ *    \arg  1     Full
+ */
+int ring_spsc_is_full (ring_spsc_t *r) {
+   return (ring_spsc_waiting (r) >= r->items) ? 1 : 0;
+}
+
+/*!
+ * \brief
+ *    Put an item to ring. Producer side.
+ * \param   r     Pointer to ring
+ * \param   b     Pointer to item
+ * \return
+ *    \arg  0  Full ring
+ *    \arg  1  Done
+ */
+__O3__ int ring_spsc_put (ring_spsc_t *r, const void *b)
+{
+   uint32_t t = atomic_load_explicit (&r->tail, _relaxed);
+
+   if (_spsc_free (r, t, 1) == 0)
+      return 0;
+   memcpy ((void*)&r->buf[(t & r->mask) * r->item_size], b, r->item_size);
+   atomic_store_explicit (&r->tail, t+1, _release);
+   return 1;
+}
+
+/*!
+ * \brief
+ *    Get an item from ring. Consumer side.
+ * \param   r     Pointer to ring
+ * \param   b     Pointer to item
+ * \return
+ *    \arg  0  Empty ring
+ *    \arg  1  Done
+ */
+__O3__ int ring_spsc_get (ring_spsc_t *r, void *b)
+{
+   uint32_t h = atomic_load_explicit (&r->head, _relaxed);
+
+   if (_spsc_avail (r, h, 1) == 0)
+      return 0;
+   memcpy (b, (const void*)&r->buf[(h & r->mask) * r->item_size], r->item_size);
+   atomic_store_explicit (&r->head, h+1, _release);
+   return 1;
+}
+
+/*!
+ * \brief
+ *    Put up to n items to ring. Producer side. The items are published
+ *    with a single index update.
+ * \param   r     Pointer to ring
+ * \param   b     Pointer to items
+ * \param   n     The number of items
+ * \return  The number of items put
+ */
+__O3__ uint32_t ring_spsc_put_n (ring_spsc_t *r, const void *b, uint32_t n)
+{
+   uint32_t f, t = atomic_load_explicit (&r->tail, _relaxed);
+
+   if ((f = _spsc_free (r, t, n)) < n)
+      n = f;
+   if (n == 0)
+      return 0;
+   _copy_in (r->buf, r->items, t & r->mask, (const byte_t*)b, n, r->item_size);
+   atomic_store_explicit (&r->tail, t+n, _release);
+   return n;
+}
+
+/*!
+ * \brief
+ *    Get up to n items from ring. Consumer side. The items are released
+ *    with a single index update.
+ * \param   r     Pointer to ring
+ * \param   b     Pointer to items
+ * \param   n     The maximum number of items
+ * \return  The number of items read
+ */
+__O3__ uint32_t ring_spsc_get_n (ring_spsc_t *r, void *b, uint32_t n)
+{
+   uint32_t a, h = atomic_load_explicit (&r->head, _relaxed);
+
+   if ((a = _spsc_avail (r, h, n)) < n)
+      n = a;
+   if (n == 0)
+      return 0;
+   _copy_out ((byte_t*)b, r->buf, r->items, h & r->mask, n, r->item_size);
+   atomic_store_explicit (&r->head, h+n, _release);
+   return n;
+}
+
+/*!
+ * \brief
+ *    Reserve contiguous free space in ring for zero-copy writing. Producer side.
+ *    The caller writes the items in place and publishes them with ring_spsc_commit().
+ * \param   r     Pointer to ring
+ * \param   n     Pointer to the number of items. Input is the wanted items, or 0 for
+ *                as many as possible. Output is the reserved items, which can be less
+ *                at the end of the buffer.
+ * \return  Pointer to the first reserved item, or NULL if the ring is full
+ */
+void* ring_spsc_reserve (ring_spsc_t *r, uint32_t *n)
+{
+   uint32_t f, c, t = atomic_load_explicit (&r->tail, _relaxed);
+
+   if (*n == 0)   *n = r->items;
+   f = _spsc_free (r, t, *n);
+   c = r->items - (t & r->mask);
+   if (c > f)     c = f;
+   if (*n > c)    *n = c;
+   return (*n) ? (void*)&r->buf[(t & r->mask) * r->item_size] : NULL;
+}
+
+/*!
+ * \brief
+ *    Publish n items written in place after ring_spsc_reserve(). Producer side.
+ * \param   r     Pointer to ring
+ * \param   n     The number of items, up to the reserved ones
+ */
+void ring_spsc_commit (ring_spsc_t *r, uint32_t n) {
+   uint32_t t = atomic_load_explicit (&r->tail, _relaxed);
+   atomic_store_explicit (&r->tail, t+n, _release);
+}
+
+/*!
+ * \brief
+ *    Access the contiguous waiting items of ring in place. Consumer side.
+ *    The caller reads the items and frees them with ring_spsc_release().
+ * \param   r     Pointer to ring
+ * \param   n     Pointer to the number of items. Input is the wanted items, or 0 for
+ *                as many as possible. Output is the available items, which can be less
+ *                at the end of the buffer.
+ * \return  Pointer to the first item, or NULL if the ring is empty
+ */
+void* ring_spsc_peek (ring_spsc_t *r, uint32_t *n)
+{
+   uint32_t a, c, h = atomic_load_explicit (&r->head, _relaxed);
+
+   if (*n == 0)   *n = r->items;
+   a = _spsc_avail (r, h, *n);
+   c = r->items - (h & r->mask);
+   if (c > a)     c = a;
+   if (*n > c)    *n = c;
+   return (*n) ? (void*)&r->buf[(h & r->mask) * r->item_size] : NULL;
+}
+
+/*!
+ * \brief
+ *    Free n items read in place after ring_spsc_peek(). Consumer side.
+ * \param   r     Pointer to ring
+ * \param   n     The number of items, up to the peeked ones
+ */
+void ring_spsc_release (ring_spsc_t *r, uint32_t n) {
+   uint32_t h = atomic_load_explicit (&r->head, _relaxed);
+   atomic_store_explicit (&r->head, h+n, _release);
+}
+
+/*
+ *  ============= Public MPMC API =============
+ */
+
+/*!
+ * \brief
+ *    Initialize a MPMC ring
+ * \param   r           Pointer to ring
+ * \param   buf         Pointer to ring's buffer. Must be at least
+ *                      RING_MPMC_BUFFER_SIZE(items, item_size) bytes and 8 bytes aligned
+ * \param   items       The ring's capacity. Must be a power of 2 and at least 2
+ * \param   item_size   The size of each item in bytes
+ * \return  The status of the operation
+ *    \arg  0     Fail, invalid arguments
+ *    \arg  1     Success
+ */
+int ring_mpmc_init (ring_mpmc_t *r, void *buf, uint32_t items, uint32_t item_size)
+{
+   uint32_t i;
+
+   if (buf == NULL || items < 2 || (items & (items-1)) || item_size == 0)
+      return 0;
+   r->buf = (byte_t*)buf;
+   r->items = items;
+   r->mask = items - 1;
+   r->item_size = item_size;
+   r->stride = RING_MPMC_STRIDE (item_size);
+   for (i=0 ; i<items ; ++i)
+      atomic_store_explicit (_cell_seq (_cell (r, i)), i, _relaxed);
+   atomic_store_explicit (&r->tail, 0, _relaxed);
+   atomic_store_explicit (&r->head, 0, _release);
+   return 1;
+}
+
+/*!
+ * \brief
+ *    Return the number of items on ring. The result is a snapshot and
+ *    includes items that are claimed but not yet published/released.
+ * \param   r     Pointer to ring
+ */
+uint32_t ring_mpmc_waiting (ring_mpmc_t *r) {
+   uint32_t h = atomic_load_explicit (&r->head, _acquire);
+   uint32_t t = atomic_load_explicit (&r->tail, _acquire);
+   return ((int32_t)(t - h) > 0) ? t - h : 0;
+}
+
+/*!
+ * \brief
+ *    Put an item to ring. Any thread.
+ * \param   r     Pointer to ring
+ * \param   b     Pointer to item
+ * \return
+ *    \arg  0  Full ring
+ *    \arg  1  Done
+ */
+__O3__ int ring_mpmc_put (ring_mpmc_t *r, const void *b) {
+   return (ring_mpmc_put_n (r, b, 1) == 1) ? 1 : 0;
+}
+
+/*!
+ * \brief
+ *    Get an item from ring. Any thread.
+ * \param   r     Pointer to ring
+ * \param   b     Pointer to item
+ * \return
+ *    \arg  0  Empty ring
+ *    \arg  1  Done
+ */
+__O3__ int ring_mpmc_get (ring_mpmc_t *r, void *b) {
+   return (ring_mpmc_get_n (r, b, 1) == 1) ? 1 : 0;
+}
+
+/*!
+ * \brief
+ *    Put up to n items to ring. Any thread. The free cells are
+ *    claimed with a single CAS.
+ * \param   r     Pointer to ring
+ * \param   b     Pointer to items
+ * \param   n     The number of items
+ * \return  The number of items put
+ */
+__O3__ uint32_t ring_mpmc_put_n (ring_mpmc_t *r, const void *b, uint32_t n)
+{
+   uint32_t pos, k, i;
+   byte_t *c;
+
+   if (n == 0)
+      return 0;
+   if ((k = _mpmc_claim (r, &r->tail, 0, n, &pos)) == 0)
+      return 0;
+   for (i=0 ; i<k ; ++i) {
+      c = _cell (r, pos+i);
+      memcpy (_cell_data (c), (const void*)&((const byte_t*)b)[i*r->item_size], r->item_size);
+      atomic_store_explicit (_cell_seq (c), pos+i+1, _release);
+   }
+   return k;
+}
+
+/*!
+ * \brief
+ *    Get up to n items from ring. Any thread. The full cells are
+ *    claimed with a single CAS.
+ * \param   r     Pointer to ring
+ * \param   b     Pointer to items
+ * \param   n     The maximum number of items
+ * \return  The number of items read
+ */
+__O3__ uint32_t ring_mpmc_get_n (ring_mpmc_t *r, void *b, uint32_t n)
+{
+   uint32_t pos, k, i;
+   byte_t *c;
+
+   if (n == 0)
+      return 0;
+   if ((k = _mpmc_claim (r, &r->head, 1, n, &pos)) == 0)
+      return 0;
+   for (i=0 ; i<k ; ++i) {
+      c = _cell (r, pos+i);
+      memcpy ((void*)&((byte_t*)b)[i*r->item_size], _cell_data (c), r->item_size);
+      atomic_store_explicit (_cell_seq (c), pos+i+r->items, _release);
+   }
+   return k;
+}
+
+/*!
+ * \brief
+ *    Claim a free cell for zero-copy writing. Any thread.
+ *    The caller writes the item in place and publishes it with ring_mpmc_commit().
+ *    Consumers wait on this cell until it is committed.
+ * \param   r     Pointer to ring
+ * \return  Pointer to the item, or NULL if the ring is full
+ */
+void* ring_mpmc_reserve (ring_mpmc_t *r)
+{
+   uint32_t pos;
+
+   if (_mpmc_claim (r, &r->tail, 0, 1, &pos) == 0)
+      return NULL;
+   return _cell_data (_cell (r, pos));
+}
+
+/*!
+ * \brief
+ *    Publish an item written in place after ring_mpmc_reserve().
+ * \param   r     Pointer to ring
+ * \param   item  The pointer returned from ring_mpmc_reserve()
+ */
+void ring_mpmc_commit (ring_mpmc_t *r, void *item)
+{
+   _Atomic uint32_t *seq = _cell_seq ((byte_t*)item - RING_MPMC_HDR);
+   tbx_unused (r);
+   atomic_store_explicit (seq, atomic_load_explicit (seq, _relaxed) + 1, _release);
+}
+
+/*!
+ * \brief
+ *    Claim a full cell for reading in place. Any thread.
+ *    The caller reads the item and frees it with ring_mpmc_release().
+ *    Producers wait on this cell until it is released.
+ * \param   r     Pointer to ring
+ * \return  Pointer to the item, or NULL if the ring is empty
+ */
+void* ring_mpmc_peek (ring_mpmc_t *r)
+{
+   uint32_t pos;
+
+   if (_mpmc_claim (r, &r->head, 1, 1, &pos) == 0)
+      return NULL;
+   return _cell_data (_cell (r, pos));
+}
+
+/*!
+ * \brief
+ *    Free an item read in place after ring_mpmc_peek().
+ * \param   r     Pointer to ring
+ * \param   item  The pointer returned from ring_mpmc_peek()
+ */
+void ring_mpmc_release (ring_mpmc_t *r, void *item)
+{
+   _Atomic uint32_t *seq = _cell_seq ((byte_t*)item - RING_MPMC_HDR);
+   atomic_store_explicit (seq, atomic_load_explicit (seq, _relaxed) + r->items - 1, _release);
+}
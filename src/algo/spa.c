@@ -95,7 +95,14 @@ typedef struct {
    double sta;         /*!< sun transit altitude [degrees] */
 } _spa_data_t;
 
-static _spa_data_t _spa_data;
+/*!
+ * Site independent data for the sun rise, transit and set
+ */
+typedef struct {
+   double nu;                 /*!< Greenwich sidereal time at 0 UT [degrees] */
+   double alpha[JD_COUNT];    /*!< geocentric right ascension of the previous, current and next day [degrees] */
+   double delta[JD_COUNT];    /*!< geocentric declination of the previous, current and next day [degrees] */
+} _spa_rts_t;
 
 
 /*
@@ -215,7 +222,7 @@ static double _top_elevation_angle (double latitude, double delta_prime, double
 static double _refraction_correction(spa_atmos_t sa, double e0);
 static double _top_azimuth_angle_astro(double h_prime, double latitude, double delta_prime);
 static double _incidence_angle (spa_output_t so, spa_location_t sl);
-static void   _geo_sun_ra_and_decl (double delta_t);
+static void   _geo_sun_ra_and_decl (_spa_data_t *d, double delta_t);
 
 /*
  * Sun Rise transit and set
@@ -223,9 +230,11 @@ static void   _geo_sun_ra_and_decl (double delta_t);
 static double _wrap_min (double m);
 static double _rts_hour_angle_at_rise_set (double latitude, double delta_zero, double h0_prime);
 static void   _rts_approx_rise_and_set (double *m_rts, double h0);
-static double _rts_alpha_delta_prime (double *ad, double n);
+static double _rts_alpha_delta_prime (const double *ad, double n);
 static double _rts_sun_altitude(double latitude, double delta_prime, double h_prime);
-static void   _eot_and_sun_rts(spa_t *spa, _spa_data_t *_spa_data, spa_output_t *spa_out);
+static void   _rts_geo (spa_time_t utc, _spa_rts_t *rts);
+static void   _eot_and_sun_rts(const spa_t *spa, _spa_data_t *_spa_data, const _spa_rts_t *rts, spa_output_t *spa_out);
+static spa_output_t _spa_site (const spa_t *spa, const _spa_data_t *t, const _spa_rts_t *rts, spa_func_en fun);
 
 
 /*
@@ -496,42 +505,43 @@ static double _incidence_angle (spa_output_t so, spa_location_t sl)
  * \brief
  *    Calculate required SPA parameters to get the right ascension (alpha) and declination (delta)
  * \note
- *    Julian day must be already calculated and in structure
+ *    Julian day must be already calculated and in structure. All the results
+ *    depend only on the time, so they can be shared by all the sites.
  */
-static void _geo_sun_ra_and_decl (double delta_t)
+static void _geo_sun_ra_and_decl (_spa_data_t *d, double delta_t)
 {
     double x[TERM_X_COUNT];
 
-    _spa_data.jde = _julian_eph_day (_spa_data.jd, delta_t);
-    _spa_data.jc  = _julian_century (_spa_data.jd);
-    _spa_data.jce = _julian_century (_spa_data.jde);
-    _spa_data.jme = _julian_millennium (_spa_data.jce);
+    d->jde = _julian_eph_day (d->jd, delta_t);
+    d->jc  = _julian_century (d->jd);
+    d->jce = _julian_century (d->jde);
+    d->jme = _julian_millennium (d->jce);
 
-    _spa_data.l = _earth_hel_longitude (_spa_data.jme);
-    _spa_data.b = _earth_hel_latitude (_spa_data.jme);
-    _spa_data.r = _earth_radius_vector (_spa_data.jme);
+    d->l = _earth_hel_longitude (d->jme);
+    d->b = _earth_hel_latitude (d->jme);
+    d->r = _earth_radius_vector (d->jme);
 
-    _spa_data.theta = _hel2geo_longitude (_spa_data.l);
-    _spa_data.beta = _hel2geo_latitude(_spa_data.b);
+    d->theta = _hel2geo_longitude (d->l);
+    d->beta = _hel2geo_latitude(d->b);
 
-    x[TERM_X0] = _spa_data.x0 = _mean_elongation_moon_sun (_spa_data.jce);
-    x[TERM_X1] = _spa_data.x1 = _mean_anomaly_sun (_spa_data.jce);
-    x[TERM_X2] = _spa_data.x2 = _mean_anomaly_moon (_spa_data.jce);
-    x[TERM_X3] = _spa_data.x3 = _argument_latitude_moon (_spa_data.jce);
-    x[TERM_X4] = _spa_data.x4 = _ascending_longitude_moon (_spa_data.jce);
+    x[TERM_X0] = d->x0 = _mean_elongation_moon_sun (d->jce);
+    x[TERM_X1] = d->x1 = _mean_anomaly_sun (d->jce);
+    x[TERM_X2] = d->x2 = _mean_anomaly_moon (d->jce);
+    x[TERM_X3] = d->x3 = _argument_latitude_moon (d->jce);
+    x[TERM_X4] = d->x4 = _ascending_longitude_moon (d->jce);
 
-    _nutation (_spa_data.jce, x, &_spa_data.del_psi, &_spa_data.del_epsilon);
+    _nutation (d->jce, x, &d->del_psi, &d->del_epsilon);
 
-    _spa_data.epsilon0 = _ecliptic_mean_obliquity (_spa_data.jme);
-    _spa_data.epsilon  = _obliquity_correction (_spa_data.del_epsilon, _spa_data.epsilon0);
+    d->epsilon0 = _ecliptic_mean_obliquity (d->jme);
+    d->epsilon  = _obliquity_correction (d->del_epsilon, d->epsilon0);
 
-    _spa_data.del_tau   = _aberration_correction(_spa_data.r);
-    _spa_data.lamda     = _apparent_sun_lon (_spa_data.theta, _spa_data.del_psi, _spa_data.del_tau);
-    _spa_data.nu0       = _greenwich_mean_sidereal_time (_spa_data.jd, _spa_data.jc);
-    _spa_data.nu        = _greenwich_sidereal_time (_spa_data.nu0, _spa_data.del_psi, _spa_data.epsilon);
+    d->del_tau   = _aberration_correction(d->r);
+    d->lamda     = _apparent_sun_lon (d->theta, d->del_psi, d->del_tau);
+    d->nu0       = _greenwich_mean_sidereal_time (d->jd, d->jc);
+    d->nu        = _greenwich_sidereal_time (d->nu0, d->del_psi, d->epsilon);
 
-    _spa_data.alpha = _geo_right_ascension (_spa_data.lamda, _spa_data.epsilon, _spa_data.beta);
-    _spa_data.delta = _geo_declination (_spa_data.beta, _spa_data.epsilon, _spa_data.lamda);
+    d->alpha = _geo_right_ascension (d->lamda, d->epsilon, d->beta);
+    d->delta = _geo_declination (d->beta, d->epsilon, d->lamda);
 }
 
 
@@ -571,7 +581,7 @@ static void _rts_approx_rise_and_set (double *m_rts, double h0)
    m_rts[SUN_TRANSIT] = _wrap ((m_rts[SUN_TRANSIT]), 0, 1);
 }
 
-static double _rts_alpha_delta_prime (double *ad, double n)
+static double _rts_alpha_delta_prime (const double *ad, double n)
 {
    double a = ad[JD_ZERO] - ad[JD_MINUS];
    double b = ad[JD_PLUS] - ad[JD_ZERO];
@@ -594,39 +604,46 @@ static double _rts_sun_altitude(double latitude, double delta_prime, double h_pr
 
 /*!
  * \brief
- *    Calculate Equation of time sun rise, transit and set
+ *    Calculate the site independent part of sun rise, transit and set.
+ *    The geocentric sun position of the previous, current and next day at 0 UT.
  */
-static void _eot_and_sun_rts(spa_t *spa, _spa_data_t *_spa_data, spa_output_t *spa_out)
+static void _rts_geo (spa_time_t utc, _spa_rts_t *rts)
 {
-   _spa_data_t sun_rts = *_spa_data;
-   spa_time_t  utc_rts = spa->utc;
-   double nu, m, h0, n;
-   double alpha[JD_COUNT], delta[JD_COUNT];
-   double m_rts[SUN_COUNT], nu_rts[SUN_COUNT], h_rts[SUN_COUNT];
-   double alpha_prime[SUN_COUNT], delta_prime[SUN_COUNT], h_prime[SUN_COUNT];
-   double h0_prime = -1*(SUN_RADIUS + spa->atmos.refract);
+   _spa_data_t d;
    int i;
 
-   m           = _rts_sun_mean_lon (_spa_data->jme);
-   sun_rts.eot = _rts_eot (m, sun_rts.alpha, sun_rts.del_psi, sun_rts.epsilon);
-
    // Clear hour and keep Date only
-   utc_rts.hour = utc_rts.min = utc_rts.sec = 0;
-   utc_rts.delta_ut1 = utc_rts.timezone = 0.0;
-
-   sun_rts.jd = _julian_day (utc_rts);
+   utc.hour = utc.min = utc.sec = 0;
+   utc.delta_ut1 = utc.timezone = 0.0;
 
-   _geo_sun_ra_and_decl (utc_rts.delta_t);
-   nu = sun_rts.nu;
+   d.jd = _julian_day (utc);
+   _geo_sun_ra_and_decl (&d, utc.delta_t);
+   rts->nu = d.nu;
 
-   utc_rts.delta_t = 0;
-   sun_rts.jd--;
+   d.jd--;
    for (i = 0; i < JD_COUNT; i++) {
-      _geo_sun_ra_and_decl (utc_rts.delta_t);
-     alpha[i] = sun_rts.alpha;
-     delta[i] = sun_rts.delta;
-     sun_rts.jd++;
+      _geo_sun_ra_and_decl (&d, 0);
+      rts->alpha[i] = d.alpha;
+      rts->delta[i] = d.delta;
+      d.jd++;
    }
+}
+
+/*!
+ * \brief
+ *    Calculate Equation of time sun rise, transit and set
+ */
+static void _eot_and_sun_rts(const spa_t *spa, _spa_data_t *_spa_data, const _spa_rts_t *rts, spa_output_t *spa_out)
+{
+   const double *alpha = rts->alpha, *delta = rts->delta;
+   double nu = rts->nu, m, h0, n;
+   double m_rts[SUN_COUNT], nu_rts[SUN_COUNT], h_rts[SUN_COUNT];
+   double alpha_prime[SUN_COUNT], delta_prime[SUN_COUNT], h_prime[SUN_COUNT];
+   double h0_prime = -1*(SUN_RADIUS + spa->atmos.refract);
+   int i;
+
+   m               = _rts_sun_mean_lon (_spa_data->jme);
+   _spa_data->eot  = _rts_eot (m, _spa_data->alpha, _spa_data->del_psi, _spa_data->epsilon);
 
    m_rts[SUN_TRANSIT] = _rts_approx_sun_transit_time (alpha[JD_ZERO], spa->loc.longitude, nu);
    h0 = _rts_hour_angle_at_rise_set (spa->loc.latitude, delta[JD_ZERO], h0_prime);
@@ -672,6 +689,50 @@ static void _eot_and_sun_rts(spa_t *spa, _spa_data_t *_spa_data, spa_output_t *s
 
 }
 
+/*!
+ * \brief
+ *    Calculate the site dependent part of the algorithm
+ * \param   spa   The site data. The utc field must be the time of \a t
+ * \param   t     The time dependent data from _geo_sun_ra_and_decl()
+ * \param   rts   The time dependent data from _rts_geo(), used by SPA_ZA_RTS and SPA_ALL
+ * \param   fun   Select which output data to calculate
+ * \return  The results
+ */
+static spa_output_t _spa_site (const spa_t *spa, const _spa_data_t *t, const _spa_rts_t *rts, spa_func_en fun)
+{
+   _spa_data_t d = *t;
+   spa_output_t ret;
+
+   d.h  = _hour_angle (d.nu, spa->loc.longitude, d.alpha);
+   d.xi = _horizontal_parallax (d.r);
+
+   _delta_alpha_prime (spa->loc, d.xi, d.h, d.delta, &d.delta_alpha, &d.delta_prime);
+
+   d.alpha_prime = _top_right_ascension (d.alpha, d.delta_alpha);
+   d.h_prime     = _top_hour_angle (d.h, d.delta_alpha);
+
+   d.e0      = _top_elevation_angle (spa->loc.latitude, d.delta_prime, d.h_prime);
+   d.del_e   = _refraction_correction (spa->atmos, d.e0);
+   d.e       = _top_elevation_angle_correction (d.e0, d.del_e);
+
+   ret.zenith        = _top_zenith_angle (d.e);
+   ret.azimuth_astro = _top_azimuth_angle_astro (d.h_prime, spa->loc.latitude, d.delta_prime);
+   ret.azimuth       = _top_azimuth_angle (ret.azimuth_astro);
+
+   switch (fun) {
+      default:
+      case SPA_ZA:      break;
+      case SPA_ZA_INC:
+         ret.incidence  = _incidence_angle (ret, spa->loc);    break;
+      case SPA_ZA_RTS:
+         _eot_and_sun_rts (spa, &d, rts, &ret);                break;
+      case SPA_ALL:
+         ret.incidence  = _incidence_angle (ret, spa->loc);
+         _eot_and_sun_rts (spa, &d, rts, &ret);                break;
+   }
+   return ret;
+}
+
 /*
  * ================== PUBLIC API ===================
  */
@@ -814,6 +875,8 @@ drv_status_en spa_set_atmos (spa_t *spa, double pr, double temp, double ar)
 /*!
  * \brief
  *    Calculate Sun position using input data stored in spa
+ * \note
+ *    The function is reentrant. All the intermediate data live in the stack.
  * \param   spa      Pointer to SPA structure to use for calculations
  * \param   fun      Select which output data to calculate
  *    \arg  SPA_ZA      calculate zenith and azimuth
@@ -824,39 +887,56 @@ drv_status_en spa_set_atmos (spa_t *spa, double pr, double temp, double ar)
  */
 spa_output_t spa_calculate (spa_t *spa, spa_func_en fun)
 {
-   spa_output_t ret;
+   _spa_data_t d;
+   _spa_rts_t  rts;
 
-   _spa_data.jd = _julian_day (spa->utc);
-   _geo_sun_ra_and_decl (spa->utc.delta_t);
+   d.jd = _julian_day (spa->utc);
+   _geo_sun_ra_and_decl (&d, spa->utc.delta_t);
+   if (fun == SPA_ZA_RTS || fun == SPA_ALL)
+      _rts_geo (spa->utc, &rts);
 
-   _spa_data.h  = _hour_angle (_spa_data.nu, spa->loc.longitude, _spa_data.alpha);
-   _spa_data.xi = _horizontal_parallax (_spa_data.r);
-
-   _delta_alpha_prime (spa->loc, _spa_data.xi, _spa_data.h, _spa_data.delta,
-                       &_spa_data.delta_alpha, &_spa_data.delta_prime);
-
-   _spa_data.alpha_prime = _top_right_ascension (_spa_data.alpha, _spa_data.delta_alpha);
-   _spa_data.h_prime     = _top_hour_angle (_spa_data.h, _spa_data.delta_alpha);
-
-   _spa_data.e0      = _top_elevation_angle (spa->loc.latitude, _spa_data.delta_prime, _spa_data.h_prime);
-   _spa_data.del_e   = _refraction_correction (spa->atmos, _spa_data.e0);
-   _spa_data.e       = _top_elevation_angle_correction (_spa_data.e0, _spa_data.del_e);
+   return _spa_site (spa, &d, &rts, fun);
+}
 
-   ret.zenith        = _top_zenith_angle (_spa_data.e);
-   ret.azimuth_astro = _top_azimuth_angle_astro (_spa_data.h_prime, spa->loc.latitude, _spa_data.delta_prime);
-   ret.azimuth       = _top_azimuth_angle (ret.azimuth_astro);
+/*!
+ * \brief
+ *    Calculate Sun position for a time series over a group of sites.
+ *    The earth heliocentric position and the nutation depend only on
+ *    the time, so they are calculated once per time stamp and shared by
+ *    all the sites. With OpenMP the sites of each time stamp are spread
+ *    to all the cores.
+ *
+ * \param   times    Pointer to the time stamps, as filled by \see spa_set_time()
+ * \param   nt       The number of time stamps
+ * \param   sites    Pointer to the sites. Only the location and atmos fields are used
+ * \param   ns       The number of sites
+ * \param   fun      Select which output data to calculate \see spa_calculate()
+ * \param   out      Pointer to the results [nt * ns]. The result of time t on
+ *                   site s is out[t*ns + s]
+ * \return  None
+ */
+void spa_calculate_batch (const spa_time_t *times, uint32_t nt, const spa_t *sites, uint32_t ns,
+                          spa_func_en fun, spa_output_t *out)
+{
+   _spa_data_t d;
+   _spa_rts_t  rts;
+   uint32_t t;
+   int32_t  s;
+
+   for (t=0 ; t<nt ; ++t) {
+      d.jd = _julian_day (times[t]);
+      _geo_sun_ra_and_decl (&d, times[t].delta_t);
+      if (fun == SPA_ZA_RTS || fun == SPA_ALL)
+         _rts_geo (times[t], &rts);
+
+#if defined(_OPENMP)
+      #pragma omp parallel for schedule(static)
+#endif
+      for (s=0 ; s<(int32_t)ns ; ++s) {
+         spa_t site = sites[s];
 
-   switch (fun) {
-      default:
-      case SPA_ZA:      break;
-      case SPA_ZA_INC:
-         ret.incidence  = _incidence_angle (ret, spa->loc);    break;
-      case SPA_ZA_RTS:
-         _eot_and_sun_rts (spa, &_spa_data, &ret);             break;
-      case SPA_ALL:
-         ret.incidence  = _incidence_angle (ret, spa->loc);
-         _eot_and_sun_rts (spa, &_spa_data, &ret);             break;
+         site.utc = times[t];
+         out[(size_t)t*ns + s] = _spa_site (&site, &d, &rts, fun);
+      }
    }
-   return ret;
 }
-
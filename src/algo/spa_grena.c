@@ -32,12 +32,12 @@
  * ============ Static Functions ==========
  */
 inline static double _rad2deg (double rad) {
-   return fabs (fmod ((180 * rad / M_PI), 360.0));
+   return fmod ((180 * rad / M_PI), 360.0);
 }
 
-// Convert degree angle to radians
+// Convert degree angle to radians, keeping the sign of S latitudes and W longitudes
 inline static double _deg2rad (double dec) {
-   return fabs (fmod ((M_PI * dec / 180), 2*M_PI));
+   return fmod ((M_PI * dec / 180), 2*M_PI);
 }
 
 /*
@@ -251,8 +251,8 @@ sun_pos_t spa_grena_calculation (spa_grena_t *spa)
       De = 0;
 
    // local coordinates of the sun
-   ret.elev = e0 - De;
-   ret.azimuth = M_PI + atan2 (sht, cht*sin_phy - sin_Dt*cos_phy);
+   ret.elev = e0 + De;
+   ret.azimuth = M_PI + atan2 (sht, cht*sin_phy - sin_Dt/cos_Dt*cos_phy);
    /*
     * xxx:
     * The original equation returns azimuth [-pi, pi] with zero azimuth
@@ -262,3 +262,89 @@ sun_pos_t spa_grena_calculation (spa_grena_t *spa)
     */
    return ret;
 }
+
+/*!
+ * \brief
+ *    Normalized Julian Day of a UNIX time, for \see spa_grena_calculation_n().
+ *    The njd is linear to time, so a series can also be filled as
+ *    njd[i] = njd[0] + i*step/86400.0
+ *
+ * \param   utc   UTC time in UNIX format
+ * \return        Normalized Julian Day, 0 = noon 1 Jan 2003
+ */
+double spa_grena_njd (time_t utc) {
+   return (double)utc / 86400.0 - 12052.5;
+}
+
+/*!
+ * \brief
+ *    Sun position for many time stamps on one site.
+ *    The algorithm is the same as \see spa_grena_calculation(), but the data
+ *    are structure of arrays and the trigonometric functions are the inline
+ *    polynomials of quick_trig, so the loop is vectorized.
+ *
+ * \param   spa      Pointer to linked data struct, with the site data and delta_t.
+ *                   Its time is not used.
+ * \param   njd      Pointer to the Normalized Julian Days \see spa_grena_njd()
+ * \param   azimuth  Pointer to azimuth results in rad [0, 2pi]
+ * \param   elev     Pointer to elevation results in rad [-pi, pi]
+ * \param   n        The number of time stamps
+ * \return           None
+ */
+__O3__ __SIMD__ void spa_grena_calculation_n (const spa_grena_t *spa, const double *njd, double *azimuth, double *elev, uint32_t n)
+{
+   double dt = spa->delta_t / 86400;
+   double cos_phy = cos (spa->latitude);
+   double sin_phy = sin (spa->latitude);
+   double Rf = 0.084217 * spa->p / (273 + spa->T);
+   double lon = spa->longitude;
+   uint32_t i;
+
+   for (i=0 ; i<n ; ++i) {
+      double t  = njd[i] + dt;
+      double t2 = t/1000.0;
+      double s, Lh, Dy, epsilon, y, sin_y, ar, D, h;
+      double cos_h, sin_h, Da, Dt, sin_Dt, cos_Dt, cht, sht, e0, ec, rm, De;
+
+      // Heliocentric longitude
+      s  = 1.72019e-2 * t - 0.0563;
+      Lh = 1.740940 + 1.7202768683e-2 * t + 3.34118e-2 * qsin (s) + 3.488e-4 * qsin (2*s)
+         + 3.13e-5 * qsin (0.2127730*t - 0.585)
+         + 1.26e-5 * qsin (4.243e-3 * t + 1.46)
+         + 2.35e-5 * qsin (1.0727e-2 * t + 0.72)
+         + 2.76e-5 * qsin (1.5799e-2 * t + 2.35)
+         + 2.75e-5 * qsin (2.1551e-2 * t - 1.98)
+         + 1.26e-5 * qsin (3.1490e-2 * t - 0.80)
+         + ((( -2.30796e-7 * t2 + 3.7976e-6) * t2 - 2.0458e-5) * t2 + 3.976e-5) * t2*t2;
+
+      // Nutation and earth axis inclination
+      Dy = 8.33e-5 * qsin (9.252e-4 * t - 1.173);
+      epsilon = -6.21e-9 * t + 0.409086 + 4.46e-5 * qsin (9.252e-4 * t + 0.397);
+
+      // Geocentric global solar coordinates
+      y     = Lh + M_PI + Dy - 9.932e-5;
+      sin_y = qsin (y);
+      ar    = qatan2 (sin_y * qcos (epsilon), qcos (y));
+      D     = qasin (qsin (epsilon) * sin_y);
+
+      // Local topocentric coordinates
+      h      = 6.30038809903*njd[i] + 4.8824623 + 0.9174*Dy + lon - ar;
+      cos_h  = qcos (h);
+      sin_h  = qsin (h);
+      Da     = -4.26e-5 * cos_phy * sin_h;
+      Dt     = D - 4.26e-5 * (sin_phy - D * cos_phy);
+      sin_Dt = qsin (Dt);
+      cos_Dt = qcos (Dt);
+      cht    = cos_h + Da * sin_h;
+      sht    = sin_h - Da * cos_h;
+
+      e0 = qasin (sin_phy * sin_Dt + cos_phy * cos_Dt * cht);
+      // Refraction, under the threshold e0 is moved to it, so the masked out value stays finite
+      rm = 0.5 - 0.5*copysign (1.0, SPA_ELEVATION_REFRACTION_TH - e0);
+      ec = e0 + (1.0 - rm)*(SPA_ELEVATION_REFRACTION_TH - e0);
+      De = rm * Rf / qtan (ec + 0.0031376/(ec + 0.089186));
+
+      elev[i]    = e0 + De;
+      azimuth[i] = M_PI + qatan2 (sht, cht*sin_phy - sin_Dt/cos_Dt*cos_phy);
+   }
+}
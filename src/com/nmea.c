@@ -86,6 +86,30 @@ static const parse_obj_en _ZDA[] = {
    _msgid, _utc, _day, _month, _year, _zone_h, _zone_m, _null
 };
 
+/*!
+ * Sentence grammars, indexed by nmea_msgid_en
+ */
+static const parse_obj_en *const _grammar[NMEA_MSGID_NUM] = {
+   NULL, _GGA, _GLL, _GSA, _GSV, _RMC, _VTG, _ZDA
+};
+
+/*!
+ * Negative powers of ten for the fractional part of the fields
+ */
+static const float _frac10[NMEA_MAX_FRAC_DIGITS+1] = {
+   1e0f, 1e-1f, 1e-2f, 1e-3f, 1e-4f, 1e-5f, 1e-6f, 1e-7f, 1e-8f, 1e-9f
+};
+
+/*!
+ * Stream parser states
+ */
+typedef enum {
+   _ST_IDLE = 0,     //!< Wait for '$'
+   _ST_ADDR,         //!< Address field, ex: "GPGGA"
+   _ST_FIELD,        //!< Data fields
+   _ST_CS_HI,        //!< Checksum's high nibble
+   _ST_CS_LO         //!< Checksum's low nibble
+}_nmea_state_en;
 
 
 /*
@@ -95,46 +119,26 @@ static const parse_obj_en _ZDA[] = {
 //! \name Tools
 //!@{
 static int _checksum (char* str);
-static float _nmea2dec (float c);
 static float _dec2nmea (float c);
-static int _match (char *sen, char *word, int n);
 static nmea_msgid_en _msgid_type (char *str);
 static char * _msgid_str (nmea_msgid_en id);
+static int _hex (byte_t c);
 //!@}
 
-//! \name Extract tools
+//! \name Stream parser
 //!@{
-static int _read_sen_type (char *str, nmea_msgid_en *id);
-static int _read_utc (char *str, utc_time_t *t);
-static int _read_day (char *str, int *day);
-static int _read_month (char *str, int *month);
-static int _read_year (char *str, int *year);
-static int _read_zone_h (char *str, int *zone_h);
-static int _read_zone_m (char *str, int *zone_m);
-static int _read_date (char *str, utc_date_t *date);
-static int _read_lat (char *str, float *lat);
-static int _read_lat_s (char *str, nmea_lat_sign_en *lat_s);
-static int _read_long (char *str, float *lon);
-static int _read_long_s (char *str, nmea_long_sign_en *lon_s);
-static int _read_elev (char *str, float *elev);
-static int _read_speed (char *str, float *speed);
-static int _read_sp_unts (char *str, nmea_speed_units_en *sp_unts);
-static int _read_course (char *str, float *course);
-static int _read_course_type (char *str, nmea_course_en *course_type);
-static int _read_mag_var (char *str, float *mag_var);
-static int _read_mag_var_s (char *str, nmea_long_sign_en *mag_var_s);
-static int _read_sats (char *str, int *sats);
-static int _read_fix (char *str, nmea_fix_en *fix);
-static int _read_valid (char *str, nmea_valid_en *valid);
+static void _sen_start (nmea_parser_t *ps);
+static void _field_start (nmea_parser_t *ps);
+static void _field_end (nmea_parser_t *ps);
+static const void * _store (nmea_cache_t *cache, nmea_msgid_en id, const nmea_common_t *obj);
+static int _sen_end (nmea_t *nmea);
+static int _parse (nmea_t *nmea, byte_t c) __O3__ ;
 //!@}
 
 //! \name Middle level
 //!@{
-static int _get_sen (nmea_t *nmea);
-static int _get_token (char *str, char *token);
-static int _checksum_chk (char *str);
 static int _read_until (nmea_t *nmea, nmea_msgid_en id);
-static int _tokenise (nmea_t *nmea, const parse_obj_en *format, nmea_common_t *obj);
+static void _stream (nmea_t *nmea, char *str);
 //!@}
 
 
@@ -159,46 +163,12 @@ static int _checksum (char* str) {
  * \brief
  *    Converts decimal angle to NMEA's format angle
  */
-static float _nmea2dec (float c)
-{
-   int d;
-
-   d = (int)c/100;
-   c -= d*100;
-   return d + (c/60);
-}
-
-/*!
- * \brief
- *    Converts NMEA's format angle to decimal angle
- */
 static float _dec2nmea (float c)
 {
    int d = (int)c;
    return d*100 + ((c-d) * 60);
 }
 
-/*!
- * \brief
- *    Search if there is a string pointed by \a word
- *    into string pointed by \a sen
- * \param   sen   Pointer to string to search into
- * \param   word  Pointer to string to search
- * \param   n     Size of word string
- * \return        The result
- *    \arg  0     Not found
- *    \arg  1     Found
- */
-static int _match (char *sen, char *word, int n)
-{
-   while (*sen) {
-      if ( !strncmp (sen, word, n) )
-         return 1;
-      ++sen;
-   }
-   return 0;
-}
-
 /*!
  * \brief
  *    Converts Message id string into message id type
@@ -223,543 +193,351 @@ static char * _msgid_str (nmea_msgid_en id)
    return NULL;
 }
 
-
-/*
- * ============== Extract tools ==============
- */
-
-/*!
- * \brief
- *    Read sentence type
- * Try to find id string \a str into sentence
- * \param   str   Pointer to token
- * \param   id    Pointer to id to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_sen_type (char *str, nmea_msgid_en *id) {
-   for (int i=0 ; nmea_msgid[i].id_type; ++i) {
-      if ( _match (str, nmea_msgid[i].id_str, 3) ) {
-         *id = nmea_msgid[i].id_type;
-         return 1;
-      }
-   }
-   *id = NMEA_NULL;
-   return 0;
-}
-
-/*!
- * \brief
- *    Read utc time
- * Try to extract utc time from token \a str
- * \param   str   Pointer to token
- * \param   t     Pointer to utc_time_t type to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_utc (char *str, utc_time_t *t) {
-   int utc_d, utc_f;
-
-   if (sscanf (str, "%d.%d", &utc_d, &utc_f)  != 2)
-      return 0;
-
-   t->hour = utc_d / 10000;
-   utc_d -= t->hour * 10000;
-   t->min = utc_d / 100;
-   t->sec = utc_d - t->min*100;
-   t->sec += (float)utc_f / 1000;
-   return 1;
-}
-
-/*!
- * \brief
- *    Read utc date
- * Try to extract utc date from token \a str
- * \param   str   Pointer to token
- * \param   date  Pointer to utc_date_t type to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_date (char *str, utc_date_t *date) {
-   int d;
-   if (sscanf (str, "%d", &d) != 1)
-      return 0;
-   date->day = d/10000;
-   d -= date->day * 10000;
-   date->month = d / 100;
-   date->year = d - date->month*100 + 2000;
-   return 1;
-}
-
-/*!
- * \brief
- *    Read day of month
- * Try to extract day from token \a str
- * \param   str   Pointer to token
- * \param   day   Pointer to day variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_day (char *str, int *day) {
-   return (sscanf (str, "%d", day) == 1) ? 1:0;
-}
-
 /*!
  * \brief
- *    Read month
- * Try to extract month from token \a str
- * \param   str   Pointer to token
- * \param   month Pointer to month variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
+ *    Hex digit value, or -1 for non hex characters
  */
-static int _read_month (char *str, int *month) {
-   return (sscanf (str, "%d", month) == 1) ? 1:0;
-}
-
-/*!
- * \brief
- *    Read year
- * Try to extract year from token \a str
- * \param   str   Pointer to token
- * \param   year  Pointer to year variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_year (char *str, int *year) {
-   return (sscanf (str, "%d", year) == 1) ? 1:0;
-}
-
-/*!
- * \brief
- *    Read local hour time zone offset
- * Try to extract hour time zone from token \a str
- * \param   str   Pointer to token
- * \param   zone_h Pointer to time zone variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_zone_h (char *str, int *zone_h) {
-   return (sscanf (str, "%d", zone_h) == 1) ? 1:0;
-}
-
-/*!
- * \brief
- *    Read local minute time zone offset
- * Try to extract minute time zone from token \a str
- * \param   str   Pointer to token
- * \param   zone_m Pointer to time zone variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_zone_m (char *str, int *zone_m) {
-   return (sscanf (str, "%d", zone_m) == 1) ? 1:0;
-}
-
-/*!
- * \brief
- *    Read latitude
- * Try to extract latitude from token \a str and convert it to
- * decimal format
- * \param   str   Pointer to token
- * \param   lat   Pointer to latitude variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_lat (char *str, float *lat) {
-   float l;
-   if (sscanf (str, "%f", &l) != 1)
-      return 0;
-   *lat = _nmea2dec (l);
-   return 1;
-}
-
-/*!
- * \brief
- *    Read latitude's orientation (South or north)
- * Try to extract latitude sign from token \a str
- * \param   str   Pointer to token
- * \param   lat_s Pointer to latitude sign variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_lat_s (char *str, nmea_lat_sign_en *lat_s) {
-   char sign;
-   *lat_s = NMEA_N;
-   if (sscanf (str, "%c", &sign) != 1)
-      return 0;
-   if (sign == 'S' || sign == 's')
-      *lat_s = NMEA_S;
-   return 1;
-}
-
-/*!
- * \brief
- *    Read longitude
- * Try to extract longitude from token \a str and convert it to
- * decimal format
- * \param   str   Pointer to token
- * \param   lon   Pointer to longitude variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_long (char *str, float *lon) {
-   float l;
-   if (sscanf (str, "%f", &l) != 1)
-      return 0;
-   *lon = _nmea2dec (l);
-   return 1;
+static int _hex (byte_t c)
+{
+   if (c >= '0' && c <= '9')  return c - '0';
+   c |= 0x20;
+   if (c >= 'a' && c <= 'f')  return c - 'a' + 10;
+   return -1;
 }
 
-/*!
- * \brief
- *    Read longitude orientation (South or north)
- * Try to extract longitude sign from token \a str
- * \param   str   Pointer to token
- * \param   lon_s Pointer to longirude sign variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_long_s (char *str, nmea_long_sign_en *lon_s) {
-   char sign;
-   *lon_s = NMEA_E;
-   if (sscanf (str, "%c", &sign) != 1)
-      return 0;
-   if (sign == 'W' || sign == 'w')
-      *lon_s = NMEA_W;
-   return 1;
-}
 
-/*!
- * \brief
- *    Read elevation
- * Try to extract elevation from token \a str
- * \param   str   Pointer to token
- * \param   elev  Pointer to elevation variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
+/*
+ * ============== Stream parser ==============
  */
-static int _read_elev (char *str, float *elev) {
-   return (sscanf (str, "%f", elev) == 1) ? 1:0;
-}
 
 /*!
  * \brief
- *    Read speed
- * Try to extract speed from token \a str
- * \param   str   Pointer to token
- * \param   speed Pointer to speed variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
+ *    Reset the parser for a new sentence, after '$'.
+ *    The data are marked as in nmea_read_xxx(), so the missing
+ *    fields are recognised.
  */
-static int _read_speed (char *str, float *speed) {
-   return (sscanf (str, "%f", speed) == 1) ? 1:0;
-}
-
-/*!
- * \brief
- *    Read speed units
- * Try to extract speed units from token \a str
- * \param   str   Pointer to token
- * \param   sp_unts Pointer to speed units variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_sp_unts (char *str, nmea_speed_units_en *sp_unts) {
-   char unt;
-   *sp_unts = NMEA_KNOTS;
-   if (sscanf (str, "%c", &unt) != 1)
-      return 0;
-   if (unt == 'K' || unt == 'k')
-      *sp_unts = NMEA_KMH;
-   return 1;
+static void _sen_start (nmea_parser_t *ps)
+{
+   ps->st = _ST_ADDR;
+   ps->cs = ps->rcs = 0;
+   ps->alen = 0;
+   ps->id = NMEA_NULL;
+   ps->format = NULL;
+   ps->tk = 0;
+   memset ((void*)&ps->obj, 0, sizeof (nmea_common_t));
+   ps->obj.fix = NMEA_NOT_FIX;
+   ps->obj.valid = NMEA_NOT_VALID;
+   ps->obj.speed_knt = -1;
+}
+
+//! Reset the field accumulator
+static void _field_start (nmea_parser_t *ps)
+{
+   ps->ip = ps->fp = 0;
+   ps->fd = ps->flen = 0;
+   ps->dot = ps->neg = 0;
+   ps->ch0 = 0;
 }
 
 /*!
  * \brief
- *    Read course
- * Try to extract course from token \a str
- * \param   str   Pointer to token
- * \param   course Pointer to course variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
+ *    Convert the accumulated field, using the grammar of the sentence.
+ *    Empty fields leave the data untouched.
+ * \param   ps    Pointer to parser
  */
-static int _read_course (char *str, float *course) {
-   return (sscanf (str, "%f", course) == 1) ? 1:0;
+static void _field_end (nmea_parser_t *ps)
+{
+   nmea_common_t *obj = &ps->obj;
+   float r, m;
+   int i;
+   char c;
+
+   if (!ps->format || ps->format[ps->tk] == _null || !ps->flen)
+      return;
+
+   i = (int)ps->ip;
+   r = (float)ps->ip + (float)ps->fp * _frac10[ps->fd];
+   if (ps->neg) {
+      i = -i;
+      r = -r;
+   }
+   c = ps->ch0 & ~0x20;    // upper case
+   // NMEA angles are dddmm.mmmm
+   m = (float)(ps->ip % 100) + (float)ps->fp * _frac10[ps->fd];
+
+   switch (ps->format[ps->tk]) {
+      case _fix_t:
+         switch (i) {
+            default:
+            case 0: obj->fix = NMEA_NOT_FIX;  break;
+            case 1: obj->fix = NMEA_FIX;      break;
+            case 2: obj->fix = NMEA_DFIX;     break;
+         }
+         break;
+      case _valid_t:    obj->valid = (c == 'V') ? NMEA_NOT_VALID : NMEA_VALID; break;
+      case _sats:       obj->sats = i;          break;
+      case _utc:
+         obj->time.hour = ps->ip / 10000;
+         obj->time.min = (ps->ip / 100) % 100;
+         obj->time.sec = m;
+         break;
+      case _date:
+         obj->date.day = ps->ip / 10000;
+         obj->date.month = (ps->ip / 100) % 100;
+         obj->date.year = ps->ip % 100 + 2000;
+         break;
+      case _day:        obj->day = i;           break;
+      case _month:      obj->month = i;         break;
+      case _year:       obj->year = i;          break;
+      case _zone_h:     obj->zone_h = i;        break;
+      case _zone_m:     obj->zone_m = i;        break;
+      case _lat:        obj->latitude = (float)(ps->ip / 100) + m/60;   break;
+      case _lat_s:      if (c == 'S') obj->latitude = -obj->latitude;   break;
+      case _long:       obj->longitude = (float)(ps->ip / 100) + m/60;  break;
+      case _long_s:     if (c == 'W') obj->longitude = -obj->longitude; break;
+      case _elev:       obj->elevation = r;     break;
+      case _speed_knt:  obj->speed_knt = r;     break;
+      case _speed_kmh:  obj->speed_kmh = r;     break;
+      case _course_t:   obj->course_t = r;      break;
+      case _course_m:   obj->course_m = r;      break;
+      case _mag_var:    obj->mag_var = r;       break;
+      case _mag_var_s:  if (c == 'W') obj->mag_var = -obj->mag_var;     break;
+
+      case _sp_unts:
+      case _crs_type:
+      case _msgid:
+      case _disc:
+      default:          break;
+   }
 }
 
 /*!
  * \brief
- *    Read course type
- * Try to extract course type from token \a str
- * \param   str   Pointer to token
- * \param   course_type  Pointer to course type variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
+ *    Copy the sentence data to the message of the cache
+ * \param   cache Pointer to cache
+ * \param   id    Sentence id
+ * \param   obj   Pointer to the sentence data
+ * \return        Pointer to the message in cache
  */
-static int _read_course_type (char *str, nmea_course_en *course_type) {
-   char tpe;
-   *course_type = NMEA_COURSE_MAG;
-   if (sscanf (str, "%c", &tpe) != 1)
-      return 0;
-   if (tpe == 'T' || tpe == 't')
-      *course_type = NMEA_COURSE_TRUE;
-   return 1;
+static const void * _store (nmea_cache_t *cache, nmea_msgid_en id, const nmea_common_t *obj)
+{
+   switch (id) {
+      case NMEA_GGA:
+         cache->gga.fix = obj->fix;
+         cache->gga.sats = obj->sats;
+         cache->gga.time = obj->time;
+         cache->gga.latitude = obj->latitude;
+         cache->gga.longitude = obj->longitude;
+         cache->gga.elevation = obj->elevation;
+         return &cache->gga;
+      case NMEA_GLL:
+         cache->gll.valid = obj->valid;
+         cache->gll.time = obj->time;
+         cache->gll.latitude = obj->latitude;
+         cache->gll.longitude = obj->longitude;
+         return &cache->gll;
+      case NMEA_GSA:
+         cache->gsa.crap = 0;
+         return &cache->gsa;
+      case NMEA_GSV:
+         cache->gsv.sats = obj->sats;
+         return &cache->gsv;
+      case NMEA_RMC:
+         cache->rmc.valid = obj->valid;
+         cache->rmc.date = obj->date;
+         cache->rmc.time = obj->time;
+         cache->rmc.latitude = obj->latitude;
+         cache->rmc.longitude = obj->longitude;
+         cache->rmc.speed_knt = obj->speed_knt;
+         cache->rmc.course_t = obj->course_t;
+         cache->rmc.mag_var = obj->mag_var;
+         return &cache->rmc;
+      case NMEA_VTG:
+         cache->vtg.course_m = obj->course_m;
+         cache->vtg.course_t = obj->course_t;
+         cache->vtg.speed_knt = obj->speed_knt;
+         cache->vtg.speed_kmh = obj->speed_kmh;
+         return &cache->vtg;
+      case NMEA_ZDA:
+         cache->zda.time = obj->time;
+         cache->zda.day = obj->day;
+         cache->zda.month = obj->month;
+         cache->zda.year = obj->year;
+         cache->zda.zone_h = obj->zone_h;
+         cache->zda.zone_m = obj->zone_m;
+         return &cache->zda;
+      default:
+         return NULL;
+   }
 }
 
 /*!
  * \brief
- *    Read Magnetic variation
- * Try to extract magnetic variation from token \a str
- * \param   str   Pointer to token
- * \param   mag_var Pointer to magnetic variation variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
+ *    Complete a sentence after the checksum. A valid sentence updates
+ *    the cache and calls its callback.
+ * \param   nmea  Pointer to linked nmea data to use
+ * \return        The result
+ *    \arg  1     Valid sentence
+ *    \arg  -1    Checksum error
  */
-static int _read_mag_var (char *str, float *mag_var) {
-   return (sscanf (str, "%f", mag_var) == 1) ? 1:0;
-}
+static int _sen_end (nmea_t *nmea)
+{
+   nmea_parser_t *ps = &nmea->ps;
+   const void *msg;
 
-/*!
- * \brief
- *    Read Magnetic variation orientation
- * Try to extract magnetic variation sign from token \a str
- * \param   str   Pointer to token
- * \param   mag_var_s Pointer to magnetic variation variable sign to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_mag_var_s (char *str, nmea_long_sign_en *mag_var_s) {
-   char tpe;
-   *mag_var_s = NMEA_E;
-   if (sscanf (str, "%c", &tpe) != 1)
-      return 0;
-   if (tpe == 'W' || tpe == 'w')
-      *mag_var_s = NMEA_W;
+   ps->st = _ST_IDLE;
+   if (ps->cs != ps->rcs) {
+      ++nmea->errors;
+      return -1;
+   }
+   ++nmea->sentences;
+   if ((msg = _store (&nmea->cache, ps->id, &ps->obj)) != NULL) {
+      nmea->cache.updated |= 1UL << ps->id;
+      if (nmea->cb[ps->id])
+         nmea->cb[ps->id] (nmea, ps->id, msg);
+   }
    return 1;
 }
 
 /*!
  * \brief
- *    Read satellites
- * Try to extract satellites from token \a str
- * \param   str   Pointer to token
- * \param   sats  Pointer to satellites variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
+ *    Feed one character to the stream parser. The checksum is calculated
+ *    and the fields are converted in place, so the sentence is never stored.
+ *    A '$' always starts a new sentence, so the parser re-synchronises
+ *    on broken sentences.
+ * \param   nmea  Pointer to linked nmea data to use
+ * \param   c     The character
+ * \return        The result
+ *    \arg  0     Sentence in progress
+ *    \arg  1     Valid sentence completed
+ *    \arg  -1    Checksum error or broken sentence
  */
-static int _read_sats (char *str, int *sats) {
-   return (sscanf (str, "%d", sats) == 1) ? 1:0;
-}
+static int _parse (nmea_t *nmea, byte_t c)
+{
+   nmea_parser_t *ps = &nmea->ps;
+   int h;
+
+   if (c == '$') {
+      h = (ps->st != _ST_IDLE) ? -1 : 0;
+      if (h)
+         ++nmea->errors;
+      _sen_start (ps);
+      return h;
+   }
+   switch (ps->st) {
+      case _ST_IDLE:
+         return 0;
+
+      case _ST_FIELD:
+         if (c >= '0' && c <= '9') {
+            if (!ps->dot)
+               ps->ip = ps->ip*10 + (c - '0');
+            else if (ps->fd < NMEA_MAX_FRAC_DIGITS) {
+               ps->fp = ps->fp*10 + (c - '0');
+               ++ps->fd;
+            }
+         }
+         else if (c == ',') {
+            ps->cs ^= c;
+            _field_end (ps);
+            if (ps->format && ps->format[ps->tk] != _null)
+               ++ps->tk;
+            _field_start (ps);
+            return 0;
+         }
+         else if (c == '*') {
+            _field_end (ps);
+            ps->st = _ST_CS_HI;
+            return 0;
+         }
+         else if (c == '.')   ps->dot = 1;
+         else if (c == '-')   ps->neg = 1;
+         else if (c < ' ' || c > '~')
+            break;
+         ps->cs ^= c;
+         if (!ps->flen)
+            ps->ch0 = c;
+         if (ps->flen < 0xFF)
+            ++ps->flen;
+         return 0;
+
+      case _ST_ADDR:
+         if (c == ',' || c == '*') {
+            if (ps->alen >= 3 && ps->alen < sizeof (ps->addr)) {
+               ps->addr[ps->alen] = 0;
+               ps->id = _msgid_type (&ps->addr[ps->alen - 3]);
+               ps->format = _grammar[ps->id];
+            }
+            ps->tk = 1;
+            _field_start (ps);
+            if (c == '*')
+               ps->st = _ST_CS_HI;
+            else {
+               ps->cs ^= c;
+               ps->st = _ST_FIELD;
+            }
+            return 0;
+         }
+         if (c < ' ' || c > '~')
+            break;
+         ps->cs ^= c;
+         if (ps->alen < sizeof (ps->addr))
+            ps->addr[ps->alen++] = c;
+         return 0;
+
+      case _ST_CS_HI:
+      case _ST_CS_LO:
+         if ((h = _hex (c)) < 0)
+            break;
+         ps->rcs = (ps->rcs << 4) | h;
+         if (ps->st == _ST_CS_HI) {
+            ps->st = _ST_CS_LO;
+            return 0;
+         }
+         return _sen_end (nmea);
 
-/*!
- * \brief
- *    Read fix
- * Try to extract fix from token \a str
- * \param   str   Pointer to token
- * \param   fix   Pointer to fix variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_fix (char *str, nmea_fix_en *fix) {
-   int d;
-   if (sscanf (str, "%d", &d) != 1)
-      return 0;
-   switch (d) {
       default:
-      case 0: *fix = NMEA_NOT_FIX;  return 1;
-      case 1: *fix = NMEA_FIX;      return 1;
-      case 2: *fix = NMEA_DFIX;     return 1;
+         break;
    }
-}
-
-/*!
- * \brief
- *    Read valid
- * Try to extract valid from token \a str
- * \param   str   Pointer to token
- * \param   valid Pointer to valid variable to return
- * \return        The status of the operation
- *    \arg  0     Not recognised id = NULL
- *    \arg  1     Recognised
- */
-static int _read_valid (char *str, nmea_valid_en *valid) {
-   char v;
-   *valid = NMEA_VALID;
-   if (sscanf (str, "%c", &v) != 1)
-      return 0;
-   if (v == 'V' || v == 'v')
-      *valid = NMEA_NOT_VALID;
-   return 1;
+   // Broken sentence
+   ps->st = _ST_IDLE;
+   ++nmea->errors;
+   return -1;
 }
 
 
-
 /*
  * ============== Middle level ==============
  */
 
-/*!
- * \brief
- *    Read a sentence from input stream into nmea's buffer
- * \param   nmea  Pointer to linked data to use
- * \return        The size of string in buffer
- */
-static int _get_sen (nmea_t *nmea)
-{
-   int i=0, st=0;
-   char ch;
-
-   do {
-      ch = nmea->io.in ();
-      if (ch == '$') { st = 1; i=0; }
-      if (st)        nmea->buf[i++] = ch;
-   }while (ch != '\n' && ch != 0 && i<nmea->buf_size);
-   nmea->buf[i] = 0;
-   return i;
-}
-
-/*!
- * \brief
- *    Get the next token from string
- * \param   str   Pointer to string to search into
- * \param   token Pointer to token to return
- * \return        The size of token
- */
-static int _get_token (char *str, char *token)
-{
-   char *s = str;
-   while (1) {
-      if (NMEA_IS_DELIMITER (*s)) {
-         ++s;
-         *token = 0;
-         return s - str;   // eat next delimiter
-      }
-      else
-         *token++ = *s++;
-   }
-   return 0;
-}
-
-/*!
- * \brief
- *    Check the checksum of a sentence
- * \param   str   Pointer to hole sentence (from '$' to "\r\n")
- * \return        The result
- *    \arg  0     Checksum don't match
- *    \arg  1     Checksum match
- */
-static int _checksum_chk (char *str)
-{
-   char *s, *d;   // Star and dollar pointers
-   int sc, cc;    // string and calculated checksum
-
-   d = strchr (str, '$');  // find where is '$'
-   s = strchr (d, '*');    // find where is '*'
-
-   sscanf (s, "*%2X\r\n", &sc);
-   for (cc=0,++d ; d<s ; ++d)
-      cc ^= *d;
-
-   return (cc == sc) ? 1:0;
-}
-
 /*!
  * \brief
  *    Read from input stream until a checksum valid sentence
- *    with id \a id appears.
+ *    with id \a id appears. All the other sentences update the cache
+ *    and call their callbacks, so nothing in the stream is lost.
+ *    An unread sentence already in cache returns immediately.
  * \param   nmea  Pointer to linked nmea data to use
  * \param   id    The desired message id sentence
  * \return        The status of the operation
- *    \arg  0     Fail
+ *    \arg  0     Fail, no input or NMEA_WAIT_MAX_TRIES other sentences
  *    \arg  1     Success
  */
 static int _read_until (nmea_t *nmea, nmea_msgid_en id)
 {
-   nmea_msgid_en s=NMEA_NULL;
-
-   _get_sen (nmea);
-   if ( !_checksum_chk ((char *)nmea->buf) )
-      return 0;
-   _read_sen_type ((char *)nmea->buf, &s);
-
-   if (s == id)   return 1;
-   else           return 0;
-}
-
-/*!
- * \brief
- *    Extract nmea data from sentence into buffer using grammar in \a format
- * \param   nmea  Pointer to linked data to use
- * \param   format Pointer to grammar array to use
- * \param   obj   Pointer to data object to return
- * \return        Number or read tokens
- */
-static int _tokenise (nmea_t *nmea, const parse_obj_en *format, nmea_common_t *obj)
-{
-   char token[NMEA_TOKEN_SIZE];
-   int cur, tk, sign=1;
-
-   for (cur=0, tk=0 ; format[tk] != _null ; ++tk) {
-      cur += _get_token ((char*)nmea->buf+cur, token);
-      switch (format[tk]) {
-         case _fix_t:      _read_fix (token, &obj->fix);          break;
-         case _valid_t:    _read_valid (token, &obj->valid);      break;
-         case _sats:       _read_sats (token, &obj->sats);        break;
-         case _utc:        _read_utc (token, &obj->time);         break;
-         case _date:       _read_date (token, &obj->date);        break;
-         case _day:        _read_day (token, &obj->day);          break;
-         case _month:      _read_month (token, &obj->month);      break;
-         case _year:       _read_year (token, &obj->year);        break;
-         case _zone_h:     _read_zone_h (token, &obj->zone_h);    break;
-         case _zone_m:     _read_zone_m (token, &obj->zone_m);    break;
-         case _lat:        _read_lat (token, &obj->latitude);     break;
-         case _lat_s:      _read_lat_s (token, (nmea_lat_sign_en*)&sign);
-                           obj->latitude *= sign;
-                           break;
-         case _long:       _read_long (token, &obj->longitude);   break;
-         case _long_s:     _read_long_s (token, (nmea_long_sign_en*)&sign);
-                           obj->longitude *= sign;
-                           break;
-         case _elev:       _read_elev (token, &obj->elevation);   break;
-         case _speed_knt:  _read_speed (token, &obj->speed_knt);  break;
-         case _speed_kmh:  _read_speed (token, &obj->speed_kmh);  break;
-         case _sp_unts:    break;
-         case _course_t:   _read_course (token, &obj->course_t);  break;
-         case _course_m:   _read_course (token, &obj->course_m);  break;
-         case _crs_type:   break;
-         case _mag_var:    _read_mag_var (token, &obj->mag_var);  break;
-         case _mag_var_s:  _read_mag_var_s (token, (nmea_long_sign_en*)&sign);
-                           obj->mag_var *= sign;
-                           break;
-
-         case _msgid:      break;
-         case _disc:       break;
-         default:          break;
-      }
+   uint32_t bit = 1UL << id;
+   byte_t ch;
+   int tries = 0;
+
+   while (!(nmea->cache.updated & bit) && tries < NMEA_WAIT_MAX_TRIES) {
+      if ((ch = nmea->io.in ()) == 0)
+         break;
+      if (_parse (nmea, ch))
+         ++tries;
    }
-   return tk;
+   if (!(nmea->cache.updated & bit))
+      return 0;
+   nmea->cache.updated &= ~bit;
+   return 1;
 }
 
 /*!
@@ -768,7 +546,7 @@ static int _tokenise (nmea_t *nmea, const parse_obj_en *format, nmea_common_t *o
  * \param   nmea  Pointer to linked data to use
  * \param   str   Pointer to string to stream
  */
-void _stream (nmea_t *nmea, char *str)
+static void _stream (nmea_t *nmea, char *str)
 {
    while (*str)
       nmea->io.out (*str++);
@@ -786,23 +564,20 @@ void _stream (nmea_t *nmea, char *str)
  *    DO NOT CALL this function
  */
 void mnea_unused (void) {
-   char tmp [2] = "0";
-
    tbx_unused (_dec2nmea (0));
    tbx_unused (_msgid_str (NMEA_NULL));
-   tbx_unused (_msgid_type (tmp));
-   tbx_unused (_read_course_type (tmp, NMEA_COURSE_TRUE));
-   tbx_unused (_read_sp_unts (tmp, NMEA_KNOTS));
 }
 /*
  * ========= Link and Glue functions ==============
  */
 
 /*!
- * Link buffer to nmea data
+ * Link buffer to nmea data. The stream parser does not store the
+ * sentences, kept for compatibility, it does nothing.
  */
 void nmea_link_buffer (nmea_t *nmea, byte_t *b) {
-   nmea->buf = b;
+   tbx_unused (nmea);
+   tbx_unused (b);
 }
 /*!
  * Link input function to nmea data
@@ -816,6 +591,13 @@ void nmea_link_in (nmea_t *nmea, nmea_in_ft in) {
 void nmea_link_out (nmea_t *nmea, nmea_out_ft out) {
    nmea->io.out = out;
 }
+/*!
+ * Link a callback for the sentences with id \a id, or NULL to remove it
+ */
+void nmea_link_callback (nmea_t *nmea, nmea_msgid_en id, nmea_cb_ft cb) {
+   if (id > NMEA_NULL && id < NMEA_MSGID_NUM)
+      nmea->cb[id] = cb;
+}
 
 
 /*
@@ -823,10 +605,11 @@ void nmea_link_out (nmea_t *nmea, nmea_out_ft out) {
  */
 
 /*!
- * Set buffer size
+ * Set buffer size. Kept for compatibility, it does nothing.
  */
 void nmea_set_buffer_size (nmea_t *nmea, int s) {
-   nmea->buf_size = s;
+   tbx_unused (nmea);
+   tbx_unused (s);
 }
 
 
@@ -869,6 +652,27 @@ drv_status_en nmea_init (nmea_t *nmea)
    #undef _bad_link
 }
 
+/*!
+ * \brief
+ *    Push received data to the stream parser. The data can be any
+ *    part of the stream, ex: a DMA or UART buffer, and the sentences can
+ *    be split across calls. Every checksum valid sentence updates the
+ *    cache and calls its callback, from within this function.
+ * \param   nmea  Pointer to linked nmea data struct to use
+ * \param   buf   Pointer to the received data
+ * \param   len   The size of the data
+ * \return        The number of valid sentences completed
+ */
+int nmea_feed (nmea_t *nmea, const byte_t *buf, int len)
+{
+   int n = 0;
+
+   while (len-- > 0)
+      if (_parse (nmea, *buf++) > 0)
+         ++n;
+   return n;
+}
+
 /*!
  * \brief
  *    Read and extract GGA data from input stream
@@ -882,21 +686,12 @@ drv_status_en nmea_init (nmea_t *nmea)
  */
 drv_status_en nmea_read_gga (nmea_t *nmea, nmea_gga_t *gga)
 {
-   nmea_common_t obj;
-
-   obj.fix = NMEA_NOT_FIX;                         // mark data
    if (_read_until (nmea, NMEA_GGA) == 0)          // Read next sentences
       return DRV_ERROR;
-   _tokenise (nmea, _GGA, &obj);                   // tokenise
 
    // Check to return
-   if (obj.fix != NMEA_NOT_FIX) {
-      gga->fix = obj.fix;
-      gga->sats = obj.sats;
-      gga->time = obj.time;
-      gga->latitude = obj.latitude;
-      gga->longitude = obj.longitude;
-      gga->elevation = obj.elevation;
+   if (nmea->cache.gga.fix != NMEA_NOT_FIX) {
+      *gga = nmea->cache.gga;
       return DRV_READY;
    }
    else
@@ -916,19 +711,12 @@ drv_status_en nmea_read_gga (nmea_t *nmea, nmea_gga_t *gga)
  */
 drv_status_en nmea_read_gll (nmea_t *nmea, nmea_gll_t *gll)
 {
-   nmea_common_t obj;
-
-   obj.valid = NMEA_NOT_VALID;                     // mark data
    if (_read_until (nmea, NMEA_GLL) == 0)          // Read next sentences
       return DRV_ERROR;
-   _tokenise (nmea, _GLL, &obj);                   // tokenise
 
    // Check to return
-   if (obj.valid != NMEA_NOT_VALID) {
-      gll->valid = obj.valid;
-      gll->time = obj.time;
-      gll->latitude = obj.latitude;
-      gll->longitude = obj.longitude;
+   if (nmea->cache.gll.valid != NMEA_NOT_VALID) {
+      *gll = nmea->cache.gll;
       return DRV_READY;
    }
    else
@@ -948,14 +736,11 @@ drv_status_en nmea_read_gll (nmea_t *nmea, nmea_gll_t *gll)
  */
 drv_status_en nmea_read_gsa (nmea_t *nmea, nmea_gsa_t *gsa)
 {
-   nmea_common_t obj;
-
    // Read sentences until we find GSA
    if (_read_until (nmea, NMEA_GSA) == 0)    // Read next sentences
       return DRV_ERROR;
-   _tokenise (nmea, _GSA, &obj);             // tokenise
 
-   gsa->crap = 0;
+   *gsa = nmea->cache.gsa;
    return DRV_READY;
 }
 
@@ -972,16 +757,12 @@ drv_status_en nmea_read_gsa (nmea_t *nmea, nmea_gsa_t *gsa)
  */
 drv_status_en nmea_read_gsv (nmea_t *nmea, nmea_gsv_t *gsv)
 {
-   nmea_common_t obj;
-
-   obj.sats = 0;                                   // mark data
    if (_read_until (nmea, NMEA_GSV) == 0)          // Read next sentences
       return DRV_ERROR;
-   _tokenise (nmea, _GSV, &obj);                   // tokenise
 
    // Check to return
-   if (obj.sats != 0) {
-      gsv->sats = obj.sats;
+   if (nmea->cache.gsv.sats != 0) {
+      *gsv = nmea->cache.gsv;
       return DRV_READY;
    }
    else
@@ -1001,23 +782,12 @@ drv_status_en nmea_read_gsv (nmea_t *nmea, nmea_gsv_t *gsv)
  */
 drv_status_en nmea_read_rmc (nmea_t *nmea, nmea_rmc_t *rmc)
 {
-   nmea_common_t obj;
-
-   obj.valid = NMEA_NOT_VALID;                     // mark data
    if (_read_until (nmea, NMEA_RMC) == 0)          // Read next sentences
       return DRV_ERROR;
-   _tokenise (nmea, _RMC, &obj);                   // tokenise
 
    // Check to return
-   if (obj.valid != NMEA_NOT_VALID) {
-      rmc->valid = obj.valid;
-      rmc->date = obj.date;
-      rmc->time = obj.time;
-      rmc->latitude = obj.latitude;
-      rmc->longitude = obj.longitude;
-      rmc->speed_knt = obj.speed_knt;
-      rmc->course_t = obj.course_t;
-      rmc->mag_var = obj.mag_var;
+   if (nmea->cache.rmc.valid != NMEA_NOT_VALID) {
+      *rmc = nmea->cache.rmc;
       return DRV_READY;
    }
    else
@@ -1036,18 +806,12 @@ drv_status_en nmea_read_rmc (nmea_t *nmea, nmea_rmc_t *rmc)
  */
 drv_status_en nmea_read_vtg (nmea_t *nmea, nmea_vtg_t *vtg)
 {
-   nmea_common_t obj;
-
-   obj.speed_knt = -1;                             // mark data
    if (_read_until (nmea, NMEA_VTG) == 0)          // Read next sentences
       return DRV_ERROR;
-   _tokenise (nmea, _VTG, &obj);                   // tokenise
 
-   if (obj.speed_knt != -1) {
-      vtg->course_m = obj.course_m;
-      vtg->course_t = obj.course_t;
-      vtg->speed_knt = obj.speed_knt;
-      vtg->speed_kmh = obj.speed_kmh;
+   // Check to return
+   if (nmea->cache.vtg.speed_knt != -1) {
+      *vtg = nmea->cache.vtg;
       return DRV_READY;
    }
    else
@@ -1066,20 +830,12 @@ drv_status_en nmea_read_vtg (nmea_t *nmea, nmea_vtg_t *vtg)
  */
 drv_status_en nmea_read_zda (nmea_t *nmea, nmea_zda_t *zda)
 {
-   nmea_common_t obj;
-
-   obj.year = 0;                                   // mark data
    if (_read_until (nmea, NMEA_ZDA) == 0)          // Read next sentences
       return DRV_ERROR;
-   _tokenise (nmea, _ZDA, &obj);                   // tokenise
-
-   if (obj.year != 0) {
-      zda->time = obj.time;
-      zda->day = obj.day;
-      zda->month = obj.month;
-      zda->year = obj.year;
-      zda->zone_h = obj.zone_h;
-      zda->zone_m = obj.zone_m;
+
+   // Check to return
+   if (nmea->cache.zda.year != 0) {
+      *zda = nmea->cache.zda;
       return DRV_READY;
    }
    else
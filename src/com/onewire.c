@@ -0,0 +1,325 @@
+/*!
+ * \file onewire.c
+ * \brief
+ *    A target and bus driver independent 1-Wire ROM search. The search state
+ *    lives in a user object, so any number of buses can be searched at the
+ *    same time.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2016 Choutouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <com/onewire.h>
+
+/*
+ * ========= Private helper macros ===========
+ */
+
+#define  _rom_bit(_rom_, _bit_)        (((_rom_)[(_bit_)/8] >> ((_bit_)%8)) & 0x01)
+#define  _set_rom_bit(_rom_, _bit_, _v_)                    \
+   do {                                                     \
+      if (_v_) (_rom_)[(_bit_)/8] |=   1 << ((_bit_)%8);    \
+      else     (_rom_)[(_bit_)/8] &= ~(1 << ((_bit_)%8));   \
+   } while (0)
+
+/*
+ * ============= Private functions ===========
+ */
+static drv_status_en _set_speed (ow_bus_t *bus, uint32_t speed);
+
+/*!
+ * \brief
+ *    Set the bus driver speed
+ */
+static drv_status_en _set_speed (ow_bus_t *bus, uint32_t speed) {
+   return bus->ioctl (bus->ow, CTRL_SET_SPEED, (ioctl_buf_t)&speed);
+}
+
+
+/*
+ *  ============= PUBLIC 1-Wire API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+
+/*!
+ * \brief   link the 1-wire bus driver data
+ * \param   bus   Pointer to the bus links
+ * \param   ow    Pointer to the 1-wire driver data, ex: ow_uart_t
+ */
+void ow_link_ow (ow_bus_t *bus, void *ow) {
+   bus->ow = ow;
+}
+/*!
+ * \brief   link the 1-wire byte write function
+ */
+void ow_link_tx (ow_bus_t *bus, ow_tx_ft fun) {
+   bus->tx = fun;
+}
+/*!
+ * \brief   link the 1-wire search triplet function
+ */
+void ow_link_triplet (ow_bus_t *bus, ow_triplet_ft fun) {
+   bus->triplet = fun;
+}
+/*!
+ * \brief   link the 1-wire ioctl function
+ */
+void ow_link_ioctl (ow_bus_t *bus, ow_ioctl_ft fun) {
+   bus->ioctl = fun;
+}
+
+/*
+ * User Functions
+ */
+
+/*!
+ * \brief
+ *    Initialize a search state. The next \sa ow_search() starts
+ *    from the first device.
+ *
+ * \param   s        Pointer to the search state
+ * \param   cmd      The search command
+ *    \arg  OW_CMD_SEARCH_ROM    All the devices
+ *    \arg  OW_CMD_SEARCH_ALARM  The devices with an alarm condition
+ * \param   family   Family code of the devices to find, or OW_FAMILY_ANY
+ */
+void ow_search_init (ow_search_t *s, byte_t cmd, byte_t family)
+{
+   memset ((void*)s, 0, sizeof (ow_search_t));
+   s->cmd = cmd;
+   s->family = family;
+}
+
+/*!
+ * \brief
+ *    1-Wire search algorithm based on maxim-ic application note 187.
+ *    Each call is one search pass and finds one device. The devices are
+ *    found in ascending \sa ow_rom_cmp() order.
+ *
+ *    For the family code filtering the first pass follows the family code
+ *    path and the search stops when the next pass would leave it.
+ *
+ * \param   bus      Pointer to the bus links
+ * \param   s        Pointer to the search state
+ * \param   romid    Pointer to romid to return. If the search is success
+ *                   this points to and 64bit long array with ROM ID
+ * \return  The status of the search
+ *    \arg  DRV_NODEV (-1) Search was failed, No device found
+ *    \arg  DRV_READY (1)  Search is complete, all ROM IDs was found. This was the last
+ *    \arg  DRV_BUSY  (2)  Search is succeed, plus there are more ROM IDs to found
+ *    \arg  DRV_ERROR (3)  Search failed, Reading or CRC error
+ * \note
+ *    After DRV_READY, DRV_NODEV or DRV_ERROR the state starts a new search.
+ */
+drv_status_en ow_search (ow_bus_t *bus, ow_search_t *s, byte_t *romid)
+{
+   uint8_t  i, dir, r, last_zero;
+
+   if (!s->last && s->family) {
+      /*
+       * Target setup, follow the family code and then the 0s
+       */
+      memset ((void*)s->rom, 0, OW_ROM_SIZE);
+      s->rom[0] = s->family;
+      s->last = OW_ROM_BITS + 1;
+   }
+   if (bus->ioctl (bus->ow, CTRL_RESET, 0) != DRV_READY) {
+      s->last = 0;
+      return DRV_NODEV;
+   }
+   bus->tx (bus->ow, (s->cmd) ? s->cmd : OW_CMD_SEARCH_ROM);
+
+   for (i=0, last_zero=0 ; i<OW_ROM_BITS ; ++i) {
+      /*
+       * The direction in case of discrepancy
+       *  bit < last:  The path of the previous pass
+       *  bit == last: The 0 path was taken in the previous pass, take the 1
+       *  bit > last:  New discrepancy, take 0
+       */
+      if (i+1 < s->last)   dir = _rom_bit (s->rom, i);
+      else                 dir = (i+1 == s->last) ? 1:0;
+
+      r = bus->triplet (bus->ow, dir);
+      if ((r & (OW_TRIPLET_ID | OW_TRIPLET_CMP)) == (OW_TRIPLET_ID | OW_TRIPLET_CMP)) {
+         /* 11 - No device on the bus */
+         s->last = 0;
+         return DRV_NODEV;
+      }
+      if (!(r & (OW_TRIPLET_ID | OW_TRIPLET_CMP)) && !(r & OW_TRIPLET_DIR))
+         last_zero = i+1;     /* 00 - discrepancy and we took the 0 */
+      _set_rom_bit (s->rom, i, r & OW_TRIPLET_DIR);
+   }
+
+   if (CRC8_buffer (CRC8_Maxim_rev, CRC_LSB, 0, s->rom, OW_ROM_SIZE) != 0) {
+      s->last = 0;
+      return DRV_ERROR;
+   }
+   if (s->family && s->rom[0] != s->family) {
+      s->last = 0;
+      return DRV_NODEV;
+   }
+   memcpy ((void*)romid, (const void*)s->rom, OW_ROM_SIZE);
+
+   /*
+    * A discrepancy in the family code bits, leaves the family
+    */
+   if (s->family && last_zero <= 8)
+      last_zero = 0;
+   s->last = last_zero;
+   return (last_zero) ? DRV_BUSY : DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Find all the devices on a bus.
+ *
+ *    On overdrive speed all the devices switch to overdrive with an
+ *    overdrive skip ROM command. The devices without overdrive support
+ *    do not answer to the overdrive resets and are not found. At the end
+ *    the bus returns to standard speed.
+ *
+ * \param   bus      Pointer to the bus links
+ * \param   cmd      The search command
+ *    \arg  OW_CMD_SEARCH_ROM    All the devices
+ *    \arg  OW_CMD_SEARCH_ALARM  The devices with an alarm condition
+ * \param   family   Family code of the devices to find, or OW_FAMILY_ANY
+ * \param   speed    The speed for the search
+ *    \arg  OW_T_STANDARD
+ *    \arg  OW_T_OVERDRIVE
+ * \param   table    Pointer to a ROM id table to fill. The ROMs are in
+ *                   ascending \sa ow_rom_cmp() order for \sa ow_rom_find()
+ * \param   size     The table size
+ * \return  The number of the devices found, up to size, or -1 on bus error
+ */
+int ow_enumerate (ow_bus_t *bus, byte_t cmd, byte_t family, uint32_t speed, ow_rom_t *table, int size)
+{
+   ow_enum_t op;
+
+   memset ((void*)&op, 0, sizeof (ow_enum_t));
+   while (ow_enumerate_async (bus, &op, cmd, family, speed, table, size) == PT_PENDING)
+      ;
+   return op.n;
+}
+
+/*!
+ * \brief
+ *    Non blocking \see ow_enumerate(). It returns DRV_BUSY after each
+ *    device found, and it has to be called again with the same arguments
+ *    until it returns the status. Each call is at most one search pass,
+ *    so the CPU is free for the others between the devices.
+ *
+ * \param   bus      Pointer to the bus links
+ * \param   op       Pointer to the operation state, zero before the first call.
+ *                   op->n is the number of the devices found, up to size,
+ *                   or -1 on bus error
+ * \param   cmd      The search command
+ * \param   family   Family code of the devices to find, or OW_FAMILY_ANY
+ * \param   speed    The speed for the search
+ * \param   table    Pointer to a ROM id table to fill
+ * \param   size     The table size
+ * \return  The status of the operation
+ *    \arg  DRV_BUSY    Pending, call again
+ *    \arg  DRV_READY   Done, also with no devices
+ *    \arg  DRV_ERROR   Bus error
+ */
+drv_status_en ow_enumerate_async (ow_bus_t *bus, ow_enum_t *op, byte_t cmd, byte_t family, uint32_t speed, ow_rom_t *table, int size)
+{
+   PT_BEGIN (&op->pt);
+   op->n = 0;
+   if (speed == OW_T_OVERDRIVE) {
+      if (_set_speed (bus, OW_T_STANDARD) != DRV_READY) {
+         op->n = -1;
+         PT_EXIT (&op->pt, DRV_ERROR);
+      }
+      if (bus->ioctl (bus->ow, CTRL_RESET, 0) != DRV_READY)
+         PT_EXIT (&op->pt, DRV_READY);
+      bus->tx (bus->ow, OW_CMD_OD_SKIP_ROM);
+      if (_set_speed (bus, OW_T_OVERDRIVE) != DRV_READY) {
+         op->n = -1;
+         PT_EXIT (&op->pt, DRV_ERROR);
+      }
+   }
+
+   ow_search_init (&op->s, cmd, family);
+   for (op->st = DRV_BUSY ; op->n<size && op->st == DRV_BUSY ; ) {
+      op->st = ow_search (bus, &op->s, table[op->n]);
+      if (op->st == DRV_BUSY || op->st == DRV_READY)
+         ++op->n;
+      else if (op->st != DRV_NODEV)
+         op->n = -1;
+      if (op->st == DRV_BUSY && op->n < size)
+         PT_YIELD (&op->pt);
+   }
+
+   if (speed == OW_T_OVERDRIVE) {
+      /* A standard reset returns all the devices to standard speed */
+      _set_speed (bus, OW_T_STANDARD);
+      bus->ioctl (bus->ow, CTRL_RESET, 0);
+   }
+   PT_EXIT (&op->pt, (op->n < 0) ? DRV_ERROR : DRV_READY);
+   PT_END (&op->pt);
+}
+
+/*!
+ * \brief
+ *    Compare two ROM ids in the order of the search, the bit 0 of
+ *    the family code first.
+ * \return  The comparison result
+ *    \arg  0     ROMs are equal
+ *    \arg  1     r1 is found after r2
+ *    \arg  -1    r1 is found before r2
+ */
+int ow_rom_cmp (const byte_t *r1, const byte_t *r2)
+{
+   byte_t d;
+   int i;
+
+   for (i=0 ; i<OW_ROM_SIZE ; ++i) {
+      if ((d = r1[i] ^ r2[i]) != 0)
+         return (r1[i] & d & -d) ? 1 : -1;
+   }
+   return 0;
+}
+
+/*!
+ * \brief
+ *    Find a ROM id in an enumerated table
+ *
+ * \param   table    Pointer to the ROM id table from \sa ow_enumerate()
+ * \param   n        The number of the ROMs in the table
+ * \param   romid    The ROM id to find
+ * \return  The table index or -1 if the ROM is not in the table
+ */
+int ow_rom_find (const ow_rom_t *table, int n, const byte_t *romid)
+{
+   int lo = 0, hi = n-1, m, c;
+
+   while (lo <= hi) {
+      m = (lo + hi) / 2;
+      if ((c = ow_rom_cmp (table[m], romid)) == 0)
+         return m;
+      else if (c < 0)   lo = m+1;
+      else              hi = m-1;
+   }
+   return -1;
+}
+
+#undef  _rom_bit
+#undef  _set_rom_bit
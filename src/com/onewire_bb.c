@@ -61,82 +61,14 @@
       _ow_->io.dir_state = drv_pin_input; \
    } while (0)
 
-/*!
- * Clear a virtual 64bit unsigned register.
- * \note
- *    We use a uint8_t array[8] to represent that kind
- *    of data for this module
- * \param   _reg  Pointer to register location. Usual the name of
- *                The array
- */
-#define  _clear_u64(_reg_)                      \
-   memset ((void*)(_reg_), 0, 8*sizeof(uint8_t))
-
-/*!
- * Read a bit value of a virtual 64bit unsigned register.
- * \note
- *    We use a uint8_t array[8] to represent that kind
- *    of data for this module
- * \param   _reg  Pointer to register location. Usual the name of
- *                The array
- * \param   _bit  The bit location we want to read
- */
-#define  _read_bit_u64(_reg_, _bit_)            \
-   (_reg_[(_bit_)/8] & (1<<((_bit_)%8))) ? 1:0
-
-/*!
- * Write/modify a bit value from a virtual 64bit unsigned register.
- * \note
- *    We use a uint8_t array[8] to represent that kind
- *    of data for this module
- * \param   _reg  Pointer to register location. Usual the name of
- *                The array
- * \param   _bit  The bit location we want to set
- * \param   _v    The value we want to set
- *    \arg  0     Set to zero
- *    \arg  !0    Set to One
- */
-#define  _write_bit_u64(_reg_, _bit_, _v_)               \
-   do {                                                  \
-      if (_v_) _reg_[(_bit_)/8] |=   1 << ((_bit_)%8);   \
-      else     _reg_[(_bit_)/8] &= ~(1 << ((_bit_)%8));  \
-   } while (0)
-
 /*
  * ============= Private functions ===========
  */
-/* Data manipulation functions */
-static int _cmp_u64 (uint8_t *reg1, uint8_t *reg2);
-
 /* Bus functions */
 static void _write_bit (ow_bb_t *ow, uint8_t b);
 static uint8_t _read_bit (ow_bb_t *ow);
 
 
-/*!
- * \brief
- *    Compare two 64bit virtual unsigned registers
- * \note
- *    We use a uint8_t array[8] to represent that kind
- *    of data for this module
- * \param   reg1  Pointer to first register location. Usual the name of
- *                the array
- * \param   reg1  Pointer to 2nd register location. Usual the name of
- *                the array
- * \return  The comparison result
- *    \arg  0     Registers are equal
- *    \arg  1     Register 1 is larger than register 2
- *    \arg  -1    Register 2 is larger than register 1
- */
-static __O3__ int _cmp_u64 (uint8_t *reg1, uint8_t *reg2) {
-   uint8_t i;
-   for (i=7 ; i>=0 ; --i) {
-      if (reg1[i] > reg2[i])        return 1;   /* reg1 > reg2 */
-      else if (reg1[i] < reg2[i])   return -1;  /* reg1 < reg2 */
-   }
-   return 0;   /* reg1 equal reg2 */
-}
-
 /*!
  * \brief
  *    Send a 1-Wire write bit and provide the recovery time
@@ -449,13 +381,39 @@ uint8_t  ow_bb_rw (ow_bb_t *ow, byte_t byte)
        * If the bit is 0, we can not read the slave response so we just write-0
        */
    }
-   return byte;
+   return ret;
+}
+
+/*!
+ * \brief
+ *    1-Wire search triplet. Read the ROM bit and its complement and
+ *    write the search direction.
+ * \param  ow    Pointer to select 1-Wire structure for the operation.
+ * \param  dir   The direction to take if there is a discrepancy
+ * \return  The OW_TRIPLET_ID, OW_TRIPLET_CMP and OW_TRIPLET_DIR bits
+ */
+uint8_t ow_bb_triplet (ow_bb_t *ow, uint8_t dir)
+{
+   uint8_t  r;
+
+   r  = (_read_bit (ow)) ? OW_TRIPLET_ID : 0;
+   r |= (_read_bit (ow)) ? OW_TRIPLET_CMP : 0;
+   switch (r) {
+      case 0:              if (dir) r |= OW_TRIPLET_DIR;  break;   /* discrepancy */
+      case OW_TRIPLET_ID:  r |= OW_TRIPLET_DIR;           break;   /* all 1s */
+      case OW_TRIPLET_CMP:                                break;   /* all 0s */
+      default:             return r;                               /* no device */
+   }
+   _write_bit (ow, (r & OW_TRIPLET_DIR) ? 1:0);
+   return r;
 }
 
 
 /*!
  * \brief
- *    1-Wire search algorithm based on maxim-ic application note 187
+ *    1-Wire search algorithm based on maxim-ic application note 187.
+ *    Each call finds the next device. The search state is kept in the
+ *    driver's data, see \sa ow_search() and \sa ow_enumerate().
  *
  * \param   ow       Pointer to select 1-Wire structure for the operation.
  * \param   romid    Pointer to romid to return. If the search is success
@@ -468,84 +426,13 @@ uint8_t  ow_bb_rw (ow_bb_t *ow, byte_t byte)
  */
 drv_status_en ow_bb_search (ow_bb_t *ow, uint8_t *romid)
 {
-   static uint8_t dec[8];  /*!<
-                            * Hold the algorithm's select bit when a discrepancy
-                            * is detected. We use this variable to navigate to the
-                            * ROM tree as we store the path we take each time (0-1).
-                            * Each bit represent a bit position in the ROM ID.
-                            */
-   static uint8_t pos[8];  /*!<
-                            * Hold the discrepancy position. We use this variable to
-                            * navigate to the ROM tree as we store the crossroads(1) we encounter.
-                            * Each bit represent a bit position in the ROM ID.
-                            */
-   uint8_t i, cur[8];      /* Current pass bit position, in a pos[8] like representation of it */
-   uint8_t  b, b1, b2;     /* bit helper vars */
-
-   if (ow_bb_reset (ow) != DRV_READY)
-      return DRV_NODEV;
-   ow_bb_tx (ow, 0xF0);    /* Issue search command */
-
-   for (i=0 ; i<64 ; ++i) {
-      /* Get response pair bits */
-      b1 = _read_bit (ow);
-      b2 = _read_bit (ow);
-
-      switch (b1 | (b2<<1)) {
-         case 0x00:  /* 00 - We have discrepancy */
-            _write_bit_u64 (cur, i, 1);
-            switch (_cmp_u64 (pos, cur)) {
-               default:
-               case -1: b = 0;
-                        _write_bit_u64 (pos, i, 1);   break;
-               case 0:  b = 1;
-                        _write_bit_u64 (dec, i, 1);   break;
-               case 1:  b = _read_bit_u64 (dec, i);   break;
-               /*<
-                * -1) pos < cur: This discrepancy is the most far for now.
-                *       Mark position and select 0.
-                *  0) pos == cur: This was the last discrepancy in the last pass.
-                *       Select the other branch this time (1).
-                *  1) pos > cur: We had a discrepancy in a MSB than that, in a previous pass.
-                *       Continue with the last pass decision.
-                */
-            }
-
-            /* Send selection and update romid */
-            _write_bit (ow, b);
-            _write_bit_u64 (romid, i, b);
-            break;
-
-         case 0x01:  /* 01 - All bits of all ROMs are 1s */
-            _write_bit (ow, 1);
-            _write_bit_u64 (romid, i, 1);   break;
-
-         case 0x02:  /* 10 - All bits of all ROMs are 0s */
-            _write_bit (ow, 0);
-            _write_bit_u64 (romid, i, 0);   break;
-
-         default:
-         case 0x03:  /* 11 - No device on the bus */
-            _clear_u64 (romid);
-            return DRV_NODEV;
-      }  /* switch (b1 | (b2<<1)) */
-   }  /* for */
-
-   switch (_cmp_u64 (dec, pos)) {
-      case -1: return DRV_BUSY;
-      case 0:  _clear_u64 (dec);
-               _clear_u64 (pos);
-               return DRV_READY;
-      default:
-      case 1:  _clear_u64 (dec);
-               _clear_u64 (pos);
-               return DRV_ERROR;
-      /*<
-       * -1) des < pos:  We have more leafs(ROMs) to found
-       *  0) des == pos: We have found all the leafs(ROMs)
-       *  1) des > pos:  We have more decision that discrepancies ?!?!?, Error.
-       */
-   }
+   ow_bus_t bus = {
+      (void*)ow,
+      (ow_tx_ft)ow_bb_tx,
+      (ow_triplet_ft)ow_bb_triplet,
+      (ow_ioctl_ft)ow_bb_ioctl
+   };
+   return ow_search (&bus, &ow->search, romid);
 }
 
 /*!
@@ -558,10 +445,14 @@ drv_status_en ow_bb_search (ow_bb_t *ow, uint8_t *romid)
  *    \arg CTRL_DEINIT
  *    \arg CTRL_INIT
  *    \arg CTRL_SEARCH
+ *    \arg CTRL_RESET
+ *    \arg CTRL_SET_SPEED     buf is a pointer to uint32_t OW_BB_T_xx timing
  * \param  buf    pointer to buffer for ioctl
  * \return The status of the operation
  *    \arg DRV_READY
  *    \arg DRV_ERROR
+ * When the command is CTRL_SEARCH or CTRL_RESET the return status is the
+ * one of \sa ow_bb_search() or \sa ow_bb_reset()
  */
 drv_status_en ow_bb_ioctl (ow_bb_t *ow, ioctl_cmd_t cmd, ioctl_buf_t buf)
 {
@@ -578,8 +469,16 @@ drv_status_en ow_bb_ioctl (ow_bb_t *ow, ioctl_cmd_t cmd, ioctl_buf_t buf)
             *(drv_status_en*)buf = ow_bb_init (ow);
          else
             ow_bb_init (ow);
+         return DRV_READY;
       case CTRL_SEARCH:         /*!< Search */
-
+         return ow_bb_search (ow, (uint8_t*)buf);
+      case CTRL_RESET:
+         return ow_bb_reset (ow);
+      case CTRL_SET_SPEED:
+         if (!buf)
+            return DRV_ERROR;
+         ow_bb_set_timing (ow, *(uint32_t*)buf);
+         return DRV_READY;
       default:                  /*!< Unsupported command, error */
          return DRV_ERROR;
 
@@ -590,8 +489,5 @@ drv_status_en ow_bb_ioctl (ow_bb_t *ow, ioctl_cmd_t cmd, ioctl_buf_t buf)
 #undef  _waiting
 #undef  _ow_dir_output
 #undef  _ow_dir_input
-#undef  _clear_u64
-#undef  _read_bit_u64
-#undef  _write_bit_u64
 #undef  _usec
 #undef _ow_is_timings
@@ -24,91 +24,18 @@
  */
 #include <com/onewire_uart.h>
 
-/*
- * ========= Private helper macros ===========
- */
-
-/*!
- * Clear a virtual 64bit unsigned register.
- * \note
- *    We use a uint8_t array[8] to represent that kind
- *    of data for this module
- * \param   _reg  Pointer to register location. Usual the name of
- *                The array
- */
-#define  _clear_u64(_reg_)                      \
-   memset ((void*)(_reg_), 0, 8*sizeof(uint8_t))
-
-/*!
- * Read a bit value of a virtual 64bit unsigned register.
- * \note
- *    We use a uint8_t array[8] to represent that kind
- *    of data for this module
- * \param   _reg  Pointer to register location. Usual the name of
- *                The array
- * \param   _bit  The bit location we want to read
- */
-#define  _read_bit_u64(_reg_, _bit_)            \
-   (_reg_[(_bit_)/8] & (1<<((_bit_)%8))) ? 1:0
-
-/*!
- * Write/modify a bit value from a virtual 64bit unsigned register.
- * \note
- *    We use a uint8_t array[8] to represent that kind
- *    of data for this module
- * \param   _reg  Pointer to register location. Usual the name of
- *                The array
- * \param   _bit  The bit location we want to set
- * \param   _v    The value we want to set
- *    \arg  0     Set to zero
- *    \arg  !0    Set to One
- */
-#define  _write_bit_u64(_reg_, _bit_, _v_)               \
-   do {                                                  \
-      if (_v_) _reg_[(_bit_)/8] |=   1 << ((_bit_)%8);   \
-      else     _reg_[(_bit_)/8] &= ~(1 << ((_bit_)%8));  \
-   } while (0)
-
-
-
 /*
  * ============= Private functions ===========
  */
-/* Data manipulation functions */
-static int _cmp_u64 (uint8_t *reg1, uint8_t *reg2);
-
 /* Set functions */
 static drv_status_en _set_baudrate (ow_uart_t *ow, ow_uart_state_en st);
 
 /* Bus functions */
+static drv_status_en _xfer (ow_uart_t *ow, byte_t *frame, int n);
 static uint8_t _write_bit (ow_uart_t *ow, uint8_t b);
-static uint8_t _read_bit (ow_uart_t *ow);
+static drv_status_en _rw_bytes (ow_uart_t *ow, const byte_t *tx, byte_t *rx, int n);
 
 
-/*!
- * \brief
- *    Compare two 64bit virtual unsigned registers
- * \note
- *    We use a uint8_t array[8] to represent that kind
- *    of data for this module
- * \param   reg1  Pointer to first register location. Usual the name of
- *                the array
- * \param   reg1  Pointer to 2nd register location. Usual the name of
- *                the array
- * \return  The comparison result
- *    \arg  0     Registers are equal
- *    \arg  1     Register 1 is larger than register 2
- *    \arg  -1    Register 2 is larger than register 1
- */
-static __O3__ int _cmp_u64 (uint8_t *reg1, uint8_t *reg2) {
-   int i;
-   for (i=7 ; i>=0 ; --i) {
-      if (reg1[i] > reg2[i])        return 1;   /* reg1 > reg2 */
-      else if (reg1[i] < reg2[i])   return -1;  /* reg1 < reg2 */
-   }
-   return 0;   /* reg1 equal reg2 */
-}
-
 /*!
  * \brief
  *    Set UART Baudrate and handle all function calls and data
@@ -137,6 +64,29 @@ static __O3__ drv_status_en _set_baudrate (ow_uart_t *ow, ow_uart_state_en st)
    return DRV_READY;
 }
 
+/*!
+ * \brief
+ *    Send a number of frames, each one is a time slot, and replace
+ *    them with the received ones. With a linked buffer read-write
+ *    function all the frames go to the UART with one call.
+ * \param   ow    Pointer to select 1-Wire structure for the operation.
+ * \param   frame The frames to send and receive
+ * \param   n     The number of frames
+ * \return        The status of the operation
+ */
+static drv_status_en _xfer (ow_uart_t *ow, byte_t *frame, int n)
+{
+   int i;
+
+   if (_set_baudrate (ow, OWS_OPER) != DRV_READY)
+      return DRV_ERROR;
+   if (ow->io.rwbuf)
+      return ow->io.rwbuf (frame, n);
+   for (i=0 ; i<n ; ++i)
+      frame[i] = (byte_t)ow->io.rw (frame[i]);
+   return DRV_READY;
+}
+
 /*!
  * \brief
  *    Send a 1-Wire write bit
@@ -190,44 +140,40 @@ static uint8_t _write_bit (ow_uart_t *ow, uint8_t b)
 
 /*!
  * \brief
- *    Read a bit from the 1-Wire bus, return it and provide
- *    the recovery time.
- *
- *           ---       -  -  -  -  -  -  -  -  -  -  - ------
- * Read         \     / X X X X X X X X X X X X X X X /
- *               ----  -  -  -  -  -  -  -  -  -  - -
- *  RS:          |   |   |   |   |   |   |   |   |   |   |
- *  bit:          st   0   1   2   3   4   5   6   7   st
- *               < ------------- 87/11 usec ------------->
- *                     ^
- *                     |
- *                Master sample
- *
- *  8 bits, no parity, 1 stop
- *  standard:  BR: 115200              Overdrive: BR: 921600
- *  TX: 0xFF
- *  RX: {1 - 0xFF,   0 - [0x00 - 0xFE] }
- *
- * \return  The answer
- *    \arg  0  Read 0
- *    \arg  1  Read 1 (This is also returned on transition error).
+ *    Write and read bytes, packing the 8 time slots of each byte to
+ *    8 frames and up to OW_UART_BULK_SIZE bytes to one transfer.
+ *    The 1 bits use the read slot, so rx gets the slave response
+ *    for them.
+ * \param   ow    Pointer to select 1-Wire structure for the operation.
+ * \param   tx    The bytes to write, NULL for all 0xFF (read)
+ * \param   rx    Buffer for the received bytes, or NULL
+ * \param   n     The number of bytes
+ * \return        The status of the operation
  */
-static uint8_t _read_bit (ow_uart_t *ow)
+static drv_status_en _rw_bytes (ow_uart_t *ow, const byte_t *tx, byte_t *rx, int n)
 {
-   uint16_t  r;
-
-   /*
-    * Make sure we are at the right baudrate
-    */
-   if (_set_baudrate (ow, OWS_OPER) != DRV_READY)
-      return 1;
-
-   /* Send frame for read */
-   r = ow->io.rw (0xFF);
-
-   /* Dispatch answer */
-   if (r < 0xFF)  return 0;
-   else           return 1;
+   byte_t   frame[8*OW_UART_BULK_SIZE];
+   int      i, b, nb;
+   byte_t   byte;
+
+   for ( ; n>0 ; n-=nb) {
+      nb = (n > OW_UART_BULK_SIZE) ? OW_UART_BULK_SIZE : n;
+      for (i=0 ; i<nb ; ++i) {
+         byte = (tx) ? *tx++ : 0xFF;
+         for (b=0 ; b<8 ; ++b, byte >>= 1)
+            frame[8*i+b] = (byte & 0x01) ? 0xFF : 0x00;  /* LSB first */
+      }
+      if (_xfer (ow, frame, 8*nb) != DRV_READY)
+         return DRV_ERROR;
+      if (rx) {
+         for (i=0 ; i<nb ; ++i) {
+            for (b=7, byte=0 ; b>=0 ; --b)
+               byte = (byte << 1) | ((frame[8*i+b] == 0xFF) ? 1:0);
+            *rx++ = byte;
+         }
+      }
+   }
+   return DRV_READY;
 }
 
 
@@ -248,6 +194,17 @@ void ow_uart_link_rw (ow_uart_t *ow, ow_uart_rw_ft rw) {
    ow->io.rw = (ow_uart_rw_ft)((rw != 0) ? rw : 0);
 }
 
+/*!
+ * \brief   link driver's UART buffer read-write function. Optional.
+ *          The function sends the frames of the buffer and replaces them
+ *          with the received ones, as a DMA transfer does.
+ * \param   ow    pointer to select 1-Wire structure for the operation.
+ * \param   rwbuf ow_uart_rwbuf_ft pointer to drivers UART buffer read-write function
+ */
+void ow_uart_link_rwbuf (ow_uart_t *ow, ow_uart_rwbuf_ft rwbuf) {
+   ow->io.rwbuf = (ow_uart_rwbuf_ft)((rwbuf != 0) ? rwbuf : 0);
+}
+
 /*!
  * \brief   link driver's UART baudrate function
  * \param   ow    pointer to select 1-Wire structure for the operation.
@@ -383,13 +340,9 @@ drv_status_en ow_uart_reset (ow_uart_t *ow)
  */
 uint8_t ow_uart_rx (ow_uart_t *ow)
 {
-   uint8_t  i;
-   byte_t byte;
+   byte_t byte = 0xFF;
 
-   for (i=8, byte=0 ; i>0 ; --i) {
-      byte >>= 1;       /* shift bits to right as LSB comes first */
-      if (_read_bit (ow) != 0)  byte |= 0x80;  /* Mask bit to MSB */
-   }
+   _rw_bytes (ow, 0, &byte, 1);
    return byte;
 }
 
@@ -402,12 +355,7 @@ uint8_t ow_uart_rx (ow_uart_t *ow)
  */
 void ow_uart_tx (ow_uart_t *ow, byte_t byte)
 {
-   uint8_t  i;
-
-   for (i=8 ; i>0 ; --i) {
-      _write_bit (ow, byte & 0x01);    /* Send LSB */
-      byte >>= 1;           /* shift bits to right */
-   }
+   _rw_bytes (ow, &byte, 0, 1);
 }
 
 /*!
@@ -419,28 +367,77 @@ void ow_uart_tx (ow_uart_t *ow, byte_t byte)
  */
 uint8_t ow_uart_rw (ow_uart_t *ow, byte_t byte)
 {
-   uint8_t  i;
-   byte_t ret;
-
-   for (i=8, ret=0 ; i>0 ; --i) {
-      ret >>= 1;     /* shift read bits to right as LSB comes first */
-      if ((byte & 0x01) != 0)    ret |= (_read_bit (ow) != 0) ? 0x80 : 0x0;
-      else                       _write_bit (ow, 0);
-      byte >>= 1;    /* shift bits to right */
-
-      /*!<
-       * If the bit is 1 we use the read sequence, as it has the same
-       * waveform with write-1 and we get the slave response
-       * If the bit is 0, we can not read the slave response so we just write-0
-       */
-   }
-   return byte;
+   byte_t ret = 0xFF;
+
+   _rw_bytes (ow, &byte, &ret, 1);
+   return ret;
+   /*!<
+    * If the bit is 1 we use the read sequence, as it has the same
+    * waveform with write-1 and we get the slave response
+    * If the bit is 0, we can not read the slave response so we just write-0
+    */
 }
 
+/*!
+ * \brief
+ *    Read a number of bytes from 1-Wire bus, with bulk transfers
+ * \param  ow    Pointer to select 1-Wire structure for the operation.
+ * \param  buf   Buffer for the received bytes
+ * \param  n     The number of bytes
+ * \return  The status of the operation
+ *    \arg  DRV_ERROR   Error, callback baudrate or transfer error
+ *    \arg  DRV_READY   Success
+ */
+drv_status_en ow_uart_read (ow_uart_t *ow, byte_t *buf, int n) {
+   return _rw_bytes (ow, 0, buf, n);
+}
+
+/*!
+ * \brief
+ *    Write a number of bytes to 1-Wire bus, with bulk transfers
+ * \param  ow    Pointer to select 1-Wire structure for the operation.
+ * \param  buf   The bytes to write
+ * \param  n     The number of bytes
+ * \return  The status of the operation
+ *    \arg  DRV_ERROR   Error, callback baudrate or transfer error
+ *    \arg  DRV_READY   Success
+ */
+drv_status_en ow_uart_write (ow_uart_t *ow, const byte_t *buf, int n) {
+   return _rw_bytes (ow, buf, 0, n);
+}
 
 /*!
  * \brief
- *    1-Wire search algorithm based on maxim-ic application note 187
+ *    1-Wire search triplet. Read the ROM bit and its complement with
+ *    one transfer and write the search direction.
+ * \param  ow    Pointer to select 1-Wire structure for the operation.
+ * \param  dir   The direction to take if there is a discrepancy
+ * \return  The OW_TRIPLET_ID, OW_TRIPLET_CMP and OW_TRIPLET_DIR bits
+ */
+uint8_t ow_uart_triplet (ow_uart_t *ow, uint8_t dir)
+{
+   byte_t   frame[2] = {0xFF, 0xFF};
+   uint8_t  r;
+
+   if (_xfer (ow, frame, 2) != DRV_READY)
+      return OW_TRIPLET_ID | OW_TRIPLET_CMP;
+   r  = (frame[0] == 0xFF) ? OW_TRIPLET_ID : 0;
+   r |= (frame[1] == 0xFF) ? OW_TRIPLET_CMP : 0;
+   switch (r) {
+      case 0:              if (dir) r |= OW_TRIPLET_DIR;  break;   /* discrepancy */
+      case OW_TRIPLET_ID:  r |= OW_TRIPLET_DIR;           break;   /* all 1s */
+      case OW_TRIPLET_CMP:                                break;   /* all 0s */
+      default:             return r;                               /* no device */
+   }
+   _write_bit (ow, (r & OW_TRIPLET_DIR) ? 1:0);
+   return r;
+}
+
+/*!
+ * \brief
+ *    1-Wire search algorithm based on maxim-ic application note 187.
+ *    Each call finds the next device. The search state is kept in the
+ *    driver's data, see \sa ow_search() and \sa ow_enumerate().
  *
  * \param   ow       Pointer to select 1-Wire structure for the operation.
  * \param   romid    Pointer to romid to return. If the search is success
@@ -453,84 +450,13 @@ uint8_t ow_uart_rw (ow_uart_t *ow, byte_t byte)
  */
 drv_status_en ow_uart_search (ow_uart_t *ow, uint8_t *romid)
 {
-   static uint8_t dec[8];  /*!<
-                            * Hold the algorithm's select bit when a discrepancy
-                            * is detected. We use this variable to navigate to the
-                            * ROM tree as we store the path we take each time (0-1).
-                            * Each bit represent a bit position in the ROM ID.
-                            */
-   static uint8_t pos[8];  /*!<
-                            * Hold the discrepancy position. We use this variable to
-                            * navigate to the ROM tree as we store the crossroads(1) we encounter.
-                            * Each bit represent a bit position in the ROM ID.
-                            */
-   uint8_t i, cur[8];      /* Current pass bit position, in a pos[8] like representation of it */
-   uint8_t  b, b1, b2;     /* bit helper vars */
-
-   if (ow_uart_reset (ow) != DRV_READY)
-      return DRV_NODEV;
-   ow_uart_tx (ow, 0xF0);    /* Issue search command */
-
-   for (i=0 ; i<64 ; ++i) {
-      /* Get response pair bits */
-      b1 = _read_bit (ow);
-      b2 = _read_bit (ow);
-
-      switch (b1 | (b2<<1)) {
-         case 0x00:  /* 00 - We have discrepancy */
-            _write_bit_u64 (cur, i, 1);
-            switch (_cmp_u64 (pos, cur)) {
-               default:
-               case -1: b = 0;
-                        _write_bit_u64 (pos, i, 1);   break;
-               case 0:  b = 1;
-                        _write_bit_u64 (dec, i, 1);   break;
-               case 1:  b = _read_bit_u64 (dec, i);   break;
-               /*<
-                * -1) pos < cur: This discrepancy is the most far for now.
-                *       Mark position and select 0.
-                *  0) pos == cur: This was the last discrepancy in the last pass.
-                *       Select the other branch this time (1).
-                *  1) pos > cur: We had a discrepancy in a MSB than that, in a previous pass.
-                *       Continue with the last pass decision.
-                */
-            }
-
-            /* Send selection and update romid */
-            _write_bit (ow, b);
-            _write_bit_u64 (romid, i, b);
-            break;
-
-         case 0x01:  /* 01 - All bits of all ROMs are 1s */
-            _write_bit (ow, 1);
-            _write_bit_u64 (romid, i, 1);   break;
-
-         case 0x02:  /* 10 - All bits of all ROMs are 0s */
-            _write_bit (ow, 0);
-            _write_bit_u64 (romid, i, 0);   break;
-
-         default:
-         case 0x03:  /* 11 - No device on the bus */
-            _clear_u64 (romid);
-            return DRV_NODEV;
-      }  /* switch (b1 | (b2<<1)) */
-   }  /* for */
-
-   switch (_cmp_u64 (dec, pos)) {
-      case -1: return DRV_BUSY;
-      case 0:  _clear_u64 (dec);
-               _clear_u64 (pos);
-               return DRV_READY;
-      default:
-      case 1:  _clear_u64 (dec);
-               _clear_u64 (pos);
-               return DRV_ERROR;
-      /*<
-       * -1) des < pos:  We have more leafs(ROMs) to found
-       *  0) des == pos: We have found all the leafs(ROMs)
-       *  1) des > pos:  We have more decision that discrepancies ?!?!?, Error.
-       */
-   }
+   ow_bus_t bus = {
+      (void*)ow,
+      (ow_tx_ft)ow_uart_tx,
+      (ow_triplet_ft)ow_uart_triplet,
+      (ow_ioctl_ft)ow_uart_ioctl
+   };
+   return ow_search (&bus, &ow->search, romid);
 }
 
 /*!
@@ -544,6 +470,7 @@ drv_status_en ow_uart_search (ow_uart_t *ow, uint8_t *romid)
  *    \arg CTRL_INIT
  *    \arg CTRL_SEARCH
  *    \arg CTRL_RESET
+ *    \arg CTRL_SET_SPEED     buf is a pointer to uint32_t OW_UART_T_xx timing
  * \param  buf    pointer to buffer for ioctl
  * \return The status of the operation
  *    \arg  DRV_ERROR      Error
@@ -576,6 +503,11 @@ __Os__ drv_status_en ow_uart_ioctl (ow_uart_t *ow, ioctl_cmd_t cmd, ioctl_buf_t
          return ow_uart_search (ow, (uint8_t*)buf);
       case CTRL_RESET:
          return ow_uart_reset (ow);
+      case CTRL_SET_SPEED:
+         if (!buf)
+            return DRV_ERROR;
+         ow_uart_set_timing (ow, *(uint32_t*)buf);
+         return DRV_READY;
       default:                  /*!< Unsupported command, error */
          return DRV_ERROR;
 
@@ -583,7 +515,4 @@ __Os__ drv_status_en ow_uart_ioctl (ow_uart_t *ow, ioctl_cmd_t cmd, ioctl_buf_t
 }
 
 
-#undef  _clear_u64
-#undef  _read_bit_u64
-#undef  _write_bit_u64
 #undef  _ow_is_timings
@@ -24,6 +24,7 @@
  */
 
 #include <crypt/aes.h>
+#include <toolbox_defs.h>
 
 
 //#define RAM_TABLES
@@ -434,7 +435,7 @@ static void aes_key_init (aes_t *ctx, uint8_t *key, aes_size size)
    uint32_t *RK, *DK;  // Pointer to round and decryption key tables
 
    #ifdef RAM_TABLES
-   if (init_flag)
+   if (_init_flag)
    {
       _aes_create_tables();
       _init_flag = 0;
@@ -788,3 +789,622 @@ void aes_decrypt (aes_t *ctx, uint8_t in[16], uint8_t out[16])
    PUT_UINT32_BE (X3, out, 12);
 }
 
+
+/*
+ * ============================ Block cipher modes ============================
+ */
+
+/*!
+ * \brief
+ *    Counter block helpers. The counter is kept as two big endian 64 bit
+ *    halves. The GCM counter (inc32) increments only the last 32 bits.
+ */
+static inline void _ctr_get (const uint8_t c[16], uint64_t *hi, uint64_t *lo)
+{
+   uint32_t a, b;
+
+   GET_UINT32_BE (a, c, 0);  GET_UINT32_BE (b, c, 4);
+   *hi = ((uint64_t)a << 32) | b;
+   GET_UINT32_BE (a, c, 8);  GET_UINT32_BE (b, c, 12);
+   *lo = ((uint64_t)a << 32) | b;
+}
+
+static inline void _ctr_put (uint8_t c[16], uint64_t hi, uint64_t lo)
+{
+   PUT_UINT32_BE ((uint32_t)(hi >> 32), c, 0);
+   PUT_UINT32_BE ((uint32_t)hi, c, 4);
+   PUT_UINT32_BE ((uint32_t)(lo >> 32), c, 8);
+   PUT_UINT32_BE ((uint32_t)lo, c, 12);
+}
+
+static inline void _ctr_inc (uint64_t *hi, uint64_t *lo, int inc32)
+{
+   if (inc32)
+      *lo = (*lo & 0xFFFFFFFF00000000ULL) | (uint32_t)(*lo + 1);
+   else if (++*lo == 0)
+      ++*hi;
+}
+
+static inline void _gcm_inc32 (uint8_t c[16])
+{
+   uint32_t n;
+
+   GET_UINT32_BE (n, c, 12);
+   ++n;
+   PUT_UINT32_BE (n, c, 12);
+}
+
+/*
+ * AES-NI and PCLMULQDQ backend
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#include <cpuid.h>
+#define _AES_NI
+
+#define _AES_NI_TARGET     __attribute__ ((target ("aes,pclmul,ssse3,sse4.1")))
+#define _AES_NI_WAY        (8)      /*!< Blocks in flight for the parallel modes */
+
+static int _aes_ni_on = 1;          /*!< The backend is selected, see aes_ni_enable() */
+
+/*!
+ * \brief
+ *    Check once if the CPU has the AES and PCLMULQDQ instructions
+ */
+static int _aes_ni_avail (void)
+{
+   static int avail = -1;
+   unsigned int a, b, c, d;
+
+   if (avail < 0) {
+      avail = 0;
+      if (__get_cpuid (1, &a, &b, &c, &d)
+       && (c & bit_AES) && (c & bit_PCLMUL) && (c & bit_SSSE3) && (c & bit_SSE4_1))
+         avail = 1;
+   }
+   return avail && _aes_ni_on;
+}
+
+/*!
+ * \brief
+ *    Convert the big endian round keys to AES-NI byte order
+ */
+static inline void _aes_ni_keys (const uint32_t *rk, int nr, __m128i k[15])
+{
+   uint8_t b[16];
+   int r, i;
+
+   for (r=0 ; r<=nr ; ++r) {
+      for (i=0 ; i<4 ; ++i)
+         PUT_UINT32_BE (rk[4*r+i], b, 4*i);
+      k[r] = _mm_loadu_si128 ((const __m128i*)b);
+   }
+}
+
+/*!
+ * \brief
+ *    The counter block of the big endian halves hi, lo
+ */
+#define _ctr_vec(_hi, _lo)    _mm_set_epi64x ((long long)__builtin_bswap64 (_lo), (long long)__builtin_bswap64 (_hi))
+
+/*!
+ * \brief
+ *    CTR mode on whole blocks, _AES_NI_WAY blocks in flight
+ */
+_AES_NI_TARGET __O3__
+static void _aes_ni_ctr (aes_t *ctx, uint64_t *hi, uint64_t *lo, const uint8_t *in, uint8_t *out, size_t blocks, int inc32)
+{
+   __m128i k[15], b[_AES_NI_WAY];
+   size_t i, j, w;
+   int r, nr = ctx->nr;
+
+   _aes_ni_keys (ctx->erk, nr, k);
+   for (i=0 ; i<blocks ; i+=w) {
+      w = (blocks-i < _AES_NI_WAY) ? blocks-i : _AES_NI_WAY;
+      for (j=0 ; j<w ; ++j) {
+         b[j] = _mm_xor_si128 (_ctr_vec (*hi, *lo), k[0]);
+         _ctr_inc (hi, lo, inc32);
+      }
+      for (r=1 ; r<nr ; ++r)
+         for (j=0 ; j<w ; ++j)
+            b[j] = _mm_aesenc_si128 (b[j], k[r]);
+      for (j=0 ; j<w ; ++j) {
+         b[j] = _mm_aesenclast_si128 (b[j], k[nr]);
+         b[j] = _mm_xor_si128 (b[j], _mm_loadu_si128 ((const __m128i*)&in[16*(i+j)]));
+         _mm_storeu_si128 ((__m128i*)&out[16*(i+j)], b[j]);
+      }
+   }
+}
+
+/*!
+ * \brief
+ *    CBC encryption on whole blocks. Each block depends on the previous.
+ */
+_AES_NI_TARGET __O3__
+static void _aes_ni_cbc_enc (aes_t *ctx, uint8_t iv[16], const uint8_t *in, uint8_t *out, size_t blocks)
+{
+   __m128i k[15], v;
+   size_t i;
+   int r, nr = ctx->nr;
+
+   _aes_ni_keys (ctx->erk, nr, k);
+   v = _mm_loadu_si128 ((const __m128i*)iv);
+   for (i=0 ; i<blocks ; ++i) {
+      v = _mm_xor_si128 (v, _mm_loadu_si128 ((const __m128i*)&in[16*i]));
+      v = _mm_xor_si128 (v, k[0]);
+      for (r=1 ; r<nr ; ++r)
+         v = _mm_aesenc_si128 (v, k[r]);
+      v = _mm_aesenclast_si128 (v, k[nr]);
+      _mm_storeu_si128 ((__m128i*)&out[16*i], v);
+   }
+   _mm_storeu_si128 ((__m128i*)iv, v);
+}
+
+/*!
+ * \brief
+ *    CBC decryption on whole blocks, _AES_NI_WAY blocks in flight.
+ *    The software decryption keys are the AES-NI (aesimc) ones.
+ */
+_AES_NI_TARGET __O3__
+static void _aes_ni_cbc_dec (aes_t *ctx, uint8_t iv[16], const uint8_t *in, uint8_t *out, size_t blocks)
+{
+   __m128i k[15], b[_AES_NI_WAY], c[_AES_NI_WAY], prev;
+   size_t i, j, w;
+   int r, nr = ctx->nr;
+
+   _aes_ni_keys (ctx->drk, nr, k);
+   prev = _mm_loadu_si128 ((const __m128i*)iv);
+   for (i=0 ; i<blocks ; i+=w) {
+      w = (blocks-i < _AES_NI_WAY) ? blocks-i : _AES_NI_WAY;
+      for (j=0 ; j<w ; ++j) {
+         c[j] = _mm_loadu_si128 ((const __m128i*)&in[16*(i+j)]);
+         b[j] = _mm_xor_si128 (c[j], k[0]);
+      }
+      for (r=1 ; r<nr ; ++r)
+         for (j=0 ; j<w ; ++j)
+            b[j] = _mm_aesdec_si128 (b[j], k[r]);
+      for (j=0 ; j<w ; ++j) {
+         b[j] = _mm_aesdeclast_si128 (b[j], k[nr]);
+         b[j] = _mm_xor_si128 (b[j], (j) ? c[j-1] : prev);
+         _mm_storeu_si128 ((__m128i*)&out[16*(i+j)], b[j]);
+      }
+      prev = c[w-1];
+   }
+   _mm_storeu_si128 ((__m128i*)iv, prev);
+}
+
+/*!
+ * \brief
+ *    GF(2^128) multiplication of the byte reflected a, b
+ *    with carry-less multiplication (Intel GCM white paper, alg. 5)
+ */
+_AES_NI_TARGET
+static inline __m128i _gfmul_ni (__m128i a, __m128i b)
+{
+   __m128i t2, t3, t4, t5, t6, t7, t8, t9;
+
+   t3 = _mm_clmulepi64_si128 (a, b, 0x00);
+   t4 = _mm_clmulepi64_si128 (a, b, 0x10);
+   t5 = _mm_clmulepi64_si128 (a, b, 0x01);
+   t6 = _mm_clmulepi64_si128 (a, b, 0x11);
+   t4 = _mm_xor_si128 (t4, t5);
+   t5 = _mm_slli_si128 (t4, 8);
+   t4 = _mm_srli_si128 (t4, 8);
+   t3 = _mm_xor_si128 (t3, t5);
+   t6 = _mm_xor_si128 (t6, t4);
+   // Shift the 256 bit product left by one
+   t7 = _mm_srli_epi32 (t3, 31);
+   t8 = _mm_srli_epi32 (t6, 31);
+   t3 = _mm_slli_epi32 (t3, 1);
+   t6 = _mm_slli_epi32 (t6, 1);
+   t9 = _mm_srli_si128 (t7, 12);
+   t8 = _mm_slli_si128 (t8, 4);
+   t7 = _mm_slli_si128 (t7, 4);
+   t3 = _mm_or_si128 (t3, t7);
+   t6 = _mm_or_si128 (t6, t8);
+   t6 = _mm_or_si128 (t6, t9);
+   // Reduce modulo x^128 + x^7 + x^2 + x + 1
+   t7 = _mm_slli_epi32 (t3, 31);
+   t8 = _mm_slli_epi32 (t3, 30);
+   t9 = _mm_slli_epi32 (t3, 25);
+   t7 = _mm_xor_si128 (t7, t8);
+   t7 = _mm_xor_si128 (t7, t9);
+   t8 = _mm_srli_si128 (t7, 4);
+   t7 = _mm_slli_si128 (t7, 12);
+   t3 = _mm_xor_si128 (t3, t7);
+   t2 = _mm_srli_epi32 (t3, 1);
+   t4 = _mm_srli_epi32 (t3, 2);
+   t5 = _mm_srli_epi32 (t3, 7);
+   t2 = _mm_xor_si128 (t2, t4);
+   t2 = _mm_xor_si128 (t2, t5);
+   t2 = _mm_xor_si128 (t2, t8);
+   t3 = _mm_xor_si128 (t3, t2);
+   return _mm_xor_si128 (t6, t3);
+}
+
+/*!
+ * \brief
+ *    GHASH whole blocks with PCLMULQDQ
+ */
+_AES_NI_TARGET __O3__
+static void _ghash_ni (const uint8_t H[16], uint8_t X[16], const uint8_t *data, size_t blocks)
+{
+   const __m128i bs = _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+   __m128i h, x;
+   size_t i;
+
+   h = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*)H), bs);
+   x = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*)X), bs);
+   for (i=0 ; i<blocks ; ++i) {
+      x = _mm_xor_si128 (x, _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*)&data[16*i]), bs));
+      x = _gfmul_ni (x, h);
+   }
+   _mm_storeu_si128 ((__m128i*)X, _mm_shuffle_epi8 (x, bs));
+}
+#endif   // #if ... __x86_64__
+
+/*!
+ * \brief
+ *    Select the AES-NI/PCLMULQDQ backend of the modes, when the CPU has it,
+ *    or the portable rounds. AES-NI is selected by default.
+ *
+ * \param en      1 to use AES-NI when available, 0 for the portable rounds
+ * \return        1 if the modes run on AES-NI after the call, 0 otherwise
+ */
+int aes_ni_enable (int en)
+{
+#if defined(_AES_NI)
+   _aes_ni_on = en;
+   return _aes_ni_avail ();
+#else
+   (void)en;
+   return 0;
+#endif
+}
+
+/*!
+ * \brief
+ *    CTR mode engine. A partial last block consumes a whole counter.
+ * \param inc32   Increment only the last 32 bits of the counter (GCM)
+ */
+static void _aes_ctr (aes_t *ctx, uint8_t ctr[16], const uint8_t *in, uint8_t *out, size_t len, int inc32)
+{
+   uint8_t  cb[16], ks[16];
+   uint64_t hi, lo;
+   size_t   i, n, blocks = len / 16;
+
+   _ctr_get (ctr, &hi, &lo);
+#if defined(_AES_NI)
+   if (_aes_ni_avail ()) {
+      _aes_ni_ctr (ctx, &hi, &lo, in, out, blocks, inc32);
+      in += 16*blocks;
+      out += 16*blocks;
+      len -= 16*blocks;
+   }
+#endif
+   for ( ; len ; len -= n, in += n, out += n) {
+      _ctr_put (cb, hi, lo);
+      _ctr_inc (&hi, &lo, inc32);
+      aes_encrypt (ctx, cb, ks);
+      n = (len < 16) ? len : 16;
+      for (i=0 ; i<n ; ++i)
+         out[i] = in[i] ^ ks[i];
+   }
+   _ctr_put (ctr, hi, lo);
+}
+
+/*!
+ * \brief
+ *    CBC encryption.
+ * \note
+ *    The input and output buffer can be the same.
+ *
+ * \param ctx     the active aes context with the key set
+ * \param iv      the initialisation vector. It is updated so a next call continues the chain
+ * \param in      buffer holding the plaintext
+ * \param out     buffer for the ciphertext
+ * \param len     the data length, multiple of 16
+ * \return        1 on success, 0 if len is not a multiple of 16
+ */
+int aes_cbc_encrypt (aes_t *ctx, uint8_t iv[16], const uint8_t *in, uint8_t *out, size_t len)
+{
+   int i;
+
+   if (len % 16)
+      return 0;
+#if defined(_AES_NI)
+   if (_aes_ni_avail ()) {
+      _aes_ni_cbc_enc (ctx, iv, in, out, len/16);
+      return 1;
+   }
+#endif
+   for ( ; len ; len -= 16, in += 16, out += 16) {
+      for (i=0 ; i<16 ; ++i)
+         out[i] = in[i] ^ iv[i];
+      aes_encrypt (ctx, out, out);
+      memcpy ((void*)iv, (const void*)out, 16);
+   }
+   return 1;
+}
+
+/*!
+ * \brief
+ *    CBC decryption.
+ * \note
+ *    The input and output buffer can be the same.
+ *
+ * \param ctx     the active aes context with the key set
+ * \param iv      the initialisation vector. It is updated so a next call continues the chain
+ * \param in      buffer holding the ciphertext
+ * \param out     buffer for the plaintext
+ * \param len     the data length, multiple of 16
+ * \return        1 on success, 0 if len is not a multiple of 16
+ */
+int aes_cbc_decrypt (aes_t *ctx, uint8_t iv[16], const uint8_t *in, uint8_t *out, size_t len)
+{
+   uint8_t c[16];
+   int i;
+
+   if (len % 16)
+      return 0;
+#if defined(_AES_NI)
+   if (_aes_ni_avail ()) {
+      _aes_ni_cbc_dec (ctx, iv, in, out, len/16);
+      return 1;
+   }
+#endif
+   for ( ; len ; len -= 16, in += 16, out += 16) {
+      memcpy ((void*)c, (const void*)in, 16);
+      aes_decrypt (ctx, c, out);
+      for (i=0 ; i<16 ; ++i)
+         out[i] ^= iv[i];
+      memcpy ((void*)iv, (const void*)c, 16);
+   }
+   return 1;
+}
+
+/*!
+ * \brief
+ *    CTR mode encryption/decryption (SP 800-38A), with 128 bit
+ *    big endian counter increment.
+ * \note
+ *    The input and output buffer can be the same. The counter is updated,
+ *    so a stream can be processed in pieces of multiple of 16 bytes. A partial
+ *    last block consumes a whole counter.
+ *
+ * \param ctx     the active aes context with the key set
+ * \param ctr     the counter block
+ * \param in      buffer holding the input data
+ * \param out     buffer for the output data
+ * \param len     the data length
+ * \return        none
+ */
+void aes_ctr (aes_t *ctx, uint8_t ctr[16], const uint8_t *in, uint8_t *out, size_t len) {
+   _aes_ctr (ctx, ctr, in, out, len, 0);
+}
+
+/*
+ * GCM
+ */
+
+/*!
+ * Reduction table for the 4-bit GHASH multiplication
+ */
+static const uint64_t _gcm_last4[16] =
+{
+   0x0000, 0x1C20, 0x3840, 0x2460, 0x7080, 0x6CA0, 0x48C0, 0x54E0,
+   0xE100, 0xFD20, 0xD940, 0xC560, 0x9180, 0x8DA0, 0xA9C0, 0xB5E0
+};
+
+/*!
+ * \brief
+ *    X = X * H in GF(2^128), with the 4-bit tables of the context
+ */
+static void _gcm_mult (aes_gcm_t *gcm, uint8_t X[16])
+{
+   uint64_t zh, zl;
+   uint8_t  lo, hi, rem;
+   int i;
+
+   lo = X[15] & 0x0F;
+   zh = gcm->HH[lo];
+   zl = gcm->HL[lo];
+   for (i=15 ; i>=0 ; --i) {
+      lo = X[i] & 0x0F;
+      hi = (X[i] >> 4) & 0x0F;
+      if (i != 15) {
+         rem = (uint8_t)(zl & 0x0F);
+         zl = (zh << 60) | (zl >> 4);
+         zh = (zh >> 4) ^ (_gcm_last4[rem] << 48);
+         zh ^= gcm->HH[lo];
+         zl ^= gcm->HL[lo];
+      }
+      rem = (uint8_t)(zl & 0x0F);
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ (_gcm_last4[rem] << 48);
+      zh ^= gcm->HH[hi];
+      zl ^= gcm->HL[hi];
+   }
+   _ctr_put (X, zh, zl);
+}
+
+/*!
+ * \brief
+ *    Update the GHASH X with data. A partial last block is zero padded.
+ */
+static void _gcm_ghash (aes_gcm_t *gcm, uint8_t X[16], const uint8_t *data, size_t len)
+{
+   size_t i, n;
+
+#if defined(_AES_NI)
+   if (_aes_ni_avail ()) {
+      _ghash_ni (gcm->H, X, data, len/16);
+      data += len & ~(size_t)0x0F;
+      len &= 0x0F;
+   }
+#endif
+   for ( ; len ; len -= n, data += n) {
+      n = (len < 16) ? len : 16;
+      for (i=0 ; i<n ; ++i)
+         X[i] ^= data[i];
+      _gcm_mult (gcm, X);
+   }
+}
+
+/*!
+ * \brief
+ *    Calculate the pre-counter block J0 and the tag mask S = E(K, J0)
+ */
+static void _gcm_start (aes_gcm_t *gcm, const uint8_t *iv, size_t iv_len, uint8_t J0[16], uint8_t S[16])
+{
+   uint8_t lb[16];
+
+   memset ((void*)J0, 0, 16);
+   if (iv_len == 12) {
+      memcpy ((void*)J0, (const void*)iv, 12);
+      J0[15] = 1;
+   }
+   else {
+      memset ((void*)lb, 0, 16);
+      _ctr_put (lb, 0, (uint64_t)iv_len << 3);
+      _gcm_ghash (gcm, J0, iv, iv_len);
+      _gcm_ghash (gcm, J0, lb, 16);
+   }
+   aes_encrypt (gcm->aes, J0, S);
+}
+
+/*!
+ * \brief
+ *    Calculate the GCM tag of the ciphertext
+ */
+static void _gcm_tag (aes_gcm_t *gcm, const uint8_t S[16], const uint8_t *aad, size_t aad_len,
+                      const uint8_t *c, size_t len, uint8_t tag[16])
+{
+   uint8_t lb[16];
+   int i;
+
+   memset ((void*)tag, 0, 16);
+   _gcm_ghash (gcm, tag, aad, aad_len);
+   _gcm_ghash (gcm, tag, c, len);
+   _ctr_put (lb, (uint64_t)aad_len << 3, (uint64_t)len << 3);
+   _gcm_ghash (gcm, tag, lb, 16);
+   for (i=0 ; i<16 ; ++i)
+      tag[i] ^= S[i];
+}
+
+/*!
+ * \brief
+ *    Initialise a GCM context on a keyed aes context. It calculates
+ *    the hash subkey and the GHASH tables.
+ *
+ * \param gcm     the GCM context to fill
+ * \param ctx     the active aes context with the key set
+ * \return        none
+ */
+void aes_gcm_init (aes_gcm_t *gcm, aes_t *ctx)
+{
+   uint64_t vh, vl;
+   uint32_t T;
+   int i, j;
+
+   memset ((void*)gcm, 0, sizeof (aes_gcm_t));
+   gcm->aes = ctx;
+   aes_encrypt (ctx, gcm->H, gcm->H);
+   _ctr_get (gcm->H, &vh, &vl);
+
+   // HL/HH[i] hold i*H, with the bits of i in reflected order
+   gcm->HH[8] = vh;
+   gcm->HL[8] = vl;
+   for (i=4 ; i>0 ; i >>= 1) {
+      T = (uint32_t)(vl & 1) * 0xE1000000U;
+      vl = (vh << 63) | (vl >> 1);
+      vh = (vh >> 1) ^ ((uint64_t)T << 32);
+      gcm->HH[i] = vh;
+      gcm->HL[i] = vl;
+   }
+   for (i=2 ; i<=8 ; i *= 2) {
+      vh = gcm->HH[i];
+      vl = gcm->HL[i];
+      for (j=1 ; j<i ; ++j) {
+         gcm->HH[i+j] = vh ^ gcm->HH[j];
+         gcm->HL[i+j] = vl ^ gcm->HL[j];
+      }
+   }
+}
+
+/*!
+ * \brief
+ *    GCM authenticated encryption (SP 800-38D).
+ * \note
+ *    The input and output buffer can be the same.
+ *
+ * \param gcm     the GCM context
+ * \param iv      the initialisation vector, 12 bytes recommended
+ * \param iv_len  the iv length
+ * \param aad     additional authenticated data
+ * \param aad_len the aad length
+ * \param in      buffer holding the plaintext
+ * \param out     buffer for the ciphertext
+ * \param len     the data length
+ * \param tag     buffer for the tag
+ * \param tag_len the tag length, up to 16
+ * \return        none
+ */
+void aes_gcm_encrypt (aes_gcm_t *gcm, const uint8_t *iv, size_t iv_len,
+                      const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, uint8_t *out, size_t len,
+                      uint8_t *tag, size_t tag_len)
+{
+   uint8_t J0[16], S[16], T[16];
+
+   _gcm_start (gcm, iv, iv_len, J0, S);
+   _gcm_inc32 (J0);
+   _aes_ctr (gcm->aes, J0, in, out, len, 1);
+   _gcm_tag (gcm, S, aad, aad_len, out, len, T);
+   memcpy ((void*)tag, (const void*)T, (tag_len < 16) ? tag_len : 16);
+}
+
+/*!
+ * \brief
+ *    GCM authenticated decryption (SP 800-38D). The tag is checked
+ *    in constant time before the decryption. On mismatch the output is
+ *    cleared.
+ * \note
+ *    The input and output buffer can be the same.
+ *
+ * \param gcm     the GCM context
+ * \param iv      the initialisation vector
+ * \param iv_len  the iv length
+ * \param aad     additional authenticated data
+ * \param aad_len the aad length
+ * \param in      buffer holding the ciphertext
+ * \param out     buffer for the plaintext
+ * \param len     the data length
+ * \param tag     the received tag
+ * \param tag_len the tag length, up to 16
+ * \return        1 if the tag is authentic, 0 otherwise
+ */
+int aes_gcm_decrypt (aes_gcm_t *gcm, const uint8_t *iv, size_t iv_len,
+                     const uint8_t *aad, size_t aad_len,
+                     const uint8_t *in, uint8_t *out, size_t len,
+                     const uint8_t *tag, size_t tag_len)
+{
+   uint8_t J0[16], S[16], T[16], diff = 0;
+   size_t i;
+
+   if (tag_len == 0 || tag_len > 16) {
+      memset ((void*)out, 0, len);
+      return 0;
+   }
+   _gcm_start (gcm, iv, iv_len, J0, S);
+   _gcm_tag (gcm, S, aad, aad_len, in, len, T);
+   for (i=0 ; i<tag_len ; ++i)
+      diff |= T[i] ^ tag[i];
+   if (diff) {
+      memset ((void*)out, 0, len);
+      return 0;
+   }
+   _gcm_inc32 (J0);
+   _aes_ctr (gcm->aes, J0, in, out, len, 1);
+   return 1;
+}
@@ -28,6 +28,7 @@
  */
 
 #include <crypt/des.h>
+#include <toolbox_defs.h>
 
 /*
  * Initial Permutation macro
@@ -75,6 +76,21 @@
         SB1[ (T >> 24) & 0x3F ];             \
 }
 
+/*
+ * 16 DES rounds, fully unrolled
+ */
+#define DES_ROUNDS(X,Y)                                        \
+{                                                              \
+   DES_ROUND (X, Y);  DES_ROUND (Y, X);                        \
+   DES_ROUND (X, Y);  DES_ROUND (Y, X);                        \
+   DES_ROUND (X, Y);  DES_ROUND (Y, X);                        \
+   DES_ROUND (X, Y);  DES_ROUND (Y, X);                        \
+   DES_ROUND (X, Y);  DES_ROUND (Y, X);                        \
+   DES_ROUND (X, Y);  DES_ROUND (Y, X);                        \
+   DES_ROUND (X, Y);  DES_ROUND (Y, X);                        \
+   DES_ROUND (X, Y);  DES_ROUND (Y, X);                        \
+}
+
 #define SWAP(a,b) { uint32_t t = a; a = b; b = t; t = 0; }
 
 /*
@@ -325,6 +341,11 @@ static const uint8_t weak_key_table[WEAK_KEY_COUNT][DES_KEY_SIZE] =
 static void  _setkey (uint32_t SK[32], const uint8_t key[DES_KEY_SIZE]);
 static void _set2key (uint32_t esk[96], uint32_t dsk[96], const uint8_t key[DES_KEY_SIZE*2]);
 static void _set3key (uint32_t esk[96], uint32_t dsk[96], const uint8_t key[24]);
+static void     _crypt (const uint32_t *SK, int stages, const uint8_t input[8], uint8_t output[8]);
+static void       _ecb (const uint32_t *sk, int stages, const uint8_t *in, uint8_t *out, size_t blocks);
+static int    _cbc_enc (const uint32_t *sk, int stages, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len);
+static int    _cbc_dec (const uint32_t *sk, int stages, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len);
+static void       _ctr (const uint32_t *sk, int stages, uint8_t ctr[8], const uint8_t *in, uint8_t *out, size_t len);
 
 
 
@@ -437,6 +458,778 @@ static void _set3key (uint32_t esk[96], uint32_t dsk[96], const uint8_t key[24])
 }
 
 
+/*
+ * ====================== Bitsliced engine ======================
+ *
+ * The blocks are transposed so slice i holds bit i of every block, and
+ * the rounds run on slices with boolean S-box circuits. The circuits are
+ * built from the SB1..SB8 tables, so the slices keep the X, Y bit order
+ * of DES_IP and DES_ROUND and the same sub-keys are used. The key bits
+ * are the same for all the blocks, so they are all-0/all-1 slices.
+ */
+#if DES_BITSLICE
+
+#define _K(k, b)     (_z - (((k) >> (b)) & 1))
+
+/*!
+ * The slice of each X, Y bit after DES_IP, as _bs_transpose() leaves the input bits
+ */
+static const uint8_t _bs_ip[64] =
+{
+   57,  7, 15, 23, 31, 39, 47, 55, 63,  5, 13, 21, 29, 37, 45, 53,
+   61,  3, 11, 19, 27, 35, 43, 51, 59,  1,  9, 17, 25, 33, 41, 49,
+   56,  6, 14, 22, 30, 38, 46, 54, 62,  4, 12, 20, 28, 36, 44, 52,
+   60,  2, 10, 18, 26, 34, 42, 50, 58,  0,  8, 16, 24, 32, 40, 48
+};
+
+/*!
+ * The X, Y bit of each output slice after DES_FP, in _bs_transpose() order
+ */
+static const uint8_t _bs_fp[64] =
+{
+   25, 57, 17, 49,  9, 41,  1, 33, 26, 58, 18, 50, 10, 42,  2, 34,
+   27, 59, 19, 51, 11, 43,  3, 35, 28, 60, 20, 52, 12, 44,  4, 36,
+   29, 61, 21, 53, 13, 45,  5, 37, 30, 62, 22, 54, 14, 46,  6, 38,
+   31, 63, 23, 55, 15, 47,  7, 39,  0, 32, 24, 56, 16, 48,  8, 40
+};
+
+/*!
+ * S-box 1, 112 gates
+ */
+#define _BS_S1(_T, _a0,_a1,_a2,_a3,_a4,_a5, d0,d1,d2,d3)        \
+{                                                               \
+   _T a0 = _a0, a1 = _a1, a2 = _a2, a3 = _a3, a4 = _a4, a5 = _a5;\
+   _T t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+      t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23,    \
+      t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34,    \
+      t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45,    \
+      t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56,    \
+      t57, t58, t59, t60, t61, t62, t63, t64, t65, t66, t67,    \
+      t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78,    \
+      t79, t80, t81, t82, t83, t84, t85, t86, t87, t88, t89,    \
+      t90, t91, t92, t93, t94, t95, t96, t97, t98, t99,         \
+      t100, t101, t102, t103, t104, t105, t106, t107, t108,     \
+      t109, t110, t111;                                         \
+   t0 = ~a1; t1 = t0 & a4; t2 = a1 | a4; t3 = a1 & a3;          \
+   t4 = t1 ^ t3; t5 = ~a4; t6 = t0 ^ a4; t7 = t5 ^ t3;          \
+   t8 = t4 ^ t7; t9 = t8 & a2; t10 = t4 ^ t9;                   \
+   t11 = a1 & ~a4; t12 = t2 & a3; t13 = t11 ^ t12;              \
+   t14 = t6 ^ t12; t15 = t13 ^ t14; t16 = t15 & a2;             \
+   t17 = t13 ^ t16; t18 = t10 ^ t17; t19 = t18 & a0;            \
+   t20 = t10 ^ t19; t21 = ~t6; t22 = t5 & a3;                   \
+   t23 = t21 ^ t22; t24 = ~t7; t25 = t23 ^ t24;                 \
+   t26 = t25 & a2; t27 = t23 ^ t26; t28 = ~t11;                 \
+   t29 = t28 ^ a3; t30 = t6 & a2; t31 = t29 ^ t30;              \
+   t32 = t27 ^ t31; t33 = t32 & a0; t34 = t27 ^ t33;            \
+   t35 = t20 ^ t34; t36 = t35 & a5; t37 = t20 ^ t36;            \
+   t38 = ~t13; t39 = t28 & a3; t40 = t1 ^ t39;                  \
+   t41 = t38 ^ t40; t42 = t41 & a2; t43 = t38 ^ t42;            \
+   t44 = t2 ^ t39; t45 = t6 ^ t39; t46 = t44 ^ t9;              \
+   t47 = t43 ^ t46; t48 = t47 & a0; t49 = t43 ^ t48;            \
+   t50 = t6 ^ t3; t51 = t28 & a2; t52 = t4 ^ t51;               \
+   t53 = t2 ^ t21; t54 = t53 & a3; t55 = t2 ^ t54;              \
+   t56 = t45 ^ t55; t57 = t56 & a2; t58 = t45 ^ t57;            \
+   t59 = t52 ^ t58; t60 = t59 & a0; t61 = t52 ^ t60;            \
+   t62 = t49 ^ t61; t63 = t62 & a5; t64 = t49 ^ t63;            \
+   t65 = t0 & a3; t66 = t5 ^ t65; t67 = t28 ^ t65;              \
+   t68 = t2 & a2; t69 = t66 ^ t68; t70 = a1 ^ t22;              \
+   t71 = ~t2; t72 = t21 & a3; t73 = t8 ^ t72;                   \
+   t74 = t67 & a2; t75 = t70 ^ t74; t76 = t69 ^ t75;            \
+   t77 = t76 & a0; t78 = t69 ^ t77; t79 = t38 ^ t45;            \
+   t80 = t79 & a2; t81 = t38 ^ t80; t82 = t73 ^ a2;             \
+   t83 = t81 ^ t82; t84 = t83 & a0; t85 = t81 ^ t84;            \
+   t86 = t78 ^ t85; t87 = t86 & a5; t88 = t78 ^ t87;            \
+   t89 = t41 ^ t50; t90 = t89 & a2; t91 = t41 ^ t90;            \
+   t92 = ~t66; t93 = t23 ^ t92; t94 = t93 & a2;                 \
+   t95 = t23 ^ t94; t96 = t91 ^ t95; t97 = t96 & a0;            \
+   t98 = t91 ^ t97; t99 = t92 ^ t16; t100 = ~t40;               \
+   t101 = t71 & a3; t102 = t6 ^ t101; t103 = t100 ^ t102;       \
+   t104 = t103 & a2; t105 = t100 ^ t104; t106 = t99 ^ t105;     \
+   t107 = t106 & a0; t108 = t99 ^ t107; t109 = t98 ^ t108;      \
+   t110 = t109 & a5; t111 = t98 ^ t110;                         \
+   d0 ^= t37; d1 ^= t64; d2 ^= t88; d3 ^= t111;                 \
+}
+
+/*!
+ * S-box 2, 102 gates
+ */
+#define _BS_S2(_T, _a0,_a1,_a2,_a3,_a4,_a5, d0,d1,d2,d3)        \
+{                                                               \
+   _T a0 = _a0, a1 = _a1, a2 = _a2, a3 = _a3, a4 = _a4, a5 = _a5;\
+   _T t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+      t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23,    \
+      t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34,    \
+      t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45,    \
+      t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56,    \
+      t57, t58, t59, t60, t61, t62, t63, t64, t65, t66, t67,    \
+      t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78,    \
+      t79, t80, t81, t82, t83, t84, t85, t86, t87, t88, t89,    \
+      t90, t91, t92, t93, t94, t95, t96, t97, t98, t99,         \
+      t100, t101;                                               \
+   t0 = ~a2; t1 = t0 ^ a3; t2 = t1 & a4; t3 = t0 ^ t2;          \
+   t4 = ~t3; t5 = t3 ^ a1; t6 = t0 ^ a4; t7 = t4 ^ t6;          \
+   t8 = t7 & a1; t9 = t4 ^ t8; t10 = t5 ^ t9;                   \
+   t11 = t10 & a5; t12 = t5 ^ t11; t13 = ~t1;                   \
+   t14 = t13 ^ t0; t15 = t14 & a4; t16 = t13 ^ t15;             \
+   t17 = t14 | a2; t18 = a3 & a2; t19 = t17 ^ t15;              \
+   t20 = t16 ^ t19; t21 = t20 & a1; t22 = t16 ^ t21;            \
+   t23 = t22 ^ a5; t24 = t12 ^ t23; t25 = t24 & a0;             \
+   t26 = t12 ^ t25; t27 = t13 & a4; t28 = t0 ^ t27;             \
+   t29 = t1 ^ t28; t30 = t29 & a1; t31 = t1 ^ t30;              \
+   t32 = ~t6; t33 = t2 & a1; t34 = t32 ^ t33;                   \
+   t35 = t31 ^ t34; t36 = t35 & a5; t37 = t31 ^ t36;            \
+   t38 = t13 & a1; t39 = t6 ^ t38; t40 = a2 & a4;               \
+   t41 = t13 ^ t40; t42 = t28 ^ t41; t43 = t42 & a1;            \
+   t44 = t28 ^ t43; t45 = t39 ^ t44; t46 = t45 & a5;            \
+   t47 = t39 ^ t46; t48 = t37 ^ t47; t49 = t48 & a0;            \
+   t50 = t37 ^ t49; t51 = ~t29; t52 = a3 & a4;                  \
+   t53 = t13 ^ t52; t54 = t51 ^ t53; t55 = t54 & a1;            \
+   t56 = t51 ^ t55; t57 = a3 ^ t40; t58 = ~t57;                 \
+   t59 = t57 ^ a1; t60 = t56 ^ t59; t61 = t60 & a5;             \
+   t62 = t56 ^ t61; t63 = t0 & a4; t64 = a3 ^ t63;              \
+   t65 = t64 ^ t55; t66 = t58 ^ t6; t67 = t66 & a1;             \
+   t68 = t58 ^ t67; t69 = t65 ^ t68; t70 = t69 & a5;            \
+   t71 = t65 ^ t70; t72 = t62 ^ t71; t73 = t72 & a0;            \
+   t74 = t62 ^ t73; t75 = t20 ^ a4; t76 = t17 & a1;             \
+   t77 = t75 ^ t76; t78 = t13 ^ t18; t79 = t78 & a4;            \
+   t80 = t13 ^ t79; t81 = t20 & a4; t82 = t14 ^ t81;            \
+   t83 = t80 ^ t82; t84 = t83 & a1; t85 = t80 ^ t84;            \
+   t86 = t77 ^ t85; t87 = t86 & a5; t88 = t77 ^ t87;            \
+   t89 = t78 ^ t52; t90 = t3 ^ t89; t91 = t90 & a1;             \
+   t92 = t3 ^ t91; t93 = t13 ^ t81; t94 = a2 & a1;              \
+   t95 = t93 ^ t94; t96 = t92 ^ t95; t97 = t96 & a5;            \
+   t98 = t92 ^ t97; t99 = t88 ^ t98; t100 = t99 & a0;           \
+   t101 = t88 ^ t100;                                           \
+   d0 ^= t26; d1 ^= t50; d2 ^= t74; d3 ^= t101;                 \
+}
+
+/*!
+ * S-box 3, 102 gates
+ */
+#define _BS_S3(_T, _a0,_a1,_a2,_a3,_a4,_a5, d0,d1,d2,d3)        \
+{                                                               \
+   _T a0 = _a0, a1 = _a1, a2 = _a2, a3 = _a3, a4 = _a4, a5 = _a5;\
+   _T t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+      t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23,    \
+      t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34,    \
+      t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45,    \
+      t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56,    \
+      t57, t58, t59, t60, t61, t62, t63, t64, t65, t66, t67,    \
+      t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78,    \
+      t79, t80, t81, t82, t83, t84, t85, t86, t87, t88, t89,    \
+      t90, t91, t92, t93, t94, t95, t96, t97, t98, t99,         \
+      t100, t101;                                               \
+   t0 = ~a0; t1 = t0 ^ a1; t2 = a0 & ~a1; t3 = t1 ^ t2;         \
+   t4 = t3 & a4; t5 = t1 ^ t4; t6 = a1 & ~t0; t7 = ~t6;         \
+   t8 = t7 ^ t1; t9 = t8 & a4; t10 = t7 ^ t9;                   \
+   t11 = t5 ^ t10; t12 = t11 & a3; t13 = t5 ^ t12;              \
+   t14 = ~t3; t15 = t6 & a4; t16 = t14 ^ t15;                   \
+   t17 = t16 ^ a3; t18 = t13 ^ t17; t19 = t18 & a2;             \
+   t20 = t13 ^ t19; t21 = t0 & a4; t22 = a1 ^ t21;              \
+   t23 = ~t1; t24 = t22 ^ t23; t25 = t24 & a3;                  \
+   t26 = t22 ^ t25; t27 = t1 ^ t9; t28 = t4 ^ t27;              \
+   t29 = t28 & a3; t30 = t4 ^ t29; t31 = t26 ^ t30;             \
+   t32 = t31 & a2; t33 = t26 ^ t32; t34 = t20 ^ t33;            \
+   t35 = t34 & a5; t36 = t20 ^ t35; t37 = ~a1;                  \
+   t38 = t37 ^ a4; t39 = t38 ^ t4; t40 = t39 & a3;              \
+   t41 = t38 ^ t40; t42 = ~t2; t43 = t14 & a4;                  \
+   t44 = t42 ^ t43; t45 = t1 ^ a4; t46 = t44 ^ t45;             \
+   t47 = t46 & a3; t48 = t44 ^ t47; t49 = t41 ^ t48;            \
+   t50 = t49 & a2; t51 = t41 ^ t50; t52 = t1 ^ t47;             \
+   t53 = t52 ^ a2; t54 = t51 ^ t53; t55 = t54 & a5;             \
+   t56 = t51 ^ t55; t57 = a0 ^ t9; t58 = t57 ^ t45;             \
+   t59 = t58 & a3; t60 = t57 ^ t59; t61 = t7 ^ t21;             \
+   t62 = t46 ^ t61; t63 = t62 & a3; t64 = t46 ^ t63;            \
+   t65 = t60 ^ t64; t66 = t65 & a2; t67 = t60 ^ t66;            \
+   t68 = t0 ^ a4; t69 = t37 & a3; t70 = t68 ^ t69;              \
+   t71 = ~t22; t72 = t3 & a3; t73 = t71 ^ t72;                  \
+   t74 = t70 ^ t73; t75 = t74 & a2; t76 = t70 ^ t75;            \
+   t77 = t67 ^ t76; t78 = t77 & a5; t79 = t67 ^ t78;            \
+   t80 = ~t68; t81 = a1 & a3; t82 = t80 ^ t81;                  \
+   t83 = t37 & a2; t84 = t82 ^ t83; t85 = t7 & a4;              \
+   t86 = a1 ^ t85; t87 = t62 ^ t86; t88 = t87 & a3;             \
+   t89 = t62 ^ t88; t90 = ~t27; t91 = t42 & a4;                 \
+   t92 = t1 ^ t91; t93 = t90 ^ t92; t94 = t93 & a3;             \
+   t95 = t90 ^ t94; t96 = t89 ^ t95; t97 = t96 & a2;            \
+   t98 = t89 ^ t97; t99 = t84 ^ t98; t100 = t99 & a5;           \
+   t101 = t84 ^ t100;                                           \
+   d0 ^= t36; d1 ^= t56; d2 ^= t79; d3 ^= t101;                 \
+}
+
+/*!
+ * S-box 4, 73 gates
+ */
+#define _BS_S4(_T, _a0,_a1,_a2,_a3,_a4,_a5, d0,d1,d2,d3)        \
+{                                                               \
+   _T a0 = _a0, a1 = _a1, a2 = _a2, a3 = _a3, a4 = _a4, a5 = _a5;\
+   _T t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+      t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23,    \
+      t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34,    \
+      t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45,    \
+      t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56,    \
+      t57, t58, t59, t60, t61, t62, t63, t64, t65, t66, t67,    \
+      t68, t69, t70, t71, t72;                                  \
+   t0 = ~a3; t1 = a1 & a3; t2 = t0 ^ t1; t3 = t2 & a5;          \
+   t4 = t0 ^ t3; t5 = ~a1; t6 = a1 ^ a3; t7 = t5 | a3;          \
+   t8 = t5 & a2; t9 = t4 ^ t8; t10 = ~t1; t11 = t5 ^ t10;       \
+   t12 = t11 & a5; t13 = t5 ^ t12; t14 = a1 ^ t3;               \
+   t15 = t13 ^ t14; t16 = t15 & a2; t17 = t13 ^ t16;            \
+   t18 = t9 ^ t17; t19 = t18 & a4; t20 = t9 ^ t19;              \
+   t21 = ~t6; t22 = t21 ^ t12; t23 = ~t2; t24 = t2 ^ a5;        \
+   t25 = t22 ^ t24; t26 = t25 & a2; t27 = t22 ^ t26;            \
+   t28 = t6 ^ a5; t29 = t1 ^ t3; t30 = t28 ^ t29;               \
+   t31 = t30 & a2; t32 = t28 ^ t31; t33 = t27 ^ t32;            \
+   t34 = t33 & a4; t35 = t27 ^ t34; t36 = t20 ^ t35;            \
+   t37 = t36 & a0; t38 = t20 ^ t37; t39 = t11 ^ a5;             \
+   t40 = t23 & a5; t41 = t7 ^ t40; t42 = t39 ^ t41;             \
+   t43 = t42 & a2; t44 = t39 ^ t43; t45 = t7 & a5;              \
+   t46 = a3 ^ t45; t47 = t13 & a2; t48 = t46 ^ t47;             \
+   t49 = t44 ^ t48; t50 = t49 & a4; t51 = t44 ^ t50;            \
+   t52 = t2 ^ t45; t53 = a1 & a2; t54 = t52 ^ t53;              \
+   t55 = t1 ^ t45; t56 = t55 ^ t30; t57 = t56 & a2;             \
+   t58 = t55 ^ t57; t59 = t54 ^ t58; t60 = t59 & a4;            \
+   t61 = t54 ^ t60; t62 = t51 ^ t61; t63 = t62 & a0;            \
+   t64 = t51 ^ t63; t65 = ~t51; t66 = t61 ^ t65;                \
+   t67 = t66 & a0; t68 = t61 ^ t67; t69 = ~t20;                 \
+   t70 = t35 ^ t69; t71 = t70 & a0; t72 = t35 ^ t71;            \
+   d0 ^= t38; d1 ^= t64; d2 ^= t68; d3 ^= t72;                  \
+}
+
+/*!
+ * S-box 5, 107 gates
+ */
+#define _BS_S5(_T, _a0,_a1,_a2,_a3,_a4,_a5, d0,d1,d2,d3)        \
+{                                                               \
+   _T a0 = _a0, a1 = _a1, a2 = _a2, a3 = _a3, a4 = _a4, a5 = _a5;\
+   _T t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+      t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23,    \
+      t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34,    \
+      t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45,    \
+      t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56,    \
+      t57, t58, t59, t60, t61, t62, t63, t64, t65, t66, t67,    \
+      t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78,    \
+      t79, t80, t81, t82, t83, t84, t85, t86, t87, t88, t89,    \
+      t90, t91, t92, t93, t94, t95, t96, t97, t98, t99,         \
+      t100, t101, t102, t103, t104, t105, t106;                 \
+   t0 = ~a1; t1 = t0 ^ a5; t2 = t0 & a5; t3 = t1 ^ t2;          \
+   t4 = t3 & a4; t5 = t1 ^ t4; t6 = a5 & ~t0; t7 = ~t6;         \
+   t8 = t7 ^ a5; t9 = t8 & a4; t10 = t7 ^ t9;                   \
+   t11 = t5 ^ t10; t12 = t11 & a3; t13 = t5 ^ t12;              \
+   t14 = a1 ^ a4; t15 = t10 ^ t14; t16 = t15 & a3;              \
+   t17 = t10 ^ t16; t18 = t13 ^ t17; t19 = t18 & a0;            \
+   t20 = t13 ^ t19; t21 = ~t10; t22 = t7 ^ t1;                  \
+   t23 = t22 & a4; t24 = t7 ^ t23; t25 = t21 ^ t24;             \
+   t26 = t25 & a3; t27 = t21 ^ t26; t28 = a1 & a4;              \
+   t29 = t1 ^ t28; t30 = t29 ^ t16; t31 = t27 ^ t30;            \
+   t32 = t31 & a0; t33 = t27 ^ t32; t34 = t20 ^ t33;            \
+   t35 = t34 & a2; t36 = t20 ^ t35; t37 = ~t1;                  \
+   t38 = a5 & a4; t39 = t1 ^ t38; t40 = t37 ^ t39;              \
+   t41 = t40 & a3; t42 = t37 ^ t41; t43 = ~t22;                 \
+   t44 = t43 ^ t38; t45 = t14 & a3; t46 = t44 ^ t45;            \
+   t47 = t42 ^ t46; t48 = t47 & a0; t49 = t42 ^ t48;            \
+   t50 = t43 ^ a4; t51 = t37 ^ a4; t52 = t7 & a3;               \
+   t53 = t50 ^ t52; t54 = t53 ^ a0; t55 = t49 ^ t54;            \
+   t56 = t55 & a2; t57 = t49 ^ t56; t58 = ~t3;                  \
+   t59 = t58 ^ a4; t60 = a5 & a3; t61 = t59 ^ t60;              \
+   t62 = a4 & ~t6; t63 = ~t62; t64 = ~t24; t65 = t63 ^ t64;     \
+   t66 = t65 & a3; t67 = t63 ^ t66; t68 = t61 ^ t67;            \
+   t69 = t68 & a0; t70 = t61 ^ t69; t71 = t44 & a3;             \
+   t72 = t64 ^ t71; t73 = ~t5; t74 = t73 ^ t26;                 \
+   t75 = t72 ^ t74; t76 = t75 & a0; t77 = t72 ^ t76;            \
+   t78 = t70 ^ t77; t79 = t78 & a2; t80 = t70 ^ t79;            \
+   t81 = t23 ^ t1; t82 = t81 & a3; t83 = t23 ^ t82;             \
+   t84 = t0 & a4; t85 = t28 & a3; t86 = t51 ^ t85;              \
+   t87 = t83 ^ t86; t88 = t87 & a0; t89 = t83 ^ t88;            \
+   t90 = t22 ^ t84; t91 = t0 ^ t62; t92 = t90 ^ t91;            \
+   t93 = t92 & a3; t94 = t90 ^ t93; t95 = t43 & a4;             \
+   t96 = t6 ^ t95; t97 = t8 ^ t62; t98 = t96 ^ t97;             \
+   t99 = t98 & a3; t100 = t96 ^ t99; t101 = t94 ^ t100;         \
+   t102 = t101 & a0; t103 = t94 ^ t102; t104 = t89 ^ t103;      \
+   t105 = t104 & a2; t106 = t89 ^ t105;                         \
+   d0 ^= t36; d1 ^= t57; d2 ^= t80; d3 ^= t106;                 \
+}
+
+/*!
+ * S-box 6, 102 gates
+ */
+#define _BS_S6(_T, _a0,_a1,_a2,_a3,_a4,_a5, d0,d1,d2,d3)        \
+{                                                               \
+   _T a0 = _a0, a1 = _a1, a2 = _a2, a3 = _a3, a4 = _a4, a5 = _a5;\
+   _T t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+      t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23,    \
+      t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34,    \
+      t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45,    \
+      t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56,    \
+      t57, t58, t59, t60, t61, t62, t63, t64, t65, t66, t67,    \
+      t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78,    \
+      t79, t80, t81, t82, t83, t84, t85, t86, t87, t88, t89,    \
+      t90, t91, t92, t93, t94, t95, t96, t97, t98, t99,         \
+      t100, t101;                                               \
+   t0 = ~a1; t1 = t0 ^ a4; t2 = t0 & a3; t3 = t1 ^ t2;          \
+   t4 = a1 ^ a3; t5 = t3 ^ t4; t6 = t5 & a2; t7 = t3 ^ t6;      \
+   t8 = ~t1; t9 = a1 & a4; t10 = t8 ^ t9; t11 = t10 & a3;       \
+   t12 = t8 ^ t11; t13 = ~t9; t14 = t13 ^ t11;                  \
+   t15 = t12 ^ t14; t16 = t15 & a2; t17 = t12 ^ t16;            \
+   t18 = t7 ^ t17; t19 = t18 & a5; t20 = t7 ^ t19;              \
+   t21 = ~t3; t22 = t0 | a4; t23 = t22 ^ a3;                    \
+   t24 = t21 ^ t23; t25 = t24 & a2; t26 = t21 ^ t25;            \
+   t27 = t1 ^ a3; t28 = a1 ^ t1; t29 = t28 & a3;                \
+   t30 = a1 ^ t29; t31 = t27 ^ t30; t32 = t31 & a2;             \
+   t33 = t27 ^ t32; t34 = t26 ^ t33; t35 = t34 & a5;            \
+   t36 = t26 ^ t35; t37 = t20 ^ t36; t38 = t37 & a0;            \
+   t39 = t20 ^ t38; t40 = a1 & a3; t41 = t8 ^ t40;              \
+   t42 = t30 ^ t41; t43 = t42 & a2; t44 = t30 ^ t43;            \
+   t45 = t1 & a3; t46 = t0 ^ t45; t47 = t28 ^ t2;               \
+   t48 = t46 ^ t47; t49 = t48 & a2; t50 = t46 ^ t49;            \
+   t51 = t44 ^ t50; t52 = t51 & a5; t53 = t44 ^ t52;            \
+   t54 = t10 & a2; t55 = t30 ^ t54; t56 = ~t47;                 \
+   t57 = a1 & a2; t58 = t21 ^ t57; t59 = t55 ^ t58;             \
+   t60 = t59 & a5; t61 = t55 ^ t60; t62 = t53 ^ t61;            \
+   t63 = t62 & a0; t64 = t53 ^ t63; t65 = t13 & a2;             \
+   t66 = t11 ^ t65; t67 = t13 & a3; t68 = t8 ^ t67;             \
+   t69 = t68 ^ a2; t70 = t66 ^ t69; t71 = t70 & a5;             \
+   t72 = t66 ^ t71; t73 = t22 & a2; t74 = t14 ^ t73;            \
+   t75 = t10 ^ t40; t76 = t75 ^ t65; t77 = t74 ^ t76;           \
+   t78 = t77 & a5; t79 = t74 ^ t78; t80 = t72 ^ t79;            \
+   t81 = t80 & a0; t82 = t72 ^ t81; t83 = ~t48; t84 = ~t42;     \
+   t85 = t83 ^ t84; t86 = t85 & a2; t87 = t83 ^ t86;            \
+   t88 = t85 & a5; t89 = t87 ^ t88; t90 = t84 ^ t56;            \
+   t91 = t90 & a2; t92 = t84 ^ t91; t93 = t22 & a3;             \
+   t94 = a4 ^ t93; t95 = t94 ^ t54; t96 = t92 ^ t95;            \
+   t97 = t96 & a5; t98 = t92 ^ t97; t99 = t89 ^ t98;            \
+   t100 = t99 & a0; t101 = t89 ^ t100;                          \
+   d0 ^= t39; d1 ^= t64; d2 ^= t82; d3 ^= t101;                 \
+}
+
+/*!
+ * S-box 7, 100 gates
+ */
+#define _BS_S7(_T, _a0,_a1,_a2,_a3,_a4,_a5, d0,d1,d2,d3)        \
+{                                                               \
+   _T a0 = _a0, a1 = _a1, a2 = _a2, a3 = _a3, a4 = _a4, a5 = _a5;\
+   _T t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+      t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23,    \
+      t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34,    \
+      t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45,    \
+      t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56,    \
+      t57, t58, t59, t60, t61, t62, t63, t64, t65, t66, t67,    \
+      t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78,    \
+      t79, t80, t81, t82, t83, t84, t85, t86, t87, t88, t89,    \
+      t90, t91, t92, t93, t94, t95, t96, t97, t98, t99;         \
+   t0 = ~a1; t1 = a1 ^ a4; t2 = a4 & a2; t3 = a1 ^ t2;          \
+   t4 = ~t1; t5 = ~a4; t6 = a1 & a2; t7 = t4 ^ t6;              \
+   t8 = t3 ^ t7; t9 = t8 & a3; t10 = t3 ^ t9;                   \
+   t11 = a4 & ~a1; t12 = ~t11; t13 = a4 ^ t12;                  \
+   t14 = t13 & a2; t15 = a4 ^ t14; t16 = t0 & ~a4;              \
+   t17 = t16 ^ t14; t18 = t15 ^ t17; t19 = t18 & a3;            \
+   t20 = t15 ^ t19; t21 = t10 ^ t20; t22 = t21 & a5;            \
+   t23 = t10 ^ t22; t24 = ~t3; t25 = t24 ^ a3;                  \
+   t26 = t18 & a2; t27 = t1 ^ t26; t28 = t11 ^ t26;             \
+   t29 = t27 ^ t28; t30 = t29 & a3; t31 = t27 ^ t30;            \
+   t32 = t25 ^ t31; t33 = t32 & a5; t34 = t25 ^ t33;            \
+   t35 = t23 ^ t34; t36 = t35 & a0; t37 = t23 ^ t36;            \
+   t38 = t27 ^ a3; t39 = t4 & a2; t40 = a4 ^ t39;               \
+   t41 = t29 ^ t39; t42 = t40 ^ t41; t43 = t42 & a3;            \
+   t44 = t40 ^ t43; t45 = t38 ^ t44; t46 = t45 & a5;            \
+   t47 = t38 ^ t46; t48 = a4 ^ a2; t49 = t39 & a3;              \
+   t50 = t48 ^ t49; t51 = t12 & a2; t52 = t5 ^ t51;             \
+   t53 = t52 ^ a3; t54 = t50 ^ t53; t55 = t54 & a5;             \
+   t56 = t50 ^ t55; t57 = t47 ^ t56; t58 = t57 & a0;            \
+   t59 = t47 ^ t58; t60 = t5 & a2; t61 = t4 ^ t60;              \
+   t62 = a4 & a3; t63 = t61 ^ t62; t64 = t63 ^ t10;             \
+   t65 = t64 & a5; t66 = t63 ^ t65; t67 = t0 ^ t51;             \
+   t68 = t16 & a2; t69 = t4 ^ t68; t70 = t67 ^ t69;             \
+   t71 = t70 & a3; t72 = t67 ^ t71; t73 = t1 ^ t2;              \
+   t74 = t4 ^ t73; t75 = t74 & a3; t76 = t4 ^ t75;              \
+   t77 = t72 ^ t76; t78 = t77 & a5; t79 = t72 ^ t78;            \
+   t80 = t66 ^ t79; t81 = t80 & a0; t82 = t66 ^ t81;            \
+   t83 = ~t7; t84 = t0 ^ a2; t85 = t83 ^ t84;                   \
+   t86 = t85 & a3; t87 = t83 ^ t86; t88 = t87 ^ a5;             \
+   t89 = t42 & a2; t90 = t4 ^ t89; t91 = t90 ^ t86;             \
+   t92 = ~t17; t93 = t92 ^ a3; t94 = t91 ^ t93;                 \
+   t95 = t94 & a5; t96 = t91 ^ t95; t97 = t88 ^ t96;            \
+   t98 = t97 & a0; t99 = t88 ^ t98;                             \
+   d0 ^= t37; d1 ^= t59; d2 ^= t82; d3 ^= t99;                  \
+}
+
+/*!
+ * S-box 8, 97 gates
+ */
+#define _BS_S8(_T, _a0,_a1,_a2,_a3,_a4,_a5, d0,d1,d2,d3)        \
+{                                                               \
+   _T a0 = _a0, a1 = _a1, a2 = _a2, a3 = _a3, a4 = _a4, a5 = _a5;\
+   _T t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12,    \
+      t13, t14, t15, t16, t17, t18, t19, t20, t21, t22, t23,    \
+      t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34,    \
+      t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45,    \
+      t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56,    \
+      t57, t58, t59, t60, t61, t62, t63, t64, t65, t66, t67,    \
+      t68, t69, t70, t71, t72, t73, t74, t75, t76, t77, t78,    \
+      t79, t80, t81, t82, t83, t84, t85, t86, t87, t88, t89,    \
+      t90, t91, t92, t93, t94, t95, t96;                        \
+   t0 = ~a1; t1 = t0 & ~a4; t2 = a4 & ~t0; t3 = ~t2;            \
+   t4 = t1 ^ t3; t5 = t4 & a3; t6 = t1 ^ t5; t7 = a1 ^ t5;      \
+   t8 = t6 ^ t7; t9 = t8 & a2; t10 = t6 ^ t9; t11 = ~t4;        \
+   t12 = t11 ^ a3; t13 = a4 & a3; t14 = t11 ^ t13;              \
+   t15 = t12 ^ t14; t16 = t15 & a2; t17 = t12 ^ t16;            \
+   t18 = t10 ^ t17; t19 = t18 & a5; t20 = t10 ^ t19;            \
+   t21 = ~t10; t22 = t0 & a3; t23 = a4 ^ t22;                   \
+   t24 = t23 ^ a2; t25 = t21 ^ t24; t26 = t25 & a5;             \
+   t27 = t21 ^ t26; t28 = t20 ^ t27; t29 = t28 & a0;            \
+   t30 = t20 ^ t29; t31 = ~t8; t32 = t31 ^ a3;                  \
+   t33 = t12 ^ t32; t34 = t33 & a2; t35 = t12 ^ t34;            \
+   t36 = ~a4; t37 = t36 ^ t33; t38 = t37 & a3;                  \
+   t39 = t36 ^ t38; t40 = t11 & a2; t41 = t39 ^ t40;            \
+   t42 = t35 ^ t41; t43 = t42 & a5; t44 = t35 ^ t43;            \
+   t45 = ~t33; t46 = t11 & a3; t47 = t8 ^ t46;                  \
+   t48 = t47 ^ t14; t49 = t48 & a2; t50 = t47 ^ t49;            \
+   t51 = a1 & a3; t52 = t4 ^ t51; t53 = ~t14; t54 = t5 & a2;    \
+   t55 = t52 ^ t54; t56 = t50 ^ t55; t57 = t56 & a5;            \
+   t58 = t50 ^ t57; t59 = t44 ^ t58; t60 = t59 & a0;            \
+   t61 = t44 ^ t60; t62 = t4 ^ t22; t63 = a1 & a2;              \
+   t64 = t62 ^ t63; t65 = t3 & a3; t66 = t8 ^ t65;              \
+   t67 = t66 ^ a2; t68 = t64 ^ t67; t69 = t68 & a5;             \
+   t70 = t64 ^ t69; t71 = t45 ^ t46; t72 = t71 ^ t23;           \
+   t73 = t72 & a2; t74 = t71 ^ t73; t75 = t0 ^ t15;             \
+   t76 = t53 & a2; t77 = t75 ^ t76; t78 = t74 ^ t77;            \
+   t79 = t78 & a5; t80 = t74 ^ t79; t81 = t70 ^ t80;            \
+   t82 = t81 & a0; t83 = t70 ^ t82; t84 = t33 ^ a3;             \
+   t85 = t84 ^ t14; t86 = t85 & a2; t87 = t84 ^ t86;            \
+   t88 = t37 & a2; t89 = t48 ^ t88; t90 = t87 ^ t89;            \
+   t91 = t90 & a5; t92 = t87 ^ t91; t93 = ~t44;                 \
+   t94 = t92 ^ t93; t95 = t94 & a0; t96 = t92 ^ t95;            \
+   d0 ^= t30; d1 ^= t61; d2 ^= t83; d3 ^= t96;                  \
+}
+
+/*!
+ * Bitsliced DES round, the slice form of DES_ROUND (s, d)
+ */
+#define _BS_ROUND(_T, s, d, k0, k1)                             \
+{                                                               \
+   _T _z = {0};                                                 \
+   _BS_S8 (_T, s[0]^_K(k0,0), s[1]^_K(k0,1), s[2]^_K(k0,2),     \
+      s[3]^_K(k0,3), s[4]^_K(k0,4), s[5]^_K(k0,5),              \
+      d[6], d[12], d[18], d[28]);                               \
+   _BS_S7 (_T, s[4]^_K(k1,0), s[5]^_K(k1,1), s[6]^_K(k1,2),     \
+      s[7]^_K(k1,3), s[8]^_K(k1,4), s[9]^_K(k1,5),              \
+      d[1], d[11], d[21], d[26]);                               \
+   _BS_S6 (_T, s[8]^_K(k0,8), s[9]^_K(k0,9), s[10]^_K(k0,10),   \
+      s[11]^_K(k0,11), s[12]^_K(k0,12), s[13]^_K(k0,13),        \
+      d[4], d[14], d[22], d[29]);                               \
+   _BS_S5 (_T, s[12]^_K(k1,8), s[13]^_K(k1,9), s[14]^_K(k1,10), \
+      s[15]^_K(k1,11), s[16]^_K(k1,12), s[17]^_K(k1,13),        \
+      d[8], d[19], d[25], d[30]);                               \
+   _BS_S4 (_T, s[16]^_K(k0,16), s[17]^_K(k0,17), s[18]^_K(k0,18),\
+      s[19]^_K(k0,19), s[20]^_K(k0,20), s[21]^_K(k0,21),        \
+      d[0], d[7], d[13], d[23]);                                \
+   _BS_S3 (_T, s[20]^_K(k1,16), s[21]^_K(k1,17), s[22]^_K(k1,18),\
+      s[23]^_K(k1,19), s[24]^_K(k1,20), s[25]^_K(k1,21),        \
+      d[3], d[9], d[17], d[27]);                                \
+   _BS_S2 (_T, s[24]^_K(k0,24), s[25]^_K(k0,25), s[26]^_K(k0,26),\
+      s[27]^_K(k0,27), s[28]^_K(k0,28), s[29]^_K(k0,29),        \
+      d[5], d[15], d[20], d[31]);                               \
+   _BS_S1 (_T, s[28]^_K(k1,24), s[29]^_K(k1,25), s[30]^_K(k1,26),\
+      s[31]^_K(k1,27), s[0]^_K(k1,28), s[1]^_K(k1,29),          \
+      d[2], d[10], d[16], d[24]);                               \
+}
+
+/*!
+ * \brief
+ *    The bitsliced DES/3DES rounds on 64 X, Y slices of type _T
+ */
+#define _BS_CORE(_name, _T, _attr)                              \
+_attr                                                           \
+static void _name (_T st[64], const uint32_t *sk, int stages)   \
+{                                                               \
+   _T *x = st, *y = &st[32], *t;                                \
+   int i;                                                       \
+                                                                \
+   for ( ; stages ; --stages) {                                 \
+      for (i=0 ; i<8 ; ++i, sk += 4) {                          \
+         _BS_ROUND (_T, y, x, sk[0], sk[1]);                    \
+         _BS_ROUND (_T, x, y, sk[2], sk[3]);                    \
+      }                                                         \
+      /* The 3DES middle stage runs with X, Y swapped */        \
+      t = x; x = y; y = t;                                      \
+   }                                                            \
+}
+
+/*!
+ * \brief
+ *    Transpose a 64x64 bit matrix in place
+ */
+static void _bs_transpose (uint64_t a[64])
+{
+   uint64_t m = 0x00000000FFFFFFFF, t;
+   int j, k;
+
+   for (j=32 ; j ; j >>= 1, m ^= m << j) {
+      for (k=0 ; k<64 ; k = (k + j + 1) & ~j) {
+         t = (a[k] ^ (a[k+j] >> j)) & m;
+         a[k] ^= t;
+         a[k+j] ^= t << j;
+      }
+   }
+}
+
+/*!
+ * \brief
+ *    Load up to 64 blocks and transpose them to slices
+ */
+static void _bs_load (uint64_t a[64], const uint8_t *in, size_t blocks)
+{
+   size_t j;
+
+   for (j=0 ; j<blocks ; ++j)
+      GET_UINT64_BE (a[j], in, 8*j);
+   for ( ; j<64 ; ++j)
+      a[j] = 0;
+   _bs_transpose (a);
+}
+
+/*!
+ * \brief
+ *    Transpose the slices back to blocks and store up to 64 of them
+ */
+static void _bs_store (uint64_t a[64], uint8_t *out, size_t blocks)
+{
+   size_t j;
+
+   _bs_transpose (a);
+   for (j=0 ; j<blocks ; ++j)
+      PUT_UINT64_BE (a[j], out, 8*j);
+}
+
+_BS_CORE (_bs_core64, uint64_t, __O3__)
+
+/*!
+ * \brief
+ *    Encrypt/decrypt up to 64 blocks in 64-bit slices
+ *
+ * \param sk      the sub-keys
+ * \param stages  1 for DES, 3 for 3DES
+ * \param in      the input blocks
+ * \param out     the output blocks, can be the input
+ * \param blocks  the number of blocks, up to 64
+ */
+static void _bs_crypt64 (const uint32_t *sk, int stages, const uint8_t *in, uint8_t *out, size_t blocks)
+{
+   uint64_t a[64], st[64];
+   int i;
+
+   _bs_load (a, in, blocks);
+   for (i=0 ; i<64 ; ++i)
+      st[i] = a[_bs_ip[i]];
+   _bs_core64 (st, sk, stages);
+   for (i=0 ; i<64 ; ++i)
+      a[i] = st[_bs_fp[i]];
+   _bs_store (a, out, blocks);
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define _BS_AVX2
+#define _BS_AVX2_TARGET    __attribute__ ((target ("avx2")))
+#define _BS_WAY            (256)    /*!< The widest batch */
+
+typedef uint64_t _bs256_t __attribute__ ((vector_size (32)));
+
+_BS_CORE (_bs_core256, _bs256_t, _BS_AVX2_TARGET __O3__)
+
+/*!
+ * \brief
+ *    Check once if the CPU has AVX2
+ */
+static int _bs_avx2_avail (void)
+{
+   static int avail = -1;
+
+   if (avail < 0)
+      avail = __builtin_cpu_supports ("avx2") ? 1:0;
+   return avail;
+}
+
+/*!
+ * \brief
+ *    Encrypt/decrypt up to 256 blocks in 256-bit slices, four
+ *    64 block lanes.
+ */
+_BS_AVX2_TARGET
+static void _bs_crypt256 (const uint32_t *sk, int stages, const uint8_t *in, uint8_t *out, size_t blocks)
+{
+   uint64_t a[4][64];
+   _bs256_t st[64];
+   size_t   n, l;
+   int i;
+
+   for (l=0 ; l<4 ; ++l) {
+      n = (blocks > 64*l) ? blocks - 64*l : 0;
+      _bs_load (a[l], &in[8*64*l], (n < 64) ? n : 64);
+   }
+   for (i=0 ; i<64 ; ++i)
+      st[i] = (_bs256_t){ a[0][_bs_ip[i]], a[1][_bs_ip[i]], a[2][_bs_ip[i]], a[3][_bs_ip[i]] };
+   _bs_core256 (st, sk, stages);
+   for (i=0 ; i<64 ; ++i)
+      for (l=0 ; l<4 ; ++l)
+         a[l][i] = st[_bs_fp[i]][l];
+   for (l=0 ; l<4 && blocks > 64*l ; ++l) {
+      n = blocks - 64*l;
+      _bs_store (a[l], &out[8*64*l], (n < 64) ? n : 64);
+   }
+}
+#else
+#define _BS_WAY            (64)
+#endif   // #if ... __x86_64__
+
+/*!
+ * \brief
+ *    Encrypt/decrypt a batch of blocks with the widest engine that pays off
+ * \return  the number of processed blocks
+ */
+static size_t _bs_crypt (const uint32_t *sk, int stages, const uint8_t *in, uint8_t *out, size_t blocks)
+{
+#if defined(_BS_AVX2)
+   if (blocks >= 128 && _bs_avx2_avail ()) {
+      if (blocks > 256)
+         blocks = 256;
+      _bs_crypt256 (sk, stages, in, out, blocks);
+      return blocks;
+   }
+#endif
+   if (blocks > 64)
+      blocks = 64;
+   _bs_crypt64 (sk, stages, in, out, blocks);
+   return blocks;
+}
+
+#define _DES_BATCH         _BS_WAY  /*!< Blocks of the mode buffers */
+#else
+#define _DES_BATCH         (1)
+#endif   // #if DES_BITSLICE
+
+/*!
+ * \brief
+ *    DES/3DES block encryption/decryption with unrolled rounds
+ * \param SK       the sub-keys
+ * \param stages   1 for DES, 3 for 3DES
+ * \param input    64-bit input block
+ * \param output   64-bit output block
+ */
+static void _crypt (const uint32_t *SK, int stages, const uint8_t input[8], uint8_t output[8])
+{
+   uint32_t X, Y, T;
+
+   GET_UINT32_BE (X, input, 0);
+   GET_UINT32_BE (Y, input, 4);
+
+   DES_IP (X, Y);
+   DES_ROUNDS (Y, X);
+   if (stages > 1) {
+      DES_ROUNDS (X, Y);
+      DES_ROUNDS (Y, X);
+   }
+   DES_FP (Y, X);
+
+   PUT_UINT32_BE (Y, output, 0);
+   PUT_UINT32_BE (X, output, 4);
+}
+
+/*!
+ * Below this number of blocks the bitsliced engine does not pay off
+ */
+#define _DES_BS_MIN        (24)
+
+/*!
+ * \brief
+ *    ECB on whole blocks, bitsliced when there are enough of them.
+ *    The input and output buffer can be the same.
+ */
+static void _ecb (const uint32_t *sk, int stages, const uint8_t *in, uint8_t *out, size_t blocks)
+{
+#if DES_BITSLICE
+   size_t n;
+
+   while (blocks >= _DES_BS_MIN) {
+      n = _bs_crypt (sk, stages, in, out, blocks);
+      in += 8*n;
+      out += 8*n;
+      blocks -= n;
+   }
+#endif
+   for ( ; blocks ; --blocks, in += 8, out += 8)
+      _crypt (sk, stages, in, out);
+}
+
+/*!
+ * \brief
+ *    CBC encryption engine. The chain is serial, so it runs on
+ *    the scalar path.
+ */
+static int _cbc_enc (const uint32_t *sk, int stages, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len)
+{
+   int i;
+
+   if (len % 8)
+      return 0;
+   for ( ; len ; len -= 8, in += 8, out += 8) {
+      for (i=0 ; i<8 ; ++i)
+         out[i] = in[i] ^ iv[i];
+      _crypt (sk, stages, out, out);
+      memcpy ((void*)iv, (const void*)out, 8);
+   }
+   return 1;
+}
+
+/*!
+ * \brief
+ *    CBC decryption engine. The blocks are independent, so they are
+ *    decrypted in batches and chained afterwards.
+ */
+static int _cbc_dec (const uint32_t *sk, int stages, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len)
+{
+   uint8_t c[8*_DES_BATCH];
+   size_t  i, n;
+
+   if (len % 8)
+      return 0;
+   for ( ; len ; len -= n, in += n, out += n) {
+      n = (len < sizeof (c)) ? len : sizeof (c);
+      memcpy ((void*)c, (const void*)in, n);
+      _ecb (sk, stages, c, out, n/8);
+      for (i=0 ; i<8 ; ++i)
+         out[i] ^= iv[i];
+      for (i=8 ; i<n ; ++i)
+         out[i] ^= c[i-8];
+      memcpy ((void*)iv, (const void*)&c[n-8], 8);
+   }
+   return 1;
+}
+
+/*!
+ * \brief
+ *    CTR engine with 64 bit big endian counter. The key stream is
+ *    made in batches. A partial last block consumes a whole counter.
+ */
+static void _ctr (const uint32_t *sk, int stages, uint8_t ctr[8], const uint8_t *in, uint8_t *out, size_t len)
+{
+   uint8_t  ks[8*_DES_BATCH];
+   uint64_t cnt;
+   size_t   i, n, blocks;
+
+   GET_UINT64_BE (cnt, ctr, 0);
+   for ( ; len ; len -= n, in += n, out += n) {
+      blocks = (len + 7) / 8;
+      if (blocks > _DES_BATCH)
+         blocks = _DES_BATCH;
+      for (i=0 ; i<blocks ; ++i, ++cnt)
+         PUT_UINT64_BE (cnt, ks, 8*i);
+      _ecb (sk, stages, ks, ks, blocks);
+      n = (len < 8*blocks) ? len : 8*blocks;
+      for (i=0 ; i<n ; ++i)
+         out[i] = in[i] ^ ks[i];
+   }
+   PUT_UINT64_BE (cnt, ctr, 0);
+}
+
 
 /*
  * ============================ Public Functions ============================
@@ -598,23 +1391,7 @@ void des3_set3key_dec (des3_t *ctx, const uint8_t key[24])
  */
 void des_crypt_ecb (des_t *ctx, const uint8_t input[8], uint8_t output[8])
 {
-   int i;
-   uint32_t X, Y, T, *SK;
-
-   SK = ctx->sk;
-
-   GET_UINT32_BE (X, input, 0);
-   GET_UINT32_BE (Y, input, 4);
-
-   DES_IP (X, Y);
-   for (i = 0; i < 8; ++i) {
-      DES_ROUND (Y, X);
-      DES_ROUND (X, Y);
-   }
-   DES_FP (Y, X);
-
-   PUT_UINT32_BE (Y, output, 0);
-   PUT_UINT32_BE (X, output, 4);
+   _crypt (ctx->sk, 1, input, output);
 }
 
 /*!
@@ -627,29 +1404,120 @@ void des_crypt_ecb (des_t *ctx, const uint8_t input[8], uint8_t output[8])
  */
 void des3_crypt_ecb (des3_t *ctx, const uint8_t input[8], uint8_t output[8])
 {
-   int i;
-   uint32_t X, Y, T, *SK;
+   _crypt (ctx->sk, 3, input, output);
+}
 
-   SK = ctx->sk;
+/*
+ * Block cipher modes
+ */
 
-   GET_UINT32_BE (X, input, 0);
-   GET_UINT32_BE (Y, input, 4);
+/*!
+ * \brief
+ *    DES-ECB on many blocks. On 64-bit targets the blocks run in
+ *    the bitsliced engine.
+ * \note
+ *    The input and output buffer can be the same.
+ *
+ * \param ctx     DES context, with the encryption or the decryption key
+ * \param in      buffer holding the input data
+ * \param out     buffer for the output data
+ * \param len     the data length, multiple of 8
+ * \return        1 on success, 0 if len is not a multiple of 8
+ */
+int des_ecb (des_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+   if (len % 8)
+      return 0;
+   _ecb (ctx->sk, 1, in, out, len/8);
+   return 1;
+}
 
-   DES_IP (X, Y);
-   for (i = 0; i < 8; ++i) {
-      DES_ROUND (Y, X);
-      DES_ROUND (X, Y);
-   }
-   for( i = 0; i < 8; ++i ) {
-      DES_ROUND (X, Y);
-      DES_ROUND (Y, X);
-   }
-   for( i = 0; i < 8; i++ ) {
-      DES_ROUND (Y, X);
-      DES_ROUND (X, Y);
-   }
-   DES_FP( Y, X );
+/*!
+ * \brief
+ *    DES-CBC encryption.
+ * \note
+ *    The input and output buffer can be the same.
+ *
+ * \param ctx     DES context with the encryption key
+ * \param iv      the initialisation vector. It is updated so a next call continues the chain
+ * \param in      buffer holding the plaintext
+ * \param out     buffer for the ciphertext
+ * \param len     the data length, multiple of 8
+ * \return        1 on success, 0 if len is not a multiple of 8
+ */
+int des_cbc_encrypt (des_t *ctx, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len) {
+   return _cbc_enc (ctx->sk, 1, iv, in, out, len);
+}
 
-   PUT_UINT32_BE (Y, output, 0);
-   PUT_UINT32_BE (X, output, 4);
+/*!
+ * \brief
+ *    DES-CBC decryption.
+ * \note
+ *    The input and output buffer can be the same.
+ *
+ * \param ctx     DES context with the decryption key
+ * \param iv      the initialisation vector. It is updated so a next call continues the chain
+ * \param in      buffer holding the ciphertext
+ * \param out     buffer for the plaintext
+ * \param len     the data length, multiple of 8
+ * \return        1 on success, 0 if len is not a multiple of 8
+ */
+int des_cbc_decrypt (des_t *ctx, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len) {
+   return _cbc_dec (ctx->sk, 1, iv, in, out, len);
+}
+
+/*!
+ * \brief
+ *    DES-CTR encryption/decryption (SP 800-38A), with 64 bit
+ *    big endian counter increment.
+ * \note
+ *    The input and output buffer can be the same. The counter is updated,
+ *    so a stream can be processed in pieces of multiple of 8 bytes. A partial
+ *    last block consumes a whole counter.
+ *
+ * \param ctx     DES context with the encryption key
+ * \param ctr     the counter block
+ * \param in      buffer holding the input data
+ * \param out     buffer for the output data
+ * \param len     the data length
+ * \return        none
+ */
+void des_ctr (des_t *ctx, uint8_t ctr[8], const uint8_t *in, uint8_t *out, size_t len) {
+   _ctr (ctx->sk, 1, ctr, in, out, len);
+}
+
+/*!
+ * \brief
+ *    3DES-ECB on many blocks, see \sa des_ecb()
+ */
+int des3_ecb (des3_t *ctx, const uint8_t *in, uint8_t *out, size_t len)
+{
+   if (len % 8)
+      return 0;
+   _ecb (ctx->sk, 3, in, out, len/8);
+   return 1;
+}
+
+/*!
+ * \brief
+ *    3DES-CBC encryption, see \sa des_cbc_encrypt()
+ */
+int des3_cbc_encrypt (des3_t *ctx, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len) {
+   return _cbc_enc (ctx->sk, 3, iv, in, out, len);
+}
+
+/*!
+ * \brief
+ *    3DES-CBC decryption, see \sa des_cbc_decrypt()
+ */
+int des3_cbc_decrypt (des3_t *ctx, uint8_t iv[8], const uint8_t *in, uint8_t *out, size_t len) {
+   return _cbc_dec (ctx->sk, 3, iv, in, out, len);
+}
+
+/*!
+ * \brief
+ *    3DES-CTR encryption/decryption, see \sa des_ctr()
+ */
+void des3_ctr (des3_t *ctx, uint8_t ctr[8], const uint8_t *in, uint8_t *out, size_t len) {
+   _ctr (ctx->sk, 3, ctr, in, out, len);
 }
@@ -44,10 +44,7 @@ static const uint8_t md5_padding[64] =
 };
 
 // Static functions
-static void md5_pre (md5_t *ctx);
 static void md5_process (md5_t *ctx, const uint8_t data[64]);
-static void md5_update (md5_t *ctx, const uint8_t *input, size_t ilen);
-static void md5_finish (md5_t *ctx, uint8_t output[16]);
 
 
 /*!
@@ -55,7 +52,7 @@ static void md5_finish (md5_t *ctx, uint8_t output[16]);
  *    MD5 context setup
  * \param ctx      context to be initialised
  */
-static void md5_pre( md5_t *ctx )
+void md5_init (md5_t *ctx)
 {
     ctx->total[0] = 0;
     ctx->total[1] = 0;
@@ -187,7 +184,7 @@ static void md5_process (md5_t *ctx, const uint8_t data[64])
  * \param input    buffer holding the  data
  * \param ilen     length of the input data
  */
-static void md5_update (md5_t *ctx, const uint8_t *input, size_t ilen)
+void md5_update (md5_t *ctx, const uint8_t *input, size_t ilen)
 {
    size_t fill;
    uint32_t left;
@@ -227,7 +224,7 @@ static void md5_update (md5_t *ctx, const uint8_t *input, size_t ilen)
  * \param ctx      MD5 context
  * \param output   MD5 checksum result
  */
-static void md5_finish (md5_t *ctx, uint8_t output[16])
+void md5_finish (md5_t *ctx, uint8_t output[16])
 {
    uint32_t last, padn;
    uint32_t high, low;
@@ -269,7 +266,7 @@ void md5 (const uint8_t *input, size_t ilen, uint8_t output[16])
 {
    md5_t ctx;
 
-   md5_pre (&ctx);
+   md5_init (&ctx);
    md5_update (&ctx, input, ilen);
    md5_finish (&ctx, output);
 
@@ -52,10 +52,7 @@ static const uint8_t sha1_padding[64] =
 
 
 // Static functions
-static void     sha1_pre (sha1_t *ctx);
 static void sha1_process (sha1_t* ctx, const uint8_t data[64]);
-static void  sha1_update (sha1_t *ctx, const uint8_t *input, size_t ilen);
-static void  sha1_finish (sha1_t *ctx, uint8_t output[32]);
 
 /*!
  * \brief
@@ -63,7 +60,7 @@ static void  sha1_finish (sha1_t *ctx, uint8_t output[32]);
  *
  * \param ctx  context to be initialised
  */
-static void sha1_pre (sha1_t *ctx)
+void sha1_init (sha1_t *ctx)
 {
    ctx->total[0] = 0;
    ctx->total[1] = 0;
@@ -214,7 +211,7 @@ static void sha1_process (sha1_t* ctx, const uint8_t data[64])
  * \param input    buffer holding the  data
  * \param ilen     length of the input data
  */
-static void sha1_update (sha1_t *ctx, const uint8_t *in, size_t ilen)
+void sha1_update (sha1_t *ctx, const uint8_t *in, size_t ilen)
 {
    size_t fill;
    uint32_t left;
@@ -256,7 +253,7 @@ static void sha1_update (sha1_t *ctx, const uint8_t *in, size_t ilen)
  * \param ctx      SHA-1 context
  * \param output   SHA-1 checksum result
  */
-static void sha1_finish (sha1_t *ctx, uint8_t out[20])
+void sha1_finish (sha1_t *ctx, uint8_t out[20])
 {
    uint32_t last, padn;
    uint32_t high, low;
@@ -298,7 +295,7 @@ void sha1 (const uint8_t *input, size_t ilen, uint8_t output[20])
 {
    sha1_t ctx;
 
-   sha1_pre (&ctx);
+   sha1_init (&ctx);
    sha1_update (&ctx, input, ilen);
    sha1_finish (&ctx, output);
 
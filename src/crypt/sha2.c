@@ -26,6 +26,7 @@
  *
  */
 #include <crypt/sha2.h>
+#include <toolbox_defs.h>
 
 #define SHR(x,n)  ((x & 0xFFFFFFFF) >> n)
 #define ROTR(x,n) (SHR(x,n) | (x << (32 - n)))
@@ -61,13 +62,143 @@ static const uint8_t sha2_padding[64] =
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
+static const uint32_t sha2_K[64] =
+{
+   0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+   0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+   0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+   0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+   0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+   0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+   0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+   0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static const uint32_t sha2_H256[8] =
+{
+   0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+/*
+ * ============ SHA extensions ============
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#include <cpuid.h>
+#define _SHA2_NI
+
+static int _sha2_ni_on = 1;         /*!< The backend is selected, see sha2_ni_enable() */
+
+/*!
+ * \brief
+ *    Four rounds of SHA-256 with the SHA extensions. The message
+ *    schedule of the next groups is calculated in between.
+ *
+ * \param _g      The round group, rounds 4*_g .. 4*_g+3
+ * \param _cur    The message words of this group
+ * \param _nxt    The message words of next group, completed here (_m2)
+ * \param _prv    The message words of the previous group
+ * \param _m2     Complete the next group's words
+ * \param _m1     Start the words of the group after 3 groups
+ */
+#define _ni_rounds(_g, _cur, _nxt, _prv, _m2, _m1) {                          \
+   msg = _mm_add_epi32 (_cur, _mm_loadu_si128 ((const __m128i*)&sha2_K[4*(_g)])); \
+   st1 = _mm_sha256rnds2_epu32 (st1, st0, msg);                               \
+   if (_m2) {                                                                 \
+      tmp = _mm_alignr_epi8 (_cur, _prv, 4);                                  \
+      _nxt = _mm_add_epi32 (_nxt, tmp);                                       \
+      _nxt = _mm_sha256msg2_epu32 (_nxt, _cur);                               \
+   }                                                                          \
+   msg = _mm_shuffle_epi32 (msg, 0x0E);                                       \
+   st0 = _mm_sha256rnds2_epu32 (st0, st1, msg);                               \
+   if (_m1)                                                                   \
+      _prv = _mm_sha256msg1_epu32 (_prv, _cur);                               \
+}
+
+/*!
+ * \brief
+ *    Process consecutive 64 byte blocks with the SHA extensions
+ *
+ * \param state    The SHA-256 state
+ * \param data     The data blocks
+ * \param blocks   The number of blocks
+ */
+__attribute__ ((target ("sha,sse4.1")))
+static void _sha2_process_ni (uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+   const __m128i mask = _mm_set_epi64x (0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+   __m128i st0, st1, msg, tmp, m0, m1, m2, m3, abef, cdgh;
+
+   // Load state as ABEF, CDGH
+   tmp = _mm_loadu_si128 ((const __m128i*)&state[0]);
+   st1 = _mm_loadu_si128 ((const __m128i*)&state[4]);
+   tmp = _mm_shuffle_epi32 (tmp, 0xB1);         // CDAB
+   st1 = _mm_shuffle_epi32 (st1, 0x1B);         // EFGH
+   st0 = _mm_alignr_epi8 (tmp, st1, 8);         // ABEF
+   st1 = _mm_blend_epi16 (st1, tmp, 0xF0);      // CDGH
+
+   for ( ; blocks ; --blocks, data += 64) {
+      abef = st0;
+      cdgh = st1;
+      m0 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*)(data +  0)), mask);
+      m1 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*)(data + 16)), mask);
+      m2 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*)(data + 32)), mask);
+      m3 = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*)(data + 48)), mask);
+
+      _ni_rounds ( 0, m0, m1, m3, 0, 0);
+      _ni_rounds ( 1, m1, m2, m0, 0, 1);
+      _ni_rounds ( 2, m2, m3, m1, 0, 1);
+      _ni_rounds ( 3, m3, m0, m2, 1, 1);
+      _ni_rounds ( 4, m0, m1, m3, 1, 1);
+      _ni_rounds ( 5, m1, m2, m0, 1, 1);
+      _ni_rounds ( 6, m2, m3, m1, 1, 1);
+      _ni_rounds ( 7, m3, m0, m2, 1, 1);
+      _ni_rounds ( 8, m0, m1, m3, 1, 1);
+      _ni_rounds ( 9, m1, m2, m0, 1, 1);
+      _ni_rounds (10, m2, m3, m1, 1, 1);
+      _ni_rounds (11, m3, m0, m2, 1, 1);
+      _ni_rounds (12, m0, m1, m3, 1, 1);
+      _ni_rounds (13, m1, m2, m0, 1, 0);
+      _ni_rounds (14, m2, m3, m1, 1, 0);
+      _ni_rounds (15, m3, m0, m2, 0, 0);
+
+      st0 = _mm_add_epi32 (st0, abef);
+      st1 = _mm_add_epi32 (st1, cdgh);
+   }
+
+   // Store state back as ABCD, EFGH
+   tmp = _mm_shuffle_epi32 (st0, 0x1B);         // FEBA
+   st1 = _mm_shuffle_epi32 (st1, 0xB1);         // DCHG
+   st0 = _mm_blend_epi16 (tmp, st1, 0xF0);      // DCBA
+   st1 = _mm_alignr_epi8 (st1, tmp, 8);         // HGFE
+   _mm_storeu_si128 ((__m128i*)&state[0], st0);
+   _mm_storeu_si128 ((__m128i*)&state[4], st1);
+}
+
+/*!
+ * \brief
+ *    Check once if the CPU has the SHA extensions (and SSE4.1)
+ */
+static int _sha2_ni_avail (void)
+{
+   static int avail = -1;
+   unsigned int a, b, c, d;
+
+   if (avail < 0) {
+      avail = 0;
+      if (__get_cpuid (1, &a, &b, &c, &d) && (c & bit_SSE4_1)
+       && __get_cpuid_count (7, 0, &a, &b, &c, &d) && (b & bit_SHA))
+         avail = 1;
+   }
+   return avail && _sha2_ni_on;
+}
+#endif
+
 
 // Static functions
-static void sha2_pre (sha2_t *ctx, sha2_size sz);
 static void sha2_process (sha2_t* ctx, const uint8_t data[64]);
-static void sha2_update (sha2_t *ctx, const uint8_t *input, size_t ilen);
-static void sha2_finish (sha2_t *ctx, uint8_t output[32]);
-static void sha2 (uint8_t *in, size_t ilen, uint8_t out[32], sha2_size sz);
+static void sha2_blocks (sha2_t* ctx, const uint8_t *data, size_t blocks);
+static void sha2 (uint8_t *in, size_t ilen, uint8_t *out, sha2_size sz);
 
 /*!
  * \brief
@@ -78,7 +209,7 @@ static void sha2 (uint8_t *in, size_t ilen, uint8_t out[32], sha2_size sz);
  *    \arg     SHA2_224
  *    \arg     SHA2_256
  */
-static void sha2_pre (sha2_t *ctx, sha2_size sz)
+void sha2_init (sha2_t *ctx, sha2_size sz)
 {
    ctx->sz = sz;
    ctx->total[0] = ctx->total[1] = 0;
@@ -222,6 +353,180 @@ static void sha2_process (sha2_t* ctx, const uint8_t data[64])
    ctx->state[7] += H;
 }
 
+/*!
+ * \brief
+ *    Process consecutive 64 byte blocks. It uses the SHA extensions
+ *    when the CPU has them.
+ * \param ctx      context to use
+ * \param data     data to process
+ * \param blocks   the number of blocks
+ */
+static void sha2_blocks (sha2_t* ctx, const uint8_t *data, size_t blocks)
+{
+#if defined(_SHA2_NI)
+   if (_sha2_ni_avail ()) {
+      _sha2_process_ni (ctx->state, data, blocks);
+      return;
+   }
+#endif
+   for ( ; blocks ; --blocks, data += 64)
+      sha2_process (ctx, data);
+}
+
+/*
+ * ============ Multi-buffer SHA-256 ============
+ */
+
+#if defined(__GNUC__)
+/*
+ * One vector element per lane. The compiler maps it to the target's SIMD
+ * registers, or splits it in scalar operations.
+ */
+typedef uint32_t _sha2_vec_t __attribute__ ((vector_size (4*SHA2_MB_LANES)));
+
+#define _VROTR(x,n)  (((x) >> (n)) | ((x) << (32 - (n))))
+#define _VS0(x)      (_VROTR(x, 7) ^ _VROTR(x,18) ^ ((x) >>  3))
+#define _VS1(x)      (_VROTR(x,17) ^ _VROTR(x,19) ^ ((x) >> 10))
+#define _VS2(x)      (_VROTR(x, 2) ^ _VROTR(x,13) ^ _VROTR(x,22))
+#define _VS3(x)      (_VROTR(x, 6) ^ _VROTR(x,11) ^ _VROTR(x,25))
+
+/*!
+ * \brief
+ *    Process one block on each of SHA2_MB_LANES independent states.
+ *    Each lane computes the rounds of its own block in one vector element.
+ *    The lanes with zero in mask keep their state.
+ *
+ * \param st       The states, one vector per state word
+ * \param blk      Pointer to each lane's block
+ * \param m        All ones for the active lanes, zero for the others
+ */
+static void _sha2_process_mb (_sha2_vec_t st[8], const uint8_t *blk[SHA2_MB_LANES], const uint32_t m[SHA2_MB_LANES]) __O3__ __SIMD__ ;
+
+static void _sha2_process_mb (_sha2_vec_t st[8], const uint8_t *blk[SHA2_MB_LANES], const uint32_t m[SHA2_MB_LANES])
+{
+   _sha2_vec_t W[64], A, B, C, D, E, F, G, H, t1, t2, mask;
+   uint32_t w[SHA2_MB_LANES];
+   int t, l;
+
+   memcpy ((void*)&mask, (const void*)m, sizeof (mask));
+
+   // Transpose the blocks, lane l of W[t] is word t of block l
+   for (t=0 ; t<16 ; ++t) {
+      for (l=0 ; l<SHA2_MB_LANES ; ++l)
+         GET_UINT32_BE (w[l], blk[l], 4*t);
+      memcpy ((void*)&W[t], (const void*)w, sizeof (w));
+   }
+   for (t=16 ; t<64 ; ++t)
+      W[t] = _VS1(W[t-2]) + W[t-7] + _VS0(W[t-15]) + W[t-16];
+
+   A = st[0]; B = st[1]; C = st[2]; D = st[3];
+   E = st[4]; F = st[5]; G = st[6]; H = st[7];
+   for (t=0 ; t<64 ; ++t) {
+      t1 = H + _VS3(E) + (G ^ (E & (F ^ G))) + sha2_K[t] + W[t];
+      t2 = _VS2(A) + ((A & B) | (C & (A | B)));
+      H = G; G = F; F = E; E = D + t1;
+      D = C; C = B; B = A; A = t1 + t2;
+   }
+   st[0] += A & mask;   st[1] += B & mask;
+   st[2] += C & mask;   st[3] += D & mask;
+   st[4] += E & mask;   st[5] += F & mask;
+   st[6] += G & mask;   st[7] += H & mask;
+}
+#else
+/*
+ * No vector extension, one state word per lane
+ */
+typedef struct {
+   uint32_t l[SHA2_MB_LANES];
+}_sha2_vec_t;
+
+/*!
+ * \brief
+ *    Process one block on each of SHA2_MB_LANES independent states, one
+ *    lane after the other with the scalar rounds. \see the vector version
+ */
+static void _sha2_process_mb (_sha2_vec_t st[8], const uint8_t *blk[SHA2_MB_LANES], const uint32_t m[SHA2_MB_LANES])
+{
+   sha2_t c;
+   int k, l;
+
+   for (l=0 ; l<SHA2_MB_LANES ; ++l) {
+      if (!m[l])
+         continue;
+      for (k=0 ; k<8 ; ++k)
+         c.state[k] = st[k].l[l];
+      sha2_process (&c, blk[l]);
+      for (k=0 ; k<8 ; ++k)
+         st[k].l[l] = c.state[k];
+   }
+}
+#endif
+
+/*!
+ * \brief
+ *    Hash up to SHA2_MB_LANES messages in parallel lanes
+ *
+ * \param in      The messages
+ * \param ilen    The message lengths
+ * \param out     The SHA-256 results
+ * \param n       The number of messages, up to SHA2_MB_LANES
+ */
+static void _sha256_mb (const uint8_t *in[], const size_t ilen[], uint8_t *out[], uint32_t n)
+{
+   _sha2_vec_t st[8];
+   uint8_t  tail[SHA2_MB_LANES][128];
+   const uint8_t *blk[SHA2_MB_LANES];
+   size_t   full[SHA2_MB_LANES], blocks[SHA2_MB_LANES], b, bmax = 0;
+   uint32_t s[8][SHA2_MB_LANES], m[SHA2_MB_LANES];
+   uint32_t l, k, r;
+   uint64_t bits;
+
+   /*
+    * Each lane runs its full blocks from the message and then 1 or 2
+    * padding blocks from its tail buffer
+    */
+   memset ((void*)tail, 0, sizeof (tail));
+   for (l=0 ; l<SHA2_MB_LANES ; ++l) {
+      if (l < n) {
+         full[l] = ilen[l] / 64;
+         r = ilen[l] % 64;
+         memcpy ((void*)tail[l], (const void*)&in[l][64*full[l]], r);
+         tail[l][r] = 0x80;
+         k = (r < 56) ? 64 : 128;
+         bits = (uint64_t)ilen[l] << 3;
+         PUT_UINT32_BE ((uint32_t)(bits >> 32), tail[l], k-8);
+         PUT_UINT32_BE ((uint32_t)bits, tail[l], k-4);
+         blocks[l] = full[l] + k/64;
+      }
+      else
+         full[l] = blocks[l] = 0;
+      if (bmax < blocks[l])
+         bmax = blocks[l];
+   }
+   // Initial state
+   for (k=0 ; k<8 ; ++k) {
+      for (l=0 ; l<SHA2_MB_LANES ; ++l)
+         s[k][l] = sha2_H256[k];
+      memcpy ((void*)&st[k], (const void*)s[k], sizeof (s[k]));
+   }
+
+   for (b=0 ; b<bmax ; ++b) {
+      for (l=0 ; l<SHA2_MB_LANES ; ++l) {
+         if (b < full[l])        blk[l] = &in[l][64*b];
+         else if (b < blocks[l]) blk[l] = &tail[l][64*(b - full[l])];
+         else                    blk[l] = tail[l];    // Done lane, masked out
+         m[l] = (b < blocks[l]) ? 0xFFFFFFFF : 0;
+      }
+      _sha2_process_mb (st, blk, m);
+   }
+
+   for (k=0 ; k<8 ; ++k)
+      memcpy ((void*)s[k], (const void*)&st[k], sizeof (s[k]));
+   for (l=0 ; l<n ; ++l)
+      for (k=0 ; k<8 ; ++k)
+         PUT_UINT32_BE (s[k][l], out[l], 4*k);
+}
+
 /*!
  * \brief          SHA-256 process buffer
  *
@@ -229,7 +534,7 @@ static void sha2_process (sha2_t* ctx, const uint8_t data[64])
  * \param input    buffer holding the  data
  * \param ilen     length of the input data
  */
-static void sha2_update (sha2_t *ctx, const uint8_t *in, size_t ilen)
+void sha2_update (sha2_t *ctx, const uint8_t *in, size_t ilen)
 {
    size_t fill;
    uint32_t left;
@@ -248,16 +553,16 @@ static void sha2_update (sha2_t *ctx, const uint8_t *in, size_t ilen)
 
    if( left && ilen >= fill ) {
       memcpy ((void *) (ctx->buffer + left), in, fill);
-      sha2_process (ctx, ctx->buffer);
+      sha2_blocks (ctx, ctx->buffer, 1);
       in += fill;
       ilen  -= fill;
       left = 0;
    }
 
-   while( ilen >= 64 ) {
-      sha2_process (ctx, in);
-      in += 64;
-      ilen  -= 64;
+   if( ilen >= 64 ) {
+      sha2_blocks (ctx, in, ilen / 64);
+      in += ilen & ~(size_t)0x3F;
+      ilen &= 0x3F;
    }
 
    if( ilen > 0 )
@@ -269,9 +574,9 @@ static void sha2_update (sha2_t *ctx, const uint8_t *in, size_t ilen)
  *    SHA-256 final digest
  *
  * \param ctx      SHA-256 context
- * \param output   SHA-224/256 checksum result
+ * \param output   SHA-224/256 checksum result, 28 or 32 bytes
  */
-static void sha2_finish (sha2_t *ctx, uint8_t out[32])
+void sha2_finish (sha2_t *ctx, uint8_t *out)
 {
    uint32_t last, padn;
    uint32_t high, low;
@@ -313,11 +618,11 @@ static void sha2_finish (sha2_t *ctx, uint8_t out[32])
  *    \arg        SHA2_256
  * \return        none
  */
-static void sha2 (uint8_t *in, size_t ilen, uint8_t out[32], sha2_size sz)
+static void sha2 (uint8_t *in, size_t ilen, uint8_t *out, sha2_size sz)
 {
    sha2_t ctx;
 
-   sha2_pre (&ctx, sz);
+   sha2_init (&ctx, sz);
    sha2_update (&ctx, in, ilen);
    sha2_finish (&ctx, out);
 
@@ -362,3 +667,53 @@ void sha256 (uint8_t *input, size_t ilen, uint8_t output[32]) {
     * Forward call to sha2()
     */
 }
+
+/*!
+ * \brief
+ *    Select the SHA extensions backend of SHA-224/256, when the CPU has it,
+ *    or the portable rounds and the multi-buffer SIMD lanes. The SHA
+ *    extensions are selected by default.
+ *
+ * \param en      1 to use the SHA extensions when available, 0 for the portable code
+ * \return        1 if SHA-224/256 run on the SHA extensions after the call, 0 otherwise
+ */
+int sha2_ni_enable (int en)
+{
+#if defined(_SHA2_NI)
+   _sha2_ni_on = en;
+   return _sha2_ni_avail ();
+#else
+   (void)en;
+   return 0;
+#endif
+}
+
+/*!
+ * \brief
+ *    Calculate the SHA-256 digests of many independent messages.
+ *    The messages are hashed in groups of SHA2_MB_LANES, one message per
+ *    SIMD lane. When the CPU has the SHA extensions, each message is
+ *    hashed with them instead, as it is faster.
+ *
+ * \param input   array of pointers to the messages
+ * \param ilen    array of the message lengths
+ * \param output  array of pointers to the SHA-256 checksum results
+ * \param n       the number of messages
+ * \return        none
+ */
+void sha256_mb (const uint8_t *input[], const size_t ilen[], uint8_t *output[], uint32_t n)
+{
+   uint32_t i, k;
+
+#if defined(_SHA2_NI)
+   if (_sha2_ni_avail ()) {
+      for (i=0 ; i<n ; ++i)
+         sha2 ((uint8_t*)input[i], ilen[i], output[i], SHA2_256);
+      return;
+   }
+#endif
+   for (i=0 ; i<n ; i+=k) {
+      k = (n-i < SHA2_MB_LANES) ? n-i : SHA2_MB_LANES;
+      _sha256_mb (&input[i], &ilen[i], &output[i], k);
+   }
+}
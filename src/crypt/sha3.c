@@ -107,11 +107,8 @@ static const uint64_t K[80] =
 };
 
 // Static functions
-static void sha3_pre (sha3_t *ctx, sha3_size sz);
-static void sha3_process (sha3_t* ctx, const uint8_t data[64]);
-static void sha3_update (sha3_t *ctx, const uint8_t *input, size_t ilen);
-static void sha3_finish (sha3_t *ctx, uint8_t output[64]);
-static void sha3 (uint8_t *in, size_t ilen, uint8_t out[64], sha3_size sz);
+static void sha3_process (sha3_t* ctx, const uint8_t data[128]);
+static void sha3 (uint8_t *in, size_t ilen, uint8_t *out, sha3_size sz);
 
 /*!
  * \brief
@@ -122,7 +119,7 @@ static void sha3 (uint8_t *in, size_t ilen, uint8_t out[64], sha3_size sz);
  *    \arg     SHA3_384
  *    \arg     SHA3_512
  */
-static void sha3_pre (sha3_t *ctx, sha3_size sz)
+void sha3_init (sha3_t *ctx, sha3_size sz)
 {
    ctx->sz = sz;
    ctx->total[0] = ctx->total[1] = 0;
@@ -214,7 +211,7 @@ static void sha3_process (sha3_t* ctx, const uint8_t data[128])
  * \param input    buffer holding the  data
  * \param ilen     length of the input data
  */
-static void sha3_update (sha3_t *ctx, const uint8_t *in, size_t ilen)
+void sha3_update (sha3_t *ctx, const uint8_t *in, size_t ilen)
 {
    size_t fill;
    unsigned int left;
@@ -255,7 +252,7 @@ static void sha3_update (sha3_t *ctx, const uint8_t *in, size_t ilen)
  * \param ctx      SHA-3 context
  * \param output   SHA-384/512 checksum result
  */
-static void sha3_finish (sha3_t *ctx, uint8_t out[64])
+void sha3_finish (sha3_t *ctx, uint8_t *out)
 {
    size_t   last, padn;
    uint64_t high, low;
@@ -298,11 +295,11 @@ static void sha3_finish (sha3_t *ctx, uint8_t out[64])
  *    \arg        SHA3_512
  * \return        none
  */
-static void sha3 (uint8_t *in, size_t ilen, uint8_t out[64], sha3_size sz)
+static void sha3 (uint8_t *in, size_t ilen, uint8_t *out, sha3_size sz)
 {
    sha3_t ctx;
 
-   sha3_pre (&ctx, sz);
+   sha3_init (&ctx, sz);
    sha3_update (&ctx, in, ilen);
    sha3_finish (&ctx, out);
 
@@ -27,12 +27,26 @@
 
 static drv_status_en _sendcontrol (ee_t *ee, uint8_t rd, uint8_t ackp);
 static drv_status_en _sendaddress (ee_t *ee, address_t add);
+static int _poll (ee_t *ee, ee_op_t *op);
+static int _writedata (ee_t *ee, address_t add, byte_t *buf, bytecount_t n);
+static drv_status_en _readdata (ee_t *ee, address_t add, byte_t *buf, bytecount_t n);
 static int _writepage (ee_t *ee, address_t add, byte_t *buf, bytecount_t n);
+static drv_status_en  _devread (ee_t *ee, address_t add, byte_t *buf, bytecount_t n);
+static drv_status_en _devwrite (ee_t *ee, address_t add, byte_t *buf, bytecount_t n);
+
+static ee_line_t*     _line_find (ee_t *ee, address_t page);
+static drv_status_en _line_flush (ee_t *ee, ee_line_t *l);
+static ee_line_t*    _line_alloc (ee_t *ee, address_t page);
+static drv_status_en  _line_fill (ee_t *ee, ee_line_t *l);
+static drv_status_en _line_merge (ee_t *ee, ee_line_t *l, uint32_t off, byte_t *buf, uint32_t n);
 
 
 /*!
  * \brief
- *    Send control byte and select to use or not ACK polling
+ *    Send control byte and select to use or not ACK polling.
+ *    While the EEPROM is in its internal write cycle it does not
+ *    acknowledge the control byte, so with ACK polling we wait exactly
+ *    as long as the write cycle lasts. On failure the bus is released.
  *
  * \param  ee    Pointer indicate the ee data stuct to use
  * \param  rd    Read flag, 1 to read, 0 to write.
@@ -57,12 +71,17 @@ static drv_status_en _sendcontrol (ee_t *ee, uint8_t rd, uint8_t ackp)
       --to;
    }while (!ack && ackp && to);
 
-   return (drv_status_en) (ack)? DRV_READY : DRV_ERROR;
+   if (!ack) {
+      ee->io.i2c_ioctl (ee->io.i2c, CTRL_STOP, (void*)0);
+      return DRV_ERROR;
+   }
+   return DRV_READY;
 }
 
 /*!
  * \brief
  *    Send the address (internal memory address) to the BUS.
+ *    On failure the bus is released.
  *
  * \param  ee   Pointer indicate the ee data stuct to use
  * \param  add  The address to send
@@ -72,44 +91,86 @@ static drv_status_en _sendcontrol (ee_t *ee, uint8_t rd, uint8_t ackp)
  */
 static drv_status_en _sendaddress (ee_t *ee, address_t add)
 {
-   if (ee->conf.size == EE_08) {
-      if (!ee->io.i2c_tx (ee->io.i2c, add, I2C_SEQ_BYTE_ACK))
-         return DRV_ERROR;
-   } else {
+   int ack;
+
+   if (ee->conf.size == EE_08)
+      ack = ee->io.i2c_tx (ee->io.i2c, add, I2C_SEQ_BYTE_ACK);
+   else {
       // MSB of the address first
-      if (!ee->io.i2c_tx (ee->io.i2c, (byte_t)((add & 0xFF00)>>8), I2C_SEQ_BYTE_ACK))
-         return DRV_ERROR;
-      if (!ee->io.i2c_tx (ee->io.i2c, (byte_t)(add & 0x00FF), I2C_SEQ_BYTE_ACK))
-         return DRV_ERROR;
+      ack = ee->io.i2c_tx (ee->io.i2c, (byte_t)((add & 0xFF00)>>8), I2C_SEQ_BYTE_ACK)
+         && ee->io.i2c_tx (ee->io.i2c, (byte_t)(add & 0x00FF), I2C_SEQ_BYTE_ACK);
+   }
+   if (!ack) {
+      ee->io.i2c_ioctl (ee->io.i2c, CTRL_STOP, (void*)0);
+      return DRV_ERROR;
    }
    return DRV_READY;
 }
 
+/*!
+ * \brief
+ *    One ACK polling try, the non blocking \see _sendcontrol().
+ *    On ACK the write transaction stays open for the address. On NACK
+ *    the bus is released, so other devices can use it until the next try.
+ *
+ * \param  ee    Pointer indicate the ee data stuct to use
+ * \param  op    Pointer to the operation, op->st gets the result
+ * \return
+ *    \arg 1  Done, op->st is DRV_READY or DRV_ERROR on timeout
+ *    \arg 0  The EEPROM is in its write cycle, try again
+ */
+static int _poll (ee_t *ee, ee_op_t *op)
+{
+   ee->io.i2c_ioctl (ee->io.i2c, CTRL_START, (void*)0);
+   if (ee->io.i2c_tx (ee->io.i2c, ee->conf.hw_addr | EE_WRITE, I2C_SEQ_BYTE_ACK)) {
+      op->st = DRV_READY;
+      return 1;
+   }
+   ee->io.i2c_ioctl (ee->io.i2c, CTRL_STOP, (void*)0);
+   if (--op->to == 0) {
+      op->st = DRV_ERROR;
+      return 1;
+   }
+   return 0;
+}
+
 /*!
  * \brief
  *    Writes a number of data to the EEPROM starting from \c add
  *    till it reaches the end of the EEPROM page, Even if buf contains
- *    more data.
- *    Returns the number of written bytes, to help \see ee_writebuffer()
+ *    more data. The write cycle starts at STOP and the next transaction
+ *    waits for it with ACK polling.
+ *    Returns the number of written bytes, to help \see _devwrite()
  *
  * \param  ee    Pointer indicate the ee data stuct to use
- * \param  buf   Pointer to data to write
  * \param  add   The starting address of the EEPROM
+ * \param  buf   Pointer to data to write
+ * \param  n     The number of bytes in buf
  *
  * \return
- *    The number of written bytes
+ *    The number of written bytes or -1 on error
  */
 static int _writepage (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
 {
-   // Page start and page offset and num to write
-   uint8_t     pg_offset = add % ee->conf.page_size;
-   uint8_t     i, nl = ee->conf.page_size - pg_offset; // num up saturation
-
-   if (nl > n)  nl = n;   // Cut out the unnecessary bytes
-
-   // Control byte (write)
+   // Control byte (write) with ACK polling for the previous write cycle
    if (_sendcontrol (ee, EE_WRITE, 1) == DRV_ERROR)
       return -1;
+   return _writedata (ee, add, buf, n);
+}
+
+/*!
+ * \brief
+ *    The page write after the control byte, \see _writepage().
+ * \return
+ *    The number of written bytes or -1 on error
+ */
+static int _writedata (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
+{
+   // Page offset and num to write
+   bytecount_t pg_offset = add % ee->conf.page_size;
+   bytecount_t i, nl = ee->conf.page_size - pg_offset; // num up saturation
+
+   if (nl > n)  nl = n;   // Cut out the unnecessary bytes
 
    if (_sendaddress (ee, add) == DRV_ERROR)
       return -1;
@@ -121,9 +182,197 @@ static int _writepage (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
 
    // Stop and return the number of written bytes.
    ee->io.i2c_ioctl (ee->io.i2c, CTRL_STOP, (void*)0);
-   return i;
+   return (i) ? (int)i : -1;
+}
+
+/*!
+ * \brief
+ *    Read a block from the EEPROM with one sequential read transaction.
+ *    The EEPROM increments its address counter across the pages, so the
+ *    whole block costs a single control and address phase.
+ *
+ * \param  ee  : Pointer indicate the ee data stuct to use
+ * \param  add : EEPROM's internal address to start reading from.
+ * \param  buf : Pointer to the buffer that receives the data.
+ * \param  n   : The number of bytes to be read, n > 0.
+ * \return
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+static drv_status_en _devread (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
+{
+   // ACK polling
+   if (_sendcontrol (ee, EE_WRITE, 1) == DRV_ERROR)
+      return DRV_ERROR;
+   return _readdata (ee, add, buf, n);
 }
 
+/*!
+ * \brief
+ *    The sequential read after the control byte, \see _devread().
+ * \return
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+static drv_status_en _readdata (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
+{
+   if (_sendaddress (ee, add) == DRV_ERROR)
+      return DRV_ERROR;
+
+   // Send Control byte (read) with repeated start.
+   if (_sendcontrol (ee, EE_READ, 0) == DRV_ERROR)
+      return DRV_ERROR;
+
+   // Seq read bytes with ACK except last one
+   for ( ; n>1 ; --n)
+      *buf++ = ee->io.i2c_rx (ee->io.i2c, 1, I2C_SEQ_BYTE_ACK);
+   *buf = ee->io.i2c_rx (ee->io.i2c, 0, I2C_SEQ_BYTE_ACK);
+
+   ee->io.i2c_ioctl (ee->io.i2c, CTRL_STOP, (void*)0);
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Write a block to the EEPROM with one page write for each page.
+ *
+ * \param  ee  : Pointer indicate the ee data stuct to use
+ * \param  add : EEPROM's internal address to start writing to.
+ * \param  buf : Pointer to the buffer that holds the data to write.
+ * \param  n   : The number of bytes to write.
+ * \return
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+static drv_status_en _devwrite (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
+{
+   bytecount_t wb;   // The written bytes
+   int         ret;
+
+   for (wb=0 ; wb<n ; wb += ret) {
+      if ((ret = _writepage (ee, add+wb, &buf[wb], n-wb)) == -1)
+         return DRV_ERROR;
+      /*!
+       * \note
+       * Each _writepage writes only until the page limit, so we
+       * call _writepage until we have no more data to send.
+       */
+   }
+   return DRV_READY;
+}
+
+/*
+ * ================ Write-back cache ================
+ */
+
+/*!
+ * \brief
+ *    Find the cache line of a page.
+ * \return  The line or NULL on miss
+ */
+static ee_line_t* _line_find (ee_t *ee, address_t page)
+{
+   uint32_t i;
+
+   for (i=0 ; i<ee->cache.lines ; ++i)
+      if (ee->cache.line[i].page == page)
+         return &ee->cache.line[i];
+   return (ee_line_t*)0;
+}
+
+/*!
+ * \brief
+ *    Write back the dirty span of a line with one page write.
+ *    A partially loaded line can not serve reads after that, so it
+ *    is dropped.
+ */
+static drv_status_en _line_flush (ee_t *ee, ee_line_t *l)
+{
+   if (l->hi > l->lo) {
+      if (_devwrite (ee, l->page + l->lo, &l->data[l->lo], l->hi - l->lo) != DRV_READY)
+         return DRV_ERROR;
+      l->lo = l->hi = 0;
+   }
+   if (!l->valid)
+      l->page = EE_NO_PAGE;
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Allocate a line for a page. We use an empty line if any,
+ *    else we write back and reuse the least recently used one.
+ * \return  The line or NULL on write back error
+ */
+static ee_line_t* _line_alloc (ee_t *ee, address_t page)
+{
+   ee_line_t *l = &ee->cache.line[0];
+   uint32_t i;
+
+   for (i=0 ; i<ee->cache.lines ; ++i) {
+      if (ee->cache.line[i].page == EE_NO_PAGE) {
+         l = &ee->cache.line[i];
+         break;
+      }
+      if (ee->cache.line[i].stamp < l->stamp)
+         l = &ee->cache.line[i];
+   }
+   if (l->page != EE_NO_PAGE && _line_flush (ee, l) != DRV_READY)
+      return (ee_line_t*)0;
+
+   l->page = page;
+   l->lo = l->hi = 0;
+   l->valid = 0;
+   return l;
+}
+
+/*!
+ * \brief
+ *    Load the clean part of a line from the EEPROM, the bytes
+ *    around the dirty span.
+ */
+static drv_status_en _line_fill (ee_t *ee, ee_line_t *l)
+{
+   bytecount_t ps = ee->conf.page_size;
+
+   if (l->lo && _devread (ee, l->page, l->data, l->lo) != DRV_READY)
+      return DRV_ERROR;
+   if (l->hi < ps && _devread (ee, l->page + l->hi, &l->data[l->hi], ps - l->hi) != DRV_READY)
+      return DRV_ERROR;
+   l->valid = 1;
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Merge user data into a line. The dirty bytes have to be one span,
+ *    so a write apart from the current span loads the page first.
+ *
+ * \param  ee    Pointer indicate the ee data stuct to use
+ * \param  l     The line
+ * \param  off   The offset inside the page
+ * \param  buf   The data
+ * \param  n     The number of bytes, off+n <= page size
+ */
+static drv_status_en _line_merge (ee_t *ee, ee_line_t *l, uint32_t off, byte_t *buf, uint32_t n)
+{
+   if (l->hi > l->lo) {
+      if (!l->valid && (off+n < l->lo || off > l->hi)
+                    && _line_fill (ee, l) != DRV_READY)
+         return DRV_ERROR;
+      if (off < l->lo)     l->lo = off;
+      if (off+n > l->hi)   l->hi = off+n;
+   }
+   else {
+      l->lo = off;
+      l->hi = off+n;
+   }
+   memcpy ((void*)&l->data[off], (const void*)buf, n);
+   if (l->lo == 0 && l->hi == ee->conf.page_size)
+      l->valid = 1;
+   l->stamp = ++ee->cache.clock;
+   return DRV_READY;
+}
 
 
 
@@ -149,6 +398,23 @@ __INLINE void ee_link_i2c_ioctl (ee_t *ee, drv_i2c_ioctl_ft fun) {
    ee->io.i2c_ioctl = fun;
 }
 
+/*!
+ * \brief
+ *    Link an optional write-back cache. The writes are coalesced in
+ *    page aligned lines and written back a page at a time, on line
+ *    replacement or with \sa ee_sync().
+ *
+ * \param  ee     Pointer indicate the ee data stuct to use
+ * \param  line   Buffer of \a lines line descriptors
+ * \param  mem    Buffer for the line data, lines * page size bytes
+ * \param  lines  The number of lines
+ */
+void ee_link_cache (ee_t *ee, ee_line_t *line, byte_t *mem, uint32_t lines) {
+   ee->cache.line = line;
+   ee->cache.mem = mem;
+   ee->cache.lines = lines;
+}
+
 /*
  * Set functions
  */
@@ -199,14 +465,19 @@ __INLINE void ee_set_timeout (ee_t *ee, uint32_t to) {
 }
 
 
+
+
 /*!
  * \brief
  *    De-Initializes peripherals used by the I2C EEPROM driver.
+ *    The dirty cache lines are written back first.
  *
  * \param  ee    Pointer indicate the ee data stuct to use
  */
 void ee_deinit (ee_t *ee)
 {
+   if (ee->status == DRV_READY)
+      ee_sync (ee);
    memset ((void*)ee, 0, sizeof (ee_t));
    /*!<
     * This leaves the status = DRV_NOINIT
@@ -224,12 +495,15 @@ void ee_deinit (ee_t *ee)
  */
 drv_status_en ee_init (ee_t *ee)
 {
+   uint32_t i;
    #define _bad_link(_link)   (!ee->io._link) ? 1:0
 
    if (_bad_link (i2c))       return ee->status = DRV_ERROR;
    if (_bad_link (i2c_rx))    return ee->status = DRV_ERROR;
    if (_bad_link (i2c_tx))    return ee->status = DRV_ERROR;
    if (_bad_link (i2c_ioctl)) return ee->status = DRV_ERROR;
+   if (ee->cache.lines && (!ee->cache.line || !ee->cache.mem))
+      return ee->status = DRV_ERROR;
 
    if (ee->status == DRV_BUSY || ee->status == DRV_NODEV)
       return ee->status = DRV_ERROR;
@@ -239,6 +513,16 @@ drv_status_en ee_init (ee_t *ee)
    if (!ee->conf.page_size)   ee->conf.page_size = EE_PAGE_SZ_DEF;
    if (!ee->conf.sector_size) ee->conf.sector_size = EE_SECTOR_SIZE_DEF;
 
+   // Empty cache
+   for (i=0 ; i<ee->cache.lines ; ++i) {
+      ee->cache.line[i].page = EE_NO_PAGE;
+      ee->cache.line[i].lo = ee->cache.line[i].hi = 0;
+      ee->cache.line[i].valid = 0;
+      ee->cache.line[i].stamp = 0;
+      ee->cache.line[i].data = &ee->cache.mem[i*ee->conf.page_size];
+   }
+   ee->cache.clock = 0;
+
    return ee->status = DRV_READY;
    #undef _bad_link
 }
@@ -246,6 +530,7 @@ drv_status_en ee_init (ee_t *ee)
 /*!
  * \brief
  *    Reads the byte at current cursor from the EEPROM.
+ *    \note The cursor is the EEPROM's, the cache is bypassed.
  *
  * \param  byte : Pointer to the byte that receives the data read from the EEPROM.
  * \return The driver status after write.
@@ -283,31 +568,17 @@ drv_status_en ee_read_cursor (ee_t *ee, byte_t *byte)
  */
 drv_status_en ee_read_byte (ee_t *ee, address_t add, byte_t *byte)
 {
-   // Send Control byte (write) with ACK polling
-   if (_sendcontrol (ee, EE_WRITE, 1) == DRV_ERROR)
-      return DRV_ERROR;
-
-   if (_sendaddress (ee, add) == DRV_ERROR)
-      return DRV_ERROR;
-
-   // Send Control byte (read).
-   if (_sendcontrol (ee, EE_READ, 0) == DRV_ERROR)
-      return DRV_ERROR;
-
-   // Read with NACK
-   *byte = ee->io.i2c_rx (ee->io.i2c, 0, I2C_SEQ_BYTE_ACK);
-
-   ee->io.i2c_ioctl (ee->io.i2c, CTRL_STOP, (void*)0);
-   return DRV_READY;
+   return ee_read (ee, add, byte, 1);
 }
 
 /*!
  * \brief
- *    Writes a byte to the EEPROM.
+ *    Writes a byte to the EEPROM. With a linked cache the byte
+ *    is coalesced with the other writes of its page.
  *
  * \param  ee  : Pointer indicate the ee data stuct to use
  * \param  add : EEPROM's internal address to write.
- * \param  byte: Pointer to the byte that receives the data read from the EEPROM.
+ * \param  byte: The byte to write.
  *
  * \return The driver status after write.
  *    \arg DRV_READY
@@ -315,24 +586,14 @@ drv_status_en ee_read_byte (ee_t *ee, address_t add, byte_t *byte)
  */
 drv_status_en ee_write_byte (ee_t *ee, address_t add, byte_t byte)
 {
-   // ACK polling
-   if (_sendcontrol (ee, EE_WRITE, 1) == DRV_ERROR)
-      return DRV_ERROR;
-
-   if (_sendaddress (ee, add) == DRV_ERROR)
-      return DRV_ERROR;
-
-   if (!ee->io.i2c_tx (ee->io.i2c, byte, I2C_SEQ_BYTE_ACK))
-      return DRV_ERROR;
-
-   ee->io.i2c_ioctl (ee->io.i2c, CTRL_STOP, (void*)0);
-   return DRV_READY;
-
+   return ee_write (ee, add, &byte, 1);
 }
 
 /*!
  * \brief
- *    Reads a block of data from the EEPROM.
+ *    Reads a block of data from the EEPROM. A read inside a cached page
+ *    is served from the cache. Any other read is one sequential read
+ *    transaction and the dirty cached bytes are laid over it.
  *
  * \param  ee  : Pointer indicate the ee data stuct to use
  * \param  add : EEPROM's internal address to start reading from.
@@ -345,38 +606,51 @@ drv_status_en ee_write_byte (ee_t *ee, address_t add, byte_t byte)
  */
 drv_status_en ee_read (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
 {
-   uint8_t  ack;
-
-   // ACK polling
-   if (_sendcontrol (ee, EE_WRITE, 1) == DRV_ERROR)
-      return DRV_ERROR;
-
-   if (_sendaddress (ee, add) == DRV_ERROR)
-      return DRV_ERROR;
+   bytecount_t ps = ee->conf.page_size;
+   bytecount_t off = add % ps;
+   address_t   s, e;
+   ee_line_t   *l;
+   uint32_t    i;
+
+   if (!n)
+      return DRV_READY;
+
+   // Cache hit
+   if (off + n <= ps && (l = _line_find (ee, add - off)) != 0
+         && (l->valid || (off >= l->lo && off + n <= l->hi))) {
+      memcpy ((void*)buf, (const void*)&l->data[off], n);
+      l->stamp = ++ee->cache.clock;
+      return DRV_READY;
+   }
 
-   // Send Control byte (read).
-   if (_sendcontrol (ee, EE_READ, 0) == DRV_ERROR)
+   if (_devread (ee, add, buf, n) != DRV_READY)
       return DRV_ERROR;
 
-   // Seq read bytes with ACK except last one
-   do {
-      ack = (n>1) ? 1:0;
-      *buf++ = ee->io.i2c_rx (ee->io.i2c, ack, I2C_SEQ_BYTE_ACK);
-      --n;
-   }while (n);
-
-   ee->io.i2c_ioctl (ee->io.i2c, CTRL_STOP, (void*)0);
+   // Lay the not yet written bytes over
+   for (i=0 ; i<ee->cache.lines ; ++i) {
+      l = &ee->cache.line[i];
+      if (l->page == EE_NO_PAGE || l->hi <= l->lo)
+         continue;
+      s = l->page + l->lo;
+      e = l->page + l->hi;
+      if (s < add)      s = add;
+      if (e > add + n)  e = add + n;
+      if (s < e)
+         memcpy ((void*)&buf[s - add], (const void*)&l->data[s - l->page], e - s);
+   }
    return DRV_READY;
 }
 
 /*!
  * \brief
- *    Write a block of data to the EEPROM.
+ *    Write a block of data to the EEPROM. With a linked cache the partial
+ *    pages are coalesced in the cache and the whole not cached pages go
+ *    straight to the EEPROM. Without cache we write a page at a time.
  *
  * \param  ee  : Pointer indicate the ee data stuct to use
  * \param  add : EEPROM's internal address to start writing to.
  * \param  buf : Pointer to the buffer that holds the data to write.
- * \param  n   : The number of bytes to be read from the EEPROM.
+ * \param  n   : The number of bytes to write to the EEPROM.
  *
  * \return The driver status after write.
  *    \arg DRV_READY
@@ -384,37 +658,172 @@ drv_status_en ee_read (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
  */
 drv_status_en ee_write (ee_t *ee, address_t add, byte_t *buf, bytecount_t n)
 {
-   uint32_t wb=0;    // The written bytes
-   int      ret;
+   bytecount_t ps = ee->conf.page_size;
+   bytecount_t wb, nl, off;
+   ee_line_t   *l;
+
+   if (!ee->cache.lines)
+      return _devwrite (ee, add, buf, n);
+
+   for (wb=0 ; wb<n ; wb += nl) {
+      off = (add + wb) % ps;
+      nl = ps - off;
+      if (nl > n - wb)  nl = n - wb;
+
+      if ((l = _line_find (ee, add + wb - off)) == 0) {
+         if (nl == ps) {
+            // Whole page, no need to cache it
+            if (_devwrite (ee, add + wb, &buf[wb], nl) != DRV_READY)
+               return DRV_ERROR;
+            continue;
+         }
+         if ((l = _line_alloc (ee, add + wb - off)) == 0)
+            return DRV_ERROR;
+      }
+      if (_line_merge (ee, l, off, &buf[wb], nl) != DRV_READY)
+         return DRV_ERROR;
+   }
+   return DRV_READY;
+}
 
-   // ACK polling
-   if (_sendcontrol (ee, EE_WRITE, 1) == DRV_ERROR)
-      return ee->status = DRV_ERROR;
+/*!
+ * \brief
+ *    Read data from EEPROM using sector addressing
+ *
+ * \param     ee  Pointer indicate the ee data stuct to use
+ * \param sector  Sector number
+ * \param    buf  Buffer pointer to store the data
+ * \param  count  Number of sectors to read
+ *
+ * \return The status of the operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en  ee_read_sector (ee_t *ee, int sector, byte_t *buf, int count)
+{
+   // Virtual sector conversions
+   address_t add = sector * ee->conf.sector_size;
+   count *= ee->conf.sector_size;
 
-   if (_sendaddress (ee, add) == DRV_ERROR)
-      return ee->status = DRV_ERROR;
+   // Forward call to buffer version
+   return ee_read (ee, add, buf, count);
+}
 
-   do {
-      ret = _writepage (ee, add+wb, &buf[wb], n-wb);
-      if (ret == -1)    return DRV_ERROR;
-      else              wb += ret;
-      /*!
-       * \note
-       * Each _writepage writes only until the page limit, so we
-       * call _writepage until we have no more data to send.
-       */
-   } while (wb < n);
+/*!
+ * \brief
+ *    Write data to EEPROM using sector addressing
+ *
+ * \param     ee  Pointer indicate the ee data stuct to use
+ * \param sector  Sector number
+ * \param    buf  Buffer pointer with the data to write
+ * \param  count  Number of sectors to write
+ *
+ * \return The status of the operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en ee_write_sector (ee_t *ee, int sector, byte_t *buf, int count)
+{
+   // Virtual sector conversions
+   address_t add = sector * ee->conf.sector_size;
+   count *= ee->conf.sector_size;
 
-   return DRV_READY;
+   // Forward call to buffer version
+   return ee_write (ee, add, buf, count);
 }
 
+/*!
+ * \brief
+ *    Write back all the dirty cache lines, one page write each.
+ *
+ * \param  ee    Pointer indicate the ee data stuct to use
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en ee_sync (ee_t *ee)
+{
+   drv_status_en ret = DRV_READY;
+   uint32_t i;
+
+   for (i=0 ; i<ee->cache.lines ; ++i)
+      if (ee->cache.line[i].page != EE_NO_PAGE
+            && _line_flush (ee, &ee->cache.line[i]) != DRV_READY)
+         ret = DRV_ERROR;
+   return ret;
+}
 
-drv_status_en  ee_read_sector (ee_t *ee, int sector, byte_t *buf, int count) {
-   return DRV_ERROR;
+/*!
+ * \brief
+ *    Non blocking read. It returns DRV_BUSY while the EEPROM is in
+ *    a write cycle, and it has to be called again with the same arguments
+ *    until it returns the status. Each call sends one ACK polling control
+ *    byte, so the CPU and the bus are free for the others meanwhile.
+ * \note
+ *    The async calls go to the EEPROM without the cache, so they are
+ *    not allowed with a linked cache.
+ *
+ * \param  ee  : Pointer indicate the ee data stuct to use
+ * \param  op  : Pointer to the operation state, zero before the first call
+ * \param  add : EEPROM's internal address to start reading from.
+ * \param  buf : Pointer to the buffer that receives the data read from the EEPROM.
+ * \param  n   : The number of bytes to be read from the EEPROM.
+ *
+ * \return The status of the operation.
+ *    \arg DRV_BUSY    Pending, call again
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en ee_read_async (ee_t *ee, ee_op_t *op, address_t add, byte_t *buf, bytecount_t n)
+{
+   PT_BEGIN (&op->pt);
+   if (ee->cache.lines)
+      PT_EXIT (&op->pt, DRV_ERROR);
+   if (!n)
+      PT_EXIT (&op->pt, DRV_READY);
+
+   op->to = ee->conf.timeout;
+   PT_WAIT_UNTIL (&op->pt, _poll (ee, op));
+   if (op->st != DRV_READY)
+      PT_EXIT (&op->pt, DRV_ERROR);
+   PT_EXIT (&op->pt, _readdata (ee, add, buf, n));
+   PT_END (&op->pt);
 }
 
-drv_status_en ee_write_sector (ee_t *ee, int sector, byte_t *buf, int count) {
-   return DRV_ERROR;
+/*!
+ * \brief
+ *    Non blocking write, one page write for each page. It returns
+ *    DRV_BUSY while the EEPROM is in a write cycle, and it has to be
+ *    called again with the same arguments until it returns the status.
+ *    As ee_write() it returns during the write cycle of the last page.
+ *    \see ee_read_async()
+ *
+ * \param  ee  : Pointer indicate the ee data stuct to use
+ * \param  op  : Pointer to the operation state, zero before the first call
+ * \param  add : EEPROM's internal address to start writing to.
+ * \param  buf : Pointer to the buffer that holds the data to write.
+ * \param  n   : The number of bytes to write to the EEPROM.
+ *
+ * \return The status of the operation.
+ *    \arg DRV_BUSY    Pending, call again
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en ee_write_async (ee_t *ee, ee_op_t *op, address_t add, byte_t *buf, bytecount_t n)
+{
+   PT_BEGIN (&op->pt);
+   if (ee->cache.lines)
+      PT_EXIT (&op->pt, DRV_ERROR);
+
+   for (op->done=0 ; op->done<n ; op->done += op->ret) {
+      op->to = ee->conf.timeout;
+      PT_WAIT_UNTIL (&op->pt, _poll (ee, op));
+      if (op->st != DRV_READY)
+         PT_EXIT (&op->pt, DRV_ERROR);
+      if ((op->ret = _writedata (ee, add + op->done, &buf[op->done], n - op->done)) == -1)
+         PT_EXIT (&op->pt, DRV_ERROR);
+   }
+   PT_END (&op->pt);
 }
 
 /*!
@@ -426,6 +835,7 @@ drv_status_en ee_write_sector (ee_t *ee, int sector, byte_t *buf, int count) {
  *    \arg CTRL_GET_STATUS
  *    \arg CTRL_DEINIT
  *    \arg CTRL_INIT
+ *    \arg CTRL_SYNC             Write back the cache
  *    \arg CTRL_GET_SIZE
  *    \arg CTRL_GET_SECTOR_SIZE
  *    \arg CTRL_ERASE_PAGE    **
@@ -452,6 +862,8 @@ drv_status_en ee_ioctl (ee_t *ee, ioctl_cmd_t cmd, ioctl_buf_t buf)
          else
             ee_init(ee);
          return DRV_READY;
+      case CTRL_SYNC:            /*!< Write back the cache */
+         return ee_sync (ee);
       case CTRL_GET_SIZE:        /*!< EEPROM size */
          if (buf)
             *(drv_status_en*)buf = ee->conf.size;
@@ -465,4 +877,3 @@ drv_status_en ee_ioctl (ee_t *ee, ioctl_cmd_t cmd, ioctl_buf_t buf)
 
    }
 }
-
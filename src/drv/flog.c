@@ -0,0 +1,816 @@
+/*!
+ * \file flog.c
+ * \brief
+ *    A target independent log structured key/record store for NOR flash.
+ *    The records are appended to a page buffer and programmed a page at a
+ *    time. The obsolete records are reclaimed sector by sector, choosing the
+ *    sectors by their garbage and their erase count (wear leveling). A RAM
+ *    index [key] -> flash address is rebuilt at mount.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <drv/flog.h>
+
+/*
+ * Flash layout
+ *
+ * Sector:  | magic | erase_cnt | 0xFF.. | seq | ~seq | 0xFF.. | record | record | ... | 0xFF.. |
+ *          |<---- FLOG_PROG_UNIT ---->|<---- FLOG_PROG_UNIT --->|
+ * Record:  | key | len | flags | crc | data | pad to FLOG_ALIGN |
+ *
+ * A free sector has the first unit only. The second unit is written when
+ * the sector joins the log, so the sectors are replayed in seq order and
+ * the records in address order. The last record of each key is the valid one.
+ * After a flush the log continues at the next FLOG_PROG_UNIT boundary.
+ */
+#define _REC_DELETED          (0x0000)    /*!< Record flags of a deleted key */
+#define _REC_VALID            (0xFFFF)    /*!< Record flags of a valid key */
+#define _COPY_CHUNK           (64)        /*!< Stack buffer for the record copies and checks */
+
+#define _align(_x, _a)        (((_x) + (_a) - 1) & ~((uint32_t)(_a) - 1))
+
+/*!
+ * Record header
+ */
+typedef struct {
+   uint16_t    key;
+   uint16_t    len;
+   uint16_t    flags;
+   uint16_t    crc;
+}_rec_t;
+
+static uint32_t     _sec_addr (flog_t *flog, uint32_t s);
+static uint32_t       _sec_of (flog_t *flog, flog_addr_t a);
+static uint32_t     _rec_size (uint32_t len);
+static uint16_t      _rec_crc (const _rec_t *h, const byte_t *data, int n, uint16_t crc);
+static drv_status_en _raw_read (flog_t *flog, flog_addr_t a, byte_t *buf, int n);
+static drv_status_en  _program (flog_t *flog, uint32_t end);
+static drv_status_en   _append (flog_t *flog, const byte_t *data, int n);
+static drv_status_en    _flush (flog_t *flog);
+static drv_status_en   _format (flog_t *flog, uint32_t s);
+static drv_status_en     _open (flog_t *flog, uint32_t reserve);
+static void         _index_set (flog_t *flog, flog_key_t key, flog_addr_t a);
+static int             _reclaim (flog_t *flog);
+static void              _scan (flog_t *flog, uint32_t s);
+static drv_status_en    _mount (flog_t *flog);
+
+/*!
+ * \brief
+ *    The flash address of sector \a s
+ */
+static uint32_t _sec_addr (flog_t *flog, uint32_t s) {
+   return flog->conf.base + s*flog->conf.sector_sz;
+}
+
+/*!
+ * \brief
+ *    The sector of flash address \a a
+ */
+static uint32_t _sec_of (flog_t *flog, flog_addr_t a) {
+   return (a - flog->conf.base) / flog->conf.sector_sz;
+}
+
+/*!
+ * \brief
+ *    The flash size of a record with \a len data bytes
+ */
+static uint32_t _rec_size (uint32_t len) {
+   return _align (FLOG_REC_HEADER_SIZE + len, FLOG_ALIGN);
+}
+
+/*!
+ * \brief
+ *    Append the record header and data to the record CRC. Use 0xFFFF for
+ *    \a crc and h=NULL for the rest of the data.
+ */
+static uint16_t _rec_crc (const _rec_t *h, const byte_t *data, int n, uint16_t crc)
+{
+   if (h)
+      crc = CRC16_buffer (CRC16_CCITT, CRC_MSB, crc, (const byte_t*)h, 3*sizeof (uint16_t));
+   return CRC16_buffer (CRC16_CCITT, CRC_MSB, crc, data, n);
+}
+
+/*!
+ * \brief
+ *    Read from the store. The current page of the active sector
+ *    comes from the page buffer, as it may not be programmed yet.
+ *
+ * \param  flog   The active flog struct.
+ * \param  a      The flash address
+ * \param  buf    Pointer to buffer for the data
+ * \param  n      The number of bytes
+ * \return The status of operation
+ */
+static drv_status_en _raw_read (flog_t *flog, flog_addr_t a, byte_t *buf, int n)
+{
+   uint32_t s = _sec_of (flog, a);
+   uint32_t off = a - _sec_addr (flog, s);
+   uint32_t pbase = flog->wpos - flog->wpos % flog->conf.page_sz;
+   int c;
+
+   if (s == flog->active && off + n > pbase) {
+      if (off < pbase) {
+         c = pbase - off;
+         if (flog->io.fl_read (flog->io.flash, a, buf, c) != DRV_READY)
+            return DRV_ERROR;
+         buf += c;
+         n -= c;
+         off = pbase;
+      }
+      memcpy ((void*)buf, (const void*)&flog->page[off - pbase], n);
+      return DRV_READY;
+   }
+   return flog->io.fl_read (flog->io.flash, a, buf, n);
+}
+
+/*!
+ * \brief
+ *    Program the page buffer from the programmed offset up to \a end,
+ *    inside the current page.
+ */
+static drv_status_en _program (flog_t *flog, uint32_t end)
+{
+   uint32_t pbase = (end - 1) - (end - 1) % flog->conf.page_sz;
+   drv_status_en st = DRV_READY;
+
+   if (end > flog->ppos)
+      st = flog->io.fl_write (flog->io.flash,
+                              _sec_addr (flog, flog->active) + flog->ppos,
+                              &flog->page[flog->ppos - pbase],
+                              end - flog->ppos);
+   flog->ppos = end;
+   return st;
+}
+
+/*!
+ * \brief
+ *    Append data to the active sector through the page buffer. Each
+ *    full page is programmed with one page program.
+ *
+ * \param  flog   The active flog struct.
+ * \param  data   Pointer to data, or NULL for padding
+ * \param  n      The number of bytes
+ * \return The status of operation
+ */
+static drv_status_en _append (flog_t *flog, const byte_t *data, int n)
+{
+   uint32_t ps = flog->conf.page_sz;
+   uint32_t po, c;
+
+   while (n > 0) {
+      po = flog->wpos % ps;
+      c = ps - po;
+      if (c > (uint32_t)n)
+         c = n;
+      if (data) {
+         memcpy ((void*)&flog->page[po], (const void*)data, c);
+         data += c;
+      }
+      flog->wpos += c;
+      n -= c;
+      if (flog->wpos % ps == 0) {
+         if (_program (flog, flog->wpos) != DRV_READY)
+            return DRV_ERROR;
+         memset ((void*)flog->page, 0xFF, ps);
+      }
+   }
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Program the pending data of the page buffer. The log continues
+ *    at the next FLOG_PROG_UNIT boundary.
+ */
+static drv_status_en _flush (flog_t *flog)
+{
+   uint32_t end;
+
+   if (flog->active == FLOG_NO_SECTOR || flog->wpos <= flog->ppos)
+      return DRV_READY;
+   end = _align (flog->wpos, FLOG_PROG_UNIT);
+   if (_program (flog, end) != DRV_READY)
+      return DRV_ERROR;
+   flog->wpos = end;
+   flog->sec[flog->active].used = end;
+   if (end % flog->conf.page_sz == 0)
+      memset ((void*)flog->page, 0xFF, flog->conf.page_sz);
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Erase sector \a s and write its first header unit with the
+ *    new erase count and its complement. The sector becomes free.
+ */
+static drv_status_en _format (flog_t *flog, uint32_t s)
+{
+   uint32_t a = _sec_addr (flog, s);
+   uint32_t h[3];
+
+   if (flog->io.fl_ioctl (flog->io.flash, CTRL_ERASE_PAGE, (ioctl_buf_t)&a) != DRV_READY)
+      return DRV_ERROR;
+   ++flog->stat.erases;
+   h[0] = FLOG_MAGIC;
+   h[1] = ++flog->sec[s].erase_cnt;
+   h[2] = ~h[1];
+   if (flog->io.fl_write (flog->io.flash, a, (byte_t*)h, sizeof (h)) != DRV_READY)
+      return DRV_ERROR;
+   flog->sec[s].seq = FLOG_SEQ_FREE;
+   flog->sec[s].used = FLOG_HEADER_SIZE;
+   flog->sec[s].live = 0;
+   ++flog->free;
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Close the active sector and open the least worn free sector.
+ *
+ * \param  flog      The active flog struct.
+ * \param  reserve   The free sectors that can not be used
+ * \return The status of operation
+ *    \arg DRV_ERROR    No free sector or flash error
+ */
+static drv_status_en _open (flog_t *flog, uint32_t reserve)
+{
+   uint32_t s, f = FLOG_NO_SECTOR;
+   uint32_t h[2];
+
+   if (flog->free <= reserve || _flush (flog) != DRV_READY)
+      return DRV_ERROR;
+   for (s=0 ; s<flog->conf.sectors ; ++s)
+      if (flog->sec[s].seq == FLOG_SEQ_FREE &&
+          (f == FLOG_NO_SECTOR || flog->sec[s].erase_cnt < flog->sec[f].erase_cnt))
+         f = s;
+   if (f == FLOG_NO_SECTOR)
+      return DRV_ERROR;
+
+   h[0] = flog->seq;
+   h[1] = ~flog->seq;
+   if (flog->io.fl_write (flog->io.flash, _sec_addr (flog, f) + FLOG_PROG_UNIT, (byte_t*)h, sizeof (h)) != DRV_READY)
+      return DRV_ERROR;
+   flog->sec[f].seq = flog->seq++;
+   flog->sec[f].used = FLOG_HEADER_SIZE;
+   flog->sec[f].live = 0;
+   --flog->free;
+
+   flog->active = f;
+   flog->wpos = flog->ppos = FLOG_HEADER_SIZE;
+   memset ((void*)flog->page, 0xFF, flog->conf.page_sz);
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Point the index of \a key to the record at \a a. The previous
+ *    record of the key becomes garbage of its sector.
+ */
+static void _index_set (flog_t *flog, flog_key_t key, flog_addr_t a)
+{
+   flog_addr_t old = flog->index[key];
+   _rec_t h;
+
+   if (old && _raw_read (flog, old, (byte_t*)&h, sizeof (h)) == DRV_READY)
+      flog->sec[_sec_of (flog, old)].live -= _rec_size (h.len);
+   flog->index[key] = a;
+}
+
+/*!
+ * \brief
+ *    Reclaim one sector. The victim is the sector with the most garbage,
+ *    or the least worn one if the erase counts spread more than
+ *    FLOG_WEAR_DELTA and a free sector can take its data. Its current
+ *    records are copied to the log and the sector is erased.
+ *
+ * \param  flog   The active flog struct.
+ * \return        The result
+ *    \arg  1     A sector was reclaimed
+ *    \arg  0     Nothing to reclaim
+ *    \arg  -1    Flash error
+ */
+static int _reclaim (flog_t *flog)
+{
+   uint32_t s, v = FLOG_NO_SECTOR, cold = FLOG_NO_SECTOR;
+   uint32_t g, maxg = 0, maxec = 0;
+   uint32_t off, size, c, n;
+   flog_addr_t a, na;
+   byte_t bf[_COPY_CHUNK];
+   _rec_t h;
+
+   for (s=0 ; s<flog->conf.sectors ; ++s) {
+      if (flog->sec[s].erase_cnt > maxec)
+         maxec = flog->sec[s].erase_cnt;
+      if (flog->sec[s].seq == FLOG_SEQ_FREE || s == flog->active)
+         continue;
+      g = flog->conf.sector_sz - FLOG_HEADER_SIZE - flog->sec[s].live;
+      if (g > maxg) {
+         maxg = g;
+         v = s;
+      }
+      if (cold == FLOG_NO_SECTOR || flog->sec[s].erase_cnt < flog->sec[cold].erase_cnt)
+         cold = s;
+   }
+   if (cold != FLOG_NO_SECTOR && flog->free &&
+       maxec - flog->sec[cold].erase_cnt > FLOG_WEAR_DELTA)
+      v = cold;
+   if (v == FLOG_NO_SECTOR)
+      return 0;
+
+   // Copy the current records
+   for (off = FLOG_HEADER_SIZE ; off + FLOG_REC_HEADER_SIZE <= flog->sec[v].used ; off += size) {
+      a = _sec_addr (flog, v) + off;
+      if (flog->io.fl_read (flog->io.flash, a, (byte_t*)&h, sizeof (h)) != DRV_READY)
+         return -1;
+      if (h.key == 0xFFFF && h.len == 0xFFFF) {
+         if (off % FLOG_PROG_UNIT == 0)
+            break;      // End of records
+         size = _align (off, FLOG_PROG_UNIT) - off;
+         continue;      // Flush padding
+      }
+      size = _rec_size (h.len);
+      if (off + size > flog->sec[v].used)
+         break;
+      if (h.key >= flog->keys || flog->index[h.key] != a)
+         continue;      // Garbage
+
+      if (flog->wpos + size > flog->conf.sector_sz && _open (flog, 0) != DRV_READY)
+         return -1;
+      na = _sec_addr (flog, flog->active) + flog->wpos;
+      for (c=0 ; c<size ; c+=n) {
+         n = (size - c < _COPY_CHUNK) ? size - c : _COPY_CHUNK;
+         if (flog->io.fl_read (flog->io.flash, a + c, bf, n) != DRV_READY ||
+             _append (flog, bf, n) != DRV_READY)
+            return -1;
+      }
+      flog->sec[flog->active].used = flog->wpos;
+      flog->sec[flog->active].live += size;
+      flog->sec[v].live -= size;
+      flog->index[h.key] = na;
+      flog->stat.copy_bytes += size;
+   }
+   // The copies must be in flash before the erase
+   if (_flush (flog) != DRV_READY || _format (flog, v) != DRV_READY)
+      return -1;
+   ++flog->stat.reclaims;
+   return 1;
+}
+
+/*!
+ * \brief
+ *    Replay the records of sector \a s to the index. A broken record,
+ *    ex: from a power loss, ends the sector.
+ */
+static void _scan (flog_t *flog, uint32_t s)
+{
+   uint32_t end = flog->conf.sector_sz;
+   uint32_t off, size, c, n;
+   byte_t bf[_COPY_CHUNK];
+   flog_addr_t a;
+   uint16_t crc;
+   _rec_t h;
+
+   flog->sec[s].live = 0;
+   for (off = FLOG_HEADER_SIZE ; off + FLOG_REC_HEADER_SIZE <= end ; off += size) {
+      a = _sec_addr (flog, s) + off;
+      if (flog->io.fl_read (flog->io.flash, a, (byte_t*)&h, sizeof (h)) != DRV_READY)
+         break;
+      if (h.key == 0xFFFF && h.len == 0xFFFF) {
+         if (off % FLOG_PROG_UNIT == 0)
+            break;      // End of records
+         size = _align (off, FLOG_PROG_UNIT) - off;
+         continue;      // Flush padding
+      }
+      size = _rec_size (h.len);
+      if (h.key >= flog->keys || off + size > end) {
+         off = end;
+         break;
+      }
+      crc = _rec_crc (&h, NULL, 0, 0xFFFF);
+      for (c=0 ; c<h.len ; c+=n) {
+         n = (h.len - c < _COPY_CHUNK) ? h.len - c : _COPY_CHUNK;
+         if (flog->io.fl_read (flog->io.flash, a + FLOG_REC_HEADER_SIZE + c, bf, n) != DRV_READY)
+            break;
+         crc = _rec_crc (NULL, bf, n, crc);
+      }
+      if (crc != h.crc) {
+         off = end;
+         break;
+      }
+      flog->sec[s].live += size;
+      _index_set (flog, h.key, a);
+   }
+   flog->sec[s].used = (off < end) ? off : end;
+}
+
+/*!
+ * \brief
+ *    Mount the store. Read the sector headers, format the sectors with
+ *    broken headers and replay the log in sequence order to the index.
+ *
+ * \param  flog   The active flog struct.
+ * \return The status of operation
+ */
+static drv_status_en _mount (flog_t *flog)
+{
+   uint32_t h[FLOG_HEADER_SIZE / sizeof (uint32_t)];
+   uint32_t s, cur, last, lo, maxec = 0, pbase;
+
+   memset ((void*)flog->index, 0, flog->keys * sizeof (flog_addr_t));
+   flog->active = FLOG_NO_SECTOR;
+   flog->wpos = flog->ppos = 0;
+   flog->free = 0;
+   flog->seq = 0;
+
+   for (s=0 ; s<flog->conf.sectors ; ++s) {
+      if (flog->io.fl_read (flog->io.flash, _sec_addr (flog, s), (byte_t*)h, sizeof (h)) != DRV_READY)
+         return DRV_ERROR;
+      flog->sec[s].used = 0;     // Needs format
+      flog->sec[s].live = 0;
+      if (h[0] != FLOG_MAGIC || h[1] != ~h[2])
+         continue;
+      flog->sec[s].erase_cnt = h[1];
+      if (h[1] > maxec)
+         maxec = h[1];
+      flog->sec[s].seq = h[FLOG_PROG_UNIT / sizeof (uint32_t)];
+      if (flog->sec[s].seq == FLOG_SEQ_FREE) {
+         if (h[FLOG_PROG_UNIT / sizeof (uint32_t) + 1] == FLOG_SEQ_FREE) {
+            flog->sec[s].used = FLOG_HEADER_SIZE;
+            ++flog->free;
+         }
+      }
+      else if (flog->sec[s].seq == ~h[FLOG_PROG_UNIT / sizeof (uint32_t) + 1]) {
+         flog->sec[s].used = FLOG_HEADER_SIZE;
+         if (flog->sec[s].seq >= flog->seq)
+            flog->seq = flog->sec[s].seq + 1;
+      }
+   }
+   // Sectors with unknown erase count take the worst one
+   for (s=0 ; s<flog->conf.sectors ; ++s)
+      if (!flog->sec[s].used) {
+         flog->sec[s].erase_cnt = maxec;
+         if (_format (flog, s) != DRV_READY)
+            return DRV_ERROR;
+      }
+
+   // Replay the log in sequence order
+   for (last = FLOG_NO_SECTOR, lo=0 ; ; lo = flog->sec[cur].seq + 1) {
+      cur = FLOG_NO_SECTOR;
+      for (s=0 ; s<flog->conf.sectors ; ++s)
+         if (flog->sec[s].seq != FLOG_SEQ_FREE && flog->sec[s].seq >= lo &&
+             (cur == FLOG_NO_SECTOR || flog->sec[s].seq < flog->sec[cur].seq))
+            cur = s;
+      if (cur == FLOG_NO_SECTOR)
+         break;
+      _scan (flog, cur);
+      last = cur;
+   }
+   if (last == FLOG_NO_SECTOR)
+      return _open (flog, 0);
+
+   // Continue the last sector from the next program unit
+   flog->active = last;
+   flog->wpos = _align (flog->sec[last].used, FLOG_PROG_UNIT);
+   if (flog->wpos > flog->conf.sector_sz)
+      flog->wpos = flog->conf.sector_sz;
+   flog->ppos = flog->sec[last].used = flog->wpos;
+
+   // The page buffer holds the current page
+   pbase = flog->wpos - flog->wpos % flog->conf.page_sz;
+   memset ((void*)flog->page, 0xFF, flog->conf.page_sz);
+   if (flog->wpos > pbase &&
+       flog->io.fl_read (flog->io.flash, _sec_addr (flog, last) + pbase, flog->page, flog->wpos - pbase) != DRV_READY)
+      return DRV_ERROR;
+   return DRV_READY;
+}
+
+
+/*
+ * ========== Public flog API ================
+ */
+
+/*
+ * Link and Glue functions
+ */
+
+/*!
+ * \brief
+ *    Link the flash driver data struct, ex: s25fs_t or snor_t
+ */
+void flog_link_flash (flog_t *flog, void* flash) {
+   flog->io.flash = flash;
+}
+/*!
+ * \brief
+ *    Link the flash read function, ex: s25fs_read()
+ */
+void flog_link_flash_read (flog_t *flog, flog_io_ft f) {
+   flog->io.fl_read = f;
+}
+/*!
+ * \brief
+ *    Link the flash write function, ex: s25fs_write()
+ */
+void flog_link_flash_write (flog_t *flog, flog_io_ft f) {
+   flog->io.fl_write = f;
+}
+/*!
+ * \brief
+ *    Link the flash ioctl function, ex: s25fs_ioctl(). It is used
+ *    for the CTRL_ERASE_PAGE command.
+ */
+void flog_link_flash_ioctl (flog_t *flog, flog_ioctl_ft f) {
+   flog->io.fl_ioctl = f;
+}
+/*!
+ * \brief
+ *    Link a RAM buffer for the index. It has one entry per key, so
+ *    the keys are [0 .. keys).
+ *
+ * \param  flog   The active flog struct.
+ * \param  index  Pointer to index buffer
+ * \param  keys   The number of flog_addr_t entries in buffer
+ */
+void flog_link_index (flog_t *flog, flog_addr_t *index, uint32_t keys) {
+   flog->index = index;
+   flog->keys = (keys < 0xFFFF) ? keys : 0xFFFF;
+}
+/*!
+ * \brief
+ *    Link a RAM buffer for the sector table. It also sets the store size.
+ *
+ * \param  flog      The active flog struct.
+ * \param  sec       Pointer to sector table
+ * \param  sectors   The number of sectors of the store
+ */
+void flog_link_sectors (flog_t *flog, flog_sector_t *sec, uint32_t sectors) {
+   flog->sec = sec;
+   flog->conf.sectors = sectors;
+}
+/*!
+ * \brief
+ *    Link a RAM buffer of page size for the page buffer
+ */
+void flog_link_page (flog_t *flog, byte_t *page) {
+   flog->page = page;
+}
+
+/*
+ * Set functions
+ */
+
+/*!
+ * \brief
+ *    Set the flash address of the store. It must be sector aligned.
+ */
+void flog_set_base (flog_t *flog, uint32_t address) {
+   flog->conf.base = address;
+}
+/*!
+ * \brief
+ *    Set the flash erase sector size
+ */
+void flog_set_sector_size (flog_t *flog, uint32_t size) {
+   flog->conf.sector_sz = size;
+}
+/*!
+ * \brief
+ *    Set the flash program page size
+ */
+void flog_set_page_size (flog_t *flog, uint32_t size) {
+   flog->conf.page_sz = size;
+}
+
+/*
+ * User Functions
+ */
+
+/*!
+ * \brief
+ *    De-Initialize the store. The pending data are lost, so call
+ *    flog_sync() before.
+ */
+void flog_deinit (flog_t *flog)
+{
+   memset ((void*)flog, 0, sizeof (flog_t));
+   /*!<
+    * This leaves the status = DRV_NOINIT
+    */
+}
+
+/*!
+ * \brief
+ *    Initialize and mount the store. The first mount formats the sectors.
+ *
+ * \param  flog   The active flog struct.
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en flog_init (flog_t *flog)
+{
+   #define _bad_link(_link)   (!flog->_link) ? 1:0
+
+   if (_bad_link (io.fl_read))      return flog->status = DRV_ERROR;
+   if (_bad_link (io.fl_write))     return flog->status = DRV_ERROR;
+   if (_bad_link (io.fl_ioctl))     return flog->status = DRV_ERROR;
+   if (_bad_link (index))           return flog->status = DRV_ERROR;
+   if (_bad_link (sec))             return flog->status = DRV_ERROR;
+   if (_bad_link (page))            return flog->status = DRV_ERROR;
+
+   if (!flog->conf.page_sz)         flog->conf.page_sz = FLOG_PAGE_SZ_DEF;
+   if (!flog->conf.sector_sz)       flog->conf.sector_sz = FLOG_SECTOR_SZ_DEF;
+   if (flog->conf.page_sz % FLOG_PROG_UNIT || flog->conf.sector_sz % flog->conf.page_sz ||
+       flog->conf.sectors < FLOG_RESERVE_SECTORS + 2 || !flog->keys)
+      return flog->status = DRV_ERROR;
+
+   flog->status = DRV_BUSY;
+   memset ((void*)&flog->stat, 0, sizeof (flog_stat_t));
+   if (_mount (flog) != DRV_READY)
+      return flog->status = DRV_ERROR;
+   return flog->status = DRV_READY;
+   #undef _bad_link
+}
+
+/*!
+ * \brief
+ *    Read the last record of \a key
+ *
+ * \param  flog   The active flog struct.
+ * \param  key    The record key
+ * \param  buf    Pointer to buffer for the data
+ * \param  size   The buffer size. The data after it are not copied
+ * \return        The record size, 0 for no record or -1 on flash error
+ */
+int flog_read (flog_t *flog, flog_key_t key, void *buf, int size)
+{
+   flog_addr_t a;
+   _rec_t h;
+
+   if (flog->status != DRV_READY || key >= flog->keys || !(a = flog->index[key]))
+      return 0;
+   if (_raw_read (flog, a, (byte_t*)&h, sizeof (h)) != DRV_READY)
+      return -1;
+   if (h.flags == _REC_DELETED)
+      return 0;
+   if (size > h.len)
+      size = h.len;
+   if (size > 0 && _raw_read (flog, a + FLOG_REC_HEADER_SIZE, (byte_t*)buf, size) != DRV_READY)
+      return -1;
+   return h.len;
+}
+
+/*!
+ * \brief
+ *    Write a record to the page buffer. The full pages are programmed
+ *    as they fill, the rest with flog_sync(). If only the reserved free
+ *    sectors are left, a sector is reclaimed first.
+ *
+ * \param  flog   The active flog struct.
+ * \param  key    The record key
+ * \param  buf    Pointer to the data
+ * \param  size   The data size, up to sector size - FLOG_HEADER_SIZE - FLOG_REC_HEADER_SIZE
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR   Bad arguments, store full or flash error
+ */
+drv_status_en flog_write (flog_t *flog, flog_key_t key, const void *buf, int size)
+{
+   uint32_t rs;
+   flog_addr_t a;
+   _rec_t h;
+
+   if (flog->status != DRV_READY || key >= flog->keys || size < 0 || size > 0xFFFF ||
+       (rs = _rec_size (size)) > flog->conf.sector_sz - FLOG_HEADER_SIZE)
+      return DRV_ERROR;
+
+   while (flog->wpos + rs > flog->conf.sector_sz) {
+      if (flog->free > FLOG_RESERVE_SECTORS) {
+         if (_open (flog, FLOG_RESERVE_SECTORS) != DRV_READY)
+            return DRV_ERROR;
+      }
+      else if (_reclaim (flog) <= 0)
+         return DRV_ERROR;
+   }
+
+   h.key = key;
+   h.len = size;
+   h.flags = (buf) ? _REC_VALID : _REC_DELETED;
+   h.crc = _rec_crc (&h, (const byte_t*)buf, size, 0xFFFF);
+   a = _sec_addr (flog, flog->active) + flog->wpos;
+   if (_append (flog, (const byte_t*)&h, sizeof (h)) != DRV_READY ||
+       _append (flog, (const byte_t*)buf, size) != DRV_READY ||
+       _append (flog, NULL, rs - FLOG_REC_HEADER_SIZE - size) != DRV_READY)
+      return DRV_ERROR;
+   flog->sec[flog->active].used = flog->wpos;
+   flog->sec[flog->active].live += rs;
+   _index_set (flog, key, a);
+   flog->stat.user_bytes += size;
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Delete \a key. A delete record is written, so the older
+ *    records of the key are not replayed at mount.
+ */
+drv_status_en flog_delete (flog_t *flog, flog_key_t key)
+{
+   if (flog->status != DRV_READY || key >= flog->keys)
+      return DRV_ERROR;
+   if (!flog->index[key])
+      return DRV_READY;
+   return flog_write (flog, key, NULL, 0);
+}
+
+/*!
+ * \brief
+ *    Program the pending data of the page buffer to flash.
+ */
+drv_status_en flog_sync (flog_t *flog)
+{
+   if (flog->status != DRV_READY)
+      return DRV_ERROR;
+   return _flush (flog);
+}
+
+/*!
+ * \brief
+ *    Background reclamation. Call it from the idle time. It reclaims one
+ *    sector while the free sectors are less than FLOG_SERVICE_SECTORS, so
+ *    the writes rarely wait for a sector erase.
+ *
+ * \param  flog   The active flog struct.
+ * \return        1 if a sector was reclaimed, 0 if there was nothing to do,
+ *                -1 on flash error
+ */
+int flog_service (flog_t *flog)
+{
+   if (flog->status != DRV_READY || flog->free >= FLOG_SERVICE_SECTORS)
+      return 0;
+   return _reclaim (flog);
+}
+
+/*!
+ * \brief
+ *    flog ioctl function
+ *
+ * \param  flog   The active flog struct.
+ * \param  cmd    specifies the command
+ *    \arg CTRL_GET_STATUS    Get flog's status
+ *    \arg CTRL_DEINIT        De-Initialise the store
+ *    \arg CTRL_INIT          Initialise and mount the store
+ *    \arg CTRL_SYNC          Program the pending data
+ *    \arg CTRL_FORMAT        Erase the store, the erase counts are kept
+ * \param  buf    pointer to buffer for ioctl
+ * \return The status of the operation
+ */
+drv_status_en flog_ioctl (flog_t *flog, ioctl_cmd_t cmd, ioctl_buf_t buf)
+{
+   uint32_t s;
+
+   switch (cmd) {
+      case CTRL_GET_STATUS:
+         if (buf)
+            *(drv_status_en*)buf = flog->status;
+         return DRV_READY;
+      case CTRL_DEINIT:
+         flog_deinit (flog);
+         return DRV_READY;
+      case CTRL_INIT:
+         if (buf)
+            *(drv_status_en*)buf = flog_init (flog);
+         else
+            flog_init (flog);
+         return DRV_READY;
+      case CTRL_SYNC:
+         return flog_sync (flog);
+      case CTRL_FORMAT:
+         if (flog->status != DRV_READY)
+            return DRV_ERROR;
+         flog->active = FLOG_NO_SECTOR;
+         flog->free = 0;
+         for (s=0 ; s<flog->conf.sectors ; ++s)
+            if (_format (flog, s) != DRV_READY)
+               return flog->status = DRV_ERROR;
+         return (_mount (flog) == DRV_READY) ? DRV_READY : (flog->status = DRV_ERROR);
+      default:
+         return DRV_ERROR;
+   }
+}
@@ -0,0 +1,257 @@
+/*!
+ * \file inputs.c
+ * \brief
+ *    A target independent multi bank input scanner with timestamped events
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <drv/inputs.h>
+
+/*
+ * ------------ Static API ------------------
+ */
+static void _put (in_t *in, uint32_t now, uint16_t id, uint8_t type);
+
+/*!
+ * \brief
+ *    Push an event to the event queue. A full queue drops the event
+ *    and counts it.
+ * \param  in     Pointer to the scanner to use
+ * \param  now    The scan time
+ * \param  id     The input id
+ * \param  type   The event type
+ */
+static void _put (in_t *in, uint32_t now, uint16_t id, uint8_t type)
+{
+   in_event_t  ev = { .time = now, .id = id, .type = type, ._res = 0 };
+
+   if (!ring_spsc_put (&in->q, (const void*)&ev))
+      ++in->lost;
+}
+
+
+/*
+ * ============================ Public Functions ============================
+ */
+
+/*
+ * Link and Glue functions
+ */
+
+/*!
+ * \brief
+ *    Links a bank device and its read function.
+ * \param  b      Pointer to the bank to use
+ * \param  dev    The bank device, passed to the read function
+ * \param  fun    The read function
+ */
+__INLINE void in_link_bank (in_bank_t *b, void *dev, in_read_ft fun) {
+   b->dev = dev;
+   b->read = fun;
+}
+
+/*
+ * Set functions
+ */
+__INLINE void in_set_bank_mask (in_bank_t *b, uint32_t mask, uint32_t inv) {
+   b->mask = mask;
+   b->inv = inv;
+}
+__INLINE void in_set_bank_repeat (in_bank_t *b, uint32_t rep) { b->rep = rep; }
+__INLINE void in_set_holdtime (in_t *in, uint32_t holdtime) { in->holdtime = holdtime; }
+__INLINE void in_set_reptime (in_t *in, uint32_t reptime) { in->reptime = reptime; }
+
+/*
+ * User Functions
+ */
+
+/*!
+ * \brief
+ *    De-Initialize the scanner
+ * \param  in     Pointer to the scanner to use
+ */
+void in_deinit (in_t *in)
+{
+   memset ((void*)in, 0, sizeof (in_t));
+   /*!<
+    * This leaves the status = DRV_NOINIT
+    */
+}
+
+/*!
+ * \brief
+ *    Initialize the scanner. The bank links and masks have to be set
+ *    before. The bank states start released.
+ *
+ * \param  in     Pointer to the scanner to use
+ * \param  bank   Pointer to the banks array
+ * \param  banks  The number of banks
+ * \param  buf    The event queue buffer
+ * \param  items  The event queue size, power of 2
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en in_init (in_t *in, in_bank_t *bank, int banks, in_event_t *buf, uint32_t items)
+{
+   if (!bank || banks <= 0 || banks > (0xFFFF >> 5))
+      return in->status = DRV_ERROR;
+   if (!ring_spsc_init (&in->q, (void*)buf, items, sizeof (in_event_t)))
+      return in->status = DRV_ERROR;
+
+   in->bank = bank;
+   in->banks = banks;
+   in->lost = 0;
+   if (!in->holdtime)   in->holdtime = IN_DEF_HOLDTIME;
+   if (!in->reptime)    in->reptime = IN_DEF_REPTIME;
+
+   for (int b=0 ; b<banks ; ++b) {
+      bank[b].state = bank[b].cnt0 = bank[b].cnt1 = 0;
+      bank[b].tmr = bank[b].lng = 0;
+   }
+   return in->status = DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Debounce a bank sample and produce its events.
+ *    Use it directly when the application already has the bank's state,
+ *    ex: from a port change interrupt.
+ *
+ *    The debounce is a 2 bit vertical counter for each input. All the
+ *    inputs of the bank are filtered with a few bitwise operations, and
+ *    only the inputs that changed state or wait for a deadline are
+ *    visited one by one.
+ *
+ * \param  in     Pointer to the scanner to use
+ * \param  b      The bank index
+ * \param  raw    The raw bank sample, before polarity
+ * \param  now    The current time in ticks
+ */
+void in_scan_bank (in_t *in, int b, uint32_t raw, uint32_t now)
+{
+   in_bank_t *bk = &in->bank[b];
+   uint32_t  delta, chg, pend;
+   int       i;
+
+   // Vertical counter. Counts the scans the sample differs from state
+   // and rolls over to 0 on the 4th, the same time state toggles.
+   delta = ((raw ^ bk->inv) & bk->mask) ^ bk->state;
+   bk->cnt1 = (bk->cnt1 ^ bk->cnt0) & delta;
+   bk->cnt0 = ~bk->cnt0 & delta;
+   chg = delta & ~(bk->cnt0 | bk->cnt1);
+   bk->state ^= chg;
+
+   // Press and release events
+   while (chg) {
+      i = __builtin_ctz (chg);
+      chg &= chg - 1;
+      if (bk->state & (1UL << i)) {
+         bk->dl[i] = now + in->holdtime;
+         bk->tmr |= (1UL << i);
+         _put (in, now, IN_ID(b, i), IN_EV_PRESS);
+      }
+      else {
+         _put (in, now, IN_ID(b, i), (bk->lng & (1UL << i)) ? IN_EV_LONG_RELEASE : IN_EV_RELEASE);
+         bk->tmr &= ~(1UL << i);
+         bk->lng &= ~(1UL << i);
+      }
+   }
+
+   // Long and repeat deadlines
+   pend = bk->tmr;
+   while (pend) {
+      i = __builtin_ctz (pend);
+      pend &= pend - 1;
+      if ((int32_t)(now - bk->dl[i]) < 0)
+         continue;
+      if (bk->lng & (1UL << i))
+         _put (in, now, IN_ID(b, i), IN_EV_REPEAT);
+      else {
+         _put (in, now, IN_ID(b, i), IN_EV_LONG);
+         bk->lng |= (1UL << i);
+      }
+      if (bk->rep & (1UL << i))
+         bk->dl[i] = now + in->reptime;
+      else
+         bk->tmr &= ~(1UL << i);
+   }
+}
+
+/*!
+ * \brief
+ *    Reads all the banks and produces their events. Can be called from
+ *    a timer interrupt or from a thread in while() loop, with a steady
+ *    period. The debounce time is 4 scan periods.
+ *
+ * \param  in     Pointer to the scanner to use
+ * \param  now    The current time in ticks, used for the deadlines and
+ *                the event timestamps.
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR   A bank read failed, the bank keeps its state
+ */
+drv_status_en in_scan (in_t *in, uint32_t now)
+{
+   drv_status_en  ret = DRV_READY;
+   uint32_t       raw;
+
+   for (int b=0 ; b<in->banks ; ++b) {
+      if (in->bank[b].read (in->bank[b].dev, &raw) != DRV_READY) {
+         ret = DRV_ERROR;
+         continue;
+      }
+      in_scan_bank (in, b, raw, now);
+   }
+   return ret;
+}
+
+/*!
+ * \brief
+ *    Get the next event from the event queue.
+ * \param  in     Pointer to the scanner to use
+ * \param  ev     Pointer to event to return
+ * \return
+ *    \arg 1   An event returned
+ *    \arg 0   The queue is empty
+ */
+__INLINE int in_get (in_t *in, in_event_t *ev) {
+   return ring_spsc_get (&in->q, (void*)ev);
+}
+
+/*!
+ * \brief
+ *    Returns the debounced state of a bank, 1 for active inputs.
+ */
+__INLINE uint32_t in_state (in_t *in, int b) {
+   return in->bank[b].state;
+}
+
+/*!
+ * \brief
+ *    Flush the event queue. Only from the consumer side.
+ */
+void in_flush (in_t *in)
+{
+   uint32_t n;
+
+   for (n=0 ; ring_spsc_peek (&in->q, &n) ; n=0)
+      ring_spsc_release (&in->q, n);
+}
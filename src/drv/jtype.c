@@ -56,10 +56,26 @@ static temp_t const J_Type_TEMP[] =
 };
 
 
+/*
+ * Compiled LUTs, built at first use
+ */
+static sen_lut_t _jtype;
+
+
 /*
  * ============================ Public Functions ============================
  */
 
+/*!
+ * \brief
+ *    The compiled J type, volt to temperature without the contact LUT, for \sa sen_convert_n()
+ */
+const sen_lut_t* sen_jtype_lut (void) {
+   if (!_jtype.n)
+      sen_lut_init (&_jtype, J_Type_mV, J_Type_TEMP, 1000);
+   return &_jtype;
+}
+
 /*!
  * \brief
  *    kty8x-121 conversion function
@@ -68,5 +84,5 @@ static temp_t const J_Type_TEMP[] =
  * \return temperature result
  */
 inline temp_t sen_jtype (float volt, float contact) {
-   return (temp_t)(contact + sen_pclut(volt*1000, J_Type_mV, J_Type_TEMP));
+   return (temp_t)(contact + sen_convert (sen_jtype_lut (), volt));
 }
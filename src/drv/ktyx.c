@@ -57,10 +57,28 @@ static temp_t const KTYx_TEMP[] =
 };
 
 
+/*
+ * Compiled LUTs, built at first use
+ */
+static sen_lut_t _kty121;
+static sen_lut_t _kty122;
+static sen_lut_t _kty116;
+
+
 /*
  * ============================ Public Functions ============================
  */
 
+/*!
+ * \brief
+ *    The compiled kty8x-121 LUT, for \sa sen_convert_n()
+ */
+const sen_lut_t* sen_kty8x_121_lut (void) {
+   if (!_kty121.n)
+      sen_lut_init (&_kty121, KTY81_121_RES, KTYx_TEMP, 1);
+   return &_kty121;
+}
+
 /*!
  * \brief
  *    kty8x-121 conversion function
@@ -68,7 +86,17 @@ static temp_t const KTYx_TEMP[] =
  * \return temperature result
  */
 inline temp_t sen_kty8x_121 (res_t r) {
-   return (temp_t)sen_pclut(r, KTY81_121_RES, KTYx_TEMP);
+   return (temp_t)sen_convert (sen_kty8x_121_lut (), r);
+}
+
+/*!
+ * \brief
+ *    The compiled kty8x-122 LUT, for \sa sen_convert_n()
+ */
+const sen_lut_t* sen_kty8x_122_lut (void) {
+   if (!_kty122.n)
+      sen_lut_init (&_kty122, KTY81_122_RES, KTYx_TEMP, 1);
+   return &_kty122;
 }
 
 /*!
@@ -78,7 +106,17 @@ inline temp_t sen_kty8x_121 (res_t r) {
  * \return temperature result
  */
 temp_t sen_kty8x_122 (res_t r){
-   return (temp_t)sen_pclut(r, KTY81_122_RES, KTYx_TEMP);
+   return (temp_t)sen_convert (sen_kty8x_122_lut (), r);
+}
+
+/*!
+ * \brief
+ *    The compiled kty11-6 LUT, for \sa sen_convert_n()
+ */
+const sen_lut_t* sen_kty11_6_lut (void) {
+   if (!_kty116.n)
+      sen_lut_init (&_kty116, KTY11_6_RES, KTYx_TEMP, 1);
+   return &_kty116;
 }
 
 /*!
@@ -88,7 +126,7 @@ temp_t sen_kty8x_122 (res_t r){
  * \return temperature result
  */
 temp_t sen_kty11_6 (res_t r){
-   return (temp_t)sen_pclut(r, KTY11_6_RES, KTYx_TEMP);
+   return (temp_t)sen_convert (sen_kty11_6_lut (), r);
 }
 
 
@@ -43,10 +43,26 @@ static temp_t const _temp[] = {
 };
 
 
+/*
+ * Compiled LUTs, built at first use
+ */
+static sen_lut_t _ntc;
+
+
 /*
  * ============================ Public Functions ============================
  */
 
+/*!
+ * \brief
+ *    The compiled ntc10k_3435k LUT, for \sa sen_convert_n()
+ */
+const sen_lut_t* sen_ntc10k_3435k_lut (void) {
+   if (!_ntc.n)
+      sen_lut_init (&_ntc, _res, _temp, 1);
+   return &_ntc;
+}
+
 /*!
  * \brief
  *    ntc10k_3435k conversion function
@@ -54,5 +70,5 @@ static temp_t const _temp[] = {
  * \return temperature result
  */
 inline temp_t sen_ntc10k_3435k (res_t r) {
-   return (temp_t)sen_nclut(r, _res, _temp);
+   return (temp_t)sen_convert (sen_ntc10k_3435k_lut (), r);
 }
@@ -43,10 +43,26 @@ static temp_t const NTC10k_TEMP[] =
 };
 
 
+/*
+ * Compiled LUTs, built at first use
+ */
+static sen_lut_t _ntc;
+
+
 /*
  * ============================ Public Functions ============================
  */
 
+/*!
+ * \brief
+ *    The compiled ntc3997k LUT, for \sa sen_convert_n()
+ */
+const sen_lut_t* sen_ntc3997k_lut (void) {
+   if (!_ntc.n)
+      sen_lut_init (&_ntc, NTC10k_RES, NTC10k_TEMP, 1);
+   return &_ntc;
+}
+
 /*!
  * \brief
  *    kty8x-121 conversion function
@@ -54,5 +70,5 @@ static temp_t const NTC10k_TEMP[] =
  * \return temperature result
  */
 inline temp_t sen_ntc3997k (res_t r) {
-   return (temp_t)sen_nclut(r, NTC10k_RES, NTC10k_TEMP);
+   return (temp_t)sen_convert (sen_ntc3997k_lut (), r);
 }
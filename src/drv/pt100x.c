@@ -56,10 +56,27 @@ static temp_t const PT100x_TEMP[]=
 };
 
 
+/*
+ * Compiled LUTs, built at first use
+ */
+static sen_lut_t _pt100;
+static sen_lut_t _pt1000;
+
+
 /*
  * ============================ Public Functions ============================
  */
 
+/*!
+ * \brief
+ *    The compiled pt100 LUT, for \sa sen_convert_n()
+ */
+const sen_lut_t* sen_pt100_lut (void) {
+   if (!_pt100.n)
+      sen_lut_init (&_pt100, PT100x_RES, PT100x_TEMP, 10);
+   return &_pt100;
+}
+
 /*!
  * \brief
  *    pt100 conversion function
@@ -67,7 +84,17 @@ static temp_t const PT100x_TEMP[]=
  * \return temperature result
  */
 inline temp_t sen_pt100 (res_t r) {
-    return (temp_t)sen_pclut(r*10, PT100x_RES, PT100x_TEMP);
+    return (temp_t)sen_convert (sen_pt100_lut (), r);
+}
+
+/*!
+ * \brief
+ *    The compiled pt1000 LUT, for \sa sen_convert_n()
+ */
+const sen_lut_t* sen_pt1000_lut (void) {
+   if (!_pt1000.n)
+      sen_lut_init (&_pt1000, PT100x_RES, PT100x_TEMP, 1);
+   return &_pt1000;
 }
 
 /*!
@@ -77,6 +104,6 @@ inline temp_t sen_pt100 (res_t r) {
  * \return temperature result
  */
 inline temp_t sen_pt1000 (res_t r) {
-    return (temp_t)sen_pclut(r, PT100x_RES, PT100x_TEMP);
+    return (temp_t)sen_convert (sen_pt1000_lut (), r);
 }
 
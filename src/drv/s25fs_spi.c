@@ -33,6 +33,8 @@ static drv_status_en _cmd_WRDI (s25fs_t *drv);
 static drv_status_en _cmd_SE (s25fs_t *drv, s25fs_idx_t idx);
 
 static int _wait_ready (s25fs_t *drv);
+static int _poll_ready (s25fs_t *drv, s25fs_op_t *op);
+static int    _program (s25fs_t *drv, s25fs_idx_t idx, byte_t *buf, int n);
 static int  _writepage (s25fs_t *drv, s25fs_idx_t idx, byte_t *buf, int n);
 /*!
  * \brief
@@ -220,10 +222,36 @@ static int _wait_ready (s25fs_t *drv)
 
 /*!
  * \brief
- *    Writes a number of data to the FLASH starting from \c idx
- *    till it reaches the end of the FLASH page, Even if buf contains
- *    more data.
- *    Returns the number of written bytes, to help \see s25fs_write_buffer()
+ *    Check once if the flash is ready, for the non blocking API.
+ *    Sends one RDSR1 and gives up on the operation's deadline.
+ *
+ * \param   drv   Pointer indicate the flash data stuct to use
+ * \param    op   Pointer to the operation, op->st gets the result
+ * \return
+ *    \arg  1  Done, ready or timeout in op->st
+ *    \arg  0  Still busy
+ */
+static int _poll_ready (s25fs_t *drv, s25fs_op_t *op)
+{
+   byte_t sr;
+
+   if (_cmd_RDSR1 (drv, &sr) == DRV_READY && !(sr & 0x01)) {
+      op->st = DRV_READY;
+      return 1;
+   }
+   if (jf_expired (op->dl)) {
+      op->st = DRV_ERROR;
+      return 1;
+   }
+   return 0;
+}
+
+/*!
+ * \brief
+ *    Starts a page program of the data from \c idx till the end of
+ *    the FLASH page, Even if buf contains more data. The flash clears
+ *    the write enable latch after each page program, so each page needs
+ *    its own WREN. The flash has to be ready.
  *
  * \param  drv   Pointer indicate the flash data stuct to use
  * \param  idx   The starting address of the FLASH
@@ -231,9 +259,9 @@ static int _wait_ready (s25fs_t *drv)
  * \param    n   The number of bytes to write
  *
  * \return
- *    The number of written bytes
+ *    The number of written bytes, or -1 on error
  */
-static int _writepage (s25fs_t *drv, s25fs_idx_t idx, byte_t *buf, int n)
+static int _program (s25fs_t *drv, s25fs_idx_t idx, byte_t *buf, int n)
 {
    // Page start and page offset and num to write
    int pg_offset = idx % drv->conf.write_page_sz;
@@ -241,15 +269,34 @@ static int _writepage (s25fs_t *drv, s25fs_idx_t idx, byte_t *buf, int n)
 
    if (nl > n)  nl = n;   // Cut out the unnecessary bytes
 
-   if ( !_wait_ready (drv) )
+   if ( _cmd_WREN (drv) != DRV_READY )
       return -1;
-
    if ( _write (drv, S25FS_PP_4B_CMD, idx, 4, buf, nl) != DRV_READY )
       return -1;
 
    return nl;
 }
 
+/*!
+ * \brief
+ *    Waits the flash and writes a number of data to the FLASH page
+ *    of \c idx. Returns the number of written bytes, to help
+ *    \see s25fs_write() and \see _program()
+ *
+ * \param  drv   Pointer indicate the flash data stuct to use
+ * \param  idx   The starting address of the FLASH
+ * \param  buf   Pointer to data to write
+ * \param    n   The number of bytes to write
+ *
+ * \return
+ *    The number of written bytes, or -1 on error
+ */
+static int _writepage (s25fs_t *drv, s25fs_idx_t idx, byte_t *buf, int n)
+{
+   if ( !_wait_ready (drv) )
+      return -1;
+   return _program (drv, idx, buf, n);
+}
 
 
 
@@ -383,9 +430,11 @@ drv_status_en s25fs_init (s25fs_t *drv)
 
    drv->status = DRV_BUSY;
 
-   // Bus SPI set mode 0
-   spi_set_cpha ((spi_bb_t*)drv->io.spi, 0);
-   spi_set_cpol ((spi_bb_t*)drv->io.spi, 0);
+   // Bus SPI set mode 0, only if the link is the bit-bang SPI
+   if (drv->io.spi_read == (s25fs_spi_rw_t)spi_rx) {
+      spi_set_cpha ((spi_bb_t*)drv->io.spi, 0);
+      spi_set_cpol ((spi_bb_t*)drv->io.spi, 0);
+   }
 
    // port init
    drv->io.cs (S25FS_DIS);
@@ -456,6 +505,10 @@ drv_status_en  s25fs_read (s25fs_t *drv, s25fs_idx_t idx, s25fs_data_t *buf, int
 /*!
  * \brief
  *    Write data to flash at address \a idx
+ * \note
+ *    The function returns while the last page programs. The next
+ *    flash operation waits for it, so the caller can prepare the next
+ *    data meanwhile.
  *
  * \param   drv   Pointer to active s25fs_t structure.
  * \param   idx   Sector address
@@ -468,12 +521,10 @@ drv_status_en  s25fs_read (s25fs_t *drv, s25fs_idx_t idx, s25fs_data_t *buf, int
  */
 drv_status_en s25fs_write (s25fs_t *drv, s25fs_idx_t idx, s25fs_data_t *buf, int count)
 {
-   uint32_t wb=0;    // The written bytes
+   int      wb=0;    // The written bytes
    int      ret;
 
    if (drv->io.wp)   drv->io.wp (S25FS_DIS);
-   if ( _cmd_WREN (drv) != DRV_READY )
-      return DRV_ERROR;
 
    do {
       ret = _writepage (drv, idx+wb, &buf[wb], count-wb);
@@ -486,10 +537,6 @@ drv_status_en s25fs_write (s25fs_t *drv, s25fs_idx_t idx, s25fs_data_t *buf, int
        */
    } while (wb < count);
 
-   if ( !_wait_ready (drv) )
-      return DRV_ERROR;
-   if ( _cmd_WRDI (drv) != DRV_READY )
-      return DRV_ERROR;
    if (drv->io.wp)   drv->io.wp (S25FS_EN);
 
    return DRV_READY;
@@ -543,6 +590,105 @@ drv_status_en s25fs_write_sector (s25fs_t *drv, int sector, s25fs_data_t *buf, i
 }
 
 
+/*!
+ * \brief
+ *    Non blocking sector erase at address \a idx. It returns DRV_BUSY
+ *    while the flash is busy, and it has to be called again with the
+ *    same arguments until it returns the status. Each call sends at most
+ *    one status read, so the CPU and the bus are free for the others
+ *    during the erase.
+ *
+ * \param  drv    pointer to active s25fs_t structure.
+ * \param   op    Pointer to the operation state, zero before the first call
+ * \param  idx    Sector address
+ *
+ * \return The status of the erase operation.
+ *    \arg DRV_BUSY     Pending, call again
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR    Communication error or timeout
+ */
+drv_status_en s25fs_erase_async (s25fs_t *drv, s25fs_op_t *op, s25fs_idx_t idx)
+{
+   PT_BEGIN (&op->pt);
+   op->dl = jf_deadline_ms (S25FS_TIMEOUT);
+   PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+   if (op->st != DRV_READY)
+      PT_EXIT (&op->pt, DRV_ERROR);
+
+   if (drv->io.wp)   drv->io.wp (S25FS_DIS);
+   if ( _cmd_WREN (drv) != DRV_READY || _cmd_SE (drv, idx) != DRV_READY )
+      PT_EXIT (&op->pt, DRV_ERROR);
+
+   op->dl = jf_deadline_ms (S25FS_TIMEOUT);
+   PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+   if (op->st != DRV_READY || _cmd_WRDI (drv) != DRV_READY)
+      PT_EXIT (&op->pt, DRV_ERROR);
+   if (drv->io.wp)   drv->io.wp (S25FS_EN);
+   PT_END (&op->pt);
+}
+
+/*!
+ * \brief
+ *    Non blocking read from flash at address \a idx. \see s25fs_erase_async()
+ *
+ * \param   drv   Pointer to active s25fs_t structure.
+ * \param    op   Pointer to the operation state, zero before the first call
+ * \param   idx   Sector address
+ * \param   buf   Buffer pointer to store the data from flash
+ * \param count   Number of bytes to read
+ *
+ * \return The status of the read operation.
+ *    \arg DRV_BUSY     Pending, call again
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en s25fs_read_async (s25fs_t *drv, s25fs_op_t *op, s25fs_idx_t idx, s25fs_data_t *buf, int count)
+{
+   PT_BEGIN (&op->pt);
+   op->dl = jf_deadline_ms (S25FS_TIMEOUT);
+   PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+   if (op->st != DRV_READY)
+      PT_EXIT (&op->pt, DRV_ERROR);
+   PT_EXIT (&op->pt, _read (drv, S25FS_READ_4B_CMD, idx, 4, buf, count));
+   PT_END (&op->pt);
+}
+
+/*!
+ * \brief
+ *    Non blocking write to flash at address \a idx, one page program
+ *    for each page. As s25fs_write() it returns while the last page
+ *    programs. \see s25fs_erase_async()
+ *
+ * \param   drv   Pointer to active s25fs_t structure.
+ * \param    op   Pointer to the operation state, zero before the first call
+ * \param   idx   Sector address
+ * \param   buf   Buffer pointer with the data to write
+ * \param count   Number of bytes to write
+ *
+ * \return The status of the write operation.
+ *    \arg DRV_BUSY     Pending, call again
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en s25fs_write_async (s25fs_t *drv, s25fs_op_t *op, s25fs_idx_t idx, s25fs_data_t *buf, int count)
+{
+   PT_BEGIN (&op->pt);
+   if (drv->io.wp)   drv->io.wp (S25FS_DIS);
+
+   for (op->done=0 ; op->done<count ; op->done += op->ret) {
+      op->dl = jf_deadline_ms (S25FS_TIMEOUT);
+      PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+      if (op->st != DRV_READY)
+         PT_EXIT (&op->pt, DRV_ERROR);
+      if ((op->ret = _program (drv, idx + op->done, &buf[op->done], count - op->done)) == -1)
+         PT_EXIT (&op->pt, DRV_ERROR);
+   }
+
+   if (drv->io.wp)   drv->io.wp (S25FS_EN);
+   PT_END (&op->pt);
+}
+
+
 /*!
  * \brief
  *    S25FS ioctl function
@@ -42,14 +42,21 @@ static void     _select (int drv, uint8_t on);
 static sd_dat_t _spi_rw (int drv, sd_dat_t out);
 static void     _spi_tx (int drv, sd_dat_t d);
 static sd_dat_t _spi_rx (int drv);
+static void     _spi_xfer (int drv, const sd_dat_t *tx, sd_dat_t *rx, size_t n);
 static sd_dat_t _wait_ready (int drv);
+static int      _poll_ready (int drv, sd_op_t *op);
+static int      _poll_token (int drv, sd_op_t *op);
 static void     _release (int drv);
 static drv_status_en _spi_deinit (int drv);
 static drv_status_en _spi_init (int drv);
 static drv_status_en _power (int drv, uint8_t on);
 static uint8_t  _rx_datablock (int drv, sd_dat_t *buf, uint32_t n);
+static uint8_t  _tx_data (int drv, const sd_dat_t *buf, sd_dat_t token);
 static uint8_t  _tx_datablock (int drv, const sd_dat_t *buf, sd_dat_t token);
 static sd_dat_t _send_command (int drv, sd_dat_t cmd, uint32_t arg);
+static size_t   _read_sectors (int drv, sd_idx_t sector, sd_dat_t *buf, size_t count);
+static void     _cache_update (int drv, sd_idx_t sector, const sd_dat_t *buf, size_t count);
+static drv_status_en _op_end (int drv, drv_status_en st);
 
 /*
  * tools
@@ -214,6 +221,32 @@ static inline sd_dat_t _spi_rx (int drv) {
    return (sd_dat_t) _spi_rw (drv, 0xFF);
 }
 
+/*!
+ * \brief
+ *    Transmit/Receive a block of bytes to SD/MMC via SPI. It uses the
+ *    bulk SPI function if linked, or the byte function otherwise.
+ *
+ * \param   drv   The number of physical drive.
+ * \param   tx    Data to send. If NULL 0xFF is send.
+ * \param   rx    Buffer for the received data. If NULL they are discarded.
+ * \param   n     Byte count
+ * \return        None
+ */
+static void _spi_xfer (int drv, const sd_dat_t *tx, sd_dat_t *rx, size_t n)
+{
+   sd_dat_t d;
+
+   if (sd.sd_io[drv].spi_rw_block) {
+      sd.sd_io[drv].spi_rw_block (sd.sd_io[drv].spi, tx, rx, n);
+      return;
+   }
+   for ( ; n ; --n) {
+      d = _spi_rw (drv, (tx) ? *tx++ : 0xFF);
+      if (rx)
+         *rx++ = d;
+   }
+}
+
 
 /*!
  * \brief
@@ -237,6 +270,40 @@ static sd_dat_t _wait_ready (int drv)
    return res;
 }
 
+/*!
+ * \brief
+ *    One ready polling byte, the non blocking \see _wait_ready().
+ *    The caller sets the timeout in sd.drive[drv].t2.
+ *
+ * \param   drv   The number of physical drive.
+ * \param   op    Pointer to the operation, op->r gets the polled byte
+ * \return
+ *    \arg 1  Done, op->r is 0xFF when ready, or not on timeout
+ *    \arg 0  The card is busy, try again
+ */
+static int _poll_ready (int drv, sd_op_t *op)
+{
+   op->r = _spi_rx (drv);
+   return (op->r == 0xFF || !sd.drive[drv].t2) ? 1:0;
+}
+
+/*!
+ * \brief
+ *    One data token polling byte, the non blocking wait of
+ *    \see _rx_datablock(). The caller sets the timeout in sd.drive[drv].t2.
+ *
+ * \param   drv   The number of physical drive.
+ * \param   op    Pointer to the operation, op->r gets the polled byte
+ * \return
+ *    \arg 1  Done, op->r is the token, or 0xFF on timeout
+ *    \arg 0  No token yet, try again
+ */
+static int _poll_token (int drv, sd_op_t *op)
+{
+   op->r = _spi_rx (drv);
+   return (op->r != 0xFF || !sd.drive[drv].t2) ? 1:0;
+}
+
 /*!
  * \brief
  *    Deselect SD Card and release SPI bus
@@ -335,7 +402,6 @@ static drv_status_en _power (int drv, uint8_t on)
  */
 static uint8_t _rx_datablock (int drv, sd_dat_t *buf, uint32_t n)
 {
-   #define _spi_rx_m(_data)   *(_data)=_spi_rw (drv, 0xFF)
    sd_dat_t token;
 
    /*!
@@ -353,19 +419,15 @@ static uint8_t _rx_datablock (int drv, sd_dat_t *buf, uint32_t n)
     * Receive the data block into buffer and make sure
     * we receive multiples of 4
     */
-   for (n+=(n%4) ? 4-(n%4):0 ; n>0 ; --n)
-      _spi_rx_m (buf++);
-
-   _spi_rw (drv, 0xFF);  // Discard CRC
-   _spi_rw (drv, 0xFF);
-
-   #undef _spi_rx_m
+   n += (n%4) ? 4-(n%4):0;
+   _spi_xfer (drv, NULL, buf, n);
+   _spi_xfer (drv, NULL, NULL, 2);  // Discard CRC
    return 1;
 }
 
 /*!
  * \brief
- *    Transmit a data block (512bytes) to MMC/SD
+ *    Transmit a data block (512bytes) to a ready MMC/SD
  *
  * \param   drv   The number of physical drive.
  * \param   buf   Pointer to 512 byte data block to be transmitted
@@ -374,15 +436,10 @@ static uint8_t _rx_datablock (int drv, sd_dat_t *buf, uint32_t n)
  *    \arg  0     Fail
  *    \arg  1     Success.
  */
-static uint8_t _tx_datablock (int drv, const sd_dat_t *buf, sd_dat_t token)
+static uint8_t _tx_data (int drv, const sd_dat_t *buf, sd_dat_t token)
 {
-   #define _spi_txb_m(_data)   _spi_rw (drv, *(_data))
    #define _spi_tx_m(_data)    _spi_rw (drv, (_data))
    sd_dat_t r;
-   int wc=512;
-
-   if (_wait_ready (drv) != 0xFF)
-      return 0;
 
    _spi_tx_m (token);  // transmit data token
    if (token != 0xFD) {
@@ -390,12 +447,8 @@ static uint8_t _tx_datablock (int drv, const sd_dat_t *buf, sd_dat_t token)
        * If is data token  transmit the 512 byte
        * data block to MMC/SD
        */
-      do
-         _spi_txb_m (buf++);
-      while (--wc);
-
-      _spi_tx_m (0xFF);          // CRC (Dummy)
-      _spi_tx_m (0xFF);
+      _spi_xfer (drv, buf, NULL, 512);
+      _spi_xfer (drv, NULL, NULL, 2);  // CRC (Dummy)
       r = _spi_rx (drv);          // Receive data response
       if ((r & 0x1F) != 0x05)    // If not accepted, return with error
          return 0;
@@ -403,10 +456,27 @@ static uint8_t _tx_datablock (int drv, const sd_dat_t *buf, sd_dat_t token)
 
    return 1;
 
-   #undef _spi_txb_m
    #undef _spi_tx_m
 }
 
+/*!
+ * \brief
+ *    Wait for the card and transmit a data block (512bytes) to MMC/SD
+ *
+ * \param   drv   The number of physical drive.
+ * \param   buf   Pointer to 512 byte data block to be transmitted
+ * \param   token Data/Stop token
+ * \return        The operation status
+ *    \arg  0     Fail
+ *    \arg  1     Success.
+ */
+static uint8_t _tx_datablock (int drv, const sd_dat_t *buf, sd_dat_t token)
+{
+   if (_wait_ready (drv) != 0xFF)
+      return 0;
+   return _tx_data (drv, buf, token);
+}
+
 /*!
  * \brief
  *    Send a command packet to SD/MMC
@@ -464,6 +534,84 @@ static sd_dat_t _send_command (int drv, sd_dat_t cmd, uint32_t arg)
    #undef _spi_tx_m
 }
 
+/*!
+ * \brief
+ *    Read sectors from the card. The card must be selected by the caller
+ *    and released afterwards.
+ *
+ * \param   drv    The number of physical drive.
+ * \param   sector Start sector number (LBA)
+ * \param   buf    Pointer to the data buffer to store read data
+ * \param   count  Sector (512 bytes) count
+ * \return         The number of sectors NOT read. 0 on success.
+ */
+static size_t _read_sectors (int drv, sd_idx_t sector, sd_dat_t *buf, size_t count)
+{
+   if (!(sd.drive[drv].type & CT_BLOCK)) // Convert to byte address if needed
+      sector *= 512;
+
+   if (count == 1) { //Single block read
+      if (_send_command (drv, SD_CMD17, sector) == 0)     // READ_SINGLE_BLOCK
+         if (_rx_datablock (drv, buf, 512))
+            count = 0;
+   } else {          // Multiple block read
+      if (_send_command (drv, SD_CMD18, sector) == 0) {   // READ_MULTIPLE_BLOCK
+         do {
+            if (!_rx_datablock (drv, buf, 512))
+               break;
+            buf += 512;
+         } while (--count);
+         _send_command (drv, SD_CMD12, 0);                // STOP_TRANSMISSION
+      }
+   }
+   return count;
+}
+
+/*!
+ * \brief
+ *    Keep the read-ahead cache coherent with written sectors
+ *
+ * \param   drv    The number of physical drive.
+ * \param   sector Start sector number (LBA) of the written data
+ * \param   buf    Pointer to the written data, or NULL to invalidate the cache
+ * \param   count  Sector count
+ * \return         None
+ */
+static void _cache_update (int drv, sd_idx_t sector, const sd_dat_t *buf, size_t count)
+{
+   sd_idx_t from, to;
+
+   if (!sd.drive[drv].ra_count)
+      return;
+   if (!buf) {
+      sd.drive[drv].ra_count = 0;
+      return;
+   }
+   from = (sector > sd.drive[drv].ra_sector) ? sector : sd.drive[drv].ra_sector;
+   to = sd.drive[drv].ra_sector + sd.drive[drv].ra_count;
+   if (sector + count < to)
+      to = sector + count;
+   if (from < to)
+      memcpy ((void*)&sd.sd_io[drv].ra_buf[(from - sd.drive[drv].ra_sector) * 512],
+              (const void*)&buf[(from - sector) * 512],
+              (to - from) * 512);
+}
+
+/*!
+ * \brief
+ *    End of a non blocking operation. Release the card and set the
+ *    drive status as the blocking calls do.
+ *
+ * \param   drv   The number of physical drive.
+ * \param   st    The operation status
+ * \return        The operation status
+ */
+static drv_status_en _op_end (int drv, drv_status_en st)
+{
+   _release (drv);
+   return (drv_status_en) (sd.drive[drv].status = st);
+}
+
 
 
 /*============================   Public Functions   ============================ */
@@ -502,6 +650,29 @@ inline void sd_link_spi_rw (int drv, spi_rw_t fun) {
       return;
    sd.sd_io[drv].spi_rw = fun;
 }
+inline void sd_link_spi_rw_block (int drv, spi_rw_block_t fun) {
+   if (_bad_drive(drv))
+      return;
+   sd.sd_io[drv].spi_rw_block = fun;
+}
+
+/*!
+ * \brief
+ *    Link a read-ahead cache buffer to the drive. Small reads are served
+ *    by reading \a sectors sectors at once with a multiple block read,
+ *    so sequential access needs one command per \a sectors sectors.
+ *
+ * \param   drv      The number of physical drive.
+ * \param   buf      Pointer to the cache buffer of sectors * 512 bytes, NULL to disable
+ * \param   sectors  The cache size in sectors
+ */
+void sd_link_cache (int drv, void* buf, uint32_t sectors) {
+   if (_bad_drive(drv))
+      return;
+   sd.sd_io[drv].ra_buf = (buf) ? (sd_dat_t*)buf : NULL;
+   sd.sd_io[drv].ra_size = (buf) ? sectors : 0;
+   sd.drive[drv].ra_count = 0;
+}
 inline void sd_link_spi (int drv, void* spi) {
    if (_bad_drive(drv))
       return;
@@ -584,6 +755,8 @@ drv_status_en sd_init (int drv)
    if (_bad_link(spi_ioctl))  return DRV_ERROR;
    if (_bad_link(spi_rw))     return DRV_ERROR;
 
+   sd.drive[drv].ra_count = 0;               // Drop cached data of the previous card
+
    _power_pin (drv, 0);                      // Initially power off the card
    if (!_is_present (drv)) {                 // No card in the socket
       sd.drive[drv].status = DRV_NODEV;
@@ -702,23 +875,27 @@ drv_status_en sd_read (int drv, sd_idx_t sector, sd_dat_t *buf, size_t count)
       return DRV_ERROR;
 
    sd.drive[drv].status = DRV_BUSY;
-   if (!(sd.drive[drv].type & CT_BLOCK)) // Convert to byte address if needed
-      sector *= 512;
-
-   if (count == 1) { //Single block read
-      if (_send_command (drv, SD_CMD17, sector) == 0)     // READ_SINGLE_BLOCK
-         if (_rx_datablock (drv, buf, 512))
-            count = 0;
-   } else {          // Multiple block read
-      if (_send_command (drv, SD_CMD18, sector) == 0) {   // READ_MULTIPLE_BLOCK
-         do {
-            if (!_rx_datablock (drv, buf, 512))
-               break;
-            buf += 512;
-         } while (--count);
-         _send_command (drv, SD_CMD12, 0);                // STOP_TRANSMISSION
+   if (count < sd.sd_io[drv].ra_size) {
+      /*
+       * Small read. Serve it from the read-ahead cache and
+       * refill the cache on miss.
+       */
+      if (sector < sd.drive[drv].ra_sector
+         || sector + count > sd.drive[drv].ra_sector + sd.drive[drv].ra_count) {
+         // The last sectors of the card may not be readable, keep what we got
+         sd.drive[drv].ra_sector = sector;
+         sd.drive[drv].ra_count = sd.sd_io[drv].ra_size
+            - _read_sectors (drv, sector, sd.sd_io[drv].ra_buf, sd.sd_io[drv].ra_size);
+         _release (drv);
+      }
+      if (sector + count <= sd.drive[drv].ra_sector + sd.drive[drv].ra_count) {
+         memcpy ((void*)buf,
+                 (const void*)&sd.sd_io[drv].ra_buf[(sector - sd.drive[drv].ra_sector) * 512],
+                 count * 512);
+         return (drv_status_en) (sd.drive[drv].status = DRV_READY);
       }
    }
+   count = _read_sectors (drv, sector, buf, count);
    _release (drv);
    return (drv_status_en) (sd.drive[drv].status = count ? DRV_ERROR : DRV_READY);
 }
@@ -744,6 +921,7 @@ drv_status_en sd_write (int drv, sd_idx_t sector, const sd_dat_t *buf, size_t co
       return DRV_ERROR;
 
    sd.drive[drv].status = DRV_BUSY;
+   _cache_update (drv, sector, buf, count);
    if (!(sd.drive[drv].type & CT_BLOCK)) // Convert to byte address if needed
       sector *= 512;
 
@@ -753,7 +931,7 @@ drv_status_en sd_write (int drv, sd_idx_t sector, const sd_dat_t *buf, size_t co
          count = 0;
    } else {             // Multiple block write
       if (sd.drive[drv].type & CT_SDC)
-         _send_command (drv, SD_ACMD23, count);
+         _send_command (drv, SD_ACMD23, count);    // Pre-erase the blocks
       if (_send_command (drv, SD_CMD25, sector) == 0) { // WRITE_MULTIPLE_BLOCK
          do {
             if (!_tx_datablock (drv, buf, 0xFC))
@@ -765,9 +943,128 @@ drv_status_en sd_write (int drv, sd_idx_t sector, const sd_dat_t *buf, size_t co
       }
    }
    _release (drv);
+   if (count)
+      _cache_update (drv, sector, NULL, 0);  // Unknown card content
    return (drv_status_en) (sd.drive[drv].status = count ? DRV_ERROR : DRV_READY);
 }
 
+/*!
+ * \brief
+ *    Non blocking read of sector(s). It returns DRV_BUSY while the card
+ *    is busy or in its access time, and it has to be called again with the
+ *    same arguments until it returns the status. Each call clocks one
+ *    polling byte, so the CPU and the SPI bus are free for the others
+ *    meanwhile. The drive status is DRV_BUSY during the operation.
+ * \note
+ *    The async calls go to the card without the read-ahead cache.
+ *
+ * \param   drv    The number of physical drive.
+ * \param   op     Pointer to the operation state, zero before the first call
+ * \param   sector Start sector number (LBA)
+ * \param   buf    Pointer to the data buffer to store read data
+ * \param   count  Sector (512 bytes) count (1..255)
+ * \return  The status of the operation
+ *    \arg  DRV_BUSY    Pending, call again
+ *    \arg  DRV_ERROR   On error.
+ *    \arg  DRV_READY   On success.
+ */
+drv_status_en sd_read_async (int drv, sd_op_t *op, sd_idx_t sector, sd_dat_t *buf, size_t count)
+{
+   PT_BEGIN (&op->pt);
+   if (_bad_drive(drv))             PT_EXIT (&op->pt, DRV_ERROR);
+   if (!count)                      PT_EXIT (&op->pt, DRV_ERROR);
+   if (sd.drive[drv].status != DRV_READY)
+      PT_EXIT (&op->pt, DRV_ERROR);
+
+   sd.drive[drv].status = DRV_BUSY;
+   op->addr = (sd.drive[drv].type & CT_BLOCK) ? sector : sector * 512;
+
+   // Wait for the card here, so the _send_command() does not block
+   _select (drv, 1);
+   sd.drive[drv].t2 = SD_WAIT_TIMEOUT;
+   PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+   if (op->r != 0xFF
+      || _send_command (drv, (count == 1) ? SD_CMD17 : SD_CMD18, op->addr) != 0)
+      PT_EXIT (&op->pt, _op_end (drv, DRV_ERROR));
+
+   for (op->done=0 ; op->done<count ; ++op->done) {
+      sd.drive[drv].t2 = SD_RX_TIMEOUT;
+      PT_WAIT_UNTIL (&op->pt, _poll_token (drv, op));
+      if (op->r != 0xFE)
+         break;
+      _spi_xfer (drv, NULL, &buf[op->done * 512], 512);
+      _spi_xfer (drv, NULL, NULL, 2);  // Discard CRC
+   }
+   if (count > 1)
+      _send_command (drv, SD_CMD12, 0);            // STOP_TRANSMISSION
+   PT_EXIT (&op->pt, _op_end (drv, (op->done == count) ? DRV_READY : DRV_ERROR));
+   PT_END (&op->pt);
+}
+
+/*!
+ * \brief
+ *    Non blocking write of sector(s). It waits also for the programming
+ *    of the last block, so the next command finds a ready card.
+ *    \see sd_read_async()
+ *
+ * \param   drv    The number of physical drive.
+ * \param   op     Pointer to the operation state, zero before the first call
+ * \param   sector Start sector number (LBA)
+ * \param   buf    Pointer to the data to be written
+ * \param   count  Sector(512 bytes) count (1..255)
+ * \return  The status of the operation
+ *    \arg  DRV_BUSY    Pending, call again
+ *    \arg  DRV_ERROR   On error.
+ *    \arg  DRV_READY   On success.
+ */
+drv_status_en sd_write_async (int drv, sd_op_t *op, sd_idx_t sector, const sd_dat_t *buf, size_t count)
+{
+   PT_BEGIN (&op->pt);
+   if (_bad_drive(drv))             PT_EXIT (&op->pt, DRV_ERROR);
+   if (_is_write_protected (drv))   PT_EXIT (&op->pt, DRV_ERROR);
+   if (!count)                      PT_EXIT (&op->pt, DRV_ERROR);
+   if (sd.drive[drv].status != DRV_READY)
+      PT_EXIT (&op->pt, DRV_ERROR);
+
+   sd.drive[drv].status = DRV_BUSY;
+   _cache_update (drv, sector, buf, count);
+   op->addr = (sd.drive[drv].type & CT_BLOCK) ? sector : sector * 512;
+   op->done = 0;
+
+   // Wait for the card here, so the _send_command() does not block
+   _select (drv, 1);
+   sd.drive[drv].t2 = SD_WAIT_TIMEOUT;
+   PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+   if (op->r == 0xFF) {
+      if (count > 1 && (sd.drive[drv].type & CT_SDC))
+         _send_command (drv, SD_ACMD23, count);    // Pre-erase the blocks
+      if (_send_command (drv, (count == 1) ? SD_CMD24 : SD_CMD25, op->addr) == 0) {
+         for ( ; op->done<count ; ++op->done) {
+            sd.drive[drv].t2 = SD_WAIT_TIMEOUT;
+            PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+            if (op->r != 0xFF
+               || !_tx_data (drv, &buf[op->done * 512], (count == 1) ? 0xFE : 0xFC))
+               break;
+         }
+         if (count > 1 && op->done == count) {
+            sd.drive[drv].t2 = SD_WAIT_TIMEOUT;
+            PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+            if (op->r != 0xFF || !_tx_data (drv, 0, 0xFD))  // STOP_TRAN token
+               op->done = 0;
+         }
+         // The programming of the last block
+         sd.drive[drv].t2 = SD_WAIT_TIMEOUT;
+         PT_WAIT_UNTIL (&op->pt, _poll_ready (drv, op));
+      }
+   }
+   if (op->done != count || op->r != 0xFF) {
+      _cache_update (drv, sector, NULL, 0);        // Unknown card content
+      PT_EXIT (&op->pt, _op_end (drv, DRV_ERROR));
+   }
+   PT_EXIT (&op->pt, _op_end (drv, DRV_READY));
+   PT_END (&op->pt);
+}
+
 /*!
  * \brief
  *    Write Sector(s)
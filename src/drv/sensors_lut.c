@@ -27,8 +27,68 @@
  */
 
 #include <drv/sensors_lut.h>
+#include <toolbox_defs.h>
 
-/* 
+/*
+ * =====================    Static    ==========================
+ */
+#define _SEN_BLOCK      (64)     /*!< Samples per sen_convert_n() pass */
+#define _SEN_KELVIN     (273.15)
+
+static int _solve (int m, double A[4][5], double x[4]);
+static float _fitval (const sen_lut_t *lut, float x);
+
+/*!
+ * \brief
+ *    Solve the m x m system A.x = b, with b as the column m of A,
+ *    with Gauss elimination and partial pivoting.
+ * \return  1 on success, 0 for a singular system
+ */
+static int _solve (int m, double A[4][5], double x[4])
+{
+   double f, t;
+   int i, j, k, p;
+
+   for (k=0 ; k<m ; ++k) {
+      for (p=k, i=k+1 ; i<m ; ++i)
+         if (fabs (A[i][k]) > fabs (A[p][k]))
+            p = i;
+      if (A[p][k] == 0)
+         return 0;
+      for (j=k ; j<=m ; ++j) {
+         t = A[k][j]; A[k][j] = A[p][j]; A[p][j] = t;
+      }
+      for (i=k+1 ; i<m ; ++i) {
+         f = A[i][k] / A[k][k];
+         for (j=k ; j<=m ; ++j)
+            A[i][j] -= f * A[k][j];
+      }
+   }
+   for (i=m-1 ; i>=0 ; --i) {
+      for (t=A[i][m], j=i+1 ; j<m ; ++j)
+         t -= A[i][j] * x[j];
+      x[i] = t / A[i][i];
+   }
+   return 1;
+}
+
+/*!
+ * \brief
+ *    The fit value at x, the input in the table units
+ */
+static float _fitval (const sen_lut_t *lut, float x)
+{
+   float l;
+
+   if (lut->fit == SEN_FIT_SH) {
+      l = logf (x);
+      return 1 / (lut->c[0] + l*(lut->c[1] + l*l*lut->c[2])) - (float)_SEN_KELVIN;
+   }
+   x = (x - lut->xc) * lut->xs;
+   return lut->c[0] + x*(lut->c[1] + x*(lut->c[2] + x*lut->c[3]));
+}
+
+/*
  * =====================    Functions    ==========================
  */
 
@@ -45,6 +105,9 @@
  *          T = 10 - ---------- * (20-10)
  *                    R20 - R10
  *          Use this for NTC Thermistors etc..
+ * \note
+ *    The table is scanned on every call, see \sa sen_lut_init()
+ *    for the compiled form.
  *
  * \param  v   The measured value
  * \param  F   Pointer to the LUT Sensor FROM array
@@ -53,18 +116,16 @@
  */
 float sen_nclut (float v, const lut_t *F, const float *T)
 {
-   int t = T[0], i = 0, j;
+   int i;
 
-   //Find end point
-   for (j=0 ; T[j]!= INT_MAX ; ++j)
+   //Boundary checking on the way to the segment
+   if (v > F[0])
+      return TEMP_ERROR;
+   for (i=1 ; T[i] != INT_MAX && v < F[i] ; ++i)
       ;
-   //Boundary checking
-   if (v < F[j-1] || v > F[0])
+   if (T[i] == INT_MAX)
       return TEMP_ERROR;
-   //First match (for now)
-   while (v <= F[i])
-      t=T[i++];
-   return (t + ((F[i-1] - v) / (F[i-1] - F[i])) * (T[i] - T[i-1]) );
+   return (T[i-1] + ((F[i-1] - v) / (F[i-1] - F[i])) * (T[i] - T[i-1]) );
 }
 
 
@@ -81,6 +142,9 @@ float sen_nclut (float v, const lut_t *F, const float *T)
  *          T = 10 - ---------- * (20-10)
  *                    R20 - R10
  *          Use this for PT100, PT1000, PTC thermistors etc..
+ * \note
+ *    The table is scanned on every call, see \sa sen_lut_init()
+ *    for the compiled form.
  *
  * \param  v   The measured value
  * \param  F   Pointer to the LUT Sensor FROM array
@@ -89,20 +153,232 @@ float sen_nclut (float v, const lut_t *F, const float *T)
  */
 float sen_pclut (float v, const lut_t *F, const float *T)
 {
-   int i = 0, j, t =0;
+   int i;
 
-   //Find end point
-   for (j=0 ; T[j]!= INT_MAX ; ++j)
+   //Boundary checking on the way to the segment
+   if (v < F[0])
+      return TEMP_ERROR;
+   for (i=1 ; T[i] != INT_MAX && v > F[i] ; ++i)
       ;
-   //Boundary checking
-   if (v < F[0] || v > F[j-1])
+   if (T[i] == INT_MAX)
       return TEMP_ERROR;
-   //First match (for now)
-   while (v >= F[i])
-      t=T[i++];
-   return (t + ((v - F[i-1]) / (F[i] - F[i-1])) * (T[i] - T[i-1]) );
+   return (T[i-1] + ((v - F[i-1]) / (F[i] - F[i-1])) * (T[i] - T[i-1]) );
 }
 
+/*!
+ * \brief
+ *    Compile a sensor LUT. The table is read once: its length, the
+ *    segment slopes and if the FROM points are evenly spaced. A table
+ *    with even spacing converts with direct indexing, any other with
+ *    a branchless binary search.
+ *
+ * \param  lut    Pointer to the compiled LUT to build
+ * \param  F      Pointer to the LUT Sensor FROM array, positive or negative coefficient
+ * \param  T      Pointer to the LUT Sensor TO array, INT_MAX terminated
+ * \param  scale  The input is multiplied by scale to get the FROM units. Ex: 10 to
+ *                convert PT100 resistance with the PT1000 table
+ * \return        The number of points, 0 on error (less than 2 points, more than
+ *                SEN_LUT_SIZE, not monotonic or bad scale)
+ */
+int sen_lut_init (sen_lut_t *lut, const lut_t *F, const float *T, float scale)
+{
+   float sign, step;
+   int i, n;
+
+   lut->n = 0;
+   for (n=0 ; T[n] != INT_MAX ; ++n)
+      ;
+   if (n < 2 || n > SEN_LUT_SIZE || !(scale > 0))
+      return 0;
 
+   sign = (F[1] > F[0]) ? 1 : -1;
+   for (i=0 ; i<n ; ++i) {
+      lut->f[i] = sign * F[i];
+      lut->t[i] = T[i];
+      if (i && !(lut->f[i] > lut->f[i-1]))
+         return 0;
+   }
+   for (i=0 ; i<n-1 ; ++i)
+      lut->k[i] = (lut->t[i+1] - lut->t[i]) / (lut->f[i+1] - lut->f[i]);
+   // The last point gets the last slope, so v == max needs no clamp
+   lut->k[n-1] = lut->k[n-2];
+   for (i=n ; i<SEN_LUT_SIZE ; ++i) {
+      lut->f[i] = FLT_MAX;
+      lut->t[i] = lut->t[n-1];
+      lut->k[i] = 0;
+   }
+   for (lut->size=1 ; lut->size < n ; lut->size <<= 1)
+      ;
+
+   // Even spacing check
+   step = (lut->f[n-1] - lut->f[0]) / (n-1);
+   lut->inv = 1 / step;
+   for (i=1 ; i<n ; ++i)
+      if (fabsf (lut->f[i] - lut->f[i-1] - step) > 1e-4f * step) {
+         lut->inv = 0;
+         break;
+      }
 
+   lut->gain = sign * scale;
+   lut->fit = SEN_FIT_NONE;
+   return lut->n = n;
+}
 
+/*!
+ * \brief
+ *    Replace the table interpolation of a compiled LUT with a least
+ *    squares fit over the table points. The input range is still the
+ *    table's.
+ *
+ * \param  lut    Pointer to the compiled LUT
+ * \param  fit    The fit
+ *    \arg SEN_FIT_NONE    Back to the table interpolation
+ *    \arg SEN_FIT_CUBIC   t = c0 + c1.x + c2.x^2 + c3.x^3
+ *    \arg SEN_FIT_SH      1/(t + 273.15) = c0 + c1.ln(x) + c2.ln(x)^3, x > 0
+ * \return        The maximum fit error at the table points, or -1 when the
+ *                fit is not possible. On error the LUT keeps its method.
+ */
+float sen_lut_fit (sen_lut_t *lut, sen_fit_en fit)
+{
+   double A[4][5] = {{0}}, c[4], b[4], x, lo, hi;
+   float  scale, err, e;
+   int i, j, k, m;
+
+   if (!lut->n)
+      return -1;
+   if (fit == SEN_FIT_NONE) {
+      lut->fit = fit;
+      return 0;
+   }
+   scale = fabsf (lut->gain);
+   lo = lut->f[0] * (lut->gain / scale);
+   hi = lut->f[lut->n-1] * (lut->gain / scale);
+   if (fit == SEN_FIT_SH && (lo <= 0 || hi <= 0))
+      return -1;
+
+   // Normal equations
+   m = (fit == SEN_FIT_SH) ? 3 : 4;
+   lut->xc = (float)((lo + hi) / 2);
+   lut->xs = (float)(2 / fabs (hi - lo));
+   for (i=0 ; i<lut->n ; ++i) {
+      x = lut->f[i] * (lut->gain / scale);
+      if (fit == SEN_FIT_SH) {
+         x = log (x);
+         b[0] = 1; b[1] = x; b[2] = x*x*x;
+         b[3] = 1 / (lut->t[i] + _SEN_KELVIN);
+      }
+      else {
+         x = (x - lut->xc) * lut->xs;
+         b[0] = 1; b[1] = x; b[2] = x*x; b[3] = x*x*x;
+      }
+      for (j=0 ; j<m ; ++j) {
+         for (k=0 ; k<m ; ++k)
+            A[j][k] += b[j] * b[k];
+         A[j][m] += b[j] * ((fit == SEN_FIT_SH) ? b[3] : lut->t[i]);
+      }
+   }
+   if (!_solve (m, A, c))
+      return -1;
+
+   lut->fit = fit;
+   for (j=0 ; j<m ; ++j)
+      lut->c[j] = (float)c[j];
+   for (err=0, i=0 ; i<lut->n ; ++i) {
+      e = fabsf (_fitval (lut, lut->f[i] * (lut->gain / scale)) - lut->t[i]);
+      if (e > err)
+         err = e;
+   }
+   return err;
+}
+
+/*!
+ * \brief
+ *    Convert a measured value with a compiled LUT
+ *
+ * \param  lut   Pointer to the compiled LUT
+ * \param  v     The measured value
+ * \return       The converted sensor value, TEMP_ERROR out of the table range,
+ *               or when the LUT is not compiled
+ */
+float sen_convert (const sen_lut_t *lut, float v)
+{
+   float u = v * lut->gain;
+   int   i, s;
+
+   if (!lut->n)
+      return TEMP_ERROR;
+   if (!(u >= lut->f[0] && u <= lut->f[lut->n-1]))
+      return TEMP_ERROR;
+   if (lut->fit != SEN_FIT_NONE)
+      return _fitval (lut, v * fabsf (lut->gain));
+
+   if (lut->inv) {
+      i = (int)((u - lut->f[0]) * lut->inv);
+      if (i > lut->n-1)
+         i = lut->n-1;
+   }
+   else {
+      for (i=0, s=lut->size>>1 ; s ; s >>= 1)
+         i += (lut->f[i+s] <= u) ? s : 0;
+   }
+   return lut->t[i] + (u - lut->f[i]) * lut->k[i];
+}
+
+/*!
+ * \brief
+ *    Convert an array of measured values with a compiled LUT. The samples
+ *    run in blocks, a search step at a time for the whole block, so the
+ *    loops are vectorised (gathers on AVX2).
+ *
+ * \param  lut   Pointer to the compiled LUT
+ * \param  v     The measured values
+ * \param  t     The converted values, TEMP_ERROR out of the table range
+ *               or when the LUT is not compiled.
+ *               It can be the same as \a v
+ * \param  n     The number of values
+ */
+__SIMD__ __O3__
+void sen_convert_n (const sen_lut_t *lut, const float *v, float *t, int n)
+{
+   const float *f = lut->f, *tt = lut->t, *k = lut->k;
+   float u[_SEN_BLOCK], lo, hi;
+   float gain = lut->gain, inv = lut->inv, r;
+   int   idx[_SEN_BLOCK], i, j, b, s, last = lut->n-1;
+
+   if (!lut->n) {
+      for (i=0 ; i<n ; ++i)
+         t[i] = (float)TEMP_ERROR;
+      return;
+   }
+   lo = lut->f[0];
+   hi = lut->f[last];
+   if (lut->fit != SEN_FIT_NONE) {
+      for (i=0 ; i<n ; ++i)
+         t[i] = sen_convert (lut, v[i]);
+      return;
+   }
+   for (i=0 ; i<n ; i+=b) {
+      b = (n-i < _SEN_BLOCK) ? n-i : _SEN_BLOCK;
+      for (j=0 ; j<b ; ++j)
+         u[j] = v[i+j] * gain;
+      if (inv) {
+         for (j=0 ; j<b ; ++j) {
+            r = (u[j] - lo) * inv;
+            r = (r > 0) ? r : 0;
+            idx[j] = (int)r;
+            idx[j] = (idx[j] < last) ? idx[j] : last;
+         }
+      }
+      else {
+         for (j=0 ; j<b ; ++j)
+            idx[j] = 0;
+         for (s=lut->size>>1 ; s ; s >>= 1)
+            for (j=0 ; j<b ; ++j)
+               idx[j] += (f[idx[j]+s] <= u[j]) ? s : 0;
+      }
+      for (j=0 ; j<b ; ++j) {
+         r = tt[idx[j]] + (u[j] - f[idx[j]]) * k[idx[j]];
+         t[i+j] = (u[j] >= lo && u[j] <= hi) ? r : (float)TEMP_ERROR;
+      }
+   }
+}
@@ -28,6 +28,7 @@
 
 static see_page_en   _valid_page (see_t *see);
 static see_idx_t      _find_last (see_t *see, see_idx_t page);
+static void         _index_build (see_t *see);
 static see_status_en _erase_page (see_t *see, see_idx_t page);
 static see_status_en  _page_swap (see_t *see);
 static see_status_en     _format (see_t *see);
@@ -36,6 +37,7 @@ static see_status_en  _try_write (see_t *see, see_idx_t page, see_idx_t idx, byt
 
 static see_status_en  _read_word (see_t *see, see_idx_t idx, byte_t *buf);
 static see_status_en _write_word (see_t *see, see_idx_t idx, byte_t *buf);
+static drv_status_en       _init (see_t *see);
 
 /*!
  * \brief
@@ -67,74 +69,107 @@ static see_page_en _valid_page (see_t *see)
 static see_idx_t _find_last (see_t *see, see_idx_t page)
 {
    byte_t      bf[SEE_FIND_LAST_BUFFER_SIZE];
-   see_idx_t   fp;
-   uint32_t    i, pairs, bts;
-   uint32_t    bfp, bfp_next;
+   see_idx_t   fp, end;
+   uint32_t    i, pairs, rec;
    see_idx_t   *last;
-   uint8_t     seek = 0;
    static see_idx_t
                page_cur = (see_idx_t)-1,
                page_pr  = (see_idx_t)-1;
 
-   // Job filter
-   if (page_cur == (see_idx_t)-1) {
-      // First time
+   /*
+    * Job filter
+    * An unknown last, (see_idx_t)-1, is set by see_init() and by the page
+    * swap for the page it erases. In that case we seek again.
+    */
+   if (page_cur == (see_idx_t)-1 || page == page_cur) {
+      // First time or repeat during current read/write
       page_cur = page;
-      seek = 1;
       last = (see_idx_t*)&see->last_cur;
    }
-   else if (page == page_cur) {
-      // Repeat during current read/write
-      seek = 0;
-      last = (see_idx_t*)&see->last_cur;
+   else if (page == page_pr && see->last_pr != (see_idx_t)-1) {
+      // Repeat for "from page" during page swap
+      last = (see_idx_t*)&see->last_pr;
    }
    else {
-      // Not current
-      if (page == page_pr) {
-         // Repeat for "from page" during page swap
-         seek = 0;
-         last = (see_idx_t*)&see->last_pr;
-      }
-      else {
-         // New current page during page swap (seek new page)
-         page_pr = page_cur;
-         page_cur = page;
-         seek = 1;
-         see->last_pr = see->last_cur;
-         last = (see_idx_t*)&see->last_cur;
-      }
+      // New current page during page swap (seek new page)
+      page_pr = page_cur;
+      page_cur = page;
+      see->last_pr = see->last_cur;
+      see->last_cur = (see_idx_t)-1;
+      last = (see_idx_t*)&see->last_cur;
    }
-   if (!seek)
+   if (*last != (see_idx_t)-1)
       return *last;
-   else {
-      // Calculate counters
-      pairs = SEE_FIND_LAST_BUFFER_SIZE / (see->iface.word_size + sizeof (see_idx_t));
-      bts = pairs * (see->iface.word_size + sizeof (see_idx_t));
-      fp = sizeof (see_page_status_en)+page;
-
-      // Loop entire flash page
-      for ( ; fp < page+see->conf.page_size - bts ; fp += (bfp - see->iface.word_size)) {
-         // Load buffer
-         if ( see->io.fl_read (see->io.flash, fp, (void*)bf, bts) != DRV_READY)
-            return *last = 0;
-         // Seek into buffer
-         bfp=0;
-         bfp_next = see->iface.word_size;
-         // One action outside
-         if ( *(see_idx_t*)(bf+bfp_next) == (see_idx_t)-1 )
-            return *last = (see_idx_t)(fp-sizeof (see_idx_t));
-         bfp = bfp_next;
-         bfp_next += see->iface.word_size + sizeof (see_idx_t);
-         // Loop the rest
-         for (i=1 ; i<pairs ; ++i) {
-            if ( *(see_idx_t*)(bf+bfp_next) == (see_idx_t)-1 )
-               return *last = (see_idx_t)(fp+bfp);
-            bfp = bfp_next;
-            bfp_next += see->iface.word_size + sizeof (see_idx_t);
-         }
+
+   // Calculate counters
+   rec = see->iface.word_size + sizeof (see_idx_t);
+   pairs = SEE_FIND_LAST_BUFFER_SIZE / rec;
+   fp = sizeof (see_page_status_en)+page;
+   end = page + see->conf.page_size;
+
+   // Loop entire flash page, the last buffer may hold fewer pairs
+   for ( ; fp + rec <= end ; fp += pairs*rec) {
+      if (fp + pairs*rec > end)
+         pairs = (end - fp) / rec;
+      // Load buffer
+      if ( see->io.fl_read (see->io.flash, fp, (void*)bf, pairs*rec) != DRV_READY)
+         return *last = 0;
+      // Seek into buffer. The last is the index of the pair before the empty one
+      for (i=0 ; i<pairs ; ++i) {
+         if ( *(see_idx_t*)(bf + i*rec + see->iface.word_size) == (see_idx_t)-1 )
+            return *last = (see_idx_t)(fp + i*rec - sizeof (see_idx_t));
+      }
+   }
+   // Full page
+   return *last = (see_idx_t)(fp - sizeof (see_idx_t));
+}
+
+/*!
+ * \brief
+ *    Rebuild the RAM index from the valid page in one sequential scan.
+ *    The records are visited from the oldest to the newest, so the
+ *    last record of each word overwrites the previous ones.
+ *    If the index is not linked, or it is too small, or the flash read
+ *    fails, the index is disabled and the reads fall back to page search.
+ *
+ * \param  see    The active see struct.
+ */
+static void _index_build (see_t *see)
+{
+   byte_t      bf[SEE_FIND_LAST_BUFFER_SIZE];
+   see_idx_t   page, fp, end, i;
+   uint32_t    words, rec, pairs, p;
+
+   see->index_en = 0;
+   words = see->iface.size / see->iface.word_size;
+   if (!see->index || see->index_size < words)
+      return;
+
+   if ( _valid_page (see) == EE_PAGE0 )   page = see->conf.page0_add;
+   else                                   page = see->conf.page1_add;
+
+   memset ((void*)see->index, 0, words * sizeof (see_idx_t));
+   rec = see->iface.word_size + sizeof (see_idx_t);
+   pairs = SEE_FIND_LAST_BUFFER_SIZE / rec;
+   fp = page + sizeof (see_page_status_en);
+   end = page + see->conf.page_size;
+
+   // Loop entire flash page, one buffer of records at a time
+   while (fp + rec <= end) {
+      if (fp + pairs*rec > end)
+         pairs = (end - fp) / rec;
+      if ( see->io.fl_read (see->io.flash, fp, (void*)bf, pairs*rec) != DRV_READY)
+         return;
+      for (p=0 ; p<pairs ; ++p, fp += rec) {
+         memcpy ((void*)&i, (const void*)&bf[p*rec + see->iface.word_size], sizeof (see_idx_t));
+         if (i == (see_idx_t)-1)
+            goto _index_done;    // Empty space, end of records
+         if (i % see->iface.word_size == 0 && i / see->iface.word_size < words)
+            see->index[i / see->iface.word_size] = fp + see->iface.word_size;
       }
-      return *last = 0;
    }
+_index_done:
+   see->index_en = 1;
 }
 
 /*!
@@ -173,7 +208,7 @@ static see_status_en _page_swap (see_t *see)
 {
    see_idx_t     from, to;
    see_page_status_en status;
-   byte_t        data;
+   byte_t        data[SEE_MAX_WORD_SIZE];
    see_idx_t     idx;
    see_status_en ee_st = EE_SUCCESS;
  
@@ -186,6 +221,9 @@ static see_status_en _page_swap (see_t *see)
       to   = see->conf.page0_add;
    }
 
+   // The last record of the page we erase is no longer valid
+   see->last_pr = (see_idx_t)-1;
+
    // Mark the new Page as RECEIVEDATA
    if ( _erase_page (see, to) != EE_SUCCESS )
       return EE_FLASHERROR;
@@ -195,9 +233,9 @@ static see_status_en _page_swap (see_t *see)
 
    // Copy each word written on "from" page to their new home
    for (idx=0 ; idx<see->iface.size ; idx+=see->iface.word_size) {
-      ee_st = _try_read (see, from, idx, &data);
+      ee_st = _try_read (see, from, idx, data);
       if (ee_st == EE_SUCCESS) {
-         ee_st = _try_write (see, to, idx, &data);
+         ee_st = _try_write (see, to, idx, data);
          if (ee_st != EE_SUCCESS)
             break;
       } else if (ee_st == EE_NODATA)
@@ -288,21 +326,34 @@ static see_status_en _try_read (see_t *see, see_idx_t page, see_idx_t idx, byte_
    see_idx_t fp;        // Actual flash pointer
    see_idx_t i;         // Read index from flash
 
-   /*
-    * Seek for the first data and jump from data to data after that
-    * Until we find the idx.
-    * Do not search Page base address (fp>page)
-    */
-   fp = _find_last (see, page);
-   while ( fp > page ) {
-      // Read index data
-      if ( see->io.fl_read (see->io.flash, fp, (void *)&i, sizeof (see_idx_t)) != DRV_READY) {
-         // Error, no data
-         return EE_FLASHERROR;
+   if (see->index_en) {
+      /*
+       * The index holds the last record of each word in current page.
+       * Words with no data have 0, so we send them to page base address.
+       */
+      fp = 0;
+      if (idx % see->iface.word_size == 0 && idx < see->iface.size)
+         fp = see->index[idx / see->iface.word_size];
+      if (!fp)
+         fp = page;
+   }
+   else {
+      /*
+       * Seek for the first data and jump from data to data after that
+       * Until we find the idx.
+       * Do not search Page base address (fp>page)
+       */
+      fp = _find_last (see, page);
+      while ( fp > page ) {
+         // Read index data
+         if ( see->io.fl_read (see->io.flash, fp, (void *)&i, sizeof (see_idx_t)) != DRV_READY) {
+            // Error, no data
+            return EE_FLASHERROR;
+         }
+         if (i == idx)  //first match
+            break;
+         fp -= (sizeof(see_idx_t) + see->iface.word_size);
       }
-      if (i == idx)  //first match
-         break;
-      fp -= (sizeof(see_idx_t) + see->iface.word_size);
    }
    // Check if we got something
    if (fp > page) {
@@ -359,6 +410,13 @@ static see_status_en _try_write (see_t *see, see_idx_t page, see_idx_t idx, byte
    if ( see->io.fl_write (see->io.flash, fp, (void*)&idx, sizeof(see_idx_t)) != DRV_READY )
       ee_st = EE_FLASHERROR;
    see->last_cur = fp;  // We only write in current page
+   if (see->index_en) {
+      // The new record is the last for idx. On failure let the reads search the page
+      if (ee_st == EE_SUCCESS && idx < see->iface.size)
+         see->index[idx / see->iface.word_size] = fp;
+      else
+         see->index_en = 0;
+   }
    return ee_st;
 }
 
@@ -412,7 +470,13 @@ static see_status_en _write_word (see_t *see, see_idx_t idx, byte_t *word)
     * If both pages are full, then the EEPROM is full
     */
    if ( (ee_st = _try_write (see, page, idx, word)) == EE_PAGEFULL) {
-      if (_page_swap (see) == EE_FLASHERROR)
+      /*
+       * The index follows the copied words during the swap. If the
+       * swap does not complete, rebuild it from the valid page.
+       */
+      if ((ee_st = _page_swap (see)) != EE_SUCCESS)
+         _index_build (see);
+      if (ee_st == EE_FLASHERROR)
          return EE_FLASHERROR;
       if (page == see->conf.page0_add)
          page = see->conf.page1_add;
@@ -487,6 +551,25 @@ inline void see_link_flash_ioctl (see_t *see, fl_ioctl_ft f) {
    see->io.fl_ioctl = f;
 }
 
+/*!
+ * \brief
+ *    Link a RAM buffer for the see index. The index keeps the flash address
+ *    of each word's last record, so the reads do not search the page.
+ *    It needs SEE_INDEX_ENTRIES(page_size, word_size) entries and it is
+ *    built in see_init(). Without it, or if it is too small, the reads
+ *    search the page.
+ *
+ * \param  see      The active see struct.
+ * \param  index    Pointer to index buffer, or NULL to unlink
+ * \param  entries  The number of see_idx_t entries in buffer
+ * \return none
+ */
+void see_link_index (see_t *see, see_idx_t *index, uint32_t entries) {
+   see->index = index;
+   see->index_size = (index) ? entries : 0;
+   see->index_en = 0;
+}
+
 /*
  * Set functions
  */
@@ -599,7 +682,7 @@ void see_deinit (see_t *see)
  *    \arg DRV_READY
  *    \arg DRV_ERROR
  */
-drv_status_en see_init (see_t *see)
+static drv_status_en _init (see_t *see)
 {
    drv_status_en        drv_st;
    see_status_en        ee_st = EE_SUCCESS;
@@ -610,8 +693,14 @@ drv_status_en see_init (see_t *see)
    if (!see->io.fl_read)   return see->status = DRV_ERROR;
    if (!see->io.fl_write)  return see->status = DRV_ERROR;
 
-   see->iface.size = (see->conf.page_size / (see->iface.word_size + sizeof(see_idx_t))) * see->iface.word_size;
+   /*
+    * The records of all the words have to fit in a page after the status,
+    * with one free record for the next write after a page swap.
+    */
+   see->iface.size = ((see->conf.page_size - sizeof (see_page_status_en))
+                     / (see->iface.word_size + sizeof(see_idx_t)) - 1) * see->iface.word_size;
    see->last_cur = see->last_pr = (see_idx_t)-1;
+   see->index_en = 0;   // Search the pages until the index is build
 
    /*!
     * \note
@@ -668,7 +757,23 @@ drv_status_en see_init (see_t *see)
 
    if (ee_st == EE_SUCCESS)   return see->status = DRV_READY;
    else                       return see->status = DRV_ERROR;
-}                                      
+}
+/*!
+ * \brief
+ *    Initialise the see. Restore the pages if needed and build
+ *    the RAM index, if one is linked.
+ * \param   see   The active see struct.
+ * \return The status
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en see_init (see_t *see)
+{
+   if (_init (see) == DRV_READY)
+      _index_build (see);
+   return see->status;
+}
+                                      
 
 
 
@@ -800,7 +905,7 @@ drv_status_en see_write (see_t *see, see_idx_t idx, byte_t *buf, bytecount_t siz
 
    // Write aligned data
    for (i=0 ; i<words ; ++i) {
-      if ( _write_word (see, idx, buf) == EE_FLASHERROR ) {
+      if ( _write_word (see, idx, buf) != EE_SUCCESS ) {
          see->status = DRV_READY;
          return DRV_ERROR;
       }
@@ -812,7 +917,7 @@ drv_status_en see_write (see_t *see, see_idx_t idx, byte_t *buf, bytecount_t siz
       memset ((void *)bf, 0, SEE_MAX_WORD_SIZE);
       memcpy ((void *)bf, (const void *)buf, rem);
       // Write last data
-      if ( _write_word (see, idx, bf) == EE_FLASHERROR ) {
+      if ( _write_word (see, idx, bf) != EE_SUCCESS ) {
          see->status = DRV_READY;
          return DRV_ERROR;
       }
@@ -866,8 +971,12 @@ drv_status_en see_ioctl (see_t *see, ioctl_cmd_t cmd, ioctl_buf_t buf)
          see->io.fl_ioctl (see->io.flash, cmd, buf);
          return see->status = DRV_READY;
       case CTRL_FORMAT:          /*!< Format flash */
-         if (_format(see) == EE_FLASHERROR ) return see->status = DRV_ERROR;
-         else                                return see->status = DRV_READY;
+         if (_format(see) == EE_FLASHERROR ) {
+            _index_build (see);
+            return see->status = DRV_ERROR;
+         }
+         _index_build (see);
+         return see->status = DRV_READY;
       default:                   /*!< Unsupported command, error */
          return DRV_ERROR;
 
@@ -0,0 +1,304 @@
+/*!
+ * \file sim_i2c_ee.c
+ * \brief
+ *    A RAM backed 24xx I2C EEPROM simulator. It has the i2c_tx/i2c_rx/
+ *    i2c_ioctl interface of the I2C drivers, so it can be linked to the
+ *    ee_i2c driver. It models the control byte, the address bytes, the
+ *    page write roll over, the write cycle that does not acknowledge the
+ *    control byte and the sequential read, and it counts the bus
+ *    transactions and the bus time so EEPROM users can be measured.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <drv/sim_i2c_ee.h>
+
+static void _spend (sie_t *sie, uint32_t t);
+static uint64_t _now (sie_t *sie);
+static void _stop (sie_t *sie);
+
+/*!
+ * \brief
+ *    Count bus time, to the statistics and to the shared clock
+ */
+static void _spend (sie_t *sie, uint32_t t)
+{
+   sie->stat.time += t;
+   if (sie->clock)
+      *sie->clock += t;
+}
+
+/*!
+ * \brief
+ *    The simulation time, the shared clock or the bus time
+ */
+static uint64_t _now (sie_t *sie) {
+   return (sie->clock) ? *sie->clock : sie->stat.time;
+}
+
+/*!
+ * \brief
+ *    Stop condition. A write transaction with data starts the
+ *    write cycle.
+ */
+static void _stop (sie_t *sie)
+{
+   _spend (sie, sie->t.cond);
+   if (sie->state == SIE_ST_WRITE && sie->wcnt) {
+      sie->busy = _now (sie) + sie->t.wr;
+      ++sie->stat.page_writes;
+   }
+   sie->state = SIE_ST_IDLE;
+}
+
+
+/*
+ *  ============= PUBLIC SIM I2C EE API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+
+/*!
+ * \brief
+ *    Link the RAM image of the EEPROM
+ *
+ * \param  sie    Pointer to simulator
+ * \param  mem    Pointer to RAM buffer
+ * \param  size   The buffer size, it is the EEPROM size
+ */
+void sie_link_mem (sie_t *sie, byte_t *mem, uint32_t size) {
+   sie->mem = mem;
+   sie->size = size;
+}
+
+/*!
+ * \brief
+ *    Link a simulation clock in nsec, shared with other simulators.
+ *    The bus time moves the clock and the write cycle runs on it, so
+ *    the devices of a system work in parallel. Optional
+ */
+void sie_link_clock (sie_t *sie, uint64_t *clock) {
+   sie->clock = clock;
+}
+
+/*
+ * Set functions
+ */
+
+/*!
+ * \brief
+ *    Set the control byte of the EEPROM without the R/W bit,
+ *    the control code and the chip select bits.
+ */
+void sie_set_hwaddress (sie_t *sie, byte_t add) {
+   sie->hw_addr = add & 0xFE;
+}
+/*!
+ * \brief
+ *    Set the EEPROM page size
+ */
+void sie_set_page_size (sie_t *sie, uint32_t size) {
+   sie->page_sz = size;
+}
+/*!
+ * \brief
+ *    Set the timing model, all in nsec
+ *
+ * \param  sie    Pointer to simulator
+ * \param  byte   Byte transfer with the ack clock
+ * \param  cond   Start or stop condition
+ * \param  wr     Write cycle
+ */
+void sie_set_timing (sie_t *sie, uint32_t byte, uint32_t cond, uint32_t wr) {
+   sie->t.byte = byte;
+   sie->t.cond = cond;
+   sie->t.wr = wr;
+}
+
+/*
+ * User Functions
+ */
+
+/*!
+ * \brief
+ *    De-Initialize the simulator
+ */
+void sie_deinit (sie_t *sie)
+{
+   memset ((void*)sie, 0, sizeof (sie_t));
+   /*!<
+    * This leaves the status = DRV_NOINIT
+    */
+}
+
+/*!
+ * \brief
+ *    Initialize the simulator. The missing settings get the defaults
+ *    and the statistics are cleared. The EEPROM content is not touched.
+ *
+ * \param  sie    Pointer to simulator
+ * \return The status of the init operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en sie_init (sie_t *sie)
+{
+   if (!sie->mem || !sie->size)
+      return sie->status = DRV_ERROR;
+
+   if (!sie->hw_addr)   sie->hw_addr = SIE_HWADDR_DEF;
+   if (!sie->page_sz)   sie->page_sz = SIE_PAGE_SZ_DEF;
+   if (!sie->t.byte && !sie->t.cond && !sie->t.wr)
+      sie_set_timing (sie, SIE_T_BYTE_DEF, SIE_T_COND_DEF, SIE_T_WR_DEF);
+   sie->addr_sz = (sie->size > 256) ? 2:1;
+   sie->state = SIE_ST_IDLE;
+   sie->ptr = sie->wcnt = 0;
+   sie->busy = 0;
+   memset ((void*)&sie->stat, 0, sizeof (sie_stat_t));
+
+   return sie->status = DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Receive a byte from the EEPROM, the sequential read. The address
+ *    counter rolls over at the end of the memory.
+ *
+ * \param  sie    Pointer to simulator
+ * \param  ack    The master's ack, 0 (NACK) ends the read
+ * \param  seq    Not used, always a byte with ack
+ * \return        The byte
+ */
+byte_t sie_i2c_rx (sie_t *sie, uint8_t ack, int seq)
+{
+   byte_t b = 0xFF;  // Released bus
+
+   (void)seq;
+   _spend (sie, sie->t.byte);
+   if (sie->state != SIE_ST_READ)
+      return b;
+   b = sie->mem[sie->ptr];
+   sie->ptr = (sie->ptr + 1) % sie->size;
+   ++sie->stat.read_bytes;
+   if (!ack)
+      sie->state = SIE_ST_IDLE;
+   return b;
+}
+
+/*!
+ * \brief
+ *    Transmit a byte to the EEPROM. During the write cycle the control
+ *    byte is not acknowledged. The data of a page write roll over at the
+ *    end of the page.
+ *
+ * \param  sie    Pointer to simulator
+ * \param  byte   The byte
+ * \param  seq    Not used, always a byte with ack
+ * \return        The EEPROM's ack, 1 for ACK, 0 for NACK
+ */
+int sie_i2c_tx (sie_t *sie, byte_t byte, int seq)
+{
+   uint32_t pg;
+
+   (void)seq;
+   _spend (sie, sie->t.byte);
+   switch (sie->state) {
+      case SIE_ST_CONTROL:
+         if ((byte & 0xFE) != sie->hw_addr) {
+            sie->state = SIE_ST_IDLE;
+            return 0;
+         }
+         if (_now (sie) < sie->busy) {
+            ++sie->stat.polls;
+            sie->state = SIE_ST_IDLE;
+            return 0;
+         }
+         if (byte & 0x01)
+            sie->state = SIE_ST_READ;
+         else {
+            sie->state = SIE_ST_ADDRESS;
+            sie->acnt = 0;
+         }
+         return 1;
+      case SIE_ST_ADDRESS:
+         sie->ptr = (sie->acnt) ? (sie->ptr << 8) | byte : byte;
+         if (++sie->acnt >= sie->addr_sz) {
+            sie->ptr %= sie->size;
+            sie->state = SIE_ST_WRITE;
+            sie->wcnt = 0;
+         }
+         return 1;
+      case SIE_ST_WRITE:
+         sie->mem[sie->ptr] = byte;
+         pg = sie->ptr - sie->ptr % sie->page_sz;
+         sie->ptr = pg + (sie->ptr - pg + 1) % sie->page_sz;
+         ++sie->wcnt;
+         ++sie->stat.write_bytes;
+         return 1;
+      default:
+         return 0;
+   }
+}
+
+/*!
+ * \brief
+ *    Simulator bus control function
+ *
+ * \param  sie    Pointer to simulator
+ * \param  cmd    specifies the command
+ *    \arg CTRL_GET_STATUS       Get simulator's status
+ *    \arg CTRL_DEINIT           De-Initialise the simulator
+ *    \arg CTRL_INIT             Initialise the simulator
+ *    \arg CTRL_START            Start or repeated start condition
+ *    \arg CTRL_STOP             Stop condition
+ * \param  buf    pointer to buffer for ioctl
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en sie_i2c_ioctl (sie_t *sie, ioctl_cmd_t cmd, ioctl_buf_t buf)
+{
+   switch (cmd)
+   {
+      case CTRL_GET_STATUS:
+         if (buf)
+            *(drv_status_en*)buf = sie->status;
+         return DRV_READY;
+      case CTRL_DEINIT:
+         sie_deinit (sie);
+         return DRV_READY;
+      case CTRL_INIT:
+         if (buf)
+            *(drv_status_en*)buf = sie_init (sie);
+         else
+            sie_init (sie);
+         return DRV_READY;
+      case CTRL_START:
+         _spend (sie, sie->t.cond);
+         ++sie->stat.transactions;
+         sie->state = SIE_ST_CONTROL;
+         return DRV_READY;
+      case CTRL_STOP:
+         _stop (sie);
+         return DRV_READY;
+      default:
+         return DRV_ERROR;
+   }
+}
@@ -0,0 +1,483 @@
+/*!
+ * \file sim_nor.c
+ * \brief
+ *    A RAM backed NOR flash simulator. It has the page program and
+ *    sector erase semantics of a NOR flash and a timing model of the
+ *    SPI transfers, the page programs and the erases, so flash users
+ *    can be measured on the host or on the target. The SPI interface
+ *    links to the S25FS driver, with the busy status of the programs
+ *    and the erases.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <drv/sim_nor.h>
+
+static int _range (snor_t *snor, uint32_t idx, int count);
+static int _writepage (snor_t *snor, uint32_t idx, byte_t *buf, int n);
+static void _spend (snor_t *snor, uint64_t t);
+static uint64_t _now (snor_t *snor);
+
+/*!
+ * \brief
+ *    Count busy time, to the statistics and to the shared clock
+ */
+static void _spend (snor_t *snor, uint64_t t)
+{
+   snor->stat.time += t;
+   if (snor->clock)
+      *snor->clock += t;
+}
+
+/*!
+ * \brief
+ *    The simulation time, the shared clock or the busy time
+ */
+static uint64_t _now (snor_t *snor) {
+   return (snor->clock) ? *snor->clock : snor->stat.time;
+}
+
+/*!
+ * \brief
+ *    Check if [idx, idx+count) is inside the flash
+ * \return  1 inside, 0 outside
+ */
+static int _range (snor_t *snor, uint32_t idx, int count)
+{
+   return (count >= 0 && idx <= snor->size && (uint32_t)count <= snor->size - idx) ? 1:0;
+}
+
+/*!
+ * \brief
+ *    Page program. The bits can only go from 1 to 0 and the
+ *    program stops at the end of the page.
+ *
+ * \param  snor  Pointer to simulator
+ * \param  idx   The starting address
+ * \param  buf   Pointer to data to write
+ * \param    n   The number of bytes to write
+ * \return       The number of written bytes
+ */
+static int _writepage (snor_t *snor, uint32_t idx, byte_t *buf, int n)
+{
+   int nl = snor->page_sz - idx % snor->page_sz;
+   byte_t *m = &snor->mem[idx];
+   int i;
+
+   if (nl > n)  nl = n;
+   for (i=0 ; i<nl ; ++i) {
+      if (buf[i] & ~m[i])
+         ++snor->stat.violations;
+      m[i] &= buf[i];
+   }
+   ++snor->stat.programs;
+   snor->stat.prog_bytes += nl;
+   _spend (snor, snor->t.cmd + (uint64_t)nl*snor->t.byte + snor->t.pp);
+   return nl;
+}
+
+
+/*
+ *  ============= PUBLIC SIM NOR API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+
+/*!
+ * \brief
+ *    Link the RAM image of the flash
+ *
+ * \param  snor   Pointer to simulator
+ * \param  mem    Pointer to RAM buffer
+ * \param  size   The buffer size, it is the flash size
+ */
+void snor_link_mem (snor_t *snor, byte_t *mem, uint32_t size) {
+   snor->mem = mem;
+   snor->size = size;
+}
+/*!
+ * \brief
+ *    Link a buffer for the erase counters, one per sector. Optional
+ */
+void snor_link_erase_cnt (snor_t *snor, uint32_t *cnt) {
+   snor->erase_cnt = cnt;
+}
+
+/*!
+ * \brief
+ *    Link a simulation clock in nsec, shared with other simulators.
+ *    The SPI transfers move the clock and the programs and erases of the
+ *    SPI interface run on it, so the devices of a system work in
+ *    parallel. Optional
+ */
+void snor_link_clock (snor_t *snor, uint64_t *clock) {
+   snor->clock = clock;
+}
+
+/*
+ * Set functions
+ */
+
+/*!
+ * \brief
+ *    Set flash program page size
+ */
+void snor_set_page_sz (snor_t *snor, uint32_t size) {
+   snor->page_sz = size;
+}
+/*!
+ * \brief
+ *    Set flash erase sector size
+ */
+void snor_set_sector_sz (snor_t *snor, uint32_t size) {
+   snor->sector_sz = size;
+}
+/*!
+ * \brief
+ *    Set the timing model, all in nsec
+ *
+ * \param  snor   Pointer to simulator
+ * \param  cmd    Command, address and CS overhead
+ * \param  byte   Transfer of one byte
+ * \param  pp     Page program
+ * \param  se     Sector erase
+ */
+void snor_set_timing (snor_t *snor, uint32_t cmd, uint32_t byte, uint32_t pp, uint32_t se) {
+   snor->t.cmd = cmd;
+   snor->t.byte = byte;
+   snor->t.pp = pp;
+   snor->t.se = se;
+}
+
+/*
+ * User Functions
+ */
+
+/*!
+ * \brief
+ *    De-Initialize the simulator
+ */
+void snor_deinit (snor_t *snor)
+{
+   memset ((void*)snor, 0, sizeof (snor_t));
+   /*!<
+    * This leaves the status = DRV_NOINIT
+    */
+}
+
+/*!
+ * \brief
+ *    Initialize the simulator. The missing settings get the defaults
+ *    and the statistics are cleared. The flash content is not touched.
+ *
+ * \param  snor   Pointer to simulator
+ * \return The status of the init operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en snor_init (snor_t *snor)
+{
+   if (!snor->mem || !snor->size)
+      return snor->status = DRV_ERROR;
+
+   if (!snor->page_sz)     snor->page_sz = SNOR_PAGE_SZ_DEF;
+   if (!snor->sector_sz)   snor->sector_sz = SNOR_SECTOR_SZ_DEF;
+   if (!snor->t.cmd && !snor->t.byte && !snor->t.pp && !snor->t.se)
+      snor_set_timing (snor, SNOR_T_CMD_DEF, SNOR_T_BYTE_DEF, SNOR_T_PP_DEF, SNOR_T_SE_DEF);
+   snor->state = SNOR_ST_IDLE;
+   snor->wel = 0;
+   snor->busy = 0;
+   memset ((void*)&snor->stat, 0, sizeof (snor_stat_t));
+
+   return snor->status = DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Erase the sector of address \a idx
+ *
+ * \param  snor   Pointer to simulator
+ * \param  idx    Address inside the sector
+ * \return The status of the erase operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en snor_erase (snor_t *snor, uint32_t idx)
+{
+   if (idx >= snor->size)
+      return DRV_ERROR;
+   idx -= idx % snor->sector_sz;
+   memset ((void*)&snor->mem[idx], 0xFF, snor->sector_sz);
+   if (snor->erase_cnt)
+      ++snor->erase_cnt[idx / snor->sector_sz];
+   ++snor->stat.erases;
+   _spend (snor, snor->t.cmd + snor->t.se);
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Read data from flash at address \a idx
+ *
+ * \param   snor  Pointer to simulator
+ * \param   idx   Flash address
+ * \param   buf   Buffer pointer to store the data from flash
+ * \param count   Number of bytes to read
+ * \return The status of the read operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en snor_read (snor_t *snor, uint32_t idx, byte_t *buf, int count)
+{
+   if (!_range (snor, idx, count))
+      return DRV_ERROR;
+   memcpy ((void*)buf, (const void*)&snor->mem[idx], count);
+   ++snor->stat.reads;
+   snor->stat.read_bytes += count;
+   _spend (snor, snor->t.cmd + (uint64_t)count*snor->t.byte);
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Write data to flash at address \a idx, one page program
+ *    for each page as s25fs_write() does.
+ *
+ * \param   snor  Pointer to simulator
+ * \param   idx   Flash address
+ * \param   buf   Buffer pointer with the data to write
+ * \param count   Number of bytes to write
+ * \return The status of the write operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en snor_write (snor_t *snor, uint32_t idx, byte_t *buf, int count)
+{
+   int wb;
+
+   if (!_range (snor, idx, count))
+      return DRV_ERROR;
+   for (wb=0 ; wb<count ; )
+      wb += _writepage (snor, idx+wb, &buf[wb], count-wb);
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Simulator ioctl function
+ *
+ * \param  snor   Pointer to simulator
+ * \param  ctrl   specifies the command
+ *    \arg CTRL_GET_STATUS       Get simulator's status
+ *    \arg CTRL_DEINIT           De-Initialise the simulator
+ *    \arg CTRL_INIT             Initialise the simulator
+ *    \arg CTRL_CMD_UNLOCK       Nothing, for compatibility
+ *    \arg CTRL_CMD_LOCK         Nothing, for compatibility
+ *    \arg CTRL_ERASE_PAGE       Sector erase, buf is a pointer to uint32_t address
+ *    \arg CTRL_ERASE_ALL        Erase all sectors
+ *    \arg CTRL_GET_SIZE         Get the flash size to uint32_t
+ *    \arg CTRL_GET_BLOCK_SIZE   Get the erase sector size to uint32_t
+ * \param  buf    pointer to buffer for ioctl
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en snor_ioctl (snor_t *snor, ioctl_cmd_t ctrl, ioctl_buf_t buf)
+{
+   uint32_t idx;
+
+   switch (ctrl)
+   {
+      case CTRL_GET_STATUS:
+         if (buf)
+            *(drv_status_en*)buf = snor->status;
+         return DRV_READY;
+      case CTRL_DEINIT:
+         snor_deinit (snor);
+         return DRV_READY;
+      case CTRL_INIT:
+         if (buf)
+            *(drv_status_en*)buf = snor_init (snor);
+         else
+            snor_init (snor);
+         return DRV_READY;
+      case CTRL_CMD_UNLOCK:
+      case CTRL_CMD_LOCK:
+         return DRV_READY;
+      case CTRL_ERASE_PAGE:
+         if (buf)
+            return snor_erase (snor, *(uint32_t*)buf);
+         else
+            return DRV_ERROR;
+      case CTRL_ERASE_ALL:
+         for (idx=0 ; idx<snor->size ; idx+=snor->sector_sz)
+            snor_erase (snor, idx);
+         return DRV_READY;
+      case CTRL_GET_SIZE:
+         if (buf)
+            *(uint32_t*)buf = snor->size;
+         return DRV_READY;
+      case CTRL_GET_BLOCK_SIZE:
+         if (buf)
+            *(uint32_t*)buf = snor->sector_sz;
+         return DRV_READY;
+      default:
+         return DRV_ERROR;
+   }
+}
+
+/*
+ * SPI interface
+ */
+
+/*!
+ * \brief
+ *    Chip select. The page program and the sector erase start on
+ *    deselect and keep the flash busy for their time. The flash ignores
+ *    them without a write enable or while it is busy.
+ *
+ * \param  snor   Pointer to simulator
+ * \param  en     1 to select, 0 to deselect
+ */
+void snor_spi_cs (snor_t *snor, uint8_t en)
+{
+   uint32_t idx;
+
+   if (en) {
+      _spend (snor, snor->t.cmd);
+      snor->state = SNOR_ST_CMD;
+      return;
+   }
+   if (snor->state == SNOR_ST_PROG && snor->wcnt) {
+      snor->busy = _now (snor) + snor->t.pp;
+      snor->wel = 0;
+      ++snor->stat.programs;
+   }
+   else if (snor->state == SNOR_ST_ERASE) {
+      idx = snor->ptr - snor->ptr % snor->sector_sz;
+      memset ((void*)&snor->mem[idx], 0xFF, snor->sector_sz);
+      if (snor->erase_cnt)
+         ++snor->erase_cnt[idx / snor->sector_sz];
+      snor->busy = _now (snor) + snor->t.se;
+      snor->wel = 0;
+      ++snor->stat.erases;
+   }
+   snor->state = SNOR_ST_IDLE;
+}
+
+/*!
+ * \brief
+ *    Receive bytes from the flash, the status register or the data
+ *    of a read command.
+ *
+ * \param  snor   Pointer to simulator
+ * \param  buf    Pointer to buffer for the data
+ * \param  n      The number of bytes
+ * \return DRV_READY
+ */
+drv_status_en snor_spi_read (snor_t *snor, byte_t *buf, int n)
+{
+   uint8_t wip = (_now (snor) < snor->busy) ? SNOR_SR_WIP : 0;
+
+   _spend (snor, (uint64_t)n*snor->t.byte);
+   for (int i=0 ; i<n ; ++i) {
+      switch (snor->state) {
+         case SNOR_ST_RDSR:
+            buf[i] = wip | ((snor->wel) ? SNOR_SR_WEL : 0);
+            break;
+         case SNOR_ST_READ:
+            buf[i] = snor->mem[snor->ptr];
+            snor->ptr = (snor->ptr + 1) % snor->size;
+            ++snor->stat.read_bytes;
+            break;
+         default:
+            buf[i] = 0xFF;    // Released bus
+            break;
+      }
+   }
+   if (snor->state == SNOR_ST_RDSR && wip)
+      ++snor->stat.polls;
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Transmit bytes to the flash, the command, the address and the
+ *    data of a page program. The program rolls over at the end of the page.
+ *
+ * \param  snor   Pointer to simulator
+ * \param  buf    Pointer to the data
+ * \param  n      The number of bytes
+ * \return DRV_READY
+ */
+drv_status_en snor_spi_write (snor_t *snor, byte_t *buf, int n)
+{
+   uint8_t  busy = (_now (snor) < snor->busy) ? 1:0;
+   uint32_t pg;
+
+   _spend (snor, (uint64_t)n*snor->t.byte);
+   for (int i=0 ; i<n ; ++i) {
+      switch (snor->state) {
+         case SNOR_ST_CMD:
+            snor->cmd = buf[i];
+            snor->state = SNOR_ST_IDLE;
+            switch (buf[i]) {
+               case SNOR_CMD_WREN:     if (!busy) snor->wel = 1;  break;
+               case SNOR_CMD_WRDI:     if (!busy) snor->wel = 0;  break;
+               case SNOR_CMD_RDSR:     snor->state = SNOR_ST_RDSR; break;
+               case SNOR_CMD_PP_4B:
+               case SNOR_CMD_READ_4B:
+               case SNOR_CMD_SE_4B:
+                  snor->state = SNOR_ST_ADDR;
+                  snor->acnt = 0;
+                  snor->ptr = 0;
+                  break;
+            }
+            break;
+         case SNOR_ST_ADDR:
+            snor->ptr = (snor->ptr << 8) | buf[i];
+            if (++snor->acnt < 4)
+               break;
+            snor->ptr %= snor->size;
+            snor->wcnt = 0;
+            if (snor->cmd == SNOR_CMD_READ_4B) {
+               snor->state = SNOR_ST_READ;
+               ++snor->stat.reads;
+            }
+            else if (busy || !snor->wel)
+               snor->state = SNOR_ST_IDLE;
+            else
+               snor->state = (snor->cmd == SNOR_CMD_PP_4B) ? SNOR_ST_PROG : SNOR_ST_ERASE;
+            break;
+         case SNOR_ST_PROG:
+            if (buf[i] & ~snor->mem[snor->ptr])
+               ++snor->stat.violations;
+            snor->mem[snor->ptr] &= buf[i];
+            pg = snor->ptr - snor->ptr % snor->page_sz;
+            snor->ptr = pg + (snor->ptr - pg + 1) % snor->page_sz;
+            ++snor->wcnt;
+            ++snor->stat.prog_bytes;
+            break;
+         default:
+            break;
+      }
+   }
+   return DRV_READY;
+}
@@ -0,0 +1,325 @@
+/*!
+ * \file sim_ow.c
+ * \brief
+ *    A multi-device 1-Wire bus simulator. It has the rw/rwbuf/br interface
+ *    of the UART 1-Wire driver and it decodes the UART frames to resets and
+ *    time slots at standard and overdrive speed. The devices answer to the
+ *    ROM commands, the search, the conditional search and the overdrive skip
+ *    and match. The bus time and the transfers are counted, so 1-Wire users
+ *    can be measured on the host or on the target.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2016 Choutouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <drv/sim_ow.h>
+
+#define  _rom_bit(_rom_, _bit_)  (((_rom_)[(_bit_)/8] >> ((_bit_)%8)) & 0x01)
+
+static uint8_t _reset (sow_t *sow, uint8_t speed);
+static uint8_t _romcmd (sow_t *sow);
+static uint8_t _slot (sow_t *sow, uint8_t speed, uint8_t b);
+static uint16_t _frame (sow_t *sow, uint8_t frame);
+
+/*!
+ * \brief
+ *    Reset pulse. A standard reset returns all the devices to standard
+ *    speed, an overdrive reset is seen only from the overdrive devices.
+ * \return  1 if there is a presence pulse
+ */
+static uint8_t _reset (sow_t *sow, uint8_t speed)
+{
+   uint8_t  pr = 0;
+   int i;
+
+   for (i=0 ; i<sow->n ; ++i) {
+      if (speed == OW_T_STANDARD)
+         sow->dev[i].speed = OW_T_STANDARD;
+      sow->dev[i].active = (sow->dev[i].speed == speed) ? 1:0;
+      pr |= sow->dev[i].active;
+   }
+   sow->state = (pr) ? SOW_ST_ROMCMD : SOW_ST_IDLE;
+   sow->cmd = 0;
+   sow->cnt = 0;
+   ++sow->stat.resets;
+   return pr;
+}
+
+/*!
+ * \brief
+ *    Dispatch a received ROM command
+ * \return  The next bus state
+ */
+static uint8_t _romcmd (sow_t *sow)
+{
+   int i;
+
+   sow->cnt = 0;
+   switch (sow->cmd) {
+      case OW_CMD_SEARCH_ALARM:
+         for (i=0 ; i<sow->n ; ++i)
+            sow->dev[i].active &= sow->dev[i].alarm;
+         return SOW_ST_SEARCH;
+      case OW_CMD_SEARCH_ROM:    return SOW_ST_SEARCH;
+      case OW_CMD_MATCH_ROM:
+      case OW_CMD_OD_MATCH_ROM:  return SOW_ST_MATCH;
+      case OW_CMD_READ_ROM:      return SOW_ST_READROM;
+      case OW_CMD_OD_SKIP_ROM:
+         for (i=0 ; i<sow->n ; ++i) {
+            if (sow->dev[i].active && sow->dev[i].od)
+               sow->dev[i].speed = OW_T_OVERDRIVE;
+         }
+         return SOW_ST_FUNC;
+      case OW_CMD_SKIP_ROM:      return SOW_ST_FUNC;
+      default:
+         for (i=0 ; i<sow->n ; ++i)
+            sow->dev[i].active = 0;
+         return SOW_ST_FUNC;
+   }
+}
+
+/*!
+ * \brief
+ *    A time slot. The master writes b, 1 is also the read slot.
+ *    The devices of an other speed do not see the slot and lose
+ *    the bus until the next reset.
+ * \return  The bus level at the sample time
+ */
+static uint8_t _slot (sow_t *sow, uint8_t speed, uint8_t b)
+{
+   sow_dev_t *d;
+   uint8_t  bus = b, rb;
+   uint32_t bit;
+   int i;
+
+   ++sow->stat.slots;
+   for (i=0 ; i<sow->n ; ++i) {
+      if (sow->dev[i].speed != speed)
+         sow->dev[i].active = 0;
+   }
+   switch (sow->state) {
+      case SOW_ST_ROMCMD:
+         sow->cmd |= b << sow->cnt;
+         if (++sow->cnt == 8)
+            sow->state = _romcmd (sow);
+         break;
+      case SOW_ST_SEARCH:
+         bit = sow->cnt / 3;
+         for (i=0, d=sow->dev ; i<sow->n ; ++i, ++d) {
+            if (!d->active)
+               continue;
+            rb = _rom_bit (d->rom, bit);
+            switch (sow->cnt % 3) {
+               case 0:  bus &= rb;     break;   /* ROM bit */
+               case 1:  bus &= !rb;    break;   /* complement */
+               default: if (rb != b) d->active = 0;
+                        break;                  /* direction */
+            }
+         }
+         if (++sow->cnt == 3*OW_ROM_BITS)
+            sow->state = SOW_ST_FUNC;
+         break;
+      case SOW_ST_MATCH:
+         for (i=0, d=sow->dev ; i<sow->n ; ++i, ++d) {
+            if (d->active && _rom_bit (d->rom, sow->cnt) != b)
+               d->active = 0;
+         }
+         if (++sow->cnt == OW_ROM_BITS) {
+            sow->state = SOW_ST_FUNC;
+            for (i=0, d=sow->dev ; i<sow->n ; ++i, ++d) {
+               if (sow->cmd == OW_CMD_OD_MATCH_ROM && d->active && d->od)
+                  d->speed = OW_T_OVERDRIVE;
+            }
+         }
+         break;
+      case SOW_ST_READROM:
+         for (i=0, d=sow->dev ; i<sow->n ; ++i, ++d) {
+            if (d->active)
+               bus &= _rom_bit (d->rom, sow->cnt);
+         }
+         if (++sow->cnt == OW_ROM_BITS)
+            sow->state = SOW_ST_FUNC;
+         break;
+      default:
+         break;
+   }
+   return bus;
+}
+
+/*!
+ * \brief
+ *    Decode a UART frame to a reset or a time slot by the baudrate
+ *    and the frame. The timings are the ones of onewire_uart.
+ * \return  The received frame
+ */
+static uint16_t _frame (sow_t *sow, uint8_t frame)
+{
+   sow->stat.time += 10000000000ULL / ((sow->baudrate) ? sow->baudrate : 1);
+   if (sow->baudrate <= 19200)
+      return _reset (sow, OW_T_STANDARD) ? (frame & 0xE0) : frame;
+   else if (sow->baudrate <= 230400) {
+      if (frame != 0xFF && frame != 0x00)
+         return _reset (sow, OW_T_OVERDRIVE) ? (frame & 0xC0) : frame;
+      return _slot (sow, OW_T_STANDARD, (frame == 0xFF) ? 1:0) ? frame : (frame & 0xE0);
+   }
+   else
+      return _slot (sow, OW_T_OVERDRIVE, (frame == 0xFF) ? 1:0) ? frame : (frame & 0xE0);
+}
+
+
+/*
+ *  ============= PUBLIC SIM 1-Wire API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+
+/*!
+ * \brief
+ *    Link the devices of the bus
+ *
+ * \param  sow    Pointer to simulator
+ * \param  dev    Pointer to the device table
+ * \param  n      The number of devices
+ */
+void sow_link_devices (sow_t *sow, sow_dev_t *dev, int n) {
+   sow->dev = dev;
+   sow->n = n;
+}
+
+/*
+ * Set functions
+ */
+
+/*!
+ * \brief
+ *    Set the timing model. The frame times come from the baudrate.
+ *
+ * \param  sow    Pointer to simulator
+ * \param  call   The overhead of each UART driver call, in nsec
+ */
+void sow_set_timing (sow_t *sow, uint32_t call) {
+   sow->t_call = call;
+}
+
+/*
+ * User Functions
+ */
+
+/*!
+ * \brief
+ *    De-Initialize the simulator
+ */
+void sow_deinit (sow_t *sow)
+{
+   memset ((void*)sow, 0, sizeof (sow_t));
+   /*!<
+    * This leaves the status = DRV_NOINIT
+    */
+}
+
+/*!
+ * \brief
+ *    Initialize the simulator. The missing settings get the defaults,
+ *    the devices return to standard speed and the statistics are cleared.
+ *
+ * \param  sow    Pointer to simulator
+ * \return The status of the init operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en sow_init (sow_t *sow)
+{
+   int i;
+
+   if (!sow->dev && sow->n)
+      return sow->status = DRV_ERROR;
+
+   if (!sow->t_call)
+      sow->t_call = SOW_T_CALL_DEF;
+   for (i=0 ; i<sow->n ; ++i) {
+      sow->dev[i].speed = OW_T_STANDARD;
+      sow->dev[i].active = 0;
+   }
+   sow->state = SOW_ST_IDLE;
+   memset ((void*)&sow->stat, 0, sizeof (sow_stat_t));
+
+   return sow->status = DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Make a valid ROM id, with the CRC
+ *
+ * \param  rom    Pointer to the ROM id
+ * \param  family The family code
+ * \param  serial The 48 bit serial number
+ */
+void sow_make_rom (byte_t *rom, byte_t family, uint64_t serial)
+{
+   int i;
+
+   rom[0] = family;
+   for (i=1 ; i<7 ; ++i, serial >>= 8)
+      rom[i] = (byte_t)serial;
+   rom[7] = CRC8_buffer (CRC8_Maxim_rev, CRC_LSB, 0, rom, 7);
+}
+
+/*
+ * UART interface
+ */
+
+/*!
+ * \brief
+ *    Send a UART frame to the bus and return the received one
+ */
+uint16_t sow_uart_rw (sow_t *sow, uint8_t frame)
+{
+   ++sow->stat.transfers;
+   sow->stat.time += sow->t_call;
+   return _frame (sow, frame);
+}
+
+/*!
+ * \brief
+ *    Send a number of UART frames to the bus with one call and
+ *    replace them with the received ones
+ */
+drv_status_en sow_uart_rwbuf (sow_t *sow, byte_t *frame, int n)
+{
+   int i;
+
+   ++sow->stat.transfers;
+   sow->stat.time += sow->t_call;
+   for (i=0 ; i<n ; ++i)
+      frame[i] = (byte_t)_frame (sow, frame[i]);
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Set the UART baudrate
+ */
+drv_status_en sow_uart_br (sow_t *sow, uint32_t br)
+{
+   sow->stat.time += sow->t_call;
+   sow->baudrate = br;
+   return DRV_READY;
+}
+
+#undef  _rom_bit
@@ -0,0 +1,551 @@
+/*!
+ * \file sim_sd.c
+ * \brief
+ *    A RAM backed SDHC card simulator in SPI mode. It has the spi_rw,
+ *    spi_rw_block and spi_ioctl interface that the sd_spi driver links
+ *    to. It models the command frames, the R1/R3/R7 responses, the data
+ *    tokens of the single and multiple block reads and writes, the read
+ *    access time and the write busy time, and it counts the SPI calls and
+ *    the bus time so the byte and the bulk paths can be measured.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <drv/sim_sd.h>
+
+static void _spend (simsd_t *sd, uint64_t t);
+static uint64_t _now (simsd_t *sd);
+static void _respond (simsd_t *sd, const byte_t *r, int n);
+static void _read_block (simsd_t *sd, const byte_t *src, uint32_t len, uint64_t access);
+static void _write_block (simsd_t *sd);
+static void _command (simsd_t *sd);
+static byte_t _out (simsd_t *sd);
+static void _in (simsd_t *sd, byte_t in);
+
+/*!
+ * \brief
+ *    Count bus time, to the statistics and to the shared clock
+ */
+static void _spend (simsd_t *sd, uint64_t t)
+{
+   sd->stat.time += t;
+   if (sd->clock)
+      *sd->clock += t;
+}
+
+/*!
+ * \brief
+ *    The simulation time, the shared clock or the bus time
+ */
+static uint64_t _now (simsd_t *sd) {
+   return (sd->clock) ? *sd->clock : sd->stat.time;
+}
+
+/*!
+ * \brief
+ *    Queue a command response after one Ncr byte
+ *
+ * \param  sd    Pointer to simulator
+ * \param  r      The response bytes, R1 first
+ * \param  n      The number of response bytes
+ */
+static void _respond (simsd_t *sd, const byte_t *r, int n)
+{
+   sd->resp[0] = 0xFF;
+   memcpy ((void*)&sd->resp[1], (const void*)r, n);
+   sd->rlen = n + 1;
+   sd->rpos = 0;
+}
+
+/*!
+ * \brief
+ *    Start the transmission of a data block. The token comes
+ *    after the access time.
+ *
+ * \param  sd    Pointer to simulator
+ * \param  src    The block data
+ * \param  len    The block length
+ * \param  access The access time
+ */
+static void _read_block (simsd_t *sd, const byte_t *src, uint32_t len, uint64_t access)
+{
+   sd->phase = SIMSD_PH_READ;
+   sd->src = src;
+   sd->dlen = len;
+   sd->dpos = -1;
+   sd->ready = _now (sd) + access;
+}
+
+/*!
+ * \brief
+ *    Program a received block. The data response comes next and the
+ *    card is busy for the write time.
+ */
+static void _write_block (simsd_t *sd)
+{
+   byte_t r = SIMSD_DATA_ACCEPTED;
+
+   if (sd->sector < sd->sectors) {
+      memcpy ((void*)&sd->mem[sd->sector * SIMSD_BLOCK_SZ], (const void*)sd->blk, SIMSD_BLOCK_SZ);
+      ++sd->stat.write_blocks;
+   }
+   else {
+      r = 0x0D;      // Write error
+      sd->multi = 0;
+      ++sd->stat.errors;
+   }
+   sd->resp[0] = r;
+   sd->rlen = 1;
+   sd->rpos = 0;
+   sd->busy = _now (sd) + ((sd->multi) ? sd->t.mwr : sd->t.wr);
+   if (sd->multi) {
+      ++sd->sector;
+      sd->phase = SIMSD_PH_WTOKEN;
+   }
+   else
+      sd->phase = SIMSD_PH_NONE;
+}
+
+/*!
+ * \brief
+ *    Execute a received command frame. The CRC is not checked.
+ */
+static void _command (simsd_t *sd)
+{
+   byte_t   c = sd->cmd[0] & 0x3F, r[5];
+   uint32_t arg, cs;
+   uint8_t  app = sd->app;
+   int      n = 1;
+
+   arg = ((uint32_t)sd->cmd[1] << 24) | ((uint32_t)sd->cmd[2] << 16)
+       | ((uint32_t)sd->cmd[3] << 8) | sd->cmd[4];
+   sd->app = 0;
+   ++sd->stat.cmds;
+   r[0] = (sd->idle) ? SIMSD_R1_IDLE : 0;
+
+   if (sd->idle && !(c == 0 || c == 8 || c == 55 || (c == 41 && app) || c == 58)) {
+      r[0] |= SIMSD_R1_ILLEGAL;
+      ++sd->stat.errors;
+      _respond (sd, r, 1);
+      return;
+   }
+   switch (c) {
+      case 0:     // GO_IDLE_STATE
+         sd->idle = 1;
+         sd->inits = 0;
+         sd->phase = SIMSD_PH_NONE;
+         r[0] = SIMSD_R1_IDLE;
+         break;
+      case 8:     // SEND_IF_COND, R7 echoes the voltage and the check pattern
+         r[1] = r[2] = 0;
+         r[3] = (byte_t)(arg >> 8) & 0x0F;
+         r[4] = (byte_t)arg;
+         n = 5;
+         break;
+      case 55:    // APP_CMD
+         sd->app = 1;
+         break;
+      case 41:    // SD_SEND_OP_COND
+         if (!app) {
+            r[0] |= SIMSD_R1_ILLEGAL;
+            break;
+         }
+         if (++sd->inits >= SIMSD_INIT_POLLS)
+            sd->idle = 0;
+         r[0] = (sd->idle) ? SIMSD_R1_IDLE : 0;
+         break;
+      case 58:    // READ_OCR, R3 with the power up and the CCS bits
+         r[1] = (sd->idle) ? 0x40 : 0xC0;
+         r[2] = 0xFF;
+         r[3] = 0x80;
+         r[4] = 0x00;
+         n = 5;
+         break;
+      case 9:     // SEND_CSD, version 2.0
+         memset ((void*)sd->reg, 0, 16);
+         cs = (sd->sectors >= 1024) ? sd->sectors / 1024 - 1 : 0;
+         sd->reg[0] = 0x40;
+         sd->reg[1] = 0x0E;
+         sd->reg[3] = 0x32;     // TRAN_SPEED 25MHz
+         sd->reg[4] = 0x5B;
+         sd->reg[5] = 0x59;     // READ_BL_LEN 512
+         sd->reg[7] = (byte_t)(cs >> 16) & 0x3F;
+         sd->reg[8] = (byte_t)(cs >> 8);
+         sd->reg[9] = (byte_t)cs;
+         sd->reg[10] = 0x7F;
+         sd->reg[11] = 0x80;
+         sd->reg[12] = 0x0A;
+         sd->reg[13] = 0x40;
+         sd->reg[15] = 0x01;
+         _read_block (sd, sd->reg, 16, 0);
+         break;
+      case 10:    // SEND_CID
+         memset ((void*)sd->reg, 0, 16);
+         memcpy ((void*)&sd->reg[1], (const void*)"TBSIMSD", 7);
+         sd->reg[15] = 0x01;
+         _read_block (sd, sd->reg, 16, 0);
+         break;
+      case 13:    // SEND_STATUS or SD_STATUS, R2
+         r[1] = 0;
+         n = 2;
+         if (app) {
+            memset ((void*)sd->reg, 0, 64);
+            sd->reg[10] = 0x90;    // AU_SIZE 4MB
+            _read_block (sd, sd->reg, 64, 0);
+         }
+         break;
+      case 16:    // SET_BLOCKLEN
+         if (arg != SIMSD_BLOCK_SZ)
+            r[0] |= SIMSD_R1_PARAM;
+         break;
+      case 12:    // STOP_TRANSMISSION
+         sd->phase = SIMSD_PH_NONE;
+         break;
+      case 17:    // READ_SINGLE_BLOCK
+      case 18:    // READ_MULTIPLE_BLOCK
+         if (arg >= sd->sectors) {
+            r[0] |= SIMSD_R1_ADDRESS;
+            break;
+         }
+         sd->multi = (c == 18);
+         sd->sector = arg;
+         _read_block (sd, &sd->mem[arg * SIMSD_BLOCK_SZ], SIMSD_BLOCK_SZ, sd->t.access);
+         break;
+      case 23:    // SET_WR_BLK_ERASE_COUNT
+         if (app)
+            ++sd->stat.pre_erases;
+         else
+            r[0] |= SIMSD_R1_ILLEGAL;
+         break;
+      case 24:    // WRITE_BLOCK
+      case 25:    // WRITE_MULTIPLE_BLOCK
+         if (arg >= sd->sectors) {
+            r[0] |= SIMSD_R1_ADDRESS;
+            break;
+         }
+         sd->multi = (c == 25);
+         sd->sector = arg;
+         sd->phase = SIMSD_PH_WTOKEN;
+         break;
+      default:
+         r[0] |= SIMSD_R1_ILLEGAL;
+         break;
+   }
+   if (r[0] & ~SIMSD_R1_IDLE)
+      ++sd->stat.errors;
+   _respond (sd, r, n);
+}
+
+/*!
+ * \brief
+ *    The byte the card transmits on the next clock. The response
+ *    first, then the data of a read, or the busy signal.
+ */
+static byte_t _out (simsd_t *sd)
+{
+   if (sd->rpos < sd->rlen)
+      return sd->resp[sd->rpos++];
+
+   if (sd->phase == SIMSD_PH_READ) {
+      if (_now (sd) < sd->ready) {
+         ++sd->stat.polls;
+         return 0xFF;
+      }
+      if (sd->dpos < 0) {
+         sd->dpos = 0;
+         return SIMSD_TOKEN_START;
+      }
+      if (sd->dpos < (int32_t)sd->dlen)
+         return sd->src[sd->dpos++];
+      // CRC, the host does not check it
+      if (++sd->dpos == (int32_t)sd->dlen + 2) {
+         if (sd->src != sd->reg)
+            ++sd->stat.read_blocks;
+         if (sd->src != sd->reg && sd->multi && ++sd->sector < sd->sectors)
+            _read_block (sd, &sd->mem[sd->sector * SIMSD_BLOCK_SZ], SIMSD_BLOCK_SZ, sd->t.access);
+         else
+            sd->phase = SIMSD_PH_NONE;
+      }
+      return 0xFF;
+   }
+   if (_now (sd) < sd->busy) {
+      ++sd->stat.polls;
+      return 0x00;
+   }
+   return 0xFF;
+}
+
+/*!
+ * \brief
+ *    Process the byte the card receives on a clock. The write data
+ *    and tokens, or the command frames.
+ */
+static void _in (simsd_t *sd, byte_t in)
+{
+   if (sd->phase == SIMSD_PH_WDATA) {
+      sd->blk[sd->dpos++] = in;
+      if (sd->dpos == SIMSD_BLOCK_SZ + 2)
+         _write_block (sd);
+      return;
+   }
+   if (sd->phase == SIMSD_PH_WTOKEN) {
+      if (in == ((sd->multi) ? SIMSD_TOKEN_MSTART : SIMSD_TOKEN_START)) {
+         sd->phase = SIMSD_PH_WDATA;
+         sd->dpos = 0;
+         return;
+      }
+      if (sd->multi && in == SIMSD_TOKEN_STOP) {
+         sd->phase = SIMSD_PH_NONE;
+         return;
+      }
+   }
+   // Command frames start with 01b
+   if (sd->cpos == 0 && (in & 0xC0) != 0x40)
+      return;
+   sd->cmd[sd->cpos++] = in;
+   if (sd->cpos == 6) {
+      sd->cpos = 0;
+      _command (sd);
+   }
+}
+
+
+/*
+ *  ============= PUBLIC SIM SD API =============
+ */
+
+/*
+ * Link and Glue functions
+ */
+
+/*!
+ * \brief
+ *    Link the RAM image of the card
+ *
+ * \param  sd    Pointer to simulator
+ * \param  mem    Pointer to RAM buffer
+ * \param  size   The buffer size in bytes, the card has size/512 blocks
+ */
+void simsd_link_mem (simsd_t *sd, byte_t *mem, uint32_t size) {
+   sd->mem = mem;
+   sd->sectors = size / SIMSD_BLOCK_SZ;
+}
+
+/*!
+ * \brief
+ *    Link a simulation clock in nsec, shared with other simulators.
+ *    The SPI transfers move the clock and the access and busy times run
+ *    on it, so the devices of a system work in parallel. Optional
+ */
+void simsd_link_clock (simsd_t *sd, uint64_t *clock) {
+   sd->clock = clock;
+}
+
+/*
+ * Set functions
+ */
+
+/*!
+ * \brief
+ *    Set the SPI clock in Hz, the byte time follows it
+ */
+void simsd_set_clock (simsd_t *sd, uint32_t clk) {
+   sd->t.byte = (clk) ? (uint32_t)(8000000000ULL / clk) : 0;
+}
+
+/*!
+ * \brief
+ *    Set the timing model, all in nsec
+ *
+ * \param  sd    Pointer to simulator
+ * \param  gap    Gap of each SPI call
+ * \param  access Read access time
+ * \param  wr     Single block write busy time
+ * \param  mwr    Multiple block write busy time, per block
+ */
+void simsd_set_timing (simsd_t *sd, uint32_t gap, uint32_t access, uint32_t wr, uint32_t mwr) {
+   sd->t.gap = gap;
+   sd->t.access = access;
+   sd->t.wr = wr;
+   sd->t.mwr = mwr;
+}
+
+/*
+ * User Functions
+ */
+
+/*!
+ * \brief
+ *    De-Initialize the simulator
+ */
+void simsd_deinit (simsd_t *sd)
+{
+   memset ((void*)sd, 0, sizeof (simsd_t));
+   /*!<
+    * This leaves the status = DRV_NOINIT
+    */
+}
+
+/*!
+ * \brief
+ *    Initialize the simulator. The missing settings get the defaults
+ *    and the statistics are cleared. The card is powered up in idle
+ *    state, it needs the CMD0 - ACMD41 sequence. The card content is
+ *    not touched.
+ *
+ * \param  sd    Pointer to simulator
+ * \return The status of the init operation.
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en simsd_init (simsd_t *sd)
+{
+   if (!sd->mem || !sd->sectors)
+      return sd->status = DRV_ERROR;
+
+   if (!sd->t.byte)
+      simsd_set_clock (sd, SIMSD_CLOCK_DEF);
+   if (!sd->t.gap && !sd->t.access && !sd->t.wr && !sd->t.mwr)
+      simsd_set_timing (sd, SIMSD_T_GAP_DEF, SIMSD_T_ACCESS_DEF, SIMSD_T_WR_DEF, SIMSD_T_MWR_DEF);
+   sd->sel = sd->app = sd->inits = 0;
+   sd->idle = 1;
+   sd->cpos = sd->rlen = sd->rpos = 0;
+   sd->phase = SIMSD_PH_NONE;
+   sd->busy = 0;
+   memset ((void*)&sd->stat, 0, sizeof (simsd_stat_t));
+
+   return sd->status = DRV_READY;
+}
+
+/*
+ * SPI interface
+ */
+
+/*!
+ * \brief
+ *    Chip select. A deselect drops the partial command and the pending
+ *    response. A select between the blocks of a multiple block read
+ *    delays the next block by the access time, so the host sees a ready
+ *    bus before the STOP_TRANSMISSION.
+ *
+ * \param  sd    Pointer to simulator
+ * \param  en     1 to select, 0 to deselect
+ */
+void simsd_spi_cs (simsd_t *sd, uint8_t en)
+{
+   if (!en) {
+      sd->cpos = sd->rlen = sd->rpos = 0;
+      sd->sel = 0;
+      return;
+   }
+   if (!sd->sel && sd->phase == SIMSD_PH_READ && sd->dpos < 0)
+      sd->ready = _now (sd) + sd->t.access;
+   sd->sel = 1;
+}
+
+/*!
+ * \brief
+ *    Transmit and receive one byte. The sd_spi spi_rw link.
+ *
+ * \param  sd    Pointer to simulator
+ * \param  out    The byte from the host
+ * \return        The byte from the card, 0xFF when deselected
+ */
+byte_t simsd_spi_rw (simsd_t *sd, byte_t out)
+{
+   byte_t in = 0xFF;
+
+   ++sd->stat.calls;
+   ++sd->stat.bytes;
+   _spend (sd, (uint64_t)sd->t.gap + sd->t.byte);
+   if (sd->sel) {
+      in = _out (sd);
+      _in (sd, out);
+   }
+   return in;
+}
+
+/*!
+ * \brief
+ *    Transmit and receive a block of bytes with one call, as a DMA or
+ *    FIFO SPI does. The sd_spi spi_rw_block link.
+ *
+ * \param  sd    Pointer to simulator
+ * \param  tx     The bytes from the host, NULL for 0xFF
+ * \param  rx     Buffer for the bytes from the card, NULL to discard
+ * \param  n      The number of bytes
+ */
+void simsd_spi_rw_block (simsd_t *sd, const byte_t *tx, byte_t *rx, size_t n)
+{
+   byte_t in;
+
+   ++sd->stat.calls;
+   sd->stat.bytes += n;
+   _spend (sd, (uint64_t)sd->t.gap + (uint64_t)n * sd->t.byte);
+   for (size_t i=0 ; i<n ; ++i) {
+      in = 0xFF;
+      if (sd->sel) {
+         in = _out (sd);
+         _in (sd, (tx) ? tx[i] : 0xFF);
+      }
+      if (rx)
+         rx[i] = in;
+   }
+}
+
+/*!
+ * \brief
+ *    The SPI bus ioctl. The sd_spi spi_ioctl link.
+ *
+ * \param  sd    Pointer to simulator
+ * \param  cmd    specifies the command
+ *    \arg CTRL_GET_STATUS    Get simulator's status
+ *    \arg CTRL_INIT          Bus init, the card powers up in idle state
+ *    \arg CTRL_DEINIT        Bus de-init
+ *    \arg CTRL_SET_CLOCK     Set the SPI clock from a uint32_t in Hz
+ * \param  buf    pointer to buffer for ioctl
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en simsd_spi_ioctl (simsd_t *sd, ioctl_cmd_t cmd, ioctl_buf_t buf)
+{
+   switch (cmd)
+   {
+      case CTRL_GET_STATUS:
+         if (buf)
+            *(drv_status_en*)buf = sd->status;
+         return DRV_READY;
+      case CTRL_INIT:
+         sd->idle = 1;
+         sd->app = sd->inits = 0;
+         sd->cpos = sd->rlen = sd->rpos = 0;
+         sd->phase = SIMSD_PH_NONE;
+         return (sd->status == DRV_READY) ? DRV_READY : DRV_ERROR;
+      case CTRL_DEINIT:
+         sd->sel = 0;
+         return DRV_READY;
+      case CTRL_SET_CLOCK:
+         if (!buf)
+            return DRV_ERROR;
+         simsd_set_clock (sd, *(uint32_t*)buf);
+         return DRV_READY;
+      default:
+         return DRV_ERROR;
+   }
+}
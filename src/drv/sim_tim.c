@@ -0,0 +1,164 @@
+/*!
+ * \file sim_tim.c
+ * \brief
+ *    A simulated hardware timer for the jiffy module. A wrapping 16bit
+ *    up counter with auto reload, that runs from the host clock or a
+ *    fixed number of ticks on each read, so jiffies, delays and timer
+ *    wheels can be run and measured on the host.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <drv/sim_tim.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#define SIM_TIM_HOST_CLOCK
+#endif
+
+static sim_tim_t _stim;
+
+/*!
+ * \brief
+ *    Host monotonic clock in nsec, 0 if there is none
+ */
+static uint64_t _host_nsec (void)
+{
+#ifdef SIM_TIM_HOST_CLOCK
+   struct timespec ts;
+   clock_gettime (CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#else
+   return 0;
+#endif
+}
+
+/*!
+ * \brief
+ *    Counter ticks in \a ns nsec
+ */
+static uint64_t _ticks (uint64_t ns) {
+   return (ns / 1000000000ULL) * _stim.freq
+        + ((ns % 1000000000ULL) * _stim.freq) / 1000000000ULL;
+}
+
+/*
+ * Link and Glue functions
+ */
+
+/*!
+ * \brief
+ *    Link a simulation clock in nsec, shared with the device simulators.
+ *    The counter runs on that clock instead of the host clock, and each
+ *    read moves the clock by step ticks, the time of a busy wait spin.
+ */
+void sim_tim_link_clock (uint64_t *clock) {
+   _stim.clock = clock;
+}
+
+/*
+ * Set functions
+ */
+
+/*!
+ * \brief
+ *    Select the counter clock.
+ * \param   step  Ticks on each read, 0 to follow the host clock. Without
+ *                a host clock the counter moves only with sim_tim_advance().
+ */
+void sim_tim_set_step (uint32_t step) {
+   _stim.step = step;
+}
+
+/*
+ * User Functions
+ */
+
+/*!
+ * \brief
+ *    Start the counter. The jiffy setfreq link, \see jf_link_setfreq().
+ * \param   freq  The counter frequency, 0 to stop
+ * \param   top   The auto reload value
+ * \return  0 on success
+ */
+int sim_tim_setfreq (uint32_t freq, uint32_t top)
+{
+   _stim.freq = freq;
+   _stim.top = top;
+   _stim.ticks = 0;
+   _stim.reads = 0;
+   _stim.t0 = (_stim.clock) ? *_stim.clock : _host_nsec ();
+   return 0;
+}
+
+/*!
+ * \brief
+ *    Read the counter. The jiffy read link, \see jf_link_read().
+ *    Each read moves the counter by step ticks, or to the host clock.
+ *    With a linked clock the counter follows it.
+ * \return  The counter value
+ */
+jiffy_t sim_tim_read (void)
+{
+   if (!_stim.freq)
+      return 0;
+   ++_stim.reads;
+   if (_stim.clock) {
+      *_stim.clock += ((uint64_t)_stim.step * 1000000000ULL) / _stim.freq;
+      _stim.ticks = _ticks (*_stim.clock - _stim.t0);
+   }
+   else if (_stim.step)
+      _stim.ticks += _stim.step;
+#ifdef SIM_TIM_HOST_CLOCK
+   else
+      _stim.ticks = _ticks (_host_nsec () - _stim.t0);
+#endif
+   return (jiffy_t)(_stim.ticks % ((uint64_t)_stim.top + 1));
+}
+
+/*!
+ * \brief
+ *    Move the counter by \a ticks, ex: to simulate a sleep.
+ *    On host clock mode the start time moves back instead.
+ */
+void sim_tim_advance (uint64_t ticks)
+{
+   if (_stim.clock && _stim.freq)
+      *_stim.clock += (ticks * 1000000000ULL) / _stim.freq;
+   else if (_stim.step || !_stim.freq)
+      _stim.ticks += ticks;
+   else
+      _stim.t0 -= (ticks * 1000000000ULL) / _stim.freq;
+}
+
+/*!
+ * \brief
+ *    The total counter ticks from start, the reference of the jiffy
+ *    extended clock.
+ */
+uint64_t sim_tim_ticks (void) {
+   return _stim.ticks;
+}
+
+/*!
+ * \brief
+ *    The number of counter reads, ex: the spins of a busy wait.
+ */
+uint64_t sim_tim_reads (void) {
+   return _stim.reads;
+}
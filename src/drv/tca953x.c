@@ -309,6 +309,46 @@ drv_status_en tca953x_port_write (tca953x_t *tca, tca953x_port_en port, uint8_t
    return _write_regs (tca, reg_add, &out, 1);
 }
 
+/*!
+ * \brief
+ *    Read both input ports with one I2C transaction. The register
+ *    address auto increments from port 0 to port 1.
+ * \param   tca      Pointer indicate the tca data stuct to use
+ * \param   in       Pointer to return the inputs, port 1 on the MS byte
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en tca953x_inputs_read (tca953x_t *tca, uint16_t *in)
+{
+   uint8_t  r[2];
+
+   if (_read_regs (tca, TCA953x_INPUT_PORT_0, r, 2) != DRV_READY)
+      return DRV_ERROR;
+   *in = ((uint16_t)r[1] << 8) | r[0];
+   return DRV_READY;
+}
+
+/*!
+ * \brief
+ *    Input bank read function, to link a TCA953x to an input
+ *    scanner bank. \see in_link_bank()
+ * \param   tca      Pointer indicate the tca data stuct to use
+ * \param   in       Pointer to return the inputs, port 1 on bits [15:8]
+ * \return The status of the operation
+ *    \arg DRV_READY
+ *    \arg DRV_ERROR
+ */
+drv_status_en tca953x_in_read (void *tca, uint32_t *in)
+{
+   uint16_t r;
+
+   if (tca953x_inputs_read ((tca953x_t*)tca, &r) != DRV_READY)
+      return DRV_ERROR;
+   *in = r;
+   return DRV_READY;
+}
+
 /*!
  * \brief
  *    Read Port's pin data
@@ -24,6 +24,13 @@
 #include <dsp/conv.h>
 
 
+/*!
+ * \brief
+ *    The main body of direct form convolution.
+ * \note
+ *    The floating point versions switch to conv_fft_xx() when both
+ *    signals have at least CONV_FFT_THRESHOLD points.
+ */
 #define  _conv_body() {                               \
    int n, k, sy, kmin, kmax;                          \
                                                       \
@@ -91,6 +98,9 @@ void conv_i (int *y, int *h, int32_t sh, int *x, int32_t sx) {
  * \return none
  */
 void conv_f (float *y, float *h, int32_t sh, float *x, int32_t sx) {
+   if (sh >= CONV_FFT_THRESHOLD && sx >= CONV_FFT_THRESHOLD &&
+       conv_fft_f (y, h, sh, x, sx) == 0)
+      return;
    _conv_body();
 }
 
@@ -118,6 +128,9 @@ void conv_f (float *y, float *h, int32_t sh, float *x, int32_t sx) {
  * \return none
  */
 void conv_d (double *y, double *h, int32_t sh, double *x, int32_t sx) {
+   if (sh >= CONV_FFT_THRESHOLD && sx >= CONV_FFT_THRESHOLD &&
+       conv_fft_d (y, h, sh, x, sx) == 0)
+      return;
    _conv_body();
 }
 
@@ -172,6 +185,9 @@ void conv_ci (complex_i_t *y, complex_i_t *h, int32_t sh, complex_i_t *x, int32_
  * \return none
  */
 void conv_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t sx) {
+   if (sh >= CONV_FFT_THRESHOLD && sx >= CONV_FFT_THRESHOLD &&
+       conv_fft_cf (y, h, sh, x, sx) == 0)
+      return;
    _conv_body();
 }
 
@@ -199,7 +215,252 @@ void conv_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_
  * \return none
  */
 void conv_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t sx) {
+   if (sh >= CONV_FFT_THRESHOLD && sx >= CONV_FFT_THRESHOLD &&
+       conv_fft_cd (y, h, sh, x, sx) == 0)
+      return;
    _conv_body();
 }
 #undef _conv_body
 
+
+/*!
+ * \brief
+ *    Return the first power of 2 that is greater or equal to x, but not
+ *    less than 2.
+ */
+static uint32_t _pow2_ge (uint32_t x) {
+   uint32_t r;
+   for (r=2 ; r<x ; r<<=1)
+      ;
+   return r;
+}
+
+/*!
+ * \brief
+ *    The main body of FFT convolution. Both signals are zero padded to the
+ *    first power of 2 that fits the linear convolution, so there is no
+ *    circular aliasing.
+ *
+ * \param   _ct   Complex type of the frequency domain
+ * \param   _t    Type of the time domain
+ * \param   _fft  Forward transform
+ * \param   _ifft Inverse transform
+ * \param   _mul  Element-wise complex multiplication
+ */
+#define  _conv_fft_body(_ct, _t, _fft, _ifft, _mul) {         \
+   uint32_t n, sy;                                             \
+   _ct *A, *B;                                                 \
+                                                               \
+   sy = sx + sh - 1;                                           \
+   n = _pow2_ge (sy);                                          \
+   if ((A = (_ct*)calloc (n, sizeof (_ct))) == NULL)           \
+      return 1;                                                \
+   if ((B = (_ct*)calloc (n, sizeof (_ct))) == NULL) {         \
+      free ((void*)A);                                         \
+      return 1;                                                \
+   }                                                           \
+   memcpy ((void*)A, (void*)h, sh*sizeof (_t));                \
+   memcpy ((void*)B, (void*)x, sx*sizeof (_t));                \
+   _fft ((_t*)A, A, n);                                        \
+   _fft ((_t*)B, B, n);                                        \
+   _mul (A, A, B, n);                                          \
+   _ifft (A, (_t*)A, n);                                       \
+   memcpy ((void*)y, (void*)A, sy*sizeof (_t));                \
+   free ((void*)A);                                            \
+   free ((void*)B);                                            \
+   return 0;                                                   \
+}
+
+/*!
+ * \brief
+ *    Calculates the convolution of float h and x using the FFT
+ *
+ *   y[n] = iFFT (FFT(h) .* FFT(x)),   n: [0 .. sh+sx-2]
+ *
+ * \param   y  Pointer to output vector
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+int conv_fft_f (float *y, float *h, int32_t sh, float *x, int32_t sx) {
+   _conv_fft_body (complex_f_t, float, fft_rf, ifft_rf, vemul_cf);
+}
+
+/*!
+ * \brief
+ *    Calculates the convolution of double h and x using the FFT
+ *
+ *   y[n] = iFFT (FFT(h) .* FFT(x)),   n: [0 .. sh+sx-2]
+ *
+ * \param   y  Pointer to output vector
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+int conv_fft_d (double *y, double *h, int32_t sh, double *x, int32_t sx) {
+   _conv_fft_body (complex_d_t, double, fft_r, ifft_r, vemul_cd);
+}
+
+/*!
+ * \brief
+ *    Calculates the convolution of complex float h and x using the FFT
+ *
+ *   y[n] = iFFT (FFT(h) .* FFT(x)),   n: [0 .. sh+sx-2]
+ *
+ * \param   y  Pointer to output vector
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+int conv_fft_cf (complex_f_t *y, complex_f_t *h, int32_t sh, complex_f_t *x, int32_t sx) {
+   _conv_fft_body (complex_f_t, complex_f_t, fft_cf, ifft_cf, vemul_cf);
+}
+
+/*!
+ * \brief
+ *    Calculates the convolution of complex double h and x using the FFT
+ *
+ *   y[n] = iFFT (FFT(h) .* FFT(x)),   n: [0 .. sh+sx-2]
+ *
+ * \param   y  Pointer to output vector
+ * \param   h  Pointer to system vector, or signal 1
+ * \param  sh  Size of vector h
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+int conv_fft_cd (complex_d_t *y, complex_d_t *h, int32_t sh, complex_d_t *x, int32_t sx) {
+   _conv_fft_body (complex_d_t, complex_d_t, fft_c, ifft_c, vemul_cd);
+}
+#undef _conv_fft_body
+
+
+/*
+ * ============ Overlap-save convolver ============
+ */
+
+/*!
+ * \brief
+ *    Overlap-save convolver de-initialisation.
+ *
+ * \param  c      Which convolver to free
+ * \return none
+*/
+void conv_ols_deinit (conv_ols_t *c) {
+   if (c->H)   free ((void*)c->H);
+   if (c->t)   free ((void*)c->t);
+   if (c->s)   free ((void*)c->s);
+   if (c->o)   free ((void*)c->o);
+   memset ((void*)c, 0, sizeof (conv_ols_t));
+}
+
+/*!
+ * \brief
+ *    Overlap-save convolver initialisation. Calculates the kernel spectrum
+ *    once, so each block costs one forward and one inverse real FFT.
+ *
+ * \param  c      Which convolver to use
+ * \param  h      Pointer to kernel
+ * \param  sh     Size of kernel
+ * \param  block  The requested number of new samples per block. The actual
+ *                block size c->L is this or greater. Use 0 for the default
+ *                FFT size of 4 times the kernel.
+ * \return        The FFT size, or 0 on failure
+ */
+uint32_t conv_ols_init (conv_ols_t *c, double *h, uint32_t sh, uint32_t block)
+{
+   memset ((void*)c, 0, sizeof (conv_ols_t));
+   if (sh == 0)
+      return 0;
+
+   c->M = sh;
+   c->N = _pow2_ge ((block) ? block + sh - 1 : 4*sh);
+   c->L = c->N - c->M + 1;
+
+   if ( (c->H = (complex_d_t*)calloc (c->N, sizeof (complex_d_t))) == NULL ||
+        (c->t = (complex_d_t*)calloc (c->N, sizeof (complex_d_t))) == NULL ||
+        (c->s = (double*)calloc (c->N, sizeof (double))) == NULL ||
+        (c->o = (double*)calloc (c->L, sizeof (double))) == NULL ) {
+      conv_ols_deinit (c);
+      return 0;
+   }
+   // Kernel spectrum
+   memcpy ((void*)c->H, (void*)h, sh*sizeof (double));
+   fft_r ((double*)c->H, c->H, c->N);
+   c->cnt = 0;
+   return c->N;
+}
+
+/*!
+ * \brief
+ *    Clear the convolver's input history and output.
+ *
+ * \param  c      Which convolver to use
+ * \return        None
+ */
+void conv_ols_reset (conv_ols_t *c) {
+   memset ((void*)c->s, 0, c->N*sizeof (double));
+   memset ((void*)c->o, 0, c->L*sizeof (double));
+   c->cnt = 0;
+}
+
+/*!
+ * \brief
+ *    Filter a block of n samples of any length. Each output point has a fixed
+ *    latency of c->L samples, so
+ *
+ *   y[k] = (h * x)[k - L]
+ *
+ *    A new block is calculated every time c->L input samples are gathered.
+ *
+ * \param  c      Which convolver to use
+ * \param  x      Pointer to input samples
+ * \param  y      Pointer to output samples. Can be the same as x
+ * \param  n      Number of samples
+ * \return        None
+ */
+void conv_ols (conv_ols_t *c, double *x, double *y, uint32_t n)
+{
+   uint32_t i, k, M_1 = c->M - 1;
+   double *t = (double*)c->t;
+
+   for (i=0 ; i<n ; i+=k) {
+      // Samples until the end of the current block
+      k = c->L - c->cnt;
+      if (k > n - i)
+         k = n - i;
+      memcpy ((void*)&c->s[M_1 + c->cnt], (void*)&x[i], k*sizeof (double));
+      memcpy ((void*)&y[i], (void*)&c->o[c->cnt], k*sizeof (double));
+
+      if ((c->cnt += k) >= c->L) {
+         // Block complete. Filter it in frequency domain
+         memcpy ((void*)t, (void*)c->s, c->N*sizeof (double));
+         fft_r (t, c->t, c->N);
+         vemul_cd (c->t, c->t, c->H, c->N);
+         ifft_r (c->t, t, c->N);
+         // Keep the valid part and the history for the next block
+         memcpy ((void*)c->o, (void*)&t[M_1], c->L*sizeof (double));
+         memmove ((void*)c->s, (void*)&c->s[c->L], M_1*sizeof (double));
+         c->cnt = 0;
+      }
+   }
+}
+
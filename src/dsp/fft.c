@@ -22,6 +22,7 @@
  *
  */
 #include <dsp/fft.h>
+#include <string.h>
 
 /*
  * Static functions
@@ -108,6 +109,537 @@ static void _bit_reverse_ci (complex_i_t *x, complex_f_t *r, uint32_t n) {
    _bit_reverse_body(complex_f_t);
 }
 
+/*
+ * ============ FFT plans ============
+ */
+
+#if FFT_PLAN_CACHE_TLS
+#define _plan_tls    _Thread_local
+#else
+#define _plan_tls
+#endif
+
+static _plan_tls fft_plan_t _plan_cache[FFT_PLAN_CACHE_SIZE];   //!< The plans used by fft_xx() entry points
+static _plan_tls uint32_t _plan_victim;                         //!< Round robin replacement index
+
+/*!
+ * \brief
+ *    The main body of the planned bit reversal. Uses the permutation
+ *    table of the plan instead of the counter reversal loop.
+ * \param   _t    The type for the conversion
+ */
+#define _bit_reverse_plan_body(_t)              \
+{                                               \
+   uint32_t i, j;                               \
+   for (i=0 ; i<n ; ++i) {                      \
+      j = rev[i];                               \
+      /* point exchange and type conversion */  \
+      if (i<=j) {                               \
+         tmp = (_t)x[i];                        \
+         r[i] = (_t)x[j];                       \
+         r[j] = tmp;                            \
+      }                                         \
+   }                                            \
+}
+
+/*!
+ * \brief
+ *    Fetch the twiddle factor W_n^k, k=[0..n), from a table of size n/2
+ *    using W_n^(k+n/2) = -W_n^k. The imaginary part is multiplied by s, so
+ *    s=-1 gives the conjugate twiddle for the inverse transform.
+ */
+#define _tw_fetch(_wr, _wi, _k, _r, _i) {             \
+   if ((_k) < n_2) {                                  \
+      _wr = _r(w[(_k)]);                              \
+      _wi = s*_i(w[(_k)]);                            \
+   } else {                                           \
+      _wr = -_r(w[(_k)-n_2]);                         \
+      _wi = -s*_i(w[(_k)-n_2]);                       \
+   }                                                  \
+}
+
+/*!
+ * \brief
+ *    Complex multiplication on split real/imaginary parts
+ *    (_pr + j_pi) = (_xr + j_xi) * (_wr + j_wi)
+ */
+#define _cmul(_pr, _pi, _xr, _xi, _wr, _wi) {         \
+   _pr = (_xr)*(_wr) - (_xi)*(_wi);                   \
+   _pi = (_xr)*(_wi) + (_xi)*(_wr);                   \
+}
+
+/*!
+ * \brief
+ *    Radix-4 butterfly. It merges two successive radix-2 stages, using
+ *    3 twiddle multiplications instead of 4 and one pass over the data
+ *    instead of two.
+ *
+ *    X0 = (a + W^2j.b) + (W^j.c + W^3j.d)
+ *    X2 = (a + W^2j.b) - (W^j.c + W^3j.d)
+ *    X1 = (a - W^2j.b) -+ j(W^j.c - W^3j.d)
+ *    X3 = (a - W^2j.b) +- j(W^j.c - W^3j.d)
+ *
+ * \param   _tw   When 0 all twiddles are unity and multiplications are skipped
+ */
+#define _fft_r4_bfly(_tw, _r, _i)                     \
+{                                                     \
+   k1 = i+q; k2 = k1+q; k3 = k2+q;                    \
+   if (_tw) {                                         \
+      _cmul (br, bi, _r(X[k1]), _i(X[k1]), w2r, w2i); \
+      _cmul (cr, ci, _r(X[k2]), _i(X[k2]), w1r, w1i); \
+      _cmul (dr, di, _r(X[k3]), _i(X[k3]), w3r, w3i); \
+   } else {                                           \
+      br = _r(X[k1]); bi = _i(X[k1]);                 \
+      cr = _r(X[k2]); ci = _i(X[k2]);                 \
+      dr = _r(X[k3]); di = _i(X[k3]);                 \
+   }                                                  \
+   ar = _r(X[i]);    ai = _i(X[i]);                   \
+   t0r = ar + br;    t0i = ai + bi;                   \
+   t1r = ar - br;    t1i = ai - bi;                   \
+   t2r = cr + dr;    t2i = ci + di;                   \
+   /* t3 = -j(c-d) for forward, +j(c-d) for inverse */\
+   t3r = s*(ci - di);                                 \
+   t3i = -s*(cr - dr);                                \
+   _r(X[i])  = t0r + t2r;  _i(X[i])  = t0i + t2i;     \
+   _r(X[k2]) = t0r - t2r;  _i(X[k2]) = t0i - t2i;     \
+   _r(X[k1]) = t1r + t3r;  _i(X[k1]) = t1i + t3i;     \
+   _r(X[k3]) = t1r - t3r;  _i(X[k3]) = t1i - t3i;     \
+}
+
+/*!
+ * \brief
+ *    The main body of the planned frequency domain synthesis. It uses the
+ *    twiddle table instead of cos()/sin() and the repeated complex multiplication.
+ *    The stages are merged in pairs using radix-4 butterflies. When log2(n) is odd
+ *    a single radix-2 stage, which has only unity twiddles, runs first.
+ *
+ * \param   _tw_t  The twiddle/data type
+ * \param   _r     Real part accessor
+ * \param   _i     Imaginary part accessor
+ */
+#define _fft_stages_plan_body(_tw_t, _r, _i)          \
+{                                                     \
+   uint32_t i, j, l, m, le, q, st, n_2;               \
+   uint32_t k1, k2, k3;                               \
+   _tw_t s, w1r, w1i, w2r, w2i, w3r, w3i;             \
+   _tw_t ar, ai, br, bi, cr, ci, dr, di;              \
+   _tw_t t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;      \
+                                                      \
+   s = (inv) ? -1 : 1;                                \
+   n_2 = n>>1;                                        \
+   m = _log2 (n);                                     \
+   l = 1;                                             \
+   if (m & 1) {                                       \
+      /* Radix-2 stage with unity twiddles */         \
+      for (i=0 ; i<n ; i+=2) {                        \
+         t0r = _r(X[i+1]); t0i = _i(X[i+1]);          \
+         _r(X[i+1]) = _r(X[i]) - t0r;                 \
+         _i(X[i+1]) = _i(X[i]) - t0i;                 \
+         _r(X[i]) += t0r;                             \
+         _i(X[i]) += t0i;                             \
+      }                                               \
+      l = 2;                                          \
+   }                                                  \
+   /* Radix-4 passes, each one does stages l, l+1 */  \
+   for ( ; l<m ; l+=2) {                              \
+      le = 1UL << (l+1);                              \
+      q = le>>2;                                      \
+      st = n >> (l+1);     /* twiddle stride */       \
+      /* First butterfly of each group: W^0 = 1 */    \
+      for (i=0 ; i<n ; i+=le)                         \
+         _fft_r4_bfly (0, _r, _i);                    \
+      for (j=1 ; j<q ; ++j) {                         \
+         _tw_fetch (w1r, w1i, j*st, _r, _i);          \
+         _tw_fetch (w2r, w2i, 2*j*st, _r, _i);        \
+         _tw_fetch (w3r, w3i, 3*j*st, _r, _i);        \
+         for (i=j ; i<n ; i+=le)                      \
+            _fft_r4_bfly (1, _r, _i);                 \
+      }                                               \
+   }                                                  \
+}
+
+/*!
+ * \brief
+ *    Real FFT post-processing. Separates the n/2 point transform Z of the
+ *    packed signal z[k] = x[2k] + jx[2k+1] into the n point spectrum of x.
+ *
+ *    Fe = (Z[k] + Z*[N-k]) / 2
+ *    Fo = (Z[k] - Z*[N-k]) / 2j
+ *    X[k] = Fe + W^k.Fo,   X[N-k] = (Fe - W^k.Fo)*,    X[n-k] = X*[k]
+ *
+ * \param   _tw_t  The twiddle/data type
+ * \param   _r     Real part accessor
+ * \param   _i     Imaginary part accessor
+ */
+#define _fft_r_post_body(_tw_t, _r, _i)               \
+{                                                     \
+   uint32_t k, N, n_2;                                \
+   _tw_t s=1, wr, wi, ar, ai, br, bi;                 \
+   _tw_t er, ei, fr, fi, tr, ti;                      \
+                                                      \
+   n_2 = N = n>>1;                                    \
+   ar = _r(X[0]); ai = _i(X[0]);                      \
+   _r(X[0]) = ar + ai;  _i(X[0]) = 0;                 \
+   _r(X[N]) = ar - ai;  _i(X[N]) = 0;                 \
+   for (k=1 ; k<=(N>>1) ; ++k) {                      \
+      ar = _r(X[k]);    ai = _i(X[k]);                \
+      br = _r(X[N-k]);  bi = _i(X[N-k]);              \
+      er = (ar + br)/2; ei = (ai - bi)/2;             \
+      fr = (ai + bi)/2; fi = (br - ar)/2;             \
+      _tw_fetch (wr, wi, k, _r, _i);                  \
+      _cmul (tr, ti, fr, fi, wr, wi);                 \
+      _r(X[k]) = er + tr;  _i(X[k]) = ei + ti;        \
+      if (k != N-k) {                                 \
+         _r(X[N-k]) = er - tr;                        \
+         _i(X[N-k]) = ti - ei;                        \
+      }                                               \
+   }                                                  \
+   /* Negative frequencies from the symmetry */      \
+   for (k=1 ; k<N ; ++k) {                            \
+      _r(X[n-k]) = _r(X[k]);                          \
+      _i(X[n-k]) = -_i(X[k]);                         \
+   }                                                  \
+}
+
+/*!
+ * \brief
+ *    Inverse real FFT pre-processing. Packs the hermitian n point spectrum X
+ *    into the n/2 point spectrum Z of z[k] = x[2k] + jx[2k+1]. It is the
+ *    reverse of the post-processing.
+ *
+ *    Fe = (X[k] + X*[N-k]) / 2
+ *    Fo = (X[k] - X*[N-k]) / 2 . W^-k
+ *    Z[k] = Fe + jFo
+ *
+ * \param   _tw_t  The twiddle/data type
+ * \param   _r     Real part accessor
+ * \param   _i     Imaginary part accessor
+ */
+#define _ifft_r_pre_body(_tw_t, _r, _i)               \
+{                                                     \
+   uint32_t k, N, n_2;                                \
+   _tw_t s=-1, wr, wi, ar, ai, br, bi;                \
+   _tw_t er, ei, dr, di, fr, fi;                      \
+                                                      \
+   n_2 = N = n>>1;                                    \
+   for (k=0 ; k<=(N>>1) ; ++k) {                      \
+      ar = _r(X[k]);    ai = _i(X[k]);                \
+      br = _r(X[N-k]);  bi = _i(X[N-k]);              \
+      /* Pair k */                                    \
+      er = (ar + br)/2; ei = (ai - bi)/2;             \
+      dr = (ar - br)/2; di = (ai + bi)/2;             \
+      _tw_fetch (wr, wi, k, _r, _i);                  \
+      _cmul (fr, fi, dr, di, wr, wi);                 \
+      _r(Z[k]) = er - fi;  _i(Z[k]) = ei + fr;        \
+      if (k != 0 && k != N-k) {                       \
+         /* Pair N-k, W^-(N-k) = -W^k */              \
+         er = (br + ar)/2; ei = (bi - ai)/2;          \
+         dr = (br - ar)/2; di = (bi + ai)/2;          \
+         _cmul (fr, fi, dr, di, -wr, wi);             \
+         _r(Z[N-k]) = er - fi;  _i(Z[N-k]) = ei + fr; \
+      }                                               \
+   }                                                  \
+}
+
+static void _bit_reverse_pc (complex_d_t *x, complex_d_t *r, uint32_t *rev, uint32_t n) __O3__ ;
+static void _bit_reverse_pcf (complex_f_t *x, complex_f_t *r, uint32_t *rev, uint32_t n) __O3__ ;
+static void _bit_reverse_pci (complex_i_t *x, complex_f_t *r, uint32_t *rev, uint32_t n) __O3__ ;
+static void _fft_stages_pc (complex_d_t *X, complex_d_t *w, uint32_t n, int inv) __O3__ ;
+static void _fft_stages_pcf (complex_f_t *X, complex_f_t *w, uint32_t n, int inv) __O3__ ;
+static void _fft_r_post_pc (complex_d_t *X, complex_d_t *w, uint32_t n) __O3__ ;
+static void _fft_r_post_pcf (complex_f_t *X, complex_f_t *w, uint32_t n) __O3__ ;
+static void _ifft_r_pre_pc (complex_d_t *X, complex_d_t *Z, complex_d_t *w, uint32_t n) __O3__ ;
+static void _ifft_r_pre_pcf (complex_f_t *X, complex_f_t *Z, complex_f_t *w, uint32_t n) __O3__ ;
+
+static void _bit_reverse_pc (complex_d_t *x, complex_d_t *r, uint32_t *rev, uint32_t n) {
+   complex_d_t tmp;
+   _bit_reverse_plan_body (complex_d_t);
+}
+static void _bit_reverse_pcf (complex_f_t *x, complex_f_t *r, uint32_t *rev, uint32_t n) {
+   complex_f_t tmp;
+   _bit_reverse_plan_body (complex_f_t);
+}
+static void _bit_reverse_pci (complex_i_t *x, complex_f_t *r, uint32_t *rev, uint32_t n) {
+   complex_f_t tmp;
+   _bit_reverse_plan_body (complex_f_t);
+}
+
+/*!
+ * \brief
+ *    Double precision butterfly stages of a size n transform
+ *
+ * \param   X     Pointer to bit reversed data
+ * \param   w     Pointer to the twiddle table of size n/2
+ * \param   n     Number of points
+ * \param   inv   Non zero for the inverse transform (conjugate twiddles)
+ */
+static void _fft_stages_pc (complex_d_t *X, complex_d_t *w, uint32_t n, int inv) {
+   _fft_stages_plan_body (double, real, imag);
+}
+
+/*!
+ * \brief
+ *    Single precision butterfly stages of a size n transform
+ *
+ * \param   X     Pointer to bit reversed data
+ * \param   w     Pointer to the twiddle table of size n/2
+ * \param   n     Number of points
+ * \param   inv   Non zero for the inverse transform (conjugate twiddles)
+ */
+static void _fft_stages_pcf (complex_f_t *X, complex_f_t *w, uint32_t n, int inv) {
+   _fft_stages_plan_body (float, realf, imagf);
+}
+
+/*!
+ * \brief
+ *    Double precision real FFT post-processing
+ *
+ * \param   X     Pointer to size n array. The first n/2 points hold the packed transform
+ * \param   w     Pointer to the twiddle table of size n/2
+ * \param   n     Number of points
+ */
+static void _fft_r_post_pc (complex_d_t *X, complex_d_t *w, uint32_t n) {
+   _fft_r_post_body (double, real, imag);
+}
+
+/*!
+ * \brief
+ *    Single precision real FFT post-processing
+ *
+ * \param   X     Pointer to size n array. The first n/2 points hold the packed transform
+ * \param   w     Pointer to the twiddle table of size n/2
+ * \param   n     Number of points
+ */
+static void _fft_r_post_pcf (complex_f_t *X, complex_f_t *w, uint32_t n) {
+   _fft_r_post_body (float, realf, imagf);
+}
+
+/*!
+ * \brief
+ *    Double precision inverse real FFT pre-processing
+ *
+ * \param   X     Pointer to size n/2+1 hermitian spectrum
+ * \param   Z     Pointer to size n/2 packed spectrum. Can be the same as X
+ * \param   w     Pointer to the twiddle table of size n/2
+ * \param   n     Number of points
+ */
+static void _ifft_r_pre_pc (complex_d_t *X, complex_d_t *Z, complex_d_t *w, uint32_t n) {
+   _ifft_r_pre_body (double, real, imag);
+}
+
+/*!
+ * \brief
+ *    Single precision inverse real FFT pre-processing
+ *
+ * \param   X     Pointer to size n/2+1 hermitian spectrum
+ * \param   Z     Pointer to size n/2 packed spectrum. Can be the same as X
+ * \param   w     Pointer to the twiddle table of size n/2
+ * \param   n     Number of points
+ */
+static void _ifft_r_pre_pcf (complex_f_t *X, complex_f_t *Z, complex_f_t *w, uint32_t n) {
+   _ifft_r_pre_body (float, realf, imagf);
+}
+
+/*!
+ * \brief
+ *    Create a FFT plan of size n. The plan holds the bit reversal permutation
+ *    and the twiddle factors, so the transforms that use it do not call cos()/sin().
+ *    Each twiddle factor is calculated directly in double precision, so there is
+ *    no error accumulation as in the recursive w *= s multiplication.
+ *
+ * \param   p     Pointer to plan to create
+ * \param   n     Number of points (power of 2)
+ * \param   type  Plan type
+ *    \arg  FFT_PLAN_D
+ *    \arg  FFT_PLAN_F
+ *    \arg  FFT_PLAN_I
+ * \return        The size of the plan, or 0 on failure
+ */
+uint32_t fft_plan_create (fft_plan_t *p, uint32_t n, fft_ptype_en type)
+{
+   uint32_t i, m, n_2;
+   double th;
+
+   memset ((void*)p, 0, sizeof (fft_plan_t));
+   if (n == 0 || (n & (n-1)) != 0)
+      return 0;   // Not a power of 2
+
+   n_2 = (n>1) ? n>>1 : 1;
+   if ( (p->rev = (uint32_t*)calloc (n, sizeof (uint32_t))) == NULL ||
+        (p->w = calloc (n_2, (type == FFT_PLAN_D) ? sizeof (complex_d_t) : sizeof (complex_f_t))) == NULL ) {
+      fft_plan_destroy (p);
+      return 0;
+   }
+
+   // Bit reversal permutation
+   m = _log2 (n);
+   for (i=1 ; i<n ; ++i)
+      p->rev[i] = (p->rev[i>>1] >> 1) | ((i & 1) << (m-1));
+
+   // Twiddle factors
+   for (i=0 ; i<(n>>1) ; ++i) {
+      th = M_2PI*i/n;
+      if (type == FFT_PLAN_D) {
+         real (((complex_d_t*)p->w)[i]) = cos (th);
+         imag (((complex_d_t*)p->w)[i]) = -sin (th);
+      }
+      else {
+         realf (((complex_f_t*)p->w)[i]) = (float)cos (th);
+         imagf (((complex_f_t*)p->w)[i]) = (float)-sin (th);
+      }
+   }
+   p->type = type;
+   return p->n = n;
+}
+
+/*!
+ * \brief
+ *    Destroy a FFT plan and free its tables.
+ *
+ * \param   p     Pointer to plan to destroy
+ * \return        None
+ */
+void fft_plan_destroy (fft_plan_t *p)
+{
+   if (p->rev)    free ((void*)p->rev);
+   if (p->w)      free (p->w);
+   memset ((void*)p, 0, sizeof (fft_plan_t));
+}
+
+/*!
+ * \brief
+ *    Return a plan of size n from the plan cache used by the fft_xx() entry
+ *    points. If there is no such plan, a new one replaces the oldest entry.
+ * \note
+ *    With FFT_PLAN_CACHE_TLS each thread has its own cache, so the fft_xx()
+ *    entry points are reentrant between threads. Without it the cache is
+ *    shared, and users that transform from more than one thread or from
+ *    interrupts should create their own plans.
+ *
+ * \param   n     Number of points (power of 2)
+ * \param   type  Plan type
+ * \return        Pointer to the plan, or NULL on failure
+ */
+fft_plan_t* fft_plan_get (uint32_t n, fft_ptype_en type)
+{
+   fft_plan_t *p;
+   uint32_t i;
+
+   for (i=0 ; i<FFT_PLAN_CACHE_SIZE ; ++i) {
+      if (_plan_cache[i].n == n && _plan_cache[i].type == type && n) {
+         // Never let the last used plan be the next victim
+         if (i == _plan_victim)
+            _plan_victim = (_plan_victim + 1) % FFT_PLAN_CACHE_SIZE;
+         return &_plan_cache[i];
+      }
+   }
+   p = &_plan_cache[_plan_victim];
+   _plan_victim = (_plan_victim + 1) % FFT_PLAN_CACHE_SIZE;
+
+   fft_plan_destroy (p);
+   return (fft_plan_create (p, n, type)) ? p : NULL;
+}
+
+/*!
+ * \brief
+ *    Destroy all the cached plans and free their memory. With
+ *    FFT_PLAN_CACHE_TLS this is the cache of the calling thread, so each
+ *    thread should flush its cache before it exits.
+ * \return        None
+ */
+void fft_plan_flush (void)
+{
+   uint32_t i;
+   for (i=0 ; i<FFT_PLAN_CACHE_SIZE ; ++i)
+      fft_plan_destroy (&_plan_cache[i]);
+   _plan_victim = 0;
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision complex FFT using the plan p.
+ *    Both in-place and not in-place calls are valid.
+ *
+ * \param   p     Pointer to a FFT_PLAN_D plan
+ * \param   x     Pointer to size p->n time domain complex array
+ * \param   X     Pointer to size p->n frequency domain complex array
+ * \return        None
+ */
+void fft_plan_execute_c (fft_plan_t *p, complex_d_t *x, complex_d_t *X) {
+   _bit_reverse_pc (x, X, p->rev, p->n);
+   _fft_stages_pc (X, (complex_d_t*)p->w, p->n, 0);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision complex FFT using the plan p.
+ *    Both in-place and not in-place calls are valid.
+ *
+ * \param   p     Pointer to a FFT_PLAN_F plan
+ * \param   x     Pointer to size p->n time domain complex array
+ * \param   X     Pointer to size p->n frequency domain complex array
+ * \return        None
+ */
+void fft_plan_execute_cf (fft_plan_t *p, complex_f_t *x, complex_f_t *X) {
+   _bit_reverse_pcf (x, X, p->rev, p->n);
+   _fft_stages_pcf (X, (complex_f_t*)p->w, p->n, 0);
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision complex FFT for complex integer input
+ *    using the plan p. Both in-place and not in-place calls are valid.
+ *
+ * \param   p     Pointer to a FFT_PLAN_I plan
+ * \param   x     Pointer to size p->n time domain complex array
+ * \param   X     Pointer to size p->n frequency domain complex array
+ * \return        None
+ */
+void fft_plan_execute_ci (fft_plan_t *p, complex_i_t *x, complex_f_t *X) {
+   _bit_reverse_pci (x, X, p->rev, p->n);
+   _fft_stages_pcf (X, (complex_f_t*)p->w, p->n, 0);
+}
+
+/*!
+ * \brief
+ *    Calculate the double precision inverse complex FFT using the plan p.
+ *    Both in-place and not in-place calls are valid.
+ *
+ * \param   p     Pointer to a FFT_PLAN_D plan
+ * \param   X     Pointer to size p->n frequency domain complex array
+ * \param   x     Pointer to size p->n time domain complex array
+ * \return        None
+ */
+void ifft_plan_execute_c (fft_plan_t *p, complex_d_t *X, complex_d_t *x) {
+   uint32_t i;
+   double _1_n = 1.0/p->n;
+
+   _bit_reverse_pc (X, x, p->rev, p->n);
+   _fft_stages_pc (x, (complex_d_t*)p->w, p->n, 1);
+   for (i=0 ; i<p->n ; ++i)
+      x[i] *= _1_n;
+}
+
+/*!
+ * \brief
+ *    Calculate the single precision inverse complex FFT using the plan p.
+ *    Both in-place and not in-place calls are valid.
+ *
+ * \param   p     Pointer to a FFT_PLAN_F plan
+ * \param   X     Pointer to size p->n frequency domain complex array
+ * \param   x     Pointer to size p->n time domain complex array
+ * \return        None
+ */
+void ifft_plan_execute_cf (fft_plan_t *p, complex_f_t *X, complex_f_t *x) {
+   uint32_t i;
+   float _1_n = 1.0f/p->n;
+
+   _bit_reverse_pcf (X, x, p->rev, p->n);
+   _fft_stages_pcf (x, (complex_f_t*)p->w, p->n, 1);
+   for (i=0 ; i<p->n ; ++i)
+      x[i] *= _1_n;
+}
+
 /*!
  * \brief
  *    The main body of fft frequency domain synthesis algorithm
@@ -210,7 +742,12 @@ static void _bit_reverse_ci (complex_i_t *x, complex_f_t *r, uint32_t n) {
  * \return        None
  */
 void fft_c (complex_d_t *x, complex_d_t *X, uint32_t n) {
-   _fft_body (complex_d_t, _bit_reverse_c);
+   fft_plan_t *p;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_D)) != NULL)
+      fft_plan_execute_c (p, x, X);
+   else
+      _fft_body (complex_d_t, _bit_reverse_c);
 }
 
 /*!
@@ -229,7 +766,12 @@ void fft_c (complex_d_t *x, complex_d_t *X, uint32_t n) {
  * \return        None
  */
 void fft_cf (complex_f_t *x, complex_f_t *X, uint32_t n) {
-   _fft_body (complex_f_t, _bit_reverse_cf);
+   fft_plan_t *p;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_F)) != NULL)
+      fft_plan_execute_cf (p, x, X);
+   else
+      _fft_body (complex_f_t, _bit_reverse_cf);
 }
 
 /*!
@@ -248,7 +790,12 @@ void fft_cf (complex_f_t *x, complex_f_t *X, uint32_t n) {
  * \return        None
  */
 void fft_ci (complex_i_t *x, complex_f_t *X, uint32_t n) {
-   _fft_body (complex_f_t, _bit_reverse_ci);
+   fft_plan_t *p;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_I)) != NULL)
+      fft_plan_execute_ci (p, x, X);
+   else
+      _fft_body (complex_f_t, _bit_reverse_ci);
 }
 
 /*!
@@ -257,11 +804,9 @@ void fft_ci (complex_i_t *x, complex_f_t *X, uint32_t n) {
  *
  *    The algorithm use the even/odd decomposition. The signal, placed in the real part
  *    of the time domain used as an complex stream. The even points as the real part and the
- *    odd points as imaginary part. After calculating the complex DFT (via the FFT, of course),
- *    the spectra are separated using the even/odd decomposition. When two or more signals
- *    need to be passed through the FFT, this technique reduces the execution time by about 35%.
- *    The improvement isn't a full factor of two because of the calculation time
- *    required for the even/odd decomposition.
+ *    odd points as imaginary part. After calculating the n/2 points complex DFT (via the FFT,
+ *    of course), the spectra are separated with a single post-processing pass using the
+ *    twiddle factors of the size n plan. So the work is about the half of a n points complex FFT.
  *
  *    This algorithm use an altered in place technique with two different
  *    pointers for time and frequency. Hence the user can use it both
@@ -276,7 +821,15 @@ void fft_ci (complex_i_t *x, complex_f_t *X, uint32_t n) {
  * \return        None
  */
 void fft_r (double *x, complex_d_t *X, uint32_t n) {
-   _fft_r_body (complex_d_t, complex_d_t, fft_c, real, imag);
+   fft_plan_t *p, *h;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_D)) != NULL &&
+       (h = fft_plan_get (n>>1, FFT_PLAN_D)) != NULL) {
+      fft_plan_execute_c (h, (complex_d_t*)x, X);
+      _fft_r_post_pc (X, (complex_d_t*)p->w, n);
+   }
+   else
+      _fft_r_body (complex_d_t, complex_d_t, fft_c, real, imag);
 }
 
 /*!
@@ -285,11 +838,9 @@ void fft_r (double *x, complex_d_t *X, uint32_t n) {
  *
  *    The algorithm use the even/odd decomposition. The signal, placed in the real part
  *    of the time domain used as an complex stream. The even points as the real part and the
- *    odd points as imaginary part. After calculating the complex DFT (via the FFT, of course),
- *    the spectra are separated using the even/odd decomposition. When two or more signals
- *    need to be passed through the FFT, this technique reduces the execution time by about 35%.
- *    The improvement isn't a full factor of two because of the calculation time
- *    required for the even/odd decomposition.
+ *    odd points as imaginary part. After calculating the n/2 points complex DFT (via the FFT,
+ *    of course), the spectra are separated with a single post-processing pass using the
+ *    twiddle factors of the size n plan. So the work is about the half of a n points complex FFT.
  *
  *    This algorithm use an altered in place technique with two different
  *    pointers for time and frequency. Hence the user can use it both
@@ -304,7 +855,15 @@ void fft_r (double *x, complex_d_t *X, uint32_t n) {
  * \return        None
  */
 void fft_rf (float *x, complex_f_t *X, uint32_t n) {
-   _fft_r_body (complex_f_t, complex_f_t, fft_cf, realf, imagf);
+   fft_plan_t *p, *h;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_F)) != NULL &&
+       (h = fft_plan_get (n>>1, FFT_PLAN_F)) != NULL) {
+      fft_plan_execute_cf (h, (complex_f_t*)x, X);
+      _fft_r_post_pcf (X, (complex_f_t*)p->w, n);
+   }
+   else
+      _fft_r_body (complex_f_t, complex_f_t, fft_cf, realf, imagf);
 }
 
 /*!
@@ -313,11 +872,9 @@ void fft_rf (float *x, complex_f_t *X, uint32_t n) {
  *
  *    The algorithm use the even/odd decomposition. The signal, placed in the real part
  *    of the time domain used as an complex stream. The even points as the real part and the
- *    odd points as imaginary part. After calculating the complex DFT (via the FFT, of course),
- *    the spectra are separated using the even/odd decomposition. When two or more signals
- *    need to be passed through the FFT, this technique reduces the execution time by about 35%.
- *    The improvement isn't a full factor of two because of the calculation time
- *    required for the even/odd decomposition.
+ *    odd points as imaginary part. After calculating the n/2 points complex DFT (via the FFT,
+ *    of course), the spectra are separated with a single post-processing pass using the
+ *    twiddle factors of the size n plan. So the work is about the half of a n points complex FFT.
  *
  *    This algorithm use an altered in place technique with two different
  *    pointers for time and frequency. Hence the user can use it both
@@ -332,7 +889,15 @@ void fft_rf (float *x, complex_f_t *X, uint32_t n) {
  * \return        None
  */
 void fft_ri (int *x, complex_f_t *X, uint32_t n) {
-   _fft_r_body (complex_i_t, complex_f_t, fft_ci, realf, imagf);
+   fft_plan_t *p, *h;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_I)) != NULL &&
+       (h = fft_plan_get (n>>1, FFT_PLAN_I)) != NULL) {
+      fft_plan_execute_ci (h, (complex_i_t*)x, X);
+      _fft_r_post_pcf (X, (complex_f_t*)p->w, n);
+   }
+   else
+      _fft_r_body (complex_i_t, complex_f_t, fft_ci, realf, imagf);
 }
 
 /*!
@@ -399,7 +964,12 @@ void fft_ri (int *x, complex_f_t *X, uint32_t n) {
  * \return        None
  */
 void ifft_c (complex_d_t *X, complex_d_t *x, uint32_t n) {
-   _ifft_body (complex_d_t, _bit_reverse_c, imag, conj);
+   fft_plan_t *p;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_D)) != NULL)
+      ifft_plan_execute_c (p, X, x);
+   else
+      _ifft_body (complex_d_t, _bit_reverse_c, imag, conj);
 }
 
 /*
@@ -418,17 +988,22 @@ void ifft_c (complex_d_t *X, complex_d_t *x, uint32_t n) {
  * \return        None
  */
 void ifft_cf (complex_f_t *X, complex_f_t *x, uint32_t n) {
-   _ifft_body (complex_f_t, _bit_reverse_cf, imagf, conjf);
+   fft_plan_t *p;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_F)) != NULL)
+      ifft_plan_execute_cf (p, X, x);
+   else
+      _ifft_body (complex_f_t, _bit_reverse_cf, imagf, conjf);
 }
 
 /*!
  * \brief
  *    Calculate the double precision inverse FFT for real signal, using complex FFT
  *
- *    The algorithm use the even/odd decomposition. The signal, placed in the frequency domain
- *    is used as an real stream by combining the real and imaginary parts. After calculating the
- *    real inverse DFT (via the iFFT, of course), the spectra must combine again and scaled by n.
- *    This technique reduces the execution time by about 35%.
+ *    The algorithm use the even/odd decomposition in reverse. The hermitian spectrum is packed
+ *    to the n/2 points spectrum of the complex signal with the even points as the real part and
+ *    the odd points as imaginary part. After calculating the n/2 points complex iFFT the time
+ *    domain signal is already in place. Only the first n/2+1 frequency points are used.
  *
  *    This algorithm use an altered in place technique with two different
  *    pointers for time and frequency. Hence the user can use it both
@@ -447,17 +1022,28 @@ void ifft_cf (complex_f_t *X, complex_f_t *x, uint32_t n) {
  * \return        None
  */
 void ifft_r (complex_d_t *X, double *x, uint32_t n) {
-   _ifft_r_body (complex_d_t, fft_r, real, imag);
+   fft_plan_t *p, *h;
+   uint32_t i;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_D)) != NULL &&
+       (h = fft_plan_get (n>>1, FFT_PLAN_D)) != NULL) {
+      _ifft_r_pre_pc (X, (complex_d_t*)x, (complex_d_t*)p->w, n);
+      ifft_plan_execute_c (h, (complex_d_t*)x, (complex_d_t*)x);
+      for (i=n ; i<2*n ; ++i)
+         x[i] = 0;
+   }
+   else
+      _ifft_r_body (complex_d_t, fft_r, real, imag);
 }
 
 /*!
  * \brief
  *    Calculate the single precision inverse FFT for real signal, using complex FFT
  *
- *    The algorithm use the even/odd decomposition. The signal, placed in the frequency domain
- *    is used as an real stream by combining the real and imaginary parts. After calculating the
- *    real inverse DFT (via the iFFT, of course), the spectra must combine again and scaled by n.
- *    This technique reduces the execution time by about 35%.
+ *    The algorithm use the even/odd decomposition in reverse. The hermitian spectrum is packed
+ *    to the n/2 points spectrum of the complex signal with the even points as the real part and
+ *    the odd points as imaginary part. After calculating the n/2 points complex iFFT the time
+ *    domain signal is already in place. Only the first n/2+1 frequency points are used.
  *
  *    This algorithm use an altered in place technique with two different
  *    pointers for time and frequency. Hence the user can use it both
@@ -476,6 +1062,17 @@ void ifft_r (complex_d_t *X, double *x, uint32_t n) {
  * \return        None
  */
 void ifft_rf (complex_f_t *X, float *x, uint32_t n) {
-   _ifft_r_body (complex_f_t, fft_rf, realf, imagf);
+   fft_plan_t *p, *h;
+   uint32_t i;
+
+   if ((p = fft_plan_get (n, FFT_PLAN_F)) != NULL &&
+       (h = fft_plan_get (n>>1, FFT_PLAN_F)) != NULL) {
+      _ifft_r_pre_pcf (X, (complex_f_t*)x, (complex_f_t*)p->w, n);
+      ifft_plan_execute_cf (h, (complex_f_t*)x, (complex_f_t*)x);
+      for (i=n ; i<2*n ; ++i)
+         x[i] = 0;
+   }
+   else
+      _ifft_r_body (complex_f_t, fft_rf, realf, imagf);
 }
 
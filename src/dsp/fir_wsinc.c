@@ -135,6 +135,140 @@ static void _2tran_loop (fir_wsinc_t *f, int sign) {
    f->k[n_2] += (sign==-1) ? 1:0;
 }
 
+/*!
+ * \brief
+ *    Direct form dot product of the kernel with the last T samples.
+ *    The delay line is mirrored, dl[i] == dl[i+T], so the newest T samples
+ *    are contiguous from dl[di] and no wrap is needed in the inner loop.
+ */
+#define _df_body(_type, _d, _h, _T, _i) {    \
+   _type a0=0, a1=0, a2=0, a3=0;             \
+   uint32_t k;                               \
+   for (k=0 ; k+4<=(_T) ; k+=4) {            \
+      a0 += (_h)[k]   * (_d)[(_i)+k];        \
+      a1 += (_h)[k+1] * (_d)[(_i)+k+1];      \
+      a2 += (_h)[k+2] * (_d)[(_i)+k+2];      \
+      a3 += (_h)[k+3] * (_d)[(_i)+k+3];      \
+   }                                         \
+   for ( ; k<(_T) ; ++k)                     \
+      a0 += (_h)[k] * (_d)[(_i)+k];          \
+   return (a0 + a1) + (a2 + a3);             \
+}
+
+static double _df_d (fir_wsinc_t *f, double in) __O3__ ;
+static complex_d_t _df_cd (fir_wsinc_t *f, complex_d_t in) __O3__ ;
+
+static double _df_d (fir_wsinc_t *f, double in) {
+   double *d = (double*)f->dl;
+
+   f->di = (f->di) ? f->di-1 : f->T-1;
+   d[f->di] = d[f->di + f->T] = in;
+   _df_body (double, d, f->h, f->T, f->di);
+}
+
+static complex_d_t _df_cd (fir_wsinc_t *f, complex_d_t in) {
+   complex_d_t *d = f->dl;
+
+   f->di = (f->di) ? f->di-1 : f->T-1;
+   d[f->di] = d[f->di + f->T] = in;
+   _df_body (complex_d_t, d, f->h, f->T, f->di);
+}
+
+/*!
+ * \brief
+ *    Y += X .* H for the first n points
+ */
+static void _cmac (complex_d_t *Y, const complex_d_t *X, const complex_d_t *H, uint32_t n) __O3__ __SIMD__ ;
+static void _cmac (complex_d_t *Y, const complex_d_t *X, const complex_d_t *H, uint32_t n) {
+   uint32_t i;
+   for (i=0 ; i<n ; ++i)
+      Y[i] += X[i] * H[i];
+}
+
+/*!
+ * \brief
+ *    Uniformly partitioned overlap-save convolution.
+ *    Each output point has a fixed latency of B samples. A block is
+ *    calculated every time B input samples are gathered, with one forward
+ *    and one inverse FFT of 2B points and P spectrum multiply-accumulates.
+ */
+static void _upols (fir_wsinc_t *f, const double *x, double *y, uint32_t n)
+{
+   uint32_t i, k, p, B = f->B, B2 = 2*f->B;
+   complex_d_t *X;
+   double *a = (double*)f->A;
+
+   for (i=0 ; i<n ; i+=k) {
+      // Samples until the end of the current block
+      k = B - f->cnt;
+      if (k > n - i)
+         k = n - i;
+      memcpy ((void*)&f->s[B + f->cnt], (const void*)&x[i], k*sizeof (double));
+      memcpy ((void*)&y[i], (void*)&f->o[f->cnt], k*sizeof (double));
+
+      if ((f->cnt += k) >= B) {
+         // Transform the new segment into the frequency delay line
+         f->xi = (f->xi + 1) % f->P;
+         X = &f->X[f->xi * B2];
+         memcpy ((void*)X, (void*)f->s, B2*sizeof (double));
+         fft_r ((double*)X, X, B2);
+
+         // Partition p of the kernel meets the segment of p blocks ago
+         memset ((void*)f->A, 0, B2*sizeof (complex_d_t));
+         for (p=0 ; p<f->P ; ++p)
+            _cmac (f->A, &f->X[((f->xi + f->P - p) % f->P) * B2], &f->H[p * B2], B+1);
+         for (p=1 ; p<B ; ++p)   // Hermitian half
+            f->A[B2 - p] = conj (f->A[p]);
+         ifft_r (f->A, a, B2);
+
+         // Keep the valid part and the new block as the history
+         memcpy ((void*)f->o, (void*)&a[B], B*sizeof (double));
+         memcpy ((void*)f->s, (void*)&f->s[B], B*sizeof (double));
+         f->cnt = 0;
+      }
+   }
+}
+
+/*!
+ * \brief
+ *    Allocate and prepare the streaming engine from the kernel spectrum
+ */
+static int _stream_init (fir_wsinc_t *f)
+{
+   uint32_t p, B2, n;
+
+   if ((f->h = (double*)calloc (f->T, sizeof (double))) == NULL ||
+       (f->dl = (complex_d_t*)calloc (2*f->T, sizeof (complex_d_t))) == NULL)
+      return 0;
+
+   // Time domain kernel, after the cascade
+   memcpy ((void*)f->t, (void*)f->k, f->N*sizeof (complex_d_t));
+   ifft_r ((complex_d_t*)f->t, f->t, f->N);
+   memcpy ((void*)f->h, (void*)f->t, f->T*sizeof (double));
+
+   if (f->T <= FIR_WSINC_DF_TAPS) {
+      f->B = f->P = 0;
+      return 1;
+   }
+   f->B = FIR_WSINC_PART_SIZE;
+   f->P = (f->T + f->B - 1) / f->B;
+   B2 = 2*f->B;
+   if ((f->s = (double*)calloc (B2, sizeof (double))) == NULL ||
+       (f->o = (double*)calloc (f->B, sizeof (double))) == NULL ||
+       (f->A = (complex_d_t*)calloc (B2, sizeof (complex_d_t))) == NULL ||
+       (f->X = (complex_d_t*)calloc (f->P*B2, sizeof (complex_d_t))) == NULL ||
+       (f->H = (complex_d_t*)calloc (f->P*B2, sizeof (complex_d_t))) == NULL)
+      return 0;
+
+   // Partition spectra
+   for (p=0 ; p<f->P ; ++p) {
+      n = (f->T - p*f->B < f->B) ? f->T - p*f->B : f->B;
+      memcpy ((void*)&f->H[p*B2], (void*)&f->h[p*f->B], n*sizeof (double));
+      fft_r ((double*)&f->H[p*B2], &f->H[p*B2], B2);
+   }
+   return 1;
+}
+
 /*
  * =================== Public API =====================
  */
@@ -277,8 +411,15 @@ void fir_wsic_set_cascade (fir_wsinc_t *f, uint32_t c) {
  * \return none
 */
 void fir_wsinc_deinit (fir_wsinc_t* f) {
-   if ( f->k )
-      free ((void*)f->k);
+   if (f->k)   free ((void*)f->k);
+   if (f->t)   free ((void*)f->t);
+   if (f->h)   free ((void*)f->h);
+   if (f->dl)  free ((void*)f->dl);
+   if (f->s)   free ((void*)f->s);
+   if (f->o)   free ((void*)f->o);
+   if (f->A)   free ((void*)f->A);
+   if (f->X)   free ((void*)f->X);
+   if (f->H)   free ((void*)f->H);
    memset ((void*)f, 0, sizeof (fir_wsinc_t));
 }
 
@@ -325,14 +466,105 @@ uint32_t fir_wsinc_init (fir_wsinc_t* f)
       // Go to Frequency domain
       fft_r (f->k, (complex_d_t*)f->k, f->N);
 
-      // Cascade filters
+      // Cascade filters, one stage spectrum per step
+      memcpy ((void*)f->t, (void*)f->k, f->N*sizeof (complex_d_t));
       for (i=1 ; i<f->casc ; ++i)
-         vemul_cd ((complex_d_t*)f->k, (complex_d_t*)f->k, (complex_d_t*)f->k, f->N);
+         vemul_cd ((complex_d_t*)f->k, (complex_d_t*)f->k, (complex_d_t*)f->t, f->N);
+
+      if (_stream_init (f))
+         return f->N;
+   }
+   return 0;
+}
 
-      return f->N;
+/*!
+ * \brief
+ *    Clear the streaming engine's history.
+ *
+ * \param  f      Which filter to use
+ * \return        None
+ */
+void fir_wsinc_reset (fir_wsinc_t* f)
+{
+   memset ((void*)f->dl, 0, 2*f->T*sizeof (complex_d_t));
+   f->di = f->cnt = f->xi = 0;
+   if (f->B) {
+      memset ((void*)f->s, 0, 2*f->B*sizeof (double));
+      memset ((void*)f->o, 0, f->B*sizeof (double));
+      memset ((void*)f->X, 0, f->P*2*f->B*sizeof (complex_d_t));
    }
+}
+
+/*!
+ * \brief
+ *    Streaming filter of a block of n samples of any length.
+ *    Kernels up to FIR_WSINC_DF_TAPS run in direct form without latency.
+ *    Longer kernels run in the frequency domain with a fixed latency of
+ *    FIR_WSINC_PART_SIZE samples, so
+ *
+ *   out[k] = (h * in)[k - FIR_WSINC_PART_SIZE]
+ *
+ * \note
+ *    The filter keeps its history between calls, so a stream can be fed in
+ *    blocks of any size. A filter instance serves one stream.
+ *
+ * \param  f      Which filter to use
+ * \param  in     Pointer to input samples
+ * \param  out    Pointer to output samples. Can be the same as in
+ * \param  n      Number of samples
+ * \return        None
+ */
+void fir_wsinc_block (fir_wsinc_t *f, const double *in, double *out, uint32_t n)
+{
+   uint32_t i;
+
+   if (f->B)
+      _upols (f, in, out, n);
    else
-      return 0;
+      for (i=0 ; i<n ; ++i)
+         out[i] = _df_d (f, in[i]);
+}
+
+/*!
+ * \brief
+ *    Streaming filter of one sample. \sa fir_wsinc_block() for the latency.
+ *
+ * \param  f      Which filter to use
+ * \param  in     The input sample
+ * \return        The filtered sample
+ */
+double fir_wsinc_d (fir_wsinc_t* f, double in) {
+   double out;
+
+   if (!f->B)
+      return _df_d (f, in);
+   _upols (f, &in, &out, 1);
+   return out;
+}
+float fir_wsinc_f (fir_wsinc_t* f, float in) {
+   return (float)fir_wsinc_d (f, (double)in);
+}
+float fir_wsinc_i (fir_wsinc_t* f, int in) {
+   return (float)fir_wsinc_d (f, (double)in);
+}
+
+/*!
+ * \brief
+ *    Streaming filter of one complex sample. The complex streams always
+ *    run in direct form, without latency.
+ *
+ * \param  f      Which filter to use
+ * \param  in     The input sample
+ * \return        The filtered sample
+ */
+complex_d_t fir_wsinc_cd (fir_wsinc_t* f, complex_d_t in) {
+   return _df_cd (f, in);
+}
+complex_f_t fir_wsinc_cf (fir_wsinc_t* f, complex_f_t in) {
+   return (complex_f_t)_df_cd (f, (complex_d_t)in);
+}
+complex_f_t fir_wsinc_ci (fir_wsinc_t* f, complex_i_t in) {
+   return (complex_f_t)_df_cd (f, (complex_d_t)in);
 }
 
 
@@ -22,6 +22,146 @@
  *
  */
 #include <dsp/vectors.h>
+#include <string.h>
+
+/*
+ * ================== Static ====================
+ */
+
+#if defined(__GNUC__)
+/*
+ * Generic vector types. The compiler maps them to the target's SIMD
+ * registers (SSE2/AVX2/NEON), or splits them in scalar operations.
+ */
+typedef float  _v8f_t __attribute__ ((vector_size (32)));
+typedef double _v4d_t __attribute__ ((vector_size (32)));
+
+/*!
+ * Unaligned vector load. Compiles to a single unaligned move.
+ */
+#define _vload(_v, _p)     memcpy ((void*)&(_v), (const void*)(_p), sizeof (_v))
+
+/*!
+ * Exchange the neighbour lanes, {re,im} -> {im,re}
+ */
+#if defined(__clang__)
+#define _vswap_8f(_v)      __builtin_shufflevector ((_v), (_v), 1, 0, 3, 2, 5, 4, 7, 6)
+#define _vswap_4d(_v)      __builtin_shufflevector ((_v), (_v), 1, 0, 3, 2)
+#else
+typedef int32_t _v8i_t __attribute__ ((vector_size (32)));
+typedef int64_t _v4i_t __attribute__ ((vector_size (32)));
+#define _vswap_8f(_v)      __builtin_shuffle ((_v), (_v8i_t){1, 0, 3, 2, 5, 4, 7, 6})
+#define _vswap_4d(_v)      __builtin_shuffle ((_v), (_v4i_t){1, 0, 3, 2})
+#endif
+#define _VEC_SIMD
+#endif
+
+/*!
+ * \brief
+ *    Complex element-wise multiplication body on split real/imaginary parts.
+ *    It avoids the C99 Annex G complex multiplication call, so the loop can
+ *    be vectorised.
+ */
+#define  _vemul_body_c(_r, _i) {                               \
+   int i;                                                      \
+   for (i=0 ; i<length ; ++i) {                                \
+      ar = _r(a[i]); ai = _i(a[i]);                            \
+      br = _r(b[i]); bi = _i(b[i]);                            \
+      _r(y[i]) = ar*br - ai*bi;                                \
+      _i(y[i]) = ar*bi + ai*br;                                \
+   }                                                           \
+}
+
+/*!
+ * \brief
+ *    Complex element-wise division body on split real/imaginary parts.
+ *    It uses Smith's scaled division, the divisor is scaled by its larger
+ *    part, so |b|^2 does not overflow or underflow where a/b does not.
+ */
+#define  _vediv_body_cc(_r, _i, _abs) {                        \
+   int i;                                                      \
+   for (i=0 ; i<length ; ++i)                                  \
+      if (_r(b[i]) == 0 && _i(b[i]) == 0)                      \
+         return 1;                                             \
+   for (i=0 ; i<length ; ++i) {                                \
+      ar = _r(a[i]); ai = _i(a[i]);                            \
+      br = _r(b[i]); bi = _i(b[i]);                            \
+      if (_abs (br) >= _abs (bi)) {                            \
+         r = bi / br;                                          \
+         d = br + bi*r;                                        \
+         _r(y[i]) = (ar + ai*r) / d;                           \
+         _i(y[i]) = (ai - ar*r) / d;                           \
+      }                                                        \
+      else {                                                   \
+         r = br / bi;                                          \
+         d = bi + br*r;                                        \
+         _r(y[i]) = (ar*r + ai) / d;                           \
+         _i(y[i]) = (ai*r - ar) / d;                           \
+      }                                                        \
+   }                                                           \
+   return 0;                                                   \
+}
+
+/*!
+ * \brief
+ *    Vector dot product body for real numbers. It uses a vector accumulator
+ *    for the main part and scalar code for the unaligned tail.
+ * \param   _vt   The vector type
+ * \param   _w    Number of lanes
+ */
+#define  _vdot_body_vr(_vt, _w) {                              \
+   _vt va, vb, acc = {0};                                      \
+   int i, k;                                                   \
+                                                               \
+   for (i=0 ; i+(_w)<=length ; i+=(_w)) {                      \
+      _vload (va, &a[i]);                                      \
+      _vload (vb, &b[i]);                                      \
+      acc += va * vb;                                          \
+   }                                                           \
+   for (res=0, k=0 ; k<(_w) ; ++k)                             \
+      res += acc[k];                                           \
+   for ( ; i<length ; ++i)                                     \
+      res += a[i] * b[i];                                      \
+   return res;                                                 \
+}
+
+/*!
+ * \brief
+ *    Vector dot product body for complex numbers on interleaved data.
+ *    The real part accumulates a.*b and the imaginary part accumulates
+ *    a.*swap(b), where swap exchanges real and imaginary parts.
+ *
+ *    Re = Sum (ar*br + ai*bi),  Im = Sum (ar*bi - ai*br)
+ *
+ * \param   _vt   The vector type
+ * \param   _st   The scalar type
+ * \param   _w    Number of scalar lanes (even)
+ * \param   _swp  Real/imaginary swap macro for the vector type
+ */
+#define  _vdot_body_vc(_vt, _st, _w, _swp, _r, _i) {            \
+   _vt va, vb, acc_r = {0}, acc_i = {0};                       \
+   const _st *pa = (const _st*)a, *pb = (const _st*)b;         \
+   _st rr=0, ri=0;                                             \
+   int i, k, n = 2*length;                                     \
+                                                               \
+   for (i=0 ; i+(_w)<=n ; i+=(_w)) {                           \
+      _vload (va, &pa[i]);                                     \
+      _vload (vb, &pb[i]);                                     \
+      acc_r += va * vb;                                        \
+      acc_i += va * _swp (vb);                                 \
+   }                                                           \
+   for (k=0 ; k<(_w) ; k+=2) {                                 \
+      rr += acc_r[k] + acc_r[k+1];                             \
+      ri += acc_i[k] - acc_i[k+1];                             \
+   }                                                           \
+   for (i>>=1 ; i<length ; ++i) {                              \
+      rr += _r(a[i])*_r(b[i]) + _i(a[i])*_i(b[i]);             \
+      ri += _r(a[i])*_i(b[i]) - _i(a[i])*_r(b[i]);             \
+   }                                                           \
+   _r(res) = rr;                                               \
+   _i(res) = ri;                                               \
+   return res;                                                 \
+}
 
 /*
  * ================== Public API ====================
@@ -33,6 +173,10 @@
  *
  *   y[n] = a[n] + b[n]
  *
+ * \note
+ *    The complex versions run the real kernel on the interleaved
+ *    real/imaginary parts.
+ *
  * \param      y  Pointer to output vector
  * \param      a  Pointer to target vector a
  * \param      b  Pointer to target vector b
@@ -41,18 +185,25 @@
  * \return none
  */
 #define  _vadd_body() {                                        \
+   int i;                                                      \
    /* Calculate vadd */                                        \
-   for (--length ; length>=0 ; --length) {                     \
-      y[length] = a[length] + b[length];                       \
+   for (i=0 ; i<length ; ++i) {                                \
+      y[i] = a[i] + b[i];                                      \
    }                                                           \
 }
-void vadd_i32 (int32_t *y, int32_t *a, int32_t *b, int length) { _vadd_body(); }
-void vadd_ui32 (uint32_t *y, uint32_t *a, uint32_t *b, int length) { _vadd_body(); }
-void vadd_f (float *y, float *a, float *b, int length) {_vadd_body(); }
-void vadd_d (double *y, double *a, double *b, int length) { _vadd_body(); }
-void vadd_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vadd_body(); }
-void vadd_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vadd_body(); }
-void vadd_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vadd_body(); }
+__SIMD__ void vadd_i32 (int32_t *y, int32_t *a, int32_t *b, int length) { _vadd_body(); }
+__SIMD__ void vadd_ui32 (uint32_t *y, uint32_t *a, uint32_t *b, int length) { _vadd_body(); }
+__SIMD__ void vadd_f (float *y, float *a, float *b, int length) {_vadd_body(); }
+__SIMD__ void vadd_d (double *y, double *a, double *b, int length) { _vadd_body(); }
+void vadd_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) {
+   vadd_i32 ((int32_t*)y, (int32_t*)a, (int32_t*)b, 2*length);
+}
+void vadd_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) {
+   vadd_f ((float*)y, (float*)a, (float*)b, 2*length);
+}
+void vadd_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) {
+   vadd_d ((double*)y, (double*)a, (double*)b, 2*length);
+}
 #undef _vadd_body
 
 /*!
@@ -61,6 +212,10 @@ void vadd_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vad
  *
  *   y[n] = a[n] - b[n]
  *
+ * \note
+ *    The complex versions run the real kernel on the interleaved
+ *    real/imaginary parts.
+ *
  * \param      y  Pointer to output vector
  * \param      a  Pointer to target vector a
  * \param      b  Pointer to target vector b
@@ -69,18 +224,25 @@ void vadd_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vad
  * \return none
  */
 #define  _vsub_body() {                                        \
+   int i;                                                      \
    /* Calculate vsub */                                        \
-   for (--length ; length>=0 ; --length) {                     \
-      y[length] = a[length] - b[length];                       \
+   for (i=0 ; i<length ; ++i) {                                \
+      y[i] = a[i] - b[i];                                      \
    }                                                           \
 }
-void vsub_i32 (int32_t *y, int32_t *a, int32_t *b, int length) { _vsub_body(); }
-void vsub_ui32 (uint32_t *y, uint32_t *a, uint32_t *b, int length) { _vsub_body(); }
-void vsub_f (float *y, float *a, float *b, int length) { _vsub_body(); }
-void vsub_d (double *y, double *a, double *b, int length) { _vsub_body(); }
-void vsub_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vsub_body(); }
-void vsub_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vsub_body(); }
-void vsub_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vsub_body(); }
+__SIMD__ void vsub_i32 (int32_t *y, int32_t *a, int32_t *b, int length) { _vsub_body(); }
+__SIMD__ void vsub_ui32 (uint32_t *y, uint32_t *a, uint32_t *b, int length) { _vsub_body(); }
+__SIMD__ void vsub_f (float *y, float *a, float *b, int length) { _vsub_body(); }
+__SIMD__ void vsub_d (double *y, double *a, double *b, int length) { _vsub_body(); }
+void vsub_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) {
+   vsub_i32 ((int32_t*)y, (int32_t*)a, (int32_t*)b, 2*length);
+}
+void vsub_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) {
+   vsub_f ((float*)y, (float*)a, (float*)b, 2*length);
+}
+void vsub_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) {
+   vsub_d ((double*)y, (double*)a, (double*)b, 2*length);
+}
 #undef _vsub_body
 
 
@@ -98,18 +260,29 @@ void vsub_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vsu
  * \return none
  */
 #define  _vemul_body() {                                       \
-   /* Calculate vadd */                                        \
-   for (--length ; length>=0 ; --length) {                     \
-      y[length] = a[length] * b[length];                       \
+   int i;                                                      \
+   /* Calculate vemul */                                       \
+   for (i=0 ; i<length ; ++i) {                                \
+      y[i] = a[i] * b[i];                                      \
    }                                                           \
 }
-void vemul_i (int *y, int *a, int *b, int length) { _vemul_body(); }
-void vemul_f (float *y, float *a, float *b, int length) {_vemul_body(); }
-void vemul_d (double *y, double *a, double *b, int length) { _vemul_body(); }
-void vemul_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vemul_body(); }
-void vemul_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vemul_body(); }
-void vemul_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vemul_body(); }
+__SIMD__ void vemul_i (int *y, int *a, int *b, int length) { _vemul_body(); }
+__SIMD__ void vemul_f (float *y, float *a, float *b, int length) {_vemul_body(); }
+__SIMD__ void vemul_d (double *y, double *a, double *b, int length) { _vemul_body(); }
+__SIMD__ void vemul_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) {
+   int ar, ai, br, bi;
+   _vemul_body_c (reali, imagi);
+}
+__SIMD__ void vemul_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) {
+   float ar, ai, br, bi;
+   _vemul_body_c (realf, imagf);
+}
+__SIMD__ void vemul_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) {
+   double ar, ai, br, bi;
+   _vemul_body_c (real, imag);
+}
 #undef _vemul_body
+#undef _vemul_body_c
 
 
 /*!
@@ -118,6 +291,10 @@ void vemul_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _ve
  *
  *   y[n] = a[n] ./ b[n]
  *
+ * \note
+ *    The divisor is checked before the division, so on failure the
+ *    output vector is left untouched.
+ *
  * \param      y  Pointer to output vector
  * \param      a  Pointer to target vector a
  * \param      b  Pointer to target vector b
@@ -128,33 +305,40 @@ void vemul_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _ve
  *    \arg  1  Fail, divide by zero
  */
 #define  _vediv_body_r() {                                     \
-   /* Calculate vadd */                                        \
-   for (--length ; length>=0 ; --length) {                     \
-      if (b[length]!= 0)                                       \
-         y[length] = a[length] / b[length];                    \
-      else                                                     \
+   int i;                                                      \
+   for (i=0 ; i<length ; ++i)                                  \
+      if (b[i] == 0)                                           \
          return 1;                                             \
-   }                                                           \
+   /* Calculate vediv */                                       \
+   for (i=0 ; i<length ; ++i)                                  \
+      y[i] = a[i] / b[i];                                      \
    return 0;                                                   \
 }
 #define  _vediv_body_c() {                                     \
-   /* Calculate vadd */                                        \
-   for (--length ; length>=0 ; --length) {                     \
-      if (b[length]!= 0+I*0)                                   \
-         y[length] = a[length] / b[length];                    \
-      else                                                     \
+   int i;                                                      \
+   for (i=0 ; i<length ; ++i)                                  \
+      if (b[i] == 0+I*0)                                       \
          return 1;                                             \
-   }                                                           \
+   /* Calculate vediv */                                       \
+   for (i=0 ; i<length ; ++i)                                  \
+      y[i] = a[i] / b[i];                                      \
    return 0;                                                   \
 }
 int vediv_i (int *y, int *a, int *b, int length) { _vediv_body_r(); }
-int vediv_f (float *y, float *a, float *b, int length) {_vediv_body_r(); }
-int vediv_d (double *y, double *a, double *b, int length) { _vediv_body_r(); }
+__SIMD__ int vediv_f (float *y, float *a, float *b, int length) {_vediv_body_r(); }
+__SIMD__ int vediv_d (double *y, double *a, double *b, int length) { _vediv_body_r(); }
 int vediv_ci (complex_i_t *y, complex_i_t *a, complex_i_t *b, int length) { _vediv_body_c(); }
-int vediv_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) { _vediv_body_c(); }
-int vediv_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _vediv_body_c(); }
+__SIMD__ int vediv_cf (complex_f_t *y, complex_f_t *a, complex_f_t *b, int length) {
+   float ar, ai, br, bi, r, d;
+   _vediv_body_cc (realf, imagf, fabsf);
+}
+__SIMD__ int vediv_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) {
+   double ar, ai, br, bi, r, d;
+   _vediv_body_cc (real, imag, fabs);
+}
 #undef _vediv_body_r
 #undef _vediv_body_c
+#undef _vediv_body_cc
 
 
 /*!
@@ -165,37 +349,59 @@ int vediv_cd (complex_d_t *y, complex_d_t *a, complex_d_t *b, int length) { _ved
  *   r = <a[n],b[n]> = Sum {a'[m]*b[n]}
  *                     n=0
  *
+ * \note
+ *    The floating point versions use vector accumulators, so the summation
+ *    order, hence the rounding, differs from a sequential sum.
+ *
  * \param      a  Pointer to target vector a
  * \param      b  Pointer to target vector b
  * \param length  Size of vectors
  *
  * \return The dot product of a and b
  */
-#define  _vdot_body_r() {                                      \
-   /* Calculate vdot */                                        \
-   for (res=0,--length ; length>=0 ; --length) {               \
-      res += a[length] * b[length];                            \
+#define  _vdot_body_r(_t) {                                    \
+   int i;                                                      \
+   /* Calculate vdot, the products in the accumulator type */  \
+   for (res=0, i=0 ; i<length ; ++i) {                         \
+      res += (_t)a[i] * b[i];                                  \
    }                                                           \
    return res;                                                 \
 }
 
 #define  _vdot_body_c() {                                      \
+   int i;                                                      \
    /* Calculate vcdot */                                       \
-   for (res=0,--length ; length>=0 ; --length) {               \
-      res += conj(a[length]) * b[length];                      \
+   for (res=0, i=0 ; i<length ; ++i) {                         \
+      res += conj(a[i]) * b[i];                                \
    }                                                           \
    return res;                                                 \
 }
-int64_t vdot_i32 (int32_t *a, int32_t *b, int length) { int64_t res; _vdot_body_r(); }
-uint64_t vdot_ui32 (uint32_t *a, uint32_t *b, int length) { uint64_t res; _vdot_body_r(); }
-float vdot_f (float *a, float *b, int length) {float res;  _vdot_body_r(); }
-double vdot_d (double *a, double *b, int length) { double res; _vdot_body_r(); }
+__SIMD__ int64_t vdot_i32 (int32_t *a, int32_t *b, int length) { int64_t res; _vdot_body_r(int64_t); }
+__SIMD__ uint64_t vdot_ui32 (uint32_t *a, uint32_t *b, int length) { uint64_t res; _vdot_body_r(uint64_t); }
 complex_i_t vdot_ci (complex_i_t *a, complex_i_t *b, int length) {complex_i_t res; _vdot_body_c(); }
+
+#if defined (_VEC_SIMD)
+__SIMD__ float vdot_f (float *a, float *b, int length) { float res; _vdot_body_vr (_v8f_t, 8); }
+__SIMD__ double vdot_d (double *a, double *b, int length) { double res; _vdot_body_vr (_v4d_t, 4); }
+__SIMD__ complex_f_t vdot_cf (complex_f_t *a, complex_f_t *b, int length) {
+   complex_f_t res;
+   _vdot_body_vc (_v8f_t, float, 8, _vswap_8f, realf, imagf);
+}
+__SIMD__ complex_d_t vdot_cd (complex_d_t *a, complex_d_t *b, int length) {
+   complex_d_t res;
+   _vdot_body_vc (_v4d_t, double, 4, _vswap_4d, real, imag);
+}
+#else
+float vdot_f (float *a, float *b, int length) {float res;  _vdot_body_r(float); }
+double vdot_d (double *a, double *b, int length) { double res; _vdot_body_r(double); }
 complex_f_t vdot_cf (complex_f_t *a, complex_f_t *b, int length) {complex_f_t res; _vdot_body_c(); }
 complex_d_t vdot_cd (complex_d_t *a, complex_d_t *b, int length) {complex_d_t res; _vdot_body_c(); }
+#endif
 
 #undef _vdot_body_r
 #undef _vdot_body_c
+#undef _vdot_body_vr
+#undef _vdot_body_vc
 
 /*!
  * \brief
@@ -23,7 +23,13 @@
  */
 #include <dsp/xcorr.h>
 
-
+/*!
+ * \brief
+ *    The main bodies of direct form cross-correlation.
+ * \note
+ *    The floating point versions switch to xcorr_fft_xx() when both
+ *    signals have at least CONV_FFT_THRESHOLD points.
+ */
 #define  _corr_body_r() {                             \
    int n, k, sy, kmin, kmax;                          \
                                                       \
@@ -97,6 +103,9 @@ void xcorr_i (int *y, int *t, int32_t st, int *x, int32_t sx) {
  * \return none
  */
 void xcorr_f (float *y, float *t, int32_t st, float *x, int32_t sx) {
+   if (st >= CONV_FFT_THRESHOLD && sx >= CONV_FFT_THRESHOLD &&
+       xcorr_fft_f (y, t, st, x, sx) == 0)
+      return;
    _corr_body_r();
 }
 
@@ -120,6 +129,9 @@ void xcorr_f (float *y, float *t, int32_t st, float *x, int32_t sx) {
  * \return none
  */
 void xcorr_d (double *y, double *t, int32_t st, double *x, int32_t sx) {
+   if (st >= CONV_FFT_THRESHOLD && sx >= CONV_FFT_THRESHOLD &&
+       xcorr_fft_d (y, t, st, x, sx) == 0)
+      return;
    _corr_body_r();
 }
 
@@ -166,6 +178,9 @@ void xcorr_ci (complex_i_t *y, complex_i_t *t, int32_t st, complex_i_t *x, int32
  * \return none
  */
 void xcorr_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) {
+   if (st >= CONV_FFT_THRESHOLD && sx >= CONV_FFT_THRESHOLD &&
+       xcorr_fft_cf (y, t, st, x, sx) == 0)
+      return;
    _corr_body_c();
 }
 
@@ -189,8 +204,108 @@ void xcorr_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32
  * \return none
  */
 void xcorr_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) {
+   if (st >= CONV_FFT_THRESHOLD && sx >= CONV_FFT_THRESHOLD &&
+       xcorr_fft_cd (y, t, st, x, sx) == 0)
+      return;
    _corr_body_c();
 }
 #undef _corr_body_r
 #undef _corr_body_c
 
+
+/*!
+ * \brief
+ *    The main body of FFT cross-correlation. The correlation is the
+ *    convolution of t with the reversed (and conjugated) x.
+ *
+ * \param   _t    Signal type
+ * \param   _cj   Conjugate function, or nothing for real signals
+ * \param   _conv FFT convolution function
+ */
+#define  _xcorr_fft_body(_t, _cj, _conv) {                    \
+   int32_t i;                                                  \
+   int r;                                                      \
+   _t *xr;                                                     \
+                                                               \
+   if ((xr = (_t*)malloc (sx*sizeof (_t))) == NULL)            \
+      return 1;                                                \
+   for (i=0 ; i<sx ; ++i)                                      \
+      xr[i] = _cj (x[sx-1-i]);                                 \
+   r = _conv (y, t, st, xr, sx);                               \
+   free ((void*)xr);                                           \
+   return r;                                                   \
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of float t and x using the FFT
+ *
+ * \param   y  Pointer to output vector
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+int xcorr_fft_f (float *y, float *t, int32_t st, float *x, int32_t sx) {
+   _xcorr_fft_body (float, , conv_fft_f);
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of double t and x using the FFT
+ *
+ * \param   y  Pointer to output vector
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+int xcorr_fft_d (double *y, double *t, int32_t st, double *x, int32_t sx) {
+   _xcorr_fft_body (double, , conv_fft_d);
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of complex float t and x using the FFT
+ *
+ * \param   y  Pointer to output vector
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+int xcorr_fft_cf (complex_f_t *y, complex_f_t *t, int32_t st, complex_f_t *x, int32_t sx) {
+   _xcorr_fft_body (complex_f_t, conjf, conv_fft_cf);
+}
+
+/*!
+ * \brief
+ *    Calculates the cross-correlation of complex double t and x using the FFT
+ *
+ * \param   y  Pointer to output vector
+ * \param   t  Pointer to target vector, or signal 1
+ * \param  st  Size of vector t
+ * \param   x  Pointer to input signal, or signal 2
+ * \param  sx  Size of input signal
+ *
+ * \return The status of operation
+ *    \arg  0  Success
+ *    \arg  1  Fail, not enough memory
+ */
+int xcorr_fft_cd (complex_d_t *y, complex_d_t *t, int32_t st, complex_d_t *x, int32_t sx) {
+   _xcorr_fft_body (complex_d_t, conj, conv_fft_cd);
+}
+#undef _xcorr_fft_body
+
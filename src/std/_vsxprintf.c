@@ -23,140 +23,230 @@
  */
 #include <std/_vsxprintf.h>
 
-static inline void _shift_right (unsigned int *i);
-static inline void _shift_left (unsigned int *i);
-static int _floorlog10 (double d) __O3__ ;
-static double _pw10(int e) __O3__ ;
-
-static int _inschar (_putc_out_t _out, char* dst, char c) __Os__ ;
-static int _insnchar (_putc_out_t _out, char *dst, char c, int n) __Os__ ;
-static int _insstring (_putc_out_t _out, char *dst, const char *src, int length) __Os__ ;
-static int _insuint(_putc_out_t _out, char *dst, _io_frm_spec_t *fs, unsigned int value) __Os__ ;
-static int _insuint64 (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, unsigned long long value) __Os__;
-static int _insint (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, char min, int value) __Os__ ;
-static int _insint64 (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, char min, long long value) __Os__;
-static int _inshex (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, unsigned int value) __Os__ ;
-static int _inscoredouble (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, double value) __Os__ ;
-static int _insfdouble (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, double value) __Os__ ;
-static int _insedouble (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, double value) __Os__ ;
+static void _sink_flush (_io_sink_t *s);
+static void _sink_write_slow (_io_sink_t *s, const char *src, int n);
+static void _sink_putn (_io_sink_t *s, char c, int n);
+
+static int _inschar (_io_sink_t *s, char c);
+static int _insnchar (_io_sink_t *s, char c, int n);
+static int _insstring (_io_sink_t *s, const char *src, int length) __Os__ ;
+static int _insuint(_io_sink_t *s, _io_frm_spec_t *fs, unsigned int value) __Os__ ;
+static int _insuint64 (_io_sink_t *s, _io_frm_spec_t *fs, unsigned long long value) __Os__;
+static int _insint (_io_sink_t *s, _io_frm_spec_t *fs, char min, int value) __Os__ ;
+static int _insint64 (_io_sink_t *s, _io_frm_spec_t *fs, char min, long long value) __Os__;
+static int _inshex (_io_sink_t *s, _io_frm_spec_t *fs, unsigned int value) __Os__ ;
+static int _insfixed (_io_sink_t *s, _io_frm_spec_t *fs, char sign, const char *dig, int nd, int dexp, int frac) __Os__ ;
+static int _insexp (_io_sink_t *s, _io_frm_spec_t *fs, char sign, const char *dig, int nd, int dexp, int frac, char e) __Os__ ;
+static int _insfdouble (_io_sink_t *s, _io_frm_spec_t *fs, double value) __Os__ ;
+static int _insedouble (_io_sink_t *s, _io_frm_spec_t *fs, double value) __Os__ ;
+static int _insgdouble (_io_sink_t *s, _io_frm_spec_t *fs, double value) __Os__ ;
 //static double _va_args_double (__VALIST ap);
 
 
-/*!
- * Helper functions.
+/*
+ * Tailoring functions
  */
 
-// Shift 1 bit to the right
-static inline void _shift_right (unsigned int *i) { *i >>= 1; }
-// Shift 1 bit to the left
-static inline void _shift_left (unsigned int *i) { *i <<= 1; }
+/*!
+ * \brief
+ *    insert a char to user defined output function
+ */
+inline int _putc_usr (char *dst, const char c)
+{
+   return __putchar (c);
+}
 
 /*!
  * \brief
- *    Calculates the integer floor (log10 (d)) of a double.
- *    For d>1 multiply a number and check it with a double
- *       the number is integer for small doubles  (<1e18)
- *       and double for big ones (>=1e18).
- *    For d<1 multiply the double and check it with an integer
- *
- *  \return  0 for wrong double (d<=0)
- *          -1 for huge values
+ *    insert a char to destination string.
  */
-static int _floorlog10 (double d)
+inline int _putc_dst (char *dst, const char c)
 {
-   int lg=0;
-   register unsigned long long tenb=1;
+   *dst = c;
+   return 1;
+}
 
-   if (d<=0)      // No Log10 for these numbers, return 0
-      return 0;
-   else if (d<1) {
-      do {
-         d *= 10;
-         --lg;
-      } while (d < 1);
-      return lg+1;
-      /*!
-       * \note
-       * Unfortunately here, we have to multiply the double.
-       * A better solution to replace that is well appreciated.
-       */
-   }
-   else {
-      if (d < _IO_MAX_FLOAT) {
-         while (tenb < d) {
-            tenb *= 10;
-            ++lg;
-         }
-         return lg-1;
-      }
-      else {
-         return -1;
-      }
-      /*!
-       *  \note
-       *  We search for the right number by integer multiplications when possible.
-       *  If the number is bigger than 1e18 (64 bit max decimal digits),
-       *  we do the loop with floating point arithmetic. sorry :(
-       */
-   }
+#if defined (PRINTF_FILES)
+/*!
+ * \brief
+ *    insert a char to file output function
+ * \param   dst   The FILE pointer of the stream
+ */
+inline int _putc_fil (char *dst, const char c)
+{
+   return (fputc (c, (FILE *)dst) == EOF) ? 0 : 1;
 }
+#endif
 
+/*!
+ * \brief
+ *    Sink back end for user's device stdout. Calls __putchar()
+ *    for the buffered run.
+ */
+int _write_usr (void *ctx, const char *src, int n)
+{
+   int i;
+
+   (void)ctx;
+   for (i=0 ; i<n ; ++i)
+      if (__putchar (src[i]) == -1)
+         break;
+   return i;
+}
 
+#if defined (PRINTF_FILES)
 /*!
- *  \brief Calculates the power 10^(int)e
+ * \brief
+ *    Sink back end for file printf family.
+ * \param   ctx   The FILE pointer of the stream
  */
-static double _pw10(int e)
+int _write_fil (void *ctx, const char *src, int n)
 {
-   register unsigned long long p=1;
-   int s=1;
+   return (int)fwrite (src, 1, n, (FILE *)ctx);
+}
+#endif
 
-   // Keep sign
-   if (e<0) {
-      s = -1;
-      e *= s;
-   }
-   // Calculate the power
-   while (e--)
-      p *= 10;
+/*!
+ * Legacy per character back end, for vsxprintf()
+ */
+typedef struct {
+   _putc_out_t out;     /*!< The per character function */
+   char        *dst;    /*!< Its destination */
+}_putc_ctx_t;
 
-   // return it as numerator or denominator.
-   if (s == 1) return (double)(p);
-   else        return (double)(1.0/p);
+static int _write_putc (void *ctx, const char *src, int n)
+{
+   _putc_ctx_t *pc = (_putc_ctx_t *)ctx;
+   int i;
+   for (i=0 ; i<n ; ++i)
+      pc->out (pc->dst++, src[i]);
+   return n;
 }
 
 
-/*
- * Tailoring functions
+/*!
+ * Output sink functions.
  */
 
 /*!
  * \brief
- *    insert a char to user defined output function
+ *    Initialize an output sink
+ *
+ * \param   s     Pointer to sink
+ * \param   write Flush callback. Use NULL for string output, where the buffer
+ *                is the destination string and the characters after the size
+ *                are counted but discarded.
+ * \param   ctx   Callback context (file, device etc...)
+ * \param   buf   Pointer to the buffer
+ * \param   size  Buffer size
  */
-inline int _putc_usr (char *dst, const char c)
+void _io_sink_init (_io_sink_t *s, _io_write_t write, void *ctx, char *buf, int size)
 {
-   return __putchar (c);
+   s->write = write;
+   s->ctx   = ctx;
+   s->buf   = buf;
+   s->size  = size;
+   s->cnt   = s->total = 0;
 }
 
 /*!
  * \brief
- *    insert a char to destination string.
+ *    Flush the buffered characters to the callback
  */
-inline int _putc_dst (char *dst, const char c)
+static void _sink_flush (_io_sink_t *s)
 {
-   *dst = c;
-   return 1;
+   if (s->write && s->cnt)
+      s->write (s->ctx, s->buf, s->cnt);
+   if (s->write)
+      s->cnt = 0;
 }
 
 /*!
  * \brief
- *    insert a char to file output function
+ *    Flush the sink and terminate string output.
+ * \return  The number of characters produced.
  */
-inline int _putc_fil (char *dst, const char c)
+int _io_sink_flush (_io_sink_t *s)
 {
-   return 0;
+   if (s->write)
+      _sink_flush (s);
+   else if (s->buf)
+      s->buf[s->cnt] = 0;
+   return s->total;
 }
 
+/*!
+ * \brief
+ *    Writes a run of characters to the sink, when it does not fit to the
+ *    buffer. Runs bigger than the buffer skip it and go directly to the callback.
+ */
+static void _sink_write_slow (_io_sink_t *s, const char *src, int n)
+{
+   int room;
+
+   s->total += n;
+   if (s->write && n >= s->size) {
+      _sink_flush (s);
+      s->write (s->ctx, src, n);
+      return;
+   }
+   while (n) {
+      if ((room = s->size - s->cnt) == 0) {
+         if (!s->write)
+            return;           // Bounded string, discard
+         _sink_flush (s);
+         room = s->size;
+      }
+      if (room > n)  room = n;
+      memcpy (&s->buf[s->cnt], src, room);
+      s->cnt += room;
+      src += room;
+      n -= room;
+   }
+}
+
+/*!
+ * \brief
+ *    Writes a run of characters to the sink. The short runs of the
+ *    conversions are copied inline.
+ */
+static inline void _sink_write (_io_sink_t *s, const char *src, int n)
+{
+   char *d;
+
+   if (n > s->size - s->cnt) {
+      _sink_write_slow (s, src, n);
+      return;
+   }
+   d = &s->buf[s->cnt];
+   s->cnt += n;
+   s->total += n;
+   while (n--)
+      *d++ = *src++;
+}
+
+/*!
+ * \brief
+ *    Writes \a n times the character \a c to the sink.
+ */
+static void _sink_putn (_io_sink_t *s, char c, int n)
+{
+   int room;
+
+   s->total += n;
+   while (n > 0) {
+      if ((room = s->size - s->cnt) == 0) {
+         if (!s->write)
+            return;           // Bounded string, discard
+         _sink_flush (s);
+         room = s->size;
+      }
+      if (room > n)  room = n;
+      memset (&s->buf[s->cnt], c, room);
+      s->cnt += room;
+      n -= room;
+   }
+}
 
 
 /*!
@@ -165,554 +255,475 @@ inline int _putc_fil (char *dst, const char c)
 
 /*!
  * \brief
- *    Writes a character inside the given string. Returns 1.
+ *    Writes a character to the sink. Returns 1.
  *
- * \param  dst    destination string.
+ * \param  s      output sink.
  * \param  c      character to write.
  */
-static inline int _inschar(_putc_out_t _out, char *dst, char c) {
-   return _out (dst, c);
+static inline int _inschar(_io_sink_t *s, char c) {
+   if (s->cnt >= s->size)
+      _sink_putn (s, c, 1);
+   else {
+      s->buf[s->cnt++] = c;
+      ++s->total;
+   }
+   return 1;
 }
 
 /*!
  * \brief
- *    Writes \a n characters inside the given string and Returns the number
+ *    Writes \a n characters to the sink and Returns the number
  *    of written characters.
  *
- * \param  dst  destination string.
+ * \param  s    output sink.
  * \param  c    character to write.
  * \param  n    number of characters to write.
  */
-static int _insnchar(_putc_out_t _out, char *dst, char c, int n)
+static inline int _insnchar(_io_sink_t *s, char c, int n)
 {
-   int nn;
-   for (nn=n ; nn ; --nn)
-      _out (dst++, c);
+   if (n <= 0)
+      return 0;
+   _sink_putn (s, c, n);
    return n;
 }
 
 /*!
  * \brief
- *    Writes a string inside the given string.
+ *    Writes a string to the sink.
  *
- * \param  dst    destination string.
+ * \param  s      output sink.
  * \param  src    source string.
  * \param  width  Minimum string width, or 0 for default.
  * \return The size of the written
  */
-static int _insstring(_putc_out_t _out, char *dst, const char *src, int length)
+static int _insstring(_io_sink_t *s, const char *src, int length)
 {
-   int n=0;
+   int n = strlen (src);
 
    // Send main string
-   for (n=0 ; *src ; ++n)
-      _out (dst++, *src++);
+   _sink_write (s, src, n);
    // Send remaining - if any
    if (length && length>n)
-      n += _insnchar (_out, dst, ' ', length-n);
+      n += _insnchar (s, ' ', length-n);
    return n;
 }
 
-
 /*!
  * \brief
- *    Writes an unsigned int inside the given string, using the provided
- *    lead character & width parameters. To convert spreads an integer in
- *    to an array discarding one LBS at a time. After that takes the last
- *    digit of each and stream it to string.
+ *    Converts an unsigned value to decimal digits. The digits are
+ *    written backwards from \a end.
  *
- *    For example the number 1234 will expand as:
- *      [0]: 1234
- *      [1]: 123
- *      [2]: 12
- *      [3]: 1
- *      [4]: 0
- *      After that it streams '1', '2', '3', and '4'
+ * \param  end    Pointer after the last digit position.
+ * \param  value  The value.
+ * \return Pointer to the first digit.
+ */
+static char *_utoa (char *end, unsigned int value)
+{
+   do {
+      *--end = (value % 10) + '0';
+      value /= 10;
+   } while (value);
+   return end;
+}
+
+static char *_utoa64 (char *end, unsigned long long value)
+{
+   // Use the 32bit division when the value fits
+   while (value > UINT_MAX) {
+      *--end = (value % 10) + '0';
+      value /= 10;
+   }
+   return _utoa (end, (unsigned int)value);
+}
+
+/*!
+ * \brief
+ *    Writes the lead characters and the sign of a number with \a len
+ *    characters. With '0' lead character the sign goes first, else the
+ *    lead characters go first.
  *
- * \param  dst   destination string.
- * \param  lead  Leading character.
- * \param  width Minimum integer width.
- * \param  value Integer value.
+ * \param  s      output sink.
+ * \param  fs     The format specifier with the width and lead character.
+ * \param  sign   The sign character or 0 for none.
+ * \param  len    The number's length without the sign.
  *
  * \return The number of written characters.
  */
-static int _insuint(_putc_out_t _out, char *dst, _io_frm_spec_t *fs, unsigned int value)
+static int _inslead (_io_sink_t *s, _io_frm_spec_t *fs, char sign, int len)
 {
-   int num = 0, i, j;
-   unsigned int bf[_IO_MAX_INT_DIGITS];
+   int pad = fs->width - len - (sign != 0);
 
-   // Spread value
-   for (i=0, bf[0]=value ; i<_IO_MAX_INT_DIGITS-1 ; ) {
-      bf[i+1] = bf[i]/10;
-      if (!bf[++i])
-         break;
+   if (pad < 0)
+      pad = 0;
+   if (fs->flags.lead == '0') {
+      if (sign)   _inschar (s, sign);
+      _insnchar (s, '0', pad);
    }
+   else {
+      _insnchar (s, fs->flags.lead, pad);
+      if (sign)   _inschar (s, sign);
+   }
+   return pad + (sign != 0);
+}
 
-   // Write leading characters
-   for (j=i ; j<fs->width ; ++j)
-      num += _inschar (_out, dst++, fs->flags.lead);
-
-   // Write actual numbers
-   for ( ; i ; --i)
-      num += _inschar (_out, dst++, (bf[i-1] - bf[i]*10) + '0');
+/*!
+ * \brief
+ *    Writes the lead characters, the sign and the digits of a number
+ *    in runs. \see _inslead()
+ *
+ * \param  s      output sink.
+ * \param  fs     The format specifier with the width and lead character.
+ * \param  sign   The sign character or 0 for none.
+ * \param  dig    Pointer to the digits.
+ * \param  nd     The number of digits.
+ *
+ * \return The number of written characters.
+ */
+static int _insnum (_io_sink_t *s, _io_frm_spec_t *fs, char sign, const char *dig, int nd)
+{
+   int n = _inslead (s, fs, sign, nd);
 
-   return num;
+   _sink_write (s, dig, nd);
+   return n + nd;
 }
 
 /*!
  * \brief
- *    Writes an unsigned long long int inside the given string, using the provided
- *    lead character & width parameters. To convert spreads an integer in
- *    to an array discarding one LBS at a time. After that takes the last
- *    digit of each and stream it to string.
- *
- *    For example the number 1234 will expand as:
- *      [0]: 1234
- *      [1]: 123
- *      [2]: 12
- *      [3]: 1
- *      [4]: 0
- *      After that it streams '1', '2', '3', and '4'
+ *    Writes an unsigned int to the sink, using the provided
+ *    lead character & width parameters. The digits are calculated
+ *    from the LSB to a local buffer and streamed as one run.
  *
- * \param  dst   destination string.
- * \param  lead  Leading character.
- * \param  width Minimum integer width.
+ * \param  s     output sink.
+ * \param  fs    The format specifier with the lead character and width.
  * \param  value Integer value.
  *
  * \return The number of written characters.
  */
-static int _insuint64 (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, unsigned long long value)
+static int _insuint(_io_sink_t *s, _io_frm_spec_t *fs, unsigned int value)
 {
-   int num = 0, i, j;
-   unsigned int bf[_IO_MAX_INT64_DIGITS];
+   char bf[_IO_MAX_INT_DIGITS];
+   char *d = _utoa (&bf[_IO_MAX_INT_DIGITS], value);
 
-   // Spread value
-   for (i=0, bf[0]=value ; i<_IO_MAX_INT64_DIGITS-1 ; ) {
-      bf[i+1] = bf[i]/10;
-      if (!bf[++i])
-         break;
-   }
-
-   // Write leading characters
-   for (j=i ; j<fs->width ; ++j)
-      num += _inschar (_out, dst++, fs->flags.lead);
+   return _insnum (s, fs, 0, d, &bf[_IO_MAX_INT_DIGITS] - d);
+}
 
-   // Write actual numbers
-   for ( ; i ; --i)
-      num += _inschar (_out, dst++, (bf[i-1] - bf[i]*10) + '0');
+/*!
+ * \brief
+ *    Writes an unsigned long long int to the sink, using the provided
+ *    lead character & width parameters. \see _insuint()
+ *
+ * \param  s     output sink.
+ * \param  fs    The format specifier with the lead character and width.
+ * \param  value Integer value.
+ *
+ * \return The number of written characters.
+ */
+static int _insuint64 (_io_sink_t *s, _io_frm_spec_t *fs, unsigned long long value)
+{
+   char bf[_IO_MAX_INT64_DIGITS];
+   char *d = _utoa64 (&bf[_IO_MAX_INT64_DIGITS], value);
 
-   return num;
+   return _insnum (s, fs, 0, d, &bf[_IO_MAX_INT64_DIGITS] - d);
 }
 
 /*!
  * \brief
- *    Writes a signed int inside the given string, using the provided
- *    lead characters & width parameters. To convert spreads an integer in
- *    to an array discarding one LBS at a time. After that takes the last
- *    digit of each and stream it to string.
- *
- *    For example the number 1234 will expand as:
- *      [0]: 1234
- *      [1]: 123
- *      [2]: 12
- *      [3]: 1
- *      [4]: 0
- *      After that it streams '1', '2', '3', and '4'
+ *    Writes a signed int to the sink, using the provided
+ *    lead characters & width parameters. \see _insuint()
  *
- * \param dst    destination string.
- * \param lead   Leading character.
- * \param width  Minimum integer width.
- * \param sign   Always print sign flag.
+ * \param s      output sink.
+ * \param fs     The format specifier with the lead character, width and plus flag.
  * \param min    Is a negative number, used if value is zero.
  * \param value  Signed integer value.
  *
  * \return The number of written characters.
  */
-static int _insint (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, char min, int value)
+static int _insint (_io_sink_t *s, _io_frm_spec_t *fs, char min, int value)
 {
-   int num = 0, i, j;
-   int bf[_IO_MAX_INT_DIGITS];
-   unsigned int absv, negative=min, scr;
-   void (*pshift) (unsigned int*);
+   char bf[_IO_MAX_INT_DIGITS];
+   char *d;
+   char sign = 0;
+   unsigned int absv;
 
    // Compute absolute value
    if (value < 0) {
-      negative=1;
-      absv = -value;
+      min = 1;
+      absv = -(unsigned int)value;
    }
    else
       absv = value;
 
-   // Spread absolute value
-   for (i=0, bf[0]=absv ; i<_IO_MAX_INT_DIGITS-1 ; ) {
-      bf[i+1] = bf[i]/10;
-      if (!bf[++i])
-         break;
-   }
-   j = i + (fs->flags.plus || negative);
-
-   /*
-    *  Decide to run lead characters code or sign code first.
-    */
-   if (fs->flags.lead == '0')
-      pshift = _shift_left;
-   else
-      pshift = _shift_right;
-
-   for (scr=0x04 ; scr ; ) {
-      pshift (&scr);
-      switch (scr) {
-         case 0x01:
-         case 0x08:
-            // Write sign
-            if (negative)
-               num += _inschar (_out, dst++, '-');
-            else if (fs->flags.plus)
-               num += _inschar (_out, dst++, '+');
-            break;
-         case 0x02:
-         case 0x10:
-            // Write lead characters
-            for ( ; j<fs->width ; ++j)
-               num += _inschar (_out, dst++, fs->flags.lead);
-            break;
-         default:
-            scr = 0;
-            break;
-      }
-   }
-
-   // Write actual numbers
-   for ( ; i ; --i)
-      num += _inschar (_out, dst++, (bf[i-1] - bf[i]*10) + '0');
-
-   return num;
+   if (min)                   sign = '-';
+   else if (fs->flags.plus)   sign = '+';
+   d = _utoa (&bf[_IO_MAX_INT_DIGITS], absv);
+   return _insnum (s, fs, sign, d, &bf[_IO_MAX_INT_DIGITS] - d);
 }
 
 /*!
  * \brief
- *    Writes a signed long long inside the given string, using the provided
- *    lead characters & width parameters. To convert spreads an integer in
- *    to an array discarding one LBS at a time. After that takes the last
- *    digit of each and stream it to string.
- *
- *    For example the number 1234 will expand as:
- *      [0]: 1234
- *      [1]: 123
- *      [2]: 12
- *      [3]: 1
- *      [4]: 0
- *      After that it streams '1', '2', '3', and '4'
+ *    Writes a signed long long to the sink, using the provided
+ *    lead characters & width parameters. \see _insuint()
  *
- * \param dst    destination string.
- * \param lead   Leading character.
- * \param width  Minimum integer width.
- * \param sign   Always print sign flag.
+ * \param s      output sink.
+ * \param fs     The format specifier with the lead character, width and plus flag.
  * \param min    Is a negative number, used if value is zero.
  * \param value  Signed integer value.
  *
  * \return The number of written characters.
  */
-static int _insint64 (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, char min, long long value)
+static int _insint64 (_io_sink_t *s, _io_frm_spec_t *fs, char min, long long value)
 {
-   int num = 0, i, j;
-   int bf[_IO_MAX_INT64_DIGITS];
+   char bf[_IO_MAX_INT64_DIGITS];
+   char *d;
+   char sign = 0;
    unsigned long long absv;
-   unsigned int negative=min, scr;
-   void (*pshift) (unsigned int*);
 
    // Compute absolute value
    if (value < 0) {
-      negative=1;
-      absv = -value;
+      min = 1;
+      absv = -(unsigned long long)value;
    }
    else
       absv = value;
 
-   // Spread absolute value
-   for (i=0, bf[0]=absv ; i<_IO_MAX_INT64_DIGITS-1 ; ) {
-      bf[i+1] = bf[i]/10;
-      if (!bf[++i])
-         break;
-   }
-   j = i + (fs->flags.plus || negative);
-
-   /*
-    *  Decide to run lead characters code or sign code first.
-    */
-   if (fs->flags.lead == '0')
-      pshift = _shift_left;
-   else
-      pshift = _shift_right;
-
-   for (scr=0x04 ; scr ; ) {
-      pshift (&scr);
-      switch (scr) {
-         case 0x01:
-         case 0x08:
-            // Write sign
-            if (negative)
-               num += _inschar (_out, dst++, '-');
-            else if (fs->flags.plus)
-               num += _inschar (_out, dst++, '+');
-            break;
-         case 0x02:
-         case 0x10:
-            // Write lead characters
-            for ( ; j<fs->width ; ++j)
-               num += _inschar (_out, dst++, fs->flags.lead);
-            break;
-         default:
-            scr = 0;
-            break;
-      }
-   }
-
-   // Write actual numbers
-   for ( ; i ; --i)
-      num += _inschar (_out, dst++, (bf[i-1] - bf[i]*10) + '0');
-
-   return num;
+   if (min)                   sign = '-';
+   else if (fs->flags.plus)   sign = '+';
+   d = _utoa64 (&bf[_IO_MAX_INT64_DIGITS], absv);
+   return _insnum (s, fs, sign, d, &bf[_IO_MAX_INT64_DIGITS] - d);
 }
 
 /*!
  * \brief
- *    Writes an hexadecimal value into a string, using the given lead
- *    character width & capital parameters. To convert spreads an integer in
- *    to an array discarding one LBS at a time (4bits). After that takes the last
- *    digit of each and stream it to string.
+ *    Writes an hexadecimal value to the sink, using the given lead
+ *    character width & capital parameters. The digits are taken
+ *    4 bits at a time from the LSB to a local buffer and streamed as one run.
  *
- *    For example the number 1234 will expand as:
- *      [0]: 0x1234
- *      [1]: 0x123
- *      [2]: 0x12
- *      [3]: 0x1
- *      [4]: 0x0
- *      After that it streams '1', '2', '3', and '4'
- *
- * \param dst    destination string.
- * \param lead   Leading character.
- * \param width  Minimum integer width.
- * \param maj    Indicates if the letters must be printed in lower- or upper-case.
+ * \param s      output sink.
+ * \param fs     The format specifier with the lead character, width and type (x or X).
  * \param value  Hexadecimal value.
  *
  * \return  The number of char written
  */
-static int _inshex (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, unsigned int value)
+static int _inshex (_io_sink_t *s, _io_frm_spec_t *fs, unsigned int value)
 {
-   int num = 0, i, j;
-   unsigned int bf[_IO_MAX_INT_DIGITS];
+   char bf[_IO_MAX_INT_DIGITS];
+   char *d = &bf[_IO_MAX_INT_DIGITS];
+   char a = (fs->type == INT_X) ? 'A' : 'a';
+
+   do {
+      *--d = ((value & 0xF) < 0xA) ? (value & 0xF) + '0' : ((value & 0xF) - 0xA) + a;
+      value >>= 4;
+   } while (value);
+   return _insnum (s, fs, 0, d, &bf[_IO_MAX_INT_DIGITS] - d);
+}
 
-   // Spread value
-   for (i=0, bf[0]=value ; i<_IO_MAX_INT_DIGITS-1 ; ) {
-      bf[i+1] = bf[i]>>4;
-      if (!bf[++i])
-         break;
+
+/*!
+ * \brief
+ *    Writes the digits of a floating point value to the sink in decimal
+ *    format, using the given lead, width & sign parameters.
+ *
+ * \param s      output sink.
+ * \param fs     The format specifier with the lead and width.
+ * \param sign   The sign character or 0 for none.
+ * \param dig    The digits, rounded to the \a frac decimals \see dtoa_round().
+ * \param nd     The number of digits. Zero for 0.
+ * \param dexp   The decimal point position of the digits.
+ * \param frac   The decimals to write. The missing ones are zeros.
+ *
+ * \return  The number of char written
+ */
+static int _insfixed (_io_sink_t *s, _io_frm_spec_t *fs, char sign, const char *dig, int nd, int dexp, int frac)
+{
+   int num = ((dexp > 0) ? dexp : 1) + ((frac) ? frac + 1 : 0);
+   int n, z, first;
+
+   num += _inslead (s, fs, sign, num);
+
+   // Integer part
+   if (dexp <= 0)
+      _inschar (s, '0');
+   else {
+      n = (nd < dexp) ? nd : dexp;
+      _sink_write (s, dig, n);
+      _insnchar (s, '0', dexp - n);
    }
+   if (!frac)
+      return num;
+
+   // Fractional part: zeros after the point, the digits and trailing zeros
+   _inschar (s, '.');
+   z = (dexp < 0) ? -dexp : 0;
+   if (z > frac)
+      z = frac;
+   _insnchar (s, '0', z);
+   first = (dexp > 0) ? dexp : 0;
+   n = nd - first;
+   if (n > frac - z)    n = frac - z;
+   if (n > 0)           _sink_write (s, &dig[first], n);
+   else                 n = 0;
+   _insnchar (s, '0', frac - z - n);
+   return num;
+}
 
-   // Write lead characters
-   for (j=i ; j<fs->width ; ++j)
-      num += _inschar (_out, dst++, fs->flags.lead);
-
-   // Write actual numbers
-   for ( ; i ; --i) {
-      if ((bf[i-1] & 0xF) < 0xA)
-         num += _inschar (_out, dst++, (bf[i-1] & 0xF) + '0');
-      else if (fs->type == INT_X)
-         num += _inschar (_out, dst++, ((bf[i-1] & 0xF) - 0xA) + 'A');
-      else
-         num += _inschar (_out, dst++, ((bf[i-1] & 0xF) - 0xA) + 'a');
+/*!
+ * \brief
+ *    Writes the digits of a floating point value to the sink in scientific
+ *    format "d.ddde+x", using the given lead, width & sign parameters.
+ *
+ * \param s      output sink.
+ * \param fs     The format specifier with the lead and width.
+ * \param sign   The sign character or 0 for none.
+ * \param dig    The digits, rounded to 1+frac digits \see dtoa_round().
+ * \param nd     The number of digits, at least one.
+ * \param dexp   The decimal point position of the digits.
+ * \param frac   The decimals to write. The missing ones are zeros.
+ * \param e      The exponent character.
+ *
+ * \return  The number of char written
+ */
+static int _insexp (_io_sink_t *s, _io_frm_spec_t *fs, char sign, const char *dig, int nd, int dexp, int frac, char e)
+{
+   char bf[_IO_MAX_INT_DIGITS];
+   char *exp;
+   int x = dexp - 1, nexp, num, n;
+
+   // Exponent string
+   exp = _utoa (&bf[_IO_MAX_INT_DIGITS], (x < 0) ? -x : x);
+   *--exp = (x < 0) ? '-' : '+';
+   *--exp = e;
+   nexp = &bf[_IO_MAX_INT_DIGITS] - exp;
+
+   num = 1 + ((frac) ? frac + 1 : 0) + nexp;
+   num += _inslead (s, fs, sign, num);
+   _inschar (s, dig[0]);
+   if (frac) {
+      _inschar (s, '.');
+      n = (nd - 1 < frac) ? nd - 1 : frac;
+      _sink_write (s, &dig[1], n);
+      _insnchar (s, '0', frac - n);
    }
+   _sink_write (s, exp, nexp);
    return num;
 }
 
+/*!
+ * \brief
+ *    The sign character of a floating point value.
+ */
+static char _dsign (_io_frm_spec_t *fs, double value)
+{
+   if (signbit (value))       return '-';
+   else if (fs->flags.plus)   return '+';
+   else                       return 0;
+}
 
 /*!
  * \brief
- *    Writes an floating point value into a string, using the given lead, width &
+ *    Writes NaN and INF.
+ */
+static int _insnfdouble (_io_sink_t *s, char sign, double value)
+{
+   if (isnan (value))
+      return _insstring (s, "NaN", 0);
+   return ((sign) ? _inschar (s, sign) : 0) + _insstring (s, "INF", 0);
+}
+
+/*!
+ * \brief
+ *    Writes an floating point value to the sink, using the given lead, width &
  *    sign parameters. The floating point is in decimal format.
+ *    The digits are the exact value correctly rounded to frac decimals,
+ *    up to \see DTOA_EXACT_DIGITS significant digits.
+ *    Supports also NaN and INF.
  *
- * \param dst    destination string.
- * \param lead   Fill character.
- * \param width  Minimum integer width.
- * \param frac   Fractional width.
- * \param sign   Always print sign flag.
+ * \param s      output sink.
+ * \param fs     The format specifier with the lead, width, frac and plus flag.
  * \param value  double value.
  *
  * \return  The number of char written
  */
-static int _inscoredouble (_putc_out_t _out, char *dst, _io_frm_spec_t *fs, double value)
+static int _insfdouble(_io_sink_t *s, _io_frm_spec_t *fs, double value)
 {
-   int num, fr_num, n_int, n_dec, negative=0;
-   double absv, r_absv, scrl;
-   _io_frm_spec_t n_int_fs, n_dec_fs;
+   char dig[DTOA_EXACT_DIGITS];
+   char sign = _dsign (fs, value);
+   int nd, dexp;
 
-   if (value<0) {
-      negative = 1;
-      absv = -value;
-   } else
-      absv = value;
+   if (!isfinite (value))
+      return _insnfdouble (s, sign, value);
 
-   // fix width
-   if (!fs->width)
-      fs->width = _IO_WIDTH;
-   // fix frac
-   if (!fs->frac)
-      fs->frac = _IO_FRACTIONAL_WIDTH;
-
-   // Calculate the n_int and n_dec parts
-   n_int = (int)absv;
-   scrl = _pw10 (fs->frac);   // Calculate the scroll multiplier
-   absv -= n_int;             // Cut the decimal part
-   absv *= scrl;              // Scroll the fractional part frac positions to the left
-   r_absv = round (absv);     // Round the scrolled frac part
-   if (r_absv >= scrl) {
-      // The rounding result, give us an integer "reminder"
-      ++n_int;
-      r_absv = 0;
-   }
-   n_dec = (int)r_absv;
-
-   /*
-    * Write the number
-    */
-   // Prepare n_int
-   n_int_fs.width = fs->width-fs->frac-1;
-   n_int_fs.frac = 0;
-   n_int_fs.flags.lead = fs->flags.lead;
-   n_int_fs.flags.plus = fs->flags.plus;
-   n_int_fs.flags.minus = n_int_fs.flags.sharp = 0;
-   // Prepare n_dec
-   n_dec_fs.width = fs->frac;
-   n_dec_fs.frac = 0;
-   n_dec_fs.flags.lead ='0';
-   n_dec_fs.flags.plus = n_int_fs.flags.minus = n_int_fs.flags.sharp = 0;
-
-   num = _insint (_out, dst, &n_int_fs, negative, n_int); // Insert the decimal part
-   dst += num;
-
-   num += _inschar (_out, dst++, '.');  // Insert point
-
-   fr_num = _insint (_out, dst, &n_dec_fs, 0, n_dec);  // Insert fractional
-   num += fr_num;          // Update counters
-   dst += fr_num;
-
-   // Write trailing zeros, if any
-   if (fr_num < fs->frac)
-      num += _insnchar (_out, dst, '0', fs->frac-fr_num);
-   return num;
+   if (!fs->width)  fs->width = _IO_WIDTH;              // fix width
+   if (!fs->frac)   fs->frac = _IO_FRACTIONAL_WIDTH;    // fix frac
+
+   nd = dtoa_fixed (value, dig, &dexp, fs->frac);
+   return _insfixed (s, fs, sign, dig, nd, dexp, fs->frac);
 }
 
 /*!
  * \brief
- *    Writes an floating point value into a string, using the given lead, width &
- *    sign parameters. The floating point is in decimal format.
+ *    Writes an floating point value to the sink, using the given lead, width &
+ *    sign parameters. The floating point is in scientific (exp) format.
  *    Supports also NaN and INF.
  *
- * \param dst    destination string.
- * \param lead   Fill character.
- * \param width  Minimum integer width.
- * \param frac   Fractional width.
- * \param sign   Always print sign flag.
+ * \param s      output sink.
+ * \param fs     The format specifier with the lead, width, frac and plus flag.
  * \param value  double value.
  *
  * \return  The number of char written
  */
-static int _insfdouble(_putc_out_t _out, char *dst, _io_frm_spec_t *fs, double value)
+static int _insedouble(_io_sink_t *s, _io_frm_spec_t *fs, double value)
 {
-   if ( isinf (value) )          // INF
-      return _insstring(_out, dst, "INF", 0);
-   else if ( isnan (value) )     // NAN
-      return _insstring(_out, dst, "NaN", 0);
-   else
-      return _inscoredouble (_out, dst, fs, value);
-   return 0;
-}
+   char dig[DTOA_EXACT_DIGITS];
+   char sign = _dsign (fs, value);
+   int nd, dexp;
+
+   if (!isfinite (value))
+      return _insnfdouble (s, sign, value);
 
+   if (!fs->width)  fs->width = _IO_WIDTH;              // fix width
+   if (!fs->frac)   fs->frac = _IO_FRACTIONAL_WIDTH;    // fix frac
 
+   nd = dtoa_digits (value, dig, &dexp);
+   nd = dtoa_round (value, dig, nd, &dexp, fs->frac + 1);
+   return _insexp (s, fs, sign, dig, nd, dexp, fs->frac, (fs->type == FL_E) ? 'E' : 'e');
+}
 
 /*!
  * \brief
- *    Writes an floating point value into a string, using the given lead, width &
- *    sign parameters. The floating point is in scientific (exp) format.
+ *    Writes an floating point value to the sink, using the given lead, width &
+ *    sign parameters. The format is decimal for exponents in [-4, precision)
+ *    and scientific for the rest, without trailing zeros unless there is the
+ *    sharp flag. Without precision (frac) the digits are the shortest ones
+ *    that read back to the same double.
  *    Supports also NaN and INF.
  *
- * \param dst    destination string.
- * \param lead   Fill character.
- * \param width  Minimum integer width.
- * \param frac   Fractional width.
- * \param sign   Always print sign flag.
+ * \param s      output sink.
+ * \param fs     The format specifier with the lead, width, frac, plus and sharp flags.
  * \param value  double value.
  *
  * \return  The number of char written
  */
-static int _insedouble(_putc_out_t _out, char *dst, _io_frm_spec_t *fs, double value)
+static int _insgdouble(_io_sink_t *s, _io_frm_spec_t *fs, double value)
 {
-   int exp=0, num=0;
-   char exp_str[6];
-   int sexp, negative=0;
-   _io_frm_spec_t exp_fs;
-
-   if ( isinf (value) )          // INF
-      return _insstring(_out, dst, "INF", 0);
-   else if ( isnan (value) )     // NAN
-      return _insstring(_out, dst, "NaN", 0);
-   else if (value == 0)          // there is no such thing as Log10(0)
-      return _insstring(_out, dst, "0.0e0", 0);
-   else
-   {
-      if (value < 0) {
-         negative = 1;
-         exp = _floorlog10(-value);
-         if (value <-1 && (exp == -1 || exp > _IO_MAX_FLOAT_EXP))
-            return _insstring(_out, dst, "-BIG", 0);
-         if (value >-1 && exp < _IO_MIN_FLOAT_EXP)
-            return _insstring(_out, dst, "-0", 0);
-      }
-      else {
-         exp = _floorlog10(value);
-         if (value >1 && (exp == -1 || exp > _IO_MAX_FLOAT_EXP))
-            return _insstring(_out, dst, "+BIG", 0);
-         if (value <1 && exp < _IO_MIN_FLOAT_EXP)
-            return _insstring(_out, dst, "+0", 0);
-      }
-
-      value = value / _pw10(exp);
-      /*
-       * We don't use pow() and floor(log10()) ;-)
-       */
-
-      // Prepare exponential and use _putc_dst() for that.
-      exp_fs.width = exp_fs.frac = 0;
-      exp_fs.flags.lead = ' ';
-      exp_fs.flags.plus = 1;
-      exp_fs.flags.minus = exp_fs.flags.sharp = 0;
-      sexp = _inschar (_putc_dst, exp_str, 'e');   // Insert e
-      sexp += _insint (_putc_dst, &exp_str[1], &exp_fs, 0, exp);
-      exp_str[sexp]=0;
-
-
-      if (!fs->width)  fs->width = _IO_WIDTH;        // fix width
-      if (!fs->frac)   fs->frac = _IO_FRACTIONAL_WIDTH;   // fix frac
-      if (fs->width < sexp+fs->frac+2+(fs->flags.plus || negative))
-         fs->width = sexp+fs->frac+2+(fs->flags.plus || negative);
-      fs->width -= sexp;       // significant's width
-      /*
-       * Calculate width from users request (full number width)
-       *
-       * full width = sign(1) + int + dot(1) + frac + sexp
-       *                        |-------------------|
-       *                          significant width
-       *  int has minimum 1 size
-       */
-
-      // Insert results to string
-      num = _inscoredouble (_out, dst, fs, value);
-      dst += num;
-      num += _insstring(_out, dst, exp_str, 0);
-      return num;
+   char dig[DTOA_EXACT_DIGITS];
+   char sign = _dsign (fs, value);
+   int nd, dexp, x, prec, frac;
+
+   if (!isfinite (value))
+      return _insnfdouble (s, sign, value);
+
+   prec = (fs->frac) ? fs->frac : DTOA_MAX_DIGITS;
+   nd = dtoa_digits (value, dig, &dexp);
+   if (fs->frac)
+      nd = dtoa_round (value, dig, nd, &dexp, prec);
+   if (!fs->frac || !fs->flags.sharp)
+      prec = nd;     // strip the trailing zeros
+   x = dexp - 1;
+   if (x >= -4 && x < ((fs->frac) ? fs->frac : DTOA_MAX_DIGITS)) {
+      frac = prec - dexp;
+      return _insfixed (s, fs, sign, dig, nd, dexp, (frac > 0) ? frac : 0);
    }
-   return 0;
+   return _insexp (s, fs, sign, dig, nd, dexp, prec - 1, (fs->type == FL_G) ? 'E' : 'e');
 }
 
 /*!
@@ -751,38 +762,51 @@ static double _va_args_double(__VALIST ap) {
 void _io_unused (void) {
    char tmp [2] = "0";
    _io_frm_spec_t tmp2 = {0};
+   _io_sink_t s;
 
-   tbx_unused (_insint64 (_putc_usr, tmp, &tmp2, 0, 0) );
-   tbx_unused (_insuint64 (_putc_usr, tmp, &tmp2, 0));
+   _io_sink_init (&s, 0, 0, tmp, 1);
+   tbx_unused (_insint64 (&s, &tmp2, 0, 0) );
+   tbx_unused (_insuint64 (&s, &tmp2, 0));
 }
 
 /*!
  * \brief
- *    Stores the result of a formatted string into another string. Format
- *    arguments are given in a va_list instance.
- *    First lexicon analysis is made to the frm
- *    Second the proper conversion function is called
- *    The procedure is continued until we reach \see PF_MAX_STRING_SIZE
- *    or NULL character..
- *
- * \param _out    callback function to use for output streaming
- * \param dst     Destination string (if any).
+ *    Formats a string to an output sink. Format arguments are given
+ *    in a va_list instance.
+ *    The plain characters of the format string are streamed in runs up to
+ *    the next '%'. For each specifier the lexicon analysis is made and the
+ *    proper conversion function is called. The conversion functions fill
+ *    the sink in runs, so the sink's callback is called only when its buffer
+ *    is full or on \see _io_sink_flush().
+ *
+ * \param s       The output sink
  * \param frm     Format string.
  * \param ap      Argument list.
  *
- * \return  The number of characters written.
+ * \return  The number of characters produced, even if they do not fit
+ *          a string sink.
  */
-int vsxprintf(_putc_out_t _out, char *dst, char *frm, __VALIST ap)
+int vsxprintf_sink (_io_sink_t *s, const char *frm, __VALIST ap)
 {
    _io_frm_obj_t obj;               /* object place holder */
    _io_frm_obj_type_en  obj_type;   /* object type place holder */
-   char* dst_start = dst;           /* Destination starting address */
+   const char *run;
 
    while (*frm != 0) {
-      frm += _io_read (frm, &obj, &obj_type);
+      // Stream the plain characters in one run
+      for (run = frm ; *run != 0 && *run != (char)-1 && !IS_PC (*run) ; ++run)
+         ;
+      if (run != frm) {
+         _sink_write (s, frm, run - frm);
+         frm = run;
+         continue;
+      }
+      frm += _io_read ((char *)frm, &obj, &obj_type);
+      if (obj_type == _IO_FRM_TERMINATOR)
+         break;
       switch (obj_type) {
          case _IO_FRM_STREAM:
-            _out (dst++, obj.character);
+            _inschar (s, obj.character);
             break;
          case _IO_FRM_SPECIFIER:
             // Variable width reading
@@ -795,40 +819,119 @@ int vsxprintf(_putc_out_t _out, char *dst, char *frm, __VALIST ap)
             if (obj.frm_specifier.type == INT_d ||
                 obj.frm_specifier.type == INT_i ||
                 obj.frm_specifier.type == INT_l)
-               dst += _insint(_out, dst, &obj.frm_specifier, 0, va_arg(ap, signed int));
+               _insint(s, &obj.frm_specifier, 0, va_arg(ap, signed int));
             else if (obj.frm_specifier.type == INT_u)
-               dst += _insuint(_out, dst, &obj.frm_specifier, va_arg(ap, unsigned int));
+               _insuint(s, &obj.frm_specifier, va_arg(ap, unsigned int));
             else if (obj.frm_specifier.type == INT_x ||
                      obj.frm_specifier.type == INT_X ||
                      obj.frm_specifier.type == INT_o)
-               dst += _inshex(_out, dst, &obj.frm_specifier, va_arg(ap, unsigned int));
+               _inshex(s, &obj.frm_specifier, va_arg(ap, unsigned int));
             else if (obj.frm_specifier.type == INT_c)
-               dst += _inschar(_out, dst, va_arg(ap, unsigned int));
+               _inschar(s, va_arg(ap, unsigned int));
             else if (obj.frm_specifier.type == INT_s)
-               dst += _insstring(_out, dst, va_arg(ap, char *), obj.frm_specifier.width);
+               _insstring(s, va_arg(ap, char *), obj.frm_specifier.width);
             else if (obj.frm_specifier.type == FL_f ||
-                     obj.frm_specifier.type == FL_g ||
-                     obj.frm_specifier.type == FL_G ||
                      obj.frm_specifier.type == FL_L)
-               //dst += _insfdouble (_out, dst, &obj.frm_specifier, _va_args_double(ap)); // XXX
-               dst += _insfdouble (_out, dst, &obj.frm_specifier, va_arg(ap, double));
+               //_insfdouble (s, &obj.frm_specifier, _va_args_double(ap)); // XXX
+               _insfdouble (s, &obj.frm_specifier, va_arg(ap, double));
             else if (obj.frm_specifier.type == FL_e ||
                      obj.frm_specifier.type == FL_E)
-               //dst += _insedouble (_out, dst, &obj.frm_specifier, _va_args_double(ap)); // XXX
-               dst += _insedouble (_out, dst, &obj.frm_specifier, va_arg(ap, double)); // XXX
+               //_insedouble (s, &obj.frm_specifier, _va_args_double(ap)); // XXX
+               _insedouble (s, &obj.frm_specifier, va_arg(ap, double)); // XXX
+            else if (obj.frm_specifier.type == FL_g ||
+                     obj.frm_specifier.type == FL_G)
+               _insgdouble (s, &obj.frm_specifier, va_arg(ap, double));
             else  // eat the wrong type to unsigned int
-               dst += _insuint(_out, dst, &obj.frm_specifier, va_arg(ap, unsigned int));
+               _insuint(s, &obj.frm_specifier, va_arg(ap, unsigned int));
             break;
             /*
              * XXX: BUG workaround
              */
          case _IO_FRM_TERMINATOR:
-            _out (dst++, 0);
-            break;
          case _IO_FRM_CRAP:
             break;
       }
    }
-   _out (dst, 0); // NULL-terminated (final \0 is not counted)
-   return (int)(dst - dst_start);
+   return s->total;
+}
+
+/*!
+ * \brief
+ *    Formats a string to a write callback, through a stack buffer
+ *    of \see _IO_SINK_BUFFER_SIZE characters.
+ *
+ * \param write   The write callback \see _write_usr(), _write_fil()
+ * \param ctx     The callback context
+ * \param frm     Format string.
+ * \param ap      Argument list.
+ *
+ * \return  The number of characters written.
+ */
+int vxprintf (_io_write_t write, void *ctx, const char *frm, __VALIST ap)
+{
+   char buf[_IO_SINK_BUFFER_SIZE];
+   _io_sink_t s;
+
+   _io_sink_init (&s, write, ctx, buf, sizeof (buf));
+   vsxprintf_sink (&s, frm, ap);
+   return _io_sink_flush (&s);
+}
+
+/*!
+ * \brief
+ *    Formats a string to a destination string of \a size bytes including the
+ *    null termination. The output is truncated to size-1 characters.
+ *
+ * \param dst     Destination string.
+ * \param size    The destination size.
+ * \param frm     Format string.
+ * \param ap      Argument list.
+ *
+ * \return  The number of characters that the full output needs, without
+ *          the null termination.
+ */
+int vsnxprintf (char *dst, size_t size, const char *frm, __VALIST ap)
+{
+   _io_sink_t s;
+
+   if (size == 0)
+      _io_sink_init (&s, 0, 0, 0, 0);
+   else
+      _io_sink_init (&s, 0, 0, dst, (size > INT_MAX) ? INT_MAX : (int)size - 1);
+   vsxprintf_sink (&s, frm, ap);
+   return _io_sink_flush (&s);
+}
+
+/*!
+ * \brief
+ *    Stores the result of a formatted string into another string or streams
+ *    it to a per character callback. Format arguments are given in a va_list
+ *    instance.
+ * \note
+ *    The per character callbacks are kept for compatibility. The string
+ *    destination \see _putc_dst() is converted to a string sink, \see _putc_usr()
+ *    and \see _putc_fil() to their write back ends and the others are called
+ *    through a buffered sink, with dst advanced per character.
+ *
+ * \param _out    callback function to use for output streaming
+ * \param dst     Destination string (if any).
+ * \param frm     Format string.
+ * \param ap      Argument list.
+ *
+ * \return  The number of characters written.
+ */
+int vsxprintf(_putc_out_t _out, char *dst, char *frm, __VALIST ap)
+{
+   _putc_ctx_t pc = { .out = _out, .dst = dst };
+
+   if (_out == _putc_dst)
+      return vsnxprintf (dst, INT_MAX, frm, ap);
+   else if (_out == _putc_usr)
+      return vxprintf (_write_usr, 0, frm, ap);
+#if defined (PRINTF_FILES)
+   else if (_out == _putc_fil)
+      return vxprintf (_write_fil, (void *)dst, frm, ap);
+#endif
+   else
+      return vxprintf (_write_putc, &pc, frm, ap);
 }
@@ -30,7 +30,7 @@ static int   _is_hex_number (char c);
 static int  _is_real_number (char c);
 
 static int _stream_getfirst (_getc_in_t _in, const char *src, char **psrc);
-static int     _number_copy (_getc_in_t _in, _number_copy_type_en t, const char *src, char **psrc, char *dst);
+static int     _number_copy (_getc_in_t _in, _number_copy_type_en t, const char *src, char **psrc, char *dst, int size);
 
 static int   _read_char (_getc_in_t _in, const char *src, char **psrc, char *ch);
 static int _read_string (_getc_in_t _in, const char *src, char **psrc, char *dst);
@@ -171,15 +171,17 @@ static int _stream_getfirst (_getc_in_t _in, const char *src, char **psrc)
 /*!
  * \brief
  *    Copy the number characters from the stream to \a dst until
- *    a whitespace or termination character appears
+ *    a whitespace or termination character appears.
+ *    The characters that do not fit to \a dst are read but dropped.
  *
  * \param   _in   Callback function to use for input streaming
  * \param   src   Destination string (if any).
  * \param   dst   The pointer to return the first non-whitespace character
+ * \param   size  The size of dst
  *
- * \return        The number of number character from the stream
+ * \return        The number of number character copied to dst
  */
-static int _number_copy (_getc_in_t _in, _number_copy_type_en t, const char *src, char **psrc, char *dst)
+static int _number_copy (_getc_in_t _in, _number_copy_type_en t, const char *src, char **psrc, char *dst, int size)
 {
    int ch, n=0;
    int (*_isnumber) (char);
@@ -196,13 +198,14 @@ static int _number_copy (_getc_in_t _in, _number_copy_type_en t, const char *src
    ch = _in (src, (char**)&src, _GETC_HEAD);
    ++n;
    while ( _isnumber (ch) ) {
-      *dst++ = ch;
+      if (n < size)
+         *dst++ = ch;
       ch = _in (src, (char**)&src, _GETC_NEXT);
       ++n;
    }
    *dst = 0;               // Destination string termination
    *psrc = (char *)src;    // Update caller source pointer
-   return n-1;
+   return (n-1 < size-1) ? n-1 : size-1;
 }
 
 /*
@@ -313,7 +316,7 @@ static int _read_uint (_getc_in_t _in, const char *src, char **psrc, unsigned in
 
    // Init pointers
    num_pos = 1;
-   str_pos = _number_copy (_in, _INT, src, psrc, num_str);
+   str_pos = _number_copy (_in, _INT, src, psrc, num_str, sizeof (num_str));
    if (str_pos == 0)
       return 0;
    else
@@ -364,7 +367,7 @@ static int _read_int (_getc_in_t _in, const char *src, char **psrc, int *dst)
 
    // Init pointers
    num_pos = 1;
-   str_pos = _number_copy (_in, _INT, src, psrc, num_str);
+   str_pos = _number_copy (_in, _INT, src, psrc, num_str, sizeof (num_str));
    if (str_pos == 0)
       return 0;
    else
@@ -418,7 +421,7 @@ static int _read_hex (_getc_in_t _in, const char *src, char **psrc, unsigned int
 
    // Init pointers
    num_pos = 1;
-   str_pos = _number_copy (_in, _HEX, src, psrc, num_str);
+   str_pos = _number_copy (_in, _HEX, src, psrc, num_str, sizeof (num_str));
    if (str_pos == 0)
       return 0;
    else
@@ -498,43 +501,14 @@ static int _read_ffloat (_getc_in_t _in, const char *src, char **psrc, float *ds
 {
    char num_str[_IO_MAX_DOUBLE_WIDTH];    // number string
    int n;                                 // The read characters
-   int f;                                 // fractional index counters
-   int n_dec;                             // Decimal part
-   float n_frac=0;                        // Fractional part
-   float frac_pos = 0.1;                  // Fractional pos/multiplier
 
    // Get string
-   n = _number_copy (_in, _FLOAT, src, psrc, num_str);
+   n = _number_copy (_in, _FLOAT, src, psrc, num_str, sizeof (num_str));
    if (n == 0) return 0;
    else        --n;
 
-   // Find dot if any
-   for (f=0; f<_IO_MAX_DOUBLE_WIDTH; ++f) {
-      if ( IS_DOT (num_str[f]) )
-         break;
-   }
-
-   // Conversions
-   if (f != _IO_MAX_DOUBLE_WIDTH) {
-      // Fractional part conversion loop
-      ++f;
-      n_frac = 0;
-      do {
-         if ( IS_0TO9 (num_str[f]) )
-            n_frac += (num_str[f] - '0') * frac_pos;
-         else
-            break;
-         // update pointers
-         frac_pos *= 0.1;
-         ++f;
-      } while (num_str[f] && f<_IO_MAX_DOUBLE_WIDTH);
-   }
-   _read_int (_getc_src, num_str, (char **)&num_str, &n_dec);
-
-   if (n_dec<0)
-      *dst = n_dec - n_frac;
-   else
-      *dst = n_dec + n_frac;
+   // Correctly rounded conversion
+   *dst = (float)strtod_fast (num_str, NULL);
    return n;
 }
 
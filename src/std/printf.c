@@ -55,8 +55,8 @@ __Os__ int puts(const char *dst)
  */
 inline int vprintf(const char *frm, __VALIST ap)
 {
-   // Forward call NO buffer ;-)
-   return vsxprintf (_putc_usr, (char *)0, (char *)frm, ap);
+   // Forward call to a buffered sink
+   return vxprintf (_write_usr, (void *)0, frm, ap);
 }
 
 /*!
@@ -79,3 +79,39 @@ __Os__ int printf(const char *frm, ...)
    return result;
 }
 
+#if defined (PRINTF_FILES)
+/*!
+ * \brief
+ *    Outputs a formatted string on a file stream. Format arguments are given
+ *    in a va_list instance.
+ *
+ * \param fp     The file stream.
+ * \param frm    Format string.
+ * \param ap     Argument list.
+ */
+inline int vfprintf(FILE *fp, const char *frm, __VALIST ap)
+{
+   return vxprintf (_write_fil, (void *)fp, frm, ap);
+}
+
+/*!
+ * \brief
+ *    Outputs a formatted string on a file stream, using a variable number of
+ *    arguments.
+ *
+ * \param fp     The file stream.
+ * \param frm    Format string.
+ */
+__Os__ int fprintf(FILE *fp, const char *frm, ...)
+{
+   __VALIST ap;
+   int result;
+
+   va_start(ap, (char *)frm);
+   result = vfprintf(fp, frm, ap);
+   va_end(ap);
+
+   return result;
+}
+#endif
+
@@ -40,7 +40,25 @@
 inline int vsprintf(char *dst, const char *frm, va_list ap)
 {
    // Forward call NO buffer ;-)
-   return vsxprintf(_putc_dst, dst, (char *)frm, ap);
+   return vsnxprintf (dst, INT_MAX, frm, ap);
+}
+
+/*!
+ * \brief
+ *    Stores the result of a formatted string into another string of
+ *    limited size. Format arguments are given in a va_list instance.
+ *
+ * \param dst      Destination string.
+ * \param size     Destination size, including the null termination.
+ * \param frm      Format string.
+ * \param ap       Argument list.
+ *
+ * \return  The number of characters that the whole output needs, without
+ *          the null termination. If it is >= size the output is truncated.
+ */
+inline int vsnprintf(char *dst, size_t size, const char *frm, va_list ap)
+{
+   return vsnxprintf (dst, size, frm, ap);
 }
 
 
@@ -65,3 +83,24 @@ __Os__ int sprintf(char *dst, const char *frm, ...)
    return result;
 }
 
+/*!
+ * \brief
+ *    Writes a formatted string inside another string of limited size.
+ *
+ * \param dst    storage string.
+ * \param size   storage size, including the null termination.
+ * \param frm    Format string.
+ * \return  \see vsnprintf()
+ */
+__Os__ int snprintf(char *dst, size_t size, const char *frm, ...)
+{
+   __VALIST ap;
+   int result;
+
+   va_start(ap, (char *)frm);
+   result = vsnprintf(dst, size, frm, ap);
+   va_end(ap);
+
+   return result;
+}
+
@@ -33,30 +33,12 @@
 #include <std/stime.h>
 
 /*!
- *  days per month -- nonleap!
- */
-static const int _spm[13] =
-{
-   0,
-   (31),
-   (31+28),
-   (31+28+31),
-   (31+28+31+30),
-   (31+28+31+30+31),
-   (31+28+31+30+31+30),
-   (31+28+31+30+31+30+31),
-   (31+28+31+30+31+30+31+31),
-   (31+28+31+30+31+30+31+31+30),
-   (31+28+31+30+31+30+31+31+30+31),
-   (31+28+31+30+31+30+31+31+30+31+30),
-   (31+28+31+30+31+30+31+31+30+31+30+31),
-};
-
-/*!
- *  Time struct for conversions
+ *  Time struct for sgmtime() conversions
  */
 static struct tm _rt;
 
+#define _SPD   (86400)         /*!< Seconds per day */
+
 /*!
  * \brief
  *    Check if the given year is leap.
@@ -103,7 +85,7 @@ inline int isleap (int year) {
  *       - and is still in use by some communities
  *    #define TIME_CALENDAR   JULIAN_CALENDAR
  */
-__Os__ time_t smktime (struct tm *_t)
+__Os__ time_t smktime (const struct tm *_t)
 {
    unsigned int mon  = _TM_MON_2_MON (_t->tm_mon);
    unsigned int year = _TM_YEAR_2_YEAR (_t->tm_year);
@@ -127,11 +109,73 @@ __Os__ time_t smktime (struct tm *_t)
                      *60 + _t->tm_sec  );    /* finally add seconds */
 }
 
+/*!
+ * \brief
+ *    Fill a tm structure from a UNIX time. The date is calculated in constant
+ *    time with the days to civil algorithm of H. Hinnant. The days are shifted
+ *    to eras of 400 years that start on 1 March, so the leap day is the last
+ *    day of the era year and the month follows from the day of year.
+ *
+ * \param   t     The UNIX time
+ * \param   _tm   Pointer to tm structure to fill
+ */
+static inline void _gmtime (time_t t, struct tm *_tm)
+{
+   time_t   days = t / _SPD;
+   int32_t  secs = t % _SPD;
+   int32_t  era, doe, yoe, doy, mp, y;
+
+   if (secs < 0) {         // Times before epoch
+      secs += _SPD;
+      --days;
+   }
+   _tm->tm_sec  = secs % 60;     secs /= 60;
+   _tm->tm_min  = secs % 60;
+   _tm->tm_hour = secs / 60;
+   _tm->tm_wday = (days >= -4) ? (days + 4) % 7 : (days + 5) % 7 + 6;    // Day one was Thursday
+
+   days += 719468;         // Days from 0000-03-01
+   era = (days >= 0 ? days : days - 146096) / 146097;
+   doe = days - (time_t)era * 146097;                          // [0, 146096]
+   yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;      // [0, 399]
+   doy = doe - (365*yoe + yoe/4 - yoe/100);                    // [0, 365], from 1 March
+   mp  = (5*doy + 2) / 153;                                    // [0, 11], from March
+   y   = yoe + era*400 + (mp >= 10);
+
+   _tm->tm_year  = _YEAR_2_TM_YEAR (y);
+   _tm->tm_mon   = (mp < 10) ? mp + 2 : mp - 10;
+   _tm->tm_mday  = doy - (153*mp + 2)/5 + 1;
+   _tm->tm_yday  = (mp < 10) ? doy + 59 + isleap (y) : doy - 306;
+   _tm->tm_isdst = 0;
+}
+
+/*!
+ * \brief
+ *    Uses the value pointed by timer to fill a tm structure with the values
+ *    that represent the corresponding time, expressed as a UTC time
+ *    (i.e., the time at the GMT timezone).
+ * \note
+ *    This function is reentrant.
+ *
+ * \param  _timer    A pointer to an object of type time_t that contains a time value.
+ * \param  _tm       Pointer to the tm structure to fill.
+ * \return           The _tm pointer. The tm structure is in normal struct tm format,
+ *                   see \sa sgmtime()
+ */
+__Os__ struct tm *sgmtime_r (const time_t *_timer, struct tm *_tm)
+{
+   _gmtime (*_timer, _tm);
+   return _tm;
+}
+
 /*!
  * \brief
  *    Uses the value pointed by timer to fill a tm structure with the values
  *    that represent the corresponding time, expressed as a UTC time
  *    (i.e., the time at the GMT timezone).
+ * \note
+ *    The result is a static structure, so this function is not reentrant.
+ *    Use \sa sgmtime_r() instead.
  *
  * \param  _timer    A pointer to an object of type time_t that contains a time value.
  * \return           A pointer to a tm structure with its members filled with the values that
@@ -151,39 +195,36 @@ __Os__ time_t smktime (struct tm *_t)
  */
 __Os__ struct tm *sgmtime  (const time_t *_timer)
 {
-   #define _SPD   (86400)
-   time_t i, k;
-   time_t work = *_timer%_SPD;
-
-   _rt.tm_sec = work%60;    work /= 60;
-   _rt.tm_min = work%60;
-   _rt.tm_hour = work/60;   work = *_timer/_SPD;
-   _rt.tm_wday = (4+work)%7;   // Day one was Thursday
-   // Find the year
-   for (i=1970; 1 ; ++i) {
-      k = isleap(i) ? 366:365;
-      if (work >= k)
-         work -= k;
-      else
-         break;
-   }
-   _rt.tm_year = _YEAR_2_TM_YEAR (i);
-   _rt.tm_yday = work;
-   _rt.tm_mday = 1;
-   if (isleap(i) && (work>58)) {
-      if (work==59)  // Add leap day
-         _rt.tm_mday = 2;
-      work -= 1;
-   }
-
-   // Find month and month-day using struct tm month format
-   for (i=11; i && (_spm[i]>work); --i)
-      ;
-   _rt.tm_mon = i;
-   _rt.tm_mday += (work - _spm[i]);
+   return sgmtime_r (_timer, &_rt);
+}
 
-   #undef _SPD
-   return (struct tm *)&_rt;
+/*!
+ * \brief
+ *    Convert an array of UNIX times to tm structures \sa sgmtime_r().
+ *
+ * \param  _timer    Pointer to the UNIX times
+ * \param  _tm       Pointer to the tm structures to fill
+ * \param  n         The number of times
+ */
+__O3__ void sgmtime_n (const time_t *_timer, struct tm *_tm, uint32_t n)
+{
+   uint32_t i;
+   for (i=0 ; i<n ; ++i)
+      _gmtime (_timer[i], &_tm[i]);
 }
 
+/*!
+ * \brief
+ *    Convert an array of tm structures to UNIX times \sa smktime().
+ *
+ * \param  _tm       Pointer to the tm structures
+ * \param  _timer    Pointer to the UNIX times to fill
+ * \param  n         The number of times
+ */
+__O3__ void smktime_n (const struct tm *_tm, time_t *_timer, uint32_t n)
+{
+   uint32_t i;
+   for (i=0 ; i<n ; ++i)
+      _timer[i] = smktime (&_tm[i]);
+}
 
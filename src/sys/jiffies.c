@@ -27,6 +27,23 @@ static jf_t _jf;
 
 #define JF_MAX_TIM_VALUE      (0xFFFF)    // 16bit counters
 
+/*!
+ * \brief
+ *    Read the timer, from the read function if linked or from the value pointer
+ */
+static inline jiffy_t _value (void) {
+   return (_jf.read) ? _jf.read () : *_jf.value;
+}
+
+/*!
+ * \brief
+ *    Convert a time of \a unit parts of second to jiffies, rounded up.
+ *    The split on whole seconds keeps the product in 64 bits.
+ */
+static uint64_t _to_jiffies (uint64_t t, uint32_t unit) {
+   return (t / unit) * _jf.freq + ((t % unit) * _jf.freq + unit - 1) / unit;
+}
+
 /*
  * ======================   Public functions   ======================
  */
@@ -54,6 +71,16 @@ void jf_link_value (jiffy_t* v) {
    _jf.value = (v != 0) ? v : 0;
 }
 
+/*!
+ * \brief
+ *    Connect a timer read function to jiffy struct. When linked it is
+ *    used instead of the value pointer, for timers that can not be read
+ *    from memory or for a simulated timer.
+ */
+void jf_link_read (jf_read_pt pfun) {
+   _jf.read = (pfun != 0) ? pfun : 0;
+}
+
 
 
 /*
@@ -104,6 +131,9 @@ __Os__ drv_status_en jf_init (uint32_t jf_freq, jiffy_t jiffies)
       _jf.jp1ms = jf_per_msec ();
       _jf.jp1us = jf_per_usec ();
       _jf.jp100ns = jf_per_100nsec ();
+      _jf.ext = 0;
+      if (_jf.read || _jf.value)
+         _jf.last = _value ();
       return _jf.status = DRV_READY;
    }
    return _jf.status = DRV_NODEV;
@@ -125,7 +155,7 @@ inline jiffy_t jf_get_jiffies (void){
  *    in the MCU. Keep in mind that its value is a moving target!
  */
 inline jiffy_t jf_get_jiffy (void){
-   return *_jf.value;
+   return _value ();
 }
 
 /*!
@@ -198,13 +228,13 @@ __Os__ jiffy_t jf_per_100nsec (void)
  */
 __O3__ void jf_delay_ms (jtime_t msec)
 {
-   jtime_t m, m2, m1 = (jtime_t)*_jf.value;
+   jtime_t m, m2, m1 = (jtime_t)_value ();
 
    msec *= _jf.jp1ms;
 
    // Eat the time difference from msec value.
    do {
-      m2 = (jtime_t)(*_jf.value);
+      m2 = (jtime_t)_value ();
       m = m2 - m1;
       msec -= (m>=0) ? m : _jf.jiffies + m;
       m1 = m2;
@@ -221,15 +251,15 @@ __O3__ void jf_delay_ms (jtime_t msec)
  */
 __O3__ void jf_delay_us (jtime_t usec)
 {
-   jtime_t m, m2, m1 = (jtime_t)*_jf.value;
+   jtime_t m, m2, m1 = (jtime_t)_value ();
 
    usec *= _jf.jp1us;
-   if ((jtime_t)(*_jf.value) - m1 > usec) // Very small delays may return here.
+   if ((jtime_t)_value () - m1 > usec) // Very small delays may return here.
       return;
 
    // Eat the time difference from usec value.
    do {
-      m2 = (jtime_t)(*_jf.value);
+      m2 = (jtime_t)_value ();
       m = m2 - m1;
       usec -= (m>=0) ? m : _jf.jiffies + m;
       m1 = m2;
@@ -246,15 +276,15 @@ __O3__ void jf_delay_us (jtime_t usec)
  */
 __O3__ void jf_delay_100ns (jtime_t _100nsec)
 {
-   jtime_t m, m2, m1 = (jtime_t)*_jf.value;
+   jtime_t m, m2, m1 = (jtime_t)_value ();
 
    _100nsec *= _jf.jp100ns;
-   if ((jtime_t)(*_jf.value) - m1 > _100nsec) // Very small delays may return here.
+   if ((jtime_t)_value () - m1 > _100nsec) // Very small delays may return here.
       return;
 
    // Eat the time difference from _100nsec value.
    do {
-      m2 = (jtime_t)(*_jf.value);
+      m2 = (jtime_t)_value ();
       m = m2 - m1;
       _100nsec -= (m>=0) ? m : _jf.jiffies + m;
       m1 = m2;
@@ -278,13 +308,13 @@ __O3__ int jf_check_msec (jtime_t msec)
    jtime_t m, m2;
 
    if (m1 == -1) {
-      m1 = *_jf.value;
+      m1 = _value ();
       cnt = _jf.jp1ms * msec;
    }
 
    // Eat the time difference from msec value.
    if (cnt>0) {
-      m2 = (jtime_t)(*_jf.value);
+      m2 = (jtime_t)_value ();
       m = m2-m1;
       cnt -= (m>=0) ? m : _jf.jiffies + m;
       m1 = m2;
@@ -313,13 +343,13 @@ __O3__ int jf_check_usec (jtime_t usec)
    jtime_t m, m2;
 
    if (m1 == -1) {
-      m1 = *_jf.value;
+      m1 = _value ();
       cnt = _jf.jp1us * usec;
    }
 
    // Eat the time difference from usec value.
    if (cnt>0) {
-      m2 = (jtime_t)(*_jf.value);
+      m2 = (jtime_t)_value ();
       m = m2-m1;
       cnt -= (m>=0) ? m : _jf.jiffies + m;
       m1 = m2;
@@ -350,13 +380,13 @@ __O3__ int jf_check_100nsec (jtime_t _100nsec)
    jtime_t m, m2;
 
    if (m1 == -1) {
-      m1 = *_jf.value;
+      m1 = _value ();
       cnt = _jf.jp100ns * _100nsec;
    }
 
    // Eat the time difference from _100nsec value.
    if (cnt>0) {
-      m2 = (jtime_t)(*_jf.value);
+      m2 = (jtime_t)_value ();
       m = m2-m1;
       cnt -= (m>=0) ? m : _jf.jiffies + m;
       m1 = m2;
@@ -367,3 +397,75 @@ __O3__ int jf_check_100nsec (jtime_t _100nsec)
       return 0;   // do not wait any more
    }
 }
+
+/*!
+ * \brief
+ *    Return the extended 64bit jiffy count. The time passed from the
+ *    last call is added to a 64bit count, so the result is monotonic and
+ *    does not wrap for the life of the system.
+ * \note
+ *    It has to be called at least once every timer period (jiffies+1),
+ *    ex: from the SysTick or from the scheduler loop, else the extra
+ *    timer periods are lost. Not reentrant, call it from one context.
+ * \return  The jiffies passed since jf_init()
+ */
+uint64_t jf_now (void)
+{
+   jiffy_t v = _value ();
+   jtime_t m = (jtime_t)v - (jtime_t)_jf.last;
+
+   if (m < 0)
+      m += (jtime_t)_jf.jiffies + 1;
+   _jf.last = v;
+   return _jf.ext += m;
+}
+
+/*!
+ * \brief
+ *    Convert extended jiffies to usec
+ */
+uint64_t jf_to_usec (uint64_t jf) {
+   if (!_jf.freq)
+      return 0;
+   return (jf / _jf.freq) * 1000000 + ((jf % _jf.freq) * 1000000) / _jf.freq;
+}
+
+/*!
+ * \brief
+ *    Convert usec to extended jiffies, rounded up
+ */
+uint64_t jf_from_usec (uint64_t usec) {
+   return _to_jiffies (usec, 1000000);
+}
+
+/*!
+ * \brief
+ *    Non blocking delays. Return a deadline msec/usec/100nsec from now,
+ *    to check with jf_expired(). Unlike jf_check_xxx() there is no
+ *    hidden state, so any number of drivers can wait at the same time and
+ *    yield to other work until their deadline.
+ *    The conversion rounds up, so the delay is never shorter than requested.
+ * \param   msec/usec/_100nsec     The time from now
+ * \return  The deadline
+ */
+jf_deadline_t jf_deadline_ms (jtime_t msec) {
+   return jf_now () + ((msec > 0) ? _to_jiffies ((uint64_t)msec, 1000) : 0);
+}
+jf_deadline_t jf_deadline_us (jtime_t usec) {
+   return jf_now () + ((usec > 0) ? _to_jiffies ((uint64_t)usec, 1000000) : 0);
+}
+jf_deadline_t jf_deadline_100ns (jtime_t _100nsec) {
+   return jf_now () + ((_100nsec > 0) ? _to_jiffies ((uint64_t)_100nsec, 10000000) : 0);
+}
+
+/*!
+ * \brief
+ *    Check a deadline from jf_deadline_xx()
+ * \param   dl    The deadline
+ * \return
+ *    \arg  0:    The deadline is ongoing, yield and check again
+ *    \arg  1:    The deadline has passed
+ */
+int jf_expired (jf_deadline_t dl) {
+   return (jf_now () >= dl) ? 1 : 0;
+}
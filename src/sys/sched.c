@@ -0,0 +1,89 @@
+/*
+ * \file sched.c
+ * \brief
+ *    A cooperative round robin scheduler for protothread tasks
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <sys/sched.h>
+
+/*!
+ * \brief
+ *    Initialize a scheduler with no tasks
+ */
+void sched_init (sched_t *s)
+{
+   s->head = 0;
+   s->tasks = 0;
+   s->runs = 0;
+}
+
+/*!
+ * \brief
+ *    Add a task to the end of the round. It can be called from a task.
+ * \param   s     Pointer to the scheduler
+ * \param   t     Pointer to the task object
+ * \param   fun   The task function
+ * \param   arg   The task argument
+ */
+void sched_add (sched_t *s, sched_task_t *t, sched_task_ft fun, void *arg)
+{
+   sched_task_t **p = &s->head;
+
+   t->fun = fun;
+   t->arg = arg;
+   t->status = PT_PENDING;
+   t->next = 0;
+   while (*p)
+      p = &(*p)->next;
+   *p = t;
+   ++s->tasks;
+}
+
+/*!
+ * \brief
+ *    Call each task once and remove the ended ones.
+ * \param   s     Pointer to the scheduler
+ * \return  The number of running tasks
+ */
+uint32_t sched_run_once (sched_t *s)
+{
+   sched_task_t **p = &s->head, *t;
+
+   while ((t = *p) != 0) {
+      ++s->runs;
+      if ((t->status = t->fun (t->arg)) != PT_PENDING) {
+         *p = t->next;
+         --s->tasks;
+      }
+      else
+         p = &t->next;
+   }
+   return s->tasks;
+}
+
+/*!
+ * \brief
+ *    Run the tasks until they all end.
+ */
+void sched_run (sched_t *s)
+{
+   while (sched_run_once (s))
+      ;
+}
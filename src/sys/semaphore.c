@@ -22,6 +22,43 @@
 
 #include <sys/semaphore.h>
 
+#define _relaxed     memory_order_relaxed
+#define _acquire     memory_order_acquire
+#define _release     memory_order_release
+
+/*
+ * On Linux hosts the waiters sleep on a futex after SEM_SPIN spins.
+ * On the targets they spin, the post comes from an interrupt or an
+ * other core.
+ */
+#if defined(__linux__) && !defined(SEM_NO_FUTEX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define SEM_FUTEX
+#endif
+
+/*!
+ * \brief
+ *    CPU hint for spin loops
+ */
+static inline void _pause (void) {
+#if defined(__x86_64__) || defined(__i386__)
+   __builtin_ia32_pause ();
+#elif defined(__arm__) || defined(__aarch64__)
+   __asm__ volatile ("yield");
+#endif
+}
+
+#ifdef SEM_FUTEX
+static inline void _futex_wait (_Atomic int *a, int v) {
+   syscall (SYS_futex, (int*)a, FUTEX_WAIT_PRIVATE, v, NULL, NULL, 0);
+}
+static inline void _futex_wake (_Atomic int *a, int n) {
+   syscall (SYS_futex, (int*)a, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+#endif
+
 /*!
  * \brief
  *    Open/Initialize semaphore.
@@ -30,8 +67,10 @@
  * \param v    The initial value of semaphore.
  */
 __Os__ static void _sinit (sem_t *s, int v) {
-   if (s)
-      s->val = v;
+   if (s) {
+      atomic_init (&s->val, v);
+      atomic_init (&s->waiters, 0);
+   }
 }
 
 /*!
@@ -55,7 +94,8 @@ __Os__ inline void sem_init (sem_t* s, int v) {
  * \return  0
  */
 __Os__ int sem_close (sem_t *s) {
-   return s->val = 0;
+   atomic_store_explicit (&s->val, 0, _relaxed);
+   return 0;
 }
 
 /*!
@@ -66,7 +106,7 @@ __Os__ int sem_close (sem_t *s) {
  * \return The semaphore value
  */
 __O3__ inline int sem_getvalue (sem_t *s) {
-   return s->val;
+   return atomic_load_explicit (&s->val, _relaxed);
 }
 
 /*!
@@ -77,39 +117,53 @@ __O3__ inline int sem_getvalue (sem_t *s) {
  * \param  s pointer to semaphore used
  * \return true for positive semaphore value.
  *
- * \note Thread safe, not reentrant.
+ * \note Thread and interrupt safe, lock-free.
  */
 __O3__ int sem_check (sem_t *s)
 {
-   if (s->val>0) {
-      --s->val;
-      return 1;
-   }
-   else
-      return 0;
+   int v = atomic_load_explicit (&s->val, _relaxed);
+
+   while (v > 0)
+      if (atomic_compare_exchange_weak_explicit (&s->val, &v, v-1, _acquire, _relaxed))
+         return 1;
+   return 0;
 }
 
 /*!
  * \brief
- *    This function waits for a semaphore(spin-lock). If the semaphore
+ *    This function waits for a semaphore. If the semaphore
  *    is positive decreases it and continue.
+ *    It spins, and on Linux hosts it sleeps on a futex after SEM_SPIN spins.
  *
  * \param  s pointer to semaphore used
  * \return None
- * \note Thread safe, not reentrant.
+ * \note Thread safe.
  */
 __O3__ void sem_wait (sem_t *s)
 {
-   while (s->val<=0)
-      ;
-   --s->val;
+   for (int spin=0 ; !sem_check (s) ; ++spin) {
+#ifdef SEM_FUTEX
+      if (spin >= SEM_SPIN) {
+         atomic_fetch_add (&s->waiters, 1);
+         _futex_wait (&s->val, 0);     // Sleeps only while val is 0
+         atomic_fetch_sub (&s->waiters, 1);
+         continue;
+      }
+#endif
+      _pause ();
+   }
 }
 
 /*!
- * \brief Increase the semaphores value
+ * \brief Increase the semaphores value. Wakes a sleeping waiter if any.
+ * \note Thread and interrupt safe.
  */
 __O3__ inline void sem_post (sem_t *s) {
-   ++s->val;
+   atomic_fetch_add (&s->val, 1);
+#ifdef SEM_FUTEX
+   if (atomic_load (&s->waiters))
+      _futex_wake (&s->val, 1);
+#endif
 }
 
 
@@ -126,7 +180,7 @@ __O3__ inline void sem_post (sem_t *s) {
  * \param v    The initial value of mutex.
 */
 __Os__ inline void mut_init (sem_t* m, int v) {
-   _sinit (m, v);
+   _sinit (m, (v) ? 1 : 0);
 }
 
 /*!
@@ -137,13 +191,14 @@ __Os__ inline void mut_init (sem_t* m, int v) {
  * \return  0
  */
 __Os__ int mut_close (sem_t *m) {
-   return m->val = 0;
+   atomic_store_explicit (&m->val, 0, _relaxed);
+   return 0;
 }
 
 /*!
  * \brief
  *    This function checks for a mutex.
- *    If its zero (unlocked) increases it and return true.
+ *    If its zero (unlocked) locks it and return true.
  *    Else return false (already locked)
  *
  * \param  s pointer to mutex used
@@ -151,39 +206,48 @@ __Os__ int mut_close (sem_t *m) {
  *    \arg  0  Fail to lock, mutex already locked
  *    \arg  1  Success, mutex is locked by the function
  *
- * \note Thread safe, not reentrant.
+ * \note Thread and interrupt safe, lock-free.
  */
 __O3__ int mut_trylock (sem_t *m)
 {
-   if (m->val<=0) {
-      m->val = 1;
-      return 1;
-   }
-   else
-      return 0;
+   int v = 0;
+   return atomic_compare_exchange_strong_explicit (&m->val, &v, 1, _acquire, _relaxed);
 }
 
 /*!
  * \brief
- *    This function waits for a mutex (spin-lock).
- *    If is zero(unlocked), increases it and continue.
- *    If the mutex is positive(1, already locked) waits.
+ *    This function waits for a mutex.
+ *    If is zero(unlocked), locks it and continue.
+ *    If the mutex is locked waits. It spins, and on Linux hosts
+ *    it marks the mutex contended and sleeps on a futex after SEM_SPIN spins.
  *
  * \param  s pointer to mutex used
  * \return None
- * \note Thread safe, not reentrant.
+ * \note Thread safe.
  */
 __O3__ inline void mut_lock (sem_t *m)
 {
-   while (m->val>0)
-      ;
-   m->val = 1;
+   for (int spin=0 ; !mut_trylock (m) ; ++spin) {
+#ifdef SEM_FUTEX
+      if (spin >= SEM_SPIN) {
+         // Mark contended, the unlock has to wake us
+         while (atomic_exchange_explicit (&m->val, 2, _acquire) != 0)
+            _futex_wait (&m->val, 2);
+         return;
+      }
+#endif
+      _pause ();
+   }
 }
 
 /*!
- * Unlock (by setting low) the semaphore.
+ * Unlock the mutex. Wakes a sleeping waiter if any.
 */
 __O3__ inline void mut_unlock (sem_t *m) {
-   m->val = 0;
+#ifdef SEM_FUTEX
+   if (atomic_exchange_explicit (&m->val, 0, _release) == 2)
+      _futex_wake (&m->val, 1);
+#else
+   atomic_store_explicit (&m->val, 0, _release);
+#endif
 }
-
@@ -0,0 +1,303 @@
+/*
+ * \file twheel.c
+ * \brief
+ *    A hierarchical timer wheel for one-shot and periodic callbacks
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <sys/twheel.h>
+
+#define TW_SPAN         ((uint64_t)1 << (TW_SLOT_BITS * TW_LEVELS))
+
+/*
+ * ------------ Static API ------------------
+ */
+
+static inline void _link (tw_node_t *h, tw_node_t *n) {
+   n->prev = h->prev;
+   n->next = h;
+   h->prev->next = n;
+   h->prev = n;
+}
+
+static inline void _unlink (tw_node_t *n) {
+   n->prev->next = n->next;
+   n->next->prev = n->prev;
+}
+
+/*!
+ * \brief
+ *    Move the list of \a from to the empty head \a to
+ */
+static inline void _move (tw_node_t *from, tw_node_t *to) {
+   to->next = from->next;
+   to->prev = from->prev;
+   to->next->prev = to;
+   to->prev->next = to;
+   from->next = from->prev = from;
+}
+
+/*!
+ * \brief
+ *    Link a timer to the slot of its expire tick. The level is
+ *    the first one that spans the distance to the expire tick.
+ *    Expired timers go to the next tick and timers beyond the wheel
+ *    to the furthest slot, they find their place on cascade.
+ */
+static void _insert (tw_t *w, tw_timer_t *t)
+{
+   uint64_t e = t->expires, d;
+   int      l, s;
+
+   if ((int64_t)(e - w->tick) < 0)
+      e = w->tick;
+   d = e - w->tick;
+   if (d >= TW_SPAN)
+      e = w->tick + TW_SPAN - 1;
+
+   for (l=0 ; l<TW_LEVELS-1 ; ++l)
+      if (d < ((uint64_t)1 << (TW_SLOT_BITS * (l+1))))
+         break;
+   s = (int)(e >> (TW_SLOT_BITS * l)) & TW_SLOT_MASK;
+
+   t->slot = (uint16_t)(l*TW_SLOTS + s);
+   t->active = 1;
+   _link (&w->slot[t->slot], &t->node);
+   w->occ[l] |= (uint64_t)1 << s;
+}
+
+/*!
+ * \brief
+ *    Re-insert the timers of a slot of a higher level, to their
+ *    place in the lower levels.
+ * \return  The slot index
+ */
+static int _cascade (tw_t *w, int l)
+{
+   tw_node_t   lst;
+   int         s = (int)(w->tick >> (TW_SLOT_BITS * l)) & TW_SLOT_MASK;
+
+   if (w->occ[l] & ((uint64_t)1 << s)) {
+      _move (&w->slot[l*TW_SLOTS + s], &lst);
+      w->occ[l] &= ~((uint64_t)1 << s);
+      while (lst.next != &lst) {
+         tw_node_t *n = lst.next;
+         _unlink (n);
+         _insert (w, (tw_timer_t*)n);
+      }
+   }
+   return s;
+}
+
+/*!
+ * \brief
+ *    Process the current tick. Cascade on a level 0 wrap and fire
+ *    the timers of the level 0 slot.
+ * \return  The number of fired timers
+ */
+static uint32_t _run (tw_t *w)
+{
+   tw_node_t   lst;
+   uint32_t    cnt = 0;
+   int         s = (int)w->tick & TW_SLOT_MASK;
+
+   if (s == 0)
+      for (int l=1 ; l<TW_LEVELS && _cascade (w, l) == 0 ; ++l)
+         ;
+
+   if (!(w->occ[0] & ((uint64_t)1 << s))) {
+      ++w->tick;
+      return 0;
+   }
+   _move (&w->slot[s], &lst);
+   w->occ[0] &= ~((uint64_t)1 << s);
+   ++w->tick;     // The callbacks see this tick as passed
+
+   // Pop one at a time, the callbacks may add or delete timers
+   while (lst.next != &lst) {
+      tw_timer_t *t = (tw_timer_t*)lst.next;
+
+      _unlink (&t->node);
+      t->active = 0;
+      --w->timers;
+      if (t->period) {
+         t->expires += t->period;
+         _insert (w, t);
+         ++w->timers;
+      }
+      ++cnt;
+      t->cb (t->arg);
+   }
+   return cnt;
+}
+
+
+/*
+ *  ============= PUBLIC Timer wheel API =============
+ */
+
+/*!
+ * \brief
+ *    Initialize a timer wheel.
+ * \param   w     Pointer to the wheel
+ * \param   now   The current time in ticks, ex: jf_now() or clock()
+ */
+void tw_init (tw_t *w, uint64_t now)
+{
+   memset ((void*)w, 0, sizeof (tw_t));
+   for (int i=0 ; i<TW_LEVELS*TW_SLOTS ; ++i)
+      w->slot[i].next = w->slot[i].prev = &w->slot[i];
+   w->tick = now + 1;
+}
+
+/*!
+ * \brief
+ *    The current time of the wheel, the last tick processed.
+ */
+__INLINE uint64_t tw_now (tw_t *w) {
+   return w->tick - 1;
+}
+
+/*!
+ * \brief
+ *    Start a timer at an absolute tick. An active timer is re-started.
+ *    O(1).
+ * \param   w        Pointer to the wheel
+ * \param   t        Pointer to the timer
+ * \param   expires  The tick to expire. Passed ticks expire on the next tick.
+ * \param   period   The period of a periodic timer, 0 for one-shot
+ * \param   cb       The callback
+ * \param   arg      The callback argument
+ */
+void tw_add_at (tw_t *w, tw_timer_t *t, uint64_t expires, uint32_t period, tw_cb_ft cb, void *arg)
+{
+   tw_del (w, t);
+   t->expires = expires;
+   t->period = period;
+   t->cb = cb;
+   t->arg = arg;
+   _insert (w, t);
+   ++w->timers;
+}
+
+/*!
+ * \brief
+ *    Start a timer \a delay ticks from now. A delay of 0 expires on the next tick.
+ *    \see tw_add_at()
+ */
+void tw_add (tw_t *w, tw_timer_t *t, uint32_t delay, uint32_t period, tw_cb_ft cb, void *arg) {
+   tw_add_at (w, t, tw_now (w) + delay, period, cb, arg);
+}
+
+/*!
+ * \brief
+ *    Stop a timer. O(1).
+ * \param   w     Pointer to the wheel
+ * \param   t     Pointer to the timer
+ * \return
+ *    \arg  0     The timer was not active
+ *    \arg  1     The timer stopped
+ */
+int tw_del (tw_t *w, tw_timer_t *t)
+{
+   tw_node_t *h;
+
+   if (!t->active)
+      return 0;
+   _unlink (&t->node);
+   h = &w->slot[t->slot];
+   if (h->next == h)
+      w->occ[t->slot >> TW_SLOT_BITS] &= ~((uint64_t)1 << (t->slot & TW_SLOT_MASK));
+   t->active = 0;
+   --w->timers;
+   return 1;
+}
+
+/*!
+ * \brief
+ *    Check if a timer is active
+ */
+__INLINE int tw_pending (tw_timer_t *t) {
+   return t->active;
+}
+
+/*!
+ * \brief
+ *    Advance the wheel up to \a now and fire the expired timers, in
+ *    expire order. Empty ticks are skipped up to the next non empty
+ *    level 0 slot or the next level 0 wrap, so the cost does not follow
+ *    the time passed.
+ * \param   w     Pointer to the wheel
+ * \param   now   The current time in ticks
+ * \return  The number of fired timers
+ */
+uint32_t tw_advance (tw_t *w, uint64_t now)
+{
+   uint32_t cnt = 0;
+   uint64_t m, nx;
+   int      s;
+
+   while ((int64_t)(now - w->tick) >= 0) {
+      s = (int)w->tick & TW_SLOT_MASK;
+      if (s != 0) {
+         // Skip the empty level 0 slots up to the wrap
+         m = w->occ[0] >> s;
+         nx = (m) ? w->tick + __builtin_ctzll (m) : (w->tick | TW_SLOT_MASK) + 1;
+         if ((int64_t)(now - nx) < 0) {
+            w->tick = now + 1;
+            break;
+         }
+         w->tick = nx;
+         if (!m)
+            continue;
+      }
+      cnt += _run (w);
+   }
+   return cnt;
+}
+
+/*!
+ * \brief
+ *    The earliest tick a timer can expire. Until then tw_advance() has
+ *    nothing to do, so a tickless system can sleep up to there.
+ *    With timers on the upper levels it is at most the next level 0
+ *    wrap, where they cascade.
+ * \param   w     Pointer to the wheel
+ * \return  The tick, or UINT64_MAX for an empty wheel
+ */
+uint64_t tw_next (tw_t *w)
+{
+   int      s = (int)w->tick & TW_SLOT_MASK;
+   uint64_t m = w->occ[0] >> s;
+   uint64_t wrap = (w->tick | TW_SLOT_MASK) + 1;
+   int      up = 0;
+
+   for (int l=1 ; l<TW_LEVELS ; ++l)
+      up |= (w->occ[l] != 0);
+   // The next tick is a wrap, its cascade may bring earlier timers to level 0
+   if (s == 0 && up)
+      return w->tick;
+   if (m)
+      return w->tick + __builtin_ctzll (m);
+   if (up)
+      return wrap;
+   if (w->occ[0])
+      return wrap + __builtin_ctzll (w->occ[0]);
+   return UINT64_MAX;
+}
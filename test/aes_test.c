@@ -0,0 +1,362 @@
+/*!
+ * \file aes_test.c
+ * \brief
+ *    Host test of the AES modes. It checks the NIST SP 800-38A CBC and CTR
+ *    vectors and the SP 800-38D GCM test cases on the AES-NI and on the
+ *    portable backend, the tag rejection of GCM, the two backends against
+ *    each other over random lengths and a counter wraparound, and measures
+ *    the throughput of both backends.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc aes_test.c ../src/crypt/aes.c -o aes_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <crypt/aes.h>
+#include "bench.h"
+
+#define MAXLEN    (1024)
+#define BENCH     (1 << 22)
+
+/*!
+ * SP 800-38A F.2 and F.5, the same plaintext for all the keys
+ */
+typedef struct {
+   const char  *key;
+   const char  *cbc;    /*!< CBC ciphertext, iv 000102...0f */
+   const char  *ctr;    /*!< CTR ciphertext, counter f0f1...ff */
+}sp38a_t;
+
+/*!
+ * SP 800-38D, the test cases of the GCM specification
+ */
+typedef struct {
+   int         tc;
+   const char  *key, *iv, *p, *a, *c, *t;
+}sp38d_t;
+
+static const char *P38a =
+   "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+   "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+
+static const sp38a_t v38a[] = {
+   {  "2b7e151628aed2a6abf7158809cf4f3c",
+      "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+      "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7",
+      "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+      "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee" },
+   {  "8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+      "4f021db243bc633d7178183a9fa071e8b4d9ada9ad7dedf4e5e738763f69145a"
+      "571b242012fb7ae07fa9baac3df102e008b0e27988598881d920a9e64f5615cd",
+      "1abc932417521ca24f2b0459fe7e6e0b090339ec0aa6faefd5ccc2c6f4ce8e94"
+      "1e36b26bd1ebc670d1bd1d665620abf74f78a7f6d29809585a97daec58c6b050" },
+   {  "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+      "f58c4c04d6e5f1ba779eabfb5f7bfbd69cfc4e967edb808d679f777bc6702c7d"
+      "39f23369a9d9bacfa530e26304231461b2eb05e2c39be9fcda6c19078c6a9d1b",
+      "601ec313775789a5b7a7f504bbf3d228f443e3ca4d62b59aca84e990cacaf5c5"
+      "2b0930daa23de94ce87017ba2d84988ddfc9c58db67aada613c2dd08457941a6" },
+};
+
+#define K128      "feffe9928665731c6d6a8f9467308308"
+#define P64       "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72" \
+                  "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255"
+#define P60       "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72" \
+                  "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39"
+#define A20       "feedfacedeadbeeffeedfacedeadbeefabaddad2"
+
+static const sp38d_t v38d[] = {
+   {  1, "00000000000000000000000000000000", "000000000000000000000000", "", "", "",
+         "58e2fccefa7e3061367f1d57a4e7455a" },
+   {  2, "00000000000000000000000000000000", "000000000000000000000000",
+         "00000000000000000000000000000000", "",
+         "0388dace60b6a392f328c2b971b2fe78",
+         "ab6e47d42cec13bdf53a67b21257bddf" },
+   {  3, K128, "cafebabefacedbaddecaf888", P64, "",
+         "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+         "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+         "4d5c2af327cd64a62cf35abd2ba6fab4" },
+   {  4, K128, "cafebabefacedbaddecaf888", P60, A20,
+         "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+         "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+         "5bc94fbc3221a5db94fae95ae7121a47" },
+   {  5, K128, "cafebabefacedbad", P60, A20,
+         "61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c7423"
+         "73806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+         "3612d2e79e3b0785561be14aaca2fccb" },
+   {  6, K128,
+         "9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+         "c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b", P60, A20,
+         "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca7"
+         "01e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+         "619cc5aefffe0bfa462af43c1699d050" },
+   { 10, K128 "feffe9928665731c", "cafebabefacedbaddecaf888", P60, A20,
+         "3980ca0b3c00e841eb06fac4872a2757859e1ceaa6efd984628593b40ca1e19c"
+         "7d773d00c144c525ac619d18c84a3f4718e2448b2fe324d9ccda2710",
+         "2519498e80f1478f37ba55bd6d27618c" },
+   { 13, "0000000000000000000000000000000000000000000000000000000000000000",
+         "000000000000000000000000", "", "", "",
+         "530f8afbc74536b9a963b4f1c4cb738b" },
+   { 14, "0000000000000000000000000000000000000000000000000000000000000000",
+         "000000000000000000000000", "00000000000000000000000000000000", "",
+         "cea7403d4d606b6e074ec5d3baf39d18",
+         "d0d1c8a799996bf0265b98b5d48ab919" },
+   { 16, K128 K128, "cafebabefacedbaddecaf888", P60, A20,
+         "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+         "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+         "76fc6ece0f4e1768cddf8853bb2d551b" },
+};
+
+static uint8_t buf[BENCH];
+
+/*
+ * Hex string to bytes, returns the length
+ */
+static size_t _hex (const char *s, uint8_t *b)
+{
+   size_t n;
+   unsigned int v;
+
+   for (n=0 ; s[2*n] ; ++n) {
+      sscanf (&s[2*n], "%2x", &v);
+      b[n] = (uint8_t)v;
+   }
+   return n;
+}
+
+static void _key (aes_t *ctx, const char *key)
+{
+   uint8_t k[32];
+
+   switch (_hex (key, k)) {
+      case 16: aes128_key_init (ctx, k); break;
+      case 24: aes192_key_init (ctx, k); break;
+      default: aes256_key_init (ctx, k); break;
+   }
+}
+
+/*
+ * SP 800-38A, whole and in two pieces to check the chaining of the iv and
+ * the counter
+ */
+static int _check_38a (void)
+{
+   static const uint8_t iv0[16] = {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+   };
+   aes_t    ctx;
+   uint8_t  p[64], c[64], y[64], iv[16];
+   size_t   i, j, n;
+   int      err = 0;
+
+   n = _hex (P38a, p);
+   for (i=0 ; i<sizeof (v38a) / sizeof (v38a[0]) ; ++i) {
+      _key (&ctx, v38a[i].key);
+
+      _hex (v38a[i].cbc, c);
+      memcpy ((void*)iv, iv0, 16);
+      err += (aes_cbc_encrypt (&ctx, iv, p, y, 16) != 1);
+      err += (aes_cbc_encrypt (&ctx, iv, &p[16], &y[16], n-16) != 1);
+      err += (memcmp (y, c, n) != 0);
+      memcpy ((void*)iv, iv0, 16);
+      err += (aes_cbc_decrypt (&ctx, iv, y, y, n) != 1);          // In place
+      err += (memcmp (y, p, n) != 0);
+      err += (aes_cbc_encrypt (&ctx, iv, p, y, 15) != 0);
+
+      _hex (v38a[i].ctr, c);
+      for (j=0 ; j<16 ; ++j)
+         iv[j] = 0xf0 + j;
+      aes_ctr (&ctx, iv, p, y, 32);
+      aes_ctr (&ctx, iv, &p[32], &y[32], 32);
+      err += (memcmp (y, c, 64) != 0);
+      for (j=0 ; j<16 ; ++j)
+         iv[j] = 0xf0 + j;
+      aes_ctr (&ctx, iv, y, y, 64);
+      err += (memcmp (y, p, 64) != 0);
+   }
+   if (err)
+      printf ("SP 800-38A: %d errors\n", err);
+   return err;
+}
+
+/*
+ * SP 800-38D, the encryption, the decryption and a rejected tag for each
+ * bit position class: the ciphertext, the aad and the tag
+ */
+static int _check_38d (void)
+{
+   aes_t       ctx;
+   aes_gcm_t   gcm;
+   uint8_t     iv[64], p[64], a[32], c[64], t[16], y[64], yt[16];
+   size_t      i, niv, np, na;
+   int         err = 0, e;
+
+   for (i=0 ; i<sizeof (v38d) / sizeof (v38d[0]) ; ++i) {
+      e = 0;
+      _key (&ctx, v38d[i].key);
+      aes_gcm_init (&gcm, &ctx);
+      niv = _hex (v38d[i].iv, iv);
+      np = _hex (v38d[i].p, p);
+      na = _hex (v38d[i].a, a);
+      _hex (v38d[i].c, c);
+      _hex (v38d[i].t, t);
+
+      aes_gcm_encrypt (&gcm, iv, niv, a, na, p, y, np, yt, 16);
+      e += (memcmp (y, c, np) != 0);
+      e += (memcmp (yt, t, 16) != 0);
+      aes_gcm_encrypt (&gcm, iv, niv, a, na, p, y, np, yt, 8);    // Truncated tag
+      e += (memcmp (yt, t, 8) != 0);
+
+      memset ((void*)y, 0, sizeof (y));
+      e += (aes_gcm_decrypt (&gcm, iv, niv, a, na, c, y, np, t, 16) != 1);
+      e += (memcmp (y, p, np) != 0);
+      e += (aes_gcm_decrypt (&gcm, iv, niv, a, na, c, y, np, t, 12) != 1);
+
+      t[15] ^= 0x01;
+      memset ((void*)y, 0xAA, sizeof (y));
+      e += (aes_gcm_decrypt (&gcm, iv, niv, a, na, c, y, np, t, 16) != 0);
+      for (size_t k=0 ; k<np ; ++k)
+         e += (y[k] != 0);
+      t[15] ^= 0x01;
+      if (np) {
+         c[np-1] ^= 0x80;
+         e += (aes_gcm_decrypt (&gcm, iv, niv, a, na, c, y, np, t, 16) != 0);
+         c[np-1] ^= 0x80;
+      }
+      if (na) {
+         a[0] ^= 0x01;
+         e += (aes_gcm_decrypt (&gcm, iv, niv, a, na, c, y, np, t, 16) != 0);
+         a[0] ^= 0x01;
+      }
+      e += (aes_gcm_decrypt (&gcm, iv, niv, a, na, c, y, np, t, 0) != 0);
+      if (e)
+         printf ("SP 800-38D test case %d: %d errors\n", v38d[i].tc, e);
+      err += e;
+   }
+   return err;
+}
+
+/*
+ * The two backends against each other, random lengths and offsets, and the
+ * counters over their 32 and 64 bit boundaries
+ */
+static int _check_backends (void)
+{
+   static uint8_t x[MAXLEN], y[2][MAXLEN], tg[2][16];
+   aes_t       ctx;
+   aes_gcm_t   gcm;
+   uint8_t     k[32], iv[2][16], ctr[16], aad[40];
+   size_t      n, o, na;
+   int         err = 0, r, b;
+
+   for (r=0 ; r<400 ; ++r) {
+      for (n=0 ; n<32 ; ++n)
+         k[n] = rand ();
+      switch (r % 3) {
+         case 0: aes128_key_init (&ctx, k); break;
+         case 1: aes192_key_init (&ctx, k); break;
+         default: aes256_key_init (&ctx, k); break;
+      }
+      aes_gcm_init (&gcm, &ctx);
+      n = rand () % (MAXLEN - 16);
+      o = rand () % 16;
+      na = rand () % sizeof (aad);
+      for (size_t i=0 ; i<n+o ; ++i)
+         x[i] = rand ();
+      for (size_t i=0 ; i<na ; ++i)
+         aad[i] = rand ();
+      for (size_t i=0 ; i<16 ; ++i)
+         ctr[i] = rand ();
+      if (r % 4 == 0)
+         memset ((void*)&ctr[8], 0xFF, 7);   // Near the 64 bit wrap
+      if (r % 4 == 1)
+         memset ((void*)&ctr[12], 0xFF, 3);  // Near the 32 bit wrap of GCM
+
+      for (b=0 ; b<2 ; ++b) {
+         aes_ni_enable (b);
+         memcpy ((void*)iv[b], ctr, 16);
+         aes_ctr (&ctx, iv[b], x+o, y[b], n);
+         aes_gcm_encrypt (&gcm, ctr, 12, aad, na, y[b], y[b], n, tg[b], 16);
+      }
+      err += (memcmp (y[0], y[1], n) != 0);
+      err += (memcmp (iv[0], iv[1], 16) != 0);
+      err += (memcmp (tg[0], tg[1], 16) != 0);
+
+      n &= ~(size_t)0x0F;
+      for (b=0 ; b<2 ; ++b) {
+         aes_ni_enable (b);
+         memcpy ((void*)iv[b], ctr, 16);
+         aes_cbc_encrypt (&ctx, iv[b], x+o, y[b], n);
+      }
+      err += (memcmp (y[0], y[1], n) != 0);
+      err += (memcmp (iv[0], iv[1], 16) != 0);
+      for (b=0 ; b<2 ; ++b) {
+         aes_ni_enable (b);
+         memcpy ((void*)iv[b], ctr, 16);
+         aes_cbc_decrypt (&ctx, iv[b], y[b], y[b], n);
+         err += (memcmp (y[b], x+o, n) != 0);
+      }
+      err += (memcmp (iv[0], iv[1], 16) != 0);
+   }
+   aes_ni_enable (1);
+   if (err)
+      printf ("backends: %d mismatches\n", err);
+   return err;
+}
+
+static void _bench (int ni)
+{
+   aes_t       ctx;
+   aes_gcm_t   gcm;
+   uint8_t     k[16] = {0}, iv[16] = {0}, tag[16];
+   double      t0, t1, t2, t3;
+
+   aes128_key_init (&ctx, k);
+   aes_gcm_init (&gcm, &ctx);
+   t0 = _now ();
+   aes_ctr (&ctx, iv, buf, buf, BENCH);
+   t1 = _now ();
+   aes_cbc_decrypt (&ctx, iv, buf, buf, BENCH);
+   t2 = _now ();
+   aes_gcm_encrypt (&gcm, iv, 12, NULL, 0, buf, buf, BENCH, tag, 16);
+   t3 = _now ();
+   printf ("%s CTR %8.1f MB/s, CBC decrypt %8.1f MB/s, GCM %8.1f MB/s\n",
+           (ni) ? "AES-NI:  " : "portable:",
+           BENCH / (t1-t0) / 1e6, BENCH / (t2-t1) / 1e6, BENCH / (t3-t2) / 1e6);
+}
+
+int main (void)
+{
+   int err = 0, ni;
+
+   srand (1);
+   for (ni=1 ; ni>=0 ; --ni) {
+      if (aes_ni_enable (ni) != ni) {
+         printf ("no AES-NI, only the portable backend is checked\n");
+         continue;
+      }
+      err += _check_38a ();
+      err += _check_38d ();
+      _bench (ni);
+   }
+   if (aes_ni_enable (1))
+      err += _check_backends ();
+   printf ("aes: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
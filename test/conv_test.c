@@ -0,0 +1,274 @@
+/*!
+ * \file conv_test.c
+ * \brief
+ *    Host test of the FFT convolution. It checks conv_xx()/conv_fft_xx() and
+ *    xcorr_xx()/xcorr_fft_xx() against a long double direct sum for sizes
+ *    around CONV_FFT_THRESHOLD, the overlap-save convolver against the direct
+ *    convolution for block lengths across the block boundaries, and times the
+ *    direct form against the FFT to show the crossover.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc conv_test.c ../src/dsp/conv.c ../src/dsp/xcorr.c ../src/dsp/fft.c ../src/dsp/vectors.c ../src/math/math.c -lm -o conv_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <dsp/conv.h>
+#include <dsp/xcorr.h>
+#include "bench.h"
+
+#define MAXS      (1100)      // Largest signal checked
+#define OLS_N     (20000)     // Samples through the overlap-save convolver
+#define BENCH_X   (4096)      // Signal size of the long signal timing
+
+typedef long double _Complex  complex_l_t;
+
+static const int32_t sizes[] = { 1, 2, 7, CONV_FFT_THRESHOLD-1, CONV_FFT_THRESHOLD,
+                                 CONV_FFT_THRESHOLD+1, 64, 100, 257, 1000 };
+
+static double        hd[MAXS], xd[MAXS], yd[2*MAXS];
+static float         hf[MAXS], xf[MAXS], yf[2*MAXS];
+static complex_d_t   hcd[MAXS], xcd[MAXS], ycd[2*MAXS];
+static complex_f_t   hcf[MAXS], xcf[MAXS], ycf[2*MAXS];
+static complex_l_t   hl[MAXS], xl[MAXS], rl[2*MAXS];
+static double        ox[OLS_N], oy[OLS_N], oref[OLS_N + MAXS];
+static double        bx[BENCH_X], by[2*BENCH_X];
+
+static double _rnd (void) {
+   return (double)rand () / RAND_MAX * 2 - 1;
+}
+
+/*
+ * Long double direct convolution, or correlation with the conjugated x
+ */
+static void _ref (complex_l_t *h, int32_t sh, complex_l_t *x, int32_t sx, int corr)
+{
+   int32_t n, k;
+
+   for (n=0 ; n<sh+sx-1 ; ++n) {
+      rl[n] = 0;
+      for (k=0 ; k<sh ; ++k) {
+         if (corr) {
+            if (sx-1-(n-k) >= 0 && sx-1-(n-k) < sx)
+               rl[n] += h[k] * conjl (x[sx-1-(n-k)]);
+         }
+         else if (n-k >= 0 && n-k < sx)
+            rl[n] += h[k] * x[n-k];
+      }
+   }
+}
+
+/*
+ * Maximum error relative to the largest reference point
+ */
+#define _rel_err(_y, _n)   ({                                  \
+   long double _e = 0, _r = 0;                                 \
+   for (int32_t _i=0 ; _i<(_n) ; ++_i) {                       \
+      if (cabsl ((_y)[_i] - rl[_i]) > _e) _e = cabsl ((_y)[_i] - rl[_i]); \
+      if (cabsl (rl[_i]) > _r)            _r = cabsl (rl[_i]); \
+   }                                                           \
+   (double)(_e / _r);                                          \
+})
+
+static int _report (const char *what, int32_t sh, int32_t sx, double e, double tol)
+{
+   if (e <= tol)
+      return 0;
+   printf ("%s sh=%d sx=%d: error %g > %g\n", what, sh, sx, e, tol);
+   return 1;
+}
+
+/*
+ * All the floating point types, the automatic and the explicit FFT path,
+ * convolution and correlation
+ */
+static int _check (int32_t sh, int32_t sx)
+{
+   int32_t i, ny = sh + sx - 1;
+   int err = 0, corr;
+
+   for (i=0 ; i<sh ; ++i) {
+      hcd[i] = _rnd () + I*_rnd ();
+      hd[i] = creal (hcd[i]);
+      hf[i] = hd[i];
+      hcf[i] = hcd[i];
+   }
+   for (i=0 ; i<sx ; ++i) {
+      xcd[i] = _rnd () + I*_rnd ();
+      xd[i] = creal (xcd[i]);
+      xf[i] = xd[i];
+      xcf[i] = xcd[i];
+   }
+   for (corr=0 ; corr<2 ; ++corr) {
+      // Real
+      for (i=0 ; i<sh ; ++i)  hl[i] = hd[i];
+      for (i=0 ; i<sx ; ++i)  xl[i] = xd[i];
+      _ref (hl, sh, xl, sx, corr);
+      if (corr) {
+         xcorr_d (yd, hd, sh, xd, sx);    err += _report ("xcorr_d", sh, sx, _rel_err (yd, ny), 1e-14);
+         xcorr_f (yf, hf, sh, xf, sx);    err += _report ("xcorr_f", sh, sx, _rel_err (yf, ny), 1e-5);
+         if (sh>1 || sx>1) {
+            xcorr_fft_d (yd, hd, sh, xd, sx); err += _report ("xcorr_fft_d", sh, sx, _rel_err (yd, ny), 1e-14);
+            xcorr_fft_f (yf, hf, sh, xf, sx); err += _report ("xcorr_fft_f", sh, sx, _rel_err (yf, ny), 1e-5);
+         }
+      }
+      else {
+         conv_d (yd, hd, sh, xd, sx);     err += _report ("conv_d", sh, sx, _rel_err (yd, ny), 1e-14);
+         conv_f (yf, hf, sh, xf, sx);     err += _report ("conv_f", sh, sx, _rel_err (yf, ny), 1e-5);
+         if (sh>1 || sx>1) {
+            conv_fft_d (yd, hd, sh, xd, sx); err += _report ("conv_fft_d", sh, sx, _rel_err (yd, ny), 1e-14);
+            conv_fft_f (yf, hf, sh, xf, sx); err += _report ("conv_fft_f", sh, sx, _rel_err (yf, ny), 1e-5);
+         }
+      }
+      // Complex
+      for (i=0 ; i<sh ; ++i)  hl[i] = hcd[i];
+      for (i=0 ; i<sx ; ++i)  xl[i] = xcd[i];
+      _ref (hl, sh, xl, sx, corr);
+      if (corr) {
+         xcorr_cd (ycd, hcd, sh, xcd, sx);      err += _report ("xcorr_cd", sh, sx, _rel_err (ycd, ny), 1e-14);
+         xcorr_cf (ycf, hcf, sh, xcf, sx);      err += _report ("xcorr_cf", sh, sx, _rel_err (ycf, ny), 1e-5);
+         xcorr_fft_cd (ycd, hcd, sh, xcd, sx);  err += _report ("xcorr_fft_cd", sh, sx, _rel_err (ycd, ny), 1e-14);
+         xcorr_fft_cf (ycf, hcf, sh, xcf, sx);  err += _report ("xcorr_fft_cf", sh, sx, _rel_err (ycf, ny), 1e-5);
+      }
+      else {
+         conv_cd (ycd, hcd, sh, xcd, sx);       err += _report ("conv_cd", sh, sx, _rel_err (ycd, ny), 1e-14);
+         conv_cf (ycf, hcf, sh, xcf, sx);       err += _report ("conv_cf", sh, sx, _rel_err (ycf, ny), 1e-5);
+         conv_fft_cd (ycd, hcd, sh, xcd, sx);   err += _report ("conv_fft_cd", sh, sx, _rel_err (ycd, ny), 1e-14);
+         conv_fft_cf (ycf, hcf, sh, xcf, sx);   err += _report ("conv_fft_cf", sh, sx, _rel_err (ycf, ny), 1e-5);
+      }
+   }
+   return err;
+}
+
+/*
+ * The overlap-save convolver fed in pieces of random length, from single
+ * samples to several blocks, with pieces that end exactly on, just before
+ * and just after a block boundary. The output has a latency of c.L samples.
+ */
+static int _check_ols (uint32_t sh, uint32_t block)
+{
+   conv_ols_t c;
+   uint32_t i, k, n, L, pass;
+   double e, r;
+   int err = 0;
+
+   for (i=0 ; i<sh ; ++i)
+      hd[i] = _rnd ();
+   for (i=0 ; i<OLS_N ; ++i)
+      ox[i] = _rnd ();
+   conv_d (oref, hd, sh, ox, OLS_N);
+   if (conv_ols_init (&c, hd, sh, block) == 0) {
+      printf ("conv_ols_init sh=%u block=%u: failed\n", sh, block);
+      return 1;
+   }
+   L = c.L;
+   for (pass=0 ; pass<2 ; ++pass) {
+      for (i=0 ; i<OLS_N ; i+=n) {
+         switch (rand () % 6) {
+            case 0:  n = 1; break;
+            case 1:  n = L - (i+L) % L;     break;   // To the boundary
+            case 2:  n = L - (i+L) % L - 1; break;   // Just before
+            case 3:  n = L - (i+L) % L + 1; break;   // Just after
+            case 4:  n = 2*L + rand () % L; break;
+            default: n = rand () % L; break;
+         }
+         if (n > OLS_N - i)
+            n = OLS_N - i;
+         conv_ols (&c, &ox[i], &oy[i], n);
+      }
+      for (e=r=0, k=0 ; k<OLS_N ; ++k) {
+         double ref = (k < L) ? 0 : oref[k-L];
+         if (fabs (oy[k] - ref) > e)   e = fabs (oy[k] - ref);
+         if (fabs (ref) > r)           r = fabs (ref);
+      }
+      if (e > 1e-13 * r) {
+         printf ("conv_ols sh=%u L=%u pass %u: error %g\n", sh, L, pass, e/r);
+         ++err;
+      }
+      conv_ols_reset (&c);    // The second pass must repeat the first
+   }
+   conv_ols_deinit (&c);
+   return err;
+}
+
+/*
+ * The direct form body of conv_d(), without the switch to the FFT
+ */
+static void _direct (double *y, double *h, int32_t sh, double *x, int32_t sx)
+{
+   int32_t n, k, kmin, kmax;
+
+   for (n=0 ; n<sh+sx-1 ; ++n) {
+      kmax = (n < sh) ? n : sh-1;
+      kmin = (n - (sx-1) > 0) ? n - (sx-1) : 0;
+      for (y[n]=0, k=kmin ; k<=kmax ; ++k)
+         y[n] += h[k] * x[n-k];
+   }
+}
+
+/*
+ * Time per call of f for a kernel of size m and a signal of size sx
+ */
+static double _time (int (*f)(double*, double*, int32_t, double*, int32_t), int32_t m, int32_t sx)
+{
+   int32_t r, runs = 20000000 / (m*sx) + 1;
+   double t0 = _now ();
+
+   for (r=0 ; r<runs ; ++r) {
+      if (f)   f (by, bx, m, bx, sx);
+      else     _direct (by, bx, m, bx, sx);
+   }
+   return (_now () - t0) * 1e6 / runs;
+}
+
+/*
+ * The direct form against the FFT for equal sizes and for a kernel of size
+ * m over a long signal
+ */
+static void _bench (void)
+{
+   int32_t m, i;
+
+   for (i=0 ; i<BENCH_X ; ++i)
+      bx[i] = _rnd ();
+   printf ("%6s %14s %14s %16s %16s\n", "m", "m*m direct", "m*m fft", "m*4096 direct", "m*4096 fft");
+   for (m=4 ; m<=512 ; m<<=1)
+      printf ("%6d %12.2fus %12.2fus %14.2fus %14.2fus\n", m,
+              _time (NULL, m, m), _time (conv_fft_d, m, m),
+              _time (NULL, m, BENCH_X), _time (conv_fft_d, m, BENCH_X));
+}
+
+int main (void)
+{
+   int err = 0;
+   size_t i, j;
+
+   srand (1);
+   for (i=0 ; i<sizeof (sizes) / sizeof (sizes[0]) ; ++i)
+      for (j=0 ; j<sizeof (sizes) / sizeof (sizes[0]) ; ++j)
+         err += _check (sizes[i], sizes[j]);
+   err += _check_ols (1, 0);
+   err += _check_ols (31, 0);
+   err += _check_ols (64, 1);
+   err += _check_ols (100, 900);
+   err += _check_ols (257, 257);
+   _bench ();
+   printf ("conv: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/*!
+ * \file crc_test.c
+ * \brief
+ *    Host test of the table driven CRC engine. It checks the standard check
+ *    values, the linked tables against the bitwise calculation for all the
+ *    widths and bit orders, buffers over 64KiB, the buffer functions from
+ *    many threads at once, and measures the throughput of the bitwise, the
+ *    table and the hardware paths.
+ *
+ *    gcc -std=gnu11 -O2 -pthread -I../inc crc_test.c ../src/algo/crc.c -o crc_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2016 Choutouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <algo/crc.h>
+#include "bench.h"
+
+#define BIG       (70000)     // Over 64KiB
+#define THREADS   (4)
+#define BENCH     (1 << 22)
+
+static byte_t        buf[BENCH];
+static crc8_table_t  t8[2];
+static crc16_table_t t16[2];
+static crc32_table_t t32[2];
+static crc64_table_t t64[2];
+static uint32_t      big_crc;
+
+/*
+ * Bitwise references
+ */
+static uint8_t _ref8 (uint8_t p, CRC_BitOrder_en bo, uint8_t c, const byte_t *d, uint32_t n) {
+   for (uint32_t i=0 ; i<n ; ++i)   c = CRC8_byte (p, bo, c, d[i]);
+   return c;
+}
+static uint16_t _ref16 (uint16_t p, CRC_BitOrder_en bo, uint16_t c, const byte_t *d, uint32_t n) {
+   for (uint32_t i=0 ; i<n ; ++i)   c = CRC16_byte (p, bo, c, d[i]);
+   return c;
+}
+static uint32_t _ref32 (uint32_t p, CRC_BitOrder_en bo, uint32_t c, const byte_t *d, uint32_t n) {
+   for (uint32_t i=0 ; i<n ; ++i)   c = CRC32_byte (p, bo, c, d[i]);
+   return c;
+}
+static uint64_t _ref64 (uint64_t p, CRC_BitOrder_en bo, uint64_t c, const byte_t *d, uint32_t n) {
+   for (uint32_t i=0 ; i<n ; ++i)   c = CRC64_byte (p, bo, c, d[i]);
+   return c;
+}
+
+/*
+ * The catalogue check values of "123456789"
+ */
+static int _check_values (void)
+{
+   const byte_t *s = (const byte_t*)"123456789";
+   int err = 0;
+
+   err += (CRC8_buffer (CRC8_Maxim_rev, CRC_LSB, 0, s, 9) != 0xA1);
+   err += (CRC16_buffer (CRC16_CCITT, CRC_MSB, 0, s, 9) != 0x31C3);
+   err += (CRC16_buffer (CRC16_IBM_rev, CRC_LSB, 0, s, 9) != 0xBB3D);
+   err += ((CRC32_buffer (CRC32_IEEE_rev, CRC_LSB, ~0U, s, 9) ^ ~0U) != 0xCBF43926);
+   err += ((CRC32_buffer (CRC32_IEEE, CRC_MSB, ~0U, s, 9) ^ ~0U) != 0xFC891918);    // BZIP2
+   err += ((CRC32_buffer (CRC32_Castagnoli_rev, CRC_LSB, ~0U, s, 9) ^ ~0U) != 0xE3069283);
+   err += ((CRC64_buffer (CRC64_ECMA_rev, CRC_LSB, ~0ULL, s, 9) ^ ~0ULL) != 0x995DC9BBDF1939FAULL);
+   err += (CRC64_buffer (CRC64_ECMA, CRC_MSB, 0, s, 9) != 0x6C40DF5F0B497347ULL);
+   if (err)
+      printf ("check values: %d mismatches\n", err);
+   return err;
+}
+
+/*
+ * The linked tables against the bitwise calculation, for every length
+ * around the slicing steps and the threshold, and a buffer over 64KiB.
+ */
+static int _check_tables (void)
+{
+   int err = 0;
+   uint32_t n, o;
+
+   for (n=0 ; n<=300 || n==BIG ; n = (n==300) ? BIG : n+1) {
+      o = rand () % 8;        // Unaligned starts
+      err += (CRC8_buffer (CRC8_CCITT, CRC_MSB, 0x5A, buf+o, n) != _ref8 (CRC8_CCITT, CRC_MSB, 0x5A, buf+o, n));
+      err += (CRC8_buffer (CRC8_Maxim_rev, CRC_LSB, 0x5A, buf+o, n) != _ref8 (CRC8_Maxim_rev, CRC_LSB, 0x5A, buf+o, n));
+      err += (CRC16_buffer (CRC16_CCITT, CRC_MSB, 0x1234, buf+o, n) != _ref16 (CRC16_CCITT, CRC_MSB, 0x1234, buf+o, n));
+      err += (CRC16_buffer (CRC16_IBM_rev, CRC_LSB, 0x1234, buf+o, n) != _ref16 (CRC16_IBM_rev, CRC_LSB, 0x1234, buf+o, n));
+      err += (CRC32_buffer (CRC32_IEEE, CRC_MSB, ~0U, buf+o, n) != _ref32 (CRC32_IEEE, CRC_MSB, ~0U, buf+o, n));
+      err += (CRC32_buffer (CRC32_IEEE_rev, CRC_LSB, ~0U, buf+o, n) != _ref32 (CRC32_IEEE_rev, CRC_LSB, ~0U, buf+o, n));
+      err += (CRC32_buffer (CRC32_Castagnoli_rev, CRC_LSB, ~0U, buf+o, n) != _ref32 (CRC32_Castagnoli_rev, CRC_LSB, ~0U, buf+o, n));
+      err += (CRC64_buffer (CRC64_ECMA, CRC_MSB, ~0ULL, buf+o, n) != _ref64 (CRC64_ECMA, CRC_MSB, ~0ULL, buf+o, n));
+      err += (CRC64_buffer (CRC64_ECMA_rev, CRC_LSB, ~0ULL, buf+o, n) != _ref64 (CRC64_ECMA_rev, CRC_LSB, ~0ULL, buf+o, n));
+   }
+   if (err)
+      printf ("tables: %d mismatches\n", err);
+   return err;
+}
+
+static void *_thread (void *arg)
+{
+   int *err = (int*)arg;
+
+   for (int i=0 ; i<50 ; ++i) {
+      if (CRC32_buffer (CRC32_IEEE_rev, CRC_LSB, ~0U, buf, BIG) != big_crc)
+         ++*err;
+   }
+   return NULL;
+}
+
+/*
+ * The buffer functions from many threads at once
+ */
+static int _check_threads (void)
+{
+   pthread_t th[THREADS];
+   int e[THREADS] = {0}, err = 0, i;
+
+   big_crc = _ref32 (CRC32_IEEE_rev, CRC_LSB, ~0U, buf, BIG);
+   for (i=0 ; i<THREADS ; ++i)
+      pthread_create (&th[i], NULL, _thread, &e[i]);
+   for (i=0 ; i<THREADS ; ++i) {
+      pthread_join (th[i], NULL);
+      err += e[i];
+   }
+   if (err)
+      printf ("threads: %d mismatches\n", err);
+   return err;
+}
+
+static void _bench (void)
+{
+   volatile uint32_t c;
+   double t0, t1, t2, t3;
+
+   t0 = _now ();
+   c = _ref32 (CRC32_IEEE_rev, CRC_LSB, ~0U, buf, BENCH/8);
+   t1 = _now ();
+   c = CRC32_buffer (CRC32_IEEE_rev, CRC_LSB, ~0U, buf, BENCH);
+   t2 = _now ();
+   c = CRC32_buffer (CRC32_Castagnoli_rev, CRC_LSB, ~0U, buf, BENCH);
+   t3 = _now ();
+   (void)c;
+   printf ("CRC32 bitwise:    %8.1f MB/s\n", BENCH/8 / (t1-t0) / 1e6);
+   printf ("CRC32 slicing-%d:  %8.1f MB/s\n", CRC_SLICING, BENCH / (t2-t1) / 1e6);
+   printf ("CRC32C:           %8.1f MB/s\n", BENCH / (t3-t2) / 1e6);
+}
+
+int main (void)
+{
+   int err = 0, i;
+
+   srand (1);
+   for (i=0 ; i<BENCH ; ++i)
+      buf[i] = (byte_t)rand ();
+
+   // Bitwise, before any table is linked
+   err += _check_values ();
+
+   err += (CRC8_link_table (&t8[0], CRC8_CCITT, CRC_MSB) != DRV_READY);
+   err += (CRC8_link_table (&t8[1], CRC8_Maxim_rev, CRC_LSB) != DRV_READY);
+   err += (CRC16_link_table (&t16[0], CRC16_CCITT, CRC_MSB) != DRV_READY);
+   err += (CRC16_link_table (&t16[1], CRC16_IBM_rev, CRC_LSB) != DRV_READY);
+   err += (CRC32_link_table (&t32[0], CRC32_IEEE, CRC_MSB) != DRV_READY);
+   err += (CRC32_link_table (&t32[1], CRC32_IEEE_rev, CRC_LSB) != DRV_READY);
+   err += (CRC64_link_table (&t64[0], CRC64_ECMA, CRC_MSB) != DRV_READY);
+   err += (CRC64_link_table (&t64[1], CRC64_ECMA_rev, CRC_LSB) != DRV_READY);
+   // The slots are full, relinking the same polynomial is fine
+   err += (CRC32_link_table (&t32[0], CRC32_Koopman, CRC_MSB) != DRV_ERROR);
+   err += (CRC32_link_table (&t32[0], CRC32_IEEE, CRC_MSB) != DRV_READY);
+   if (err)
+      printf ("link: %d errors\n", err);
+
+   err += _check_values ();
+   err += _check_tables ();
+   err += _check_threads ();
+   _bench ();
+   CRC_unlink_tables ();
+   err += _check_values ();
+
+   printf ("crc: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,343 @@
+/*!
+ * \file des_test.c
+ * \brief
+ *    Host test of the DES and 3DES modes. It checks the FIPS 81 DES ECB
+ *    and CBC vectors and the SP 800-67 TDEA vector, in short runs on the
+ *    scalar engine and repeated to long runs on the bitsliced engine. It
+ *    checks the ECB, CBC and CTR modes against the SP 800-38A constructions
+ *    on the single block des_crypt_ecb() over random lengths that cover all
+ *    the engine batches, in place and in pieces. Then it measures the MB/s
+ *    of the modes against the single block des_crypt_ecb() loop.
+ *    Build it also with -DDES_BITSLICE=0 to check the scalar only build.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc des_test.c ../src/crypt/des.c -o des_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <crypt/des.h>
+#include "bench.h"
+
+#define MAXLEN    (8*700)     // Over the 256 block batch
+#define REPEAT    (40)        // Vector copies of the long runs
+#define BENCH     (1 << 22)
+
+/*!
+ * FIPS 81 appendix B, "Now is the time for all "
+ */
+static const char *F81_key = "0123456789abcdef";
+static const char *F81_iv  = "1234567890abcdef";
+static const char *F81_p   = "4e6f772069732074" "68652074696d6520" "666f7220616c6c20";
+static const char *F81_ecb = "3fa40e8a984d4815" "6a271787ab8883f9" "893d51ec4b563b53";
+static const char *F81_cbc = "e5c7cdde872bf27c" "43e934008c389c0f" "683788499a7c05f6";
+
+/*!
+ * SP 800-67 TDEA example, "The qufck brown fox jump"
+ */
+static const char *T67_key = "0123456789abcdef" "23456789abcdef01" "456789abcdef0123";
+static const char *T67_p   = "5468652071756663" "6b2062726f776e20" "666f78206a756d70";
+static const char *T67_c   = "a826fd8ce53b855f" "cce21c8112256fe6" "68d5c05dd9b6b900";
+
+static uint8_t buf[BENCH];
+
+/*
+ * Hex string to bytes, returns the length
+ */
+static size_t _hex (const char *s, uint8_t *b)
+{
+   size_t n;
+   unsigned int v;
+
+   for (n=0 ; s[2*n] ; ++n) {
+      sscanf (&s[2*n], "%2x", &v);
+      b[n] = (uint8_t)v;
+   }
+   return n;
+}
+
+/*
+ * The vector once and REPEAT times. The repeated ECB runs and the CBC
+ * decryption of the long chain are bitsliced.
+ */
+static int _check_fips81 (void)
+{
+   static uint8_t p[8*3*REPEAT], c[8*3*REPEAT], e[8*3*REPEAT], y[8*3*REPEAT];
+   des_t    enc, dec;
+   uint8_t  k[8], iv0[8], iv[8];
+   size_t   n, r, i;
+   int      err = 0;
+
+   _hex (F81_key, k);
+   _hex (F81_iv, iv0);
+   des_setkey_enc (&enc, k);
+   des_setkey_dec (&dec, k);
+   n = _hex (F81_p, p);
+   _hex (F81_ecb, e);
+
+   for (i=0 ; i<n ; i+=8)
+      des_crypt_ecb (&enc, &p[i], &y[i]);
+   err += (memcmp (y, e, n) != 0);
+   for (r=1 ; r<REPEAT ; ++r) {
+      memcpy ((void*)&p[r*n], p, n);
+      memcpy ((void*)&e[r*n], e, n);
+   }
+   for (r=1 ; r<=REPEAT ; r+=REPEAT-1) {
+      err += (des_ecb (&enc, p, y, r*n) != 1 || memcmp (y, e, r*n) != 0);
+      err += (des_ecb (&dec, y, y, r*n) != 1 || memcmp (y, p, r*n) != 0);
+   }
+
+   // CBC, whole and in two pieces
+   _hex (F81_cbc, c);
+   memcpy ((void*)iv, iv0, 8);
+   err += (des_cbc_encrypt (&enc, iv, p, y, 8) != 1);
+   err += (des_cbc_encrypt (&enc, iv, &p[8], &y[8], n-8) != 1);
+   err += (memcmp (y, c, n) != 0 || memcmp (iv, &c[n-8], 8) != 0);
+   memcpy ((void*)iv, iv0, 8);
+   err += (des_cbc_decrypt (&dec, iv, c, y, n) != 1 || memcmp (y, p, n) != 0);
+   err += (des_cbc_encrypt (&enc, iv, p, y, 7) != 0);
+   err += (des_cbc_decrypt (&dec, iv, p, y, 9) != 0);
+
+   // The long CBC chain, decrypted bitsliced in place
+   memcpy ((void*)iv, iv0, 8);
+   des_cbc_encrypt (&enc, iv, p, c, REPEAT*n);
+   memcpy ((void*)iv, iv0, 8);
+   err += (des_cbc_decrypt (&dec, iv, c, c, REPEAT*n) != 1 || memcmp (c, p, REPEAT*n) != 0);
+   if (err)
+      printf ("FIPS 81: %d errors\n", err);
+   return err;
+}
+
+static int _check_sp800_67 (void)
+{
+   static uint8_t p[8*3*REPEAT], c[8*3*REPEAT], y[8*3*REPEAT];
+   des3_t   enc, dec;
+   uint8_t  k[24];
+   size_t   n, r;
+   int      err = 0;
+
+   _hex (T67_key, k);
+   des3_set3key_enc (&enc, k);
+   des3_set3key_dec (&dec, k);
+   n = _hex (T67_p, p);
+   _hex (T67_c, c);
+
+   for (r=0 ; r<n ; r+=8)
+      des3_crypt_ecb (&enc, &p[r], &y[r]);
+   err += (memcmp (y, c, n) != 0);
+   for (r=1 ; r<REPEAT ; ++r) {
+      memcpy ((void*)&p[r*n], p, n);
+      memcpy ((void*)&c[r*n], c, n);
+   }
+   for (r=1 ; r<=REPEAT ; r+=REPEAT-1) {
+      err += (des3_ecb (&enc, p, y, r*n) != 1 || memcmp (y, c, r*n) != 0);
+      err += (des3_ecb (&dec, y, y, r*n) != 1 || memcmp (y, p, r*n) != 0);
+   }
+   if (err)
+      printf ("SP 800-67: %d errors\n", err);
+   return err;
+}
+
+/*
+ * The SP 800-38A CBC and CTR constructions on the single block function
+ */
+typedef void (*block_ft) (void *ctx, const uint8_t in[8], uint8_t out[8]);
+
+static void _ref_cbc_enc (block_ft f, void *ctx, const uint8_t iv0[8], const uint8_t *in, uint8_t *out, size_t len)
+{
+   const uint8_t *iv = iv0;
+   size_t i, j;
+
+   for (i=0 ; i<len ; i+=8, iv = &out[i-8]) {
+      for (j=0 ; j<8 ; ++j)
+         out[i+j] = in[i+j] ^ iv[j];
+      f (ctx, &out[i], &out[i]);
+   }
+}
+static void _ref_ctr (block_ft f, void *ctx, const uint8_t ctr0[8], const uint8_t *in, uint8_t *out, size_t len)
+{
+   uint8_t  cb[8], ks[8];
+   uint64_t cnt = 0;
+   size_t   i;
+
+   for (i=0 ; i<8 ; ++i)
+      cnt = (cnt << 8) | ctr0[i];
+   for (i=0 ; i<len ; ++i) {
+      if (i % 8 == 0) {
+         for (int j=0 ; j<8 ; ++j)
+            cb[j] = (uint8_t)(cnt >> (56 - 8*j));
+         f (ctx, cb, ks);
+         ++cnt;
+      }
+      out[i] = in[i] ^ ks[i % 8];
+   }
+}
+
+/*
+ * The modes of DES (stages 1) or 3DES (stages 3) against the
+ * constructions, random keys, lengths and split points
+ */
+static int _check_modes (int stages)
+{
+   static uint8_t x[MAXLEN], y[MAXLEN], z[MAXLEN], r[MAXLEN];
+   des_t    e1, d1;
+   des3_t   e3, d3;
+   block_ft f;
+   void     *ectx;
+   uint8_t  k[24], iv0[8], iv[8], ctr[8];
+   size_t   n, s, i;
+   int      t, err = 0;
+
+   if (stages == 1) {
+      f = (block_ft)des_crypt_ecb;
+      ectx = &e1;
+   }
+   else {
+      f = (block_ft)des3_crypt_ecb;
+      ectx = &e3;
+   }
+   for (t=0 ; t<300 ; ++t) {
+      for (i=0 ; i<24 ; ++i)
+         k[i] = rand ();
+      if (stages == 1) {
+         des_setkey_enc (&e1, k);
+         des_setkey_dec (&d1, k);
+      }
+      else if (t & 1) {
+         des3_set2key_enc (&e3, k);
+         des3_set2key_dec (&d3, k);
+      }
+      else {
+         des3_set3key_enc (&e3, k);
+         des3_set3key_dec (&d3, k);
+      }
+      n = 8 * (rand () % (MAXLEN/8 + 1));
+      s = 8 * (rand () % (n/8 + 1));
+      for (i=0 ; i<n ; ++i)
+         x[i] = rand ();
+      for (i=0 ; i<8 ; ++i)
+         iv0[i] = rand ();
+      if (t % 4 == 0)
+         memset ((void*)&iv0[1], 0xFF, 7);    // Near the counter wrap
+
+      // ECB
+      for (i=0 ; i<n ; i+=8)
+         f (ectx, &x[i], &r[i]);
+      if (stages == 1) des_ecb (&e1, x, y, n);
+      else             des3_ecb (&e3, x, y, n);
+      err += (memcmp (y, r, n) != 0);
+      if (stages == 1) des_ecb (&d1, y, y, n);
+      else             des3_ecb (&d3, y, y, n);
+      err += (memcmp (y, x, n) != 0);
+
+      // CBC, in two pieces
+      _ref_cbc_enc (f, ectx, iv0, x, r, n);
+      memcpy ((void*)iv, iv0, 8);
+      if (stages == 1) {
+         des_cbc_encrypt (&e1, iv, x, y, s);
+         des_cbc_encrypt (&e1, iv, &x[s], &y[s], n-s);
+      }
+      else {
+         des3_cbc_encrypt (&e3, iv, x, y, s);
+         des3_cbc_encrypt (&e3, iv, &x[s], &y[s], n-s);
+      }
+      err += (memcmp (y, r, n) != 0);
+      memcpy ((void*)iv, iv0, 8);
+      if (stages == 1) {
+         des_cbc_decrypt (&d1, iv, y, y, s);
+         des_cbc_decrypt (&d1, iv, &y[s], &y[s], n-s);
+      }
+      else {
+         des3_cbc_decrypt (&d3, iv, y, y, s);
+         des3_cbc_decrypt (&d3, iv, &y[s], &y[s], n-s);
+      }
+      err += (memcmp (y, x, n) != 0);
+      err += (n && memcmp (iv, &r[n-8], 8) != 0);
+
+      // CTR, any length, in two pieces
+      n -= rand () % 8 * (n > 0);
+      if (s > n)
+         s = n & ~(size_t)7;
+      _ref_ctr (f, ectx, iv0, x, r, n);
+      memcpy ((void*)ctr, iv0, 8);
+      if (stages == 1) {
+         des_ctr (&e1, ctr, x, z, s);
+         des_ctr (&e1, ctr, &x[s], &z[s], n-s);
+      }
+      else {
+         des3_ctr (&e3, ctr, x, z, s);
+         des3_ctr (&e3, ctr, &x[s], &z[s], n-s);
+      }
+      err += (memcmp (z, r, n) != 0);
+   }
+   if (err)
+      printf ("%s modes: %d mismatches\n", (stages == 1) ? "DES" : "3DES", err);
+   return err;
+}
+
+/*
+ * MB/s of the modes and of the single block loop they replace
+ */
+static void _bench (int stages)
+{
+   des_t    c1;
+   des3_t   c3;
+   uint8_t  k[24] = {1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24}, iv[8] = {0};
+   double   t[6];
+   size_t   i;
+
+   des_setkey_enc (&c1, k);
+   des3_set3key_enc (&c3, k);
+   t[0] = _now ();
+   for (i=0 ; i<BENCH ; i+=8)
+      if (stages == 1)  des_crypt_ecb (&c1, &buf[i], &buf[i]);
+      else              des3_crypt_ecb (&c3, &buf[i], &buf[i]);
+   t[1] = _now ();
+   if (stages == 1)  des_ecb (&c1, buf, buf, BENCH);
+   else              des3_ecb (&c3, buf, buf, BENCH);
+   t[2] = _now ();
+   if (stages == 1)  des_ctr (&c1, iv, buf, buf, BENCH);
+   else              des3_ctr (&c3, iv, buf, buf, BENCH);
+   t[3] = _now ();
+   if (stages == 1)  des_cbc_decrypt (&c1, iv, buf, buf, BENCH);
+   else              des3_cbc_decrypt (&c3, iv, buf, buf, BENCH);
+   t[4] = _now ();
+   if (stages == 1)  des_cbc_encrypt (&c1, iv, buf, buf, BENCH);
+   else              des3_cbc_encrypt (&c3, iv, buf, buf, BENCH);
+   t[5] = _now ();
+   printf ("%-4s crypt_ecb %6.1f, ECB %6.1f, CTR %6.1f, CBC dec %6.1f, CBC enc %6.1f MB/s\n",
+           (stages == 1) ? "DES" : "3DES", BENCH / (t[1]-t[0]) / 1e6, BENCH / (t[2]-t[1]) / 1e6,
+           BENCH / (t[3]-t[2]) / 1e6, BENCH / (t[4]-t[3]) / 1e6, BENCH / (t[5]-t[4]) / 1e6);
+}
+
+int main (void)
+{
+   int err = 0;
+
+   srand (1);
+   err += _check_fips81 ();
+   err += _check_sp800_67 ();
+   err += _check_modes (1);
+   err += _check_modes (3);
+   printf ("DES_BITSLICE %d\n", DES_BITSLICE);
+   _bench (1);
+   _bench (3);
+   printf ("des: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,232 @@
+/*!
+ * \file dtoa_test.c
+ * \brief
+ *    Host test of the double conversions. It fuzzes dtoa() with random bit
+ *    patterns over the whole exponent range and the edge values, and checks
+ *    that its output parses back to the same bits with strtod_fast() and
+ *    with the libc strtod(). It checks strtod_fast() against strtod() on
+ *    random and near halfway strings, counts the dtoa() outputs that are
+ *    not the shortest, and measures both against the libc.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc dtoa_test.c ../src/std/dtoa.c -lm -o dtoa_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <std/dtoa.h>
+#include "bench.h"
+
+#define FUZZ      (1000000)
+#define BENCH     (1 << 20)
+
+static double  bv[BENCH];
+static char    bs[BENCH][DTOA_BUFFER_SIZE];
+
+static uint64_t _rnd64 (void) {
+   return ((uint64_t)rand () << 62) ^ ((uint64_t)rand () << 31) ^ rand ();
+}
+
+static uint64_t _bits (double v) {
+   uint64_t b;
+   memcpy (&b, &v, sizeof (b));
+   return b;
+}
+
+static double _dbl (uint64_t b) {
+   double v;
+   memcpy (&v, &b, sizeof (v));
+   return v;
+}
+
+/*
+ * dtoa() of v has to parse back to the same bits, and the whole string has
+ * to be used. With one digit less, libc has to read another double.
+ */
+static int _round_trip (double v, uint32_t *longer)
+{
+   char  buf[DTOA_BUFFER_SIZE], sh[32], dig[DTOA_MAX_DIGITS], *end;
+   int   n, nd, dexp, err = 0;
+
+   n = dtoa (v, buf);
+   err += (n != (int)strlen (buf) || n >= DTOA_BUFFER_SIZE);
+   err += (_bits (strtod_fast (buf, &end)) != _bits (v));
+   err += (end != buf + n);
+   err += (_bits (strtod (buf, NULL)) != _bits (v));
+
+   nd = dtoa_digits (v, dig, &dexp);
+   if (nd > 1) {
+      snprintf (sh, sizeof (sh), "%.*e", nd - 2, v);
+      if (strtod (sh, NULL) == v)
+         ++*longer;
+   }
+   if (err)
+      printf ("%.17g (%016llx): \"%s\"\n", v, (unsigned long long)_bits (v), buf);
+   return err;
+}
+
+/*
+ * strtod_fast() against strtod() on a string, the whole string is used
+ */
+static int _parse (const char *s)
+{
+   char *e1, *e2;
+   double a = strtod_fast (s, &e1), b = strtod (s, &e2);
+
+   if (_bits (a) == _bits (b) && e1 == e2)
+      return 0;
+   printf ("\"%s\": %.17g vs %.17g\n", s, a, b);
+   return 1;
+}
+
+static int _check_edges (uint32_t *longer)
+{
+   static const double ev[] = {
+      0.0, 1.0, 0.1, 0.2, 0.3, 1.0/3, 2.0/3, 100, 1e15, 1e16, 1e17, 1e21, 1e22, 1e23,
+      9007199254740992.0, 9007199254740993.0, 5e-324, 1e-323, 2.2250738585072009e-308,
+      DBL_MIN, DBL_MAX, DBL_EPSILON, 1.7976931348623157e308, 4.9406564584124654e-324,
+      123456789012345678.0, 0.000123456789, 1.5, 2.5, 0.5e-4, 1e-5,
+   };
+   char s[16];
+   int err = 0, e;
+   uint32_t i;
+
+   for (i=0 ; i<sizeof (ev) / sizeof (ev[0]) ; ++i) {
+      err += _round_trip (ev[i], longer);
+      err += _round_trip (-ev[i], longer);
+   }
+   for (e=-1074 ; e<=1023 ; ++e) {               // Powers of 2 and neighbours
+      err += _round_trip (ldexp (1, e), longer);
+      err += _round_trip (nextafter (ldexp (1, e), 0), longer);
+      err += _round_trip (nextafter (ldexp (1, e), INFINITY), longer);
+   }
+   for (e=-323 ; e<=308 ; ++e) {                 // Powers of 10
+      snprintf (s, sizeof (s), "1e%d", e);
+      err += _round_trip (strtod (s, NULL), longer);
+   }
+   for (i=0 ; i<100000 ; ++i)                    // Integers and subnormals
+      err += _round_trip ((double)i, longer) + _round_trip (_dbl (i), longer);
+
+   err += _round_trip (-0.0, longer);
+   if (err)
+      printf ("edges: %d errors\n", err);
+   return err;
+}
+
+static int _check_fuzz (uint32_t *longer)
+{
+   int err = 0;
+   uint64_t b;
+
+   for (int i=0 ; i<FUZZ ; ++i) {
+      do
+         b = _rnd64 ();
+      while (!isfinite (_dbl (b)));
+      err += _round_trip (_dbl (b), longer);
+      // Over a random exponent the bits are biased to huge values
+      err += _round_trip (ldexp ((double)(b >> 11), rand () % 2100 - 1128), longer);
+   }
+   if (err)
+      printf ("fuzz: %d errors\n", err);
+   return err;
+}
+
+/*
+ * Random strings of up to 25 digits, and the halfway points between two
+ * doubles, exact and off by one in the last digit
+ */
+static int _check_strtod (void)
+{
+   char  s[128];
+   int   err = 0, i, j, n, d;
+   long double h;
+   double v;
+
+   for (i=0 ; i<400000 ; ++i) {
+      n = 1 + rand () % 25;
+      d = rand () % n;
+      for (j=0 ; j<n ; ++j)
+         s[j + (j >= d)] = '0' + rand () % 10;
+      s[d] = '.';
+      snprintf (&s[n+1], sizeof (s) - n - 1, "e%d", rand () % 700 - 350);
+      err += _parse (s);
+
+      do
+         v = _dbl (_rnd64 ());
+      while (!isfinite (v) || v == 0);
+      h = ((long double)v + (long double)nextafter (v, INFINITY)) / 2;
+      snprintf (s, sizeof (s), "%.40Le", h);
+      err += _parse (s);
+      s[41] += (s[41] < '9') ? 1 : -1;
+      err += _parse (s);
+   }
+   err += _parse ("2.4703282292062327208828439643411068618252990130716238221279284125033775363510437593264991818081799618989828234772285886546332835517796989819938739800539093906315035659515570226392290858392449105184435931802849936536152500319370457678249219365623669863658480757001585769269903706311928279558551332927834338409351978015531246597263579574622766465272827220056374006485499977096599470454020828166226237857393450736339007967761930577506740176324673600968951340535537458516661134223766678604162159680461914467291840300530057530849048765391711386591646239524912623653881879636239373280423891018672348497668235089863388587925628302755995657524455507255189313690836254779186948667994968324049705821028513185451396213837722826145437693412532098591327667236328125e-324");
+   err += _parse ("  -1e400");
+   err += _parse ("1e-400");
+   err += _parse ("infinity");
+   err += _parse ("-NaN");
+   err += _parse ("x1");
+   if (err)
+      printf ("strtod: %d errors\n", err);
+   return err;
+}
+
+static void _bench (void)
+{
+   double t0, t1, t2, t3, t4;
+   volatile double s = 0;
+   int i;
+
+   for (i=0 ; i<BENCH ; ++i)
+      do
+         bv[i] = _dbl (_rnd64 ());
+      while (!isfinite (bv[i]));
+   t0 = _now ();
+   for (i=0 ; i<BENCH ; ++i)
+      dtoa (bv[i], bs[i]);
+   t1 = _now ();
+   for (i=0 ; i<BENCH ; ++i)
+      snprintf (bs[i], DTOA_BUFFER_SIZE, "%.17g", bv[i]);
+   t2 = _now ();
+   for (i=0 ; i<BENCH ; ++i)
+      s += strtod_fast (bs[i], NULL);
+   t3 = _now ();
+   for (i=0 ; i<BENCH ; ++i)
+      s += strtod (bs[i], NULL);
+   t4 = _now ();
+   printf ("dtoa:        %6.1f ns, libc %%.17g %6.1f ns\n", (t1-t0) * 1e9 / BENCH, (t2-t1) * 1e9 / BENCH);
+   printf ("strtod_fast: %6.1f ns, libc strtod %6.1f ns\n", (t3-t2) * 1e9 / BENCH, (t4-t3) * 1e9 / BENCH);
+}
+
+int main (void)
+{
+   uint32_t longer = 0;
+   int err = 0;
+
+   srand (1);
+   err += _check_edges (&longer);
+   err += _check_fuzz (&longer);
+   err += _check_strtod ();
+   printf ("dtoa: %u outputs with a shorter round trip (%.4f%%)\n", longer, longer * 100.0 / (2*FUZZ));
+   _bench ();
+   printf ("dtoa: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,323 @@
+/*!
+ * \file ee_i2c_test.c
+ * \brief
+ *    Host test of the I2C EEPROM driver on the 24xx simulator. It checks
+ *    that the write-back cache coalesces the dirty bytes of a page to one
+ *    page write, that writes across page boundaries and apart spans of a
+ *    page land right, and that the reads see the not yet written bytes.
+ *    It checks the ACK polling of the blocking and the non blocking calls
+ *    and its timeout. Random traffic with and without cache is compared
+ *    with a reference image. Then it prints the transactions, the page
+ *    writes and the bus time of small writes with and without the cache.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc ee_i2c_test.c ../src/drv/ee_i2c.c ../src/drv/sim_i2c_ee.c -o ee_i2c_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <drv/ee_i2c.h>
+#include <drv/sim_i2c_ee.h>
+
+#define EE_SIZE      (32768)     // 24xx256
+#define PAGE_SZ      (64)
+#define LINES        (4)
+#define TIMEOUT      (1000)      // ACK polling tries, a poll is about 27 usec
+#define OPS          (20000)     // Random operations
+
+static byte_t     mem[EE_SIZE], ref[EE_SIZE];
+static sie_t      sie;
+static ee_t       ee;
+static ee_line_t  line[LINES];
+static byte_t     line_mem[LINES * PAGE_SZ];
+
+static uint32_t _rnd (void)
+{
+   static uint32_t x = 2463534242u;
+   x ^= x << 13;  x ^= x >> 17;  x ^= x << 5;
+   return x;
+}
+
+/*
+ * Driver on the simulator, with \a lines cache lines
+ */
+static void _setup (uint32_t lines)
+{
+   ee_deinit (&ee);
+   ee_link_i2c (&ee, (void*)&sie);
+   ee_link_i2c_rx (&ee, (drv_i2c_rx_ft)sie_i2c_rx);
+   ee_link_i2c_tx (&ee, (drv_i2c_tx_ft)sie_i2c_tx);
+   ee_link_i2c_ioctl (&ee, (drv_i2c_ioctl_ft)sie_i2c_ioctl);
+   if (lines)
+      ee_link_cache (&ee, line, line_mem, lines);
+   ee_set_hwaddress (&ee, SIE_HWADDR_DEF);
+   ee_set_size (&ee, EE_256);
+   ee_set_page_size (&ee, PAGE_SZ);
+   ee_set_timeout (&ee, TIMEOUT);
+   ee_init (&ee);
+}
+
+static int _write (address_t a, uint32_t n)
+{
+   byte_t b[512];
+   uint32_t i;
+
+   for (i=0 ; i<n ; ++i)
+      ref[a+i] = b[i] = (byte_t)_rnd ();
+   return ee_write (&ee, a, b, n) != DRV_READY;
+}
+
+static int _cmp (const char *when)
+{
+   uint32_t i;
+
+   for (i=0 ; i<EE_SIZE ; ++i)
+      if (mem[i] != ref[i]) {
+         printf ("%s: EEPROM byte 0x%04x is 0x%02x, expected 0x%02x\n", when, i, mem[i], ref[i]);
+         return 1;
+      }
+   return 0;
+}
+
+/*
+ * The page writes since the last call
+ */
+static uint32_t _page_writes (void)
+{
+   static uint32_t last;
+   uint32_t n = sie.stat.page_writes - last;
+   last = sie.stat.page_writes;
+   return n;
+}
+
+static int _expect (const char *what, uint32_t got, uint32_t exp)
+{
+   if (got == exp)
+      return 0;
+   printf ("%s: %u page writes, expected %u\n", what, got, exp);
+   return 1;
+}
+
+static int _check_coalescing (void)
+{
+   uint32_t i, p[PAGE_SZ], t;
+   byte_t b;
+   int err = 0;
+
+   _setup (LINES);
+   _page_writes ();
+
+   // The bytes of a page in random order, one page write
+   for (i=0 ; i<PAGE_SZ ; ++i)
+      p[i] = i;
+   for (i=PAGE_SZ-1 ; i>0 ; --i) {
+      t = _rnd () % (i+1);
+      b = p[i]; p[i] = p[t]; p[t] = b;
+   }
+   for (i=0 ; i<PAGE_SZ ; ++i)
+      err += _write (0x1000 + p[i], 1);
+   err += _expect ("random bytes before sync", _page_writes (), 0);
+   ee_sync (&ee);
+   err += _expect ("random bytes of a page", _page_writes (), 1);
+
+   // Overwrites of the same bytes, one page write
+   for (i=0 ; i<100 ; ++i)
+      err += _write (0x2010 + i%8, 4);
+   ee_sync (&ee);
+   err += _expect ("overwrites", _page_writes (), 1);
+
+   // Across page boundaries. The whole middle page goes straight.
+   err += _write (0x3028, 100);
+   err += _expect ("page boundaries before sync", _page_writes (), 1);
+   ee_sync (&ee);
+   err += _expect ("page boundaries", _page_writes (), 2);
+
+   // Apart spans of a page, the page is loaded and written with one write
+   err += _write (0x4002, 3);
+   err += _write (0x4030, 5);
+   err += _write (0x4010, 1);
+   ee_sync (&ee);
+   err += _expect ("apart spans", _page_writes (), 1);
+
+   // More pages than lines, the LRU line is written back
+   for (i=0 ; i<LINES+1 ; ++i)
+      err += _write (0x5000 + i*PAGE_SZ + 7, 2);
+   err += _expect ("line replacement", _page_writes (), 1);
+   ee_sync (&ee);
+   err += _expect ("line replacement sync", _page_writes (), LINES);
+
+   // Nothing dirty
+   ee_sync (&ee);
+   err += _expect ("clean sync", _page_writes (), 0);
+   err += _cmp ("coalescing");
+   return err;
+}
+
+/*
+ * The reads see the cached bytes, in and across the cached pages
+ */
+static int _check_reads (void)
+{
+   byte_t b[300];
+   int err = 0;
+
+   _setup (LINES);
+   err += _write (0x6005, 10);
+   err += _write (0x6040 + 60, 8);
+   err += (ee_read (&ee, 0x6000, b, 300) != DRV_READY || memcmp (b, &ref[0x6000], 300) != 0);
+   err += (ee_read (&ee, 0x6007, b, 4) != DRV_READY || memcmp (b, &ref[0x6007], 4) != 0);
+   err += (ee_read_byte (&ee, 0x6081, b) != DRV_READY || b[0] != ref[0x6081]);
+   if (err)
+      printf ("reads of dirty bytes differ\n");
+   ee_sync (&ee);
+   return err + _cmp ("reads");
+}
+
+/*
+ * Back to back writes wait the write cycle with ACK polling. With a short
+ * timeout the polling gives up.
+ */
+static int _check_polling (void)
+{
+   ee_op_t op;
+   byte_t b[200];
+   drv_status_en st;
+   uint32_t i, polls, calls;
+   uint64_t t0;
+   int err = 0;
+
+   _setup (0);
+   polls = sie.stat.polls;
+   t0 = sie.stat.time;
+   for (i=0 ; i<8 ; ++i)
+      err += _write (0x7000 + i*PAGE_SZ, PAGE_SZ);
+   err += (ee_read (&ee, 0x7000, b, 200) != DRV_READY || memcmp (b, &ref[0x7000], 200) != 0);
+   if (sie.stat.polls - polls < 8 || sie.stat.time - t0 < 8ULL*SIE_T_WR_DEF) {
+      printf ("polling: %u polls in %llu nsec\n", sie.stat.polls - polls, (unsigned long long)(sie.stat.time - t0));
+      ++err;
+   }
+
+   // Non blocking, each call is one poll
+   for (i=0 ; i<197 ; ++i)
+      ref[0x7103 + i] = b[i] = (byte_t)_rnd ();
+   memset ((void*)&op, 0, sizeof (op));
+   polls = sie.stat.polls;
+   for (calls=1 ; (st = ee_write_async (&ee, &op, 0x7103, b, 197)) == DRV_BUSY ; ++calls)
+      ;
+   err += (st != DRV_READY);
+   memset ((void*)&op, 0, sizeof (op));
+   while ((st = ee_read_async (&ee, &op, 0x7103, b, 197)) == DRV_BUSY)
+      ++calls;
+   if (st != DRV_READY || memcmp (b, &ref[0x7103], 197) != 0) {
+      printf ("async write and read failed\n");
+      ++err;
+   }
+   if (calls < sie.stat.polls - polls) {
+      printf ("async: %u calls for %u polls\n", calls, sie.stat.polls - polls);
+      ++err;
+   }
+
+   // Timeout
+   ee_set_timeout (&ee, 2);
+   err += _write (0x7200, 4);
+   st = ee_write (&ee, 0x7300, b, 4);
+   if (st != DRV_ERROR) {
+      printf ("polling timeout: write returned %d\n", st);
+      ++err;
+   }
+   ee_set_timeout (&ee, TIMEOUT);
+   return err + _cmp ("polling");
+}
+
+/*
+ * Random traffic against the reference image
+ */
+static int _check_random (uint32_t lines)
+{
+   byte_t b[512];
+   address_t a;
+   uint32_t i, n;
+   int err = 0;
+
+   _setup (lines);
+   for (i=0 ; i<OPS && !err ; ++i) {
+      n = 1 + ((_rnd () & 3) ? _rnd () % 8 : _rnd () % 300);
+      a = _rnd () % (EE_SIZE - n);
+      if (_rnd () & 3)
+         a &= 0x0FFF;      // Mostly a hot area
+      switch (_rnd () % 5) {
+         case 0:
+            if (ee_read (&ee, a, b, n) != DRV_READY || memcmp (b, &ref[a], n) != 0) {
+               printf ("%u lines: read of %u bytes at 0x%04x differs\n", lines, n, a);
+               ++err;
+            }
+            break;
+         case 1:
+            if (_rnd () % 16 == 0)
+               ee_sync (&ee);
+            break;
+         default:
+            err += _write (a, n);
+      }
+   }
+   ee_sync (&ee);
+   return err + _cmp ((lines) ? "random traffic, cache" : "random traffic");
+}
+
+/*
+ * Log like small writes, 6 byte records to a 4 KB area
+ */
+static void _bench (uint32_t lines)
+{
+   uint32_t i, tr = sie.stat.transactions, pw = sie.stat.page_writes;
+   uint64_t t = sie.stat.time;
+
+   _setup (lines);
+   for (i=0 ; i<4096 ; ++i)
+      _write (0x100 + (i*6) % 4096, 6);
+   ee_sync (&ee);
+   printf ("%-10s %8u %12u %12u %10.1f\n", (lines) ? "cache" : "no cache", 4096,
+           sie.stat.transactions - tr, sie.stat.page_writes - pw, (sie.stat.time - t) * 1e-6);
+}
+
+int main (void)
+{
+   int err = 0;
+
+   memset ((void*)mem, 0xFF, sizeof (mem));
+   memset ((void*)ref, 0xFF, sizeof (ref));
+   sie_link_mem (&sie, mem, sizeof (mem));
+   sie_set_page_size (&sie, PAGE_SZ);
+   sie_init (&sie);
+
+   err += _check_coalescing ();
+   err += _check_reads ();
+   err += _check_polling ();
+   err += _check_random (0);
+   err += _check_random (1);
+   err += _check_random (LINES);
+
+   printf ("%-10s %8s %12s %12s %10s\n", "", "writes", "transactions", "page writes", "bus ms");
+   _bench (0);
+   _bench (LINES);
+   err += _cmp ("bench");
+   printf ("ee_i2c: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,342 @@
+/*!
+ * \file fft_test.c
+ * \brief
+ *    Host test of the radix-4 and the packed real FFT paths. It checks the
+ *    transforms against a long double DFT and the dft_xx() reference, the
+ *    inverse transforms and the 2*n output buffer contract of ifft_r and
+ *    ifft_rf, the per thread plan cache from concurrent threads, and times
+ *    the transforms against the dft_xx() reference and the planned against
+ *    the unplanned transforms.
+ *
+ *    gcc -std=gnu11 -O2 -pthread -I../inc fft_test.c ../src/dsp/fft.c ../src/dsp/dft.c ../src/math/math.c -lm -o fft_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dsp/fft.h>
+#include <dsp/dft.h>
+#include "bench.h"
+
+#define NMAX      (4096)      // Largest size checked against the DFT
+#define NBENCH    (65536)     // Largest size timed
+#define THREADS   (4)         // Threads that share the fft_xx() entry points
+#define TSIZES    (8)         // Sizes each thread cycles, more than the cache holds
+
+static complex_d_t   xc[2*NMAX], Xc[2*NMAX], Rc[2*NMAX];
+static complex_f_t   xcf[2*NMAX], Xcf[2*NMAX], Rcf[2*NMAX];
+static double        xr[2*NMAX], yr[4*NMAX];
+static float         xrf[2*NMAX], yrf[4*NMAX];
+static int           xri[4*NMAX];
+static complex_d_t   bx[NBENCH];
+
+static double _rnd (void) {
+   return (double)rand () / RAND_MAX * 2 - 1;
+}
+
+/*
+ * Maximum error of the first m points, relative to the largest reference point
+ */
+static double _err_c (complex_d_t *y, complex_d_t *ref, uint32_t m)
+{
+   double e = 0, r = 0;
+   for (uint32_t i=0 ; i<m ; ++i) {
+      if (cabs (y[i] - ref[i]) > e)  e = cabs (y[i] - ref[i]);
+      if (cabs (ref[i]) > r)         r = cabs (ref[i]);
+   }
+   return e / r;
+}
+static double _err_cf (complex_f_t *y, complex_f_t *ref, uint32_t m)
+{
+   double e = 0, r = 0;
+   for (uint32_t i=0 ; i<m ; ++i) {
+      if (cabsf (y[i] - ref[i]) > e) e = cabsf (y[i] - ref[i]);
+      if (cabsf (ref[i]) > r)        r = cabsf (ref[i]);
+   }
+   return e / r;
+}
+
+/*
+ * Long double DFT with exact twiddles. The dft_xx() build their angles in
+ * the working precision, so their error grows with n and they only bound
+ * the FFT loosely. dft_r sums only the first half of the signal, the real
+ * transforms are checked against dft_c/dft_cf.
+ */
+static void _ref (complex_d_t *x, complex_d_t *X, uint32_t n)
+{
+   static long double c[NMAX], s[NMAX];
+   long double re, im, a = 2 * 3.14159265358979323846264338327950288L / n;
+   uint32_t k, i, m;
+
+   for (i=0 ; i<n ; ++i) {
+      c[i] = cosl (a*i);
+      s[i] = sinl (a*i);
+   }
+   for (k=0 ; k<n ; ++k) {
+      for (re=im=0, i=0 ; i<n ; ++i) {
+         m = (uint64_t)k*i % n;
+         re += creal (x[i])*c[m] + cimag (x[i])*s[m];
+         im += cimag (x[i])*c[m] - creal (x[i])*s[m];
+      }
+      X[k] = (double)re + I*(double)im;
+   }
+}
+
+static int _report (const char *what, uint32_t n, double e, double tol)
+{
+   if (e <= tol)
+      return 0;
+   printf ("%s n=%u: error %g > %g\n", what, n, e, tol);
+   return 1;
+}
+
+/*
+ * All the transforms of size n against the DFT
+ */
+static int _check (uint32_t n)
+{
+   int err = 0;
+   uint32_t i;
+
+   for (i=0 ; i<n ; ++i) {
+      xc[i] = _rnd () + I*_rnd ();
+      xcf[i] = (complex_f_t)xc[i];
+      xr[i] = _rnd ();
+      xrf[i] = (float)xr[i];
+      xri[i] = rand () % 2001 - 1000;
+   }
+   // Complex, both radix-4 and radix-2 sizes
+   dft_c (xc, Rc, n);
+   fft_c (xc, Xc, n);
+   err += _report ("fft_c vs dft_c", n, _err_c (Xc, Rc, n), n * 1e-15);
+   _ref (xc, Rc, n);
+   err += _report ("fft_c", n, _err_c (Xc, Rc, n), 1e-14);
+   ifft_c (Xc, Xc, n);
+   err += _report ("ifft_c", n, _err_c (Xc, xc, n), 1e-14);
+
+   dft_cf (xcf, Rcf, n);
+   fft_cf (xcf, Xcf, n);
+   err += _report ("fft_cf vs dft_cf", n, _err_cf (Xcf, Rcf, n), n * 1e-6);
+   for (i=0 ; i<n ; ++i)
+      Rcf[i] = (complex_f_t)Rc[i];     // xcf is xc rounded to float
+   err += _report ("fft_cf", n, _err_cf (Xcf, Rcf, n), 2e-6);
+   ifft_cf (Xcf, Xcf, n);
+   err += _report ("ifft_cf", n, _err_cf (Xcf, xcf, n), 2e-6);
+
+   // Real, the packed path. The time arrays are 2*n long.
+   for (i=0 ; i<n ; ++i)
+      xc[i] = xr[i];
+   dft_c (xc, Rc, n);
+   for (i=0 ; i<n ; ++i)
+      yr[i] = xr[i];
+   fft_r (yr, Xc, n);
+   err += _report ("fft_r vs dft_c", n, _err_c (Xc, Rc, n), n * 1e-15);
+   _ref (xc, Rc, n);
+   err += _report ("fft_r", n, _err_c (Xc, Rc, n), 1e-14);
+
+   for (i=0 ; i<2*n ; ++i)
+      yr[i] = 1e300;
+   ifft_r (Xc, yr, n);
+   for (i=0 ; i<n ; ++i)
+      Xc[i] = yr[i];
+   err += _report ("ifft_r", n, _err_c (Xc, xc, n), 1e-14);
+   for (i=n ; i<2*n ; ++i)
+      err += _report ("ifft_r zero tail", n, fabs (yr[i]), 0);
+
+   for (i=0 ; i<n ; ++i) {
+      xcf[i] = xrf[i];
+      xc[i] = xrf[i];
+   }
+   dft_cf (xcf, Rcf, n);
+   for (i=0 ; i<n ; ++i)
+      yrf[i] = xrf[i];
+   fft_rf (yrf, Xcf, n);
+   err += _report ("fft_rf vs dft_cf", n, _err_cf (Xcf, Rcf, n), n * 1e-6);
+   _ref (xc, Rc, n);
+   for (i=0 ; i<n ; ++i)
+      Rcf[i] = (complex_f_t)Rc[i];
+   err += _report ("fft_rf", n, _err_cf (Xcf, Rcf, n), 2e-6);
+
+   for (i=0 ; i<2*n ; ++i)
+      yrf[i] = 1e30f;
+   ifft_rf (Xcf, yrf, n);
+   for (i=0 ; i<n ; ++i)
+      Xcf[i] = yrf[i];
+   err += _report ("ifft_rf", n, _err_cf (Xcf, xcf, n), 2e-6);
+   for (i=n ; i<2*n ; ++i)
+      err += _report ("ifft_rf zero tail", n, fabs (yrf[i]), 0);
+
+   for (i=0 ; i<n ; ++i)
+      xc[i] = xri[i];
+   _ref (xc, Rc, n);
+   for (i=0 ; i<n ; ++i)
+      Rcf[i] = (complex_f_t)Rc[i];
+   fft_ri (xri, Xcf, n);
+   err += _report ("fft_ri", n, _err_cf (Xcf, Rcf, n), 2e-6);
+   return err;
+}
+
+/*
+ * In place real transforms, the time and frequency arrays are the same
+ */
+static int _check_in_place (uint32_t n)
+{
+   complex_d_t *X = (complex_d_t*)yr;
+   uint32_t i;
+
+   for (i=0 ; i<n ; ++i)
+      yr[i] = xr[i] = _rnd ();
+   fft_r (yr, X, n);
+   ifft_r (X, yr, n);
+   for (i=0 ; i<n ; ++i)
+      if (fabs (yr[i] - xr[i]) > 1e-14)
+         return _report ("in place ifft_r", n, fabs (yr[i] - xr[i]), 1e-14);
+   return 0;
+}
+
+static void _bench (void)
+{
+   uint32_t n, r, runs;
+   double t0, t1, t2, t3;
+
+   printf ("%8s %12s %12s %12s\n", "n", "dft_c us", "fft_c us", "fft_r us");
+   for (n=64 ; n<=NBENCH ; n<<=2) {
+      runs = 4000000 / n;
+      for (r=0 ; r<n ; ++r)
+         bx[r] = _rnd ();
+      t0 = _now ();
+      if (n <= 1024)
+         dft_c (bx, Rc, n);
+      t1 = _now ();
+      for (r=0 ; r<runs ; ++r)
+         fft_c (bx, bx, n);
+      t2 = _now ();
+      for (r=0 ; r<runs ; ++r)
+         fft_r ((double*)bx, bx, n);
+      t3 = _now ();
+      if (n <= 1024)
+         printf ("%8u %12.2f %12.3f %12.3f\n", n, (t1-t0)*1e6, (t2-t1)*1e6/runs, (t3-t2)*1e6/runs);
+      else
+         printf ("%8u %12s %12.3f %12.3f\n", n, "-", (t2-t1)*1e6/runs, (t3-t2)*1e6/runs);
+   }
+}
+
+/*
+ * Each thread cycles more sizes than the plan cache holds, so a shared cache
+ * would evict the plans of the other threads in the middle of a transform.
+ * The results must match a private plan bit for bit.
+ */
+static void* _thread (void *arg)
+{
+   static const uint32_t sz[TSIZES] = { 16, 32, 64, 128, 256, 512, 1024, 2048 };
+   complex_d_t *x = malloc (2048 * sizeof (complex_d_t));
+   complex_d_t *X = malloc (2048 * sizeof (complex_d_t));
+   complex_d_t *R = malloc (2048 * sizeof (complex_d_t));
+   unsigned int seed = (unsigned int)(uintptr_t)arg;
+   fft_plan_t p;
+   int *err = (int*)arg;
+   uint32_t r, i, n;
+
+   for (r=0 ; r<2000 ; ++r) {
+      n = sz[(r + *err) % TSIZES];
+      for (i=0 ; i<n ; ++i)
+         x[i] = (double)rand_r (&seed) / RAND_MAX + I * (double)rand_r (&seed) / RAND_MAX;
+      fft_plan_create (&p, n, FFT_PLAN_D);
+      fft_plan_execute_c (&p, x, R);
+      fft_plan_destroy (&p);
+      fft_c (x, X, n);
+      if (memcmp (X, R, n * sizeof (complex_d_t)) != 0)
+         ++*err;
+   }
+   fft_plan_flush ();
+   free (x); free (X); free (R);
+   return NULL;
+}
+
+static int _check_threads (void)
+{
+   pthread_t th[THREADS];
+   int e[THREADS], err = 0;
+   int i;
+
+   for (i=0 ; i<THREADS ; ++i) {
+      e[i] = i;
+      pthread_create (&th[i], NULL, _thread, &e[i]);
+   }
+   for (i=0 ; i<THREADS ; ++i) {
+      pthread_join (th[i], NULL);
+      err += e[i] - i;
+   }
+   if (err)
+      printf ("threads: %d mismatches\n", err);
+   return err;
+}
+
+/*
+ * The same transform with the tables built on every call, with a plan made
+ * once, and through the plan cache of fft_c
+ */
+static void _bench_plan (void)
+{
+   fft_plan_t p;
+   uint32_t n, r, runs;
+   double t0, t1, t2, t3;
+
+   printf ("%8s %14s %12s %12s\n", "n", "unplanned us", "planned us", "fft_c us");
+   for (n=64 ; n<=NBENCH ; n<<=1) {
+      runs = 4000000 / n;
+      for (r=0 ; r<n ; ++r)
+         bx[r] = _rnd ();
+      t0 = _now ();
+      for (r=0 ; r<runs ; ++r) {
+         fft_plan_create (&p, n, FFT_PLAN_D);
+         fft_plan_execute_c (&p, bx, bx);
+         fft_plan_destroy (&p);
+      }
+      t1 = _now ();
+      fft_plan_create (&p, n, FFT_PLAN_D);
+      for (r=0 ; r<runs ; ++r)
+         fft_plan_execute_c (&p, bx, bx);
+      fft_plan_destroy (&p);
+      t2 = _now ();
+      for (r=0 ; r<runs ; ++r)
+         fft_c (bx, bx, n);
+      t3 = _now ();
+      printf ("%8u %14.3f %12.3f %12.3f\n", n, (t1-t0)*1e6/runs, (t2-t1)*1e6/runs, (t3-t2)*1e6/runs);
+   }
+}
+
+int main (void)
+{
+   int err = 0;
+   uint32_t n;
+
+   srand (1);
+   for (n=2 ; n<=NMAX ; n<<=1) {
+      err += _check (n);
+      err += _check_in_place (n);
+   }
+   err += _check_threads ();
+   _bench ();
+   _bench_plan ();
+   printf ("fft: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
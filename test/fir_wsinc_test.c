@@ -0,0 +1,234 @@
+/*!
+ * \file fir_wsinc_test.c
+ * \brief
+ *    Host test of the windowed sinc streaming engine. It feeds a signal to
+ *    fir_wsinc_block() in pieces of random length, from single samples to
+ *    several partitions, and one by one to fir_wsinc_d()/_f()/_cf(), for
+ *    kernels on both sides of FIR_WSINC_DF_TAPS, and checks the output
+ *    against the block filter fir_wsinc(), shifted by the latency of the
+ *    partitioned path. Then it times the streaming engine against
+ *    fir_wsinc() on growing buffers.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc fir_wsinc_test.c ../src/dsp/fir_wsinc.c ../src/dsp/fft.c ../src/dsp/vectors.c ../src/math/math.c -lm -o fir_wsinc_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dsp/fir_wsinc.h>
+#include "bench.h"
+
+#define NS        (20000)     // Samples through the streaming engine
+#define NS_P2     (32768)     // fir_wsinc() writes up to the next power of 2
+#define BENCH_N   (65536)     // Largest buffer of the timing
+
+typedef struct {
+   const char     *name;
+   fir_ftype_en   ftype;
+   fir_wtype_en   wtype;
+   double         fc1, fc2, tb;
+   uint32_t       casc;
+}filter_t;
+
+static const filter_t filters[] = {
+   { "low pass, direct",            FIR_LOW_PASS,    FIR_WSINC_BLACKMAN, 0.10, 0,    0.10, 1 },
+   { "high pass, 1 tap over",       FIR_HIGH_PASS,   FIR_WSINC_HAMMING,  0.20, 0,    0.0508, 1 },
+   { "band pass, partitioned",      FIR_BAND_PASS,   FIR_WSINC_BLACKMAN, 0.10, 0.20, 0.02, 1 },
+   { "band reject, partitioned",    FIR_BAND_REJECT, FIR_WSINC_HANNING,  0.15, 0.30, 0.01, 1 },
+   { "low pass, cascade 3",         FIR_LOW_PASS,    FIR_WSINC_BLACKMAN, 0.05, 0,    0.05, 3 },
+};
+
+static double        x[NS], xi[NS], ref[NS_P2], refi[NS_P2], y[NS];
+static float         yf[NS];
+static complex_f_t   ycf[NS];
+static double        bx[BENCH_N], by[BENCH_N];
+
+static double _rnd (void) {
+   return (double)rand () / RAND_MAX * 2 - 1;
+}
+
+static int _init (fir_wsinc_t *f, const filter_t *p)
+{
+   memset ((void*)f, 0, sizeof (fir_wsinc_t));
+   fir_wsinc_set_ftype (f, p->ftype);
+   fir_wsinc_set_wtype (f, p->wtype);
+   fir_wsinc_set_fc (f, p->fc1, p->fc2);
+   fir_wsinc_set_tb (f, p->tb);
+   fir_wsic_set_cascade (f, p->casc);
+   return fir_wsinc_init (f) != 0;
+}
+
+/*
+ * Maximum error of the n first points against ref, delayed by L samples,
+ * relative to the largest reference point
+ */
+static double _rel_err (const double *r, const double *o, uint32_t n, uint32_t L)
+{
+   double e = 0, m = 0, v;
+   uint32_t k;
+
+   for (k=0 ; k<n ; ++k) {
+      v = (k < L) ? 0 : r[k-L];
+      if (fabs (o[k] - v) > e)   e = fabs (o[k] - v);
+      if (fabs (v) > m)          m = fabs (v);
+   }
+   return e / m;
+}
+
+static int _report (const char *name, const char *what, double e, double tol)
+{
+   if (e <= tol)
+      return 0;
+   printf ("%s, %s: error %g > %g\n", name, what, e, tol);
+   return 1;
+}
+
+/*
+ * Pieces of random length, with pieces that end exactly on, just before
+ * and just after a partition boundary
+ */
+static uint32_t _piece (uint32_t i, uint32_t B)
+{
+   uint32_t n;
+
+   if (!B)  B = FIR_WSINC_PART_SIZE;
+   switch (rand () % 6) {
+      case 0:  n = 1; break;
+      case 1:  n = B - i % B;     break;   // To the boundary
+      case 2:  n = B - i % B - 1; break;   // Just before
+      case 3:  n = B - i % B + 1; break;   // Just after
+      case 4:  n = 2*B + rand () % (3*B); break;
+      default: n = rand () % B; break;
+   }
+   return (n > NS - i) ? NS - i : n;
+}
+
+static int _check (const filter_t *p)
+{
+   fir_wsinc_t f;
+   uint32_t i, k, n, pass;
+   char what[32];
+   float e;
+   int err = 0;
+
+   if (!_init (&f, p)) {
+      printf ("%s: fir_wsinc_init failed\n", p->name);
+      return 1;
+   }
+   printf ("%-26s T=%4u B=%3u P=%u\n", p->name, f.T, f.B, f.P);
+   for (i=0 ; i<NS ; ++i) {
+      x[i] = _rnd ();
+      xi[i] = _rnd ();
+   }
+   fir_wsinc (&f, x, ref, NS);
+   fir_wsinc (&f, xi, refi, NS);
+
+   // Block calls of any length. The second pass checks fir_wsinc_reset()
+   for (pass=0 ; pass<2 ; ++pass) {
+      fir_wsinc_reset (&f);
+      for (i=0 ; i<NS ; i+=n)
+         fir_wsinc_block (&f, &x[i], &y[i], n = _piece (i, f.B));
+      snprintf (what, sizeof (what), "fir_wsinc_block pass %u", pass);
+      err += _report (p->name, what, _rel_err (ref, y, NS, f.B), 1e-12);
+   }
+   // In place
+   fir_wsinc_reset (&f);
+   memcpy ((void*)y, (void*)x, sizeof (x));
+   for (i=0 ; i<NS ; i+=n)
+      fir_wsinc_block (&f, &y[i], &y[i], n = _piece (i, f.B));
+   err += _report (p->name, "fir_wsinc_block in place", _rel_err (ref, y, NS, f.B), 1e-12);
+
+   // Sample by sample
+   fir_wsinc_reset (&f);
+   for (i=0 ; i<NS ; ++i)
+      y[i] = fir_wsinc_d (&f, x[i]);
+   err += _report (p->name, "fir_wsinc_d", _rel_err (ref, y, NS, f.B), 1e-12);
+
+   fir_wsinc_reset (&f);
+   for (i=0 ; i<NS ; ++i)
+      yf[i] = fir_wsinc_f (&f, (float)x[i]);
+   for (i=0 ; i<NS ; ++i)
+      y[i] = yf[i];
+   err += _report (p->name, "fir_wsinc_f", _rel_err (ref, y, NS, f.B), 1e-5);
+
+   // The complex streams run in direct form, without latency
+   fir_wsinc_reset (&f);
+   for (i=0 ; i<NS ; ++i)
+      ycf[i] = fir_wsinc_cf (&f, (complex_f_t)(x[i] + I*xi[i]));
+   for (k=0 ; k<2 ; ++k) {
+      for (i=0 ; i<NS ; ++i)
+         y[i] = (k) ? cimagf (ycf[i]) : crealf (ycf[i]);
+      e = _rel_err ((k) ? refi : ref, y, NS, 0);
+      err += _report (p->name, (k) ? "fir_wsinc_cf imag" : "fir_wsinc_cf real", e, 1e-5);
+   }
+   fir_wsinc_deinit (&f);
+   return err;
+}
+
+/*
+ * Samples per second of fir_wsinc() on the whole buffer, of one
+ * fir_wsinc_block() call and of fir_wsinc_d() per sample
+ */
+static void _bench (const filter_t *p)
+{
+   fir_wsinc_t f;
+   uint32_t n, i, r, runs;
+   double t0, tb, ts, td;
+
+   if (!_init (&f, p))
+      return;
+   for (i=0 ; i<BENCH_N ; ++i)
+      bx[i] = _rnd ();
+   printf ("%s, T=%u\n", p->name, f.T);
+   printf ("%8s %16s %16s %16s\n", "n", "fir_wsinc", "fir_wsinc_block", "fir_wsinc_d");
+   for (n=256 ; n<=BENCH_N ; n<<=2) {
+      runs = 4*BENCH_N / n;
+      t0 = _now ();
+      for (r=0 ; r<runs ; ++r)
+         fir_wsinc (&f, bx, by, n);
+      tb = _now () - t0;
+      t0 = _now ();
+      for (r=0 ; r<runs ; ++r)
+         fir_wsinc_block (&f, bx, by, n);
+      ts = _now () - t0;
+      t0 = _now ();
+      for (r=0 ; r<runs ; ++r)
+         for (i=0 ; i<n ; ++i)
+            by[i] = fir_wsinc_d (&f, bx[i]);
+      td = _now () - t0;
+      printf ("%8u %12.2f Ms/s %12.2f Ms/s %12.2f Ms/s\n", n,
+              (double)n*runs / tb * 1e-6, (double)n*runs / ts * 1e-6, (double)n*runs / td * 1e-6);
+   }
+   fir_wsinc_deinit (&f);
+}
+
+int main (void)
+{
+   int err = 0;
+   size_t i;
+
+   srand (1);
+   for (i=0 ; i<sizeof (filters) / sizeof (filters[0]) ; ++i)
+      err += _check (&filters[i]);
+   _bench (&filters[0]);
+   _bench (&filters[2]);
+   printf ("fir_wsinc: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
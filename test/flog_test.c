@@ -0,0 +1,365 @@
+/*!
+ * \file flog_test.c
+ * \brief
+ *    Host test of the flash log store on the NOR flash simulator. It cuts
+ *    the power at random flash operations, in the middle of page programs
+ *    and sector erases, remounts and checks every key against the records
+ *    written since the last sync. It checks that the index rebuilt at mount
+ *    after many reclamations is the one the store had in RAM, and that hot
+ *    keys over cold data spread the erase counts by about FLOG_WEAR_DELTA.
+ *    Then it prints the write throughput and the write amplification.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc flog_test.c ../src/drv/flog.c ../src/drv/sim_nor.c ../src/algo/crc.c -o flog_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <drv/flog.h>
+#include <drv/sim_nor.h>
+#include "bench.h"
+
+#define SECTORS      (8)
+#define SECTOR_SZ    (4096)
+#define PAGE_SZ      (256)
+#define KEYS         (64)
+#define MAX_LEN      (120)
+#define CUTS         (2000)      // Power cuts
+#define WEAR_WRITES  (200000)    // Hot key writes of the wear test
+
+static byte_t        mem[SECTORS * SECTOR_SZ];
+static uint32_t      ecnt[SECTORS];
+static snor_t        nor;
+static flog_t        flog;
+static flog_addr_t   index_[KEYS], index_ram[KEYS];
+static flog_sector_t sec[SECTORS];
+static byte_t        page[PAGE_SZ];
+
+/*
+ * The versions of each key that may be in flash. lo is the synced one,
+ * hi the last one written.
+ */
+static uint32_t      lo[KEYS], hi[KEYS];
+
+/*
+ * Power cut. The flash operations count down to the cut. The operation
+ * of the cut is done in part and all the next ones fail.
+ */
+static int           budget = -1;   // -1 for no cut
+static int           dead;
+
+static int _cut (void)
+{
+   if (dead)
+      return 1;
+   if (budget > 0 && --budget == 0) {
+      dead = 1;
+      return 2;
+   }
+   return 0;
+}
+
+static drv_status_en _fl_read (void *f, uint32_t a, byte_t *b, int n) {
+   return snor_read ((snor_t*)f, a, b, n);
+}
+static drv_status_en _fl_write (void *f, uint32_t a, byte_t *b, int n)
+{
+   switch (_cut ()) {
+      case 0:  return snor_write ((snor_t*)f, a, b, n);
+      case 2:  snor_write ((snor_t*)f, a, b, rand () % n);   // Part of the program
+               /* fall through */
+      default: return DRV_ERROR;
+   }
+}
+static drv_status_en _fl_ioctl (void *f, ioctl_cmd_t cmd, ioctl_buf_t buf)
+{
+   switch (_cut ()) {
+      case 0:  return snor_ioctl ((snor_t*)f, cmd, buf);
+      case 2:  if (rand () & 1)                             // The erase may be done
+                  snor_ioctl ((snor_t*)f, cmd, buf);
+               /* fall through */
+      default: return DRV_ERROR;
+   }
+}
+
+/*
+ * The record of each key and version. The data start with the version.
+ * Version 0 is no record.
+ */
+static uint32_t _hash (flog_key_t key, uint32_t ver) {
+   return (key * 2654435761u) ^ (ver * 40503u + 0x9E37u);
+}
+static int _deleted (flog_key_t key, uint32_t ver) {
+   return ver == 0 || (_hash (key, ver) >> 8) % 13 == 0;
+}
+static int _len (flog_key_t key, uint32_t ver) {
+   return 4 + _hash (key, ver) % (MAX_LEN - 3);
+}
+static void _fill (byte_t *b, flog_key_t key, uint32_t ver)
+{
+   int i, n = _len (key, ver);
+
+   memcpy ((void*)b, (void*)&ver, 4);
+   for (i=4 ; i<n ; ++i)
+      b[i] = (byte_t)(key*31 + ver*7 + i);
+}
+
+static drv_status_en _put (flog_key_t key, uint32_t ver)
+{
+   byte_t b[MAX_LEN];
+
+   if (_deleted (key, ver))
+      return flog_write (&flog, key, NULL, 0);
+   _fill (b, key, ver);
+   return flog_write (&flog, key, b, _len (key, ver));
+}
+
+static int _mount (void)
+{
+   flog_deinit (&flog);
+   flog_link_flash (&flog, &nor);
+   flog_link_flash_read (&flog, _fl_read);
+   flog_link_flash_write (&flog, _fl_write);
+   flog_link_flash_ioctl (&flog, _fl_ioctl);
+   flog_link_index (&flog, index_, KEYS);
+   flog_link_sectors (&flog, sec, SECTORS);
+   flog_link_page (&flog, page);
+   flog_set_sector_size (&flog, SECTOR_SZ);
+   flog_set_page_size (&flog, PAGE_SZ);
+   return flog_init (&flog) == DRV_READY;
+}
+
+/*
+ * Each key has one of the versions [lo, hi]. The found version becomes
+ * the only one.
+ */
+static int _check_keys (const char *when)
+{
+   byte_t b[MAX_LEN + 8], r[MAX_LEN];
+   uint32_t v, found;
+   int n, err = 0;
+   flog_key_t k;
+
+   for (k=0 ; k<KEYS ; ++k) {
+      n = flog_read (&flog, k, b, sizeof (b));
+      found = 0xFFFFFFFF;
+      if (n > 0) {
+         memcpy ((void*)&v, (void*)b, 4);
+         if (n >= 4 && v >= lo[k] && v <= hi[k] && !_deleted (k, v) && n == _len (k, v)) {
+            _fill (r, k, v);
+            if (memcmp (b, r, n) == 0)
+               found = v;
+         }
+      }
+      else if (n == 0) {
+         for (v=hi[k] ; v+1>lo[k] && v+1>0 ; --v)
+            if (_deleted (k, v)) {
+               found = v;
+               break;
+            }
+      }
+      if (found == 0xFFFFFFFF) {
+         if (err++ < 5)
+            printf ("%s: key %u read %d, versions %u..%u\n", when, k, n, lo[k], hi[k]);
+         continue;
+      }
+      lo[k] = hi[k] = found;
+   }
+   return err;
+}
+
+/*
+ * Random writes, deletes, syncs and services until the power cut
+ */
+static int _workload (int ops)
+{
+   flog_key_t k;
+   int i;
+
+   for (i=0 ; i<ops && !dead ; ++i) {
+      k = rand () % KEYS;
+      if (_put (k, hi[k] + 1) == DRV_READY)
+         ++hi[k];
+      else if (!dead) {
+         printf ("flog_write failed without a power cut, %u free sectors\n", flog.free);
+         return 1;
+      }
+      else
+         ++hi[k];    // It may be in flash in part
+      if (rand () % 8 == 0 && flog_sync (&flog) == DRV_READY && !dead)
+         memcpy ((void*)lo, (void*)hi, sizeof (lo));
+      if (rand () % 16 == 0)
+         flog_service (&flog);
+   }
+   return 0;
+}
+
+static int _check_power_cuts (void)
+{
+   uint32_t reclaims = 0;
+   int c, err = 0;
+   char when[32];
+
+   if (!_mount ()) {
+      printf ("first mount failed\n");
+      return 1;
+   }
+   for (c=0 ; c<CUTS && !err ; ++c) {
+      budget = 1 + rand () % 300;
+      dead = 0;
+      err += _workload (1000);
+      reclaims += flog.stat.reclaims;
+      budget = -1;
+      dead = 0;
+      if (!_mount ()) {
+         printf ("mount after cut %d failed\n", c);
+         return 1;
+      }
+      snprintf (when, sizeof (when), "cut %d", c);
+      err += _check_keys (when);
+   }
+   printf ("power cuts: %d, %u reclaims, %u program violations\n", c, reclaims, nor.stat.violations);
+   err += (nor.stat.violations != 0);
+   return err;
+}
+
+/*
+ * The index and the sector table rebuilt at mount after many reclamations
+ */
+static int _check_rebuild (void)
+{
+   flog_sector_t sec_ram[SECTORS];
+   uint32_t s, reclaims = 0;
+   int i, err = 0;
+
+   for (i=0 ; i<20 ; ++i) {
+      err += _workload (5000);
+      reclaims += flog.stat.reclaims;
+      flog_sync (&flog);
+      memcpy ((void*)lo, (void*)hi, sizeof (lo));
+      memcpy ((void*)index_ram, (void*)index_, sizeof (index_));
+      memcpy ((void*)sec_ram, (void*)sec, sizeof (sec));
+      if (!_mount ()) {
+         printf ("rebuild %d: mount failed\n", i);
+         return 1;
+      }
+      if (memcmp (index_ram, index_, sizeof (index_)) != 0) {
+         printf ("rebuild %d: index differs\n", i);
+         ++err;
+      }
+      for (s=0 ; s<SECTORS ; ++s)
+         if (sec[s].seq != sec_ram[s].seq || sec[s].erase_cnt != sec_ram[s].erase_cnt ||
+             sec[s].live != sec_ram[s].live) {
+            printf ("rebuild %d: sector %u differs\n", i, s);
+            ++err;
+         }
+      err += _check_keys ("rebuild");
+      for (s=0 ; s<KEYS ; ++s)
+         err += (lo[s] != hi[s]);
+   }
+   printf ("index rebuild: 20 remounts over %u reclaims\n", reclaims);
+   return err;
+}
+
+/*
+ * Half of the store is cold data written once. Without wear leveling its
+ * sectors would never be erased.
+ */
+static int _check_wear (void)
+{
+   byte_t b[MAX_LEN];
+   uint32_t s, mn, mx;
+   int i, err = 0;
+
+   memset ((void*)mem, 0xFF, sizeof (mem));
+   memset ((void*)ecnt, 0, sizeof (ecnt));
+   memset ((void*)lo, 0, sizeof (lo));
+   memset ((void*)hi, 0, sizeof (hi));
+   _mount ();
+   for (i=8 ; i<KEYS ; ++i)
+      flog_write (&flog, i, b, MAX_LEN);
+   for (i=0 ; i<WEAR_WRITES ; ++i) {
+      if (flog_write (&flog, i % 8, b, 16) != DRV_READY) {
+         printf ("wear: write %d failed\n", i);
+         return 1;
+      }
+      flog_service (&flog);
+   }
+   for (mn=mx=ecnt[0], s=1 ; s<SECTORS ; ++s) {
+      if (ecnt[s] < mn) mn = ecnt[s];
+      if (ecnt[s] > mx) mx = ecnt[s];
+   }
+   printf ("wear: erase counts %u..%u, spread %u, FLOG_WEAR_DELTA %u\n", mn, mx, mx - mn, FLOG_WEAR_DELTA);
+   err += (mx - mn > FLOG_WEAR_DELTA + 2);
+   for (i=8 ; i<KEYS ; ++i)
+      err += (flog_read (&flog, i, b, MAX_LEN) != MAX_LEN);
+   return err;
+}
+
+/*
+ * Records/s on the host and on the simulated flash time, and the flash
+ * bytes programmed per user byte
+ */
+static void _bench (int len)
+{
+   byte_t b[MAX_LEN];
+   uint64_t t_nor, prog;
+   double t0, t;
+   int i, n = 100000;
+
+   memset ((void*)mem, 0xFF, sizeof (mem));
+   _mount ();
+   memset ((void*)b, 0x5A, sizeof (b));
+   nor.stat.time = nor.stat.prog_bytes = 0;
+   t0 = _now ();
+   for (i=0 ; i<n ; ++i) {
+      flog_write (&flog, rand () % KEYS, b, len);
+      flog_service (&flog);
+   }
+   flog_sync (&flog);
+   t = _now () - t0;
+   t_nor = nor.stat.time;
+   prog = nor.stat.prog_bytes;
+   printf ("%4d bytes: %9.0f rec/s host, %8.0f rec/s flash, WA %.2f (copies %.2f)\n", len,
+           n / t, n / (t_nor * 1e-9), (double)prog / flog.stat.user_bytes,
+           (double)flog.stat.copy_bytes / flog.stat.user_bytes);
+}
+
+int main (void)
+{
+   int err = 0;
+
+   srand (1);
+   memset ((void*)mem, 0xFF, sizeof (mem));
+   snor_link_mem (&nor, mem, sizeof (mem));
+   snor_link_erase_cnt (&nor, ecnt);
+   snor_set_page_sz (&nor, PAGE_SZ);
+   snor_set_sector_sz (&nor, SECTOR_SZ);
+   snor_init (&nor);
+
+   err += _check_power_cuts ();
+   err += _check_rebuild ();
+   err += _check_wear ();
+   _bench (8);
+   _bench (32);
+   _bench (MAX_LEN);
+   printf ("flog: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
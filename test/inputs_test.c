@@ -0,0 +1,409 @@
+/*!
+ * \file inputs_test.c
+ * \brief
+ *    Host test of the input scanner. Four TCA9535 banks on an I2C bus model
+ *    and a 32 input GPIO bank, 96 inputs, are driven with bounce patterns.
+ *    Scripted presses check the press, long, repeat, release and long
+ *    release events and their timestamps over the tick wraparound, and that
+ *    bounces and glitches shorter than the debounce make no events. Random
+ *    bouncy traffic on all the inputs is checked against a per input
+ *    reference debouncer, and a full queue counts its lost events. Then it
+ *    measures the time per scan of 32 up to 256 inputs against the old
+ *    btn_service() of 16 buttons.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc inputs_test.c ../src/drv/inputs.c ../src/drv/tca953x.c ../src/drv/buttons.c ../src/algo/ring.c ../src/algo/queue.c -o inputs_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <drv/inputs.h>
+#include <drv/tca953x.h>
+#include <drv/buttons.h>
+#include "bench.h"
+
+#define TCAS         (4)
+#define BANKS        (TCAS + 1)     // The last one is the GPIO bank
+#define INPUTS       (TCAS*16 + 32)
+#define QSIZE        (256)
+#define HOLD         (2000)
+#define REP          (200)
+#define T0           (0xFFFFF000u)  // The ticks wrap during the test
+#define SCANS        (200000)       // Scans of the random traffic
+#define BENCH_SCANS  (200000)
+
+/*
+ * I2C bus with TCA9535 devices. Only the register reads of the driver are
+ * modeled, the input ports follow the pins.
+ */
+typedef struct {
+   uint16_t    pins[TCAS];    // Raw pin levels
+   int         dev;           // Addressed device, -1 for none
+   int         state;         // 0 idle, 1 control, 2 register, 3 read
+   uint8_t     reg;
+   uint32_t    transactions;
+}bus_t;
+
+static bus_t      bus;
+static tca953x_t  tca[TCAS];
+static uint32_t   gpio;          // The GPIO port
+static in_bank_t  bank[BANKS];
+static in_t       in;
+static in_event_t qbuf[QSIZE];
+
+static uint8_t _bus_addr (int d) { return TCA953x_ADDRESS_MASK | (2*d); }
+
+static drv_status_en _bus_ioctl (void *b, ioctl_cmd_t cmd, ioctl_buf_t buf)
+{
+   (void)b; (void)buf;
+   if (cmd == CTRL_START) {
+      bus.state = 1;
+      ++bus.transactions;
+   }
+   else if (cmd == CTRL_STOP)
+      bus.state = 0;
+   return DRV_READY;
+}
+static int _bus_tx (void *b, byte_t byte, int seq)
+{
+   int d;
+
+   (void)b; (void)seq;
+   switch (bus.state) {
+      case 1:
+         for (bus.dev=-1, d=0 ; d<TCAS ; ++d)
+            if ((byte & 0xFE) == _bus_addr (d))
+               bus.dev = d;
+         if (bus.dev < 0)
+            return 0;
+         bus.state = (byte & 1) ? 3 : 2;
+         return 1;
+      case 2:
+         bus.reg = byte;
+         return 1;
+      default:
+         return 0;
+   }
+}
+static byte_t _bus_rx (void *b, uint8_t ack, int seq)
+{
+   byte_t r = 0xFF;
+
+   (void)b; (void)ack; (void)seq;
+   if (bus.state == 3 && bus.reg < 2)
+      r = (byte_t)(bus.pins[bus.dev] >> (8*bus.reg));
+   bus.reg ^= 1;     // Auto increment inside the register pair
+   return r;
+}
+
+static drv_status_en _gpio_read (void *dev, uint32_t *in) {
+   *in = *(uint32_t*)dev;
+   return DRV_READY;
+}
+
+/*
+ * Input i is bit i%16 of TCA i/16, and the GPIO bank after the TCAs.
+ * The TCA inputs are active low.
+ */
+static int _bank_of (int i) { return (i < TCAS*16) ? i/16 : TCAS; }
+static int _bit_of (int i)  { return (i < TCAS*16) ? i%16 : i - TCAS*16; }
+
+static void _pin (int i, int active)
+{
+   if (i < TCAS*16) {
+      if (active)    bus.pins[i/16] &= ~(1u << (i%16));
+      else           bus.pins[i/16] |=  (1u << (i%16));
+   }
+   else {
+      if (active)    gpio |=  (1u << (i - TCAS*16));
+      else           gpio &= ~(1u << (i - TCAS*16));
+   }
+}
+
+static void _setup (uint32_t items, uint32_t rep_mask)
+{
+   int d;
+
+   memset ((void*)&bus, 0, sizeof (bus));
+   for (d=0 ; d<TCAS ; ++d) {
+      bus.pins[d] = 0xFFFF;
+      tca953x_deinit (&tca[d]);
+      tca953x_link_i2c (&tca[d], (void*)&bus);
+      tca953x_link_i2c_rx (&tca[d], _bus_rx);
+      tca953x_link_i2c_tx (&tca[d], _bus_tx);
+      tca953x_link_i2c_ioctl (&tca[d], _bus_ioctl);
+      tca953x_set_hwaddress (&tca[d], 2*d);
+      tca953x_set_timeout (&tca[d], 1);
+      tca953x_init (&tca[d]);
+      in_link_bank (&bank[d], (void*)&tca[d], tca953x_in_read);
+      in_set_bank_mask (&bank[d], 0xFFFF, 0xFFFF);
+      in_set_bank_repeat (&bank[d], rep_mask & 0xFFFF);
+   }
+   gpio = 0;
+   in_link_bank (&bank[TCAS], (void*)&gpio, _gpio_read);
+   in_set_bank_mask (&bank[TCAS], 0xFFFFFFFF, 0);
+   in_set_bank_repeat (&bank[TCAS], rep_mask);
+   in_deinit (&in);
+   in_set_holdtime (&in, HOLD);
+   in_set_reptime (&in, REP);
+   in_init (&in, bank, BANKS, qbuf, items);
+}
+
+/*
+ * The expected events, in queue order
+ */
+static in_event_t exp_ev[4096];
+static int        exp_n, exp_i;
+
+static void _expect (uint32_t t, int i, uint8_t type)
+{
+   exp_ev[exp_n].time = t;
+   exp_ev[exp_n].id = IN_ID (_bank_of (i), _bit_of (i));
+   exp_ev[exp_n].type = type;
+   ++exp_n;
+}
+
+static int _match (const char *when)
+{
+   in_event_t ev;
+   int err = 0;
+
+   while (in_get (&in, &ev)) {
+      if (exp_i >= exp_n || ev.time != exp_ev[exp_i].time || ev.id != exp_ev[exp_i].id ||
+          ev.type != exp_ev[exp_i].type) {
+         if (err++ < 5)
+            printf ("%s: event {%u, id %u, type %u}, expected {%u, id %u, type %u}\n", when,
+                    ev.time - T0, ev.id, ev.type, (exp_i < exp_n) ? exp_ev[exp_i].time - T0 : 0,
+                    (exp_i < exp_n) ? exp_ev[exp_i].id : 0, (exp_i < exp_n) ? exp_ev[exp_i].type : 0);
+      }
+      ++exp_i;
+   }
+   return err;
+}
+
+/*
+ * A pattern is a list of scan times where the pin toggles, starting released
+ */
+typedef struct {
+   int         input;
+   uint32_t    tog[16];
+}pattern_t;
+
+static int _check_scripted (void)
+{
+   static const pattern_t pat[] = {
+      // Press with bounce at 100, settles at 105. Release with bounce at 3500.
+      { 3,  { 100, 101, 102, 104, 105, 3500, 3501, 3502, 0 } },
+      // Glitches of 3 scans, no events
+      { 20, { 50, 53, 60, 61, 62, 65, 0 } },
+      // Long press without repeats
+      { 70, { 200, 3000, 0 } },
+      // Short press of exactly the debounce on the GPIO bank, bounced release
+      { 90, { 300, 304, 306, 308, 0 } },
+   };
+   uint32_t t, k;
+   size_t   p;
+   int      err = 0;
+
+   _setup (QSIZE, 1u << 3);
+   for (t=0 ; t<4000 ; ++t) {
+      for (p=0 ; p<sizeof (pat) / sizeof (pat[0]) ; ++p)
+         for (k=0 ; pat[p].tog[k] ; ++k)
+            if (pat[p].tog[k] == t)
+               _pin (pat[p].input, !(k & 1));
+      in_scan (&in, T0 + t);
+   }
+   // Each input follows after 4 stable scans. The order in a scan is bank
+   // by bank, the presses and releases and then the deadlines.
+   exp_n = exp_i = 0;
+   _expect (T0 + 108, 3, IN_EV_PRESS);
+   _expect (T0 + 203, 70, IN_EV_PRESS);
+   _expect (T0 + 303, 90, IN_EV_PRESS);
+   _expect (T0 + 311, 90, IN_EV_RELEASE);
+   _expect (T0 + 108 + HOLD, 3, IN_EV_LONG);
+   _expect (T0 + 203 + HOLD, 70, IN_EV_LONG);
+   for (t = 108 + HOLD + REP ; t < 3003 ; t += REP)
+      _expect (T0 + t, 3, IN_EV_REPEAT);
+   _expect (T0 + 3003, 70, IN_EV_LONG_RELEASE);
+   for ( ; t <= 3505 ; t += REP)
+      _expect (T0 + t, 3, IN_EV_REPEAT);
+   _expect (T0 + 3505, 3, IN_EV_LONG_RELEASE);
+   err += _match ("scripted");
+   if (exp_i != exp_n) {
+      printf ("scripted: %d events, expected %d\n", exp_i, exp_n);
+      ++err;
+   }
+   err += (in_state (&in, 0) != 0 || in.lost != 0);
+   return err;
+}
+
+/*
+ * Reference debouncer, one input at a time. The state follows a sample
+ * that differs for 4 scans in a row.
+ */
+typedef struct {
+   uint8_t     raw, state, cnt, lng, tmr;
+   uint32_t    dl;
+}ref_t;
+
+static ref_t ref[INPUTS];
+
+static int _check_random (void)
+{
+   uint32_t t, now, rep = 0x5A5A5A5A;
+   int      i, b, bit, err = 0, bounce[INPUTS] = {0};
+   ref_t    *r;
+   uint32_t events = 0;
+
+   _setup (QSIZE, rep);
+   memset ((void*)ref, 0, sizeof (ref));
+   for (t=0 ; t<SCANS && err<5 ; ++t) {
+      now = T0 + t;
+      // Pin activity. A change bounces for up to 8 scans.
+      for (i=0 ; i<INPUTS ; ++i) {
+         if (bounce[i]) {
+            --bounce[i];
+            _pin (i, ref[i].raw = (bounce[i]) ? rand () & 1 : ref[i].raw ^ (rand () % 3 == 0));
+         }
+         else if (rand () % 1500 == 0)
+            bounce[i] = 1 + rand () % 8;
+         else if (rand () % 4000 == 0)
+            _pin (i, ref[i].raw ^= 1);
+      }
+      in_scan (&in, now);
+
+      // The expected events in scan order
+      exp_n = exp_i = 0;
+      for (b=0 ; b<BANKS ; ++b) {
+         int n = (b < TCAS) ? 16 : 32, first = (b < TCAS) ? 16*b : 16*TCAS;
+         for (bit=0 ; bit<n ; ++bit) {
+            r = &ref[first + bit];
+            r->cnt = (r->raw != r->state) ? r->cnt + 1 : 0;
+            if (r->cnt < 4)
+               continue;
+            r->cnt = 0;
+            r->state ^= 1;
+            if (r->state) {
+               _expect (now, first + bit, IN_EV_PRESS);
+               r->tmr = 1;
+               r->dl = now + HOLD;
+            }
+            else {
+               _expect (now, first + bit, (r->lng) ? IN_EV_LONG_RELEASE : IN_EV_RELEASE);
+               r->tmr = r->lng = 0;
+            }
+         }
+         for (bit=0 ; bit<n ; ++bit) {
+            r = &ref[first + bit];
+            if (!r->tmr || (int32_t)(now - r->dl) < 0)
+               continue;
+            _expect (now, first + bit, (r->lng) ? IN_EV_REPEAT : IN_EV_LONG);
+            r->lng = 1;
+            if (rep & (1u << bit))
+               r->dl = now + REP;
+            else
+               r->tmr = 0;
+         }
+      }
+      events += exp_n;
+      err += _match ("random");
+      err += (exp_i != exp_n);
+   }
+   printf ("random: %u scans of %d inputs, %u events, %u I2C transactions\n", t, INPUTS, events, bus.transactions);
+
+   // A full queue drops and counts
+   _setup (16, 0);
+   gpio = 0xFFFFFFFF;
+   for (t=0 ; t<4 ; ++t)
+      in_scan (&in, T0 + t);
+   if (in.lost != 32 - 16) {
+      printf ("full queue: %u lost\n", in.lost);
+      ++err;
+   }
+   in_flush (&in);
+   err += (in_get (&in, &exp_ev[0]) != 0);
+   return err;
+}
+
+/*
+ * Time per scan of the old 16 button service and of the scanner with 32
+ * to 256 inputs on memory banks, a press and release every few scans
+ */
+static uint16_t   btn_port;
+#define _BTN(_n)  static uint8_t _btn##_n (void) { return (btn_port >> _n) & 1; }
+_BTN(0) _BTN(1) _BTN(2) _BTN(3) _BTN(4) _BTN(5) _BTN(6) _BTN(7)
+_BTN(8) _BTN(9) _BTN(10) _BTN(11) _BTN(12) _BTN(13) _BTN(14) _BTN(15)
+
+static void _bench (void)
+{
+   static in_bank_t bk[8];
+   static uint32_t  port[8];
+   in_event_t ev;
+   double   t0, t;
+   uint32_t s;
+   int      b, n;
+
+   btn_init ();
+   btn_link_btn0 (_btn0);   btn_link_btn1 (_btn1);   btn_link_btn2 (_btn2);   btn_link_btn3 (_btn3);
+   btn_link_btn4 (_btn4);   btn_link_btn5 (_btn5);   btn_link_btn6 (_btn6);   btn_link_btn7 (_btn7);
+   btn_link_btn8 (_btn8);   btn_link_btn9 (_btn9);   btn_link_btn10 (_btn10); btn_link_btn11 (_btn11);
+   btn_link_btn12 (_btn12); btn_link_btn13 (_btn13); btn_link_btn14 (_btn14); btn_link_btn15 (_btn15);
+   btn_set_holdtime (HOLD);
+   t0 = _now ();
+   for (s=0 ; s<BENCH_SCANS ; ++s) {
+      btn_port = ((s >> 6) & 1) << (s >> 7) % 16;
+      btn_service ();
+      btn_getkey (0);
+   }
+   t = _now () - t0;
+   printf ("%-22s %4d inputs %8.1f ns/scan %6.2f ns/input\n", "btn_service", 16, t / BENCH_SCANS * 1e9, t / BENCH_SCANS / 16 * 1e9);
+
+   for (n=1 ; n<=8 ; n*=2) {
+      for (b=0 ; b<n ; ++b) {
+         in_link_bank (&bk[b], (void*)&port[b], _gpio_read);
+         in_set_bank_mask (&bk[b], 0xFFFFFFFF, 0);
+         in_set_bank_repeat (&bk[b], 0xFFFFFFFF);
+         port[b] = 0;
+      }
+      in_deinit (&in);
+      in_init (&in, bk, n, qbuf, QSIZE);
+      t0 = _now ();
+      for (s=0 ; s<BENCH_SCANS ; ++s) {
+         port[(s >> 7) % n] = ((s >> 6) & 1) << (s >> 9) % 32;
+         in_scan (&in, s);
+         while (in_get (&in, &ev))
+            ;
+      }
+      t = _now () - t0;
+      printf ("%-22s %4d inputs %8.1f ns/scan %6.2f ns/input\n", "in_scan", 32*n, t / BENCH_SCANS * 1e9, t / BENCH_SCANS / (32*n) * 1e9);
+   }
+}
+
+int main (void)
+{
+   int err = 0;
+
+   srand (1);
+   err += _check_scripted ();
+   err += _check_random ();
+   _bench ();
+   printf ("inputs: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,386 @@
+/*!
+ * \file nmea_test.c
+ * \brief
+ *    Host test of the NMEA stream parser. It builds a GPS log of GGA, GLL,
+ *    GSA, GSV, RMC, VTG, ZDA and proprietary sentences with noise between
+ *    them, bad checksums and sentences cut by a '$', and feeds it to
+ *    nmea_feed() in random chunk sizes. Every callback is checked in order
+ *    against the sentence it comes from, then the cache, the counters and
+ *    nmea_read_xxx() on the input link. Then it measures sentences/s.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc nmea_test.c ../src/com/nmea.c -lm -o nmea_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <com/nmea.h>
+#include "bench.h"
+
+#define EPOCHS    (2000)      // One fix per second
+#define LOG_SIZE  (EPOCHS * 700)
+#define SENS      (EPOCHS * 10)
+#define BENCH_MB  (64)        // Log volume of the timing
+
+/*
+ * A sentence of the log and what the parser has to report for it
+ */
+typedef struct {
+   nmea_msgid_en  id;         //!< NMEA_NULL for proprietary sentences
+   nmea_common_t  v;          //!< The expected data
+}expect_t;
+
+static char       lg[LOG_SIZE];
+static int        lg_n;
+static expect_t   ex[SENS];
+static int        ex_n, ex_valid, ex_errors;
+static int        cb_i, cb_err;
+static nmea_t     nmea;
+static int        rd;         // Input link position
+
+/*
+ * Add "$<body>*<cs>\r\n" to the log. bad: 1 for a wrong checksum, 2 to cut
+ * the sentence in the middle, so the next '$' has to re-synchronise.
+ */
+static void _add (const char *body, nmea_msgid_en id, const nmea_common_t *v, int bad)
+{
+   int cs = 0, n = strlen (body);
+   const char *p;
+
+   for (p=body ; *p ; ++p)
+      cs ^= *p;
+   if (bad == 2) {
+      lg_n += sprintf (&lg[lg_n], "$%.*s", n/2, body);
+      ++ex_errors;
+      return;
+   }
+   if (bad == 1) {
+      cs ^= 0x21;
+      ++ex_errors;
+   }
+   lg_n += sprintf (&lg[lg_n], "$%s*%02X\r\n", body, cs);
+   if (!bad) {
+      ex[ex_n].id = id;
+      ex[ex_n].v = *v;
+      ++ex_n;
+      ++ex_valid;
+   }
+}
+
+/*
+ * Noise between sentences, as a receiver's binary messages. No '$' in it.
+ */
+static void _noise (void)
+{
+   int i, n = rand () % 24;
+
+   for (i=0 ; i<n ; ++i) {
+      char c = rand () % 256;
+      lg[lg_n++] = (c == '$') ? '#' : c;
+   }
+}
+
+static void _build (void)
+{
+   nmea_common_t v;
+   char b[160], lat[24], lon[24];
+   int k, hh, mm, ss, sec, bad;
+   double la, lo;
+
+   lg_n = ex_n = ex_valid = ex_errors = 0;
+   for (k=0 ; k<EPOCHS ; ++k) {
+      sec = 12*3600 + 34*60 + 56 + k;
+      hh = (sec / 3600) % 24; mm = (sec / 60) % 60; ss = sec % 60;
+      la = 37.9690 + k * 1e-4;
+      lo = 23.7167 + k * 2e-4;
+      snprintf (lat, sizeof (lat), "%02d%07.4f,%c", (int)la, (la - (int)la) * 60, (k & 1) ? 'S' : 'N');
+      snprintf (lon, sizeof (lon), "%03d%07.4f,%c", (int)lo, (lo - (int)lo) * 60, (k & 2) ? 'W' : 'E');
+      la *= (k & 1) ? -1 : 1;
+      lo *= (k & 2) ? -1 : 1;
+      // One sentence in 16 is bad, one in 16 is cut
+      #define _bad()    ((bad = rand () % 16) < 2 ? bad + 1 : 0)
+
+      memset ((void*)&v, 0, sizeof (v));
+      v.fix = (k % 7) ? NMEA_FIX : NMEA_DFIX;
+      v.sats = 4 + k % 9;
+      v.time.hour = hh; v.time.min = mm; v.time.sec = ss + 0.25f;
+      v.latitude = la; v.longitude = lo;
+      v.elevation = 545.4f + k % 100;
+      snprintf (b, sizeof (b), "GPGGA,%02d%02d%02d.25,%s,%s,%d,%02d,0.9,%.1f,M,46.9,M,,",
+                hh, mm, ss, lat, lon, v.fix, v.sats, v.elevation);
+      _add (b, NMEA_GGA, &v, _bad ());
+      _noise ();
+
+      memset ((void*)&v, 0, sizeof (v));
+      v.valid = (k % 5) ? NMEA_VALID : NMEA_NOT_VALID;
+      v.time.hour = hh; v.time.min = mm; v.time.sec = ss;
+      v.latitude = la; v.longitude = lo;
+      snprintf (b, sizeof (b), "GPGLL,%s,%s,%02d%02d%02d.00,%c,A", lat, lon, hh, mm, ss, (v.valid == NMEA_VALID) ? 'A' : 'V');
+      _add (b, NMEA_GLL, &v, _bad ());
+
+      memset ((void*)&v, 0, sizeof (v));
+      _add ("GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1", NMEA_GSA, &v, _bad ());
+
+      v.sats = 9 + k % 4;
+      snprintf (b, sizeof (b), "GPGSV,3,1,%02d,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00", v.sats);
+      _add (b, NMEA_GSV, &v, _bad ());
+      _noise ();
+
+      memset ((void*)&v, 0, sizeof (v));
+      v.valid = (k % 5) ? NMEA_VALID : NMEA_NOT_VALID;
+      v.time.hour = hh; v.time.min = mm; v.time.sec = ss;
+      v.date.day = 1 + k % 28; v.date.month = 1 + k % 12; v.date.year = 2024;
+      v.latitude = la; v.longitude = lo;
+      v.speed_knt = 22.4f + k % 10;
+      v.course_t = 84.4f;
+      v.mag_var = (k & 4) ? -3.1f : 3.1f;
+      snprintf (b, sizeof (b), "GPRMC,%02d%02d%02d,%c,%s,%s,%05.1f,084.4,%02d%02d24,003.1,%c",
+                hh, mm, ss, (v.valid == NMEA_VALID) ? 'A' : 'V', lat, lon, v.speed_knt,
+                v.date.day, v.date.month, (k & 4) ? 'W' : 'E');
+      _add (b, NMEA_RMC, &v, _bad ());
+
+      memset ((void*)&v, 0, sizeof (v));
+      v.course_t = 54.7f; v.course_m = 34.4f;
+      v.speed_knt = 5.5f + k % 3; v.speed_kmh = v.speed_knt * 1.852f;
+      snprintf (b, sizeof (b), "GPVTG,054.7,T,034.4,M,%05.1f,N,%05.1f,K", v.speed_knt, v.speed_kmh);
+      v.speed_kmh = roundf (v.speed_kmh * 10) / 10;
+      _add (b, NMEA_VTG, &v, _bad ());
+
+      memset ((void*)&v, 0, sizeof (v));
+      v.time.hour = hh; v.time.min = mm; v.time.sec = ss;
+      v.day = 11; v.month = 3; v.year = 2024;
+      v.zone_h = -3; v.zone_m = 30;
+      snprintf (b, sizeof (b), "GPZDA,%02d%02d%02d.00,11,03,2024,-03,30", hh, mm, ss);
+      _add (b, NMEA_ZDA, &v, _bad ());
+
+      // Proprietary, counted but without cache and callback
+      memset ((void*)&v, 0, sizeof (v));
+      _add ("PGRME,15.0,M,45.0,M,25.0,M", NMEA_NULL, &v, _bad ());
+      _noise ();
+      #undef _bad
+   }
+}
+
+#define _feq(_a, _b)    (fabsf ((_a) - (_b)) < 1e-4f)
+#define _teq(_a, _b)    ((_a).hour == (_b).hour && (_a).min == (_b).min && _feq ((_a).sec, (_b).sec))
+
+/*
+ * The sentence data against the expected ones
+ */
+static int _same (nmea_msgid_en id, const void *msg, const nmea_common_t *v)
+{
+   switch (id) {
+      case NMEA_GGA: {
+         const nmea_gga_t *m = msg;
+         return m->fix == v->fix && m->sats == v->sats && _teq (m->time, v->time) &&
+                _feq (m->latitude, v->latitude) && _feq (m->longitude, v->longitude) &&
+                _feq (m->elevation, v->elevation);
+      }
+      case NMEA_GLL: {
+         const nmea_gll_t *m = msg;
+         return m->valid == v->valid && _teq (m->time, v->time) &&
+                _feq (m->latitude, v->latitude) && _feq (m->longitude, v->longitude);
+      }
+      case NMEA_GSA:
+         return 1;
+      case NMEA_GSV:
+         return ((const nmea_gsv_t *)msg)->sats == v->sats;
+      case NMEA_RMC: {
+         const nmea_rmc_t *m = msg;
+         return m->valid == v->valid && _teq (m->time, v->time) &&
+                m->date.day == v->date.day && m->date.month == v->date.month && m->date.year == v->date.year &&
+                _feq (m->latitude, v->latitude) && _feq (m->longitude, v->longitude) &&
+                _feq (m->speed_knt, v->speed_knt) && _feq (m->course_t, v->course_t) &&
+                _feq (m->mag_var, v->mag_var);
+      }
+      case NMEA_VTG: {
+         const nmea_vtg_t *m = msg;
+         return _feq (m->course_t, v->course_t) && _feq (m->course_m, v->course_m) &&
+                _feq (m->speed_knt, v->speed_knt) && _feq (m->speed_kmh, v->speed_kmh);
+      }
+      case NMEA_ZDA: {
+         const nmea_zda_t *m = msg;
+         return _teq (m->time, v->time) && m->day == v->day && m->month == v->month &&
+                m->year == v->year && m->zone_h == v->zone_h && m->zone_m == v->zone_m;
+      }
+      default:
+         return 0;
+   }
+}
+
+/*
+ * The callbacks come in the order of the log, skipping the proprietary
+ * sentences which have none
+ */
+static void _cb (nmea_t *n, nmea_msgid_en id, const void *msg)
+{
+   while (cb_i < ex_n && ex[cb_i].id == NMEA_NULL)
+      ++cb_i;
+   if (cb_i >= ex_n || ex[cb_i].id != id || !_same (id, msg, &ex[cb_i].v)) {
+      if (cb_err++ < 5)
+         printf ("callback %d: id %d, expected %d\n", cb_i, id, (cb_i < ex_n) ? (int)ex[cb_i].id : -1);
+   }
+   ++cb_i;
+   (void)n;
+}
+
+static byte_t _in (void) {
+   return (rd < lg_n) ? lg[rd++] : 0;
+}
+static int _out (byte_t c) {
+   return c;
+}
+
+static void _init (void)
+{
+   nmea_msgid_en id;
+
+   nmea_deinit (&nmea);
+   nmea_link_in (&nmea, _in);
+   nmea_link_out (&nmea, _out);
+   nmea_link_buffer (&nmea, NULL);         // Old API, no effect
+   nmea_set_buffer_size (&nmea, 0);
+   for (id=NMEA_GGA ; id<NMEA_MSGID_NUM ; ++id)
+      nmea_link_callback (&nmea, id, _cb);
+   nmea_init (&nmea);
+}
+
+/*
+ * The last valid sentence of each type against the cache
+ */
+static int _check_cache (void)
+{
+   static const nmea_msgid_en ids[] = { NMEA_GGA, NMEA_GLL, NMEA_GSA, NMEA_GSV, NMEA_RMC, NMEA_VTG, NMEA_ZDA };
+   const void *msg[NMEA_MSGID_NUM] = {
+      NULL, &nmea.cache.gga, &nmea.cache.gll, &nmea.cache.gsa, &nmea.cache.gsv,
+      &nmea.cache.rmc, &nmea.cache.vtg, &nmea.cache.zda
+   };
+   size_t i;
+   int k, err = 0;
+
+   for (i=0 ; i<sizeof (ids) / sizeof (ids[0]) ; ++i) {
+      for (k=ex_n-1 ; k>=0 && ex[k].id != ids[i] ; --k)
+         ;
+      if (k < 0 || !_same (ids[i], msg[ids[i]], &ex[k].v)) {
+         printf ("cache of id %d differs\n", ids[i]);
+         ++err;
+      }
+      if (!(nmea.cache.updated & (1UL << ids[i]))) {
+         printf ("id %d not marked as updated\n", ids[i]);
+         ++err;
+      }
+   }
+   return err;
+}
+
+/*
+ * The log in chunks of random size, up to max
+ */
+static int _check_feed (int max)
+{
+   int i, n, done = 0, err = 0;
+
+   _init ();
+   cb_i = cb_err = 0;
+   for (i=0 ; i<lg_n ; i+=n) {
+      n = 1 + rand () % max;
+      if (n > lg_n - i)
+         n = lg_n - i;
+      done += nmea_feed (&nmea, (const byte_t *)&lg[i], n);
+   }
+   while (cb_i < ex_n && ex[cb_i].id == NMEA_NULL)
+      ++cb_i;
+   err += (cb_err != 0 || cb_i != ex_n);
+   err += (done != ex_valid || (int)nmea.sentences != ex_valid);
+   if ((int)nmea.errors != ex_errors) {
+      printf ("chunks up to %d: %u errors, expected %d\n", max, nmea.errors, ex_errors);
+      ++err;
+   }
+   if (err)
+      printf ("chunks up to %d: %d/%d callbacks, %d wrong, %d/%d sentences\n",
+              max, cb_i, ex_n, cb_err, done, ex_valid);
+   err += _check_cache ();
+   return err;
+}
+
+/*
+ * nmea_read_xxx() pull the stream from the input link, until their sentence
+ * or an unread one in cache. The first RMC is not valid, so its read is busy.
+ */
+static int _check_read (void)
+{
+   nmea_rmc_t rmc;
+   nmea_zda_t zda;
+   drv_status_en st;
+   int k, err = 0;
+
+   _init ();
+   rd = cb_i = cb_err = 0;
+   for (k=0 ; ex[k].id != NMEA_RMC ; ++k)
+      ;
+   while (ex[k].id != NMEA_RMC || ex[k].v.valid != NMEA_VALID) {
+      if (ex[k].id == NMEA_RMC)
+         err += (nmea_read_rmc (&nmea, &rmc) != DRV_BUSY);
+      ++k;
+   }
+   st = nmea_read_rmc (&nmea, &rmc);
+   err += (st != DRV_READY || !_same (NMEA_RMC, &rmc, &ex[k].v));
+   // A ZDA is already unread in cache, the last one before that RMC
+   while (k > 0 && ex[k].id != NMEA_ZDA)
+      --k;
+   err += (nmea_read_zda (&nmea, &zda) != DRV_READY || !_same (NMEA_ZDA, &zda, &ex[k].v));
+   err += (cb_err != 0);
+   if (err)
+      printf ("nmea_read_xxx: %d errors\n", err);
+   return err;
+}
+
+static void _bench (void)
+{
+   int r, runs = BENCH_MB * 1000000 / lg_n + 1;
+   double t0, t;
+
+   _init ();
+   for (r=0 ; r<NMEA_MSGID_NUM ; ++r)
+      nmea.cb[r] = NULL;
+   t0 = _now ();
+   for (r=0 ; r<runs ; ++r)
+      nmea_feed (&nmea, (const byte_t *)lg, lg_n);
+   t = _now () - t0;
+   printf ("nmea_feed: %.0f sentences/s, %.1f MB/s\n", nmea.sentences / t, (double)lg_n * runs / t * 1e-6);
+}
+
+int main (void)
+{
+   static const int chunk[] = { 1, 3, 16, 82, 1024, LOG_SIZE };
+   size_t i;
+   int err = 0;
+
+   srand (1);
+   _build ();
+   printf ("log: %d bytes, %d valid sentences, %d bad\n", lg_n, ex_valid, ex_errors);
+   for (i=0 ; i<sizeof (chunk) / sizeof (chunk[0]) ; ++i)
+      err += _check_feed (chunk[i]);
+   err += _check_read ();
+   _bench ();
+   printf ("nmea: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
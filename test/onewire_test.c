@@ -0,0 +1,180 @@
+/*!
+ * \file onewire_test.c
+ * \brief
+ *    Host test of the 1-Wire enumeration on the UART driver and the 1-Wire
+ *    bus simulator. It checks the blocking and the non blocking enumeration
+ *    against the simulated devices, with the family filter, the alarm search,
+ *    the overdrive speed, a short table and an empty bus, and measures the
+ *    bus time of the enumeration and the longest non blocking call.
+ *
+ *    gcc -std=gnu11 -O2 -D__VALIST=__gnuc_va_list -I../inc onewire_test.c ../src/com/onewire.c ../src/com/onewire_uart.c ../src/drv/sim_ow.c ../src/algo/crc.c -o onewire_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2016 Choutouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <com/onewire.h>
+#include <com/onewire_uart.h>
+#include <drv/sim_ow.h>
+
+#define DEVS      (24)
+
+static sow_t      sow;
+static sow_dev_t  dev[DEVS];
+static ow_uart_t  owu;
+static ow_bus_t   bus;
+static ow_rom_t   tb[DEVS+1], tb_async[DEVS+1];
+
+static uint16_t _rw (uint8_t f)                     { return sow_uart_rw (&sow, f); }
+static drv_status_en _rwbuf (byte_t *f, int n)      { return sow_uart_rwbuf (&sow, f, n); }
+static drv_status_en _br (uint32_t br)              { return sow_uart_br (&sow, br); }
+
+/*
+ * The devices the search has to find
+ */
+static int _expected (byte_t cmd, byte_t family, uint32_t speed)
+{
+   int i, n = 0;
+
+   for (i=0 ; i<sow.n ; ++i) {
+      if (family != OW_FAMILY_ANY && dev[i].rom[0] != family)   continue;
+      if (cmd == OW_CMD_SEARCH_ALARM && !dev[i].alarm)           continue;
+      if (speed == OW_T_OVERDRIVE && !dev[i].od)                 continue;
+      ++n;
+   }
+   return n;
+}
+
+/*
+ * A found table has to be in ascending order and each ROM one of the
+ * expected devices
+ */
+static int _check_table (ow_rom_t *t, int n, byte_t cmd, byte_t family, uint32_t speed)
+{
+   int i, j, err = 0;
+
+   for (i=0 ; i<n ; ++i) {
+      if (i && ow_rom_cmp (t[i-1], t[i]) >= 0)
+         ++err;
+      for (j=0 ; j<DEVS && memcmp (t[i], dev[j].rom, OW_ROM_SIZE) ; ++j)
+         ;
+      if (j == DEVS
+         || (family != OW_FAMILY_ANY && dev[j].rom[0] != family)
+         || (cmd == OW_CMD_SEARCH_ALARM && !dev[j].alarm)
+         || (speed == OW_T_OVERDRIVE && !dev[j].od))
+         ++err;
+   }
+   return err;
+}
+
+/*
+ * The blocking and the non blocking enumeration of the same search. The
+ * async one returns pending once between each two devices.
+ */
+static int _check (byte_t cmd, byte_t family, uint32_t speed, int size)
+{
+   ow_enum_t      op;
+   drv_status_en  st;
+   int err = 0, n, calls, exp = _expected (cmd, family, speed);
+
+   if (exp > size)
+      exp = size;
+   n = ow_enumerate (&bus, cmd, family, speed, tb, size);
+   err += (n != exp);
+   err += _check_table (tb, n, cmd, family, speed);
+
+   memset ((void*)&op, 0, sizeof (op));
+   for (calls=1 ; (st = ow_enumerate_async (&bus, &op, cmd, family, speed, tb_async, size)) == PT_PENDING ; ++calls)
+      ;
+   err += (st != DRV_READY);
+   err += (op.n != n);
+   err += (n > 1 && calls != n);
+   err += (memcmp (tb, tb_async, n * OW_ROM_SIZE) != 0);
+   if (err)
+      printf ("cmd=%02X family=%02X speed=%u size=%d: found %d of %d, %d errors\n",
+              cmd, family, speed, size, n, exp, err);
+   return err;
+}
+
+/*
+ * The bus time of the enumeration, and the longest non blocking call
+ */
+static void _bench (void)
+{
+   ow_enum_t   op;
+   uint64_t    t0, t1, longest = 0;
+   int sp;
+
+   for (sp=OW_T_STANDARD ; sp<=OW_T_OVERDRIVE ; ++sp) {
+      t0 = sow.stat.time;
+      ow_enumerate (&bus, OW_CMD_SEARCH_ROM, OW_FAMILY_ANY, sp, tb, DEVS);
+      t1 = sow.stat.time;
+      printf ("enumerate %s: %8.2f ms bus time\n", (sp) ? "overdrive" : "standard ", (t1-t0) * 1e-6);
+   }
+   memset ((void*)&op, 0, sizeof (op));
+   do {
+      t0 = sow.stat.time;
+      if (ow_enumerate_async (&bus, &op, OW_CMD_SEARCH_ROM, OW_FAMILY_ANY, OW_T_STANDARD, tb, DEVS) != PT_PENDING)
+         break;
+      if (sow.stat.time - t0 > longest)
+         longest = sow.stat.time - t0;
+   } while (1);
+   printf ("async standard: longest call %.2f ms\n", longest * 1e-6);
+}
+
+int main (void)
+{
+   static const byte_t fam[] = { 0x28, 0x28, 0x28, 0x2D, 0x10, 0x3B };
+   int err = 0, i;
+
+   srand (1);
+   for (i=0 ; i<DEVS ; ++i) {
+      sow_make_rom (dev[i].rom, fam[i % sizeof (fam)], ((uint64_t)rand () << 16) ^ rand ());
+      dev[i].alarm = (i % 3 == 0);
+      dev[i].od = (i % 2 == 0);
+   }
+   sow_link_devices (&sow, dev, DEVS);
+   sow_init (&sow);
+   ow_uart_link_rw (&owu, _rw);
+   ow_uart_link_rwbuf (&owu, _rwbuf);
+   ow_uart_link_br (&owu, _br);
+   ow_uart_set_timing (&owu, OW_UART_T_STANDARD);
+   err += (ow_uart_init (&owu) != DRV_READY);
+
+   ow_link_ow (&bus, (void*)&owu);
+   ow_link_tx (&bus, (ow_tx_ft)ow_uart_tx);
+   ow_link_triplet (&bus, (ow_triplet_ft)ow_uart_triplet);
+   ow_link_ioctl (&bus, (ow_ioctl_ft)ow_uart_ioctl);
+
+   err += _check (OW_CMD_SEARCH_ROM, OW_FAMILY_ANY, OW_T_STANDARD, DEVS+1);
+   err += _check (OW_CMD_SEARCH_ROM, 0x28, OW_T_STANDARD, DEVS+1);
+   err += _check (OW_CMD_SEARCH_ROM, 0x3B, OW_T_STANDARD, DEVS+1);
+   err += _check (OW_CMD_SEARCH_ROM, 0x01, OW_T_STANDARD, DEVS+1);   // No such family
+   err += _check (OW_CMD_SEARCH_ALARM, OW_FAMILY_ANY, OW_T_STANDARD, DEVS+1);
+   err += _check (OW_CMD_SEARCH_ROM, OW_FAMILY_ANY, OW_T_OVERDRIVE, DEVS+1);
+   err += _check (OW_CMD_SEARCH_ROM, OW_FAMILY_ANY, OW_T_STANDARD, 5);
+   _bench ();
+
+   sow_link_devices (&sow, dev, 0);                                  // Empty bus
+   err += _check (OW_CMD_SEARCH_ROM, OW_FAMILY_ANY, OW_T_STANDARD, DEVS+1);
+   err += _check (OW_CMD_SEARCH_ROM, OW_FAMILY_ANY, OW_T_OVERDRIVE, DEVS+1);
+
+   printf ("onewire: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,332 @@
+/*!
+ * \file overlap_test.c
+ * \brief
+ *    Host demo of the non blocking driver calls. The same workload runs
+ *    on a NOR flash (s25fs_spi on sim_nor), an I2C EEPROM (ee_i2c on
+ *    sim_i2c_ee) and an SD card (sd_spi on sim_sd), all on one shared
+ *    simulated clock. First the blocking calls run one device after the
+ *    other. Then three scheduler tasks run the async calls, so the busy
+ *    time of each device overlaps the bus traffic of the others. It
+ *    prints the simulated time of both runs and checks the written data.
+ *
+ *    gcc -std=gnu11 -O2 -D__VALIST=__gnuc_va_list -I../inc overlap_test.c ../src/drv/s25fs_spi.c ../src/drv/ee_i2c.c ../src/drv/sd_spi.c ../src/drv/sim_nor.c ../src/drv/sim_i2c_ee.c ../src/drv/sim_sd.c ../src/drv/sim_tim.c ../src/sys/jiffies.c ../src/sys/sched.c ../src/com/spi_bb.c -o overlap_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <drv/s25fs_spi.h>
+#include <drv/ee_i2c.h>
+#include <drv/sd_spi.h>
+#include <drv/sim_nor.h>
+#include <drv/sim_i2c_ee.h>
+#include <drv/sim_sd.h>
+#include <drv/sim_tim.h>
+#include <sys/jiffies.h>
+#include <sys/sched.h>
+
+#define TIM_FREQ     (1000000)   // Jiffy timer, a busy wait read is 1 usec
+
+/*
+ * The workload of each run
+ */
+#define NOR_ERASES   (2)         // 64 KB sector erases
+#define NOR_PAGES    (256)       // 256 byte page programs
+#define EE_PAGES     (64)        // 64 byte page writes
+#define SD_BLOCKS    (256)       // Single block writes
+
+#define NOR_SECTOR   (SNOR_SECTOR_SZ_DEF)
+#define NOR_PAGE     (SNOR_PAGE_SZ_DEF)
+#define EE_PAGE      (64)
+#define NOR_SIZE     (2 * NOR_ERASES * NOR_SECTOR)
+#define EE_SIZE      (32768)
+#define SD_SECTORS   (2 * SD_BLOCKS)
+
+static uint64_t   clk;        // Shared simulated clock in nsec
+
+static snor_t     snor;
+static sie_t      sie;
+static simsd_t    card;
+static s25fs_t    nor;
+static ee_t       ee;
+
+static byte_t     nor_mem[NOR_SIZE];
+static byte_t     ee_mem[EE_SIZE];
+static byte_t     sd_mem[SD_SECTORS * SIMSD_BLOCK_SZ];
+
+static byte_t     nor_dat[NOR_PAGES * NOR_PAGE];
+static byte_t     ee_dat[EE_PAGES * EE_PAGE];
+static byte_t     sd_dat[SD_BLOCKS * SIMSD_BLOCK_SZ];
+
+/*!
+ * A device task, the protothread state of one device's workload
+ */
+typedef struct {
+   pt_t           pt;
+   int            i;          /*!< The current erase, page or block */
+   uint32_t       base;       /*!< Device address of the run */
+   drv_status_en  st;         /*!< Status of the last operation */
+   union {
+      s25fs_op_t  nor;
+      ee_op_t     ee;
+      sd_op_t     sd;
+   }op;
+}job_t;
+
+static void _nor_cs (uint8_t en) { snor_spi_cs (&snor, en); }
+static void _sd_cs (uint8_t en) { simsd_spi_cs (&card, en); }
+
+/*
+ * The time base of the SD driver, as a timer interrupt does
+ */
+static void _tick (int sig) {
+   (void)sig;
+   sd_service ();
+}
+
+static void _fill (byte_t *b, size_t n) {
+   for (size_t i=0 ; i<n ; ++i)
+      b[i] = (byte_t)rand ();
+}
+
+static int _init (void)
+{
+   int err = 0;
+
+   sim_tim_link_clock (&clk);
+   sim_tim_set_step (1);
+   jf_link_setfreq ((jf_setfreq_pt)sim_tim_setfreq);
+   jf_link_read ((jf_read_pt)sim_tim_read);
+   err += (jf_init (TIM_FREQ, 0xFFFF) != DRV_READY);
+
+   memset ((void*)nor_mem, 0xFF, sizeof (nor_mem));
+   snor_link_mem (&snor, nor_mem, sizeof (nor_mem));
+   snor_link_clock (&snor, &clk);
+   snor_init (&snor);
+   s25fs_deinit (&nor);
+   s25fs_link_cs (&nor, _nor_cs);
+   s25fs_link_spi (&nor, (void*)&snor);
+   s25fs_link_spi_read (&nor, (s25fs_spi_rw_t)snor_spi_read);
+   s25fs_link_spi_write (&nor, (s25fs_spi_rw_t)snor_spi_write);
+   err += (s25fs_init (&nor) != DRV_READY);
+
+   memset ((void*)ee_mem, 0xFF, sizeof (ee_mem));
+   sie_link_mem (&sie, ee_mem, sizeof (ee_mem));
+   sie_link_clock (&sie, &clk);
+   sie_set_page_size (&sie, EE_PAGE);
+   sie_init (&sie);
+   ee_deinit (&ee);
+   ee_link_i2c (&ee, (void*)&sie);
+   ee_link_i2c_rx (&ee, (drv_i2c_rx_ft)sie_i2c_rx);
+   ee_link_i2c_tx (&ee, (drv_i2c_tx_ft)sie_i2c_tx);
+   ee_link_i2c_ioctl (&ee, (drv_i2c_ioctl_ft)sie_i2c_ioctl);
+   ee_set_hwaddress (&ee, SIE_HWADDR_DEF);
+   ee_set_size (&ee, EE_256);
+   ee_set_page_size (&ee, EE_PAGE);
+   ee_set_timeout (&ee, 1000);
+   err += (ee_init (&ee) != DRV_READY);
+
+   simsd_link_mem (&card, sd_mem, sizeof (sd_mem));
+   simsd_link_clock (&card, &clk);
+   simsd_init (&card);
+   sd_link_cs (0, _sd_cs);
+   sd_link_spi (0, (void*)&card);
+   sd_link_spi_ioctl (0, (spi_ioctl_t)simsd_spi_ioctl);
+   sd_link_spi_rw (0, (spi_rw_t)simsd_spi_rw);
+   sd_link_spi_rw_block (0, (spi_rw_block_t)simsd_spi_rw_block);
+   err += (sd_init (0) != DRV_READY);
+   return err;
+}
+
+/*
+ * Wait the last write of each device with a blocking read, so both runs
+ * end with idle devices.
+ */
+static int _drain (int run)
+{
+   byte_t b[SIMSD_BLOCK_SZ];
+   int err = 0;
+
+   err += (s25fs_read (&nor, run * NOR_ERASES * NOR_SECTOR, b, 1) != DRV_READY);
+   err += (ee_read (&ee, run * EE_PAGES * EE_PAGE, b, 1) != DRV_READY);
+   err += (sd_read (0, run * SD_BLOCKS, b, 1) != DRV_READY);
+   return err;
+}
+
+/*
+ * The written data of a run against the sources
+ */
+static int _check (int run)
+{
+   int err = 0;
+
+   err += (memcmp (&nor_mem[run * NOR_ERASES * NOR_SECTOR], nor_dat, sizeof (nor_dat)) != 0);
+   err += (memcmp (&ee_mem[run * EE_PAGES * EE_PAGE], ee_dat, sizeof (ee_dat)) != 0);
+   err += (memcmp (&sd_mem[run * SD_BLOCKS * SIMSD_BLOCK_SZ], sd_dat, sizeof (sd_dat)) != 0);
+   if (err)
+      printf ("%s run: %d devices with wrong data\n", (run) ? "async" : "blocking", err);
+   return err;
+}
+
+/*
+ * The blocking calls, one device after the other
+ */
+static int _run_blocking (void)
+{
+   uint64_t t0 = clk, t;
+   int err = 0, i;
+
+   for (i=0 ; i<NOR_ERASES ; ++i)
+      err += (s25fs_erase (&nor, i * NOR_SECTOR) != DRV_READY);
+   for (i=0 ; i<NOR_PAGES ; ++i)
+      err += (s25fs_write (&nor, i * NOR_PAGE, &nor_dat[i * NOR_PAGE], NOR_PAGE) != DRV_READY);
+   printf ("  flash      %8.1f ms\n", (clk - t0) * 1e-6);
+
+   t = clk;
+   for (i=0 ; i<EE_PAGES ; ++i)
+      err += (ee_write (&ee, i * EE_PAGE, &ee_dat[i * EE_PAGE], EE_PAGE) != DRV_READY);
+   printf ("  eeprom     %8.1f ms\n", (clk - t) * 1e-6);
+
+   t = clk;
+   for (i=0 ; i<SD_BLOCKS ; ++i)
+      err += (sd_write (0, i, &sd_dat[i * SIMSD_BLOCK_SZ], 1) != DRV_READY);
+   printf ("  sd         %8.1f ms\n", (clk - t) * 1e-6);
+
+   err += _drain (0);
+   printf ("blocking     %8.1f ms\n", (clk - t0) * 1e-6);
+   if (err)
+      printf ("blocking run: %d errors\n", err);
+   return err + _check (0);
+}
+
+static drv_status_en _nor_task (void *arg)
+{
+   job_t *j = (job_t*)arg;
+
+   PT_BEGIN (&j->pt);
+   for (j->i=0 ; j->i<NOR_ERASES ; ++j->i) {
+      memset ((void*)&j->op, 0, sizeof (j->op));
+      PT_CALL (&j->pt, j->st, s25fs_erase_async (&nor, &j->op.nor, j->base + j->i * NOR_SECTOR));
+      if (j->st != DRV_READY)
+         PT_EXIT (&j->pt, DRV_ERROR);
+   }
+   for (j->i=0 ; j->i<NOR_PAGES ; ++j->i) {
+      memset ((void*)&j->op, 0, sizeof (j->op));
+      PT_CALL (&j->pt, j->st, s25fs_write_async (&nor, &j->op.nor, j->base + j->i * NOR_PAGE,
+                                                 &nor_dat[j->i * NOR_PAGE], NOR_PAGE));
+      if (j->st != DRV_READY)
+         PT_EXIT (&j->pt, DRV_ERROR);
+   }
+   PT_END (&j->pt);
+}
+
+static drv_status_en _ee_task (void *arg)
+{
+   job_t *j = (job_t*)arg;
+
+   PT_BEGIN (&j->pt);
+   for (j->i=0 ; j->i<EE_PAGES ; ++j->i) {
+      memset ((void*)&j->op, 0, sizeof (j->op));
+      PT_CALL (&j->pt, j->st, ee_write_async (&ee, &j->op.ee, j->base + j->i * EE_PAGE,
+                                              &ee_dat[j->i * EE_PAGE], EE_PAGE));
+      if (j->st != DRV_READY)
+         PT_EXIT (&j->pt, DRV_ERROR);
+   }
+   PT_END (&j->pt);
+}
+
+static drv_status_en _sd_task (void *arg)
+{
+   job_t *j = (job_t*)arg;
+
+   PT_BEGIN (&j->pt);
+   for (j->i=0 ; j->i<SD_BLOCKS ; ++j->i) {
+      memset ((void*)&j->op, 0, sizeof (j->op));
+      PT_CALL (&j->pt, j->st, sd_write_async (0, &j->op.sd, j->base + j->i,
+                                              &sd_dat[j->i * SIMSD_BLOCK_SZ], 1));
+      if (j->st != DRV_READY)
+         PT_EXIT (&j->pt, DRV_ERROR);
+   }
+   PT_END (&j->pt);
+}
+
+/*
+ * Three tasks with the async calls, the same workload to the second
+ * half of each device
+ */
+static int _run_async (void)
+{
+   sched_t        s;
+   sched_task_t   t[3];
+   job_t          j[3];
+   uint64_t       t0 = clk;
+   int err = 0, i;
+
+   memset ((void*)j, 0, sizeof (j));
+   j[0].base = NOR_ERASES * NOR_SECTOR;
+   j[1].base = EE_PAGES * EE_PAGE;
+   j[2].base = SD_BLOCKS;
+   sched_init (&s);
+   sched_add (&s, &t[0], _nor_task, &j[0]);
+   sched_add (&s, &t[1], _ee_task, &j[1]);
+   sched_add (&s, &t[2], _sd_task, &j[2]);
+   sched_run (&s);
+   for (i=0 ; i<3 ; ++i)
+      err += (t[i].status != DRV_READY);
+
+   err += _drain (1);
+   printf ("async        %8.1f ms, %llu task calls\n", (clk - t0) * 1e-6, (unsigned long long)s.runs);
+   if (err)
+      printf ("async run: %d errors\n", err);
+   return err + _check (1);
+}
+
+int main (void)
+{
+   struct itimerval it = { {0, 1000}, {0, 1000} };
+   uint64_t t_sync, t_async;
+   int err = 0;
+
+   srand (1);
+   _fill (nor_dat, sizeof (nor_dat));
+   _fill (ee_dat, sizeof (ee_dat));
+   _fill (sd_dat, sizeof (sd_dat));
+   _fill (sd_mem, sizeof (sd_mem));
+   signal (SIGALRM, _tick);
+   setitimer (ITIMER_REAL, &it, NULL);
+
+   if ((err = _init ()) != 0)
+      printf ("init: %d errors\n", err);
+   else {
+      printf ("%d flash erases + %d page programs, %d eeprom page writes, %d sd block writes\n",
+              NOR_ERASES, NOR_PAGES, EE_PAGES, SD_BLOCKS);
+      t_sync = clk;
+      err += _run_blocking ();
+      t_sync = clk - t_sync;
+      t_async = clk;
+      err += _run_async ();
+      t_async = clk - t_async;
+      printf ("gain         %8.2fx\n", (double)t_sync / t_async);
+      err += (t_async >= t_sync);
+   }
+   printf ("overlap: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
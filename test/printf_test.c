@@ -0,0 +1,236 @@
+/*!
+ * \file printf_test.c
+ * \brief
+ *    Host test of the buffered printf sink. It checks that vxprintf(),
+ *    vsnxprintf() and the per character vsxprintf() produce the same log
+ *    lines as the host's snprintf(), that vsnxprintf() truncates and counts
+ *    right, and that _write_fil() and _putc_fil() through vsxprintf() write
+ *    the same file. Then it measures the formatted log throughput of the
+ *    buffered sinks against the per character path.
+ *
+ *    gcc -std=gnu11 -O2 -DPRINTF_FILES -D__VALIST=va_list -I../inc printf_test.c ../src/std/_vsxprintf.c ../src/std/_base_io.c ../src/std/dtoa.c -lm -o printf_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std/_vsxprintf.h>
+#include "bench.h"
+
+#define LINES     (200000)    // Log lines of the timing
+#define OUT_SIZE  (1024)
+
+static const char *lvl[] = { "DBG", "INF", "WRN", "ERR" };
+static const char *mod[] = { "adc", "spi_flash", "nmea", "ctrl_loop", "" };
+
+static char    out[OUT_SIZE], ref[OUT_SIZE];
+static int     out_n;
+static size_t  dev_n;      // Characters the device got
+
+/*
+ * The user's device. It only counts, as a UART driver would move the
+ * character out.
+ */
+int __putchar (char c) {
+   dev_n += (c != 0);
+   return c;
+}
+
+/*
+ * Write callback to memory
+ */
+static int _write_mem (void *ctx, const char *src, int n)
+{
+   (void)ctx;
+   memcpy ((void*)&out[out_n], (const void*)src, n);
+   out_n += n;
+   return n;
+}
+
+/*
+ * Per character callbacks, the path of the old engine
+ */
+static int _putc_mem (char *dst, const char c) {
+   (void)dst;
+   out[out_n++] = c;
+   return 1;
+}
+static int _putc_dev (char *dst, const char c) {
+   (void)dst;
+   return __putchar (c);
+}
+#if defined (PRINTF_FILES)
+static FILE *_fp;
+static int _putc_file (char *dst, const char c) {
+   (void)dst;
+   return (fputc (c, _fp) == EOF) ? 0 : 1;
+}
+#endif
+
+static int _xprintf (_io_write_t w, void *ctx, const char *frm, ...)
+{
+   va_list ap;
+   int r;
+   va_start (ap, frm);
+   r = vxprintf (w, ctx, frm, ap);
+   va_end (ap);
+   return r;
+}
+
+static int _sxprintf (_putc_out_t o, char *dst, const char *frm, ...)
+{
+   va_list ap;
+   int r;
+   va_start (ap, frm);
+   r = vsxprintf (o, dst, (char *)frm, ap);
+   va_end (ap);
+   return r;
+}
+
+static int _snxprintf (char *dst, size_t size, const char *frm, ...)
+{
+   va_list ap;
+   int r;
+   va_start (ap, frm);
+   r = vsnxprintf (dst, size, frm, ap);
+   va_end (ap);
+   return r;
+}
+
+#define LOG_FRM   "[%10u.%03u] %s %-10s ch=%2d raw=0x%08x v=%8.3f %s\n"
+#define LOG_ARGS(_i)                                        \
+   (unsigned)(_i)/1000, (unsigned)(_i)%1000, lvl[(_i)%4],   \
+   mod[(_i)%5], (int)((_i)%17) - 8, (unsigned)(_i)*2654435761u, \
+   ((double)(_i) - 5000) / 7.0, ((_i)%3) ? "ok" : "timeout on the second retry"
+
+static int _check_line (uint32_t i)
+{
+   int n, r, err = 0;
+
+   n = snprintf (ref, sizeof (ref), LOG_FRM, LOG_ARGS (i));
+
+   out_n = 0;
+   r = _xprintf (_write_mem, 0, LOG_FRM, LOG_ARGS (i));
+   out[out_n] = 0;
+   err += (r != n || out_n != n || strcmp (out, ref) != 0);
+
+   out_n = 0;
+   r = _sxprintf (_putc_mem, 0, LOG_FRM, LOG_ARGS (i));
+   out[out_n] = 0;
+   err += (r != n || out_n != n || strcmp (out, ref) != 0);
+
+   r = _snxprintf (out, sizeof (out), LOG_FRM, LOG_ARGS (i));
+   err += (r != n || strcmp (out, ref) != 0);
+
+   // Truncation, the return value is the full size
+   r = _snxprintf (out, 17, LOG_FRM, LOG_ARGS (i));
+   err += (r != n || strlen (out) != 16 || strncmp (out, ref, 16) != 0);
+   err += (_snxprintf (NULL, 0, LOG_FRM, LOG_ARGS (i)) != n);
+
+   if (err)
+      printf ("line %u: got \"%s\", expected \"%s\"\n", i, out, ref);
+   return err != 0;
+}
+
+#if defined (PRINTF_FILES)
+/*
+ * The buffered and the per character file back ends write the same file
+ */
+static int _check_files (void)
+{
+   FILE *fb = tmpfile (), *fc = tmpfile ();
+   char lb[OUT_SIZE], lc[OUT_SIZE];
+   uint32_t i;
+   int err = 0;
+
+   if (!fb || !fc) {
+      printf ("tmpfile failed\n");
+      return 1;
+   }
+   for (i=0 ; i<1000 ; ++i) {
+      _xprintf (_write_fil, fb, LOG_FRM, LOG_ARGS (i*37));
+      _sxprintf (_putc_fil, (char *)fc, LOG_FRM, LOG_ARGS (i*37));
+   }
+   rewind (fb);
+   rewind (fc);
+   for (i=0 ; fgets (lb, sizeof (lb), fb) ; ++i) {
+      snprintf (ref, sizeof (ref), LOG_FRM, LOG_ARGS (i*37));
+      err += (fgets (lc, sizeof (lc), fc) == NULL || strcmp (lb, lc) != 0 || strcmp (lb, ref) != 0);
+   }
+   err += (i != 1000 || fgets (lc, sizeof (lc), fc) != NULL);
+   fclose (fb);
+   fclose (fc);
+   if (err)
+      printf ("_write_fil/_putc_fil: %d lines differ\n", err);
+   return err;
+}
+#endif
+
+/*
+ * Log lines per second and MB/s of each path
+ */
+static void _bench (void)
+{
+   char buf[OUT_SIZE];
+   uint32_t i;
+   double t0, t;
+   size_t bytes;
+#if defined (PRINTF_FILES)
+   FILE *fp = _fp = fopen ("/dev/null", "w");
+#endif
+
+   printf ("%-28s %12s %10s\n", "", "lines/s", "MB/s");
+#define _run(_name, _call)   {                                   \
+   bytes = 0;                                                     \
+   t0 = _now ();                                                  \
+   for (i=0 ; i<LINES ; ++i)                                      \
+      bytes += _call;                                             \
+   t = _now () - t0;                                              \
+   printf ("%-28s %12.0f %10.2f\n", _name, LINES / t, bytes / t * 1e-6); \
+}
+   _run ("device, per char callback", _sxprintf (_putc_dev, 0, LOG_FRM, LOG_ARGS (i)));
+   _run ("device, _write_usr sink",   _xprintf (_write_usr, 0, LOG_FRM, LOG_ARGS (i)));
+   _run ("string, vsnxprintf",        _snxprintf (buf, sizeof (buf), LOG_FRM, LOG_ARGS (i)));
+   _run ("string, host snprintf",     snprintf (buf, sizeof (buf), LOG_FRM, LOG_ARGS (i)));
+#if defined (PRINTF_FILES)
+   if (fp) {
+      _run ("file, fputc per char",      _sxprintf (_putc_file, 0, LOG_FRM, LOG_ARGS (i)));
+      _run ("file, _write_fil sink",     _xprintf (_write_fil, fp, LOG_FRM, LOG_ARGS (i)));
+      _run ("file, host fprintf",        fprintf (fp, LOG_FRM, LOG_ARGS (i)));
+      fclose (fp);
+   }
+#endif
+#undef _run
+}
+
+int main (void)
+{
+   uint32_t i;
+   int err = 0;
+
+   for (i=0 ; i<20000 ; ++i)
+      err += _check_line (i*7919);
+#if defined (PRINTF_FILES)
+   err += _check_files ();
+#endif
+   _bench ();
+   printf ("printf: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,395 @@
+/*!
+ * \file ring_test.c
+ * \brief
+ *    Host test of the lock-free rings. Producer and consumer threads move
+ *    sequence numbered items through a small SPSC ring (1P/1C) and MPMC ring
+ *    (NP/NC), mixing the single, the batch and the reserve/commit calls. The
+ *    consumers check the order and the count of every producer's items.
+ *    Each ring also starts near the 2^32 wrap of its indexes. The test
+ *    reports the throughput and the put to get latency.
+ *
+ *    gcc -std=gnu11 -O2 -pthread -I../inc ring_test.c ../src/algo/ring.c -o ring_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos <houtouridis.ch@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <algo/ring.h>
+#include "bench.h"
+
+#define ITEMS     (64)        // Ring capacity, small to wrap often
+#define COUNT     (2000000)   // Items per producer
+#define BATCH     (11)        // Largest batch, not a divisor of ITEMS
+#define MAXTH     (4)         // Largest number of producers/consumers
+#define WRAP      (0xFFFFFF00u)  // Start index, near the 32 bit wrap
+
+/*!
+ * The item. The check word catches torn copies.
+ */
+typedef struct {
+   uint32_t    prod;    //!< Producer id
+   uint32_t    seq;     //!< Producer's sequence number
+   uint64_t    stamp;   //!< Put time in ns
+   uint32_t    check;   //!< ~seq
+}item_t;
+
+/*!
+ * The result of a consumer
+ */
+typedef struct {
+   uint32_t    got;              //!< Items received
+   uint32_t    last[MAXTH];      //!< Last sequence + 1 of each producer
+   uint32_t    err;              //!< Order/content errors
+   unsigned int seed;            //!< Random batch sizes
+   uint64_t    lat_sum, lat_max; //!< Latency in ns
+}cons_t;
+
+static ring_spsc_t   spsc;
+static ring_mpmc_t   mpmc;
+static item_t        spsc_buf[ITEMS];
+static uint64_t      mpmc_buf[RING_MPMC_BUFFER_SIZE (ITEMS, sizeof (item_t)) / 8];
+static int           producers, consumers;
+static _Atomic uint32_t done;    // Finished producers
+static _Atomic uint8_t  seen[MAXTH][COUNT];  // Times each item was received
+
+static void _make (item_t *it, uint32_t prod, uint32_t seq) {
+   it->prod = prod;
+   it->seq = seq;
+   it->check = ~seq;
+   it->stamp = _ns ();
+}
+
+/*
+ * Check an item against the producer's last sequence. A single consumer
+ * gets every item of a producer, more consumers each get an increasing part.
+ */
+static void _take (cons_t *c, const item_t *it)
+{
+   uint64_t l = _ns () - it->stamp;
+
+   if (it->prod >= (uint32_t)producers || it->seq >= COUNT || it->check != ~it->seq ||
+       it->seq < c->last[it->prod] || (consumers == 1 && it->seq != c->last[it->prod]))
+      ++c->err;
+   else {
+      c->last[it->prod] = it->seq + 1;
+      atomic_fetch_add_explicit (&seen[it->prod][it->seq], 1, memory_order_relaxed);
+   }
+   ++c->got;
+   c->lat_sum += l;
+   if (l > c->lat_max)  c->lat_max = l;
+}
+
+/*
+ * ========= SPSC =========
+ */
+static void* _spsc_prod (void *arg)
+{
+   item_t b[BATCH], *p;
+   uint32_t seq = 0, n, k, i;
+   unsigned int seed = 1;
+
+   tbx_unused (arg);
+   while (seq < COUNT) {
+      n = 1 + rand_r (&seed) % BATCH;
+      if (n > COUNT - seq)
+         n = COUNT - seq;
+      switch (rand_r (&seed) % 3) {
+         case 0:
+            _make (b, 0, seq);
+            k = ring_spsc_put (&spsc, b);
+            break;
+         case 1:
+            for (i=0 ; i<n ; ++i)
+               _make (&b[i], 0, seq+i);
+            k = ring_spsc_put_n (&spsc, b, n);
+            break;
+         default:
+            k = n;
+            if ((p = ring_spsc_reserve (&spsc, &k)) != NULL) {
+               for (i=0 ; i<k ; ++i)
+                  _make (&p[i], 0, seq+i);
+               ring_spsc_commit (&spsc, k);
+            }
+            else
+               k = 0;
+            break;
+      }
+      if (k == 0)
+         sched_yield ();
+      seq += k;
+   }
+   atomic_fetch_add (&done, 1);
+   return NULL;
+}
+
+static void* _spsc_cons (void *arg)
+{
+   cons_t *c = (cons_t*)arg;
+   item_t b[BATCH], *p;
+   uint32_t n, k, i;
+   unsigned int seed = c->seed;
+
+   while (c->got < COUNT) {
+      n = 1 + rand_r (&seed) % BATCH;
+      switch (rand_r (&seed) % 3) {
+         case 0:
+            if ((k = ring_spsc_get (&spsc, b)) != 0)
+               _take (c, b);
+            break;
+         case 1:
+            k = ring_spsc_get_n (&spsc, b, n);
+            for (i=0 ; i<k ; ++i)
+               _take (c, &b[i]);
+            break;
+         default:
+            k = n;
+            if ((p = ring_spsc_peek (&spsc, &k)) != NULL) {
+               for (i=0 ; i<k ; ++i)
+                  _take (c, &p[i]);
+               ring_spsc_release (&spsc, k);
+            }
+            else
+               k = 0;
+            break;
+      }
+      if (k == 0)
+         sched_yield ();
+   }
+   return NULL;
+}
+
+/*
+ * ========= MPMC =========
+ */
+static void* _mpmc_prod (void *arg)
+{
+   uint32_t prod = (uint32_t)(uintptr_t)arg;
+   item_t b[BATCH], *p;
+   uint32_t seq = 0, n, k, i;
+   unsigned int seed = 10 + prod;
+
+   while (seq < COUNT) {
+      n = 1 + rand_r (&seed) % BATCH;
+      if (n > COUNT - seq)
+         n = COUNT - seq;
+      switch (rand_r (&seed) % 3) {
+         case 0:
+            _make (b, prod, seq);
+            k = ring_mpmc_put (&mpmc, b);
+            break;
+         case 1:
+            for (i=0 ; i<n ; ++i)
+               _make (&b[i], prod, seq+i);
+            k = ring_mpmc_put_n (&mpmc, b, n);
+            break;
+         default:
+            if ((p = ring_mpmc_reserve (&mpmc)) != NULL) {
+               _make (p, prod, seq);
+               ring_mpmc_commit (&mpmc, p);
+               k = 1;
+            }
+            else
+               k = 0;
+            break;
+      }
+      if (k == 0)
+         sched_yield ();
+      seq += k;
+   }
+   atomic_fetch_add (&done, 1);
+   return NULL;
+}
+
+static void* _mpmc_cons (void *arg)
+{
+   cons_t *c = (cons_t*)arg;
+   item_t b[BATCH], *p;
+   uint32_t n, k, i;
+   unsigned int seed = c->seed;
+
+   for ( ; ; ) {
+      n = 1 + rand_r (&seed) % BATCH;
+      switch (rand_r (&seed) % 3) {
+         case 0:
+            if ((k = ring_mpmc_get (&mpmc, b)) != 0)
+               _take (c, b);
+            break;
+         case 1:
+            k = ring_mpmc_get_n (&mpmc, b, n);
+            for (i=0 ; i<k ; ++i)
+               _take (c, &b[i]);
+            break;
+         default:
+            if ((p = ring_mpmc_peek (&mpmc)) != NULL) {
+               _take (c, p);
+               ring_mpmc_release (&mpmc, p);
+               k = 1;
+            }
+            else
+               k = 0;
+            break;
+      }
+      if (k == 0) {
+         // The ring drains before the last producer finishes or after
+         if (atomic_load (&done) == (uint32_t)producers && ring_mpmc_waiting (&mpmc) == 0)
+            break;
+         sched_yield ();
+      }
+   }
+   return NULL;
+}
+
+/*
+ * Move the MPMC ring's indexes to pos. Same as ring_mpmc_init() with the
+ * cells numbered from pos.
+ */
+static void _mpmc_start (uint32_t pos)
+{
+   uint32_t i, stride = RING_MPMC_STRIDE (sizeof (item_t));
+
+   for (i=0 ; i<ITEMS ; ++i)
+      atomic_store ((_Atomic uint32_t*)((byte_t*)mpmc_buf + ((pos+i) & (ITEMS-1)) * stride), pos+i);
+   atomic_store (&mpmc.tail, pos);
+   atomic_store (&mpmc.head, pos);
+}
+
+/*
+ * Run np producers and nc consumers and check that every consumer saw
+ * each producer's items in order, and all the items arrived once.
+ */
+static int _run (const char *name, int np, int nc, void* (*prod)(void*), void* (*cons)(void*))
+{
+   pthread_t pt[MAXTH], ct[MAXTH];
+   cons_t c[MAXTH] = {{0}};
+   uint64_t got = 0, err = 0, lat = 0, lmax = 0, t0;
+   double t;
+   int i, j, k;
+
+   producers = np;
+   consumers = nc;
+   atomic_store (&done, 0);
+   memset ((void*)seen, 0, sizeof (seen));
+   t0 = _ns ();
+   for (i=0 ; i<nc ; ++i) {
+      c[i].seed = 100 + i;
+      pthread_create (&ct[i], NULL, cons, &c[i]);
+   }
+   for (i=0 ; i<np ; ++i)
+      pthread_create (&pt[i], NULL, prod, (void*)(uintptr_t)i);
+   for (i=0 ; i<np ; ++i)
+      pthread_join (pt[i], NULL);
+   for (i=0 ; i<nc ; ++i)
+      pthread_join (ct[i], NULL);
+   t = (_ns () - t0) * 1e-9;
+
+   for (i=0 ; i<nc ; ++i) {
+      got += c[i].got;
+      err += c[i].err;
+      lat += c[i].lat_sum;
+      if (c[i].lat_max > lmax)  lmax = c[i].lat_max;
+   }
+   // Every item exactly once
+   for (j=0 ; j<np ; ++j)
+      for (k=0 ; k<COUNT ; ++k)
+         err += (atomic_load_explicit (&seen[j][k], memory_order_relaxed) != 1);
+   err += (got != (uint64_t)np * COUNT);
+   printf ("%-14s %9.2f Mitems/s, latency mean %7.2f us, max %8.1f us%s\n", name,
+           got / t * 1e-6, (got) ? lat / (double)got * 1e-3 : 0, lmax * 1e-3,
+           (err) ? "  FAIL" : "");
+   if (err)
+      printf ("%s: %u errors, %u of %u items\n", name, (unsigned)err, (unsigned)got, np * COUNT);
+   return (err) ? 1 : 0;
+}
+
+/*
+ * The ring state at the edges, single threaded
+ */
+static int _check_edges (void)
+{
+   item_t b[ITEMS+1], *p;
+   uint32_t n;
+   int err = 0;
+
+   err += (ring_spsc_init (&spsc, spsc_buf, 48, sizeof (item_t)) != 0);    // Not a power of 2
+   err += (ring_mpmc_init (&mpmc, mpmc_buf, 1, sizeof (item_t)) != 0);     // Less than 2
+   ring_spsc_init (&spsc, spsc_buf, ITEMS, sizeof (item_t));
+   ring_mpmc_init (&mpmc, mpmc_buf, ITEMS, sizeof (item_t));
+
+   err += (ring_spsc_put_n (&spsc, b, 0) != 0);
+   err += (ring_mpmc_put_n (&mpmc, b, 0) != 0);
+   err += (ring_mpmc_get_n (&mpmc, b, 0) != 0);
+   err += (ring_spsc_put_n (&spsc, b, ITEMS+1) != ITEMS);
+   err += (ring_spsc_is_full (&spsc) != 1);
+   err += (ring_spsc_put (&spsc, b) != 0);
+   n = 0;
+   err += (ring_spsc_reserve (&spsc, &n) != NULL);
+   err += (ring_spsc_get_n (&spsc, b, ITEMS-3) != ITEMS-3);
+   // 3 items at the end of the buffer, the reservation stops at the end
+   n = 0;
+   err += ((p = ring_spsc_reserve (&spsc, &n)) != &spsc_buf[0] || n != ITEMS-3);
+   n = 0;
+   err += ((p = ring_spsc_peek (&spsc, &n)) != &spsc_buf[ITEMS-3] || n != 3);
+   err += (ring_mpmc_put_n (&mpmc, b, ITEMS+1) != ITEMS);
+   err += (ring_mpmc_put (&mpmc, b) != 0);
+   err += (ring_mpmc_reserve (&mpmc) != NULL);
+   err += (ring_mpmc_waiting (&mpmc) != ITEMS);
+   err += (ring_mpmc_get_n (&mpmc, b, ITEMS+1) != ITEMS);
+   err += (ring_mpmc_get (&mpmc, b) != 0);
+   err += (ring_mpmc_peek (&mpmc) != NULL);
+   if (err)
+      printf ("edges: %d errors\n", err);
+   return err;
+}
+
+int main (void)
+{
+   int err = 0, np, pass;
+   char name[32];
+
+   err += _check_edges ();
+   for (pass=0 ; pass<2 ; ++pass) {
+      ring_spsc_init (&spsc, spsc_buf, ITEMS, sizeof (item_t));
+      if (pass) {
+         atomic_store (&spsc.tail, WRAP);
+         atomic_store (&spsc.head, WRAP);
+         spsc.head_c = spsc.tail_c = WRAP;
+      }
+      snprintf (name, sizeof (name), "SPSC 1P/1C%s", (pass) ? " w" : "");
+      err += _run (name, 1, 1, _spsc_prod, _spsc_cons);
+
+      for (np=1 ; np<=MAXTH ; np<<=1) {
+         ring_mpmc_init (&mpmc, mpmc_buf, ITEMS, sizeof (item_t));
+         if (pass)
+            _mpmc_start (WRAP);
+         snprintf (name, sizeof (name), "MPMC %dP/%dC%s", np, np, (pass) ? " w" : "");
+         err += _run (name, np, np, _mpmc_prod, _mpmc_cons);
+      }
+      ring_mpmc_init (&mpmc, mpmc_buf, ITEMS, sizeof (item_t));
+      if (pass)
+         _mpmc_start (WRAP);
+      snprintf (name, sizeof (name), "MPMC %dP/1C%s", MAXTH, (pass) ? " w" : "");
+      err += _run (name, MAXTH, 1, _mpmc_prod, _mpmc_cons);
+   }
+   printf ("(w: indexes start near the 32 bit wrap)\n");
+   printf ("ring: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
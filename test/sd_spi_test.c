@@ -0,0 +1,423 @@
+/*!
+ * \file sd_spi_test.c
+ * \brief
+ *    Host test of the sd_spi driver on the SD card simulator. It checks
+ *    the reads and the writes of the byte and the bulk SPI path against
+ *    the card image, the read-ahead cache with its coherency on writes
+ *    and at the end of the card, and the ACMD23 pre-erase of the multiple
+ *    block writes. It checks the non blocking reads and writes, the drive
+ *    status during a pending operation and the cache after an async write.
+ *    Then it measures the bus time of sector reads and writes on each
+ *    path, and compares the blocking calls against two interleaved async
+ *    writers on two cards, with the total time on the shared simulated
+ *    clock and the longest time a single call holds the CPU.
+ *
+ *    gcc -std=gnu11 -O2 -D__VALIST=__gnuc_va_list -I../inc sd_spi_test.c ../src/drv/sd_spi.c ../src/drv/sim_sd.c -o sd_spi_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <drv/sd_spi.h>
+#include <drv/sim_sd.h>
+
+#define SECTORS   (4096)
+#define BLOCKS    (64)        // Blocks of a multiple block write
+#define CACHE     (8)
+#define BENCH     (1024)      // Sectors of each benchmark
+#define OPS       (2000)      // Random operations
+
+static simsd_t    card[2];
+static byte_t     mem[2][SECTORS * SIMSD_BLOCK_SZ];
+static byte_t     buf[2][BLOCKS * SIMSD_BLOCK_SZ];
+static byte_t     ra[CACHE * SIMSD_BLOCK_SZ];
+static uint64_t   clk;        // Shared simulated clock in nsec
+
+static void _cs0 (uint8_t en) { simsd_spi_cs (&card[0], en); }
+static void _cs1 (uint8_t en) { simsd_spi_cs (&card[1], en); }
+
+/*
+ * The time base of the driver, as a timer interrupt does
+ */
+static void _tick (int sig) {
+   (void)sig;
+   sd_service ();
+}
+
+static void _fill (byte_t *b, size_t n) {
+   for (size_t i=0 ; i<n ; ++i)
+      b[i] = (byte_t)rand ();
+}
+
+static int _init (int drv, drv_pinout_ft cs)
+{
+   simsd_deinit (&card[drv]);
+   simsd_link_mem (&card[drv], mem[drv], sizeof (mem[drv]));
+   simsd_link_clock (&card[drv], &clk);
+   simsd_init (&card[drv]);
+
+   sd_link_cs (drv, cs);
+   sd_link_spi (drv, (void*)&card[drv]);
+   sd_link_spi_ioctl (drv, (spi_ioctl_t)simsd_spi_ioctl);
+   sd_link_spi_rw (drv, (spi_rw_t)simsd_spi_rw);
+   return (sd_init (drv) != DRV_READY);
+}
+
+/*
+ * Select the byte or the bulk SPI path
+ */
+static void _path (int drv, int bulk) {
+   sd_link_spi_rw_block (drv, (bulk) ? (spi_rw_block_t)simsd_spi_rw_block : NULL);
+}
+
+/*
+ * Random reads and writes of 1..BLOCKS sectors against the card image
+ */
+static int _check_rw (int bulk, int cache)
+{
+   sd_idx_t s;
+   size_t n;
+   int err = 0, i, wr;
+
+   _path (0, bulk);
+   sd_link_cache (0, (cache) ? ra : NULL, CACHE);
+   for (i=0 ; i<OPS && !err ; ++i) {
+      n = 1 + ((rand () & 1) ? rand () % 4 : rand () % BLOCKS);
+      s = rand () % (SECTORS - n);
+      if (rand () & 3)
+         s &= 0xFF;     // Mostly a hot area, the cache has to hit
+      if (!(wr = rand () & 1)) {
+         err += (sd_read (0, s, buf[0], n) != DRV_READY);
+         err += (memcmp (buf[0], &mem[0][s * SIMSD_BLOCK_SZ], n * SIMSD_BLOCK_SZ) != 0);
+      }
+      else {
+         _fill (buf[0], n * SIMSD_BLOCK_SZ);
+         err += (sd_write (0, s, buf[0], n) != DRV_READY);
+         err += (memcmp (buf[0], &mem[0][s * SIMSD_BLOCK_SZ], n * SIMSD_BLOCK_SZ) != 0);
+      }
+      if (err)
+         printf ("%s path%s: %s of %u sectors at %u differs\n", (bulk) ? "bulk" : "byte",
+                 (cache) ? " + cache" : "", (wr) ? "write" : "read", (unsigned)n, (unsigned)s);
+   }
+   err += (card[0].stat.errors != 0);
+   sd_link_cache (0, NULL, 0);
+   return err;
+}
+
+/*
+ * The read-ahead cache: one command for each CACHE sectors of small
+ * sequential reads, the writes update the cached sectors, and a fill at
+ * the end of the card keeps the readable sectors.
+ */
+static int _check_cache (void)
+{
+   uint32_t cmds;
+   int err = 0, i;
+
+   _path (0, 1);
+   sd_link_cache (0, ra, CACHE);
+   cmds = card[0].stat.cmds;
+   for (i=0 ; i<4*CACHE ; ++i) {
+      err += (sd_read (0, 1000 + i, buf[0], 1) != DRV_READY);
+      err += (memcmp (buf[0], &mem[0][(1000 + i) * SIMSD_BLOCK_SZ], SIMSD_BLOCK_SZ) != 0);
+   }
+   // A CMD18 and a CMD12 for each fill
+   if (card[0].stat.cmds - cmds != 2 * 4) {
+      printf ("cache: %u commands for %d sector reads\n", card[0].stat.cmds - cmds, 4*CACHE);
+      ++err;
+   }
+
+   // Writes into and across the cached sectors
+   err += (sd_read (0, 2000, buf[1], 1) != DRV_READY);          // Caches 2000..2007
+   _fill (buf[0], 4 * SIMSD_BLOCK_SZ);
+   err += (sd_write (0, 2006, buf[0], 4) != DRV_READY);
+   err += (sd_write (0, 1998, &buf[0][SIMSD_BLOCK_SZ], 3) != DRV_READY);
+   err += (sd_read (0, 1998, buf[1], 5) != DRV_READY);
+   err += (memcmp (buf[1], &mem[0][1998 * SIMSD_BLOCK_SZ], 5 * SIMSD_BLOCK_SZ) != 0);
+   err += (sd_read (0, 2005, buf[1], 3) != DRV_READY);
+   err += (memcmp (buf[1], &mem[0][2005 * SIMSD_BLOCK_SZ], 3 * SIMSD_BLOCK_SZ) != 0);
+   err += (memcmp (&buf[1][SIMSD_BLOCK_SZ], buf[0], 2 * SIMSD_BLOCK_SZ) != 0);
+
+   // The last sectors, the fill stops at the end of the card
+   err += (sd_read (0, SECTORS-2, buf[1], 2) != DRV_READY);
+   err += (memcmp (buf[1], &mem[0][(SECTORS-2) * SIMSD_BLOCK_SZ], 2 * SIMSD_BLOCK_SZ) != 0);
+   err += (sd_read (0, SECTORS-1, buf[1], 1) != DRV_READY);
+   err += (memcmp (buf[1], &mem[0][(SECTORS-1) * SIMSD_BLOCK_SZ], SIMSD_BLOCK_SZ) != 0);
+   err += (sd_read (0, SECTORS-1, buf[1], 2) != DRV_ERROR);     // Out of the card
+   sd_setstatus (0, DRV_READY);
+   card[0].stat.errors = 0;
+
+   sd_link_cache (0, NULL, 0);
+   if (err)
+      printf ("cache: %d errors\n", err);
+   return err;
+}
+
+/*
+ * Multiple block writes send an ACMD23 with the block count before the
+ * CMD25, the single block writes do not.
+ */
+static int _check_acmd23 (void)
+{
+   uint32_t pe, wb;
+   int err = 0, n;
+
+   for (n=1 ; n<=BLOCKS ; n *= 2) {
+      pe = card[0].stat.pre_erases;
+      wb = card[0].stat.write_blocks;
+      _fill (buf[0], n * SIMSD_BLOCK_SZ);
+      err += (sd_write (0, 3000, buf[0], n) != DRV_READY);
+      err += (memcmp (buf[0], &mem[0][3000 * SIMSD_BLOCK_SZ], n * SIMSD_BLOCK_SZ) != 0);
+      err += (card[0].stat.pre_erases - pe != ((n > 1) ? 1u : 0u));
+      err += (card[0].stat.write_blocks - wb != (uint32_t)n);
+   }
+   if (err)
+      printf ("acmd23: %d errors\n", err);
+   return err;
+}
+
+/*
+ * BENCH sectors read and written with each path, on the simulated bus time
+ */
+static void _bench_line (const char *name, uint64_t t0, uint32_t calls, uint32_t cmds)
+{
+   printf ("%-36s %8.1f ms %8.1f calls/sector %6u commands\n", name, (card[0].stat.time - t0) * 1e-6,
+           (double)(card[0].stat.calls - calls) / BENCH, card[0].stat.cmds - cmds);
+}
+
+static int _bench (void)
+{
+   static const char *rd[] = {
+      "read, 1 sector per call, byte path",
+      "read, 1 sector per call, bulk path",
+      "read, bulk path + 8 sector cache" };
+   static const char *wr[] = {
+      "write, single block, byte path",
+      "write, single block, bulk path",
+      "write, 64 block CMD25 + ACMD23, bulk" };
+   uint64_t t0;
+   uint32_t calls, cmds;
+   int err = 0, i, k;
+
+   for (k=0 ; k<3 ; ++k) {
+      _path (0, k > 0);
+      sd_link_cache (0, (k == 2) ? ra : NULL, CACHE);
+      t0 = card[0].stat.time; calls = card[0].stat.calls; cmds = card[0].stat.cmds;
+      for (i=0 ; i<BENCH ; ++i) {
+         err += (sd_read (0, i, buf[0], 1) != DRV_READY);
+         err += (memcmp (buf[0], &mem[0][i * SIMSD_BLOCK_SZ], SIMSD_BLOCK_SZ) != 0);
+      }
+      _bench_line (rd[k], t0, calls, cmds);
+   }
+   sd_link_cache (0, NULL, 0);
+   for (k=0 ; k<3 ; ++k) {
+      _path (0, k > 0);
+      _fill (buf[1], sizeof (buf[1]));
+      t0 = card[0].stat.time; calls = card[0].stat.calls; cmds = card[0].stat.cmds;
+      for (i=0 ; i<BENCH ; i += (k == 2) ? BLOCKS : 1) {
+         if (k < 2)
+            err += (sd_write (0, BENCH + i, &buf[1][(i % BLOCKS) * SIMSD_BLOCK_SZ], 1) != DRV_READY);
+         else
+            err += (sd_write (0, BENCH + i, buf[1], BLOCKS) != DRV_READY);
+      }
+      err += (sd_read (0, 0, buf[0], 1) != DRV_READY);   // The last busy time
+      _bench_line (wr[k], t0, calls, cmds);
+      for (i=0 ; i<BENCH ; ++i)
+         err += (memcmp (&mem[0][(BENCH + i) * SIMSD_BLOCK_SZ], &buf[1][(i % BLOCKS) * SIMSD_BLOCK_SZ], SIMSD_BLOCK_SZ) != 0);
+   }
+   if (err)
+      printf ("bench: %d errors\n", err);
+   return err;
+}
+
+/*
+ * The blocking and the non blocking reads against the card image. The
+ * async read has to give the CPU back during the access time.
+ */
+static int _check_read_async (void)
+{
+   sd_op_t        op;
+   drv_status_en  st;
+   int err = 0, calls, busy = 0, n;
+
+   for (n=1 ; n<=BLOCKS ; n *= 4) {
+      memset ((void*)buf[0], 0, n * SIMSD_BLOCK_SZ);
+      err += (sd_read (0, 100 + n, buf[0], n) != DRV_READY);
+      err += (memcmp (buf[0], &mem[0][(100 + n) * SIMSD_BLOCK_SZ], n * SIMSD_BLOCK_SZ) != 0);
+
+      memset ((void*)&op, 0, sizeof (op));
+      memset ((void*)buf[0], 0, n * SIMSD_BLOCK_SZ);
+      for (calls=1 ; (st = sd_read_async (0, &op, 200 + n, buf[0], n)) == PT_PENDING ; ++calls) {
+         if (sd_getstatus (0) != DRV_BUSY)
+            ++busy;
+         if (sd_read (0, 0, buf[1], 1) != DRV_ERROR)
+            ++busy;     // No other operation while pending
+      }
+      err += (st != DRV_READY);
+      err += (memcmp (buf[0], &mem[0][(200 + n) * SIMSD_BLOCK_SZ], n * SIMSD_BLOCK_SZ) != 0);
+      err += (calls < n);  // At least one access time for each block
+      err += (sd_getstatus (0) != DRV_READY);
+   }
+   // Out of the card
+   memset ((void*)&op, 0, sizeof (op));
+   while ((st = sd_read_async (0, &op, SECTORS, buf[0], 1)) == PT_PENDING)
+      ;
+   err += (st != DRV_ERROR);
+   err += (sd_getstatus (0) != DRV_ERROR);
+   sd_setstatus (0, DRV_READY);     // As the blocking calls, the error stays
+   err += busy;
+   if (err)
+      printf ("async read: %d errors\n", err);
+   return err;
+}
+
+/*
+ * The non blocking writes against the card image. They return with a
+ * ready card, so the next command does not wait.
+ */
+static int _check_write_async (void)
+{
+   sd_op_t        op;
+   drv_status_en  st;
+   int err = 0, n;
+
+   for (n=1 ; n<=BLOCKS ; n *= 4) {
+      _fill (buf[0], n * SIMSD_BLOCK_SZ);
+      memset ((void*)&op, 0, sizeof (op));
+      while ((st = sd_write_async (0, &op, 300 + n, buf[0], n)) == PT_PENDING)
+         ;
+      err += (st != DRV_READY);
+      err += (memcmp (buf[0], &mem[0][(300 + n) * SIMSD_BLOCK_SZ], n * SIMSD_BLOCK_SZ) != 0);
+      err += (card[0].busy > clk);
+   }
+   if (err)
+      printf ("async write: %d errors\n", err);
+   return err;
+}
+
+/*
+ * An async write into the sectors of the read-ahead cache
+ */
+static int _check_cache_async (void)
+{
+   sd_op_t op;
+   int err = 0;
+
+   sd_link_cache (0, ra, CACHE);
+   err += (sd_read (0, 500, buf[1], 1) != DRV_READY);    // Fills 500..507
+   _fill (buf[0], 2 * SIMSD_BLOCK_SZ);
+   memset ((void*)&op, 0, sizeof (op));
+   while (sd_write_async (0, &op, 503, buf[0], 2) == PT_PENDING)
+      ;
+   err += (sd_read (0, 502, buf[1], 3) != DRV_READY);
+   err += (memcmp (buf[1], &mem[0][502 * SIMSD_BLOCK_SZ], 3 * SIMSD_BLOCK_SZ) != 0);
+   err += (memcmp (&buf[1][SIMSD_BLOCK_SZ], buf[0], 2 * SIMSD_BLOCK_SZ) != 0);
+   sd_link_cache (0, NULL, 0);
+   if (err)
+      printf ("async cache: %d errors\n", err);
+   return err;
+}
+
+/*
+ * BLOCKS single block writes on each card, with the blocking calls one
+ * card after the other and with two interleaved async writers.
+ */
+static int _bench_async (void)
+{
+   sd_op_t        op[2];
+   drv_status_en  st;
+   uint64_t       t0, t1, t_sync, t_async, max_sync = 0, max_async = 0;
+   int err = 0, i, b[2] = {0, 0};
+
+   _path (0, 1);
+   _path (1, 1);
+   _fill (buf[0], sizeof (buf[0]));
+   _fill (buf[1], sizeof (buf[1]));
+   t0 = clk;
+   for (i=0 ; i<2*BLOCKS ; ++i) {
+      t1 = clk;
+      err += (sd_write (i%2, 1000 + i/2, &buf[i%2][i/2 * SIMSD_BLOCK_SZ], 1) != DRV_READY);
+      if (clk - t1 > max_sync)   max_sync = clk - t1;
+   }
+   err += (sd_read (0, 0, ra, 1) != DRV_READY);      // The last busy times
+   err += (sd_read (1, 0, ra, 1) != DRV_READY);
+   t_sync = clk - t0;
+
+   memset ((void*)op, 0, sizeof (op));
+   t0 = clk;
+   while (b[0] < BLOCKS || b[1] < BLOCKS) {
+      for (i=0 ; i<2 ; ++i) {
+         if (b[i] >= BLOCKS)
+            continue;
+         t1 = clk;
+         st = sd_write_async (i, &op[i], 2000 + b[i], &buf[i][b[i] * SIMSD_BLOCK_SZ], 1);
+         if (clk - t1 > max_async)  max_async = clk - t1;
+         if (st != PT_PENDING) {
+            err += (st != DRV_READY);
+            ++b[i];
+         }
+      }
+   }
+   t_async = clk - t0;
+   for (i=0 ; i<2 ; ++i) {
+      err += (memcmp (buf[i], &mem[i][1000 * SIMSD_BLOCK_SZ], sizeof (buf[i])) != 0);
+      err += (memcmp (buf[i], &mem[i][2000 * SIMSD_BLOCK_SZ], sizeof (buf[i])) != 0);
+   }
+   printf ("2 cards x %d block writes: blocking %.2f ms, longest call %.1f us\n",
+           BLOCKS, t_sync * 1e-6, max_sync * 1e-3);
+   printf ("                           async    %.2f ms, longest call %.1f us\n",
+           t_async * 1e-6, max_async * 1e-3);
+   err += (max_async >= max_sync);
+   if (err)
+      printf ("async bench: %d errors\n", err);
+   return err;
+}
+
+int main (void)
+{
+   struct itimerval it = { {0, 1000}, {0, 1000} };
+   int err = 0;
+
+   srand (1);
+   _fill (mem[0], sizeof (mem[0]));
+   _fill (mem[1], sizeof (mem[1]));
+   signal (SIGALRM, _tick);
+   setitimer (ITIMER_REAL, &it, NULL);
+
+   err += _init (0, _cs0);
+   err += _init (1, _cs1);
+   if (err)
+      printf ("init: %d errors\n", err);
+   else {
+      err += _check_rw (0, 0);
+      err += _check_rw (1, 0);
+      err += _check_rw (1, 1);
+      err += _check_cache ();
+      err += _check_acmd23 ();
+      err += _bench ();
+      err += _check_read_async ();
+      err += _check_write_async ();
+      err += _check_cache_async ();
+      err += _bench_async ();
+   }
+   printf ("sd_spi: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
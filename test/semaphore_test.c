@@ -0,0 +1,235 @@
+/*!
+ * \file semaphore_test.c
+ * \brief
+ *    Host test of the semaphores and mutexes with pthreads. THREADS threads
+ *    increment a plain counter under mut_lock()/mut_unlock() and under a
+ *    binary semaphore, so any lost update shows in the count. Then producers
+ *    and consumers pass numbered items through a bounded ring with the two
+ *    semaphores "empty" and "full", every item has to arrive exactly once.
+ *    The non blocking sem_check()/mut_trylock() are checked single threaded.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc semaphore_test.c ../src/sys/semaphore.c -lpthread -o semaphore_test
+ *
+ *    On Linux the waiters sleep on a futex. Build a second time with
+ *    -DSEM_NO_FUTEX to check the spinning waiters of the targets.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/semaphore.h>
+#include "bench.h"
+
+#define THREADS   (4)
+#define LOCKS     (200000)    // Lock/unlock per thread
+#define PRODS     (2)
+#define CONS      (3)
+#ifndef SEM_NO_FUTEX
+#define ITEMS     (30000)     // Items per producer
+#else
+#define ITEMS     (1000)      // Spinning waiters burn their time slice on a single core
+#endif
+#define SLOTS     (16)        // Ring size
+
+static sem_t      mut;
+static sem_t      bin;
+static long       count;
+
+static sem_t      empty, full, put_m, get_m;
+static int        ring[SLOTS];
+static int        head, tail;
+static int        seen[PRODS*ITEMS];
+
+/*
+ * Lock/unlock workers
+ */
+static void *_mut_worker (void *arg)
+{
+   (void)arg;
+   for (int i=0 ; i<LOCKS ; ++i) {
+      mut_lock (&mut);
+      ++count;
+      mut_unlock (&mut);
+   }
+   return NULL;
+}
+
+static void *_sem_worker (void *arg)
+{
+   (void)arg;
+   for (int i=0 ; i<LOCKS ; ++i) {
+      sem_wait (&bin);
+      ++count;
+      sem_post (&bin);
+   }
+   return NULL;
+}
+
+/*
+ * Producer/consumer. The producers number their items p*ITEMS + i, a
+ * consumer stops at the item -1.
+ */
+static void *_producer (void *arg)
+{
+   int p = (int)(intptr_t)arg;
+
+   for (int i=0 ; i<ITEMS ; ++i) {
+      sem_wait (&empty);
+      mut_lock (&put_m);
+      ring[head] = p*ITEMS + i;
+      head = (head+1) % SLOTS;
+      mut_unlock (&put_m);
+      sem_post (&full);
+   }
+   return NULL;
+}
+
+static void *_consumer (void *arg)
+{
+   int v;
+
+   (void)arg;
+   for (;;) {
+      sem_wait (&full);
+      mut_lock (&get_m);
+      v = ring[tail];
+      tail = (tail+1) % SLOTS;
+      mut_unlock (&get_m);
+      sem_post (&empty);
+      if (v < 0)
+         return NULL;
+      __atomic_fetch_add (&seen[v], 1, __ATOMIC_RELAXED);
+   }
+}
+
+/*!
+ * Run THREADS workers and check the count
+ */
+static int _check_lock (const char *name, void *(*worker) (void *))
+{
+   pthread_t th[THREADS];
+   double t0, t1;
+   int i;
+
+   count = 0;
+   t0 = _now ();
+   for (i=0 ; i<THREADS ; ++i)
+      pthread_create (&th[i], NULL, worker, NULL);
+   for (i=0 ; i<THREADS ; ++i)
+      pthread_join (th[i], NULL);
+   t1 = _now ();
+   printf ("%s: %d threads, %.1f ns per lock/unlock\n", name, THREADS,
+      (t1-t0) * 1e9 / ((double)THREADS*LOCKS));
+   if (count != (long)THREADS*LOCKS) {
+      printf ("%s: count %ld, expected %ld\n", name, count, (long)THREADS*LOCKS);
+      return 1;
+   }
+   return 0;
+}
+
+static int _check_prodcons (void)
+{
+   pthread_t pt[PRODS], ct[CONS];
+   double t0, t1;
+   int err = 0, i;
+
+   sem_init (&empty, SLOTS);
+   sem_init (&full, 0);
+   mut_init (&put_m, 0);
+   mut_init (&get_m, 0);
+   memset (seen, 0, sizeof (seen));
+   t0 = _now ();
+   for (i=0 ; i<CONS ; ++i)
+      pthread_create (&ct[i], NULL, _consumer, NULL);
+   for (i=0 ; i<PRODS ; ++i)
+      pthread_create (&pt[i], NULL, _producer, (void*)(intptr_t)i);
+   for (i=0 ; i<PRODS ; ++i)
+      pthread_join (pt[i], NULL);
+   // A stop item for each consumer
+   for (i=0 ; i<CONS ; ++i) {
+      sem_wait (&empty);
+      ring[head] = -1;
+      head = (head+1) % SLOTS;
+      sem_post (&full);
+   }
+   for (i=0 ; i<CONS ; ++i)
+      pthread_join (ct[i], NULL);
+   t1 = _now ();
+   printf ("prodcons: %d producers, %d consumers, %.1f ns per item\n", PRODS, CONS,
+      (t1-t0) * 1e9 / (PRODS*ITEMS));
+
+   for (i=0 ; i<PRODS*ITEMS ; ++i)
+      if (seen[i] != 1) {
+         printf ("prodcons: item %d seen %d times\n", i, seen[i]);
+         ++err;
+         break;
+      }
+   if (sem_getvalue (&empty) != SLOTS || sem_getvalue (&full) != 0) {
+      printf ("prodcons: empty %d, full %d at the end\n", sem_getvalue (&empty), sem_getvalue (&full));
+      ++err;
+   }
+   return err;
+}
+
+/*!
+ * The non blocking calls
+ */
+static int _check_try (void)
+{
+   sem_t s, m;
+   int err = 0;
+
+   sem_init (&s, 0);
+   err += sem_check (&s) != 0;
+   sem_post (&s);
+   sem_post (&s);
+   err += sem_getvalue (&s) != 2;
+   err += sem_check (&s) != 1;
+   err += sem_check (&s) != 1;
+   err += sem_check (&s) != 0;
+
+   mut_init (&m, 0);
+   err += mut_trylock (&m) != 1;
+   err += mut_trylock (&m) != 0;
+   mut_unlock (&m);
+   err += mut_trylock (&m) != 1;
+   mut_unlock (&m);
+   mut_init (&m, 1);
+   err += mut_trylock (&m) != 0;
+   if (err)
+      printf ("try: %d checks failed\n", err);
+   return err;
+}
+
+int main (void)
+{
+   int err = 0;
+
+   err += _check_try ();
+   mut_init (&mut, 0);
+   err += _check_lock ("mutex", _mut_worker);
+   sem_init (&bin, 1);
+   err += _check_lock ("semaphore", _sem_worker);
+   err += _check_prodcons ();
+
+   printf ("semaphore: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
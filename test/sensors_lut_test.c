@@ -0,0 +1,395 @@
+/*!
+ * \file sensors_lut_test.c
+ * \brief
+ *    Host test of the compiled sensor LUTs. Every sensor table is checked
+ *    against the legacy sen_pclut()/sen_nclut() scan at the table points,
+ *    the segment midpoints, the exact table limits and their float
+ *    neighbours and at random values, for sen_convert() and sen_convert_n().
+ *    Synthetic tables cover the direct indexing, the binary search over
+ *    padded sizes and the sen_lut_init() errors. The cubic and Steinhart-Hart
+ *    fits are checked against the error sen_lut_fit() reports. At the end the
+ *    pt100 conversion is timed, legacy scan vs compiled vs batch.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc sensors_lut_test.c ../src/drv/sensors_lut.c ../src/drv/pt100x.c ../src/drv/ktyx.c ../src/drv/ntc10k_3435k.c ../src/drv/ntc3997k.c ../src/drv/jtype.c -lm -o sensors_lut_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <drv/sensors_lut.h>
+#include <drv/pt100x.h>
+#include <drv/ktyx.h>
+#include <drv/ntc10k_3435k.h>
+#include <drv/ntc3997k.h>
+#include <drv/jtype.h>
+#include "bench.h"
+
+#define RANDS     (20000)     // Random values per table
+#define BENCH     (4096)      // Samples per timed pass
+#define RUNS      (500)
+#define TOL(_t)   (2e-3 + 1e-5*fabs (_t))
+
+/*!
+ * A table under test, rebuilt in the legacy FROM/TO form
+ */
+typedef struct {
+   const char        *name;
+   const sen_lut_t   *lut;
+   lut_t             F[SEN_LUT_SIZE+1];
+   float             T[SEN_LUT_SIZE+1];
+   float             scale;
+   int               n;
+}table_t;
+
+static table_t tbl[] = {
+   { .name = "pt100" },
+   { .name = "pt1000" },
+   { .name = "kty8x_121" },
+   { .name = "kty8x_122" },
+   { .name = "kty11_6" },
+   { .name = "ntc10k_3435k" },
+   { .name = "ntc3997k" },
+   { .name = "jtype" },
+};
+#define TABLES    (int)(sizeof (tbl) / sizeof (tbl[0]))
+
+static volatile float sink;
+
+/*!
+ * Rebuild the FROM/TO table of a compiled LUT. The FROM points are stored
+ * sign * F, so the negation back is exact.
+ */
+static void _rebuild (table_t *tb, const sen_lut_t *lut)
+{
+   float sign = (lut->gain > 0) ? 1 : -1;
+   int i;
+
+   tb->lut = lut;
+   tb->n = lut->n;
+   tb->scale = fabsf (lut->gain);
+   for (i=0 ; i<lut->n ; ++i) {
+      tb->F[i] = sign * lut->f[i];
+      tb->T[i] = lut->t[i];
+   }
+   tb->T[i] = INT_MAX;
+}
+
+/*!
+ * The legacy conversion of a table
+ */
+static float _legacy (const table_t *tb, float v)
+{
+   return (tb->lut->gain > 0) ? sen_pclut (v * tb->scale, tb->F, tb->T)
+                              : sen_nclut (v * tb->scale, tb->F, tb->T);
+}
+
+/*!
+ * Compare a converted value with the reference, TEMP_ERROR only matches itself
+ */
+static int _same (float t, float ref)
+{
+   if (t == (float)TEMP_ERROR || ref == (float)TEMP_ERROR)
+      return t == ref;
+   return fabs (t - ref) <= TOL (ref);
+}
+
+/*!
+ * Check one value with sen_convert() against the legacy scan
+ */
+static int _check_one (const table_t *tb, const sen_lut_t *lut, float v)
+{
+   float t = sen_convert (lut, v), ref = _legacy (tb, v);
+
+   if (_same (t, ref))
+      return 0;
+   printf ("%s: v=%.9g compiled %.6f, legacy %.6f\n", tb->name, v, t, ref);
+   return 1;
+}
+
+/*!
+ * Check a compiled LUT against its legacy table: table points, midpoints,
+ * limits and neighbours, random values, and the batch conversion.
+ */
+static int _check_table (const table_t *tb, const sen_lut_t *lut)
+{
+   static float v[RANDS], t[RANDS], w[RANDS];
+   float lo = tb->F[0] / tb->scale, hi = tb->F[tb->n-1] / tb->scale;
+   float span = fabsf (hi - lo), vmin = fminf (lo, hi), x;
+   int err = 0, i, k;
+
+   for (i=0 ; i<tb->n ; ++i) {
+      err += _check_one (tb, lut, tb->F[i] / tb->scale);
+      if (i)
+         err += _check_one (tb, lut, (tb->F[i] + tb->F[i-1]) / 2 / tb->scale);
+   }
+   // The limits and the float values next to them, both ways
+   for (i=0 ; i<2 ; ++i) {
+      x = (i) ? hi : lo;
+      err += _check_one (tb, lut, x);
+      err += _check_one (tb, lut, nextafterf (x, INFINITY));
+      err += _check_one (tb, lut, nextafterf (x, -INFINITY));
+   }
+   // The limits in the table units have to be in, the next floats out
+   for (i=0 ; i<2 ; ++i) {
+      k = (i) ? tb->n-1 : 0;
+      x = tb->F[k] / tb->scale;
+      if (x * tb->scale != tb->F[k])
+         continue;
+      if (sen_convert (lut, x) == (float)TEMP_ERROR) {
+         printf ("%s: limit %.9g rejected\n", tb->name, x);
+         ++err;
+      }
+      x = (lut->gain * (k ? 1 : -1) > 0) ? nextafterf (x, INFINITY) : nextafterf (x, -INFINITY);
+      if (sen_convert (lut, x) != (float)TEMP_ERROR) {
+         printf ("%s: %.9g past the limit accepted\n", tb->name, x);
+         ++err;
+      }
+   }
+   for (i=0 ; i<RANDS ; ++i) {
+      v[i] = vmin - span/10 + span * 1.2f * rand () / RAND_MAX;
+      err += _check_one (tb, lut, v[i]);
+   }
+
+   // Batch, whole and with odd lengths, then in place
+   sen_convert_n (lut, v, t, RANDS);
+   for (i=0 ; i<RANDS ; i+=k) {
+      k = 1 + rand () % 131;
+      k = (i+k > RANDS) ? RANDS-i : k;
+      sen_convert_n (lut, &v[i], &w[i], k);
+   }
+   for (i=0 ; i<RANDS ; ++i)
+      if (!_same (t[i], sen_convert (lut, v[i])) || !_same (w[i], t[i])) {
+         printf ("%s: batch v=%.9g %.6f/%.6f, single %.6f\n", tb->name, v[i], t[i], w[i], sen_convert (lut, v[i]));
+         ++err;
+         break;
+      }
+   memcpy (w, v, sizeof (w));
+   sen_convert_n (lut, w, w, RANDS);
+   if (memcmp (w, t, sizeof (w))) {
+      printf ("%s: in place batch differs\n", tb->name);
+      ++err;
+   }
+   return err;
+}
+
+/*!
+ * Synthetic tables: uniform and not, every size up to SEN_LUT_SIZE, both
+ * coefficient signs. Covers the direct indexing and the binary search over
+ * the padded sizes.
+ */
+static int _check_synthetic (void)
+{
+   static table_t tb;
+   sen_lut_t lut;
+   int err = 0, n, i, uni, neg;
+
+   for (n=2 ; n<=SEN_LUT_SIZE ; ++n)
+      for (uni=0 ; uni<2 ; ++uni)
+         for (neg=0 ; neg<2 ; ++neg) {
+            for (i=0 ; i<n ; ++i) {
+               tb.F[i] = (uni) ? 100 + 10*i : 100 + 10*i + i*i*0.37f;
+               tb.F[i] = (neg) ? 2000 - tb.F[i] : tb.F[i];
+               tb.T[i] = -50 + 7.5f*i + ((i & 1) ? 0.3f : 0);
+            }
+            tb.T[n] = INT_MAX;
+            tb.name = "synthetic";
+            if (sen_lut_init (&lut, tb.F, tb.T, 1) != n
+             || (lut.inv != 0) != (uni || n == 2)) {
+               printf ("synthetic: n=%d uniform=%d neg=%d init %d, inv %g\n", n, uni, neg, lut.n, lut.inv);
+               ++err;
+               continue;
+            }
+            _rebuild (&tb, &lut);
+            err += _check_table (&tb, &lut);
+         }
+   return err;
+}
+
+/*!
+ * A LUT that failed to compile, or never did, converts to TEMP_ERROR
+ */
+static int _check_init (void)
+{
+   static lut_t F[SEN_LUT_SIZE+2];
+   static float T[SEN_LUT_SIZE+2];
+   static sen_lut_t zero;
+   sen_lut_t lut;
+   float v[3] = { 1, 50, 100 }, t[3];
+   int err = 0, c, i, r;
+
+   for (c=0 ; c<5 ; ++c) {
+      for (i=0 ; i<SEN_LUT_SIZE+1 ; ++i) {
+         F[i] = 10 * i;
+         T[i] = i;
+      }
+      T[SEN_LUT_SIZE+1] = INT_MAX;
+      switch (c) {
+         case 0: T[1] = INT_MAX; break;   // 1 point
+         case 1: break;                   // Too long
+         case 2: F[7] = F[5];             // Not monotonic
+                 T[20] = INT_MAX; break;
+         case 3: T[20] = INT_MAX;         // Bad scale
+                 break;
+         case 4: break;                   // Never compiled
+      }
+      memset (&lut, 0x55, sizeof (lut));
+      r = (c == 4) ? (lut = zero).n : sen_lut_init (&lut, F, T, (c == 3) ? 0 : 1);
+      sen_convert_n (&lut, v, t, 3);
+      if (r || sen_convert (&lut, 50) != (float)TEMP_ERROR
+            || t[0] != (float)TEMP_ERROR || t[1] != (float)TEMP_ERROR || t[2] != (float)TEMP_ERROR) {
+         printf ("init case %d: returned %d, converts %g\n", c, r, sen_convert (&lut, 50));
+         ++err;
+      }
+   }
+   return err;
+}
+
+/*!
+ * Cubic and Steinhart-Hart fits. The reported error has to be the maximum
+ * error at the table points, the range stays the table's and an impossible
+ * fit leaves the LUT as it was.
+ */
+static int _check_fit (const table_t *tb)
+{
+   static const char *fn[] = { "none", "cubic", "SH" };
+   sen_lut_t lut;
+   float e, emax, x, r;
+   int err = 0, fit, i;
+
+   for (fit=SEN_FIT_CUBIC ; fit<=SEN_FIT_SH ; ++fit) {
+      lut = *tb->lut;
+      r = sen_lut_fit (&lut, fit);
+      if (fit == SEN_FIT_SH && tb->F[0] * tb->F[tb->n-1] <= 0) {
+         // Non positive input, no logarithm
+         if (r != -1 || lut.fit != SEN_FIT_NONE) {
+            printf ("%s: SH fit on non positive input returned %g\n", tb->name, r);
+            ++err;
+         }
+         continue;
+      }
+      if (r < 0 || lut.fit != (sen_fit_en)fit) {
+         printf ("%s: %s fit failed\n", tb->name, fn[fit]);
+         ++err;
+         continue;
+      }
+      for (emax=0, i=0 ; i<tb->n ; ++i) {
+         e = fabsf (sen_convert (&lut, tb->F[i] / tb->scale) - tb->T[i]);
+         emax = (e > emax) ? e : emax;
+      }
+      if (fabsf (emax - r) > TOL (r)) {
+         printf ("%s: %s fit reports %g, measured %g\n", tb->name, fn[fit], r, emax);
+         ++err;
+      }
+      // Out of the table range it is still an error
+      x = fminf (tb->F[0], tb->F[tb->n-1]);
+      x = (x - fabsf (tb->F[tb->n-1] - tb->F[0]) / 100) / tb->scale;
+      if (sen_convert (&lut, x) != (float)TEMP_ERROR) {
+         printf ("%s: %s fit converts out of range\n", tb->name, fn[fit]);
+         ++err;
+      }
+      printf ("%-14s %-5s fit max error %8.4f\n", tb->name, fn[fit], r);
+   }
+   if (sen_lut_fit (&lut, SEN_FIT_NONE) != 0 || lut.fit != SEN_FIT_NONE
+    || sen_convert (&lut, tb->F[1] / tb->scale) != sen_convert (tb->lut, tb->F[1] / tb->scale)) {
+      printf ("%s: back to table interpolation failed\n", tb->name);
+      ++err;
+   }
+   return err;
+}
+
+/*!
+ * Spot values of the driver functions
+ */
+static int _check_drivers (void)
+{
+   int err = 0;
+
+   err += fabsf (sen_pt100 (100)) > 0.01f;
+   err += fabsf (sen_pt1000 (1000)) > 0.01f;
+   err += fabsf (sen_pt100 (138.51f) - 100) > 0.01f;
+   err += fabsf (sen_ntc10k_3435k (10000) - 25) > 0.5f;
+   err += sen_pt100 (10) != (float)TEMP_ERROR;
+   err += sen_pt1000 (5000) != (float)TEMP_ERROR;
+   if (err)
+      printf ("drivers: %d spot values wrong\n", err);
+   return err;
+}
+
+/*!
+ * pt100 conversion time: legacy scan, compiled and batch
+ */
+static void _bench (const table_t *tb)
+{
+   static float v[BENCH], t[BENCH];
+   double t0, t1, t2, t3;
+   float s;
+   int i, r;
+
+   for (i=0 ; i<BENCH ; ++i)
+      v[i] = (tb->F[0] + (tb->F[tb->n-1] - tb->F[0]) * (float)rand () / RAND_MAX) / tb->scale;
+
+   t0 = _now ();
+   for (s=0, r=0 ; r<RUNS ; ++r)
+      for (i=0 ; i<BENCH ; ++i)
+         s += _legacy (tb, v[i]);
+   sink = s;
+   t1 = _now ();
+   for (s=0, r=0 ; r<RUNS ; ++r)
+      for (i=0 ; i<BENCH ; ++i)
+         s += sen_convert (tb->lut, v[i]);
+   sink = s;
+   t2 = _now ();
+   for (s=0, r=0 ; r<RUNS ; ++r) {
+      sen_convert_n (tb->lut, v, t, BENCH);
+      s += t[r % BENCH];
+   }
+   sink = s;
+   t3 = _now ();
+   printf ("%s: legacy %.1f ns/sample, compiled %.1f ns, batch %.1f ns\n", tb->name,
+      (t1-t0) * 1e9 / (RUNS*BENCH), (t2-t1) * 1e9 / (RUNS*BENCH), (t3-t2) * 1e9 / (RUNS*BENCH));
+}
+
+int main (void)
+{
+   const sen_lut_t *(*lut[TABLES]) (void) = {
+      sen_pt100_lut, sen_pt1000_lut, sen_kty8x_121_lut, sen_kty8x_122_lut,
+      sen_kty11_6_lut, sen_ntc10k_3435k_lut, sen_ntc3997k_lut, sen_jtype_lut
+   };
+   int err = 0, i;
+
+   srand (1);
+   for (i=0 ; i<TABLES ; ++i) {
+      if (!lut[i] ()->n) {
+         printf ("%s: table not compiled\n", tbl[i].name);
+         ++err;
+         continue;
+      }
+      _rebuild (&tbl[i], lut[i] ());
+      err += _check_table (&tbl[i], tbl[i].lut);
+      err += _check_fit (&tbl[i]);
+   }
+   err += _check_synthetic ();
+   err += _check_init ();
+   err += _check_drivers ();
+   _bench (&tbl[0]);
+
+   printf ("sensors_lut: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
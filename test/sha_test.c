@@ -0,0 +1,344 @@
+/*!
+ * \file sha_test.c
+ * \brief
+ *    Host test of the hash functions. It checks the RFC 1321 MD5 and the
+ *    FIPS 180-4 SHA-1/224/256/384/512 vectors one-shot, in 1 byte and in
+ *    random chunks through the init/update/finish API, random lengths around
+ *    the block and padding boundaries, and sha256_mb() lane by lane against
+ *    sha256() for messages of unequal lengths. SHA-224/256 run both on the
+ *    SHA extensions and on the portable rounds. It measures the throughput
+ *    of every hash and of the SHA-256 backends.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc sha_test.c ../src/crypt/md5.c ../src/crypt/sha1.c ../src/crypt/sha2.c ../src/crypt/sha3.c -o sha_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <crypt/md5.h>
+#include <crypt/sha1.h>
+#include <crypt/sha2.h>
+#include <crypt/sha3.h>
+#include "bench.h"
+
+#define MILLION   (1000000)
+#define MAXLEN    (1200)      // Largest random message
+#define MB_MSGS   (19)        // Messages of the multi-buffer check, not a multiple of the lanes
+#define BENCH     (1 << 24)
+
+/*!
+ * The messages of the vectors
+ */
+static const char *msg[] = {
+   "abc",
+   "",
+   "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+   "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+   NULL     // One million 'a'
+};
+#define MSGS   (sizeof (msg) / sizeof (msg[0]))
+
+/*!
+ * A hash through a common interface
+ */
+typedef struct {
+   const char  *name;
+   size_t      dlen;
+   void        (*hash) (const uint8_t *in, size_t ilen, uint8_t *out);
+   void        (*init) (void *ctx);
+   void        (*update) (void *ctx, const uint8_t *in, size_t ilen);
+   void        (*finish) (void *ctx, uint8_t *out);
+   const char  *v[MSGS];   //!< The digests of msg[]
+}alg_t;
+
+typedef union {
+   md5_t    md5;
+   sha1_t   sha1;
+   sha2_t   sha2;
+   sha3_t   sha3;
+}ctx_t;
+
+static void _md5_hash (const uint8_t *in, size_t ilen, uint8_t *out) { md5 (in, ilen, out); }
+static void _md5_init (void *c) { md5_init (c); }
+static void _md5_update (void *c, const uint8_t *in, size_t ilen) { md5_update (c, in, ilen); }
+static void _md5_finish (void *c, uint8_t *out) { md5_finish (c, out); }
+static void _sha1_hash (const uint8_t *in, size_t ilen, uint8_t *out) { sha1 (in, ilen, out); }
+static void _sha1_init (void *c) { sha1_init (c); }
+static void _sha1_update (void *c, const uint8_t *in, size_t ilen) { sha1_update (c, in, ilen); }
+static void _sha1_finish (void *c, uint8_t *out) { sha1_finish (c, out); }
+static void _sha224_hash (const uint8_t *in, size_t ilen, uint8_t *out) { sha224 ((uint8_t*)in, ilen, out); }
+static void _sha224_init (void *c) { sha2_init (c, SHA2_224); }
+static void _sha256_hash (const uint8_t *in, size_t ilen, uint8_t *out) { sha256 ((uint8_t*)in, ilen, out); }
+static void _sha256_init (void *c) { sha2_init (c, SHA2_256); }
+static void _sha2_update (void *c, const uint8_t *in, size_t ilen) { sha2_update (c, in, ilen); }
+static void _sha2_finish (void *c, uint8_t *out) { sha2_finish (c, out); }
+static void _sha384_hash (const uint8_t *in, size_t ilen, uint8_t *out) { sha384 ((uint8_t*)in, ilen, out); }
+static void _sha384_init (void *c) { sha3_init (c, SHA3_384); }
+static void _sha512_hash (const uint8_t *in, size_t ilen, uint8_t *out) { sha512 ((uint8_t*)in, ilen, out); }
+static void _sha512_init (void *c) { sha3_init (c, SHA3_512); }
+static void _sha3_update (void *c, const uint8_t *in, size_t ilen) { sha3_update (c, in, ilen); }
+static void _sha3_finish (void *c, uint8_t *out) { sha3_finish (c, out); }
+
+static const alg_t algs[] = {
+   { "MD5", 16, _md5_hash, _md5_init, _md5_update, _md5_finish, {
+      "900150983cd24fb0d6963f7d28e17f72",
+      "d41d8cd98f00b204e9800998ecf8427e",
+      "8215ef0796a20bcaaae116d3876c664a",
+      "03dd8807a93175fb062dfb55dc7d359c",
+      "7707d6ae4e027c70eea2a935c2296f21" } },
+   { "SHA-1", 20, _sha1_hash, _sha1_init, _sha1_update, _sha1_finish, {
+      "a9993e364706816aba3e25717850c26c9cd0d89d",
+      "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+      "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+      "a49b2446a02c645bf419f995b67091253a04a259",
+      "34aa973cd4c4daa4f61eeb2bdbad27316534016f" } },
+   { "SHA-224", 28, _sha224_hash, _sha224_init, _sha2_update, _sha2_finish, {
+      "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7",
+      "d14a028c2a3a2bc9476102bb288234c415a2b01f828ea62ac5b3e42f",
+      "75388b16512776cc5dba5da1fd890150b0c6455cb4f58b1952522525",
+      "c97ca9a559850ce97a04a96def6d99a9e0e0e2ab14e6b8df265fc0b3",
+      "20794655980c91d8bbb4c1ea97618a4bf03f42581948b2ee4ee7ad67" } },
+   { "SHA-256", 32, _sha256_hash, _sha256_init, _sha2_update, _sha2_finish, {
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+      "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+      "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" } },
+   { "SHA-384", 48, _sha384_hash, _sha384_init, _sha3_update, _sha3_finish, {
+      "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7",
+      "38b060a751ac96384cd9327eb1b1e36a21fdb71114be07434c0cc7bf63f6e1da274edebfe76f65fbd51ad2f14898b95b",
+      "3391fdddfc8dc7393707a65b1b4709397cf8b1d162af05abfe8f450de5f36bc6b0455a8520bc4e6f5fe95b1fe3c8452b",
+      "09330c33f71147e83d192fc782cd1b4753111b173b3b05d22fa08086e3b0f712fcc7c71a557e2db966c3e9fa91746039",
+      "9d0e1809716474cb086e834e310a4a1ced149e9c00f248527972cec5704c2a5b07b8b3dc38ecc4ebae97ddd87f3d8985" } },
+   { "SHA-512", 64, _sha512_hash, _sha512_init, _sha3_update, _sha3_finish, {
+      "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+      "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e",
+      "204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c33596fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445",
+      "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909",
+      "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b" } },
+};
+#define ALGS   (sizeof (algs) / sizeof (algs[0]))
+
+static uint8_t million[MILLION];
+static uint8_t buf[BENCH];
+
+/*
+ * Hex string to bytes, returns the length
+ */
+static size_t _hex (const char *s, uint8_t *b)
+{
+   size_t n;
+   unsigned int v;
+
+   for (n=0 ; s[2*n] ; ++n) {
+      sscanf (&s[2*n], "%2x", &v);
+      b[n] = (uint8_t)v;
+   }
+   return n;
+}
+
+/*
+ * Hash in chunks. chunk 0 is random chunk sizes from 0 to 2 blocks.
+ */
+static void _chunked (const alg_t *a, const uint8_t *in, size_t ilen, size_t chunk, uint8_t *out)
+{
+   ctx_t ctx;
+   size_t i, k;
+
+   a->init (&ctx);
+   for (i=0 ; i<ilen ; i+=k) {
+      k = (chunk) ? chunk : (size_t)(rand () % 257);
+      if (k > ilen - i)
+         k = ilen - i;
+      a->update (&ctx, &in[i], k);
+   }
+   a->update (&ctx, in, 0);
+   a->finish (&ctx, out);
+}
+
+/*
+ * The vectors one-shot, in 1 byte chunks and in random chunks
+ */
+static int _check_vectors (const alg_t *a)
+{
+   const uint8_t *in;
+   uint8_t  ref[64], out[64];
+   size_t   ilen, m;
+   int      err = 0, e, r;
+
+   for (m=0 ; m<MSGS ; ++m) {
+      in = (msg[m]) ? (const uint8_t*)msg[m] : million;
+      ilen = (msg[m]) ? strlen (msg[m]) : MILLION;
+      _hex (a->v[m], ref);
+      e = 0;
+      a->hash (in, ilen, out);
+      e += (memcmp (out, ref, a->dlen) != 0);
+      _chunked (a, in, ilen, 1, out);
+      e += (memcmp (out, ref, a->dlen) != 0);
+      for (r=0 ; r<4 ; ++r) {
+         _chunked (a, in, ilen, 0, out);
+         e += (memcmp (out, ref, a->dlen) != 0);
+      }
+      if (e)
+         printf ("%s vector %u: %d mismatches\n", a->name, (unsigned)m, e);
+      err += e;
+   }
+   return err;
+}
+
+/*
+ * Every length up to MAXLEN, chunked against one-shot. The lengths cover
+ * the padding that fits in the last block and the one that needs another.
+ */
+static int _check_lengths (const alg_t *a)
+{
+   static uint8_t in[MAXLEN];
+   uint8_t  ref[64], out[64];
+   size_t   n;
+   int      err = 0;
+
+   for (n=0 ; n<MAXLEN ; ++n)
+      in[n] = rand ();
+   for (n=0 ; n<MAXLEN ; ++n) {
+      a->hash (in, n, ref);
+      _chunked (a, in, n, 0, out);
+      err += (memcmp (out, ref, a->dlen) != 0);
+      _chunked (a, in, n, 63, out);
+      err += (memcmp (out, ref, a->dlen) != 0);
+   }
+   if (err)
+      printf ("%s lengths: %d mismatches\n", a->name, err);
+   return err;
+}
+
+/*
+ * sha256_mb() lane by lane against sha256() from the portable rounds, for
+ * 1..MB_MSGS messages of unequal lengths and unaligned starts. sha256_mb()
+ * runs on the multi-buffer lanes, or on the SHA extensions with ni.
+ */
+static int _check_mb (int ni)
+{
+   static uint8_t data[MB_MSGS][MAXLEN+8], dig[MB_MSGS][32];
+   const uint8_t *in[MB_MSGS];
+   uint8_t  *out[MB_MSGS], ref[32];
+   size_t   ilen[MB_MSGS];
+   uint32_t n, i, r;
+   int      err = 0;
+
+   for (r=0 ; r<50 ; ++r) {
+      for (n=1 ; n<=MB_MSGS ; ++n) {
+         for (i=0 ; i<n ; ++i) {
+            switch (rand () % 4) {
+               case 0:  ilen[i] = rand () % 130; break;         // Around the padding
+               case 1:  ilen[i] = 64*(rand () % 8) + 55 + rand () % 3; break;
+               default: ilen[i] = rand () % MAXLEN; break;
+            }
+            in[i] = &data[i][rand () % 8];
+            for (size_t k=0 ; k<ilen[i] ; ++k)
+               ((uint8_t*)in[i])[k] = rand ();
+            out[i] = dig[i];
+         }
+         sha2_ni_enable (ni);
+         sha256_mb (in, ilen, out, n);
+         sha2_ni_enable (0);
+         for (i=0 ; i<n ; ++i) {
+            sha256 ((uint8_t*)in[i], ilen[i], ref);
+            if (memcmp (ref, dig[i], 32) != 0) {
+               if (err < 5)
+                  printf ("sha256_mb%s: lane %u of %u, length %u mismatch\n", (ni) ? " SHA-NI" : "", i, n, (unsigned)ilen[i]);
+               ++err;
+            }
+         }
+      }
+   }
+   return err;
+}
+
+static void _bench (void)
+{
+   const uint8_t *in[SHA2_MB_LANES*8];
+   uint8_t  *out[SHA2_MB_LANES*8], dig[SHA2_MB_LANES*8][32], d[64];
+   size_t   ilen[SHA2_MB_LANES*8], m;
+   uint32_t i, n;
+   double   t0, t1;
+   int      ni;
+
+   for (m=0 ; m<ALGS ; ++m) {
+      t0 = _now ();
+      algs[m].hash (buf, BENCH, d);
+      t1 = _now ();
+      printf ("%-8s %8.1f MB/s\n", algs[m].name, BENCH / (t1-t0) / 1e6);
+   }
+   // SHA-256 backends, one long message and many short ones
+   for (ni=1 ; ni>=0 ; --ni) {
+      if (sha2_ni_enable (ni) != ni)
+         continue;
+      t0 = _now ();
+      sha256 (buf, BENCH, d);
+      t1 = _now ();
+      printf ("SHA-256 %s: one message %8.1f MB/s", (ni) ? "SHA-NI  " : "portable", BENCH / (t1-t0) / 1e6);
+      for (n=SHA2_MB_LANES*8, i=0 ; i<n ; ++i) {
+         ilen[i] = BENCH / n;
+         in[i] = &buf[i * ilen[i]];
+         out[i] = dig[i];
+      }
+      t0 = _now ();
+      sha256_mb (in, ilen, out, n);
+      t1 = _now ();
+      printf (", sha256_mb %8.1f MB/s", BENCH / (t1-t0) / 1e6);
+      for (i=0 ; i<n ; ++i)
+         ilen[i] = 64;
+      t0 = _now ();
+      for (m=0 ; m<4096 ; ++m)
+         sha256_mb (in, ilen, out, n);
+      t1 = _now ();
+      printf (", 64 byte messages %8.1f MB/s\n", 4096.0 * n * 64 / (t1-t0) / 1e6);
+   }
+   sha2_ni_enable (1);
+}
+
+int main (void)
+{
+   int err = 0, ni;
+   size_t m;
+
+   srand (1);
+   memset ((void*)million, 'a', MILLION);
+   for (m=0 ; m<BENCH ; ++m)
+      buf[m] = rand ();
+   for (ni=1 ; ni>=0 ; --ni) {
+      if (sha2_ni_enable (ni) != ni) {
+         printf ("no SHA extensions, only the portable SHA-224/256 is checked\n");
+         continue;
+      }
+      for (m=0 ; m<ALGS ; ++m) {
+         if (ni == 0 && algs[m].init != _sha224_init && algs[m].init != _sha256_init)
+            continue;   // Only SHA-224/256 have two backends
+         err += _check_vectors (&algs[m]);
+         err += _check_lengths (&algs[m]);
+      }
+   }
+   err += _check_mb (0);
+   if (sha2_ni_enable (1))
+      err += _check_mb (1);
+   _bench ();
+   printf ("sha: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+/*!
+ * \file sim_ee_test.c
+ * \brief
+ *    Host test of the simulated EEPROM on a RAM flash stub. It checks the
+ *    reads against a reference image over many page swaps, with and without
+ *    the RAM index, after a re-init and after a format, and measures the
+ *    read latency and the flash reads of each word with the page search
+ *    and with the index.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc sim_ee_test.c ../src/drv/sim_ee.c -o sim_ee_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <drv/sim_ee.h>
+#include "bench.h"
+
+#define PAGE      (4096)      // see page size
+#define SECTOR    (1024)      // Flash erase sector
+#define WORD      (4)
+#define WRITES    (20000)
+#define RUNS      (20)
+
+/*!
+ * RAM flash stub. The writes can only clear bits, as on NOR flash,
+ * and the erase sets the sector to 0xFF.
+ */
+typedef struct {
+   byte_t      mem[2*PAGE];
+   uint32_t    reads;      /*!< Read calls */
+   uint32_t    erases;     /*!< Sector erases */
+   uint32_t    bad;        /*!< Writes that need to set a bit, or out of range */
+}fl_t;
+
+static fl_t       fl;
+static see_t      see;
+static see_idx_t  ix_buf[SEE_INDEX_ENTRIES (PAGE, WORD)];
+static byte_t     ref[PAGE], buf[PAGE];
+static uint32_t   size;
+
+static drv_status_en _fl_read (void *f, see_idx_t a, void *d, int n)
+{
+   fl_t *p = (fl_t*)f;
+
+   ++p->reads;
+   if (a + n > sizeof (p->mem))
+      return DRV_ERROR;
+   memcpy (d, (const void*)&p->mem[a], n);
+   return DRV_READY;
+}
+
+static drv_status_en _fl_write (void *f, see_idx_t a, void *d, int n)
+{
+   fl_t *p = (fl_t*)f;
+   const byte_t *s = (const byte_t*)d;
+
+   if (a + n > sizeof (p->mem)) {
+      ++p->bad;
+      return DRV_ERROR;
+   }
+   for (int i=0 ; i<n ; ++i) {
+      if (s[i] & ~p->mem[a+i])
+         ++p->bad;
+      p->mem[a+i] &= s[i];
+   }
+   return DRV_READY;
+}
+
+static drv_status_en _fl_ioctl (void *f, ioctl_cmd_t cmd, ioctl_buf_t buf)
+{
+   fl_t *p = (fl_t*)f;
+   see_idx_t a;
+
+   switch (cmd) {
+      case CTRL_ERASE_PAGE:
+         a = *(see_idx_t*)buf;
+         if (a % SECTOR || a >= sizeof (p->mem))
+            return DRV_ERROR;
+         memset ((void*)&p->mem[a], 0xFF, SECTOR);
+         ++p->erases;
+         return DRV_READY;
+      default:
+         return DRV_READY;
+   }
+}
+
+static int _init (int indexed)
+{
+   see_deinit (&see);
+   see_link_flash (&see, (void*)&fl);
+   see_link_flash_read (&see, _fl_read);
+   see_link_flash_write (&see, _fl_write);
+   see_link_flash_ioctl (&see, _fl_ioctl);
+   if (indexed)
+      see_link_index (&see, ix_buf, sizeof (ix_buf) / sizeof (ix_buf[0]));
+   see_set_page0_add (&see, 0);
+   see_set_page1_add (&see, PAGE);
+   see_set_page_size (&see, PAGE);
+   see_set_flash_sector_size (&see, SECTOR);
+   see_set_word_size (&see, WORD);
+   see_set_sector_size (&see, 512);
+   if (see_init (&see) != DRV_READY)
+      return 1;
+   size = see.iface.size;
+   return (indexed && !see.index_en);
+}
+
+/*
+ * The whole EEPROM against the reference, word by word and in one read
+ */
+static int _compare (const char *what)
+{
+   int err = 0;
+   uint32_t i;
+
+   for (i=0 ; i<size ; i+=WORD) {
+      memset ((void*)buf, 0, WORD);
+      err += (see_read (&see, i, buf, WORD) != DRV_READY);
+      err += (memcmp (buf, &ref[i], WORD) != 0);
+   }
+   memset ((void*)buf, 0, size);
+   err += (see_read (&see, 1, buf, size - 2) != DRV_READY);    // Unaligned ends
+   err += (memcmp (buf, &ref[1], size - 2) != 0);
+   if (err)
+      printf ("%s: %d mismatches\n", what, err);
+   return err;
+}
+
+/*
+ * Random aligned writes, many page swaps. The reads with the index, with the
+ * page search on the same flash, and with an index rebuilt by a re-init.
+ */
+static int _check (void)
+{
+   int err = 0, w;
+   uint32_t i, idx, n, erases;
+
+   err += _init (1);
+   for (i=0 ; i<size ; ++i)
+      ref[i] = (byte_t)rand ();
+   err += (see_write (&see, 0, ref, size) != DRV_READY);
+   err += _compare ("first write");
+
+   erases = fl.erases;
+   for (w=0 ; w<WRITES ; ++w) {
+      idx = (rand () % (size / WORD)) * WORD;
+      n = (1 + rand () % 4) * WORD;
+      if (idx + n > size)
+         n = size - idx;
+      for (i=0 ; i<n ; ++i)
+         ref[idx+i] = (byte_t)rand ();
+      err += (see_write (&see, idx, &ref[idx], n) != DRV_READY);
+      if (w % 4000 == 3999)
+         err += _compare ("indexed");
+   }
+   if (fl.erases - erases < 10) {
+      printf ("only %u erases, no page swaps\n", fl.erases - erases);
+      ++err;
+   }
+
+   err += _init (0);
+   err += _compare ("page search");
+   err += _init (1);
+   err += _compare ("re-init");
+
+   // After a format the EEPROM is empty and the words read as no data
+   err += (see_ioctl (&see, CTRL_FORMAT, NULL) != DRV_READY);
+   memset ((void*)ref, 0x5A, size);
+   memcpy ((void*)buf, ref, size);
+   err += (see_read (&see, 0, buf, size) != DRV_READY);
+   err += (memcmp (buf, ref, size) != 0);
+   for (i=0 ; i<size ; ++i)
+      ref[i] = (byte_t)rand ();
+   err += (see_write (&see, 0, ref, size) != DRV_READY);
+   err += _compare ("format");
+
+   err += (fl.bad != 0);
+   if (err)
+      printf ("check: %d errors, %u bad flash writes\n", err, fl.bad);
+   return err;
+}
+
+/*
+ * Read latency of a word with a full page, with the page search and
+ * with the index
+ */
+static void _bench (void)
+{
+   double   t0, t[2];
+   uint32_t r[2], i, k;
+   int      ix;
+
+   for (ix=0 ; ix<2 ; ++ix) {
+      _init (ix);
+      fl.reads = 0;
+      t0 = _now ();
+      for (k=0 ; k<RUNS ; ++k)
+         for (i=0 ; i<size ; i+=WORD)
+            see_read (&see, i, buf, WORD);
+      t[ix] = _now () - t0;
+      r[ix] = fl.reads;
+   }
+   k = RUNS * size / WORD;
+   printf ("word read, page search: %8.1f ns %6.1f flash reads\n", t[0] * 1e9 / k, (double)r[0] / k);
+   printf ("word read, RAM index:   %8.1f ns %6.1f flash reads\n", t[1] * 1e9 / k, (double)r[1] / k);
+}
+
+int main (void)
+{
+   int err = 0;
+
+   srand (1);
+   memset ((void*)fl.mem, 0, sizeof (fl.mem));   // Unformatted flash
+   err += _check ();
+   _bench ();
+   printf ("sim_ee: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+/*!
+ * \file spa_batch_test.c
+ * \brief
+ *    Host test of the Grena and PSA batch kernels. For a few sites it runs
+ *    spa_grena_calculation_n() and psa_calculate_n() over a year at 1 minute
+ *    steps, checks them against the scalar spa_grena_calculation() and
+ *    psa_calculate(), and asserts the maximum zenith and azimuth error
+ *    against the NREL spa_calculate() while the sun is up. Then it measures
+ *    positions/s of the scalar against the batch kernels.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc spa_batch_test.c ../src/algo/spa_grena.c ../src/algo/psa.c ../src/algo/spa.c ../src/std/stime.c ../src/math/math.c -lm -o spa_batch_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algo/spa.h>
+#include <algo/spa_grena.h>
+#include <algo/psa.h>
+#include "bench.h"
+
+#define YEAR0     (1704067200)      // 2024-01-01 00:00 UTC
+#define POINTS    (365*1440)        // A year at 1 minute steps
+#define DELTA_T   (69.2)            // TT - UT [sec]
+
+#define R2D       (180.0/M_PI)
+
+/*
+ * Maximum errors in degrees. The batch against the scalar code, and the
+ * algorithms against NREL SPA, Grena under 87 deg zenith and PSA under
+ * 80 deg, as PSA has no refraction model. The azimuth is checked from
+ * AZ_ZEN_MIN, as near the zenith any position error turns into azimuth.
+ */
+#define TOL_BATCH       (1e-8)
+#define TOL_GRENA_ZEN   (0.01)
+#define TOL_GRENA_AZ    (0.03)
+#define TOL_PSA_ZEN     (0.12)
+#define TOL_PSA_AZ      (0.05)
+#define AZ_ZEN_MIN      (15)
+
+typedef struct {
+   const char *name;
+   double lon, lat;
+}site_t;
+
+static const site_t sites[] = {
+   { "Athens",     23.7,   38.0 },
+   { "Sydney",    151.2,  -33.9 },
+   { "Golden",   -105.18,  39.74 },
+};
+
+static double  njd[POINTS], jd[POINTS];
+static double  g_az[POINTS], g_el[POINTS], p_zen[POINTS], p_az[POINTS];
+
+/*
+ * Azimuth difference in degrees, in [0, 180]
+ */
+static double _daz (double a, double b)
+{
+   double d = fmod (fabs (a - b), 360);
+   return (d > 180) ? 360 - d : d;
+}
+
+static int _report (const char *site, const char *what, double e, double tol)
+{
+   printf ("   %-24s %10.3g deg\n", what, e);
+   if (e <= tol)
+      return 0;
+   printf ("%s, %s: error %g > %g\n", site, what, e, tol);
+   return 1;
+}
+
+static int _check (const site_t *st)
+{
+   spa_t          s;
+   spa_output_t   r;
+   spa_grena_t    g;
+   psa_t          p;
+   sun_pos_t      gs;
+   psa_output_t   ps;
+   time_t         utc;
+   uint32_t       i;
+   double eg_b=0, ep_b=0, eg_z=0, eg_a=0, ep_z=0, ep_a=0;
+   int err = 0;
+
+   memset ((void*)&s, 0, sizeof (s));
+   memset ((void*)&g, 0, sizeof (g));
+   memset ((void*)&p, 0, sizeof (p));
+   spa_set_location (&s, st->lon, st->lat, 0, 0, 0);
+   spa_set_atmos (&s, 1013.25, 20, 0.5667);
+   spa_grena_set_longitude (&g, st->lon);
+   spa_grena_set_latitude (&g, st->lat);
+   spa_grena_init (&g);
+   g.delta_t = DELTA_T;
+   psa_set_location (&p, st->lon, st->lat);
+
+   // The batch kernels
+   for (i=0 ; i<POINTS ; ++i) {
+      njd[i] = spa_grena_njd (YEAR0 + 60*(time_t)i);
+      jd[i]  = psa_jd (YEAR0 + 60*(time_t)i);
+   }
+   spa_grena_calculation_n (&g, njd, g_az, g_el, POINTS);
+   psa_calculate_n (&p, jd, p_zen, p_az, POINTS);
+
+   printf ("%s, %.2f %.2f\n", st->name, st->lon, st->lat);
+   for (i=0 ; i<POINTS ; ++i) {
+      utc = YEAR0 + 60*(time_t)i;
+
+      // Batch against the scalar code
+      spa_grena_set_time (&g, utc, DELTA_T);
+      gs = spa_grena_calculation (&g);
+      if (fabs (gs.elev - g_el[i]) * R2D > eg_b)         eg_b = fabs (gs.elev - g_el[i]) * R2D;
+      if (_daz (gs.azimuth*R2D, g_az[i]*R2D) > eg_b)     eg_b = _daz (gs.azimuth*R2D, g_az[i]*R2D);
+      psa_set_time (&p, utc);
+      ps = psa_calculate (&p);
+      if (fabs (ps.zenith - p_zen[i]) * R2D > ep_b)      ep_b = fabs (ps.zenith - p_zen[i]) * R2D;
+      if (_daz (ps.azimuth*R2D, p_az[i]*R2D) > ep_b)     ep_b = _daz (ps.azimuth*R2D, p_az[i]*R2D);
+
+      // Batch against NREL SPA
+      spa_set_time (&s, utc, 0, DELTA_T, 0);
+      r = spa_calculate (&s, SPA_ZA);
+      if (r.zenith < 87) {
+         if (fabs (90 - g_el[i]*R2D - r.zenith) > eg_z)  eg_z = fabs (90 - g_el[i]*R2D - r.zenith);
+         if (r.zenith > AZ_ZEN_MIN && _daz (g_az[i]*R2D, r.azimuth) > eg_a)
+            eg_a = _daz (g_az[i]*R2D, r.azimuth);
+      }
+      if (r.zenith < 80) {
+         if (fabs (p_zen[i]*R2D - r.zenith) > ep_z)      ep_z = fabs (p_zen[i]*R2D - r.zenith);
+         if (r.zenith > AZ_ZEN_MIN && _daz (p_az[i]*R2D, r.azimuth) > ep_a)
+            ep_a = _daz (p_az[i]*R2D, r.azimuth);
+      }
+   }
+   err += _report (st->name, "grena batch vs scalar", eg_b, TOL_BATCH);
+   err += _report (st->name, "grena zenith vs spa", eg_z, TOL_GRENA_ZEN);
+   err += _report (st->name, "grena azimuth vs spa", eg_a, TOL_GRENA_AZ);
+   err += _report (st->name, "psa batch vs scalar", ep_b, TOL_BATCH);
+   err += _report (st->name, "psa zenith vs spa", ep_z, TOL_PSA_ZEN);
+   err += _report (st->name, "psa azimuth vs spa", ep_a, TOL_PSA_AZ);
+   return err;
+}
+
+/*
+ * Positions per second, the scalar calculation per time stamp against one
+ * batch call for the year. The day numbers are ready in both cases.
+ */
+static void _bench (const site_t *st)
+{
+   spa_grena_t g;
+   psa_t       p;
+   sun_pos_t   gs;
+   psa_output_t ps;
+   double      t0, t, sum = 0;
+   uint32_t    i;
+
+   memset ((void*)&g, 0, sizeof (g));
+   memset ((void*)&p, 0, sizeof (p));
+   spa_grena_set_longitude (&g, st->lon);
+   spa_grena_set_latitude (&g, st->lat);
+   spa_grena_init (&g);
+   g.delta_t = DELTA_T;
+   psa_set_location (&p, st->lon, st->lat);
+   for (i=0 ; i<POINTS ; ++i) {
+      njd[i] = spa_grena_njd (YEAR0 + 60*(time_t)i);
+      jd[i]  = psa_jd (YEAR0 + 60*(time_t)i);
+   }
+   printf ("%-8s %16s %16s\n", "", "scalar", "batch");
+
+   t0 = _now ();
+   for (i=0 ; i<POINTS ; ++i) {
+      g.njd = njd[i];
+      gs = spa_grena_calculation (&g);
+      sum += gs.elev;
+   }
+   t = _now () - t0;
+   t0 = _now ();
+   spa_grena_calculation_n (&g, njd, g_az, g_el, POINTS);
+   printf ("%-8s %11.2f Mpos/s %11.2f Mpos/s\n", "grena", POINTS / t * 1e-6, POINTS / (_now () - t0) * 1e-6);
+
+   t0 = _now ();
+   for (i=0 ; i<POINTS ; ++i) {
+      p.t.jd = jd[i];
+      p.t.dec_hour = fmod (jd[i] + 0.5, 1.0) * 24;
+      ps = psa_calculate (&p);
+      sum += ps.zenith;
+   }
+   t = _now () - t0;
+   t0 = _now ();
+   psa_calculate_n (&p, jd, p_zen, p_az, POINTS);
+   printf ("%-8s %11.2f Mpos/s %11.2f Mpos/s\n", "psa", POINTS / t * 1e-6, POINTS / (_now () - t0) * 1e-6);
+   if (sum == 0)  // Keep the scalar loops
+      printf ("\n");
+}
+
+int main (void)
+{
+   int err = 0;
+   size_t i;
+
+   for (i=0 ; i<sizeof (sites) / sizeof (sites[0]) ; ++i)
+      err += _check (&sites[i]);
+   _bench (&sites[0]);
+   printf ("spa_batch: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
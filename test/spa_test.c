@@ -0,0 +1,163 @@
+/*!
+ * \file spa_test.c
+ * \brief
+ *    Host test of the NREL solar position algorithm. It checks the NREL
+ *    reference case, that spa_calculate_batch() gives the same results as
+ *    spa_calculate() for each point, and measures the batch on 10k sites
+ *    over the 1440 minutes of a day against spa_calculate() per point.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc spa_test.c ../src/algo/spa.c ../src/std/stime.c -lm -o spa_test
+ *    (add -fopenmp to spread the sites of the batch over the cores)
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algo/spa.h>
+#include "bench.h"
+
+#define SITES     (10000)
+#define TIMES     (1440)      // The minutes of a day
+#define CHUNK     (60)        // Time stamps of each batch call
+#define STRIDE    (101)       // Sites checked against spa_calculate()
+
+static spa_t         site[SITES];
+static spa_time_t    tm[TIMES];
+static spa_output_t  out[CHUNK * SITES];
+
+static double _rnd (double a, double b) {
+   return a + (b - a) * rand () / RAND_MAX;
+}
+
+/*
+ * The same fields, bit for bit, for the outputs of fun
+ */
+static int _same (const spa_output_t *a, const spa_output_t *b, spa_func_en fun)
+{
+   int d = 0;
+
+   d += memcmp (&a->zenith, &b->zenith, sizeof (double)) != 0;
+   d += memcmp (&a->azimuth, &b->azimuth, sizeof (double)) != 0;
+   d += memcmp (&a->azimuth_astro, &b->azimuth_astro, sizeof (double)) != 0;
+   if (fun == SPA_ZA_INC || fun == SPA_ALL)
+      d += memcmp (&a->incidence, &b->incidence, sizeof (double)) != 0;
+   if (fun == SPA_ZA_RTS || fun == SPA_ALL) {
+      d += memcmp (&a->sunrise, &b->sunrise, sizeof (double)) != 0;
+      d += memcmp (&a->suntransit, &b->suntransit, sizeof (double)) != 0;
+      d += memcmp (&a->sunset, &b->sunset, sizeof (double)) != 0;
+   }
+   return d != 0;
+}
+
+/*
+ * The reference case of the NREL SPA report, 2003-10-17 12:30:30 -7h at
+ * Golden CO, with spa_calculate() and a batch of one
+ */
+static int _check_nrel (void)
+{
+   spa_t s;
+   spa_output_t r[2];
+   int err = 0, i;
+
+   memset ((void*)&s, 0, sizeof (s));
+   s.utc = (spa_time_t){ 2003, 10, 17, 12, 30, 30, 0, 67, -7 };
+   spa_set_location (&s, -105.1786, 39.742476, 1830.14, 30, -10);
+   spa_set_atmos (&s, 820, 11, 0.5667);
+   r[0] = spa_calculate (&s, SPA_ALL);
+   spa_calculate_batch (&s.utc, 1, &s, 1, SPA_ALL, &r[1]);
+   for (i=0 ; i<2 ; ++i) {
+      err += (fabs (r[i].zenith - 50.11162) > 1e-5);
+      err += (fabs (r[i].azimuth - 194.34024) > 1e-5);
+      err += (fabs (r[i].incidence - 25.18700) > 1e-5);
+      err += (fabs (r[i].sunrise - 6.212067) > 1e-6);
+      err += (fabs (r[i].suntransit - 11.768045) > 1e-6);
+      err += (fabs (r[i].sunset - 17.338667) > 1e-6);
+   }
+   err += _same (&r[0], &r[1], SPA_ALL);
+   if (err)
+      printf ("NREL reference: %d errors, zenith %.6f azimuth %.6f incidence %.6f rts %.6f %.6f %.6f\n",
+              err, r[0].zenith, r[0].azimuth, r[0].incidence, r[0].sunrise, r[0].suntransit, r[0].sunset);
+   return err;
+}
+
+/*
+ * The batch of all the sites and the minutes of the day, in CHUNK time
+ * stamps per call. Each STRIDE-th site against spa_calculate().
+ */
+static int _check_batch (void)
+{
+   spa_output_t   r;
+   double         tb = 0, ts = 0, t0;
+   uint32_t       t, s, c, n = 0;
+   int            err = 0;
+
+   for (c=0 ; c<TIMES ; c+=CHUNK) {
+      t0 = _now ();
+      spa_calculate_batch (&tm[c], CHUNK, site, SITES, SPA_ZA_INC, out);
+      tb += _now () - t0;
+
+      t0 = _now ();
+      for (t=0 ; t<CHUNK ; ++t) {
+         for (s=(c+t)%STRIDE ; s<SITES ; s+=STRIDE, ++n) {
+            site[s].utc = tm[c+t];
+            r = spa_calculate (&site[s], SPA_ZA_INC);
+            err += _same (&r, &out[t*SITES + s], SPA_ZA_INC);
+         }
+      }
+      ts += _now () - t0;
+   }
+   printf ("batch %u sites x %u times: %.2f s, %.1f ns/point\n", SITES, TIMES, tb, tb * 1e9 / ((double)SITES * TIMES));
+   printf ("spa_calculate:                  %.1f ns/point, %.1fx\n", ts * 1e9 / n, (ts / n) / (tb / ((double)SITES * TIMES)));
+
+   // Sun rise/transit/set on some hours
+   for (t=0 ; t<TIMES ; t+=CHUNK) {
+      spa_calculate_batch (&tm[t], 1, site, SITES / 10, SPA_ALL, out);
+      for (s=0 ; s<SITES / 10 ; ++s) {
+         site[s].utc = tm[t];
+         r = spa_calculate (&site[s], SPA_ALL);
+         err += _same (&r, &out[s], SPA_ALL);
+      }
+   }
+   if (err)
+      printf ("batch: %d points differ from spa_calculate\n", err);
+   return err;
+}
+
+int main (void)
+{
+   spa_t    tmp;
+   uint32_t i;
+   int      err = 0;
+
+   srand (1);
+   for (i=0 ; i<SITES ; ++i) {
+      memset ((void*)&site[i], 0, sizeof (site[i]));
+      spa_set_location (&site[i], _rnd (-180, 180), _rnd (-89, 89), _rnd (0, 4000), _rnd (0, 60), _rnd (-180, 180));
+      spa_set_atmos (&site[i], _rnd (600, 1030), _rnd (-20, 40), 0.5667);
+   }
+   for (i=0 ; i<TIMES ; ++i) {
+      err += (spa_set_time (&tmp, 1718928000 + 60*i, 0, 69.2, 0) != DRV_READY);    // 2024-06-21
+      tm[i] = tmp.utc;
+   }
+   err += _check_nrel ();
+   err += _check_batch ();
+   printf ("spa: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
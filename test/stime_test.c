@@ -0,0 +1,180 @@
+/*!
+ * \file stime_test.c
+ * \brief
+ *    Host test of the civil date conversion. It walks every day of the
+ *    years 1 to 9999 with a calendar counter and checks sgmtime_r(), the
+ *    array versions and the round trip of smktime() against it, checks the
+ *    round trip on every day up to year 200000, the times of day and the
+ *    times before 1970, and measures the conversion rates.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc stime_test.c ../src/std/stime.c -o stime_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <std/stime.h>
+#include "bench.h"
+
+#define SPD       (86400)
+#define LAST_YEAR (200000)    // Last year of the round trip
+#define BENCH     (1 << 20)
+
+static time_t     tt[BENCH], tt2[BENCH];
+static struct tm  tb[BENCH];
+
+static int _mdays (int y, int m)
+{
+   static const int md[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+   return md[m] + (m == 1 && isleap (y));
+}
+
+/*
+ * The days from 1970-01-01 to 0001-01-01
+ */
+static time_t _day_of_year1 (void)
+{
+   time_t d = 0;
+   for (int y=1 ; y<1970 ; ++y)
+      d -= 365 + isleap (y);
+   return d;
+}
+
+static int _cmp (const struct tm *a, const struct tm *b)
+{
+   return a->tm_year != b->tm_year || a->tm_mon != b->tm_mon || a->tm_mday != b->tm_mday
+       || a->tm_yday != b->tm_yday || a->tm_wday != b->tm_wday
+       || a->tm_hour != b->tm_hour || a->tm_min != b->tm_min || a->tm_sec != b->tm_sec
+       || a->tm_isdst != 0;
+}
+
+/*
+ * Every day of the years 1 to 9999 against a calendar counter, with a
+ * random time of the day. The array versions in blocks of BENCH days.
+ */
+static int _check_walk (void)
+{
+   struct tm   ref, tm;
+   time_t      d, t;
+   int         err = 0, e, y, m, md, yd, wd, n = 0, s;
+
+   d = _day_of_year1 ();
+   wd = 1;                 // 0001-01-01 was Monday
+   memset ((void*)&ref, 0, sizeof (ref));
+   for (y=1 ; y<=9999 ; ++y) {
+      for (yd=0, m=0 ; m<12 ; ++m) {
+         for (md=1 ; md<=_mdays (y, m) ; ++md, ++yd, ++d, wd = (wd + 1) % 7) {
+            s = rand () % SPD;
+            t = d * SPD + s;
+            ref.tm_year = _YEAR_2_TM_YEAR (y);
+            ref.tm_mon  = m;
+            ref.tm_mday = md;
+            ref.tm_yday = yd;
+            ref.tm_wday = wd;
+            ref.tm_hour = s / 3600;
+            ref.tm_min  = s / 60 % 60;
+            ref.tm_sec  = s % 60;
+
+            e  = (sgmtime_r (&t, &tm) != &tm);
+            e += _cmp (&tm, &ref);
+            e += (smktime (&ref) != t);
+            if (e && n++ < 5)
+               printf ("%04d-%02d-%02d: %d-%d-%d wday %d yday %d\n", y, m+1, md,
+                       _TM_YEAR_2_YEAR (tm.tm_year), tm.tm_mon+1, tm.tm_mday, tm.tm_wday, tm.tm_yday);
+            err += e;
+         }
+      }
+   }
+   t = -1;
+   err += _cmp (sgmtime (&t), &(struct tm){ .tm_year=69, .tm_mon=11, .tm_mday=31,
+                .tm_yday=364, .tm_wday=3, .tm_hour=23, .tm_min=59, .tm_sec=59 });
+
+   // Array versions on the same days, before and after 1970
+   for (t=_day_of_year1 () * SPD ; t < (time_t)2932897 * SPD ; t += (time_t)BENCH * SPD) {
+      for (int i=0 ; i<BENCH ; ++i)
+         tt[i] = t + (time_t)i * SPD + rand () % SPD;
+      sgmtime_n (tt, tb, BENCH);
+      smktime_n (tb, tt2, BENCH);
+      for (int i=0 ; i<BENCH ; ++i) {
+         sgmtime_r (&tt[i], &tm);
+         err += _cmp (&tb[i], &tm);
+         err += (tt2[i] != tt[i]);
+      }
+   }
+   if (err)
+      printf ("walk: %d errors\n", err);
+   return err;
+}
+
+/*
+ * smktime (sgmtime_r (t)) == t and a monotonic date on every day up to
+ * LAST_YEAR
+ */
+static int _check_round_trip (void)
+{
+   struct tm   tm, pr;
+   time_t      t;
+   int         err = 0;
+
+   t = _day_of_year1 () * SPD + SPD - 1;
+   sgmtime_r (&t, &pr);
+   for ( ; ; pr = tm) {
+      t += SPD;
+      sgmtime_r (&t, &tm);
+      if (_TM_YEAR_2_YEAR (tm.tm_year) > LAST_YEAR)
+         break;
+      err += (smktime (&tm) != t);
+      err += (tm.tm_wday != (pr.tm_wday + 1) % 7);
+      if (tm.tm_mday == 1)
+         err += (tm.tm_mon != (pr.tm_mon + 1) % 12 || pr.tm_mday != _mdays (_TM_YEAR_2_YEAR (pr.tm_year), pr.tm_mon));
+      else
+         err += (tm.tm_mon != pr.tm_mon || tm.tm_mday != pr.tm_mday + 1);
+   }
+   if (err)
+      printf ("round trip: %d errors\n", err);
+   return err;
+}
+
+static void _bench (void)
+{
+   double t0, t1, t2;
+
+   for (int i=0 ; i<BENCH ; ++i)
+      tt[i] = ((time_t)rand () << 8) ^ rand ();
+   t0 = _now ();
+   sgmtime_n (tt, tb, BENCH);
+   t1 = _now ();
+   smktime_n (tb, tt2, BENCH);
+   t2 = _now ();
+   printf ("sgmtime_n: %6.1f Mconv/s\n", BENCH / (t1-t0) * 1e-6);
+   printf ("smktime_n: %6.1f Mconv/s\n", BENCH / (t2-t1) * 1e-6);
+}
+
+int main (void)
+{
+   int err = 0;
+
+   srand (1);
+   err += _check_walk ();
+   err += _check_round_trip ();
+   _bench ();
+   printf ("stime: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+/*!
+ * \file twheel_test.c
+ * \brief
+ *    Host test of the timer wheel. It checks tw_next() against the
+ *    earliest pending expiry and the expire ticks of the fired timers.
+ *    Then it times N inserts, cancels and expirations on the simulated
+ *    timer counter and prints the operations per second.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc twheel_test.c ../src/sys/twheel.c ../src/drv/sim_tim.c -o twheel_test
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/twheel.h>
+#include <drv/sim_tim.h>
+
+#define TIMERS    (64)
+#define STEPS     (200000)
+#define TIM_FREQ  (100000000)   // Counter of the timing, 100 MHz
+#define BENCH_MAX (1000000)
+
+static tw_t       w;
+static tw_timer_t tm[TIMERS];
+static int        late;
+static tw_timer_t bt[BENCH_MAX];
+static uint32_t   fired;
+
+/*
+ * Each timer must fire on its expire tick
+ */
+static void _cb (void *arg)
+{
+   tw_timer_t *t = (tw_timer_t*)arg;
+   uint64_t   e = t->expires - t->period;   // Periodic ones are already moved
+
+   if (tw_now (&w) != e)
+      ++late;
+}
+
+/*
+ * The earliest pending expiry, passed ones expire on the next tick
+ */
+static uint64_t _earliest (void)
+{
+   uint64_t e = UINT64_MAX;
+
+   for (int i=0 ; i<TIMERS ; ++i)
+      if (tw_pending (&tm[i]) && tm[i].expires < e)
+         e = tm[i].expires;
+   if (e != UINT64_MAX && e <= tw_now (&w))
+      e = tw_now (&w) + 1;
+   return e;
+}
+
+/*
+ * tw_next() must not pass the earliest expiry, and the wheel must
+ * have nothing to fire before tw_next()
+ */
+static int _check_next (void)
+{
+   uint64_t n = tw_next (&w), e = _earliest ();
+
+   if (n > e) {
+      printf ("tw_next: %llu, earliest: %llu at tick %llu\n",
+         (unsigned long long)n, (unsigned long long)e, (unsigned long long)tw_now (&w));
+      return 1;
+   }
+   if (n != UINT64_MAX && n > tw_now (&w) + 1 && tw_advance (&w, n - 1) != 0) {
+      printf ("timers fired before tw_next: %llu\n", (unsigned long long)n);
+      return 1;
+   }
+   return 0;
+}
+
+static void _count (void *arg) {
+   (void)arg;
+   ++fired;
+}
+
+/*
+ * Seconds on the simulated counter since the last call. It follows the
+ * host clock.
+ */
+static double _lap (void)
+{
+   static uint64_t last;
+   uint64_t t;
+
+   sim_tim_read ();
+   t = sim_tim_ticks ();
+   t -= last;
+   last += t;
+   return (double)t / TIM_FREQ;
+}
+
+/*
+ * N timers with delays up to 2^20 ticks. Half of them are cancelled in
+ * random order and the rest expire with tickless advances.
+ */
+static int _bench (uint32_t n)
+{
+   uint32_t i, j, x, *ord = malloc (n * sizeof (uint32_t));
+   double   ti, tc, te;
+
+   if (!ord)
+      return 1;
+   for (i=0 ; i<n ; ++i)
+      ord[i] = i;
+   for (i=n-1 ; i>0 ; --i) {
+      j = (uint32_t)rand () % (i+1);
+      x = ord[i]; ord[i] = ord[j]; ord[j] = x;
+   }
+   tw_init (&w, 0);
+   fired = 0;
+
+   _lap ();
+   for (i=0 ; i<n ; ++i)
+      tw_add (&w, &bt[i], 1 + ((uint32_t)rand () & 0xFFFFF), 0, _count, 0);
+   ti = _lap ();
+   for (i=0 ; i<n/2 ; ++i)
+      tw_del (&w, &bt[ord[i]]);
+   tc = _lap ();
+   while (tw_next (&w) != UINT64_MAX)
+      tw_advance (&w, tw_next (&w));
+   te = _lap ();
+   free (ord);
+
+   printf ("%8u timers: insert %6.2f Mops/s, cancel %6.2f Mops/s, expire %6.2f Mops/s\n", n,
+           n / ti * 1e-6, n/2 / tc * 1e-6, fired / te * 1e-6);
+   return fired != n - n/2;
+}
+
+int main (void)
+{
+   int      err = 0, i;
+   uint32_t r;
+
+   // The level 0 wrap case
+   tw_init (&w, 0);
+   tw_add_at (&w, &tm[0], 100, 0, _cb, &tm[0]);
+   tw_advance (&w, 63);
+   tw_add_at (&w, &tm[1], 120, 0, _cb, &tm[1]);
+   if (tw_next (&w) > 100) {
+      printf ("wrap: tw_next: %llu, expected <= 100\n", (unsigned long long)tw_next (&w));
+      ++err;
+   }
+   tw_del (&w, &tm[0]);
+   tw_del (&w, &tm[1]);
+
+   // Random timers and steps
+   srand (1);
+   tw_init (&w, 12345);
+   for (i=0 ; i<STEPS && !err ; ++i) {
+      tw_timer_t *t = &tm[rand () % TIMERS];
+
+      r = (uint32_t)rand ();
+      switch (r % 4) {
+         case 0:
+            tw_add (&w, t, 1 + (r >> 2) % ((r & 0x400) ? 300000 : 200), 0, _cb, t);
+            break;
+         case 1:
+            tw_add (&w, t, 1 + (r >> 2) % 5000, 1 + (r >> 8) % 3000, _cb, t);
+            break;
+         case 2:
+            tw_del (&w, t);
+            break;
+         default:
+            if (tw_next (&w) != UINT64_MAX && (r & 1))
+               tw_advance (&w, tw_next (&w));         // Tickless sleep
+            else
+               tw_advance (&w, tw_now (&w) + (r >> 2) % 700);
+            break;
+      }
+      err += _check_next ();
+   }
+   if (late) {
+      printf ("%d timers fired off their expire tick\n", late);
+      ++err;
+   }
+
+   sim_tim_setfreq (TIM_FREQ, 0xFFFF);
+   for (uint32_t n=1000 ; n<=BENCH_MAX ; n*=10)
+      err += _bench (n);
+   printf ("twheel: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}
@@ -0,0 +1,445 @@
+/*!
+ * \file vectors_test.c
+ * \brief
+ *    Host test of the vector kernels. A table of every vadd/vsub/vemul/vediv/vdot
+ *    variant checks each kernel against a plain scalar loop for head offsets
+ *    0..3 and short and odd lengths, and times each kernel against its scalar
+ *    loop. The complex division is also checked against the C complex division
+ *    over the whole exponent range.
+ *
+ *    gcc -std=gnu11 -O2 -I../inc vectors_test.c ../src/dsp/vectors.c -lm -o vectors_test
+ *
+ *    The kernels run their AVX2 clone where the CPU has it. Build a second
+ *    time with -DTBX_NO_SIMD_CLONES to check the baseline vector code.
+ *
+ * This file is part of toolbox
+ *
+ * Copyright (C) 2014 Houtouridis Christos (http://www.houtouridis.net)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dsp/vectors.h>
+#include "bench.h"
+
+#define N         (1027)      // Odd, to exercise the tails
+#define OFS       (4)         // Head offsets checked, 0..OFS-1
+#define DIVS      (200000)
+#define RUNS      (2000)
+
+/*!
+ * Element types of the kernels
+ */
+typedef enum {
+   T_I32=0, T_UI32, T_F, T_D, T_CI, T_CF, T_CD, T_NUM
+}type_en;
+
+typedef enum {
+   OP_ADD=0, OP_SUB, OP_MUL, OP_DIV, OP_DOT
+}op_en;
+
+typedef void (*ew_fn) (void *y, void *a, void *b, int length);
+typedef int (*div_fn) (void *y, void *a, void *b, int length);
+
+/*!
+ * One kernel of the table
+ */
+typedef struct {
+   const char  *name;
+   op_en       op;
+   type_en     t;
+   void        (*fn) (void);
+}kernel_t;
+
+#define _K(_op, _f, _t)    { #_f, _op, _t, (void (*)(void))_f }
+
+static const kernel_t kernels[] = {
+   _K (OP_ADD, vadd_i32, T_I32),  _K (OP_ADD, vadd_ui32, T_UI32), _K (OP_ADD, vadd_f, T_F),
+   _K (OP_ADD, vadd_d, T_D),      _K (OP_ADD, vadd_ci, T_CI),     _K (OP_ADD, vadd_cf, T_CF),
+   _K (OP_ADD, vadd_cd, T_CD),
+   _K (OP_SUB, vsub_i32, T_I32),  _K (OP_SUB, vsub_ui32, T_UI32), _K (OP_SUB, vsub_f, T_F),
+   _K (OP_SUB, vsub_d, T_D),      _K (OP_SUB, vsub_ci, T_CI),     _K (OP_SUB, vsub_cf, T_CF),
+   _K (OP_SUB, vsub_cd, T_CD),
+   _K (OP_MUL, vemul_i, T_I32),   _K (OP_MUL, vemul_f, T_F),      _K (OP_MUL, vemul_d, T_D),
+   _K (OP_MUL, vemul_ci, T_CI),   _K (OP_MUL, vemul_cf, T_CF),    _K (OP_MUL, vemul_cd, T_CD),
+   _K (OP_DIV, vediv_i, T_I32),   _K (OP_DIV, vediv_f, T_F),      _K (OP_DIV, vediv_d, T_D),
+   _K (OP_DIV, vediv_ci, T_CI),   _K (OP_DIV, vediv_cf, T_CF),    _K (OP_DIV, vediv_cd, T_CD),
+   _K (OP_DOT, vdot_i32, T_I32),  _K (OP_DOT, vdot_ui32, T_UI32), _K (OP_DOT, vdot_f, T_F),
+   _K (OP_DOT, vdot_d, T_D),      _K (OP_DOT, vdot_ci, T_CI),     _K (OP_DOT, vdot_cf, T_CF),
+   _K (OP_DOT, vdot_cd, T_CD),
+};
+
+static const int lengths[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 65, 100, N-OFS };
+
+static int32_t       ai[N], bi[N], yi[N], ri[N];
+static uint32_t      au[N], bu[N], yu[N], ru[N];
+static float         af[N], bf[N], yf[N], rf[N];
+static double        ad[N], bd[N], yd[N], rd[N];
+static complex_i_t   aci[N], bci[N], yci[N], rci[N];
+static complex_f_t   acf[N], bcf[N], ycf[N], rcf[N];
+static complex_d_t   acd[N], bcd[N], ycd[N], rcd[N];
+
+/*!
+ * The operands, the kernel output and the reference output of each type
+ */
+static struct {
+   void     *a, *b, *y, *r;
+   size_t   size;
+}buf[T_NUM] = {
+   { ai, bi, yi, ri, sizeof (ai[0]) },    { au, bu, yu, ru, sizeof (au[0]) },
+   { af, bf, yf, rf, sizeof (af[0]) },    { ad, bd, yd, rd, sizeof (ad[0]) },
+   { aci, bci, yci, rci, sizeof (aci[0]) }, { acf, bcf, ycf, rcf, sizeof (acf[0]) },
+   { acd, bcd, ycd, rcd, sizeof (acd[0]) },
+};
+
+static double _rnd (void) {
+   return (double)rand () / RAND_MAX * 2 - 1;
+}
+
+/*
+ * A random number with its binary exponent in [-e, e]
+ */
+static double _rnd_exp (int e) {
+   return ldexp (_rnd (), rand () % (2*e+1) - e);
+}
+
+/*
+ * A non zero random integer in [-m, m]
+ */
+static int _rnd_nz (int m) {
+   int v = rand () % (2*m+1) - m;
+   return (v) ? v : 1;
+}
+
+/*
+ * Relative error in the norm of the result
+ */
+static double _cerr (complex_d_t y, complex_d_t ref) {
+   return cabs (y - ref) / cabs (ref);
+}
+
+/*
+ * ========= Scalar references =========
+ * Plain loops with the vectoriser off, so they are both the reference and
+ * the baseline of the timing.
+ */
+#define __SCALAR__   __attribute__ ((noinline, optimize ("no-tree-vectorize")))
+
+#define _ew_loop(_t, _expr)                                    \
+   _t *y = (_t*)vy, *a = (_t*)va, *b = (_t*)vb;               \
+   for (int i=0 ; i<n ; ++i)  y[i] = _expr;
+
+#define _ew_loop_c(_t, _st, _r, _i, _er, _ei)                  \
+   _t *y = (_t*)vy, *a = (_t*)va, *b = (_t*)vb;               \
+   for (int i=0 ; i<n ; ++i) {                                 \
+      _st ar = _r(a[i]), ax = _i(a[i]), br = _r(b[i]), bx = _i(b[i]); \
+      _r(y[i]) = _er;                                          \
+      _i(y[i]) = _ei;                                          \
+   }
+
+__SCALAR__ static void _scalar_ew (op_en op, type_en t, void *vy, void *va, void *vb, int n)
+{
+   switch (t) {
+      case T_I32:
+         if (op == OP_ADD)       { _ew_loop (int32_t, a[i] + b[i]); }
+         else if (op == OP_SUB)  { _ew_loop (int32_t, a[i] - b[i]); }
+         else if (op == OP_MUL)  { _ew_loop (int32_t, a[i] * b[i]); }
+         else                    { _ew_loop (int32_t, a[i] / b[i]); }
+         break;
+      case T_UI32:
+         if (op == OP_ADD)       { _ew_loop (uint32_t, a[i] + b[i]); }
+         else                    { _ew_loop (uint32_t, a[i] - b[i]); }
+         break;
+      case T_F:
+         if (op == OP_ADD)       { _ew_loop (float, a[i] + b[i]); }
+         else if (op == OP_SUB)  { _ew_loop (float, a[i] - b[i]); }
+         else if (op == OP_MUL)  { _ew_loop (float, a[i] * b[i]); }
+         else                    { _ew_loop (float, a[i] / b[i]); }
+         break;
+      case T_D:
+         if (op == OP_ADD)       { _ew_loop (double, a[i] + b[i]); }
+         else if (op == OP_SUB)  { _ew_loop (double, a[i] - b[i]); }
+         else if (op == OP_MUL)  { _ew_loop (double, a[i] * b[i]); }
+         else                    { _ew_loop (double, a[i] / b[i]); }
+         break;
+      case T_CI:
+         if (op == OP_ADD)       { _ew_loop_c (complex_i_t, int, reali, imagi, ar+br, ax+bx); }
+         else if (op == OP_SUB)  { _ew_loop_c (complex_i_t, int, reali, imagi, ar-br, ax-bx); }
+         else if (op == OP_MUL)  { _ew_loop_c (complex_i_t, int, reali, imagi, ar*br - ax*bx, ar*bx + ax*br); }
+         else                    { _ew_loop (complex_i_t, a[i] / b[i]); }
+         break;
+      case T_CF:
+         if (op == OP_ADD)       { _ew_loop_c (complex_f_t, float, realf, imagf, ar+br, ax+bx); }
+         else if (op == OP_SUB)  { _ew_loop_c (complex_f_t, float, realf, imagf, ar-br, ax-bx); }
+         else if (op == OP_MUL)  { _ew_loop_c (complex_f_t, float, realf, imagf, ar*br - ax*bx, ar*bx + ax*br); }
+         else                    { _ew_loop (complex_f_t, (complex_f_t)((complex_d_t)a[i] / (complex_d_t)b[i])); }
+         break;
+      case T_CD:
+         if (op == OP_ADD)       { _ew_loop_c (complex_d_t, double, real, imag, ar+br, ax+bx); }
+         else if (op == OP_SUB)  { _ew_loop_c (complex_d_t, double, real, imag, ar-br, ax-bx); }
+         else if (op == OP_MUL)  { _ew_loop_c (complex_d_t, double, real, imag, ar*br - ax*bx, ar*bx + ax*br); }
+         else                    { _ew_loop (complex_d_t, a[i] / b[i]); }
+         break;
+      default: break;
+   }
+}
+
+#define _dot_loop(_t, _acc, _expr)                             \
+   _t *a = (_t*)va, *b = (_t*)vb;                              \
+   _acc res = 0;                                               \
+   for (int i=0 ; i<n ; ++i)  res += _expr;                    \
+   *(_acc*)vr = res;
+
+/*
+ * The dot products in the sequential order. The result goes to vr, in the
+ * return type of the kernel.
+ */
+__SCALAR__ static void _scalar_dot (type_en t, void *vr, void *va, void *vb, int n)
+{
+   switch (t) {
+      case T_I32:    { _dot_loop (int32_t, int64_t, (int64_t)a[i] * b[i]); } break;
+      case T_UI32:   { _dot_loop (uint32_t, uint64_t, (uint64_t)a[i] * b[i]); } break;
+      case T_F:      { _dot_loop (float, float, a[i] * b[i]); } break;
+      case T_D:      { _dot_loop (double, double, a[i] * b[i]); } break;
+      case T_CI:     { _dot_loop (complex_i_t, complex_i_t, conj (a[i]) * b[i]); } break;
+      case T_CF:     { _dot_loop (complex_f_t, complex_f_t, conjf (a[i]) * b[i]); } break;
+      case T_CD:     { _dot_loop (complex_d_t, complex_d_t, conj (a[i]) * b[i]); } break;
+      default: break;
+   }
+}
+
+/*
+ * The dot product kernel of type t, the result goes to vr
+ */
+static void _kernel_dot (const kernel_t *k, void *vr, void *va, void *vb, int n)
+{
+   switch (k->t) {
+      case T_I32:    *(int64_t*)vr = ((int64_t (*)(int32_t*, int32_t*, int))k->fn) (va, vb, n); break;
+      case T_UI32:   *(uint64_t*)vr = ((uint64_t (*)(uint32_t*, uint32_t*, int))k->fn) (va, vb, n); break;
+      case T_F:      *(float*)vr = ((float (*)(float*, float*, int))k->fn) (va, vb, n); break;
+      case T_D:      *(double*)vr = ((double (*)(double*, double*, int))k->fn) (va, vb, n); break;
+      case T_CI:     *(complex_i_t*)vr = ((complex_i_t (*)(complex_i_t*, complex_i_t*, int))k->fn) (va, vb, n); break;
+      case T_CF:     *(complex_f_t*)vr = ((complex_f_t (*)(complex_f_t*, complex_f_t*, int))k->fn) (va, vb, n); break;
+      case T_CD:     *(complex_d_t*)vr = ((complex_d_t (*)(complex_d_t*, complex_d_t*, int))k->fn) (va, vb, n); break;
+      default: break;
+   }
+}
+
+/*
+ * Compare element i of the kernel output y with the reference r. The add,
+ * sub and integer results are exact. The products may round differently
+ * where the compiler contracts them, the complex division is Smith's
+ * against the C division.
+ */
+static int _differ (op_en op, type_en t, void *y, void *r, int i)
+{
+   double tol = (op == OP_MUL || op == OP_DIV) ? ((t == T_CF) ? 1e-6 : 1e-15) : 0;
+
+   switch (t) {
+      case T_I32:    return ((int32_t*)y)[i] != ((int32_t*)r)[i];
+      case T_UI32:   return ((uint32_t*)y)[i] != ((uint32_t*)r)[i];
+      case T_F:      return ((float*)y)[i] != ((float*)r)[i];
+      case T_D:      return ((double*)y)[i] != ((double*)r)[i];
+      case T_CI:     return ((complex_i_t*)y)[i] != ((complex_i_t*)r)[i];
+      case T_CF:
+         if (tol == 0)  return ((complex_f_t*)y)[i] != ((complex_f_t*)r)[i];
+         return !(_cerr (((complex_f_t*)y)[i], ((complex_f_t*)r)[i]) <= tol);
+      case T_CD:
+         if (tol == 0)  return ((complex_d_t*)y)[i] != ((complex_d_t*)r)[i];
+         return !(_cerr (((complex_d_t*)y)[i], ((complex_d_t*)r)[i]) <= tol);
+      default: return 1;
+   }
+}
+
+/*
+ * The dot products against the sequential sums. The vector accumulators
+ * round in an other order, bound by n ulps of the sum of |a.b|.
+ */
+static int _differ_dot (type_en t, void *y, void *r, int n)
+{
+   switch (t) {
+      case T_I32:    return *(int64_t*)y != *(int64_t*)r;
+      case T_UI32:   return *(uint64_t*)y != *(uint64_t*)r;
+      case T_CI:     return *(complex_i_t*)y != *(complex_i_t*)r;
+      case T_F:      return fabsf (*(float*)y - *(float*)r) > (n+1) * 1e-7;
+      case T_D:      return fabs (*(double*)y - *(double*)r) > (n+1) * 1e-16;
+      case T_CF:     return cabsf (*(complex_f_t*)y - *(complex_f_t*)r) > (n+1) * 2e-7;
+      case T_CD:     return cabs (*(complex_d_t*)y - *(complex_d_t*)r) > (n+1) * 2e-16;
+      default: return 1;
+   }
+}
+
+/*
+ * Every kernel against its scalar loop for each head offset and length.
+ * The output guard elements around y must stay untouched.
+ */
+static int _check_kernel (const kernel_t *k)
+{
+   uint8_t  *a = buf[k->t].a, *b = buf[k->t].b, *y = buf[k->t].y, *r = buf[k->t].r;
+   size_t   sz = buf[k->t].size;
+   complex_d_t ydot, rdot;    // Large enough for every dot result
+   int      err = 0, o, l, n, i;
+
+   for (o=0 ; o<OFS ; ++o) {
+      for (l=0 ; l<(int)(sizeof (lengths) / sizeof (lengths[0])) ; ++l) {
+         n = lengths[l];
+         if (k->op == OP_DOT) {
+            memset ((void*)&ydot, 0, sizeof (ydot));
+            memset ((void*)&rdot, 0, sizeof (rdot));
+            _kernel_dot (k, &ydot, a + o*sz, b + o*sz, n);
+            _scalar_dot (k->t, &rdot, a + o*sz, b + o*sz, n);
+            err += _differ_dot (k->t, &ydot, &rdot, n);
+            continue;
+         }
+         memset ((void*)y, 0x5A, N*sz);
+         memset ((void*)r, 0x5A, N*sz);
+         if (k->op == OP_DIV)
+            err += (((div_fn)k->fn) (y + o*sz, a + o*sz, b + o*sz, n) != 0);
+         else
+            ((ew_fn)k->fn) (y + o*sz, a + o*sz, b + o*sz, n);
+         _scalar_ew (k->op, k->t, r + o*sz, a + o*sz, b + o*sz, n);
+         for (i=o ; i<o+n ; ++i)
+            err += _differ (k->op, k->t, y, r, i);
+         err += (memcmp (y, r, o*sz) != 0);
+         err += (memcmp (y + (o+n)*sz, r + (o+n)*sz, (N-o-n)*sz) != 0);
+      }
+   }
+   if (err)
+      printf ("%s: %d mismatches\n", k->name, err);
+   return err;
+}
+
+/*
+ * The divisions reject a zero anywhere in the divisor and leave the output
+ * untouched
+ */
+static int _check_div_zero (const kernel_t *k)
+{
+   uint8_t  *b = buf[k->t].b, *y = buf[k->t].y, *r = buf[k->t].r;
+   size_t   sz = buf[k->t].size;
+   uint8_t  save[sizeof (complex_d_t)];
+   int      err = 0;
+
+   memcpy ((void*)save, b + 37*sz, sz);
+   memset ((void*)(b + 37*sz), 0, sz);
+   memset ((void*)y, 0x5A, N*sz);
+   memset ((void*)r, 0x5A, N*sz);
+   err += (((div_fn)k->fn) (y, buf[k->t].a, b, 64) != 1);
+   err += (memcmp (y, r, N*sz) != 0);
+   memcpy ((void*)(b + 37*sz), save, sz);
+   if (err)
+      printf ("%s: divide by zero not rejected\n", k->name);
+   return err;
+}
+
+/*
+ * The complex division against the C complex division, with the operands
+ * over the whole exponent range. The a.conj(b) / |b|^2 form fails here for
+ * |b| < 1e-154 or |b| > 1e154.
+ */
+static int _check_div (void)
+{
+   complex_d_t a, b, y, ref;
+   complex_f_t fa, fb, fy, fref;
+   int err = 0, i;
+
+   for (i=0 ; i<DIVS ; ++i) {
+      a = _rnd_exp (1000) + I*_rnd_exp (1000);
+      b = _rnd_exp (1000) + I*_rnd_exp (1000);
+      if (i & 1)     // Both parts of a similar magnitude
+         b = ldexp (_rnd (), (i>>1)%2001 - 1000) + I*ldexp (_rnd (), (i>>1)%2001 - 1000);
+      ref = a / b;
+      if (!isfinite (creal (ref)) || !isfinite (cimag (ref)) || cabs (ref) < 1e-290 || cabs (ref) > 1e290)
+         continue;
+      vediv_cd (&y, &a, &b, 1);
+      if (!(_cerr (y, ref) < 1e-15)) {
+         if (err < 5)
+            printf ("vediv_cd: (%g%+gi)/(%g%+gi) = %g%+gi, expected %g%+gi\n",
+                    creal (a), cimag (a), creal (b), cimag (b), creal (y), cimag (y), creal (ref), cimag (ref));
+         ++err;
+      }
+      fa = (float)_rnd_exp (120) + I*(float)_rnd_exp (120);
+      fb = (float)_rnd_exp (120) + I*(float)_rnd_exp (120);
+      fref = (complex_f_t)((complex_d_t)fa / (complex_d_t)fb);
+      if (!isfinite (crealf (fref)) || !isfinite (cimagf (fref)) || cabsf (fref) < 1e-35f || cabsf (fref) > 1e35f)
+         continue;
+      vediv_cf (&fy, &fa, &fb, 1);
+      if (!(cabsf (fy - fref) <= 1e-6f * cabsf (fref))) {
+         if (err < 5)
+            printf ("vediv_cf: (%g%+gi)/(%g%+gi) = %g%+gi, expected %g%+gi\n",
+                    crealf (fa), cimagf (fa), crealf (fb), cimagf (fb), crealf (fy), cimagf (fy), crealf (fref), cimagf (fref));
+         ++err;
+      }
+   }
+   if (err)
+      printf ("div: %d mismatches\n", err);
+   return err;
+}
+
+/*
+ * Each kernel against its scalar loop, on the unaligned length N
+ */
+static void _bench (const kernel_t *k)
+{
+   complex_d_t res;
+   void     *a = buf[k->t].a, *b = buf[k->t].b, *y = buf[k->t].y;
+   double   t0, t1, t2;
+   int      r;
+
+   t0 = _now ();
+   for (r=0 ; r<RUNS ; ++r) {
+      if (k->op == OP_DOT)    _scalar_dot (k->t, &res, a, b, N);
+      else                    _scalar_ew (k->op, k->t, y, a, b, N);
+   }
+   t1 = _now ();
+   for (r=0 ; r<RUNS ; ++r) {
+      if (k->op == OP_DOT)       _kernel_dot (k, &res, a, b, N);
+      else if (k->op == OP_DIV)  ((div_fn)k->fn) (y, a, b, N);
+      else                       ((ew_fn)k->fn) (y, a, b, N);
+   }
+   t2 = _now ();
+   printf ("%-10s scalar %7.3f ns/elem, kernel %7.3f ns/elem, %5.2fx\n", k->name,
+           (t1-t0) * 1e9 / RUNS / N, (t2-t1) * 1e9 / RUNS / N, (t1-t0) / (t2-t1));
+}
+
+int main (void)
+{
+   int err = 0, i;
+   size_t k;
+
+   srand (1);
+   for (i=0 ; i<N ; ++i) {
+      ai[i] = rand () - RAND_MAX/2; bi[i] = _rnd_nz (1000);
+      au[i] = (uint32_t)rand () * 3u; bu[i] = (uint32_t)rand () * 5u;
+      af[i] = _rnd (); bf[i] = _rnd () + 2;
+      ad[i] = _rnd (); bd[i] = _rnd () - 2;
+      aci[i] = (rand () % 20001 - 10000) + I*(rand () % 20001 - 10000);
+      bci[i] = _rnd_nz (100) + I*_rnd_nz (100);
+      acf[i] = _rnd () + I*_rnd (); bcf[i] = _rnd () + I*_rnd ();
+      acd[i] = _rnd () + I*_rnd (); bcd[i] = _rnd () + I*_rnd ();
+   }
+   for (k=0 ; k<sizeof (kernels) / sizeof (kernels[0]) ; ++k) {
+      err += _check_kernel (&kernels[k]);
+      if (kernels[k].op == OP_DIV)
+         err += _check_div_zero (&kernels[k]);
+   }
+   err += _check_div ();
+   for (k=0 ; k<sizeof (kernels) / sizeof (kernels[0]) ; ++k)
+      _bench (&kernels[k]);
+   printf ("vectors: %s\n", (err) ? "FAIL" : "PASS");
+   return (err) ? 1 : 0;
+}